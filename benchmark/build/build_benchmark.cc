@@ -0,0 +1,116 @@
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+#include <tbb/global_control.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include "build/build.hh"
+
+namespace {
+
+// tree writes a synthetic source tree: layers of packages, each importing
+// two packages of the layer below, plus a chain of bigger packages that
+// forms the critical path; root imports the top of everything.
+struct tree {
+    std::string root;
+    std::vector<std::string> roots{"root"};
+
+    void write(const std::string &path, std::vector<std::string> imports, int funcs) {
+        auto dir = std::filesystem::path(root) / path;
+        std::filesystem::create_directories(dir);
+        for (int file = 0; file < 2; file++) {
+            std::string src = "package " + path.substr(path.rfind('/') + 1) + "\n\n";
+            std::string calls;
+            for (auto &imp : file == 0 ? imports : std::vector<std::string>{}) {
+                src += fmt::format("import \"{}\"\n", imp);
+                calls += fmt::format("\t{}.F0()\n", imp.substr(imp.rfind('/') + 1));
+            }
+            for (int i = 0; i < funcs; i++) {
+                src += fmt::format(R"(
+func F{0}_{1}(xs []int) int {{
+	sum := 0
+	for i, x := range xs {{
+		if x > i {{
+			sum += x * i
+		}}
+	}}
+	return sum
+}}
+)",
+                                   file, i);
+            }
+            src += fmt::format("\nfunc F{}() {{\n{}}}\n", file, calls);
+            std::ofstream(dir / fmt::format("f{}.go", file)) << src;
+        }
+    }
+
+    tree(int layers, int width) {
+        char tmpl[] = "/tmp/build_benchmark.XXXXXX";
+        root = mkdtemp(tmpl);
+        for (int l = 0; l < layers; l++) {
+            for (int w = 0; w < width; w++) {
+                std::vector<std::string> imports;
+                if (l > 0) {
+                    imports = {fmt::format("l{}/p{}", l - 1, w), fmt::format("l{}/p{}", l - 1, (w + 1) % width)};
+                }
+                write(fmt::format("l{}/p{}", l, w), imports, 20);
+            }
+            std::vector<std::string> chain;
+            if (l > 0) {
+                chain.push_back(fmt::format("chain/c{}", l - 1));
+            }
+            write(fmt::format("chain/c{}", l), chain, 100);
+        }
+        std::vector<std::string> imports{fmt::format("chain/c{}", layers - 1)};
+        for (int w = 0; w < width; w++) {
+            imports.push_back(fmt::format("l{}/p{}", layers - 1, w));
+        }
+        write("root", imports, 1);
+    }
+    ~tree() { std::filesystem::remove_all(root); }
+};
+
+// BM_Build builds a tree of 8 layers of 32 packages with state.range(0)
+// threads, from loading to type checking.
+void BM_Build(benchmark::State &state) {
+    tree t(8, 32);
+    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, size_t(state.range(0)));
+    for (auto _ : state) {
+        auto g = build::Load(t.root, t.roots);
+        if (!build::Build(g) || !g.Errors.empty()) {
+            state.SkipWithError("build failed");
+        }
+        state.counters["packages"] = double(g.Packages.size());
+    }
+}
+
+// BM_RebuildCached rebuilds the tree of BM_Build from a warm build cache
+// with state.range(0) threads, as after switching back to a branch built
+// before.
+void BM_RebuildCached(benchmark::State &state) {
+    tree t(8, 32);
+    build::Options opts;
+    opts.CacheDir = t.root + "/.cache";
+    {
+        auto g = build::Load(t.root, t.roots);
+        build::Build(g, opts);
+    }
+    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, size_t(state.range(0)));
+    for (auto _ : state) {
+        auto g = build::Load(t.root, t.roots);
+        if (!build::Build(g, opts) || !g.Errors.empty()) {
+            state.SkipWithError("build failed");
+        }
+        auto cached = std::count_if(g.Packages.begin(), g.Packages.end(), [](auto &pkg) { return pkg->Cached; });
+        state.counters["cached"] = double(cached);
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_Build)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RebuildCached)->Arg(1)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
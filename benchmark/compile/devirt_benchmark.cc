@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include <sstream>
+
+#include "compile/devirt.hh"
+#include "syntax/ast/walk.hh"
+#include "syntax/parser.hh"
+
+namespace {
+
+// package generates a package of n stages of a pipeline reading and
+// writing through io.Reader and io.Writer style interfaces, in the style
+// of an encoder streaming records.
+std::string package(int n) {
+    std::string src = R"(package bench
+
+type Reader interface{ Read(p []byte) (int, error) }
+
+type Writer interface{ Write(p []byte) (int, error) }
+
+type Buffer struct {
+	buf []byte
+	off int
+}
+
+func (b *Buffer) Read(p []byte) (int, error) { return copy(p, b.buf[b.off:]), nil }
+
+func (b *Buffer) Write(p []byte) (int, error) { return len(p), nil }
+
+func (b *Buffer) Len() int { return len(b.buf) - b.off }
+
+type Counter struct{ n int }
+
+func (c *Counter) Write(p []byte) (int, error) { return len(p), nil }
+
+func NewBuffer(b []byte) *Buffer { return &Buffer{buf: b} }
+
+func Source(b []byte) Reader { return NewBuffer(b) }
+
+)";
+    for (int i = 0; i < n; i++) {
+        src += fmt::format(R"(func stage{0}(in []byte, verbose bool) int {{
+	var r Reader = Source(in)
+	var w Writer = NewBuffer(nil)
+	var log Writer = &Counter{{}}
+	if verbose {{
+		log = NewBuffer(nil)
+	}}
+	p := make([]byte, {0}+1)
+	n, _ := r.Read(p)
+	w.Write(p[:n])
+	log.Write(p[:n])
+	return n
+}}
+
+)",
+                           i);
+    }
+    return src;
+}
+
+// BM_Devirt plans the devirtualization in a package of state.range(0)
+// pipeline stages; the direct counter is the fraction of the interface
+// calls made direct.
+void BM_Devirt(benchmark::State &state) {
+    auto f = syntax::Parse(std::make_unique<std::istringstream>(package(int(state.range(0)))), nullptr);
+    ast::File *files[] = {f.get()};
+    types::Checker check;
+    check.Check(files);
+    size_t calls = 0, direct = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        compile::Inliner inliner(check);
+        inliner.Analyze(files);
+        state.ResumeTiming();
+        compile::Devirtualizer devirt(check, "bench", &inliner);
+        benchmark::DoNotOptimize(devirt.Analyze(files));
+        calls = direct = 0;
+        ast::Inspect(f.get(), [&](ast::Node *n) {
+            auto c = dyn_cast<ast::CallExpr>(n);
+            auto sel = c == nullptr ? nullptr : dyn_cast<ast::SelectorExpr>(c->Fun.get());
+            if (sel != nullptr && sel->X->typ != 0 && types::IsInterface(sel->X->typ)) {
+                calls++;
+                direct += devirt.Devirtualized(c) != nullptr;
+            }
+            return true;
+        });
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["direct"] = calls == 0 ? 0 : double(direct) / double(calls);
+}
+
+} // namespace
+
+BENCHMARK(BM_Devirt)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
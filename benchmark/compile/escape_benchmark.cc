@@ -0,0 +1,99 @@
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include <sstream>
+
+#include "compile/escape.hh"
+#include "syntax/parser.hh"
+
+namespace {
+
+// package generates a package of n request handlers in the style of a
+// server: each one builds a request, a scratch buffer and a header map,
+// formats through a helper, and hands some of its results to the caller
+// or to a channel.
+std::string package(int n) {
+    std::string src = R"(package bench
+
+type Request struct {
+	Method, Path string
+	Header map[string]string
+	Body   []byte
+}
+
+type Response struct {
+	Status int
+	Body   []byte
+}
+
+var done = make(chan *Response, 16)
+
+func status(r *Request) int {
+	if r.Method == "GET" {
+		return 200
+	}
+	return 405
+}
+
+func fill(buf []byte, s string) int { return copy(buf, s) }
+
+func wrap(r *Response) *Response { return r }
+
+)";
+    for (int i = 0; i < n; i++) {
+        src += fmt::format(R"(func handle{0}(path string, body []byte) *Response {{
+	req := &Request{{Method: "GET", Path: path, Body: body}}
+	req.Header = map[string]string{{"Host": "example.com"}}
+	buf := make([]byte, 256)
+	k := fill(buf, path)
+	for i := 0; i < k; i++ {{
+		part := &Request{{Method: req.Method, Path: path[:i]}}
+		k -= status(part) / 100
+	}}
+	count := 0
+	visit := func(b byte) {{ count += int(b) }}
+	for _, b := range buf[:k] {{
+		visit(b)
+	}}
+	resp := &Response{{Status: status(req) + count%2, Body: body}}
+	if k%2 == 0 {{
+		done <- &Response{{Status: k}}
+	}}
+	return wrap(resp)
+}}
+
+)",
+                           i);
+    }
+    return src;
+}
+
+// BM_Escape analyzes a package of state.range(0) handlers; the stack
+// counter is the fraction of allocation sites kept on the stack.
+void BM_Escape(benchmark::State &state) {
+    auto f = syntax::Parse(std::make_unique<std::istringstream>(package(int(state.range(0)))), nullptr);
+    ast::File *files[] = {f.get()};
+    types::Checker check;
+    check.Check(files);
+    size_t sites = 0, stack = 0;
+    for (auto _ : state) {
+        compile::EscapeAnalysis escape(check);
+        auto decisions = escape.Analyze(files);
+        sites = stack = 0;
+        for (auto &d : decisions) {
+            if (d.kind == compile::EscapeDecision::Alloc) {
+                sites++;
+                stack += !d.Heap;
+            }
+        }
+        benchmark::DoNotOptimize(decisions);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["stack"] = sites == 0 ? 0 : double(stack) / double(sites);
+}
+
+} // namespace
+
+BENCHMARK(BM_Escape)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,93 @@
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include <sstream>
+
+#include "compile/callgraph.hh"
+#include "compile/inline.hh"
+#include "syntax/ast/walk.hh"
+#include "syntax/parser.hh"
+
+namespace {
+
+// package generates a package of n request handlers in the style of a
+// server: each one reads the request through getters, checks it with
+// small predicates and builds the response through a helper.
+std::string package(int n) {
+    std::string src = R"(package bench
+
+type Request struct {
+	method, path string
+	header       map[string]string
+	body         []byte
+}
+
+func (r *Request) Method() string         { return r.method }
+func (r *Request) Path() string           { return r.path }
+func (r *Request) Header(k string) string { return r.header[k] }
+func (r *Request) Len() int               { return len(r.body) }
+
+func (r *Request) IsGet() bool { return r.Method() == "GET" }
+
+type Response struct {
+	Status int
+	Body   []byte
+}
+
+func status(ok bool) int {
+	if ok {
+		return 200
+	}
+	return 404
+}
+
+func respond(code int, body []byte) *Response { return &Response{Status: code, Body: body} }
+
+)";
+    for (int i = 0; i < n; i++) {
+        src += fmt::format(R"(func handle{0}(r *Request) *Response {{
+	if !r.IsGet() || r.Header("Host") == "" {{
+		return respond(405, nil)
+	}}
+	n := 0
+	for i := 0; i < r.Len(); i++ {{
+		n += len(r.Path())
+	}}
+	return respond(status(n > {0}), r.body)
+}}
+
+)",
+                           i);
+    }
+    return src;
+}
+
+// BM_Inline plans the inlining in a package of state.range(0) handlers;
+// the inlined counter is the fraction of the static calls inlined.
+void BM_Inline(benchmark::State &state) {
+    auto f = syntax::Parse(std::make_unique<std::istringstream>(package(int(state.range(0)))), nullptr);
+    ast::File *files[] = {f.get()};
+    types::Checker check;
+    check.Check(files);
+    size_t calls = 0, inlined = 0;
+    for (auto _ : state) {
+        compile::Inliner inliner(check);
+        benchmark::DoNotOptimize(inliner.Analyze(files));
+        calls = inlined = 0;
+        ast::Inspect(f.get(), [&](ast::Node *n) {
+            if (auto c = dyn_cast<ast::CallExpr>(n); c != nullptr && compile::StaticCallee(check, c) != nullptr) {
+                calls++;
+                inlined += inliner.Inlined(c) != nullptr;
+            }
+            return true;
+        });
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["inlined"] = calls == 0 ? 0 : double(inlined) / double(calls);
+}
+
+} // namespace
+
+BENCHMARK(BM_Inline)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include <sstream>
+
+#include "compile/stencil.hh"
+#include "syntax/parser.hh"
+
+namespace {
+
+// package generates a package of generic container helpers instantiated
+// with n named types, half of them pointers, in the style of a service
+// keeping caches of its entities.
+std::string package(int n) {
+    std::string src = R"(package bench
+
+func Keys[K comparable, V any](m map[K]V) []K {
+	out := make([]K, 0, len(m))
+	for k := range m {
+		out = append(out, k)
+	}
+	return out
+}
+
+func Filter[T any](xs []T, keep func(T) bool) []T {
+	var out []T
+	for _, x := range xs {
+		if keep(x) {
+			out = append(out, x)
+		}
+	}
+	return out
+}
+
+func Index[T comparable](xs []T, v T) int {
+	for i, x := range xs {
+		if x == v {
+			return i
+		}
+	}
+	return -1
+}
+
+)";
+    for (int i = 0; i < n; i++) {
+        src += fmt::format(R"(type ID{0} int64
+
+type Entity{0} struct{{ id ID{0} }}
+
+func use{0}(cache map[ID{0}]*Entity{0}, ids []ID{0}) int {{
+	keys := Keys(cache)
+	live := Filter(ids, func(id ID{0}) bool {{ return cache[id] != nil }})
+	all := Filter([]*Entity{0}{{}}, func(e *Entity{0}) bool {{ return e != nil }})
+	return Index(keys, ID{0}(1)) + len(live) + len(all)
+}}
+
+)",
+                           i);
+    }
+    return src;
+}
+
+// BM_Stencil plans the instantiation of the generic helpers in a package of
+// state.range(0) entity types; the stencils counter is the number of
+// stencils per instance, which stays small as instances are added.
+void BM_Stencil(benchmark::State &state) {
+    auto f = syntax::Parse(std::make_unique<std::istringstream>(package(int(state.range(0)))), nullptr);
+    ast::File *files[] = {f.get()};
+    types::Checker check;
+    check.Check(files);
+    size_t stencils = 0, instances = 0;
+    for (auto _ : state) {
+        compile::InstanceCache cache;
+        compile::Stenciler stenciler(check, "bench", &cache);
+        instances = stenciler.Analyze(files).size();
+        stencils = stenciler.Stencils().size();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["stencils"] = instances == 0 ? 0 : double(stencils) / double(instances);
+}
+
+} // namespace
+
+BENCHMARK(BM_Stencil)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,201 @@
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include <chrono>
+#include <sstream>
+
+#include "ssa/build.hh"
+#include "ssa/pass.hh"
+#include "syntax/parser.hh"
+
+namespace {
+
+// package generates a package of n message types in the style of a
+// marshalling and validation layer: each type has a validator that walks
+// its fields and a slice of tags with bounds and range checks, and an
+// encoder that appends the fields to a buffer, which is checksummed.
+std::string package(int n) {
+    std::string src = R"(package bench
+
+type Error struct {
+	Field string
+	Code  int
+}
+
+func fail(field string, code int) *Error { return &Error{Field: field, Code: code} }
+
+func putInt(buf []byte, v int) []byte {
+	for v >= 0x80 {
+		buf = append(buf, byte(v)|0x80)
+		v >>= 7
+	}
+	return append(buf, byte(v))
+}
+
+func putString(buf []byte, s string) []byte {
+	buf = putInt(buf, len(s))
+	for i := 0; i < len(s); i++ {
+		buf = append(buf, s[i])
+	}
+	return buf
+}
+
+func checksum(buf []byte) uint32 {
+	var s uint32
+	for i := 0; i+1 < len(buf); i += 2 {
+		s += uint32(buf[i])<<8 | uint32(buf[i+1])
+	}
+	return s
+}
+
+)";
+    for (int i = 0; i < n; i++) {
+        src += fmt::format(R"(type Msg{0} struct {{
+	ID    int
+	Name  string
+	Tags  []string
+	Score int
+}}
+
+func (m *Msg{0}) Validate() *Error {{
+	if m.ID <= 0 {{
+		return fail("id", {0})
+	}}
+	if len(m.Name) == 0 || len(m.Name) > 64 {{
+		return fail("name", {0})
+	}}
+	for i, t := range m.Tags {{
+		if t == "" {{
+			return fail("tags", i)
+		}}
+		for j := 0; j < i; j++ {{
+			if m.Tags[j] == t {{
+				return fail("tags", j)
+			}}
+		}}
+	}}
+	switch {{
+	case m.Score < 0:
+		return fail("score", -1)
+	case m.Score > 100:
+		return fail("score", 1)
+	}}
+	return nil
+}}
+
+func (m *Msg{0}) Marshal(buf []byte) []byte {{
+	buf = putInt(buf, m.ID)
+	buf = putString(buf, m.Name)
+	buf = putInt(buf, len(m.Tags))
+	for _, t := range m.Tags {{
+		buf = putString(buf, t)
+	}}
+	if m.Score != 0 {{
+		buf = putInt(buf, m.Score)
+	}}
+	return buf
+}}
+
+)",
+                           i);
+    }
+    return src;
+}
+
+// funcs returns the function declarations of file.
+std::vector<ast::FuncDecl *> funcs(const ast::FilePtr &file) {
+    std::vector<ast::FuncDecl *> decls;
+    for (auto &d : file->DeclList) {
+        if (auto f = dyn_cast<ast::FuncDecl>(d.get())) {
+            decls.push_back(f);
+        }
+    }
+    return decls;
+}
+
+// BM_Build lowers the functions of a package of state.range(0) message
+// types to SSA form, reusing one Func as the compiler does; the counters
+// are the values and the arena bytes per function.
+void BM_Build(benchmark::State &state) {
+    auto file = syntax::Parse(std::make_unique<std::istringstream>(package(int(state.range(0)))), nullptr);
+    ast::File *files[] = {file.get()};
+    types::Checker check;
+    check.Check(files);
+    auto decls = funcs(file);
+    ssa::Func f;
+    size_t values = 0, bytes = 0;
+    for (auto _ : state) {
+        values = bytes = 0;
+        for (auto d : decls) {
+            if (!ssa::Build(f, check, d)) {
+                state.SkipWithError("function not lowered");
+                return;
+            }
+            values += f.NumValues();
+            bytes += f.Bytes();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(decls.size()));
+    state.counters["values"] = double(values) / double(decls.size());
+    state.counters["bytes"] = double(bytes) / double(decls.size());
+}
+
+// BM_Optimize lowers the functions of the package and runs the default
+// pipeline on them. The counters are the live values per function before
+// and after the passes, the bounds checks left per function and the share
+// of the time the passes take.
+void BM_Optimize(benchmark::State &state) {
+    auto file = syntax::Parse(std::make_unique<std::istringstream>(package(int(state.range(0)))), nullptr);
+    ast::File *files[] = {file.get()};
+    types::Checker check;
+    check.Check(files);
+    auto decls = funcs(file);
+    auto live = [](const ssa::Func &f) {
+        size_t n = 0;
+        for (auto b : f.Blocks()) {
+            n += b->Values.size();
+        }
+        return n;
+    };
+    auto bounds = [](const ssa::Func &f) {
+        size_t n = 0;
+        for (auto b : f.Blocks()) {
+            n += b->Kind == ssa::BlockKind::If && b->Control->Op == ssa::Op::IsInBounds;
+        }
+        return n;
+    };
+    ssa::Func f;
+    ssa::PassManager pm;
+    size_t before = 0, after = 0, checks = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto _ : state) {
+        before = after = checks = 0;
+        for (auto d : decls) {
+            if (!ssa::Build(f, check, d)) {
+                state.SkipWithError("function not lowered");
+                return;
+            }
+            before += live(f);
+            pm.Run(f);
+            after += live(f);
+            checks += bounds(f);
+        }
+    }
+    auto total = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    uint64_t passes = 0;
+    for (auto &t : pm.Timings()) {
+        passes += t.Nanos;
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(decls.size()));
+    state.counters["before"] = double(before) / double(decls.size());
+    state.counters["after"] = double(after) / double(decls.size());
+    state.counters["checks"] = double(checks) / double(decls.size());
+    state.counters["passes"] = double(passes) / total;
+}
+
+} // namespace
+
+BENCHMARK(BM_Build)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Optimize)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+
+#include "common/typeid_cast.hh"
+#include "syntax/ast/walk.hh"
+#include "syntax/parser.hh"
+
+namespace {
+
+// nodes returns the nodes of a file mixing calls, selectors and operators,
+// in walk order.
+std::vector<ast::Node *> nodes(ast::FilePtr &f) {
+    std::string src = "package bench\n\nfunc f() {\n";
+    for (int i = 0; i < 1000; i++) {
+        src += "\tx.y[i] = g(a + b, c.d)\n";
+    }
+    f = syntax::Parse(std::make_unique<std::istringstream>(src + "}\n"), nullptr);
+    std::vector<ast::Node *> list;
+    ast::Inspect(f.get(), [&](ast::Node *n) {
+        list.push_back(n);
+        return true;
+    });
+    return list;
+}
+
+// Each benchmark counts the call expressions and the expressions among all
+// nodes: an exact-type test and a test for an abstract base.
+
+void BM_DynCast(benchmark::State &state) {
+    ast::FilePtr f;
+    auto list = nodes(f);
+    for (auto _ : state) {
+        int64_t calls = 0, exprs = 0;
+        for (auto n : list) {
+            calls += dyn_cast<ast::CallExpr>(n) != nullptr;
+            exprs += dyn_cast<ast::ExprNode>(n) != nullptr;
+        }
+        benchmark::DoNotOptimize(calls);
+        benchmark::DoNotOptimize(exprs);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(list.size()));
+}
+
+void BM_DynamicCast(benchmark::State &state) {
+    ast::FilePtr f;
+    auto list = nodes(f);
+    for (auto _ : state) {
+        int64_t calls = 0, exprs = 0;
+        for (auto n : list) {
+            calls += dynamic_cast<ast::CallExpr *>(n) != nullptr;
+            exprs += dynamic_cast<ast::ExprNode *>(n) != nullptr;
+        }
+        benchmark::DoNotOptimize(calls);
+        benchmark::DoNotOptimize(exprs);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(list.size()));
+}
+
+// typeid_cast only matches exact types, so the base test falls back to
+// dynamic_cast, as its callers would have to.
+void BM_TypeidCast(benchmark::State &state) {
+    ast::FilePtr f;
+    auto list = nodes(f);
+    for (auto _ : state) {
+        int64_t calls = 0, exprs = 0;
+        for (auto n : list) {
+            calls += typeid_cast<ast::CallExpr *>(n) != nullptr;
+            exprs += dynamic_cast<ast::ExprNode *>(n) != nullptr;
+        }
+        benchmark::DoNotOptimize(calls);
+        benchmark::DoNotOptimize(exprs);
+    }
+    state.SetItemsProcessed(state.iterations() * int64_t(list.size()));
+}
+
+} // namespace
+
+BENCHMARK(BM_DynCast);
+BENCHMARK(BM_DynamicCast);
+BENCHMARK(BM_TypeidCast);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+#include <tbb/global_control.h>
+
+#include <sstream>
+
+#include "syntax/parser.hh"
+#include "syntax/types/check.hh"
+
+namespace {
+
+// package generates a package of n functions whose bodies loop, branch and
+// call each other, so that checking is dominated by the function bodies.
+std::string package(int n) {
+    std::string src = "package bench\n\ntype T struct{ a, b int }\n\nvar total int\n\n";
+    for (int i = 0; i < n; i++) {
+        src += fmt::format(R"(func f{0}(xs []T, s string) int {{
+	sum := len(s)
+	for i, x := range xs {{
+		if x.a > x.b {{
+			sum += x.a * i
+		}} else {{
+			sum -= x.b
+		}}
+	}}
+	m := map[string]int{{s: sum}}
+	total += m[s]
+	if sum > 0 {{
+		return f{1}(xs[1:], s+"!")
+	}}
+	return sum
+}}
+
+)",
+                           i, (i + 1) % n);
+    }
+    return src;
+}
+
+// BM_Check checks the package with state.range(1) threads; one thread checks
+// the function bodies sequentially.
+void BM_Check(benchmark::State &state) {
+    auto f = syntax::Parse(std::make_unique<std::istringstream>(package(int(state.range(0)))), nullptr);
+    ast::File *files[] = {f.get()};
+    auto threads = int(state.range(1));
+    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, threads);
+    for (auto _ : state) {
+        types::Checker c;
+        benchmark::DoNotOptimize(c.Check(files, threads > 1));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+} // namespace
+
+BENCHMARK(BM_Check)->ArgsProduct({{1000, 4000}, {1, 2, 4, 8}})->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,49 @@
+#include <benchmark/benchmark.h>
+
+#include "syntax/types/constant.hh"
+
+namespace {
+
+using types::Value;
+
+// fold computes the bit masks 1<<i - 1 and the sums of i/10 for i < n, as
+// generated enum and table code does.
+void fold(benchmark::State &state, int shift) {
+    auto one = Value::MakeInt64(1);
+    auto tenth = Value::MakeFromLiteral("0.1", FloatLit);
+    for (auto _ : state) {
+        Value mask = Value::MakeInt64(0), sum = Value::MakeInt64(0);
+        for (int i = 0; i < 60; i++) {
+            auto bit = types::Shift(one, Operator_Shl, uint64_t(i + shift));
+            mask = types::BinaryOp(mask, Operator_Or, bit);
+            sum = types::BinaryOp(sum, Operator_Add, types::BinaryOp(Value::MakeInt64(i), Operator_Mul, tenth));
+        }
+        benchmark::DoNotOptimize(mask);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * 60);
+}
+
+void BM_FoldInline(benchmark::State &state) { fold(state, 0); }
+
+// BM_FoldBig shifts the masks beyond 64 bits, forcing the bignum path.
+void BM_FoldBig(benchmark::State &state) { fold(state, 64); }
+
+void BM_ParseLiteral(benchmark::State &state) {
+    const char *lits[] = {"0x7fff_ffff", "3.14159", "1e-9", "0b1010_1010", "6.02214076e23"};
+    for (auto _ : state) {
+        for (auto lit : lits) {
+            auto kind = std::string_view(lit).find_first_of(".e") == std::string_view::npos ? IntLit : FloatLit;
+            benchmark::DoNotOptimize(Value::MakeFromLiteral(lit, kind));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 5);
+}
+
+} // namespace
+
+BENCHMARK(BM_FoldInline);
+BENCHMARK(BM_FoldBig);
+BENCHMARK(BM_ParseLiteral);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,93 @@
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include <filesystem>
+#include <sstream>
+
+#include "syntax/parser.hh"
+#include "syntax/types/export.hh"
+
+namespace {
+
+common::SymbolId sym(const std::string &name) { return common::Interner::Global().Intern(name); }
+
+// exported writes the export data of a generated package of n struct
+// types, each with a method, and n functions using them, like a
+// generated API client, to a temporary directory.
+struct exported {
+    std::string dir;
+    int n;
+
+    explicit exported(int n) : n(n) {
+        char tmpl[] = "/tmp/export_benchmark.XXXXXX";
+        dir = mkdtemp(tmpl);
+        std::string src = "package api\n";
+        for (int i = 0; i < n; i++) {
+            src += fmt::format(R"(
+type Request{0} struct {{
+	ID    int64
+	Name  string
+	Tags  []string
+	Attrs map[string]*Request{0}
+}}
+
+func (r *Request{0}) Validate() error {{ return nil }}
+
+func Call{0}(r *Request{0}, opts ...string) (*Request{0}, error) {{ return r, nil }}
+)",
+                               i);
+        }
+        auto file = syntax::Parse(std::make_unique<std::istringstream>(src), [](uint, uint, std::string) {});
+        types::DirImporter importer(dir);
+        types::Checker check(&importer);
+        ast::File *files[] = {file.get()};
+        check.Check(files);
+        importer.Add("api", types::Export(check, "api"));
+    }
+    ~exported() { std::filesystem::remove_all(dir); }
+};
+
+// BM_ImportFew maps the export data of a package of state.range(0)
+// functions and uses three of them, with their types and methods.
+void BM_ImportFew(benchmark::State &state) {
+    exported e(int(state.range(0)));
+    std::vector<common::SymbolId> names;
+    for (auto i : {0, e.n / 2, e.n - 1}) {
+        names.push_back(sym(fmt::format("Call{}", i)));
+    }
+    auto validate = sym("Validate");
+    for (auto _ : state) {
+        types::DirImporter importer(e.dir);
+        auto pkg = importer.Import("api");
+        for (auto name : names) {
+            auto f = pkg->Lookup(name);
+            auto req = types::TypeTable::Global()[types::TypeTable::Global()[f->Type].Params()[0]].Elem();
+            benchmark::DoNotOptimize(pkg->Methods(req).size() == 1 && pkg->Methods(req)[0]->Name == validate);
+        }
+        state.counters["decoded"] = double(pkg->Decoded());
+    }
+}
+
+// BM_ImportAll uses all functions of the package, for comparison.
+void BM_ImportAll(benchmark::State &state) {
+    exported e(int(state.range(0)));
+    std::vector<common::SymbolId> names;
+    for (int i = 0; i < e.n; i++) {
+        names.push_back(sym(fmt::format("Call{}", i)));
+    }
+    for (auto _ : state) {
+        types::DirImporter importer(e.dir);
+        auto pkg = importer.Import("api");
+        for (auto name : names) {
+            benchmark::DoNotOptimize(pkg->Lookup(name));
+        }
+        state.counters["decoded"] = double(pkg->Decoded());
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_ImportFew)->Arg(1000)->Arg(10000)->Arg(50000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ImportAll)->Arg(1000)->Arg(10000)->Arg(50000)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
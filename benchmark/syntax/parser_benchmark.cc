@@ -0,0 +1,120 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <sstream>
+
+#include "syntax/cache/ast_cache.hh"
+#include "syntax/parser.hh"
+
+namespace {
+
+// goSource generates a package with n functions that exercise declarations,
+// statements and expressions of every precedence level.
+std::string goSource(int n) {
+    std::string src = "package bench\n\nimport \"fmt\"\n\ntype point struct {\n\tx, y int\n\tname string\n}\n\n";
+    for (int i = 0; i < n; i++) {
+        src += fmt::format(R"(func f{0}(p *point, xs []int, m map[string]int) (int, error) {{
+	sum := 0
+	for i, x := range xs {{
+		if x%2 == 0 && i < len(xs)-1 || p.x > {0} {{
+			sum += x*p.y + (i<<2)&0xff
+		}} else {{
+			m[p.name] = sum - x/3
+		}}
+	}}
+	switch {{
+	case sum > 100:
+		return sum, fmt.Errorf("too big: %d", sum)
+	}}
+	q := point{{x: sum, y: -p.y, name: "q"}}
+	return q.x + q.y, nil
+}}
+
+)",
+                           i);
+    }
+    return src;
+}
+
+void BM_Lex(benchmark::State &state) {
+    auto src = goSource(int(state.range(0)));
+    for (auto _ : state) {
+        syntax::scanner s;
+        s.init(std::make_unique<std::istringstream>(src), nullptr, 0);
+        int64_t ntoks = 0;
+        for (s.next(); s._tok != Token_EOF; s.next()) {
+            ntoks++;
+        }
+        benchmark::DoNotOptimize(ntoks);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(src.size()));
+}
+
+void BM_Parse(benchmark::State &state) {
+    auto src = goSource(int(state.range(0)));
+    for (auto _ : state) {
+        auto f = syntax::Parse(std::make_unique<std::istringstream>(src), nullptr);
+        benchmark::DoNotOptimize(f);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(src.size()));
+}
+
+void BM_ParseSkipBodies(benchmark::State &state) {
+    auto src = goSource(int(state.range(0)));
+    for (auto _ : state) {
+        auto f = syntax::Parse(std::make_unique<std::istringstream>(src), nullptr, SkipFuncBodies);
+        benchmark::DoNotOptimize(f);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(src.size()));
+}
+
+void BM_ParseParallelBodies(benchmark::State &state) {
+    auto src = goSource(int(state.range(0)));
+    for (auto _ : state) {
+        auto f = syntax::Parse(std::make_unique<std::istringstream>(src), nullptr, SkipFuncBodies);
+        syntax::ParseFuncBodies(src, f.get(), nullptr);
+        benchmark::DoNotOptimize(f);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(src.size()));
+}
+
+// BM_LoadCached measures a warm build: the tree is mapped from the AST cache
+// and walked in place.
+void BM_LoadCached(benchmark::State &state) {
+    auto src = goSource(int(state.range(0)));
+    auto dir = std::filesystem::temp_directory_path() / "pxcppgo_ast_cache_bench";
+    syntax::cache::AstCache cache(dir.string());
+    cache.Store(src, *syntax::Parse(std::make_unique<std::istringstream>(src), nullptr));
+    for (auto _ : state) {
+        auto f = cache.Load(src);
+        uint32_t ndecls = f->Root().Child(1).NumChildren();
+        benchmark::DoNotOptimize(ndecls);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(src.size()));
+    std::filesystem::remove_all(dir);
+}
+
+// BM_DecodeCached measures a warm build that needs the mutable tree.
+void BM_DecodeCached(benchmark::State &state) {
+    auto src = goSource(int(state.range(0)));
+    auto dir = std::filesystem::temp_directory_path() / "pxcppgo_ast_cache_bench";
+    syntax::cache::AstCache cache(dir.string());
+    cache.Store(src, *syntax::Parse(std::make_unique<std::istringstream>(src), nullptr));
+    for (auto _ : state) {
+        auto f = cache.Load(src)->Decode();
+        benchmark::DoNotOptimize(f);
+    }
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(src.size()));
+    std::filesystem::remove_all(dir);
+}
+
+} // namespace
+
+BENCHMARK(BM_Lex)->Arg(16)->Arg(256);
+BENCHMARK(BM_Parse)->Arg(16)->Arg(256);
+BENCHMARK(BM_ParseSkipBodies)->Arg(16)->Arg(256);
+BENCHMARK(BM_ParseParallelBodies)->Arg(16)->Arg(256)->UseRealTime();
+BENCHMARK(BM_LoadCached)->Arg(16)->Arg(256);
+BENCHMARK(BM_DecodeCached)->Arg(16)->Arg(256);
+
+BENCHMARK_MAIN();
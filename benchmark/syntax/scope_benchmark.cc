@@ -0,0 +1,149 @@
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include <deque>
+#include <random>
+#include <sstream>
+#include <unordered_map>
+
+#include "syntax/parser.hh"
+#include "syntax/types/check.hh"
+
+namespace {
+
+common::SymbolId sym(const std::string &name) { return common::Interner::Global().Intern(name); }
+
+// nesting is a synthetic function body: depth nested blocks declaring
+// three names each inside a package of 500 names, and the identifier uses
+// of its innermost block, which refer to locals at every depth, package
+// names and predeclared names like a typical body does.
+struct nesting {
+    std::deque<types::Object> objs;
+    types::Scope pkg{&types::Universe()};
+    std::vector<common::SymbolId> uses;
+
+    types::Object *make(const std::string &name) {
+        auto &obj = objs.emplace_back();
+        obj.Name = sym(name);
+        return &obj;
+    }
+
+    explicit nesting(int depth) {
+        for (int i = 0; i < 500; i++) {
+            pkg.Insert(make(fmt::format("pkg{}", i)));
+        }
+        pkg.Freeze();
+        std::mt19937 rng(1);
+        const char *predeclared[] = {"int", "string", "len", "nil", "true", "append", "error", "byte"};
+        for (int i = 0; i < 1024; i++) {
+            switch (rng() % 4) {
+            case 0:
+            case 1:
+                uses.push_back(sym(fmt::format("v{}_{}", rng() % depth, rng() % 3)));
+                break;
+            case 2:
+                uses.push_back(sym(fmt::format("pkg{}", rng() % 500)));
+                break;
+            default:
+                uses.push_back(sym(predeclared[rng() % 8]));
+                break;
+            }
+        }
+    }
+};
+
+// BM_Lookup resolves the uses through BlockScopes over the shared scopes.
+void BM_Lookup(benchmark::State &state) {
+    auto depth = int(state.range(0));
+    nesting n(depth);
+    types::BlockScopes blocks(&n.pkg);
+    auto s = types::NoScope;
+    for (int d = 0; d < depth; d++) {
+        s = blocks.Open(s);
+        for (int j = 0; j < 3; j++) {
+            blocks[s].Insert(n.make(fmt::format("v{}_{}", d, j)));
+        }
+    }
+    for (auto _ : state) {
+        for (auto name : n.uses) {
+            benchmark::DoNotOptimize(blocks.Lookup(s, name));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * n.uses.size());
+}
+
+// BM_LookupMap resolves the same uses through a pointer chain of
+// std::unordered_map blocks, for comparison.
+void BM_LookupMap(benchmark::State &state) {
+    struct block {
+        const block *parent;
+        std::unordered_map<common::SymbolId, types::Object *> objs;
+    };
+    auto depth = int(state.range(0));
+    nesting n(depth);
+    std::deque<block> blocks;
+    blocks.push_back({nullptr, {}});
+    for (auto &obj : n.objs) {
+        blocks.back().objs.emplace(obj.Name, &obj);
+    }
+    for (int d = 0; d < depth; d++) {
+        blocks.push_back({&blocks.back(), {}});
+        for (int j = 0; j < 3; j++) {
+            auto obj = n.make(fmt::format("v{}_{}", d, j));
+            blocks.back().objs.emplace(obj->Name, obj);
+        }
+    }
+    for (auto _ : state) {
+        for (auto name : n.uses) {
+            types::Object *obj = nullptr;
+            for (const block *b = &blocks.back(); b != nullptr && obj == nullptr; b = b->parent) {
+                if (auto it = b->objs.find(name); it != b->objs.end()) {
+                    obj = it->second;
+                }
+            }
+            benchmark::DoNotOptimize(obj != nullptr ? obj : types::Universe().LookupLocal(name));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * n.uses.size());
+}
+
+// nested generates a package of n functions, each nesting depth blocks
+// that declare variables and use those of all enclosing blocks.
+std::string nested(int n, int depth) {
+    std::string src = "package bench\n\nvar g int\n\n";
+    for (int i = 0; i < n; i++) {
+        src += fmt::format("func f{}(p int) int {{\n", i);
+        for (int d = 0; d < depth; d++) {
+            src += fmt::format("\tv{0} := p + g + len(\"x\")\n", d);
+            for (int u = d; u >= 0 && u > d - 4; u--) {
+                src += fmt::format("\tv{0} += v{1}\n", d, u);
+            }
+            src += "\tif v" + std::to_string(d) + " > 0 {\n";
+        }
+        src += "\tp++\n";
+        for (int d = 0; d < depth; d++) {
+            src += "\t}\n";
+        }
+        src += "\treturn p\n}\n\n";
+    }
+    return src;
+}
+
+// BM_CheckNested checks deeply nested function bodies on one thread.
+void BM_CheckNested(benchmark::State &state) {
+    auto f = syntax::Parse(std::make_unique<std::istringstream>(nested(200, int(state.range(0)))), nullptr);
+    ast::File *files[] = {f.get()};
+    for (auto _ : state) {
+        types::Checker c;
+        benchmark::DoNotOptimize(c.Check(files, false));
+    }
+    state.SetItemsProcessed(state.iterations() * 200);
+}
+
+} // namespace
+
+BENCHMARK(BM_Lookup)->Arg(4)->Arg(16)->Arg(64);
+BENCHMARK(BM_LookupMap)->Arg(4)->Arg(16)->Arg(64);
+BENCHMARK(BM_CheckNested)->Arg(8)->Arg(32)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
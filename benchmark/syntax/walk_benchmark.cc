@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+
+#include "syntax/ast/walk.hh"
+#include "syntax/parser.hh"
+
+namespace {
+
+// chain generates a package whose only initializer is x + x + ... + x with
+// n operands, as produced by code generators.
+std::string chain(int n) {
+    std::string src = "package bench\n\nvar x int\nvar y = x";
+    for (int i = 1; i < n; i++) {
+        src += " + x";
+    }
+    return src + "\n";
+}
+
+struct counter : ast::Visitor {
+    int64_t n = 0;
+    bool Enter(ast::NodePtr, ast::NodePtr) override {
+        n++;
+        return false;
+    }
+    bool Leave(ast::NodePtr, ast::NodePtr) override { return true; }
+};
+
+void BM_Accept(benchmark::State &state) {
+    auto f = syntax::Parse(std::make_unique<std::istringstream>(chain(int(state.range(0)))), nullptr);
+    for (auto _ : state) {
+        counter c;
+        f->Accept(&c, f.get());
+        benchmark::DoNotOptimize(c.n);
+    }
+}
+
+void BM_Walk(benchmark::State &state) {
+    auto f = syntax::Parse(std::make_unique<std::istringstream>(chain(int(state.range(0)))), nullptr);
+    ast::Walker w;
+    for (auto _ : state) {
+        int64_t n = 0;
+        w.Walk(f.get(), [&](ast::Node *) {
+            n++;
+            return ast::Visit::Children;
+        });
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_Accept)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_Walk)->Arg(1000)->Arg(10000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,197 @@
+#include "build/cache.hh"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <fmt/format.h>
+
+#include "common/mapped_file.hh"
+
+namespace build {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// the first line of an action entry
+constexpr std::string_view entry_header = "pxcppgo-cache 1\n";
+
+// files used within the hour are not touched again on use
+constexpr auto touch_interval = std::chrono::hours(1);
+
+// touch marks file as used now, if it was not within the last hour.
+void touch(const std::string &file) {
+    std::error_code ec;
+    auto now = fs::file_time_type::clock::now();
+    auto mtime = fs::last_write_time(file, ec);
+    if (!ec && now - mtime > touch_interval) {
+        fs::last_write_time(file, now, ec);
+    }
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Hasher
+
+Hasher &Hasher::Add(std::string_view field) {
+    Add(uint64_t(field.size()));
+    _state.Update(field);
+    return *this;
+}
+
+Hasher &Hasher::Add(uint64_t field) {
+    char b[8];
+    for (int i = 0; i < 8; i++) {
+        b[i] = char(field >> (8 * i));
+    }
+    _state.Update(std::string_view(b, sizeof(b)));
+    return *this;
+}
+
+std::string Hasher::Sum() const { return _state.Sum(); }
+
+// ----------------------------------------------------------------------------
+// Cache
+
+Cache::Cache(std::string dir, uint64_t max_size) : _dir(std::move(dir)), _max_size(max_size) {}
+
+std::string Cache::Hash(std::string_view data) { return common::Digest(data); }
+
+const std::string &Cache::ToolId() {
+    static const std::string id = [] {
+        auto exe = common::MappedFile::Open("/proc/self/exe");
+        return exe != nullptr ? Hash(exe->View()) : std::string(16, '\0');
+    }();
+    return id;
+}
+
+std::string Cache::file(std::string_view digest, char kind) const {
+    auto name = common::HexDigest(digest);
+    return fmt::format("{}/{}/{}-{}", _dir, name.substr(0, 2), name, kind);
+}
+
+bool Cache::write(const std::string &file, std::string_view data) const {
+    static std::atomic<uint64_t> seq{0};
+
+    std::error_code ec;
+    fs::create_directories(fs::path(file).parent_path(), ec);
+    auto tmp = fmt::format("{}.{}.{}.tmp", file, getpid(), seq.fetch_add(1));
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), std::streamsize(data.size()));
+        if (!out.flush()) {
+            out.close();
+            fs::remove(tmp, ec);
+            return false;
+        }
+    }
+    fs::rename(tmp, file, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+std::optional<std::vector<std::string>> Cache::Get(std::string_view key) const {
+    auto entry_file = file(key, 'a');
+    auto entry = common::MappedFile::Open(entry_file);
+    if (entry == nullptr || !entry->View().starts_with(entry_header)) {
+        return std::nullopt;
+    }
+    std::vector<std::string> outputs;
+    std::istringstream lines(std::string(entry->View().substr(entry_header.size())));
+    std::string name;
+    uint64_t size;
+    while (lines >> name >> size) {
+        auto out_file = fmt::format("{}/{}/{}-d", _dir, name.substr(0, 2), name);
+        auto out = common::MappedFile::Open(out_file);
+        if (out == nullptr) {
+            return std::nullopt;
+        }
+        if (out->Size() != size || common::HexDigest(Hash(out->View())) != name) {
+            // damaged: remove it, so that it is written again
+            std::error_code ec;
+            fs::remove(out_file, ec);
+            return std::nullopt;
+        }
+        touch(out_file);
+        outputs.emplace_back(out->View());
+    }
+    if (!lines.eof()) {
+        return std::nullopt;
+    }
+    touch(entry_file);
+    return outputs;
+}
+
+bool Cache::Put(std::string_view key, const std::vector<std::string_view> &outputs) const {
+    std::string entry(entry_header);
+    for (auto out : outputs) {
+        auto d = Hash(out);
+        auto out_file = file(d, 'd');
+        // an output already stored is shared, and only marked as used
+        std::error_code ec;
+        if (fs::file_size(out_file, ec) == out.size() && !ec) {
+            touch(out_file);
+        } else if (!write(out_file, out)) {
+            return false;
+        }
+        entry += fmt::format("{} {}\n", common::HexDigest(d), out.size());
+    }
+    return write(file(key, 'a'), entry);
+}
+
+uint64_t Cache::Trim() const {
+    struct used {
+        fs::file_time_type mtime;
+        uint64_t size;
+        fs::path path;
+    };
+    std::vector<used> files;
+    uint64_t size = 0;
+    auto now = fs::file_time_type::clock::now();
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(_dir, ec); !ec && it != fs::recursive_directory_iterator();
+         it.increment(ec)) {
+        // errors on a file skip it, not the rest of the cache
+        std::error_code fe;
+        if (!it->is_regular_file(fe)) {
+            continue;
+        }
+        auto mtime = it->last_write_time(fe);
+        if (it->path().extension() == ".tmp") {
+            if (!fe && now - mtime > touch_interval) {
+                fs::remove(it->path(), fe);
+            }
+            continue;
+        }
+        auto n = it->file_size(fe);
+        if (!fe) {
+            files.push_back({mtime, n, it->path()});
+            size += n;
+        }
+    }
+    if (size <= _max_size) {
+        return size;
+    }
+    std::sort(files.begin(), files.end(), [](auto &a, auto &b) { return a.mtime < b.mtime; });
+    for (auto &f : files) {
+        if (size <= _max_size / 10 * 9) {
+            break;
+        }
+        if (fs::remove(f.path, ec)) {
+            size -= f.size;
+        }
+    }
+    return size;
+}
+
+} // namespace build
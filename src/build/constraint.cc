@@ -0,0 +1,272 @@
+#include "build/constraint.hh"
+
+#include <algorithm>
+#include <vector>
+
+namespace build {
+
+namespace {
+
+constexpr std::string_view knownOS[] = {
+    "aix",   "android", "darwin", "dragonfly", "freebsd", "hurd",    "illumos", "ios",     "js",
+    "linux", "nacl",    "netbsd", "openbsd",   "plan9",   "solaris", "wasip1",  "windows", "zos",
+};
+
+constexpr std::string_view unixOS[] = {
+    "aix",   "android", "darwin", "dragonfly", "freebsd", "hurd",
+    "illumos", "ios",   "linux",  "netbsd",    "openbsd", "solaris",
+};
+
+constexpr std::string_view knownArch[] = {
+    "386",     "amd64",  "amd64p32", "arm",       "armbe",       "arm64", "arm64be", "loong64",
+    "mips",    "mipsle", "mips64",   "mips64le",  "mips64p32",   "mips64p32le", "ppc", "ppc64",
+    "ppc64le", "riscv",  "riscv64",  "s390",      "s390x",       "sparc", "sparc64", "wasm",
+};
+
+template <size_t N>
+bool contains(const std::string_view (&list)[N], std::string_view s) {
+    return std::find(std::begin(list), std::end(list), s) != std::end(list);
+}
+
+bool isTagChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.';
+}
+
+// expr evaluates a //go:build expression by recursive descent:
+//
+//	or   = and { "||" and }
+//	and  = not { "&&" not }
+//	not  = "!" not | "(" or ")" | tag
+struct expr {
+    std::string_view s;
+    const Target &target;
+    std::string error;
+
+    void skip() {
+        while (!s.empty() && (s[0] == ' ' || s[0] == '\t')) {
+            s.remove_prefix(1);
+        }
+    }
+
+    bool got(std::string_view tok) {
+        skip();
+        if (!s.starts_with(tok)) {
+            return false;
+        }
+        s.remove_prefix(tok.size());
+        return true;
+    }
+
+    bool orExpr() {
+        auto x = andExpr();
+        while (error.empty() && got("||")) {
+            x = andExpr() || x; // evaluated first to parse the whole line
+        }
+        return x;
+    }
+
+    bool andExpr() {
+        auto x = notExpr();
+        while (error.empty() && got("&&")) {
+            x = notExpr() && x;
+        }
+        return x;
+    }
+
+    bool notExpr() {
+        if (got("!")) {
+            return !notExpr();
+        }
+        if (got("(")) {
+            auto x = orExpr();
+            if (error.empty() && !got(")")) {
+                error = "missing )";
+            }
+            return x;
+        }
+        skip();
+        size_t n = 0;
+        while (n < s.size() && isTagChar(s[n])) {
+            n++;
+        }
+        if (n == 0) {
+            if (error.empty()) {
+                error = s.empty() ? "unexpected end of expression" : "unexpected token " + std::string(s.substr(0, 1));
+            }
+            return false;
+        }
+        auto tag = s.substr(0, n);
+        s.remove_prefix(n);
+        return target.Match(tag);
+    }
+};
+
+// plusBuild evaluates the options of a // +build line: the line is
+// satisfied if one of its space-separated options is, and an option if all
+// of its comma-separated terms are.
+bool plusBuild(std::string_view line, const Target &target) {
+    bool any = false;
+    while (!line.empty()) {
+        auto end = line.find_first_of(" \t");
+        auto option = line.substr(0, end);
+        line = end == std::string_view::npos ? std::string_view{} : line.substr(end + 1);
+        if (option.empty()) {
+            continue;
+        }
+        bool all = true;
+        while (!option.empty() && all) {
+            auto comma = option.find(',');
+            auto term = option.substr(0, comma);
+            option = comma == std::string_view::npos ? std::string_view{} : option.substr(comma + 1);
+            bool negated = term.starts_with('!');
+            if (negated) {
+                term.remove_prefix(1);
+            }
+            all = !term.empty() && target.Match(term) != negated;
+        }
+        any = any || all;
+    }
+    return any;
+}
+
+// goodOSArchFile reports whether the _GOOS, _GOARCH or _GOOS_GOARCH suffix
+// of name, if any, is that of target.
+bool goodOSArchFile(std::string_view name, const Target &target) {
+    name = name.substr(0, name.find('.'));
+    auto i = name.find('_');
+    if (i == std::string_view::npos) {
+        return true;
+    }
+    std::vector<std::string_view> parts;
+    for (name.remove_prefix(i + 1);;) {
+        auto j = name.find('_');
+        parts.push_back(name.substr(0, j));
+        if (j == std::string_view::npos) {
+            break;
+        }
+        name.remove_prefix(j + 1);
+    }
+    if (parts.back() == "test") {
+        parts.pop_back();
+    }
+    auto n = parts.size();
+    if (n >= 2 && contains(knownOS, parts[n - 2]) && contains(knownArch, parts[n - 1])) {
+        return target.Match(parts[n - 2]) && target.Match(parts[n - 1]);
+    }
+    if (n >= 1 && (contains(knownOS, parts[n - 1]) || contains(knownArch, parts[n - 1]))) {
+        return target.Match(parts[n - 1]);
+    }
+    return true;
+}
+
+} // namespace
+
+bool Target::Match(std::string_view tag) const {
+    if (tag == GOOS || tag == GOARCH || tag == "gc") {
+        return true;
+    }
+    if ((GOOS == "android" && tag == "linux") || (GOOS == "illumos" && tag == "solaris") ||
+        (GOOS == "ios" && tag == "darwin")) {
+        return true;
+    }
+    if (tag == "unix") {
+        return contains(unixOS, GOOS);
+    }
+    // the release tags of go1.21
+    if (tag.starts_with("go1.")) {
+        auto minor = tag.substr(4);
+        int n = 0;
+        for (auto c : minor) {
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            n = n * 10 + (c - '0');
+        }
+        return !minor.empty() && n >= 1 && n <= 21;
+    }
+    return false;
+}
+
+bool MatchFile(std::string_view name, std::string_view src, const Target &target, std::string &error) {
+    if (!goodOSArchFile(name, target)) {
+        return false;
+    }
+    // the header is the leading run of comments and blank lines; the
+    // // +build lines count only before its last blank line
+    std::vector<std::string_view> goBuild, plus;
+    size_t plusBeforeBlank = 0;
+    bool inComment = false;
+    while (!src.empty()) {
+        auto end = src.find('\n');
+        auto line = src.substr(0, end);
+        src = end == std::string_view::npos ? std::string_view{} : src.substr(end + 1);
+        while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) {
+            line.remove_suffix(1);
+        }
+        while (!line.empty() && (line.front() == ' ' || line.front() == '\t')) {
+            line.remove_prefix(1);
+        }
+        if (inComment) {
+            auto close = line.find("*/");
+            if (close == std::string_view::npos) {
+                continue;
+            }
+            inComment = false;
+            line.remove_prefix(close + 2);
+            if (!line.empty()) {
+                break;
+            }
+            continue;
+        }
+        if (line.empty()) {
+            plusBeforeBlank = plus.size();
+            continue;
+        }
+        if (line.starts_with("/*")) {
+            auto close = line.find("*/", 2);
+            if (close == std::string_view::npos) {
+                inComment = true;
+            } else if (close + 2 != line.size()) {
+                break;
+            }
+            continue;
+        }
+        if (!line.starts_with("//")) {
+            break;
+        }
+        if (line.starts_with("//go:build") && (line.size() == 10 || line[10] == ' ' || line[10] == '\t')) {
+            goBuild.push_back(line.substr(10));
+        } else if (auto text = line.substr(2); text.find_first_not_of(" \t") != std::string_view::npos) {
+            text.remove_prefix(text.find_first_not_of(" \t"));
+            if (text.starts_with("+build") && (text.size() == 6 || text[6] == ' ' || text[6] == '\t')) {
+                plus.push_back(text.substr(6));
+            }
+        }
+    }
+
+    if (goBuild.size() > 1) {
+        error = "multiple //go:build comments";
+        return false;
+    }
+    if (goBuild.size() == 1) {
+        expr e{goBuild[0], target, {}};
+        auto ok = e.orExpr();
+        e.skip();
+        if (e.error.empty() && !e.s.empty()) {
+            e.error = "unexpected token " + std::string(e.s.substr(0, 1));
+        }
+        if (!e.error.empty()) {
+            error = "parsing //go:build line: " + e.error;
+            return false;
+        }
+        return ok;
+    }
+    for (size_t i = 0; i < plusBeforeBlank; i++) {
+        if (!plusBuild(plus[i], target)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace build
@@ -0,0 +1,253 @@
+#include <fmt/format.h>
+#include <tbb/task_group.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
+#include "build/build.hh"
+#include "common/mapped_file.hh"
+#include "syntax/parser.hh"
+#include "syntax/types/constant.hh"
+
+namespace build {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// packageCost is the fixed part of the cost of a package, in bytes of
+// source, for the work that does not depend on its size.
+constexpr uint64_t packageCost = 4096;
+
+// loader finds the packages reachable from the roots. Each package is
+// scanned by its own task, which loads the packages it imports in turn.
+struct loader {
+    fs::path root;
+    Target target;
+    tbb::task_group tasks;
+    std::mutex mu; // guards the fields below
+    std::unordered_map<std::string, Package *> byPath;
+    std::vector<std::unique_ptr<Package>> packages;
+    std::vector<std::string> errors;
+
+    bool exists(const std::string &path) {
+        std::error_code ec;
+        return fs::is_directory(root / path, ec);
+    }
+
+    void load(const std::string &path) {
+        Package *pkg;
+        {
+            std::lock_guard lock(mu);
+            if (byPath.contains(path)) {
+                return;
+            }
+            pkg = packages.emplace_back(std::make_unique<Package>()).get();
+            pkg->Path = path;
+            pkg->Dir = (root / path).string();
+            byPath.emplace(path, pkg);
+        }
+        tasks.run([this, pkg] { scan(*pkg); });
+    }
+
+    // scan lists the files of pkg built for the target and parses their
+    // import clauses.
+    void scan(Package &pkg) {
+        std::error_code ec;
+        bool excluded = false;
+        for (auto &e : fs::directory_iterator(pkg.Dir, ec)) {
+            auto name = e.path().filename().string();
+            if (!e.is_regular_file(ec) || !name.ends_with(".go") || name.ends_with("_test.go")) {
+                continue;
+            }
+            auto src = common::MappedFile::Open(e.path().string());
+            std::string error;
+            if (src != nullptr && !MatchFile(name, src->View(), target, error)) {
+                if (!error.empty()) {
+                    pkg.Errors.push_back(fmt::format("{}: {}", e.path().string(), error));
+                }
+                excluded = true;
+                continue;
+            }
+            pkg.Files.push_back(e.path().string());
+            pkg.Cost += e.file_size(ec);
+        }
+        std::sort(pkg.Files.begin(), pkg.Files.end());
+        std::sort(pkg.Errors.begin(), pkg.Errors.end());
+        pkg.Cost += packageCost;
+        if (pkg.Files.empty() && pkg.Errors.empty()) {
+            pkg.Errors.push_back(excluded ? fmt::format("build constraints exclude all Go files in {}", pkg.Dir)
+                                          : fmt::format("no Go files in {}", pkg.Dir));
+        }
+        if (pkg.Files.empty()) {
+            return;
+        }
+
+        for (auto &file : pkg.Files) {
+            // syntax errors are reported when the package is built
+            auto f = syntax::ParseFile(file, [](uint, uint, std::string) {}, ImportsOnly);
+            if (f == nullptr) {
+                continue;
+            }
+            syntax::FileSet::Global().Release(f->pos); // only the import paths are kept
+            for (auto &d : f->DeclList) {
+                auto imp = dyn_cast<ast::ImportDecl>(d.get());
+                if (imp == nullptr || imp->Path == nullptr || imp->Path->Bad) {
+                    continue;
+                }
+                // imports of packages not under the root are left out of
+                // the graph; the type checker reports them
+                auto path = types::Value::MakeFromLiteral(imp->Path->Value, StringLit);
+                if (path.IsKnown() && exists(std::string(path.StringVal()))) {
+                    pkg.Imports.emplace_back(path.StringVal());
+                }
+            }
+        }
+        std::sort(pkg.Imports.begin(), pkg.Imports.end());
+        pkg.Imports.erase(std::unique(pkg.Imports.begin(), pkg.Imports.end()), pkg.Imports.end());
+        for (auto &path : pkg.Imports) {
+            load(path);
+        }
+    }
+};
+
+// cycle returns an import cycle reached from pkg, which is on a cycle or
+// imports a package that is, as the packages "a", "b", "a".
+std::vector<Package *> cycle(Package *pkg, const std::vector<bool> &cyclic) {
+    std::vector<Package *> path;
+    std::unordered_map<Package *, size_t> seen;
+    for (auto p = pkg; !seen.contains(p);) {
+        seen.emplace(p, path.size());
+        path.push_back(p);
+        // some import of a package on a cycle is on a cycle too
+        p = *std::find_if(p->Deps.begin(), p->Deps.end(), [&](Package *d) { return cyclic[d->Index]; });
+        if (seen.contains(p)) {
+            path.erase(path.begin(), path.begin() + ptrdiff_t(seen.at(p)));
+            path.push_back(p);
+        }
+    }
+    return path;
+}
+
+} // namespace
+
+Package::~Package() {
+    for (auto &f : Syntax) {
+        if (f != nullptr) {
+            syntax::FileSet::Global().Release(f->pos);
+        }
+    }
+}
+
+Graph Load(const std::string &root, std::span<const std::string> paths, const Target &target) {
+    loader l;
+    l.root = root;
+    l.target = target;
+    for (auto &path : paths) {
+        if (l.exists(path)) {
+            l.load(path);
+        } else {
+            l.errors.push_back(fmt::format("package {} is not in {}", path, root));
+        }
+    }
+    l.tasks.wait();
+
+    // link the packages in a deterministic order
+    Graph g;
+    g.Errors = std::move(l.errors);
+    auto &pkgs = l.packages;
+    std::sort(pkgs.begin(), pkgs.end(), [](auto &a, auto &b) { return a->Path < b->Path; });
+    for (size_t i = 0; i < pkgs.size(); i++) {
+        pkgs[i]->Index = i;
+    }
+    for (auto &pkg : pkgs) {
+        for (auto &path : pkg->Imports) {
+            auto dep = l.byPath.at(path);
+            pkg->Deps.push_back(dep);
+            dep->Importers.push_back(pkg.get());
+        }
+    }
+
+    // order the packages dependencies first; those left over are on an
+    // import cycle or import a package that is
+    std::vector<size_t> pending(pkgs.size());
+    std::vector<Package *> order;
+    for (auto &pkg : pkgs) {
+        pending[pkg->Index] = pkg->Deps.size();
+        if (pkg->Deps.empty()) {
+            order.push_back(pkg.get());
+        }
+    }
+    for (size_t i = 0; i < order.size(); i++) {
+        for (auto imp : order[i]->Importers) {
+            if (--pending[imp->Index] == 0) {
+                order.push_back(imp);
+            }
+        }
+    }
+    if (order.size() < pkgs.size()) {
+        // the packages on cycles are those left over that reach themselves
+        // through other left-over packages; report each cycle once
+        std::vector<bool> left(pkgs.size()), cyclic(pkgs.size()), reported(pkgs.size());
+        for (auto &pkg : pkgs) {
+            left[pkg->Index] = pending[pkg->Index] > 0;
+        }
+        for (auto &pkg : pkgs) {
+            std::vector<Package *> stack{pkg.get()};
+            std::vector<bool> seen(pkgs.size());
+            while (left[pkg->Index] && !stack.empty() && !cyclic[pkg->Index]) {
+                auto p = stack.back();
+                stack.pop_back();
+                for (auto d : p->Deps) {
+                    if (d == pkg.get()) {
+                        cyclic[pkg->Index] = true;
+                    } else if (left[d->Index] && !seen[d->Index]) {
+                        seen[d->Index] = true;
+                        stack.push_back(d);
+                    }
+                }
+            }
+        }
+        for (auto &pkg : pkgs) {
+            if (!cyclic[pkg->Index] || reported[pkg->Index]) {
+                continue;
+            }
+            auto c = cycle(pkg.get(), cyclic);
+            if (reported[c[0]->Index]) {
+                continue;
+            }
+            std::string msg = "import cycle not allowed: ";
+            for (size_t i = 0; i < c.size(); i++) {
+                reported[c[i]->Index] = true;
+                msg += (i > 0 ? " -> " : "") + c[i]->Path;
+            }
+            g.Errors.push_back(std::move(msg));
+        }
+        // forget the left-over packages
+        for (auto pkg : order) {
+            std::erase_if(pkg->Importers, [&](Package *imp) { return left[imp->Index]; });
+        }
+    }
+
+    // the priority of a package is its cost plus the highest priority of
+    // its importers
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        auto pkg = *it;
+        uint64_t next = 0;
+        for (auto imp : pkg->Importers) {
+            next = std::max(next, imp->Priority);
+        }
+        pkg->Priority = pkg->Cost + next;
+    }
+
+    for (auto pkg : order) {
+        auto &owner = pkgs[pkg->Index];
+        pkg->Index = g.Packages.size();
+        g.Packages.push_back(std::move(owner));
+    }
+    return g;
+}
+
+} // namespace build
@@ -0,0 +1,339 @@
+#include <fmt/format.h>
+#include <tbb/concurrent_priority_queue.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+
+#include "build/build.hh"
+#include "common/mapped_file.hh"
+#include "syntax/cache/ast_cache.hh"
+#include "syntax/parser.hh"
+
+namespace build {
+
+namespace {
+
+// urgency orders the ready packages by priority; ties go to the package
+// that comes first in the graph, for a stable order on one thread.
+struct urgency {
+    bool operator()(const Package *a, const Package *b) const {
+        return a->Priority != b->Priority ? a->Priority < b->Priority : a->Index > b->Index;
+    }
+};
+
+// buffer copies data into a buffer of its own.
+flatbuffers::DetachedBuffer buffer(std::string_view data) {
+    auto buf = new uint8_t[data.size()];
+    std::memcpy(buf, data.data(), data.size());
+    // a buffer without an allocator is freed with delete[]
+    return flatbuffers::DetachedBuffer(nullptr, false, buf, data.size(), buf, data.size());
+}
+
+// embedPatterns adds the patterns of each //go:embed directive in src to
+// embeds. It scans the text before the file is parsed, so it may take a
+// directive out of a string literal: that only adds files to a key.
+void embedPatterns(std::string_view src, std::vector<std::vector<std::string>> &embeds) {
+    std::string_view prefix = "//go:embed";
+    for (auto i = src.find(prefix); i != std::string_view::npos; i = src.find(prefix, i + 1)) {
+        auto args = src.substr(i + prefix.size());
+        args = args.substr(0, args.find('\n'));
+        std::vector<std::string> patterns;
+        if ((args.starts_with(' ') || args.starts_with('\t')) && syntax::ParseGoEmbed(args, patterns) &&
+            !patterns.empty()) {
+            embeds.push_back(std::move(patterns));
+        }
+    }
+}
+
+// scheduler runs the builds of the packages of a graph. A package is
+// released into the ready queue once the last package it imports is
+// type-checked, and one task is spawned per released package. A task
+// does not build the package it was spawned for but the most urgent one
+// ready when it runs, so that TBB's work stealing spreads the builds
+// across threads while the ready queue decides their order. With a cache,
+// the key of a package is computed when it is released, once the export
+// data of its imports is known, and a hit skips its parse, check and
+// compile stages.
+struct scheduler {
+    Graph &g;
+    const Options &opts;
+    tbb::task_group tasks;
+    tbb::concurrent_priority_queue<Package *, urgency> ready;
+    std::unique_ptr<std::atomic<size_t>[]> pending; // imports not checked yet, by package index
+    std::unique_ptr<std::atomic<bool>[]> failed;    // some import failed, by package index
+    std::unique_ptr<Cache> cache;
+    std::unique_ptr<syntax::cache::AstCache> asts; // the parsed files, in the cache
+    std::vector<std::string> keys;    // cache keys by package index, empty if not cacheable
+    std::vector<std::string> exports; // export data to cache, by package index
+    std::optional<compile::CallProfile> profile; // parsed from opts.Profile
+    std::string profileHash;                     // the digest of opts.Profile, for the keys
+
+    scheduler(Graph &g, const Options &opts)
+        : g(g), opts(opts), pending(new std::atomic<size_t>[g.Packages.size()]),
+          failed(new std::atomic<bool>[g.Packages.size()]) {
+        for (auto &pkg : g.Packages) {
+            pending[pkg->Index] = pkg->Deps.size();
+            failed[pkg->Index] = false;
+        }
+        if (!opts.CacheDir.empty()) {
+            cache = std::make_unique<Cache>(opts.CacheDir, opts.CacheSize);
+            asts = std::make_unique<syntax::cache::AstCache>(opts.CacheDir + "/ast");
+            keys.resize(g.Packages.size());
+            exports.resize(g.Packages.size());
+        }
+        if (!opts.Profile.empty()) {
+            std::string error;
+            profile = compile::CallProfile::Parse(opts.Profile, error);
+            profileHash = Cache::Hash(opts.Profile);
+        }
+    }
+
+    void run() {
+        for (auto &pkg : g.Packages) {
+            if (pkg->Deps.empty()) {
+                release(pkg.get());
+            }
+        }
+        tasks.wait();
+    }
+
+    void release(Package *pkg) {
+        ready.push(pkg);
+        tasks.run([this] {
+            Package *pkg;
+            if (ready.try_pop(pkg)) {
+                build(*pkg);
+            }
+        });
+    }
+
+    void build(Package &pkg) {
+        if (failed[pkg.Index]) {
+            pkg.Skipped = true;
+        } else if (pkg.Errors.empty() && !restore(pkg)) {
+            parse(pkg);
+            if (pkg.Errors.empty()) {
+                check(pkg);
+            }
+        }
+
+        // the export data of the package is ready: start its importers
+        bool ok = !pkg.Failed();
+        for (auto imp : pkg.Importers) {
+            if (!ok) {
+                failed[imp->Index] = true;
+            }
+            if (--pending[imp->Index] == 0) {
+                release(imp);
+            }
+        }
+        if (ok && !pkg.Cached) {
+            devirtualize(pkg);
+            embed(pkg);
+            if (opts.Compile && pkg.Errors.empty()) {
+                opts.Compile(pkg);
+            }
+            store(pkg);
+        }
+    }
+
+    // restore restores the export data and outputs of pkg from the cache,
+    // if its key is there, and reports whether it did.
+    bool restore(Package &pkg) {
+        if (cache == nullptr) {
+            return false;
+        }
+        Hasher h;
+        h.Add(pkg.Path).Add(Cache::ToolId()).Add(uint64_t(ExportDataVersion));
+        h.Add(uint64_t(opts.InlineBudget)).Add(uint64_t(opts.Flags.size()));
+        for (auto &flag : opts.Flags) {
+            h.Add(flag);
+        }
+        h.Add(profileHash);
+        h.Add(uint64_t(pkg.Files.size()));
+        std::vector<std::vector<std::string>> embeds;
+        for (auto &file : pkg.Files) {
+            auto src = common::MappedFile::Open(file);
+            if (src == nullptr) {
+                return false; // reported by the parser
+            }
+            h.Add(std::filesystem::path(file).filename().string()).Add(src->View());
+            embedPatterns(src->View(), embeds);
+        }
+        for (auto dep : pkg.Deps) {
+            h.Add(dep->ExportHash);
+        }
+        // the files embedded, by content; a pattern that names none fails
+        // the build, unless the scan took it out of a string
+        std::vector<std::string> names;
+        for (auto &patterns : embeds) {
+            std::string err;
+            auto files = staticdata::ResolveEmbed(pkg.Dir, patterns, err);
+            h.Add(err);
+            names.insert(names.end(), files.begin(), files.end());
+        }
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+        h.Add(uint64_t(names.size()));
+        for (auto &name : names) {
+            auto &f = pkg.Embeds.emplace_back();
+            if (!staticdata::WriteEmbed(pkg.Dir + "/" + name, nullptr, f)) {
+                return false; // reported by the embed stage
+            }
+            h.Add(name).Add(f.Hash);
+        }
+        auto &key = keys[pkg.Index] = h.Sum();
+
+        auto outputs = cache->Get(key);
+        if (!outputs || outputs->empty() || !g.Exports->Add(pkg.Path, buffer(outputs->front()))) {
+            return false;
+        }
+        pkg.ExportHash = Cache::Hash(outputs->front());
+        pkg.Outputs.assign(outputs->begin() + 1, outputs->end());
+        pkg.Cached = true;
+        return true;
+    }
+
+    // store caches the export data and outputs of pkg, built without
+    // errors, under its key.
+    void store(Package &pkg) {
+        if (cache == nullptr || keys[pkg.Index].empty() || !pkg.Errors.empty()) {
+            return;
+        }
+        std::vector<std::string_view> outputs{exports[pkg.Index]};
+        outputs.insert(outputs.end(), pkg.Outputs.begin(), pkg.Outputs.end());
+        cache->Put(keys[pkg.Index], outputs); // the cache is best effort
+        exports[pkg.Index] = {};
+    }
+
+    void parse(Package &pkg) {
+        pkg.Syntax.resize(pkg.Files.size());
+        std::vector<std::vector<std::string>> errors(pkg.Files.size());
+        tbb::parallel_for(size_t(0), pkg.Files.size(), [&](size_t i) {
+            auto &file = pkg.Files[i];
+            auto errh = [&](uint line, uint col, std::string msg) {
+                errors[i].push_back(fmt::format("{}:{}:{}: {}", file, line, col, msg));
+            };
+            // the files of a package rebuilt for a change elsewhere are
+            // decoded from the AST cache instead of parsed again
+            std::unique_ptr<common::MappedFile> src;
+            if (asts != nullptr && (src = common::MappedFile::Open(file)) != nullptr) {
+                pkg.Syntax[i] = syntax::cache::ParseCached(*asts, src->View(), errh, directives, file);
+            } else {
+                pkg.Syntax[i] = syntax::ParseFile(file, errh, directives);
+            }
+        });
+        for (auto &errs : errors) {
+            pkg.Errors.insert(pkg.Errors.end(), errs.begin(), errs.end());
+        }
+    }
+
+    void check(Package &pkg) {
+        std::vector<ast::File *> files;
+        for (auto &f : pkg.Syntax) {
+            files.push_back(f.get());
+        }
+        pkg.Types = std::make_unique<types::Checker>(g.Exports.get());
+        for (auto &e : pkg.Types->Check(files, opts.ParallelBodies)) {
+            auto p = syntax::FileSet::Global().Resolve(e.Pos);
+            pkg.Errors.push_back(fmt::format("{}:{}:{}: {}", p.Filename, p.Line, p.Col, e.Msg));
+        }
+        if (!pkg.Errors.empty()) {
+            return;
+        }
+        types::InlineBodies bodies;
+        if (opts.InlineBudget > 0) {
+            pkg.Inline = std::make_unique<compile::Inliner>(*pkg.Types, opts.InlineBudget);
+            pkg.Inline->Analyze(files);
+            bodies = pkg.Inline->Exports();
+        }
+        pkg.Stencil = std::make_unique<compile::Stenciler>(*pkg.Types, pkg.Path, g.Instances.get());
+        pkg.Stencil->Analyze(files);
+        bodies.merge(pkg.Stencil->Exports());
+        // the escape summaries of the functions, for the analysis of their callers
+        pkg.Escape = std::make_unique<compile::EscapeAnalysis>(*pkg.Types);
+        pkg.Escape->Analyze(files);
+        auto leaks = pkg.Escape->Exports();
+        auto data = types::Export(*pkg.Types, pkg.Path, &bodies, &leaks);
+        std::string_view view(reinterpret_cast<const char *>(data.data()), data.size());
+        pkg.ExportHash = Cache::Hash(view);
+        if (cache != nullptr) {
+            exports[pkg.Index] = view;
+        }
+        if (!g.Exports->Add(pkg.Path, std::move(data))) {
+            pkg.Errors.push_back(fmt::format("could not write export data to {}", g.Exports->File(pkg.Path)));
+        }
+    }
+
+    // devirtualize plans the devirtualization of pkg, which does not
+    // change its export data: it runs once its importers are released.
+    void devirtualize(Package &pkg) {
+        std::vector<ast::File *> files;
+        for (auto &f : pkg.Syntax) {
+            files.push_back(f.get());
+        }
+        pkg.Devirt = std::make_unique<compile::Devirtualizer>(*pkg.Types, pkg.Path, pkg.Inline.get(),
+                                                              profile ? &*profile : nullptr);
+        pkg.Devirt->Analyze(files);
+    }
+
+    // embed resolves the //go:embed directives of pkg and streams the files
+    // they name to the data writer, recording them in Embeds.
+    void embed(Package &pkg) {
+        auto hashed = std::exchange(pkg.Embeds, {}); // for the key
+        std::vector<std::string> names;
+        for (auto &file : pkg.Syntax) {
+            for (auto &d : file->DeclList) {
+                auto v = dyn_cast<ast::VarDecl>(d.get());
+                if (v == nullptr || v->EmbedPatterns.empty()) {
+                    continue;
+                }
+                std::string err;
+                auto files = staticdata::ResolveEmbed(pkg.Dir, v->EmbedPatterns, err);
+                if (!err.empty()) {
+                    auto p = syntax::FileSet::Global().Resolve(v->GetPos());
+                    pkg.Errors.push_back(fmt::format("{}:{}:{}: {}", p.Filename, p.Line, p.Col, err));
+                }
+                names.insert(names.end(), files.begin(), files.end());
+            }
+        }
+        std::sort(names.begin(), names.end());
+        names.erase(std::unique(names.begin(), names.end()), names.end());
+        staticdata::SectionWriter w;
+        if (opts.Data) {
+            w = [&](std::string_view chunk) { opts.Data(pkg, chunk); };
+        }
+        for (auto &name : names) {
+            auto &f = pkg.Embeds.emplace_back();
+            if (!staticdata::WriteEmbed(pkg.Dir + "/" + name, w, f)) {
+                pkg.Errors.push_back(fmt::format("could not read embedded file {}/{}", pkg.Dir, name));
+            }
+            // a file that changed since it was hashed for the key leaves
+            // the results unfit to cache under it
+            auto same = [&](auto &k) { return k.Path == f.Path && k.Hash == f.Hash; };
+            if (cache != nullptr && std::none_of(hashed.begin(), hashed.end(), same)) {
+                keys[pkg.Index].clear();
+            }
+        }
+    }
+};
+
+} // namespace
+
+bool Build(Graph &g, const Options &opts) {
+    g.Exports = std::make_unique<types::DirImporter>(opts.ExportDir);
+    g.Instances = std::make_unique<compile::InstanceCache>();
+    scheduler s(g, opts);
+    s.run();
+    if (s.cache != nullptr) {
+        s.cache->Trim();
+    }
+    return std::none_of(g.Packages.begin(), g.Packages.end(), [](auto &pkg) { return pkg->Failed(); });
+}
+
+} // namespace build
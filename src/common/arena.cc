@@ -0,0 +1,63 @@
+#include "common/arena.hh"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace common {
+
+namespace {
+
+constexpr size_t header = (sizeof(void *) * 2 + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+} // namespace
+
+Arena::~Arena() {
+    while (_chunks != nullptr) {
+        auto next = _chunks->next;
+        std::free(_chunks);
+        _chunks = next;
+    }
+}
+
+void Arena::push(size_t size) {
+    auto c = static_cast<Chunk *>(std::malloc(header + size));
+    if (c == nullptr) {
+        throw std::bad_alloc();
+    }
+    c->next = _chunks;
+    c->size = size;
+    _chunks = c;
+    _reserved += size;
+    _begin = _cur = reinterpret_cast<char *>(c) + header;
+    _end = _cur + size;
+}
+
+void *Arena::grow(size_t size, size_t align) {
+    if (_chunks != nullptr) {
+        _used += size_t(_cur - _begin);
+    }
+    push(std::max(_chunk_size, size + align));
+    return Allocate(size, align);
+}
+
+void Arena::Reset() {
+    if (_chunks == nullptr) {
+        return;
+    }
+    auto used = Used();
+    if (_chunks->next != nullptr) {
+        // keep a single chunk large enough for the whole unit of work
+        while (_chunks != nullptr) {
+            auto next = _chunks->next;
+            std::free(_chunks);
+            _chunks = next;
+        }
+        _reserved = 0;
+        _chunk_size = std::max(_chunk_size, used);
+        push(_chunk_size);
+    }
+    _begin = _cur = reinterpret_cast<char *>(_chunks) + header;
+    _used = 0;
+}
+
+} // namespace common
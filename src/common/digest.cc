@@ -0,0 +1,40 @@
+#include "common/digest.hh"
+
+#include <xxhash.h>
+
+namespace common {
+
+namespace {
+
+std::string encode(XXH128_hash_t h) {
+    std::string d(16, '\0');
+    for (int i = 0; i < 8; i++) {
+        d[i] = char(h.high64 >> (56 - 8 * i));
+        d[8 + i] = char(h.low64 >> (56 - 8 * i));
+    }
+    return d;
+}
+
+} // namespace
+
+std::string Digest(std::string_view data) { return encode(XXH3_128bits(data.data(), data.size())); }
+
+DigestState::DigestState() : _state(XXH3_createState()) { XXH3_128bits_reset(_state); }
+
+DigestState::~DigestState() { XXH3_freeState(_state); }
+
+void DigestState::Update(std::string_view data) { XXH3_128bits_update(_state, data.data(), data.size()); }
+
+std::string DigestState::Sum() const { return encode(XXH3_128bits_digest(_state)); }
+
+std::string HexDigest(std::string_view digest) {
+    constexpr char digits[] = "0123456789abcdef";
+    std::string s(2 * digest.size(), '\0');
+    for (size_t i = 0; i < digest.size(); i++) {
+        s[2 * i] = digits[uint8_t(digest[i]) >> 4];
+        s[2 * i + 1] = digits[uint8_t(digest[i]) & 0xf];
+    }
+    return s;
+}
+
+} // namespace common
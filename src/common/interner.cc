@@ -0,0 +1,103 @@
+#include "common/interner.hh"
+
+#include <cstring>
+
+#include <xxhash.h>
+
+namespace common {
+
+// Pending is the key used to insert a new string. libcuckoo constructs the
+// stored key and value from it while holding the bucket locks, and only when
+// the string is not in the table yet: converting it to a key copies the bytes
+// into the arena, converting it to a value assigns the next ID. The pair is
+// constructed key first, so the ID is published with the stored copy.
+struct Interner::Pending {
+    Interner *in;
+    std::string_view s;
+    std::string_view stored{};
+    SymbolId id = 0;
+
+    operator std::string_view() {
+        stored = in->Store(s);
+        return stored;
+    }
+    operator SymbolId() {
+        id = in->Publish(stored);
+        return id;
+    }
+};
+
+size_t Interner::Hash::operator()(std::string_view s) const { return XXH3_64bits(s.data(), s.size()); }
+size_t Interner::Hash::operator()(const Pending &p) const { return (*this)(p.s); }
+bool Interner::Equal::operator()(std::string_view a, const Pending &b) const { return a == b.s; }
+
+Interner::Interner() : _chunks(new std::atomic<std::string_view *>[size_t(1) << (32 - chunk_bits)]()) {
+    Intern("");
+}
+
+Interner::~Interner() {
+    for (size_t i = 0; i < (size_t(1) << (32 - chunk_bits)); i++) {
+        delete[] _chunks[i].load(std::memory_order_relaxed);
+    }
+}
+
+Interner &Interner::Global() {
+    static Interner global;
+    return global;
+}
+
+SymbolId Interner::Intern(std::string_view s) {
+    SymbolId id;
+    if (_map.find(s, id)) {
+        return id;
+    }
+    // The string may have been inserted concurrently since the lookup above,
+    // in which case the callback reports the existing ID.
+    Pending p{this, s};
+    auto inserted = _map.uprase_fn(
+        p,
+        [&](SymbolId &existing) {
+            id = existing;
+            return false;
+        },
+        p);
+    return inserted ? p.id : id;
+}
+
+bool Interner::Lookup(std::string_view s, SymbolId &id) const { return _map.find(s, id); }
+
+std::string_view Interner::Store(std::string_view s) {
+    if (s.empty()) {
+        return std::string_view("", 0);
+    }
+    tbb::spin_mutex::scoped_lock lock(_arena_mutex);
+    if (s.size() > _avail) {
+        auto size = std::max(s.size(), arena_block_size);
+        _blocks.emplace_back(new char[size]);
+        _cur = _blocks.back().get();
+        _avail = size;
+    }
+    auto dst = _cur;
+    std::memcpy(dst, s.data(), s.size());
+    _cur += s.size();
+    _avail -= s.size();
+    return std::string_view(dst, s.size());
+}
+
+SymbolId Interner::Publish(std::string_view s) {
+    auto id = _next.fetch_add(1, std::memory_order_acq_rel);
+    auto &slot = _chunks[id >> chunk_bits];
+    auto chunk = slot.load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+        auto fresh = new std::string_view[chunk_size];
+        if (slot.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) {
+            chunk = fresh;
+        } else {
+            delete[] fresh;
+        }
+    }
+    chunk[id & (chunk_size - 1)] = s;
+    return id;
+}
+
+} // namespace common
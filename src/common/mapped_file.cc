@@ -0,0 +1,54 @@
+#include "common/mapped_file.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace common {
+
+MappedFile::~MappedFile() {
+    if (_size > 0) {
+        munmap(const_cast<char *>(_data), _size);
+    }
+}
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    auto size = size_t(st.st_size);
+    if (size == 0) {
+        close(fd);
+        return std::unique_ptr<MappedFile>(new MappedFile("", 0));
+    }
+    // the mapping keeps its own reference to the file
+    void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    return std::unique_ptr<MappedFile>(new MappedFile(static_cast<const char *>(data), size));
+}
+
+void MappedFile::Sequential() const {
+    if (_size > 0) {
+        madvise(const_cast<char *>(_data), _size, MADV_SEQUENTIAL);
+    }
+}
+
+void MappedFile::Release(size_t offset, size_t size) const {
+    if (offset < _size && size > 0) {
+        madvise(const_cast<char *>(_data) + offset, std::min(size, _size - offset), MADV_DONTNEED);
+    }
+}
+
+} // namespace common
@@ -156,10 +156,10 @@ bool operator>(char lhs, const rune_t &rhs) {
     return lhs > rhs._value;
 }
 bool operator<=(char lhs, const rune_t &rhs) {
-    return lhs < rhs._value;
+    return lhs <= rhs._value;
 }
 bool operator>=(char lhs, const rune_t &rhs) {
-    return lhs > rhs._value;
+    return lhs >= rhs._value;
 }
 
 ///////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,149 @@
+#include "compile/callgraph.hh"
+
+#include <algorithm>
+
+#include "syntax/ast/walk.hh"
+
+namespace compile {
+
+using types::ObjKind;
+using types::Object;
+
+namespace {
+
+ast::ExprNode *unparen(ast::ExprNode *e) {
+    while (auto p = dyn_cast_or_null<ast::ParenExpr>(e)) {
+        e = p->X.get();
+    }
+    return e;
+}
+
+} // namespace
+
+bool IsType(const types::Checker &check, ast::ExprNode *e) {
+    e = unparen(e);
+    if (e == nullptr) {
+        return false;
+    }
+    switch (e->Kind()) {
+    case ast::NodeKind::ArrayType:
+    case ast::NodeKind::SliceType:
+    case ast::NodeKind::DotsType:
+    case ast::NodeKind::StructType:
+    case ast::NodeKind::InterfaceType:
+    case ast::NodeKind::FuncType:
+    case ast::NodeKind::MapType:
+    case ast::NodeKind::ChanType:
+        return true;
+    case ast::NodeKind::Name: {
+        auto obj = check.ObjectOf(cast<ast::Name>(e));
+        return obj != nullptr && obj->Kind == ObjKind::TypeName;
+    }
+    case ast::NodeKind::SelectorExpr: {
+        auto obj = check.ObjectOf(cast<ast::SelectorExpr>(e)->Sel.get());
+        return obj != nullptr && obj->Kind == ObjKind::TypeName;
+    }
+    case ast::NodeKind::Operation: {
+        auto op = cast<ast::Operation>(e);
+        return op->Op == Operator_Mul && op->Y == nullptr && IsType(check, op->X.get());
+    }
+    default:
+        return false;
+    }
+}
+
+Object *StaticCallee(const types::Checker &check, const ast::CallExpr *call) {
+    auto fun = unparen(call->Fun.get());
+    Object *callee = nullptr;
+    if (auto name = dyn_cast<ast::Name>(fun)) {
+        callee = check.ObjectOf(name);
+    } else if (auto sel = dyn_cast<ast::SelectorExpr>(fun)) {
+        auto x = dyn_cast<ast::Name>(sel->X.get());
+        auto obj = x == nullptr ? nullptr : check.ObjectOf(x);
+        if (obj != nullptr && obj->Kind == ObjKind::PkgName) {
+            callee = check.ObjectOf(sel->Sel.get());
+        } else {
+            auto s = types::LookupFieldOrMethod(check, sel->X->typ, sel->Sel->Sym);
+            callee = s.kind == types::Selection::Method ? s.method : nullptr;
+        }
+    }
+    return callee != nullptr && callee->Kind == ObjKind::Func ? callee : nullptr;
+}
+
+CallGraph CallGraph::Build(const types::Checker &check, std::span<ast::File *const> files) {
+    CallGraph g;
+    for (auto file : files) {
+        for (auto &d : file->DeclList) {
+            if (auto f = dyn_cast<ast::FuncDecl>(d.get()); f && f->Body != nullptr) {
+                auto obj = check.ObjectOf(f->Name.get());
+                if (obj != nullptr) {
+                    g.Index.emplace(obj, g.Funcs.size());
+                }
+                g.Funcs.push_back(f);
+                g.Objects.push_back(obj);
+            }
+        }
+    }
+    g.Calls.resize(g.Funcs.size());
+    for (size_t i = 0; i < g.Funcs.size(); i++) {
+        ast::Inspect(g.Funcs[i]->Body.get(), [&](ast::Node *n) {
+            auto c = dyn_cast<ast::CallExpr>(n);
+            auto callee = c == nullptr ? nullptr : StaticCallee(check, c);
+            if (auto it = callee == nullptr ? g.Index.end() : g.Index.find(callee); it != g.Index.end()) {
+                g.Calls[i].push_back(it->second);
+            }
+            return true;
+        });
+    }
+    return g;
+}
+
+// Components runs Tarjan's algorithm, which yields the components callees
+// first.
+std::vector<std::vector<size_t>> CallGraph::Components() const {
+    std::vector<std::vector<size_t>> out;
+    std::vector<int> low(Funcs.size()), num(Funcs.size(), -1);
+    std::vector<bool> onStack(Funcs.size());
+    std::vector<size_t> stack;
+    int counter = 0;
+    auto visit = [&](auto &self, size_t v) -> void {
+        low[v] = num[v] = counter++;
+        stack.push_back(v);
+        onStack[v] = true;
+        for (auto w : Calls[v]) {
+            if (num[w] < 0) {
+                self(self, w);
+                low[v] = std::min(low[v], low[w]);
+            } else if (onStack[w]) {
+                low[v] = std::min(low[v], num[w]);
+            }
+        }
+        if (low[v] == num[v]) {
+            auto &c = out.emplace_back();
+            size_t w;
+            do {
+                w = stack.back();
+                stack.pop_back();
+                onStack[w] = false;
+                c.push_back(w);
+            } while (w != v);
+            std::sort(c.begin(), c.end());
+        }
+    };
+    for (size_t v = 0; v < Funcs.size(); v++) {
+        if (num[v] < 0) {
+            visit(visit, v);
+        }
+    }
+    return out;
+}
+
+bool CallGraph::Recursive(std::span<const size_t> component) const {
+    if (component.size() != 1) {
+        return true;
+    }
+    auto &calls = Calls[component[0]];
+    return std::find(calls.begin(), calls.end(), component[0]) != calls.end();
+}
+
+} // namespace compile
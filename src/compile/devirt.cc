@@ -0,0 +1,509 @@
+#include "compile/devirt.hh"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <charconv>
+#include <unordered_set>
+
+#include "compile/callgraph.hh"
+#include "syntax/ast/walk.hh"
+
+namespace compile {
+
+using types::ObjKind;
+using types::Object;
+using types::TypeId;
+using types::TypeTable;
+
+namespace {
+
+// The flow of an interface expression is None if no value flows into it,
+// Any if values of several or unknown dynamic types may, and otherwise
+// the one dynamic type of its values.
+constexpr TypeId None = 0;
+constexpr TypeId Any = ~TypeId(0);
+
+// MaxDepth bounds the nesting of the inlined calls whose results the flow
+// is computed through.
+constexpr int MaxDepth = 8;
+
+TypeId join(TypeId a, TypeId b) {
+    return a == None ? b : b == None || a == b ? a : Any;
+}
+
+bool exact(TypeId t) { return t != None && t != Any; }
+
+ast::ExprNode *unparen(ast::ExprNode *e) {
+    while (auto p = dyn_cast_or_null<ast::ParenExpr>(e)) {
+        e = p->X.get();
+    }
+    return e;
+}
+
+// exprList returns the expressions of a list, or the single expression e.
+std::vector<ast::ExprNode *> exprList(ast::ExprNode *e) {
+    std::vector<ast::ExprNode *> out;
+    if (auto l = dyn_cast_or_null<ast::ListExpr>(e)) {
+        for (auto &x : l->ElemList) {
+            out.push_back(x.get());
+        }
+    } else if (e != nullptr) {
+        out.push_back(e);
+    }
+    return out;
+}
+
+// assigned returns the variables the body of an inlined function assigns
+// or takes the address of: its parameters among them do not keep the flows
+// of their arguments.
+std::unordered_set<const Object *> assigned(const InlineBody &body) {
+    std::unordered_set<const Object *> out;
+    auto add = [&](ast::ExprNode *e) {
+        if (auto name = dyn_cast<ast::Name>(unparen(e))) {
+            out.insert(body.Check->ObjectOf(name));
+        }
+    };
+    ast::Inspect(body.Decl->Body.get(), [&](ast::Node *n) {
+        if (auto a = dyn_cast<ast::AssignStmt>(n)) {
+            for (auto lhs : exprList(a->Lhs.get())) {
+                add(lhs);
+            }
+        } else if (auto r = dyn_cast<ast::RangeClause>(n); r != nullptr && r->Lhs != nullptr && !r->Def) {
+            for (auto lhs : exprList(r->Lhs.get())) {
+                add(lhs);
+            }
+        } else if (auto op = dyn_cast<ast::Operation>(n); op != nullptr && op->Y == nullptr && op->Op == Operator_And) {
+            add(op->X.get());
+        }
+        return true;
+    });
+    return out;
+}
+
+// receiver returns the selector of the interface method call call,
+// checked by check, or nil if call is not one.
+ast::SelectorExpr *receiver(const types::Checker &check, const ast::CallExpr *call) {
+    auto sel = dyn_cast<ast::SelectorExpr>(unparen(call->Fun.get()));
+    if (sel == nullptr || sel->X->typ == 0 || !types::IsInterface(sel->X->typ) || IsType(check, sel->X.get())) {
+        return nullptr;
+    }
+    return sel;
+}
+
+// method returns the method name of the dynamic type t, declared by t
+// itself rather than promoted from an embedded field, or nil.
+Object *method(const types::Checker &check, TypeId t, common::SymbolId name) {
+    auto s = types::LookupFieldOrMethod(check, t, name);
+    if (s.kind != types::Selection::Method || s.method == nullptr || !s.index.empty()) {
+        return nullptr;
+    }
+    auto &table = TypeTable::Global();
+    if (s.method->PtrRecv && table.Kind(table.Underlying(t)) != KindPointer) {
+        return nullptr;
+    }
+    return s.method;
+}
+
+} // namespace
+
+// Flow is the type flow of a function, or of the body of a call the
+// inliner inlines: what is known of the dynamic types of its interface
+// variables.
+struct Devirtualizer::Flow {
+    const types::Checker &check;
+    Inliner *inliner;
+    std::unordered_map<const Object *, TypeId> vars; // the local variables of interface type
+    std::unordered_map<const Object *, TypeId> params; // of an inlined body: the flows of the arguments
+    int depth = 0;
+
+    // of returns the flow of the expression e.
+    TypeId of(ast::ExprNode *e) const {
+        e = unparen(e);
+        if (e == nullptr || e->typ == 0) {
+            return Any;
+        }
+        auto &table = TypeTable::Global();
+        if (!types::IsInterface(e->typ)) {
+            if (table.Kind(e->typ) == KindUntypedNil) {
+                return None; // a nil interface has no dynamic type
+            }
+            return types::IsUntyped(e->typ) ? types::DefaultType(e->typ) : e->typ;
+        }
+        if (auto name = dyn_cast<ast::Name>(e)) {
+            auto obj = check.ObjectOf(name);
+            if (auto it = params.find(obj); it != params.end()) {
+                return it->second;
+            }
+            auto it = vars.find(obj);
+            return it == vars.end() ? Any : it->second;
+        }
+        auto call = dyn_cast<ast::CallExpr>(e);
+        if (call == nullptr) {
+            return Any;
+        }
+        if (IsType(check, call->Fun.get())) {
+            return call->ArgList.size() == 1 ? of(call->ArgList[0].get()) : Any; // a conversion
+        }
+        auto plan = inliner == nullptr || depth >= MaxDepth ? nullptr : inliner->Inlined(call);
+        if (plan == nullptr || plan->Body->Result == nullptr) {
+            return Any; // the results of statements are not followed
+        }
+        return Flow{*plan->Body->Check, inliner, {}, bind(*plan), depth + 1}.of(plan->Body->Result);
+    }
+
+    // bind returns the flows of the arguments of the inlined call plan.
+    std::unordered_map<const Object *, TypeId> bind(const InlinedCall &plan) const {
+        std::unordered_map<const Object *, TypeId> out;
+        auto changed = assigned(*plan.Body);
+        for (size_t i = 0; i < plan.Args.size(); i++) {
+            if (auto p = plan.Body->Params[i]; p != nullptr && plan.Args[i] != nullptr && changed.count(p) == 0) {
+                out[p] = of(plan.Args[i]);
+            }
+        }
+        return out;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// CallProfile
+
+std::optional<CallProfile> CallProfile::Parse(std::string_view text, std::string &error) {
+    CallProfile p;
+    for (int line = 1; !text.empty(); line++) {
+        auto end = text.find('\n');
+        auto rest = text.substr(0, end);
+        text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+
+        std::vector<std::string_view> fields;
+        while (!rest.empty()) {
+            auto start = rest.find_first_not_of(" \t\r");
+            if (start == std::string_view::npos) {
+                break;
+            }
+            rest = rest.substr(start);
+            auto stop = std::min(rest.find_first_of(" \t\r"), rest.size());
+            fields.push_back(rest.substr(0, stop));
+            rest = rest.substr(stop);
+        }
+        if (fields.empty() || fields[0].starts_with("#")) {
+            continue;
+        }
+        int offset = 0;
+        uint64_t count = 0;
+        auto number = [](std::string_view s, auto &v) {
+            auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), v);
+            return ec == std::errc() && ptr == s.data() + s.size();
+        };
+        if (fields.size() != 4 || !number(fields[1], offset) || !number(fields[3], count)) {
+            error = fmt::format("line {}: want \"caller offset callee count\"", line);
+            return std::nullopt;
+        }
+        auto &edges = p._sites[fmt::format("{} {}", fields[0], offset)];
+        auto it = std::find_if(edges.begin(), edges.end(), [&](const Edge &e) { return e.Callee == fields[2]; });
+        if (it == edges.end()) {
+            edges.push_back({std::string(fields[2]), count});
+        } else {
+            it->Count += count;
+        }
+    }
+    for (auto &[_, edges] : p._sites) {
+        std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b) {
+            return a.Count != b.Count ? a.Count > b.Count : a.Callee < b.Callee;
+        });
+    }
+    return p;
+}
+
+std::span<const CallProfile::Edge> CallProfile::Callees(std::string_view caller, int offset) const {
+    auto it = _sites.find(fmt::format("{} {}", caller, offset));
+    return it == _sites.end() ? std::span<const Edge>() : std::span<const Edge>(it->second);
+}
+
+// ----------------------------------------------------------------------------
+// DevirtDecision
+
+std::string DevirtDecision::Message() const {
+    if (Guarded) {
+        return fmt::format("PGO devirtualizing interface call {} to {}", Call, Method);
+    }
+    return fmt::format("devirtualizing {} to {}", Call, Type);
+}
+
+// ----------------------------------------------------------------------------
+// Devirtualizer
+
+Devirtualizer::Devirtualizer(const types::Checker &check, std::string path, Inliner *inliner,
+                             const CallProfile *profile)
+    : _check(check), _path(std::move(path)), _inliner(inliner), _profile(profile) {}
+
+const std::vector<DevirtDecision> &Devirtualizer::Analyze(std::span<ast::File *const> files) {
+    for (auto file : files) {
+        for (auto &d : file->DeclList) {
+            if (auto decl = dyn_cast<ast::FuncDecl>(d.get()); decl != nullptr && decl->Body != nullptr) {
+                analyze(decl);
+            }
+        }
+    }
+    if (_inliner != nullptr) {
+        _inliner->InlineDirect(_direct);
+    }
+    std::stable_sort(_decisions.begin(), _decisions.end(),
+                     [](const DevirtDecision &a, const DevirtDecision &b) { return a.Pos < b.Pos; });
+    return _decisions;
+}
+
+// analyze computes the type flow of the function decl, which is
+// insensitive to the order of its statements, and devirtualizes its
+// calls, then those of the bodies inlined into it.
+void Devirtualizer::analyze(ast::FuncDecl *decl) {
+    Flow flow{_check, _inliner};
+    std::vector<std::pair<const Object *, ast::ExprNode *>> assigns;
+    std::unordered_set<const Object *> unknown;
+    std::vector<const ast::CallExpr *> calls;
+    std::unordered_set<const ast::CallExpr *> spawned;
+
+    auto declare = [&](ast::ExprNode *e) {
+        auto n = dyn_cast<ast::Name>(e);
+        auto obj = n == nullptr ? nullptr : _check.ObjectOf(n);
+        if (obj != nullptr && obj->Kind == ObjKind::Var && types::IsInterface(obj->Type)) {
+            flow.vars.emplace(obj, None);
+        }
+    };
+    auto assign = [&](std::span<ast::ExprNode *const> lhs, std::span<ast::ExprNode *const> rhs) {
+        for (size_t i = 0; i < lhs.size(); i++) {
+            auto n = dyn_cast<ast::Name>(lhs[i]);
+            auto obj = n == nullptr ? nullptr : _check.ObjectOf(n);
+            if (obj == nullptr || flow.vars.count(obj) == 0) {
+                continue;
+            }
+            if (lhs.size() == rhs.size()) {
+                assigns.emplace_back(obj, rhs[i]);
+            } else {
+                unknown.insert(obj); // the results of a call, or a comma-ok form
+            }
+        }
+    };
+    ast::Inspect(decl->Body.get(), [&](ast::Node *n) {
+        switch (n->Kind()) {
+        case ast::NodeKind::VarDecl: {
+            auto v = cast<ast::VarDecl>(n);
+            std::vector<ast::ExprNode *> names;
+            for (auto &name : v->NameList) {
+                declare(name.get());
+                names.push_back(name.get());
+            }
+            if (v->Values != nullptr) {
+                assign(names, exprList(v->Values.get()));
+            }
+            break;
+        }
+        case ast::NodeKind::AssignStmt: {
+            auto a = cast<ast::AssignStmt>(n);
+            if (a->Rhs == nullptr || (a->Op != 0 && a->Op != Operator_Def)) {
+                break; // x op= y and x++ compute numbers or strings
+            }
+            auto lhs = exprList(a->Lhs.get());
+            if (a->Op == Operator_Def) {
+                std::for_each(lhs.begin(), lhs.end(), declare);
+            }
+            assign(lhs, exprList(a->Rhs.get()));
+            break;
+        }
+        case ast::NodeKind::RangeClause: {
+            auto r = cast<ast::RangeClause>(n);
+            for (auto lhs : exprList(r->Lhs.get())) {
+                if (r->Def) {
+                    declare(lhs);
+                }
+                if (auto name = dyn_cast<ast::Name>(lhs)) {
+                    unknown.insert(_check.ObjectOf(name));
+                }
+            }
+            break;
+        }
+        case ast::NodeKind::Operation: {
+            // a variable whose address is taken may be assigned through it
+            auto op = cast<ast::Operation>(n);
+            if (auto name = op->Y == nullptr && op->Op == Operator_And ? dyn_cast<ast::Name>(unparen(op->X.get()))
+                                                                       : nullptr) {
+                unknown.insert(_check.ObjectOf(name));
+            }
+            break;
+        }
+        case ast::NodeKind::CallStmt:
+            spawned.insert(cast<ast::CallStmt>(n)->Call.get());
+            break;
+        case ast::NodeKind::CallExpr:
+            calls.push_back(cast<ast::CallExpr>(n));
+            break;
+        default:
+            break;
+        }
+        return true;
+    });
+    for (auto obj : unknown) {
+        if (auto it = flow.vars.find(obj); it != flow.vars.end()) {
+            it->second = Any;
+        }
+    }
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto [obj, rhs] : assigns) {
+            auto t = join(flow.vars[obj], flow.of(rhs));
+            if (auto &v = flow.vars[obj]; v != t) {
+                v = t;
+                changed = true;
+            }
+        }
+    }
+
+    for (auto call : calls) {
+        auto sel = receiver(_check, call);
+        if (sel == nullptr) {
+            continue;
+        }
+        auto t = flow.of(sel->X.get());
+        auto m = exact(t) ? method(_check, t, sel->Sel->Sym) : nullptr;
+        if (m != nullptr) {
+            add(_check, call, nullptr, {m, t}, spawned.count(call) != 0);
+        } else if (_profile != nullptr) {
+            guarded(decl, call);
+        }
+    }
+    if (_inliner == nullptr) {
+        return;
+    }
+    for (auto site : calls) {
+        auto plan = _inliner->Inlined(site);
+        if (plan == nullptr) {
+            continue;
+        }
+        auto &check = *plan->Body->Check;
+        Flow inlined{check, _inliner, {}, flow.bind(*plan), 1};
+        ast::Inspect(plan->Body->Decl->Body.get(), [&](ast::Node *n) {
+            auto call = dyn_cast<ast::CallExpr>(n);
+            auto sel = call == nullptr ? nullptr : receiver(check, call);
+            if (sel == nullptr || Devirtualized(call) != nullptr) {
+                return true;
+            }
+            auto t = inlined.of(sel->X.get());
+            if (auto m = exact(t) ? method(check, t, sel->Sel->Sym) : nullptr) {
+                add(check, call, site, {m, t}, true);
+            }
+            return true;
+        });
+    }
+}
+
+// guarded devirtualizes the interface call call of the function decl if
+// the profile shows a dominant dynamic type for it.
+void Devirtualizer::guarded(ast::FuncDecl *decl, const ast::CallExpr *call) {
+    auto &fs = syntax::FileSet::Global();
+    auto offset = fs.Resolve(call->pos).Line - fs.Resolve(decl->Name->pos).Line;
+    auto edges = _profile->Callees(funcName(decl), offset);
+    uint64_t total = 0;
+    for (auto &e : edges) {
+        total += e.Count;
+    }
+    if (edges.empty() || edges[0].Count == 0 || edges[0].Count * 100 < total * GuardedDevirtMinPercent) {
+        return;
+    }
+    auto sel = receiver(_check, call);
+    TypeId t = 0;
+    common::SymbolId name = 0;
+    if (!resolve(edges[0].Callee, t, name) || name != sel->Sel->Sym ||
+        types::MissingMethod(_check, t, sel->X->typ) != 0) {
+        return;
+    }
+    if (auto m = method(_check, t, name)) {
+        add(_check, call, nullptr, {m, t, true}, false);
+    }
+}
+
+// resolve resolves the method named callee in a profile to its receiver
+// type and name.
+bool Devirtualizer::resolve(std::string_view callee, TypeId &type, common::SymbolId &method) const {
+    auto dot = callee.rfind('.');
+    if (dot == std::string_view::npos) {
+        return false;
+    }
+    auto recv = callee.substr(0, dot);
+    std::string_view path, name;
+    bool ptr = recv.ends_with(")");
+    if (ptr) {
+        auto open = recv.rfind(".(*");
+        if (open == std::string_view::npos) {
+            return false;
+        }
+        path = recv.substr(0, open);
+        name = recv.substr(open + 3, recv.size() - open - 4);
+    } else if (auto d = recv.rfind('.'); d != std::string_view::npos) {
+        path = recv.substr(0, d);
+        name = recv.substr(d + 1);
+    } else {
+        return false;
+    }
+    auto &interner = common::Interner::Global();
+    Object *obj = nullptr;
+    if (path == _path) {
+        obj = _check.PackageScope().LookupLocal(interner.Intern(name));
+    } else if (auto importer = _check.GetImporter()) {
+        auto pkg = importer->Import(path);
+        obj = pkg == nullptr ? nullptr : pkg->Lookup(interner.Intern(name));
+    }
+    if (obj == nullptr || obj->Kind != ObjKind::TypeName) {
+        return false;
+    }
+    type = ptr ? TypeTable::Global().Pointer(obj->Type) : obj->Type;
+    method = interner.Intern(callee.substr(dot + 1));
+    return true;
+}
+
+// add records the devirtualized call call, in the body inlined at site if
+// set, and notes it for the inliner unless it is spawned by a go or defer
+// statement or inlined itself.
+void Devirtualizer::add(const types::Checker &check, const ast::CallExpr *call, const ast::CallExpr *site,
+                        DevirtCall d, bool spawned) {
+    auto sel = cast<ast::SelectorExpr>(unparen(call->Fun.get()));
+    auto t = typeName(check, d.Type);
+    auto name = common::Interner::Global().Name(sel->Sel->Sym);
+    auto m = t.starts_with("*") ? fmt::format("({}).{}", t, name) : fmt::format("{}.{}", t, name);
+    _decisions.push_back({(site != nullptr ? site : call)->pos,
+                          fmt::format("{}.{}", ast::String(sel->X.get()), name), t, m, d.Guarded});
+    _calls[{call, site}] = d;
+    if (site == nullptr && !spawned) {
+        _direct.push_back({call, d.Method, d.Type});
+    }
+}
+
+const DevirtCall *Devirtualizer::Devirtualized(const ast::CallExpr *call, const ast::CallExpr *site) const {
+    auto it = _calls.find({call, site});
+    return it == _calls.end() ? nullptr : &it->second;
+}
+
+// typeName returns how decisions name the dynamic type t: qualified by
+// the name of its package if it is imported.
+std::string Devirtualizer::typeName(const types::Checker &check, TypeId t) const {
+    auto &table = TypeTable::Global();
+    bool ptr = table.Kind(t) == KindPointer;
+    auto base = ptr ? table[t].Elem() : t;
+    auto s = table.String(base);
+    auto importer = check.GetImporter();
+    if (auto owner = importer == nullptr ? nullptr : importer->Owner(base)) {
+        s = fmt::format("{}.{}", owner->Name(), s);
+    }
+    return ptr ? "*" + s : s;
+}
+
+// funcName returns how profiles name the function decl.
+std::string Devirtualizer::funcName(ast::FuncDecl *decl) const {
+    auto &name = decl->Name->Value;
+    if (decl->Recv == nullptr) {
+        return fmt::format("{}.{}", _path, name);
+    }
+    auto t = ast::String(decl->Recv->Type.get());
+    return t.starts_with("*") ? fmt::format("{}.({}).{}", _path, t, name) : fmt::format("{}.{}.{}", _path, t, name);
+}
+
+} // namespace compile
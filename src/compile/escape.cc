@@ -0,0 +1,1543 @@
+#include "compile/escape.hh"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <deque>
+#include <optional>
+#include <unordered_set>
+
+#include "compile/callgraph.hh"
+#include "syntax/ast/walk.hh"
+
+namespace compile {
+
+using types::ObjKind;
+using types::Object;
+using types::TypeId;
+using types::TypeTable;
+using Location = EscapeAnalysis::Location;
+
+namespace {
+
+const types::Type &under(TypeId t) {
+    auto &table = TypeTable::Global();
+    return table[table.Underlying(t)];
+}
+
+uint8_t kindOf(TypeId t) { return t == 0 ? KindInvalid : under(t).Kind; }
+
+ast::ExprNode *unparen(ast::ExprNode *e) {
+    while (auto p = dyn_cast_or_null<ast::ParenExpr>(e)) {
+        e = p->X.get();
+    }
+    return e;
+}
+
+// exprList returns the expressions of a list, or the single expression e.
+std::vector<ast::ExprNode *> exprList(ast::ExprNode *e) {
+    std::vector<ast::ExprNode *> out;
+    if (auto l = dyn_cast_or_null<ast::ListExpr>(e)) {
+        for (auto &x : l->ElemList) {
+            out.push_back(x.get());
+        }
+    } else if (e != nullptr) {
+        out.push_back(e);
+    }
+    return out;
+}
+
+// pointerShaped reports whether a value of type t is stored in an
+// interface as is; other values are boxed in a new allocation.
+bool pointerShaped(TypeId t) {
+    auto &u = under(t);
+    switch (u.Kind) {
+    case KindPointer:
+    case KindUnsafePointer:
+    case KindMap:
+    case KindChan:
+    case KindFunc:
+        return true;
+    case KindStruct:
+        return u.Elems.size() == 1 && pointerShaped(u.Elems[0]);
+    case KindArray:
+        return u.Len == 1 && pointerShaped(u.Elem());
+    default:
+        return false;
+    }
+}
+
+// hasPointers reports whether values of type t contain pointers.
+bool hasPointers(TypeId t) {
+    auto &u = under(t);
+    switch (u.Kind) {
+    case KindArray:
+        return u.Len > 0 && hasPointers(u.Elem());
+    case KindStruct:
+        return std::any_of(u.Elems.begin(), u.Elems.end(), hasPointers);
+    case KindString:
+    case KindUntypedString:
+    case KindUnsafePointer:
+    case KindSlice:
+    case KindPointer:
+    case KindFunc:
+    case KindInterface:
+    case KindMap:
+    case KindChan:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::string position(syntax::Pos pos) {
+    auto p = syntax::FileSet::Global().Resolve(pos);
+    return fmt::format("{}:{}", p.Line, p.Col);
+}
+
+// hole is where the value of an expression being evaluated goes: a
+// location, with the dereferences the expression's context applies to the
+// value, or nowhere if dst is nil. why and pos label the flow for
+// explanations; addrtaken is set if the value is the address of a
+// variable, which the hole takes.
+struct hole {
+    Location *dst = nullptr;
+    int derefs = 0;
+    syntax::Pos pos{};
+    const char *why = "assign";
+    bool addrtaken = false;
+
+    hole shift(int d, const ast::Node *at, const char *w) const {
+        return dst == nullptr ? *this : hole{dst, derefs + d, at->pos, w, d < 0 || (d == 0 && addrtaken)};
+    }
+    hole deref(const ast::Node *at, const char *w) const { return shift(1, at, w); }
+    hole addr(const ast::Node *at, const char *w) const { return shift(-1, at, w); }
+    hole note(const ast::Node *at, const char *w) const { return shift(0, at, w); }
+};
+
+} // namespace
+
+struct EscapeAnalysis::Location {
+    enum Role : uint8_t {
+        Local,  // a local variable, or a temporary
+        Param,  // a parameter of a function of the batch
+        Result, // a result of a function of the batch
+        Heap,
+        Alloc, // an allocation site
+    };
+    struct Edge {
+        Location *src;
+        int derefs;
+        syntax::Pos pos;
+        const char *why;
+    };
+
+    Role role = Local;
+    std::string name;
+    const ast::Node *site = nullptr;
+    const Object *var = nullptr;
+    int fn = 0; // the function or closure declaring it
+    int loopDepth = 0;
+    int func = -1;  // for a parameter or result, its function in the batch
+    int index = -1; // and its index, the receiver first
+    bool escapes = false;
+    // for a variable, whether a closure captures it, whether its address
+    // is taken and whether it is assigned other than by its declaration
+    bool captured = false;
+    bool addrtaken = false;
+    bool reassigned = false;
+    const char *reason = nullptr; // why it is on the heap whatever flows to it
+    std::vector<Edge> edges;      // the flows into the location
+    std::vector<std::string> explain;
+
+    // state of the walk from the current root
+    uint32_t walkgen = 0;
+    int derefs = 0;
+    Location *dst = nullptr; // the location the shortest path continues to
+    size_t dstEdge = 0;
+    bool queued = false;
+};
+
+// Batch analyzes the functions of one strongly connected component of the
+// call graph together.
+struct EscapeAnalysis::Batch {
+    struct Func {
+        ast::FuncDecl *decl;
+        const Object *obj;
+        std::vector<Location *> params, results;
+    };
+    // Scope is a function or closure body; closures are nested in the
+    // scope they appear in.
+    struct Scope {
+        int parent = -1;
+        Location *closure = nullptr; // the closure's allocation; nil for a function
+        TypeId sig = 0;
+        std::vector<Location *> params;  // nil for unnamed and blank parameters
+        std::vector<Location *> results; // for a function
+        // the variables of enclosing functions the closure refers to, and
+        // where it first does
+        std::vector<std::pair<Location *, syntax::Pos>> captures;
+        std::unordered_set<const Location *> captured;
+    };
+
+    Batch(EscapeAnalysis &ea, bool explain) : ea(ea), check(ea._check), explain(explain) {
+        heap = &locs.emplace_back();
+        heap->role = Location::Heap;
+        heap->name = "{heap}";
+        heap->escapes = true;
+    }
+
+    EscapeAnalysis &ea;
+    const types::Checker &check;
+    bool explain;
+    std::deque<Location> locs;
+    Location *heap;
+    std::vector<Func> funcs;
+    std::unordered_map<const Object *, int> index; // function -> its index in funcs
+    std::vector<Scope> scopes;
+    std::unordered_map<const Object *, Location *> vars;
+    int scope = -1;
+    int loopDepth = 0;
+    std::unordered_set<common::SymbolId> looping; // labels targeted by a backward goto
+    uint32_t walkgen = 0;
+
+    // locations and flows
+
+    hole heapHole(const ast::Node *at, const char *why) const { return hole{heap, 0, at->pos, why}; }
+    static hole discard() { return {}; }
+    static hole to(Location *l, const ast::Node *at, const char *why) { return hole{l, 0, at->pos, why}; }
+
+    Location *newLoc(Location::Role role, std::string name, const ast::Node *site) {
+        auto l = &locs.emplace_back();
+        l->role = role;
+        l->name = std::move(name);
+        l->site = site;
+        l->fn = scope;
+        l->loopDepth = loopDepth;
+        return l;
+    }
+
+    Location *newVar(const ast::Name *name, Location::Role role = Location::Local) {
+        auto obj = name == nullptr ? nullptr : check.ObjectOf(name);
+        if (obj == nullptr || name->Value == "_") {
+            return nullptr;
+        }
+        return newVar(obj, name, role);
+    }
+
+    Location *newVar(const Object *obj, const ast::Node *site, Location::Role role = Location::Local) {
+        auto l = newLoc(role, std::string(common::Interner::Global().Name(obj->Name)), site);
+        l->var = obj;
+        if (types::Sizeof(obj->Type) > MaxStackVarSize) {
+            l->escapes = true;
+            l->reason = "too large for stack";
+        }
+        vars[obj] = l;
+        return l;
+    }
+
+    Location *newAlloc(const ast::Node *site, std::string what, int64_t size) {
+        auto l = newLoc(Location::Alloc, std::move(what), site);
+        if (size > MaxImplicitStackVarSize) {
+            l->escapes = true;
+            l->reason = "too large for stack";
+        }
+        return l;
+    }
+
+    // flow records that the value of src, dereferenced as k says, flows to
+    // the location of k.
+    void flow(const hole &k, Location *src) {
+        if (k.dst == nullptr || src == nullptr || (k.dst == src && k.derefs >= 0)) {
+            return;
+        }
+        if (k.addrtaken) {
+            src->addrtaken = true;
+        }
+        k.dst->edges.push_back({src, k.derefs, k.pos, k.why});
+    }
+
+    // tee returns a hole whose value flows to each of ks.
+    hole tee(std::span<const hole> ks, const ast::Node *at) {
+        auto t = newLoc(Location::Local, "{temp}", at);
+        for (auto &k : ks) {
+            flow(k, t);
+        }
+        return to(t, at, "assign");
+    }
+
+    // varLoc returns the location of the local variable obj, making the
+    // enclosing closures up to its declaration capture it; package-level
+    // and unknown variables are the heap.
+    Location *varLoc(const Object *obj, const ast::Node *at) {
+        auto it = vars.find(obj);
+        if (it == vars.end()) {
+            return heap;
+        }
+        auto l = it->second;
+        for (int s = scope; s >= 0 && s != l->fn; s = scopes[s].parent) {
+            auto &sc = scopes[s];
+            if (sc.closure == nullptr || !sc.captured.insert(l).second) {
+                continue;
+            }
+            sc.captures.emplace_back(l, at->pos);
+            if (sc.parent == l->fn && !l->captured) {
+                l->captured = true;
+                // assignments in straight-line code before the first
+                // capture do not keep it from capturing the value
+                if (sc.closure->loopDepth == l->loopDepth) {
+                    l->reassigned = false;
+                }
+            }
+        }
+        return l;
+    }
+
+    // reassign marks the variables of ks as assigned.
+    static void reassign(std::span<const hole> ks) {
+        for (auto &k : ks) {
+            if (k.dst != nullptr) {
+                k.dst->reassigned = true;
+            }
+        }
+    }
+
+    // captures flows the variables the closures capture to the closures,
+    // once all assignments to them are known: the value of those a closure
+    // can copy, the address of the others.
+    void captures() {
+        for (auto &sc : scopes) {
+            for (auto [l, pos] : sc.captures) {
+                bool byValue = !l->addrtaken && !l->reassigned && l->var != nullptr &&
+                               types::Sizeof(l->var->Type) <= 128;
+                flow(hole{sc.closure, byValue ? 0 : -1, pos, byValue ? "captured by value" : "captured by a closure"},
+                     l);
+            }
+        }
+    }
+
+    // type information
+
+    bool isType(ast::ExprNode *e) const { return IsType(check, e); }
+
+    // packageName reports whether e names an imported package.
+    bool packageName(ast::ExprNode *e) const {
+        auto n = dyn_cast<ast::Name>(e);
+        auto obj = n == nullptr ? nullptr : check.ObjectOf(n);
+        return obj != nullptr && obj->Kind == ObjKind::PkgName;
+    }
+
+    // constant returns the value of e if it is a constant expression.
+    std::optional<types::Value> constant(ast::ExprNode *e) const {
+        e = unparen(e);
+        if (auto b = dyn_cast_or_null<ast::BasicLit>(e)) {
+            return types::Value::MakeFromLiteral(b->Value, b->Kind);
+        }
+        const ast::Name *name = dyn_cast_or_null<ast::Name>(e);
+        if (auto s = dyn_cast_or_null<ast::SelectorExpr>(e); s && packageName(s->X.get())) {
+            name = s->Sel.get();
+        }
+        if (name != nullptr) {
+            auto obj = check.ObjectOf(name);
+            if (obj != nullptr && obj->Kind == ObjKind::Const) {
+                return obj->Val;
+            }
+            return std::nullopt;
+        }
+        if (auto op = dyn_cast_or_null<ast::Operation>(e)) {
+            auto x = constant(op->X.get());
+            if (!x) {
+                return std::nullopt;
+            }
+            if (op->Y == nullptr) {
+                return op->Op == Operator_Recv ? std::nullopt : std::optional(types::UnaryOp(op->Op, *x, 0));
+            }
+            auto y = constant(op->Y.get());
+            if (!y || op->Op == Operator_Shl || op->Op == Operator_Shr || (op->Op >= Operator_OrOr && op->Op <= Operator_Geq)) {
+                return std::nullopt;
+            }
+            return types::BinaryOp(*x, op->Op, *y);
+        }
+        return std::nullopt;
+    }
+
+    // expressions
+
+    // expr evaluates e, whose value flows to k.
+    void expr(const hole &k, ast::ExprNode *e) {
+        if (e == nullptr) {
+            return;
+        }
+        if (k.dst != nullptr && k.derefs >= 0 && e->typ != 0 && !types::IsUntyped(e->typ) && !hasPointers(e->typ)) {
+            // a value without pointers refers to nothing
+            expr(discard(), e);
+            return;
+        }
+        switch (e->Kind()) {
+        case ast::NodeKind::Name: {
+            auto obj = check.ObjectOf(cast<ast::Name>(e));
+            if (obj != nullptr && obj->Kind == ObjKind::Var) {
+                flow(k, varLoc(obj, e));
+            }
+            return;
+        }
+        case ast::NodeKind::ParenExpr:
+            expr(k, cast<ast::ParenExpr>(e)->X.get());
+            return;
+        case ast::NodeKind::CompositeLit:
+            compositeLit(k, cast<ast::CompositeLit>(e), e->typ);
+            return;
+        case ast::NodeKind::FuncLit:
+            closure(k, cast<ast::FuncLit>(e));
+            return;
+        case ast::NodeKind::SelectorExpr:
+            selector(k, cast<ast::SelectorExpr>(e));
+            return;
+        case ast::NodeKind::IndexExpr: {
+            auto x = cast<ast::IndexExpr>(e);
+            switch (kindOf(x->X->typ)) {
+            case KindArray:
+                expr(k, x->X.get());
+                break;
+            case KindString:
+                expr(discard(), x->X.get());
+                break;
+            case KindMap:
+                expr(k.deref(e, "map index"), x->X.get());
+                break;
+            default: // slices and pointers to arrays
+                expr(k.deref(e, "index"), x->X.get());
+                break;
+            }
+            expr(discard(), x->Index.get());
+            return;
+        }
+        case ast::NodeKind::SliceExpr: {
+            auto x = cast<ast::SliceExpr>(e);
+            if (kindOf(x->X->typ) == KindArray) {
+                expr(k.addr(e, "slice of an array"), x->X.get());
+            } else {
+                expr(k.note(e, "slice"), x->X.get());
+            }
+            for (auto &i : x->Index) {
+                expr(discard(), i.get());
+            }
+            return;
+        }
+        case ast::NodeKind::AssertExpr: {
+            auto x = cast<ast::AssertExpr>(e);
+            // a value of a type that is not pointer-shaped is copied out of its box
+            bool copied = !types::IsInterface(e->typ) && !pointerShaped(e->typ);
+            expr(copied ? k.deref(e, "type assertion") : k.note(e, "type assertion"), x->X.get());
+            return;
+        }
+        case ast::NodeKind::Operation: {
+            auto op = cast<ast::Operation>(e);
+            if (op->Y == nullptr && op->Op == Operator_And) {
+                addressOf(k, op);
+            } else if (op->Y == nullptr && op->Op == Operator_Mul) {
+                expr(k.deref(e, "indirection"), op->X.get());
+            } else {
+                expr(discard(), op->X.get());
+                expr(discard(), op->Y.get());
+            }
+            return;
+        }
+        case ast::NodeKind::CallExpr: {
+            hole ks[] = {k};
+            call(ks, cast<ast::CallExpr>(e));
+            return;
+        }
+        case ast::NodeKind::KeyValueExpr:
+            expr(discard(), cast<ast::KeyValueExpr>(e)->Key.get());
+            expr(k, cast<ast::KeyValueExpr>(e)->Value.get());
+            return;
+        case ast::NodeKind::ListExpr:
+            for (auto &x : cast<ast::ListExpr>(e)->ElemList) {
+                expr(k, x.get());
+            }
+            return;
+        default: // literals and types
+            return;
+        }
+    }
+
+    // value evaluates e, which is assigned to a variable of type t, boxing
+    // it if t is an interface.
+    void value(const hole &k, TypeId t, ast::ExprNode *e) {
+        if (t == 0 || !types::IsInterface(t)) {
+            expr(k, e);
+        } else {
+            toInterface(k, e);
+        }
+    }
+
+    void toInterface(const hole &k, ast::ExprNode *e) {
+        if (e == nullptr) {
+            return;
+        }
+        auto from = e->typ;
+        if (from == 0 || types::IsInterface(from) || from == KindUntypedNil) {
+            expr(k, e);
+            return;
+        }
+        if (pointerShaped(from)) {
+            expr(k.note(e, "interface conversion"), e);
+        } else if (constant(e) || types::Sizeof(from) == 0) {
+            expr(discard(), e); // constants and zero-sized values need no box
+        } else {
+            auto box = newAlloc(e, ast::String(e), types::Sizeof(from));
+            flow(k.addr(e, "interface conversion"), box);
+            expr(to(box, e, "boxed"), e);
+        }
+    }
+
+    void addressOf(const hole &k, ast::Operation *op) {
+        auto x = unparen(op->X.get());
+        if (auto lit = dyn_cast<ast::CompositeLit>(x)) {
+            auto a = newAlloc(op, fmt::format("&{}{{...}}", lit->Type ? ast::String(lit->Type.get()) : ""),
+                              types::Sizeof(lit->typ));
+            flow(k.addr(op, "address-of"), a);
+            compositeLit(to(a, lit, "literal element"), lit, lit->typ);
+            return;
+        }
+        expr(k.addr(op, "address-of"), x);
+    }
+
+    // compositeLit evaluates the literal e of type t.
+    void compositeLit(const hole &k, ast::CompositeLit *e, TypeId t) {
+        auto &table = TypeTable::Global();
+        if (kindOf(t) == KindPointer) {
+            // an elided &T{...} in a []*T literal
+            auto elem = under(t).Elem();
+            auto a = newAlloc(e, fmt::format("&{}{{...}}", table.String(elem)), types::Sizeof(elem));
+            flow(k.addr(e, "address-of"), a);
+            compositeLit(to(a, e, "literal element"), e, elem);
+            return;
+        }
+        auto &u = under(t);
+        auto elems = [&](const hole &h, TypeId elem) {
+            for (auto &el : e->ElemList) {
+                if (auto kv = dyn_cast<ast::KeyValueExpr>(el.get())) {
+                    expr(discard(), kv->Key.get());
+                    valueOrLit(h, elem, kv->Value.get());
+                } else {
+                    valueOrLit(h, elem, el.get());
+                }
+            }
+        };
+        switch (u.Kind) {
+        case KindStruct:
+            for (size_t i = 0; i < e->ElemList.size(); i++) {
+                auto el = e->ElemList[i].get();
+                auto field = i < u.Elems.size() ? u.Elems[i] : 0;
+                if (auto kv = dyn_cast<ast::KeyValueExpr>(el)) {
+                    field = kv->Key->typ;
+                    el = kv->Value.get();
+                }
+                valueOrLit(k.note(el, "struct literal element"), field, el);
+            }
+            return;
+        case KindArray:
+            elems(k.note(e, "array literal element"), u.Elem());
+            return;
+        case KindSlice: {
+            int64_t n = e->Packed != nullptr ? int64_t(e->Packed->Len()) : int64_t(e->ElemList.size());
+            auto a = newAlloc(e, fmt::format("{}{{...}}", table.String(t)), n * types::Sizeof(u.Elem()));
+            flow(k.addr(e, "slice literal"), a);
+            elems(to(a, e, "slice literal element"), u.Elem());
+            return;
+        }
+        case KindMap: {
+            auto a = newAlloc(e, fmt::format("{}{{...}}", table.String(t)), 0);
+            flow(k.addr(e, "map literal"), a);
+            for (auto &el : e->ElemList) {
+                if (auto kv = dyn_cast<ast::KeyValueExpr>(el.get())) {
+                    valueOrLit(heapHole(kv, "map literal key"), u.Key(), kv->Key.get());
+                    valueOrLit(heapHole(kv, "map literal value"), u.Elem(), kv->Value.get());
+                }
+            }
+            return;
+        }
+        default:
+            for (auto &el : e->ElemList) {
+                expr(discard(), el.get());
+            }
+            return;
+        }
+    }
+
+    // valueOrLit evaluates an element of a composite literal, which may be a
+    // literal with an elided type.
+    void valueOrLit(const hole &k, TypeId t, ast::ExprNode *e) {
+        if (auto lit = dyn_cast_or_null<ast::CompositeLit>(e); lit && lit->Type == nullptr) {
+            compositeLit(k, lit, t);
+        } else {
+            value(k, t, e);
+        }
+    }
+
+    void selector(const hole &k, ast::SelectorExpr *e) {
+        if (packageName(e->X.get())) {
+            return; // a package-level object of another package
+        }
+        if (isType(e->X.get())) {
+            return; // a method expression
+        }
+        auto s = types::LookupFieldOrMethod(check, e->X->typ, e->Sel->Sym);
+        switch (s.kind) {
+        case types::Selection::Field:
+            expr(s.indirect ? k.deref(e, "field of a pointer") : k.note(e, "field"), e->X.get());
+            return;
+        case types::Selection::Method:
+            // a method value closes over its receiver
+            expr(heapHole(e, "method value"), e->X.get());
+            return;
+        default:
+            expr(heapHole(e, "unknown selector"), e->X.get());
+            return;
+        }
+    }
+
+    // closure evaluates the function literal e, whose closure flows to k,
+    // and returns its scope.
+    int closure(const hole &k, ast::FuncLit *e) {
+        auto c = newAlloc(e, "func literal", 0);
+        flow(k.addr(e, "closure"), c);
+
+        int outer = scope;
+        int depth = loopDepth;
+        scope = int(scopes.size());
+        auto &sc = scopes.emplace_back();
+        sc.parent = outer;
+        sc.closure = c;
+        sc.sig = e->typ;
+        loopDepth = 0;
+        for (auto &f : e->Type->ParamList) {
+            auto l = newVar(f->Name.get());
+            scopes[scope].params.push_back(l);
+        }
+        for (auto &f : e->Type->ResultList) {
+            // what a closure returns is lost to its callers
+            flow(heapHole(e, "closure result"), newVar(f->Name.get()));
+        }
+        block(e->Body.get());
+        int self = scope;
+        scope = outer;
+        loopDepth = depth;
+        return self;
+    }
+
+    // call evaluates the call e, whose results flow to ks; with spawned, the
+    // call runs after the statement, as in a go statement or a deferred call
+    // in a loop, so its function and arguments flow to the heap.
+    void call(std::span<const hole> ks, ast::CallExpr *e, bool spawned = false) {
+        auto result = [&](size_t i) { return i < ks.size() ? ks[i] : discard(); };
+        auto fun = unparen(e->Fun.get());
+        auto args = e->ArgList;
+
+        if (isType(fun)) {
+            conversion(result(0), e);
+            return;
+        }
+        if (auto n = dyn_cast<ast::Name>(fun)) {
+            if (auto obj = check.ObjectOf(n); obj != nullptr && obj->Kind == ObjKind::Builtin) {
+                builtin(result(0), e, obj->Builtin);
+                return;
+            }
+        }
+
+        // the callee: a function of the package, a method, a literal or unknown
+        const Object *callee = nullptr;
+        ast::ExprNode *recv = nullptr;
+        int recvDerefs = 0;
+        int scopeOfLit = -1;
+        TypeId sig = fun->typ;
+        size_t first = 0; // the parameter of the first argument
+        if (auto n = dyn_cast<ast::Name>(fun)) {
+            if (auto obj = check.ObjectOf(n); obj != nullptr && obj->Kind == ObjKind::Func) {
+                callee = obj;
+            } else {
+                expr(spawned ? heapHole(e, "go function") : discard(), fun);
+            }
+        } else if (auto sel = dyn_cast<ast::SelectorExpr>(fun)) {
+            if (packageName(sel->X.get())) {
+                callee = check.ObjectOf(sel->Sel.get());
+            } else if (isType(sel->X.get())) {
+                // a method expression T.m: the receiver is the first argument
+                auto s = types::LookupFieldOrMethod(check, sel->X->typ, sel->Sel->Sym);
+                callee = s.method;
+            } else {
+                auto s = types::LookupFieldOrMethod(check, sel->X->typ, sel->Sel->Sym);
+                if (s.kind == types::Selection::Method) {
+                    callee = s.method;
+                    recv = sel->X.get();
+                    first = 1;
+                    recvDerefs = s.indirect ? 1 : 0;
+                    if (s.method != nullptr && s.method->PtrRecv) {
+                        recvDerefs--;
+                    }
+                    if (s.method == nullptr) {
+                        recvDerefs = 0; // an interface method gets the interface value
+                    }
+                } else {
+                    expr(spawned ? heapHole(e, "go function") : discard(), fun);
+                }
+            }
+        } else if (auto lit = dyn_cast<ast::FuncLit>(fun)) {
+            scopeOfLit = closure(spawned ? heapHole(e, "go function") : discard(), lit);
+        } else {
+            expr(spawned ? heapHole(e, "go function") : discard(), fun);
+        }
+        if (callee != nullptr && callee->Kind != ObjKind::Func) {
+            callee = nullptr;
+        }
+        if (callee != nullptr && first == 1) {
+            sig = callee->Type;
+        }
+
+        // where the parameters flow
+        const Func *f = nullptr;
+        const std::vector<ParamLeaks> *leaks = nullptr;
+        if (callee != nullptr && !spawned) {
+            if (auto it = index.find(callee); it != index.end()) {
+                f = &funcs[it->second];
+            } else {
+                leaks = ea.summary(callee);
+            }
+        }
+        std::vector<hole> params;
+        auto param = [&](size_t i, const ast::Node *at) -> hole {
+            if (spawned) {
+                return heapHole(at, "go argument");
+            }
+            if (scopeOfLit >= 0) {
+                auto &ps = scopes[scopeOfLit].params;
+                return i < ps.size() ? to(ps[i], at, "call argument") : discard();
+            }
+            if (f != nullptr) {
+                return i < f->params.size() ? to(f->params[i], at, "call argument") : discard();
+            }
+            if (leaks == nullptr || i >= leaks->size()) {
+                return heapHole(at, "call argument to an unknown function");
+            }
+            auto &p = (*leaks)[i];
+            std::vector<hole> dsts;
+            if (p.Heap >= 0) {
+                dsts.push_back(heapHole(at, "call argument").shift(p.Heap, at, "leaking parameter"));
+            }
+            for (size_t r = 0; r < p.Results.size(); r++) {
+                if (p.Results[r] >= 0 && result(r).dst != nullptr) {
+                    dsts.push_back(result(r).shift(p.Results[r], at, "parameter returned"));
+                }
+            }
+            if (dsts.empty()) {
+                return discard();
+            }
+            return dsts.size() == 1 ? dsts[0] : tee(dsts, at);
+        };
+
+        if (recv != nullptr) {
+            expr(param(0, recv).shift(recvDerefs, recv, "receiver"), recv);
+        }
+        auto sigType = kindOf(sig) == KindFunc ? &under(sig) : nullptr;
+        auto nparams = sigType != nullptr ? sigType->Params().size() : 0;
+        if (sigType != nullptr && args.size() == 1 && args[0]->typ == 0 && nparams > 1) {
+            // f(g()) with g returning several values
+            std::vector<hole> holes;
+            for (size_t i = 0; i < nparams; i++) {
+                holes.push_back(param(first + i, args[0].get()));
+            }
+            if (auto c = dyn_cast<ast::CallExpr>(unparen(args[0].get()))) {
+                call(holes, c);
+            }
+        } else {
+            Location *dots = nullptr;
+            for (size_t i = 0; i < args.size(); i++) {
+                auto arg = args[i].get();
+                if (sigType == nullptr) {
+                    expr(param(first + i, arg), arg);
+                } else if (sigType->Variadic && !e->HasDots && i + 1 >= nparams) {
+                    // the arguments of a variadic parameter are stored in an implicit slice
+                    auto elem = under(sigType->Params().back()).Elem();
+                    if (dots == nullptr) {
+                        dots = newAlloc(e, "... argument", int64_t(args.size() - i) * types::Sizeof(elem));
+                        flow(param(first + nparams - 1, arg).addr(arg, "... argument"), dots);
+                    }
+                    value(to(dots, arg, "... argument element"), elem, arg);
+                } else {
+                    auto t = i < nparams ? sigType->Params()[i] : 0;
+                    value(param(first + i, arg), t, arg);
+                }
+            }
+        }
+
+        // where the results flow
+        if (f != nullptr) {
+            for (size_t r = 0; r < f->results.size() && r < ks.size(); r++) {
+                flow(ks[r].note(e, "call result"), f->results[r]);
+            }
+        }
+    }
+
+    void conversion(const hole &k, ast::CallExpr *e) {
+        if (e->ArgList.size() != 1) {
+            return;
+        }
+        auto arg = e->ArgList[0].get();
+        auto t = e->typ, from = arg->typ;
+        auto toKind = kindOf(t), fromKind = kindOf(from);
+        if (types::IsInterface(t)) {
+            toInterface(k, arg);
+        } else if ((toKind == KindSlice && types::IsString(from)) || (toKind == KindString && fromKind == KindSlice)) {
+            // []byte(s), []rune(s) and string(b) copy into a new allocation
+            auto a = newAlloc(e, ast::String(e), 0);
+            flow(k.addr(e, "conversion"), a);
+            expr(discard(), arg);
+        } else {
+            expr(k.note(e, "conversion"), arg);
+        }
+    }
+
+    void builtin(const hole &k, ast::CallExpr *e, types::BuiltinId id) {
+        auto &args = e->ArgList;
+        switch (id) {
+        case types::BuiltinId::Append: {
+            if (args.empty()) {
+                return;
+            }
+            auto elem = kindOf(args[0]->typ) == KindSlice ? under(args[0]->typ).Elem() : 0;
+            // the appendee may be returned as is, or copied to the heap
+            hole ks[] = {k, heapHole(e, "appendee slice").deref(e, "appendee slice")};
+            expr(elem != 0 && hasPointers(elem) ? tee(ks, e) : k, args[0].get());
+            for (size_t i = 1; i < args.size(); i++) {
+                if (e->HasDots) {
+                    expr(heapHole(e, "appended slice...").deref(e, "appended slice..."), args[i].get());
+                } else {
+                    value(heapHole(args[i].get(), "appended to slice"), elem, args[i].get());
+                }
+            }
+            return;
+        }
+        case types::BuiltinId::New: {
+            auto t = kindOf(e->typ) == KindPointer ? under(e->typ).Elem() : 0;
+            auto a = newAlloc(e, ast::String(e), types::Sizeof(t));
+            flow(k.addr(e, "new"), a);
+            return;
+        }
+        case types::BuiltinId::Make: {
+            auto t = args.empty() ? 0 : args[0]->typ;
+            for (size_t i = 1; i < args.size(); i++) {
+                expr(discard(), args[i].get());
+            }
+            switch (kindOf(t)) {
+            case KindSlice: {
+                auto a = newAlloc(e, ast::String(e), 0);
+                int64_t n = 0;
+                for (size_t i = 1; i < args.size() && a->reason == nullptr; i++) {
+                    auto v = constant(args[i].get());
+                    auto len = v ? v->ToInt().Int64Val() : std::nullopt;
+                    if (!len) {
+                        a->escapes = true;
+                        a->reason = "non-constant size";
+                    } else {
+                        n = std::max(n, *len);
+                    }
+                }
+                if (a->reason == nullptr && n * types::Sizeof(under(t).Elem()) > MaxImplicitStackVarSize) {
+                    a->escapes = true;
+                    a->reason = "too large for stack";
+                }
+                flow(k.addr(e, "make"), a);
+                return;
+            }
+            case KindMap:
+                flow(k.addr(e, "make"), newAlloc(e, ast::String(e), 0));
+                return;
+            default: // channels are always on the heap
+                return;
+            }
+        }
+        case types::BuiltinId::Panic:
+            for (auto &a : args) {
+                toInterface(heapHole(e, "panic"), a.get());
+            }
+            return;
+        case types::BuiltinId::Min:
+        case types::BuiltinId::Max:
+            for (auto &a : args) {
+                expr(k, a.get());
+            }
+            return;
+        case types::BuiltinId::Print:
+        case types::BuiltinId::Println:
+            // the arguments are printed as they are, without boxing
+        default:
+            for (auto &a : args) {
+                expr(discard(), a.get());
+            }
+            return;
+        }
+    }
+
+    // statements
+
+    void block(ast::BlockStmt *b) {
+        if (b == nullptr) {
+            return;
+        }
+        for (auto &s : b->List) {
+            stmt(s.get());
+        }
+    }
+
+    void stmts(std::span<const ast::StmtNodePtr> list) {
+        for (auto &s : list) {
+            stmt(s.get());
+        }
+    }
+
+    // assignHole returns the hole of the location lhs, whose value is
+    // replaced: a local variable, a part of one, or anything reached
+    // through a pointer, which is the heap.
+    hole assignHole(ast::ExprNode *lhs, const ast::Node *at) {
+        lhs = unparen(lhs);
+        switch (lhs->Kind()) {
+        case ast::NodeKind::Name: {
+            auto n = cast<ast::Name>(lhs);
+            auto obj = check.ObjectOf(n);
+            if (n->Value == "_" || obj == nullptr) {
+                return discard();
+            }
+            return to(varLoc(obj, lhs), at, "assign");
+        }
+        case ast::NodeKind::SelectorExpr: {
+            auto s = cast<ast::SelectorExpr>(lhs);
+            if (packageName(s->X.get())) {
+                return heapHole(at, "assign to a global");
+            }
+            auto sel = types::LookupFieldOrMethod(check, s->X->typ, s->Sel->Sym);
+            if (sel.kind == types::Selection::Field && !sel.indirect) {
+                return assignHole(s->X.get(), at);
+            }
+            expr(discard(), s->X.get());
+            return heapHole(at, "assign through a pointer");
+        }
+        case ast::NodeKind::IndexExpr: {
+            auto x = cast<ast::IndexExpr>(lhs);
+            switch (kindOf(x->X->typ)) {
+            case KindArray:
+                expr(discard(), x->Index.get());
+                return assignHole(x->X.get(), at);
+            case KindMap: {
+                expr(discard(), x->X.get());
+                value(heapHole(at, "key of map put"), under(x->X->typ).Key(), x->Index.get());
+                return heapHole(at, "map put");
+            }
+            default:
+                expr(discard(), x->X.get());
+                expr(discard(), x->Index.get());
+                return heapHole(at, "assign to a slice element");
+            }
+        }
+        default:
+            expr(discard(), lhs);
+            return heapHole(at, "assign through a pointer");
+        }
+    }
+
+    // selfAssign reports whether lhs = rhs reslices a slice reached through
+    // a pointer variable into itself, as in b.buf = b.buf[i:j]: that
+    // stores no pointer the destination did not hold. Slicing an array
+    // held by value would store a pointer to it.
+    bool selfAssign(ast::ExprNode *lhs, ast::ExprNode *rhs) const {
+        auto slice = dyn_cast<ast::SliceExpr>(unparen(rhs));
+        if (slice == nullptr || kindOf(slice->X->typ) == KindArray) {
+            return false;
+        }
+        auto base = [&](ast::ExprNode *e) -> const Object * {
+            ast::ExprNode *x = nullptr;
+            e = unparen(e);
+            if (auto op = dyn_cast<ast::Operation>(e); op && op->Op == Operator_Mul && op->Y == nullptr) {
+                x = op->X.get();
+            } else if (auto s = dyn_cast<ast::SelectorExpr>(e); s && kindOf(s->X->typ) == KindPointer) {
+                x = s->X.get();
+            }
+            auto n = dyn_cast_or_null<ast::Name>(unparen(x));
+            auto obj = n == nullptr ? nullptr : check.ObjectOf(n);
+            return obj != nullptr && obj->Kind == ObjKind::Var ? obj : nullptr;
+        };
+        auto obj = base(lhs);
+        return obj != nullptr && obj == base(slice->X.get());
+    }
+
+    // typeOf returns the type of the destination lhs.
+    TypeId typeOf(ast::ExprNode *lhs) const {
+        if (auto n = dyn_cast<ast::Name>(unparen(lhs))) {
+            auto obj = check.ObjectOf(n);
+            return obj != nullptr ? obj->Type : n->typ;
+        }
+        return lhs->typ;
+    }
+
+    // assign evaluates rhs into the holes ks of destinations of types ts.
+    void assign(std::span<const hole> ks, std::span<const TypeId> ts, const std::vector<ast::ExprNode *> &rhs) {
+        if (rhs.size() == 1 && ks.size() > 1) {
+            auto x = unparen(rhs[0]);
+            if (auto c = dyn_cast<ast::CallExpr>(x)) {
+                // interface results of a call are boxed by the callee
+                call(ks, c);
+            } else {
+                // v, ok = m[k], x.(T) or <-ch
+                value(ks[0], ts[0], x);
+            }
+            return;
+        }
+        for (size_t i = 0; i < rhs.size(); i++) {
+            if (i < ks.size()) {
+                value(ks[i], ts[i], rhs[i]);
+            } else {
+                expr(discard(), rhs[i]);
+            }
+        }
+    }
+
+    void stmt(ast::StmtNode *s) {
+        if (s == nullptr) {
+            return;
+        }
+        switch (s->Kind()) {
+        case ast::NodeKind::LabeledStmt: {
+            auto l = cast<ast::LabeledStmt>(s);
+            if (looping.count(l->Label->Sym)) {
+                loopDepth++; // the target of a backward goto starts a loop
+            }
+            stmt(l->Stmt.get());
+            return;
+        }
+        case ast::NodeKind::BlockStmt:
+            block(cast<ast::BlockStmt>(s));
+            return;
+        case ast::NodeKind::ExprStmt: {
+            auto x = unparen(cast<ast::ExprStmt>(s)->X.get());
+            if (auto c = dyn_cast<ast::CallExpr>(x)) {
+                call({}, c);
+            } else {
+                expr(discard(), x);
+            }
+            return;
+        }
+        case ast::NodeKind::SendStmt: {
+            auto x = cast<ast::SendStmt>(s);
+            expr(discard(), x->Chan.get());
+            auto elem = kindOf(x->Chan->typ) == KindChan ? under(x->Chan->typ).Elem() : 0;
+            value(heapHole(s, "send"), elem, x->Value.get());
+            return;
+        }
+        case ast::NodeKind::DeclStmt:
+            for (auto &d : cast<ast::DeclStmt>(s)->DeclList) {
+                auto v = dyn_cast<ast::VarDecl>(d.get());
+                if (v == nullptr) {
+                    continue;
+                }
+                std::vector<hole> ks;
+                std::vector<TypeId> ts;
+                for (auto &n : v->NameList) {
+                    auto l = newVar(n.get());
+                    ks.push_back(l == nullptr ? discard() : to(l, n.get(), "assign"));
+                    ts.push_back(typeOf(n.get()));
+                }
+                assign(ks, ts, exprList(v->Values.get()));
+            }
+            return;
+        case ast::NodeKind::AssignStmt: {
+            auto a = cast<ast::AssignStmt>(s);
+            if (a->Rhs == nullptr || (a->Op != 0 && a->Op != Operator_Def)) {
+                // x op= y and x++ compute numbers or strings
+                hole ks[] = {assignHole(a->Lhs.get(), s)};
+                expr(discard(), a->Rhs.get());
+                reassign(ks);
+                return;
+            }
+            std::vector<hole> ks;
+            std::vector<TypeId> ts;
+            std::vector<hole> reassigned;
+            for (auto lhs : exprList(a->Lhs.get())) {
+                auto n = dyn_cast<ast::Name>(lhs);
+                auto obj = n == nullptr ? nullptr : check.ObjectOf(n);
+                if (a->Op == Operator_Def && obj != nullptr && !vars.count(obj) && n->Value != "_") {
+                    ks.push_back(to(newVar(obj, n), s, "assign"));
+                } else {
+                    ks.push_back(assignHole(lhs, s));
+                    reassigned.push_back(ks.back());
+                }
+                ts.push_back(typeOf(lhs));
+            }
+            auto rhs = exprList(a->Rhs.get());
+            if (ks.size() == 1 && rhs.size() == 1 && selfAssign(a->Lhs.get(), rhs[0])) {
+                // b.buf = b.buf[i:j] stores no pointer b.buf did not hold
+                ks[0] = discard();
+            }
+            assign(ks, ts, rhs);
+            reassign(reassigned);
+            return;
+        }
+        case ast::NodeKind::CallStmt: {
+            auto c = cast<ast::CallStmt>(s);
+            // a call deferred outside loops runs before the function returns
+            call({}, c->Call.get(), c->Tok == Token_Go || loopDepth > 0);
+            return;
+        }
+        case ast::NodeKind::ReturnStmt:
+            returnStmt(cast<ast::ReturnStmt>(s));
+            return;
+        case ast::NodeKind::IfStmt: {
+            auto x = cast<ast::IfStmt>(s);
+            stmt(x->Init.get());
+            expr(discard(), x->Cond.get());
+            block(x->Then.get());
+            stmt(x->Else.get());
+            return;
+        }
+        case ast::NodeKind::ForStmt:
+            forStmt(cast<ast::ForStmt>(s));
+            return;
+        case ast::NodeKind::SwitchStmt:
+            switchStmt(cast<ast::SwitchStmt>(s));
+            return;
+        case ast::NodeKind::SelectStmt:
+            for (auto &c : cast<ast::SelectStmt>(s)->Body) {
+                stmt(c->Comm.get());
+                stmts(c->Body);
+            }
+            return;
+        default: // empty and branch statements
+            return;
+        }
+    }
+
+    void returnStmt(ast::ReturnStmt *s) {
+        auto results = exprList(s->Results.get());
+        if (results.empty()) {
+            return;
+        }
+        auto &sc = scopes[scope];
+        auto sig = kindOf(sc.sig) == KindFunc ? &under(sc.sig) : nullptr;
+        std::vector<hole> ks;
+        std::vector<TypeId> ts;
+        size_t n = sig != nullptr ? sig->Results().size() : results.size();
+        for (size_t i = 0; i < n; i++) {
+            if (sc.closure != nullptr) {
+                ks.push_back(heapHole(s, "return from a closure"));
+            } else {
+                ks.push_back(i < sc.results.size() ? to(sc.results[i], s, "return") : discard());
+            }
+            ts.push_back(sig != nullptr ? sig->Results()[i] : 0);
+        }
+        assign(ks, ts, results);
+        reassign(ks);
+    }
+
+    void forStmt(ast::ForStmt *s) {
+        if (auto r = dyn_cast_or_null<ast::RangeClause>(s->Init.get())) {
+            auto lhs = exprList(r->Lhs.get());
+            // the range expression is evaluated once, before the loop
+            std::vector<hole> ks, vars;
+            auto xt = r->X->typ;
+            auto kind = kindOf(xt);
+            if (kind == KindPointer) {
+                kind = kindOf(under(xt).Elem());
+            }
+            loopDepth++;
+            for (size_t i = 0; i < lhs.size(); i++) {
+                hole k;
+                auto n = dyn_cast<ast::Name>(lhs[i]);
+                if (r->Def && n != nullptr) {
+                    auto l = newVar(n);
+                    k = l == nullptr ? discard() : to(l, r, "range");
+                } else {
+                    loopDepth--;
+                    k = assignHole(lhs[i], r);
+                    loopDepth++;
+                }
+                vars.push_back(k);
+                // the key of a map and the elements are copied out of what x refers to
+                bool elem = i == 1 || kind == KindChan || (kind == KindMap && i == 0);
+                if (elem && (kind == KindSlice || kind == KindMap || kind == KindChan || kindOf(xt) == KindPointer)) {
+                    ks.push_back(k.deref(r, "range"));
+                } else if (elem && kind == KindArray) {
+                    ks.push_back(k.note(r, "range"));
+                }
+            }
+            loopDepth--;
+            expr(ks.empty() ? discard() : ks.size() == 1 ? ks[0] : tee(ks, r), r->X.get());
+            loopDepth++;
+            block(s->Body.get());
+            // the variables are assigned again after each iteration
+            reassign(vars);
+            loopDepth--;
+            return;
+        }
+        // the variables of the init statement are per iteration
+        loopDepth++;
+        stmt(s->Init.get());
+        expr(discard(), s->Cond.get());
+        block(s->Body.get());
+        stmt(s->Post.get());
+        loopDepth--;
+    }
+
+    void switchStmt(ast::SwitchStmt *s) {
+        stmt(s->Init.get());
+        if (auto g = dyn_cast_or_null<ast::TypeSwitchGuard>(s->Tag.get())) {
+            std::vector<hole> ks;
+            for (auto &c : s->Body) {
+                auto obj = check.Implicit(c.get());
+                if (obj == nullptr) {
+                    continue;
+                }
+                auto l = newVar(obj, g->Lhs.get());
+                // a value that is not pointer-shaped is copied out of its box
+                bool copied = !types::IsInterface(obj->Type) && !pointerShaped(obj->Type);
+                ks.push_back(copied ? to(l, c.get(), "switch case").deref(c.get(), "switch case")
+                                    : to(l, c.get(), "switch case"));
+            }
+            expr(ks.empty() ? discard() : ks.size() == 1 ? ks[0] : tee(ks, g), g->X.get());
+        } else {
+            expr(discard(), s->Tag.get());
+        }
+        for (auto &c : s->Body) {
+            if (!isa_and_nonnull<ast::TypeSwitchGuard>(s->Tag.get())) {
+                for (auto x : exprList(c->Cases.get())) {
+                    expr(discard(), x);
+                }
+            }
+            stmts(c->Body);
+        }
+    }
+
+    // functions
+
+    // declare creates the locations of the parameters and results of the
+    // functions of the batch, before any body is walked, so that calls
+    // between them connect.
+    void declare() {
+        for (size_t i = 0; i < funcs.size(); i++) {
+            auto &f = funcs[i];
+            scope = int(scopes.size());
+            auto &sc = scopes.emplace_back();
+            sc.sig = f.obj != nullptr ? f.obj->Type : 0;
+            auto param = [&](ast::Field *field) {
+                auto l = newVar(field->Name.get(), Location::Param);
+                if (l == nullptr) {
+                    l = newLoc(Location::Param, "_", field);
+                }
+                l->func = int(i);
+                l->index = int(f.params.size());
+                f.params.push_back(l);
+            };
+            if (f.decl->Recv != nullptr) {
+                param(f.decl->Recv.get());
+            }
+            for (auto &p : f.decl->Type->ParamList) {
+                param(p.get());
+            }
+            for (auto &r : f.decl->Type->ResultList) {
+                auto l = newVar(r->Name.get(), Location::Result);
+                if (l == nullptr) {
+                    l = newLoc(Location::Result, fmt::format("~r{}", f.results.size()), r.get());
+                }
+                l->func = int(i);
+                l->index = int(f.results.size());
+                f.results.push_back(l);
+            }
+            sc.params = f.params;
+            sc.results = f.results;
+        }
+        scope = -1;
+    }
+
+    void body(size_t i) {
+        auto &f = funcs[i];
+        scope = int(i); // the scope of a function is its index
+        loopDepth = 0;
+        looping.clear();
+        std::unordered_set<common::SymbolId> seen;
+        ast::Inspect(f.decl->Body.get(), [&](ast::Node *n) {
+            if (auto l = dyn_cast<ast::LabeledStmt>(n)) {
+                seen.insert(l->Label->Sym);
+            } else if (auto b = dyn_cast<ast::BranchStmt>(n); b && b->Tok == Token_Goto && b->Label) {
+                if (seen.count(b->Label->Sym)) {
+                    looping.insert(b->Label->Sym);
+                }
+            }
+            return true;
+        });
+        block(f.decl->Body.get());
+        scope = -1;
+    }
+
+    // solving
+
+    // outlives reports whether root outlives l: whatever flows to root
+    // from l must be as long-lived as root.
+    bool outlives(const Location *root, const Location *l) const {
+        if (root->escapes || root->role == Location::Result) {
+            return true; // callers may keep results anywhere
+        }
+        if (root->fn == l->fn && root->loopDepth < l->loopDepth) {
+            return true;
+        }
+        // l is allocated by a closure of root's function
+        for (int s = l->fn; s >= 0; s = scopes[s].parent) {
+            if (s == root->fn) {
+                return s != l->fn;
+            }
+        }
+        return false;
+    }
+
+    void leakTo(Location *param, const Location *root, int derefs) {
+        auto &leaks = ea._leaks[funcs[param->func].obj];
+        auto &p = leaks[param->index];
+        if (!root->escapes && root->role == Location::Result && root->func == param->func) {
+            auto &r = p.Results[root->index];
+            r = r < 0 ? derefs : std::min(r, derefs);
+        } else {
+            p.Heap = p.Heap < 0 ? derefs : std::min(p.Heap, derefs);
+        }
+    }
+
+    // explainFlow records the path from l to root, which l escapes to.
+    void explainFlow(Location *l, const Location *root) {
+        for (auto n = l; n != root && n->dst != nullptr; n = n->dst) {
+            auto &e = n->dst->edges[n->dstEdge];
+            auto prefix = e.derefs < 0 ? std::string("&") : std::string(size_t(e.derefs), '*');
+            l->explain.push_back(
+                fmt::format("flow: {} = {}{}: {} at {}", n->dst->name, prefix, n->name, e.why, position(e.pos)));
+        }
+        if (root->role == Location::Result) {
+            l->explain.push_back(fmt::format("{} is a result", root->name));
+        } else if (root != heap && root->escapes) {
+            l->explain.push_back(fmt::format("{} escapes to heap", root->name));
+        } else if (root != heap && root->fn == l->fn) {
+            l->explain.push_back(fmt::format("{} is declared outside the loop", root->name));
+        } else if (root != heap) {
+            l->explain.push_back(fmt::format("{} is declared outside the closure", root->name));
+        }
+    }
+
+    // walkOne finds the locations whose values flow to root, with the least
+    // number of dereferences, and marks those whose address flows to a
+    // root that outlives them as escaping.
+    void walkOne(Location *root, std::deque<Location *> &todo) {
+        walkgen++;
+        root->walkgen = walkgen;
+        root->derefs = 0;
+        root->dst = nullptr;
+        std::deque<Location *> queue{root};
+        while (!queue.empty()) {
+            auto l = queue.front();
+            queue.pop_front();
+            int derefs = l->derefs;
+            bool addressOf = derefs < 0;
+            if (addressOf) {
+                derefs = 0;
+            }
+            if (outlives(root, l)) {
+                if (l->role == Location::Param && l->func >= 0) {
+                    leakTo(l, root, derefs);
+                }
+                if (addressOf && !l->escapes) {
+                    l->escapes = true;
+                    if (explain) {
+                        explainFlow(l, root);
+                    }
+                    if (!l->queued) {
+                        l->queued = true;
+                        todo.push_back(l);
+                    }
+                    continue;
+                }
+            }
+            for (size_t i = 0; i < l->edges.size(); i++) {
+                auto &e = l->edges[i];
+                if (e.src->escapes) {
+                    continue;
+                }
+                int d = derefs + e.derefs;
+                if (e.src->walkgen != walkgen || e.src->derefs > d) {
+                    e.src->walkgen = walkgen;
+                    e.src->derefs = d;
+                    e.src->dst = l;
+                    e.src->dstEdge = i;
+                    queue.push_back(e.src);
+                }
+            }
+        }
+    }
+
+    void solve() {
+        for (auto &f : funcs) {
+            auto &leaks = ea._leaks[f.obj];
+            leaks.assign(f.params.size(), ParamLeaks{});
+            for (auto &p : leaks) {
+                p.Results.assign(f.results.size(), -1);
+            }
+        }
+        std::deque<Location *> todo;
+        for (auto &l : locs) {
+            l.queued = true;
+            todo.push_back(&l);
+        }
+        while (!todo.empty()) {
+            auto root = todo.front();
+            todo.pop_front();
+            root->queued = false;
+            walkOne(root, todo);
+        }
+    }
+
+    void report(std::vector<EscapeDecision> &out) {
+        for (auto &l : locs) {
+            if (l.reason != nullptr && explain && l.explain.empty()) {
+                l.explain.push_back(l.reason);
+            }
+            if (l.role == Location::Alloc) {
+                ea._sites[l.site] = l.escapes;
+                out.push_back({EscapeDecision::Alloc, l.site->pos, l.site, l.name, l.escapes, {}, l.explain});
+            } else if (l.var != nullptr) {
+                ea._vars[l.var] = l.escapes;
+                if (l.escapes) {
+                    out.push_back({EscapeDecision::Var, l.site->pos, l.site, l.name, true, {}, l.explain});
+                }
+            }
+        }
+        for (auto &f : funcs) {
+            auto &leaks = ea._leaks[f.obj];
+            for (size_t i = 0; i < f.params.size(); i++) {
+                auto p = f.params[i];
+                if (p->var == nullptr || !hasPointers(p->var->Type)) {
+                    continue;
+                }
+                EscapeDecision d{EscapeDecision::Param, p->site->pos, p->site, p->name, leaks[i].Leaks()};
+                if (leaks[i].Heap > 0) {
+                    d.Leak = "content";
+                } else if (leaks[i].Heap < 0) {
+                    for (size_t r = 0; r < leaks[i].Results.size(); r++) {
+                        if (leaks[i].Results[r] >= 0) {
+                            d.Leak = fmt::format("to result {} level={}", f.results[r]->name, leaks[i].Results[r]);
+                            break;
+                        }
+                    }
+                }
+                out.push_back(std::move(d));
+            }
+        }
+    }
+};
+
+// ----------------------------------------------------------------------------
+// EscapeDecision
+
+std::string EscapeDecision::Message() const {
+    switch (kind) {
+    case Var:
+        return fmt::format("moved to heap: {}", What);
+    case Param:
+        if (!Heap) {
+            return fmt::format("{} does not escape", What);
+        }
+        if (Leak == "content") {
+            return fmt::format("leaking param content: {}", What);
+        }
+        return Leak.empty() ? fmt::format("leaking param: {}", What) : fmt::format("leaking param: {} {}", What, Leak);
+    default:
+        return Heap ? fmt::format("{} escapes to heap", What) : fmt::format("{} does not escape", What);
+    }
+}
+
+bool ParamLeaks::Leaks() const {
+    return Heap >= 0 || std::any_of(Results.begin(), Results.end(), [](int r) { return r >= 0; });
+}
+
+// ----------------------------------------------------------------------------
+// EscapeAnalysis
+
+EscapeAnalysis::~EscapeAnalysis() = default;
+
+std::vector<EscapeDecision> EscapeAnalysis::Analyze(std::span<ast::File *const> files, bool explain) {
+    auto graph = CallGraph::Build(_check, files);
+    std::vector<EscapeDecision> out;
+    for (auto &b : graph.Components()) {
+        Batch batch(*this, explain);
+        for (auto i : b) {
+            auto obj = graph.Objects[i];
+            if (obj != nullptr) {
+                batch.index.emplace(obj, int(batch.funcs.size()));
+            }
+            batch.funcs.push_back({graph.Funcs[i], obj, {}, {}});
+        }
+        batch.declare();
+        for (size_t i = 0; i < batch.funcs.size(); i++) {
+            batch.body(i);
+        }
+        batch.captures();
+        batch.solve();
+        batch.report(out);
+    }
+    std::stable_sort(out.begin(), out.end(), [](const EscapeDecision &a, const EscapeDecision &b) {
+        return a.Pos < b.Pos;
+    });
+    return out;
+}
+
+bool EscapeAnalysis::OnHeap(const ast::Node *site) const {
+    auto it = _sites.find(site);
+    return it == _sites.end() || it->second;
+}
+
+bool EscapeAnalysis::Moved(const Object *var) const {
+    auto it = _vars.find(var);
+    return it == _vars.end() || it->second;
+}
+
+const std::vector<ParamLeaks> *EscapeAnalysis::Leaks(const Object *fn) const {
+    auto it = _leaks.find(fn);
+    return it == _leaks.end() ? nullptr : &it->second;
+}
+
+types::LeakSummaries EscapeAnalysis::Exports() const {
+    types::LeakSummaries out;
+    for (auto &[fn, leaks] : _leaks) {
+        if (fn == nullptr || fn->Imported != nullptr) {
+            continue;
+        }
+        auto &flat = out[fn];
+        for (auto &p : leaks) {
+            flat.push_back(p.Heap);
+            flat.insert(flat.end(), p.Results.begin(), p.Results.end());
+        }
+    }
+    return out;
+}
+
+const std::vector<ParamLeaks> *EscapeAnalysis::summary(const Object *fn) {
+    if (auto leaks = Leaks(fn); leaks != nullptr || fn->Leaks.empty() || kindOf(fn->Type) != KindFunc) {
+        return leaks;
+    }
+    // for each parameter, the heap and then each result
+    size_t stride = 1 + under(fn->Type).Results().size();
+    if (fn->Leaks.size() % stride != 0) {
+        return nullptr;
+    }
+    auto &leaks = _leaks[fn];
+    for (size_t i = 0; i < fn->Leaks.size(); i += stride) {
+        auto &p = leaks.emplace_back();
+        p.Heap = fn->Leaks[i];
+        p.Results.assign(fn->Leaks.begin() + i + 1, fn->Leaks.begin() + i + stride);
+    }
+    return &leaks;
+}
+
+} // namespace compile
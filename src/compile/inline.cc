@@ -0,0 +1,621 @@
+#include "compile/inline.hh"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <unordered_set>
+
+#include "compile/callgraph.hh"
+#include "syntax/ast/walk.hh"
+#include "syntax/operator_string.hh"
+#include "syntax/parser.hh"
+
+namespace compile {
+
+using types::ObjKind;
+using types::Object;
+using types::TypeId;
+using types::TypeTable;
+
+namespace {
+
+ast::ExprNode *unparen(ast::ExprNode *e) {
+    while (auto p = dyn_cast_or_null<ast::ParenExpr>(e)) {
+        e = p->X.get();
+    }
+    return e;
+}
+
+// single returns the expression returned by the body of f if the body is
+// a single return statement of one value, or nil.
+ast::ExprNode *single(ast::FuncDecl *f) {
+    if (f->Body == nullptr || f->Body->List.size() != 1 || f->Type->ResultList.size() != 1) {
+        return nullptr;
+    }
+    auto ret = dyn_cast<ast::ReturnStmt>(f->Body->List[0].get());
+    if (ret == nullptr || ret->Results == nullptr || isa<ast::ListExpr>(ret->Results.get())) {
+        return nullptr;
+    }
+    return ret->Results.get();
+}
+
+// shape returns why the statements of a body cannot be expanded, or the
+// empty string: assignments, expression and send statements, variable
+// declarations, if statements, blocks, loops, the breaks and continues of
+// loops and returns can, switches cannot. loop is set in the body of a
+// loop.
+std::string shape(const std::vector<ast::StmtNodePtr> &list, bool loop = false) {
+    for (auto &s : list) {
+        std::string reason;
+        switch (s->Kind()) {
+        case ast::NodeKind::EmptyStmt:
+        case ast::NodeKind::ExprStmt:
+        case ast::NodeKind::SendStmt:
+        case ast::NodeKind::AssignStmt:
+        case ast::NodeKind::ReturnStmt:
+            break;
+        case ast::NodeKind::BlockStmt:
+            reason = shape(cast<ast::BlockStmt>(s.get())->List, loop);
+            break;
+        case ast::NodeKind::IfStmt: {
+            auto x = cast<ast::IfStmt>(s.get());
+            reason = shape(x->Then->List, loop);
+            if (reason.empty() && x->Else != nullptr) {
+                reason = shape({x->Else}, loop);
+            }
+            break;
+        }
+        case ast::NodeKind::DeclStmt:
+            for (auto &d : cast<ast::DeclStmt>(s.get())->DeclList) {
+                if (isa<ast::ConstDecl>(d.get())) {
+                    reason = "unhandled op DCLCONST";
+                } else if (isa<ast::TypeDecl>(d.get())) {
+                    reason = "unhandled op DCLTYPE";
+                }
+            }
+            break;
+        case ast::NodeKind::ForStmt:
+            reason = shape(cast<ast::ForStmt>(s.get())->Body->List, true);
+            break;
+        case ast::NodeKind::SwitchStmt:
+            reason = isa_and_nonnull<ast::TypeSwitchGuard>(cast<ast::SwitchStmt>(s.get())->Tag.get())
+                         ? "unhandled op TYPESW"
+                         : "unhandled op SWITCH";
+            break;
+        default: {
+            // neither labels nor switches are inlined, so a break or
+            // continue is of the innermost loop
+            auto x = dyn_cast<ast::BranchStmt>(s.get());
+            if (!loop || x == nullptr || (x->Tok != Token_Break && x->Tok != Token_Continue)) {
+                reason = "unhandled op BREAK";
+            }
+            break;
+        }
+        }
+        if (!reason.empty()) {
+            return reason;
+        }
+    }
+    return "";
+}
+
+// simple formats an assignment, expression or send statement.
+std::string simple(ast::SimpleStmtNode *s) {
+    if (auto x = dyn_cast<ast::ExprStmt>(s)) {
+        return ast::String(x->X.get());
+    }
+    if (auto x = dyn_cast<ast::SendStmt>(s)) {
+        return fmt::format("{} <- {}", ast::String(x->Chan.get()), ast::String(x->Value.get()));
+    }
+    auto x = cast<ast::AssignStmt>(s);
+    auto lhs = ast::String(x->Lhs.get());
+    if (x->Rhs == nullptr) {
+        return lhs + (x->Op == Operator_Add ? "++" : "--");
+    }
+    auto op = x->Op == 0 ? std::string("") : syntax::OperatorString(x->Op);
+    return fmt::format("{} {}= {}", lhs, op, ast::String(x->Rhs.get()));
+}
+
+// format writes the statements of a body that shape accepts as Go source,
+// each on a line indented by depth tabs.
+void format(std::string &out, const std::vector<ast::StmtNodePtr> &list, int depth) {
+    std::string indent(depth, '\t');
+    for (auto &s : list) {
+        switch (s->Kind()) {
+        case ast::NodeKind::EmptyStmt:
+            break;
+        case ast::NodeKind::BlockStmt:
+            out += indent + "{\n";
+            format(out, cast<ast::BlockStmt>(s.get())->List, depth + 1);
+            out += indent + "}\n";
+            break;
+        case ast::NodeKind::ReturnStmt: {
+            auto x = cast<ast::ReturnStmt>(s.get());
+            out += indent + (x->Results == nullptr ? "return\n" : "return " + ast::String(x->Results.get()) + "\n");
+            break;
+        }
+        case ast::NodeKind::IfStmt: {
+            out += indent;
+            for (auto x = cast<ast::IfStmt>(s.get()); x != nullptr;) {
+                out += "if ";
+                if (x->Init != nullptr) {
+                    out += simple(x->Init.get()) + "; ";
+                }
+                out += ast::String(x->Cond.get()) + " {\n";
+                format(out, x->Then->List, depth + 1);
+                out += indent + "}";
+                auto next = dyn_cast_or_null<ast::IfStmt>(x->Else.get());
+                if (next != nullptr) {
+                    out += " else ";
+                } else if (x->Else != nullptr) {
+                    out += " else {\n";
+                    format(out, cast<ast::BlockStmt>(x->Else.get())->List, depth + 1);
+                    out += indent + "}";
+                }
+                x = next;
+            }
+            out += "\n";
+            break;
+        }
+        case ast::NodeKind::ForStmt: {
+            auto x = cast<ast::ForStmt>(s.get());
+            out += indent + "for ";
+            if (auto r = dyn_cast_or_null<ast::RangeClause>(x->Init.get())) {
+                if (r->Lhs != nullptr) {
+                    out += ast::String(r->Lhs.get()) + (r->Def ? " := " : " = ");
+                }
+                out += "range " + ast::String(r->X.get()) + " ";
+            } else if (x->Init != nullptr || x->Post != nullptr) {
+                out += x->Init == nullptr ? ";" : simple(x->Init.get()) + ";";
+                out += x->Cond == nullptr ? ";" : " " + ast::String(x->Cond.get()) + ";";
+                out += x->Post == nullptr ? " " : " " + simple(x->Post.get()) + " ";
+            } else if (x->Cond != nullptr) {
+                out += ast::String(x->Cond.get()) + " ";
+            }
+            out += "{\n";
+            format(out, x->Body->List, depth + 1);
+            out += indent + "}\n";
+            break;
+        }
+        case ast::NodeKind::BranchStmt:
+            out += indent + (cast<ast::BranchStmt>(s.get())->Tok == Token_Break ? "break\n" : "continue\n");
+            break;
+        case ast::NodeKind::DeclStmt:
+            for (auto &d : cast<ast::DeclStmt>(s.get())->DeclList) {
+                auto v = cast<ast::VarDecl>(d.get());
+                std::string names;
+                for (auto &n : v->NameList) {
+                    names += fmt::format("{}{}", names.empty() ? "" : ", ", n->Value);
+                }
+                out += indent + "var " + names;
+                if (v->Type != nullptr) {
+                    out += " " + ast::String(v->Type.get());
+                }
+                if (v->Values != nullptr) {
+                    out += " = " + ast::String(v->Values.get());
+                }
+                out += "\n";
+            }
+            break;
+        default:
+            out += indent + simple(cast<ast::SimpleStmtNode>(s.get())) + "\n";
+            break;
+        }
+    }
+}
+
+bool variadic(ast::FuncDecl *f) {
+    auto &params = f->Type->ParamList;
+    return !params.empty() && isa<ast::DotsType>(params.back()->Type.get());
+}
+
+// builtin returns the built-in function call calls, or nil.
+const Object *builtin(const types::Checker &check, const ast::CallExpr *call) {
+    auto name = dyn_cast<ast::Name>(unparen(call->Fun.get()));
+    auto obj = name == nullptr ? nullptr : check.ObjectOf(name);
+    return obj != nullptr && obj->Kind == ObjKind::Builtin ? obj : nullptr;
+}
+
+bool packageName(const types::Checker &check, ast::ExprNode *e) {
+    auto n = dyn_cast<ast::Name>(e);
+    auto obj = n == nullptr ? nullptr : check.ObjectOf(n);
+    return obj != nullptr && obj->Kind == ObjKind::PkgName;
+}
+
+// arguments appends the arguments of c to those of call, which holds the
+// receiver of a method call, and packs those of a variadic parameter. It
+// returns false if they are the results of a call.
+bool arguments(InlinedCall &call, const ast::CallExpr *c) {
+    for (auto &a : c->ArgList) {
+        if (a->typ == 0) {
+            return false; // several values
+        }
+        call.Args.push_back(a.get());
+    }
+    auto n = call.Body->Params.size();
+    if (call.Body->Variadic && !c->HasDots && call.Args.size() >= n - 1) {
+        call.Packed.assign(call.Args.begin() + std::ptrdiff_t(n - 1), call.Args.end());
+        call.Args.resize(n - 1);
+        call.Args.push_back(nullptr);
+    }
+    return call.Args.size() == n;
+}
+
+Object *param(const types::Checker &check, const ast::Field *f) {
+    return f->Name == nullptr || f->Name->Value == "_" ? nullptr : check.ObjectOf(f->Name.get());
+}
+
+// body returns the inlinable body of decl, checked by check, with the
+// given cost.
+std::unique_ptr<InlineBody> body(const types::Checker &check, ast::FuncDecl *decl, int cost) {
+    auto b = std::make_unique<InlineBody>();
+    b->Cost = cost;
+    b->Check = &check;
+    b->Decl = decl;
+    b->Result = single(decl);
+    b->Variadic = variadic(decl);
+    if (decl->Recv != nullptr) {
+        b->Params.push_back(param(check, decl->Recv.get()));
+    }
+    for (auto &p : decl->Type->ParamList) {
+        b->Params.push_back(param(check, p.get()));
+    }
+    for (auto &r : decl->Type->ResultList) {
+        b->Results.push_back(param(check, r.get()));
+    }
+    return b;
+}
+
+} // namespace
+
+// Func is a function whose cost is being computed.
+struct Inliner::Func {
+    const types::Checker &check;
+    ast::FuncDecl *decl;
+    int cost = 0;
+    std::string reason; // why the body cannot be inlined whatever its cost
+};
+
+// Imported is a body of an imported function, checked against the
+// objects of its package.
+struct Inliner::Imported {
+    ast::FilePtr file;
+    std::unique_ptr<types::Scope> outer;
+    std::unique_ptr<types::Checker> check;
+};
+
+// ----------------------------------------------------------------------------
+// InlineDecision
+
+std::string InlineDecision::Message() const {
+    switch (kind) {
+    case CanInline:
+        return fmt::format("can inline {} with cost {}", Func, Cost);
+    case CannotInline:
+        return fmt::format("cannot inline {}: {}", Func, Reason);
+    default:
+        return fmt::format("inlining call to {}", Func);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Inliner
+
+Inliner::Inliner(const types::Checker &check, int budget) : _check(check), _budget(budget) {}
+Inliner::~Inliner() = default;
+
+const std::vector<InlineDecision> &Inliner::Analyze(std::span<ast::File *const> files) {
+    if (_budget <= 0) {
+        return _decisions;
+    }
+    auto graph = CallGraph::Build(_check, files);
+    for (auto &component : graph.Components()) {
+        bool recursive = graph.Recursive(component);
+        for (auto i : component) {
+            auto obj = graph.Objects[i];
+            if (obj == nullptr || !obj->TParams.empty()) {
+                continue; // generic functions are instantiated, see stencil.hh
+            }
+            Func f{_check, graph.Funcs[i]};
+            cost(f);
+            auto reason = f.reason;
+            if (reason.empty() && recursive) {
+                reason = "recursive";
+            } else if (reason.empty() && f.cost > _budget) {
+                reason = fmt::format("function too complex: cost {} exceeds budget {}", f.cost, _budget);
+            } else if (reason.empty() && !(reason = shape(f.decl->Body->List)).empty()) {
+                _shaped[obj] = f.cost;
+            }
+            InlineDecision d{reason.empty() ? InlineDecision::CanInline : InlineDecision::CannotInline,
+                             f.decl->Name->pos, name(_check, obj, 0), f.cost, reason};
+            _decisions.push_back(std::move(d));
+            if (reason.empty()) {
+                _bodies[obj] = body(_check, f.decl, f.cost);
+            }
+        }
+    }
+    for (auto decl : graph.Funcs) {
+        plan(_check, decl, true);
+    }
+    std::stable_sort(_decisions.begin(), _decisions.end(),
+                     [](const InlineDecision &a, const InlineDecision &b) { return a.Pos < b.Pos; });
+    return _decisions;
+}
+
+// cost computes the cost of the body of f, and why it cannot be inlined
+// if it contains what the inliner does not handle.
+int Inliner::cost(Func &f) {
+    auto root = f.decl->Body.get();
+    ast::Inspect(root, [&](ast::Node *n) {
+        if (!f.reason.empty()) {
+            return false;
+        }
+        if (n == root) {
+            return true;
+        }
+        f.cost++;
+        switch (n->Kind()) {
+        case ast::NodeKind::FuncLit:
+            f.reason = "unhandled op CLOSURE";
+            return false;
+        case ast::NodeKind::CallStmt:
+            f.reason = cast<ast::CallStmt>(n)->Tok == Token_Go ? "unhandled op GO" : "unhandled op DEFER";
+            return false;
+        case ast::NodeKind::SelectStmt:
+            f.reason = "unhandled op SELECT";
+            return false;
+        case ast::NodeKind::LabeledStmt:
+            f.reason = "unhandled op LABEL";
+            return false;
+        case ast::NodeKind::BranchStmt:
+            if (cast<ast::BranchStmt>(n)->Tok == Token_Goto) {
+                f.reason = "unhandled op GOTO";
+                return false;
+            }
+            return true;
+        case ast::NodeKind::CallExpr: {
+            auto c = cast<ast::CallExpr>(n);
+            if (auto b = builtin(f.check, c)) {
+                if (b->Builtin == types::BuiltinId::Recover) {
+                    f.reason = "call to recover";
+                    return false;
+                }
+                return true;
+            }
+            if (IsType(f.check, c->Fun.get())) {
+                return true; // a conversion
+            }
+            auto callee = StaticCallee(f.check, c);
+            auto body = callee == nullptr ? nullptr : Body(callee);
+            if (body != nullptr) {
+                f.cost += body->Cost;
+            } else if (auto it = callee == nullptr ? _shaped.end() : _shaped.find(callee); it != _shaped.end()) {
+                f.cost += it->second; // gc would inline it
+            } else {
+                f.cost += InlineExtraCallCost;
+            }
+            return true;
+        }
+        default:
+            return true;
+        }
+    });
+    return f.cost;
+}
+
+// plan plans the calls to inline in the body of decl, checked by check,
+// and reports them if report is set.
+void Inliner::plan(const types::Checker &check, ast::FuncDecl *decl, bool report) {
+    auto &table = TypeTable::Global();
+    size_t nodes = 0;
+    ast::Inspect(decl->Body.get(), [&](ast::Node *) { return ++nodes <= size_t(InlineBigFunctionNodes); });
+    bool big = nodes > size_t(InlineBigFunctionNodes);
+
+    // the calls of go and defer statements run later: they are not inlined
+    std::unordered_set<const ast::CallExpr *> spawned;
+    ast::Inspect(decl->Body.get(), [&](ast::Node *n) {
+        if (auto s = dyn_cast<ast::CallStmt>(n)) {
+            spawned.insert(s->Call.get());
+            return true;
+        }
+        auto c = dyn_cast<ast::CallExpr>(n);
+        if (c == nullptr || spawned.count(c) != 0) {
+            return true;
+        }
+        auto callee = StaticCallee(check, c);
+        auto body = callee == nullptr ? nullptr : Body(callee);
+        if (body == nullptr || (big && body->Cost > InlineBigFunctionMaxCost)) {
+            return true;
+        }
+        InlinedCall call{callee, body};
+        TypeId recv = 0;
+        auto sel = dyn_cast<ast::SelectorExpr>(unparen(c->Fun.get()));
+        if (sel != nullptr && !packageName(check, sel->X.get())) {
+            recv = sel->X->typ;
+            if (!IsType(check, sel->X.get())) {
+                auto s = types::LookupFieldOrMethod(check, recv, sel->Sel->Sym);
+                if (!s.index.empty()) {
+                    return true; // promoted from an embedded field
+                }
+                bool ptr = table.Kind(table.Underlying(recv)) == KindPointer;
+                call.AddrRecv = callee->PtrRecv && !ptr;
+                call.DerefRecv = !callee->PtrRecv && ptr;
+                call.Args.push_back(sel->X.get());
+            }
+        }
+        if (!arguments(call, c)) {
+            return true;
+        }
+        if (report) {
+            _decisions.push_back({InlineDecision::Call, c->pos, name(check, callee, recv)});
+        }
+        _calls.emplace(c, std::move(call));
+        return true;
+    });
+}
+
+const InlineBody *Inliner::Body(Object *fn) {
+    if (_budget <= 0 || !fn->TParams.empty()) {
+        return nullptr;
+    }
+    if (auto it = _bodies.find(fn); it != _bodies.end()) {
+        return it->second.get();
+    }
+    return load(fn);
+}
+
+// load parses and checks the body of the imported function fn and
+// computes its cost. The package objects the body refers to are looked up
+// in the package declaring fn and make up the outer scope of the body.
+const InlineBody *Inliner::load(Object *fn) {
+    auto importer = _check.GetImporter();
+    auto pkg = fn->Imported;
+    if (fn->Body.empty() || pkg == nullptr || importer == nullptr) {
+        return nullptr;
+    }
+    _bodies.emplace(fn, nullptr); // breaks cycles
+
+    auto imp = std::make_unique<Imported>();
+    bool ok = true;
+    imp->file = syntax::Parse(std::make_unique<std::istringstream>(std::string(fn->Body)),
+                              [&](uint, uint, std::string) { ok = false; });
+    if (!ok || imp->file == nullptr || imp->file->DeclList.empty()) {
+        return nullptr;
+    }
+    auto decl = dyn_cast<ast::FuncDecl>(imp->file->DeclList.back().get());
+    if (decl == nullptr || decl->Body == nullptr || decl->Recv != nullptr) {
+        return nullptr;
+    }
+    imp->outer = std::make_unique<types::Scope>(&types::Universe());
+    ast::Inspect(imp->file.get(), [&](ast::Node *n) {
+        if (auto name = dyn_cast<ast::Name>(n)) {
+            if (auto obj = pkg->Lookup(name->Sym)) {
+                imp->outer->Insert(obj);
+            }
+        }
+        return true;
+    });
+    imp->outer->Freeze();
+    imp->check = std::make_unique<types::Checker>(importer, imp->outer.get());
+    ast::File *files[] = {imp->file.get()};
+    if (!imp->check->Check(files, false).empty()) {
+        return nullptr;
+    }
+
+    Func f{*imp->check, decl};
+    cost(f);
+    if (!f.reason.empty() || f.cost > _budget || !shape(decl->Body->List).empty()) {
+        return nullptr;
+    }
+    auto b = body(*imp->check, decl, f.cost);
+    plan(*imp->check, decl, false);
+    _imported.push_back(std::move(imp));
+    return (_bodies[fn] = std::move(b)).get();
+}
+
+const InlinedCall *Inliner::Inlined(const ast::CallExpr *call) const {
+    auto it = _calls.find(call);
+    return it == _calls.end() ? nullptr : &it->second;
+}
+
+void Inliner::InlineDirect(std::span<const DirectCall> calls) {
+    auto &table = TypeTable::Global();
+    for (auto &c : calls) {
+        auto body = Body(c.Method);
+        if (body == nullptr) {
+            continue;
+        }
+        auto sel = cast<ast::SelectorExpr>(unparen(c.Call->Fun.get()));
+        InlinedCall direct{c.Method, body, {sel->X.get()}};
+        direct.DerefRecv = !c.Method->PtrRecv && table.Kind(table.Underlying(c.Recv)) == KindPointer;
+        direct.Assert = c.Recv;
+        if (!arguments(direct, c.Call)) {
+            continue;
+        }
+        _decisions.push_back({InlineDecision::Call, c.Call->pos, name(_check, c.Method, c.Recv)});
+        _calls[c.Call] = std::move(direct);
+    }
+    std::stable_sort(_decisions.begin(), _decisions.end(),
+                     [](const InlineDecision &a, const InlineDecision &b) { return a.Pos < b.Pos; });
+}
+
+// Exports formats each body as a file of the package: the imports the body
+// and its signature use, and the function _ whose parameters are the
+// receiver and the parameters of the function, with its results and
+// statements.
+types::InlineBodies Inliner::Exports() const {
+    types::InlineBodies out;
+    for (auto &[fn, body] : _bodies) {
+        if (body == nullptr || body->Check != &_check) {
+            continue; // imported
+        }
+        std::map<std::string_view, std::string_view> imports;
+        auto note = [&](ast::Node *root) {
+            ast::Inspect(root, [&](ast::Node *n) {
+                if (auto name = dyn_cast<ast::Name>(n)) {
+                    if (auto obj = _check.ObjectOf(name); obj != nullptr && obj->Kind == ObjKind::PkgName) {
+                        imports.emplace(name->Value, obj->Path);
+                    }
+                }
+                return true;
+            });
+        };
+        auto add = [&](std::string &list, ast::Field *f) {
+            auto name = f->Name == nullptr || f->Name->Value.empty() ? std::string_view("_")
+                                                                      : std::string_view(f->Name->Value);
+            list += fmt::format("{}{} {}", list.empty() ? "" : ", ", name, ast::String(f->Type.get()));
+            note(f->Type.get());
+        };
+        auto decl = body->Decl;
+        std::string params, results;
+        if (decl->Recv != nullptr) {
+            add(params, decl->Recv.get());
+        }
+        for (auto &p : decl->Type->ParamList) {
+            add(params, p.get());
+        }
+        for (auto &r : decl->Type->ResultList) {
+            add(results, r.get());
+        }
+        note(decl->Body.get());
+
+        auto src = fmt::format("package {}\n\n", _check.Name());
+        for (auto [name, path] : imports) {
+            src += fmt::format("import {} \"{}\"\n", name, path);
+        }
+        src += fmt::format("\nfunc _({}){} {{\n", params, results.empty() ? "" : " (" + results + ")");
+        format(src, decl->Body->List, 1);
+        src += "}\n";
+        out.emplace(fn, std::move(src));
+    }
+    return out;
+}
+
+// name returns how decisions name the function or method fn, declared by
+// the package of check or an imported one; recv is the receiver type of a
+// call of an imported method.
+std::string Inliner::name(const types::Checker &check, Object *fn, TypeId recv) const {
+    auto &interner = common::Interner::Global();
+    auto &table = TypeTable::Global();
+    auto method = interner.Name(fn->Name);
+    if (auto decl = dyn_cast_or_null<ast::FuncDecl>(fn->Decl); decl != nullptr && decl->Recv != nullptr) {
+        auto t = ast::String(decl->Recv->Type.get());
+        return t.starts_with("*") ? fmt::format("({}).{}", t, method) : fmt::format("{}.{}", t, method);
+    }
+    if (recv == 0) {
+        return fn->Imported == nullptr ? std::string(method) : fmt::format("{}.{}", fn->Imported->Name(), method);
+    }
+    if (table.Kind(recv) == KindPointer) {
+        recv = table[recv].Elem();
+    }
+    auto t = table.String(recv);
+    auto importer = check.GetImporter();
+    if (auto owner = importer == nullptr ? nullptr : importer->Owner(recv)) {
+        t = fmt::format("{}.{}", owner->Name(), t);
+    }
+    return fn->PtrRecv ? fmt::format("(*{}).{}", t, method) : fmt::format("{}.{}", t, method);
+}
+
+} // namespace compile
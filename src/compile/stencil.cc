@@ -0,0 +1,688 @@
+#include "compile/stencil.hh"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <unordered_set>
+
+#include "compile/callgraph.hh"
+#include "syntax/ast/walk.hh"
+#include "syntax/parser.hh"
+#include "syntax/types/scope.hh"
+
+namespace compile {
+
+using types::ObjKind;
+using types::Object;
+using types::TypeId;
+using types::TypeTable;
+
+namespace {
+
+ast::ExprNode *unparen(ast::ExprNode *e) {
+    while (auto p = dyn_cast_or_null<ast::ParenExpr>(e)) {
+        e = p->X.get();
+    }
+    return e;
+}
+
+// dependent reports whether t refers to a type parameter.
+bool dependent(TypeId t) {
+    auto &table = TypeTable::Global();
+    auto &typ = table[t];
+    if (typ.Kind == KindTypeParam) {
+        return true;
+    }
+    if (typ.Kind < KindArray || typ.Kind == KindNamed) {
+        return false;
+    }
+    return std::any_of(typ.Elems.begin(), typ.Elems.end(), [](TypeId e) { return dependent(types::TermType(e)); });
+}
+
+bool dependent(std::span<const TypeId> list) {
+    return std::any_of(list.begin(), list.end(), [](TypeId t) { return dependent(t); });
+}
+
+// printer writes types in Go syntax. The named types of other packages are
+// qualified by the path of their package if link is set, which makes the
+// names of stencils and dictionaries the same in all packages of a build,
+// and by the name of their package otherwise, which is noted in imports.
+struct printer {
+    const types::Checker &check;
+    std::string_view path; // of the package of check
+    bool link;
+    std::map<std::string, std::string> *imports = nullptr;
+
+    std::string operator()(TypeId t) {
+        std::string s;
+        write(s, t);
+        return s;
+    }
+
+    std::string operator()(std::span<const TypeId> list) {
+        std::string s;
+        for (size_t i = 0; i < list.size(); i++) {
+            s += i > 0 ? "," : "";
+            write(s, list[i]);
+        }
+        return s;
+    }
+
+    void list(std::string &s, std::span<const TypeId> list, bool variadic) {
+        for (size_t i = 0; i < list.size(); i++) {
+            s += i > 0 ? ", " : "";
+            if (variadic && i + 1 == list.size()) {
+                s += "...";
+                write(s, TypeTable::Global()[list[i]].Elem());
+            } else {
+                write(s, list[i]);
+            }
+        }
+    }
+
+    void write(std::string &s, TypeId t) {
+        auto &table = TypeTable::Global();
+        auto &interner = common::Interner::Global();
+        auto &typ = table[t];
+        switch (typ.Kind) {
+        case KindArray:
+            s += fmt::format("[{}]", typ.Len);
+            write(s, typ.Elem());
+            break;
+        case KindSlice:
+            s += "[]";
+            write(s, typ.Elem());
+            break;
+        case KindPointer:
+            s += "*";
+            write(s, typ.Elem());
+            break;
+        case KindMap:
+            s += "map[";
+            write(s, typ.Key());
+            s += "]";
+            write(s, typ.Elem());
+            break;
+        case KindChan:
+            s += typ.Len == 2 ? "<-chan " : typ.Len == 1 ? "chan<- " : "chan ";
+            write(s, typ.Elem());
+            break;
+        case KindFunc: {
+            s += "func(";
+            list(s, typ.Params(), typ.Variadic);
+            s += ")";
+            auto results = typ.Results();
+            if (results.size() == 1) {
+                s += " ";
+                write(s, results[0]);
+            } else if (results.size() > 1) {
+                s += " (";
+                list(s, results, false);
+                s += ")";
+            }
+            break;
+        }
+        case KindStruct:
+            s += "struct{";
+            for (size_t i = 0; i < typ.Names.size(); i++) {
+                s += i > 0 ? "; " : "";
+                if (!(typ.Names[i] & types::EmbeddedField)) {
+                    s += interner.Name(typ.Names[i]);
+                    s += " ";
+                }
+                write(s, typ.Elems[i]);
+            }
+            s += "}";
+            break;
+        case KindInterface: {
+            s += "interface{";
+            auto sep = "";
+            for (size_t i = 0; i < typ.Names.size(); i++, sep = "; ") {
+                s += sep;
+                s += interner.Name(typ.Names[i]);
+                s += (*this)(typ.Elems[i]).substr(4); // drop the func keyword
+            }
+            if (typ.Variadic) {
+                s += sep;
+                s += "comparable";
+                sep = "; ";
+            }
+            auto terms = typ.Terms();
+            for (size_t i = 0; i < terms.size(); i++) {
+                s += i > 0 ? " | " : sep;
+                s += terms[i] & types::TildeTerm ? "~" : "";
+                write(s, types::TermType(terms[i]));
+            }
+            s += "}";
+            break;
+        }
+        case KindNamed: {
+            auto importer = check.GetImporter();
+            auto owner = importer == nullptr ? nullptr : importer->Owner(t);
+            auto universe = types::Universe().Lookup(typ.Name);
+            if (owner != nullptr) {
+                s += link ? owner->Path() : owner->Name();
+                s += ".";
+                if (imports != nullptr) {
+                    imports->emplace(owner->Name(), owner->Path());
+                }
+            } else if (link && (universe == nullptr || universe->Type != t)) {
+                s += path;
+                s += ".";
+            }
+            s += interner.Name(typ.Name);
+            break;
+        }
+        case KindTypeParam:
+            s += interner.Name(typ.Name);
+            break;
+        default:
+            s += table.String(t);
+        }
+    }
+};
+
+} // namespace
+
+// Imported is the signature of an imported generic function decoded with
+// its layout, checked against the objects of its package.
+struct Stenciler::Imported {
+    ast::FilePtr file;
+    std::unique_ptr<types::Scope> outer;
+    std::unique_ptr<types::Checker> check;
+};
+
+// ----------------------------------------------------------------------------
+// Shapes
+
+TypeId ShapeOf(TypeId t) {
+    auto &table = TypeTable::Global();
+    auto u = table.Underlying(t);
+    switch (table.Kind(u)) {
+    case KindPointer:
+    case KindUnsafePointer:
+    case KindMap:
+    case KindChan:
+    case KindFunc:
+        return table.Pointer(KindUint8);
+    default:
+        return u;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// InstanceCache and StencilReport
+
+std::string InstanceCache::Claim(const std::string &name, std::string_view pkg) {
+    if (_owners.insert(name, std::string(pkg))) {
+        return std::string(pkg);
+    }
+    return _owners.find(name);
+}
+
+std::string StencilReport::Message() const {
+    if (New) {
+        return fmt::format("instantiating {} with new stencil {}", Instance, Code->Name);
+    }
+    if (Elsewhere) {
+        return fmt::format("instantiating {} with stencil {} of package {}", Instance, Code->Name, Code->Owner);
+    }
+    return fmt::format("instantiating {} with stencil {}", Instance, Code->Name);
+}
+
+// ----------------------------------------------------------------------------
+// Stenciler
+
+Stenciler::Stenciler(const types::Checker &check, std::string path, InstanceCache *cache)
+    : _check(check), _path(std::move(path)), _cache(cache) {}
+Stenciler::~Stenciler() = default;
+
+const std::vector<StencilReport> &Stenciler::Analyze(std::span<ast::File *const> files) {
+    for (auto file : files) {
+        for (auto &d : file->DeclList) {
+            auto decl = dyn_cast<ast::FuncDecl>(d.get());
+            auto obj = decl == nullptr || decl->Body == nullptr ? nullptr : _check.ObjectOf(decl->Name.get());
+            if (obj != nullptr && !obj->TParams.empty()) {
+                layout(obj, decl);
+            }
+        }
+    }
+    // the instances in generic bodies whose type arguments refer to type
+    // parameters are instantiated with the dictionaries they are in
+    std::unordered_set<const Stencil *> seen;
+    for (auto file : files) {
+        ast::Inspect(file, [&](ast::Node *n) {
+            auto name = dyn_cast<ast::Name>(n);
+            auto inst = name == nullptr ? nullptr : _check.InstanceOf(name);
+            if (inst == nullptr || dependent(inst->TypeArgs)) {
+                return true;
+            }
+            auto dict = instantiate(inst->Func, inst->TypeArgs);
+            if (dict == nullptr) {
+                return true;
+            }
+            _instances.emplace(name, dict);
+            auto fn = inst->Func;
+            auto instance = fmt::format("{}{}[{}]", fn->Imported == nullptr ? "" : fmt::format("{}.", fn->Imported->Name()),
+                                        common::Interner::Global().Name(fn->Name),
+                                        printer{_check, _path, false}(inst->TypeArgs));
+            bool elsewhere = dict->Code->Owner != _path;
+            bool isNew = !elsewhere && seen.insert(dict->Code).second;
+            _reports.push_back({name->pos, std::move(instance), dict->Code, isNew, elsewhere});
+            return true;
+        });
+    }
+    std::stable_sort(_reports.begin(), _reports.end(),
+                     [](const StencilReport &a, const StencilReport &b) { return a.Pos < b.Pos; });
+    return _reports;
+}
+
+// layout computes the layout of the dictionaries of the generic function
+// fn declared by decl from what its body does with its type parameters.
+GenericFunc *Stenciler::layout(Object *fn, ast::FuncDecl *decl) {
+    auto &table = TypeTable::Global();
+    auto g = std::make_unique<GenericFunc>();
+    g->Func = fn;
+    g->Name = funcName(fn);
+    g->TParams = fn->TParams;
+    auto add = [&](DictEntry e) {
+        if (std::find(g->Layout.begin(), g->Layout.end(), e) == g->Layout.end()) {
+            g->Layout.push_back(std::move(e));
+        }
+    };
+    for (auto t : fn->TParams) {
+        add({DictEntry::TypeDesc, t});
+    }
+    // convert adds the entry a conversion of a value of type v to the
+    // interface t needs: the type of an empty interface, the itab of
+    // another
+    auto convert = [&](TypeId v, TypeId t) {
+        auto &iface = table[table.Underlying(t)];
+        if (iface.Kind != KindInterface || !dependent(v) || table.Kind(table.Underlying(v)) == KindInterface) {
+            return;
+        }
+        if (iface.Names.empty()) {
+            add({DictEntry::TypeDesc, v});
+        } else {
+            add({DictEntry::Itab, v, t});
+        }
+    };
+    // the results of the function literals are not those of fn
+    std::unordered_set<const ast::Node *> nested;
+    ast::Inspect(decl->Body.get(), [&](ast::Node *n) {
+        if (auto lit = dyn_cast<ast::FuncLit>(n)) {
+            ast::Inspect(lit->Body.get(), [&](ast::Node *m) {
+                if (isa<ast::ReturnStmt>(m)) {
+                    nested.insert(m);
+                }
+                return true;
+            });
+        }
+        return true;
+    });
+    auto results = table[fn->Type].Results();
+    ast::Inspect(decl->Body.get(), [&](ast::Node *n) {
+        switch (n->Kind()) {
+        case ast::NodeKind::ReturnStmt: {
+            auto ret = cast<ast::ReturnStmt>(n);
+            if (ret->Results == nullptr || nested.count(ret) != 0) {
+                break;
+            }
+            auto list = dyn_cast<ast::ListExpr>(ret->Results.get());
+            if (list == nullptr && results.size() == 1) {
+                convert(ret->Results->typ, results[0]);
+            }
+            for (size_t i = 0; list != nullptr && i < list->ElemList.size() && i < results.size(); i++) {
+                convert(list->ElemList[i]->typ, results[i]);
+            }
+            break;
+        }
+        case ast::NodeKind::CompositeLit:
+        case ast::NodeKind::AssertExpr: {
+            auto t = cast<ast::ExprNode>(n)->typ;
+            if (dependent(t)) {
+                add({DictEntry::TypeDesc, t});
+            }
+            break;
+        }
+        case ast::NodeKind::SwitchStmt: {
+            auto s = cast<ast::SwitchStmt>(n);
+            if (!isa<ast::TypeSwitchGuard>(s->Tag.get())) {
+                break;
+            }
+            for (auto &c : s->Body) {
+                auto cases = dyn_cast_or_null<ast::ListExpr>(c->Cases.get());
+                auto one = c->Cases.get();
+                for (size_t i = 0; i < (cases != nullptr ? cases->ElemList.size() : one != nullptr); i++) {
+                    auto t = (cases != nullptr ? cases->ElemList[i].get() : one)->typ;
+                    if (dependent(t)) {
+                        add({DictEntry::TypeDesc, t});
+                    }
+                }
+            }
+            break;
+        }
+        case ast::NodeKind::SelectorExpr: {
+            auto sel = cast<ast::SelectorExpr>(n);
+            auto x = sel->X->typ;
+            auto base = table.Kind(x) == KindPointer ? table[x].Elem() : x;
+            if (table.Kind(base) == KindTypeParam &&
+                types::LookupFieldOrMethod(_check, x, sel->Sel->Sym).kind == types::Selection::Method) {
+                add({DictEntry::Method, base, 0, std::string(sel->Sel->Value)});
+            }
+            break;
+        }
+        case ast::NodeKind::Name: {
+            auto inst = _check.InstanceOf(cast<ast::Name>(n));
+            if (inst != nullptr && dependent(inst->TypeArgs)) {
+                add({DictEntry::SubDict, 0, 0, {}, inst->Func, inst->TypeArgs});
+            }
+            break;
+        }
+        case ast::NodeKind::CallExpr: {
+            auto c = cast<ast::CallExpr>(n);
+            auto fun = unparen(c->Fun.get());
+            auto b = dyn_cast<ast::Name>(fun);
+            auto obj = b == nullptr ? nullptr : _check.ObjectOf(b);
+            if (obj != nullptr && obj->Kind == ObjKind::Builtin) {
+                if (obj->Builtin == types::BuiltinId::Make && dependent(c->typ)) {
+                    add({DictEntry::TypeDesc, c->typ});
+                } else if (obj->Builtin == types::BuiltinId::New && dependent(c->typ)) {
+                    add({DictEntry::TypeDesc, table[c->typ].Elem()});
+                }
+                break;
+            }
+            if (IsType(_check, fun)) {
+                if (c->ArgList.size() == 1) {
+                    convert(c->ArgList[0]->typ, c->typ);
+                }
+                break;
+            }
+            // the arguments passed to parameters of interface types
+            auto &sig = table[table.Underlying(fun->typ)];
+            if (sig.Kind != KindFunc || c->HasDots) {
+                break;
+            }
+            auto params = sig.Params();
+            for (size_t i = 0; i < c->ArgList.size() && !params.empty(); i++) {
+                auto p = params[std::min(i, params.size() - 1)];
+                if (sig.Variadic && i + 1 >= params.size()) {
+                    p = table[p].Elem();
+                }
+                convert(c->ArgList[i]->typ, p);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        return true;
+    });
+    auto out = g.get();
+    _generics[fn] = std::move(g);
+    return out;
+}
+
+const GenericFunc *Stenciler::Generic(Object *fn) {
+    if (fn == nullptr || fn->TParams.empty()) {
+        return nullptr;
+    }
+    if (auto it = _generics.find(fn); it != _generics.end()) {
+        return it->second.get();
+    }
+    return load(fn);
+}
+
+// load decodes the layout of the imported generic function fn. Its types
+// are the parameter types of the function _ of the file exported, checked
+// against the objects of the package declaring fn; see Exports. Without a
+// usable layout, the dictionaries of fn hold its type arguments only.
+const GenericFunc *Stenciler::load(Object *fn) {
+    auto pkg = fn->Imported;
+    auto importer = _check.GetImporter();
+    if (pkg == nullptr) {
+        return nullptr;
+    }
+    auto g = std::make_unique<GenericFunc>();
+    g->Func = fn;
+    g->Name = funcName(fn);
+    g->TParams = fn->TParams;
+    for (auto t : fn->TParams) {
+        g->Layout.push_back({DictEntry::TypeDesc, t});
+    }
+    auto out = g.get();
+    _generics[fn] = std::move(g);
+
+    auto imp = std::make_unique<Imported>();
+    bool ok = importer != nullptr && !fn->Body.empty();
+    if (ok) {
+        imp->file = syntax::Parse(std::make_unique<std::istringstream>(std::string(fn->Body)),
+                                  [&](uint, uint, std::string) { ok = false; });
+    }
+    auto decl = !ok || imp->file == nullptr || imp->file->DeclList.empty()
+                    ? nullptr
+                    : dyn_cast<ast::FuncDecl>(imp->file->DeclList.back().get());
+    if (decl == nullptr || decl->TParamList.size() != fn->TParams.size()) {
+        return out;
+    }
+    imp->outer = std::make_unique<types::Scope>(&types::Universe());
+    ast::Inspect(imp->file.get(), [&](ast::Node *n) {
+        if (auto name = dyn_cast<ast::Name>(n)) {
+            if (auto obj = pkg->Lookup(name->Sym)) {
+                imp->outer->Insert(obj);
+            }
+        }
+        return true;
+    });
+    imp->outer->Freeze();
+    imp->check = std::make_unique<types::Checker>(importer, imp->outer.get());
+    ast::File *files[] = {imp->file.get()};
+    if (!imp->check->Check(files, false).empty()) {
+        return out;
+    }
+
+    std::vector<TypeId> tparams, params;
+    for (auto &f : decl->TParamList) {
+        tparams.push_back(imp->check->ObjectOf(f->Name.get())->Type);
+    }
+    for (auto &f : decl->Type->ParamList) {
+        params.push_back(f->Type->typ);
+    }
+    auto type = [&](int i) { return i >= 0 && size_t(i) < params.size() ? params[size_t(i)] : 0; };
+    std::vector<DictEntry> layout;
+    std::istringstream body{std::string(fn->Body)};
+    for (std::string line; std::getline(body, line);) {
+        std::istringstream in(line);
+        std::string dict, kind;
+        in >> dict >> kind;
+        if (dict != "//dict") {
+            continue;
+        }
+        DictEntry e;
+        int i = -1, j = -1;
+        if (kind == "type" && in >> i) {
+            e = {DictEntry::TypeDesc, type(i)};
+        } else if (kind == "method" && in >> i >> e.Name) {
+            e.kind = DictEntry::Method;
+            e.Type = type(i);
+        } else if (kind == "itab" && in >> i >> j) {
+            e = {DictEntry::Itab, type(i), type(j)};
+        } else if (std::string path, name; kind == "subdict" && in >> path >> name) {
+            auto from = path == pkg->Path() ? pkg : importer->Import(path);
+            auto callee = from == nullptr ? nullptr : from->Lookup(common::Interner::Global().Intern(name));
+            e.kind = DictEntry::SubDict;
+            e.Callee = callee;
+            while (in >> i) {
+                e.TypeArgs.push_back(type(i));
+            }
+            if (callee == nullptr || e.TypeArgs.size() != callee->TParams.size()) {
+                return out;
+            }
+        } else {
+            return out;
+        }
+        if (e.Type == 0 && e.kind != DictEntry::SubDict) {
+            return out;
+        }
+        layout.push_back(std::move(e));
+    }
+    out->TParams = std::move(tparams);
+    out->Layout = std::move(layout);
+    _imported.push_back(std::move(imp));
+    return out;
+}
+
+// instantiate returns the dictionary of fn instantiated with targs, which
+// it creates with those of the generic functions fn calls, and the
+// stencil of the dictionary, which it claims in the cache.
+const Dictionary *Stenciler::instantiate(Object *fn, std::span<const TypeId> targs) {
+    auto g = Generic(fn);
+    if (g == nullptr || targs.size() != g->TParams.size()) {
+        return nullptr;
+    }
+    auto name = fmt::format("{}[{}]", g->Name, printer{_check, _path, true}(targs));
+    if (auto it = _dictsByName.find(name); it != _dictsByName.end()) {
+        return it->second;
+    }
+    auto dict = std::make_unique<Dictionary>();
+    dict->Name = std::move(name);
+    dict->TypeArgs.assign(targs.begin(), targs.end());
+
+    std::vector<TypeId> shapes;
+    std::string shapeNames;
+    for (auto t : targs) {
+        shapes.push_back(ShapeOf(t));
+        shapeNames += fmt::format("{}go.shape.{}", shapeNames.empty() ? "" : ",",
+                                  printer{_check, _path, true}(shapes.back()));
+    }
+    auto stencilName = fmt::format("{}[{}]", g->Name, shapeNames);
+    auto &code = _stencilsByName[stencilName];
+    if (code == nullptr) {
+        auto s = std::make_unique<Stencil>();
+        s->Generic = g;
+        s->Shapes = std::move(shapes);
+        s->Name = stencilName;
+        s->Owner = _cache != nullptr ? _cache->Claim(stencilName, _path) : _path;
+        code = s.get();
+        _stencils.push_back(std::move(s));
+    }
+    dict->Code = code;
+
+    auto d = dict.get();
+    _dictsByName.emplace(d->Name, d); // a recursive function refers to its own dictionary
+    _dicts.push_back(std::move(dict));
+    for (auto &e : g->Layout) {
+        DictEntry c = e;
+        c.Type = types::Subst(e.Type, g->TParams, targs);
+        c.Iface = types::Subst(e.Iface, g->TParams, targs);
+        for (auto &t : c.TypeArgs) {
+            t = types::Subst(t, g->TParams, targs);
+        }
+        if (c.kind == DictEntry::SubDict) {
+            auto sub = instantiate(c.Callee, c.TypeArgs);
+            c.Name = sub != nullptr ? sub->Name : "";
+        }
+        d->Entries.push_back(std::move(c));
+    }
+    return d;
+}
+
+const Dictionary *Stenciler::DictOf(const ast::Name *name) const {
+    auto it = _instances.find(name);
+    return it == _instances.end() ? nullptr : it->second;
+}
+
+// Exports formats the layout of each generic function as a file of the
+// package: the imports its types use, and the function _ with the type
+// parameters of the function and one parameter per type of the layout,
+// the type parameters first, followed by the entries of the layout as
+// comments "//dict kind operands", where the operands of an entry are the
+// indices of its types among the parameters:
+//
+//     //dict type i
+//     //dict method i name
+//     //dict itab i iface
+//     //dict subdict path name targs...
+types::InlineBodies Stenciler::Exports() const {
+    types::InlineBodies out;
+    for (auto &[fn, g] : _generics) {
+        auto decl = g == nullptr || fn->Imported != nullptr ? nullptr : dyn_cast_or_null<ast::FuncDecl>(fn->Decl);
+        if (decl == nullptr) {
+            continue; // imported
+        }
+        std::map<std::string, std::string> imports;
+        printer print{_check, _path, false, &imports};
+        std::vector<TypeId> params;
+        auto index = [&](TypeId t) {
+            auto it = std::find(params.begin(), params.end(), t);
+            if (it != params.end()) {
+                return size_t(it - params.begin());
+            }
+            params.push_back(t);
+            return params.size() - 1;
+        };
+        for (auto t : g->TParams) {
+            index(t);
+        }
+        std::string entries;
+        for (auto &e : g->Layout) {
+            switch (e.kind) {
+            case DictEntry::TypeDesc:
+                entries += fmt::format("//dict type {}\n", index(e.Type));
+                break;
+            case DictEntry::Method:
+                entries += fmt::format("//dict method {} {}\n", index(e.Type), e.Name);
+                break;
+            case DictEntry::Itab:
+                entries += fmt::format("//dict itab {} {}\n", index(e.Type), index(e.Iface));
+                break;
+            case DictEntry::SubDict: {
+                auto callee = e.Callee;
+                entries += fmt::format("//dict subdict {} {}",
+                                       callee->Imported != nullptr ? callee->Imported->Path() : _path,
+                                       common::Interner::Global().Name(callee->Name));
+                for (auto t : e.TypeArgs) {
+                    entries += fmt::format(" {}", index(t));
+                }
+                entries += "\n";
+                break;
+            }
+            }
+        }
+
+        std::string tparams;
+        for (auto &f : decl->TParamList) {
+            tparams += fmt::format("{}{} {}", tparams.empty() ? "" : ", ", f->Name->Value, ast::String(f->Type.get()));
+            ast::Inspect(f->Type.get(), [&](ast::Node *n) {
+                if (auto name = dyn_cast<ast::Name>(n)) {
+                    if (auto obj = _check.ObjectOf(name); obj != nullptr && obj->Kind == ObjKind::PkgName) {
+                        imports.emplace(name->Value, obj->Path);
+                    }
+                }
+                return true;
+            });
+        }
+        std::string list;
+        for (auto t : params) {
+            list += fmt::format("{}{}", list.empty() ? "" : ", ", print(t));
+        }
+
+        auto src = fmt::format("package {}\n\n", _check.Name());
+        for (auto &[name, path] : imports) {
+            src += fmt::format("import {} \"{}\"\n", name, path);
+        }
+        src += fmt::format("\nfunc _[{}]({}) {{}}\n\n{}", tparams, list, entries);
+        out.emplace(fn, std::move(src));
+    }
+    return out;
+}
+
+// funcName returns the linker name of the function fn: "path.F".
+std::string Stenciler::funcName(Object *fn) const {
+    return fmt::format("{}.{}", fn->Imported != nullptr ? fn->Imported->Path() : std::string_view(_path),
+                       common::Interner::Global().Name(fn->Name));
+}
+
+} // namespace compile
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "build/cache.hh"
+#include "build/constraint.hh"
+#include "compile/devirt.hh"
+#include "compile/escape.hh"
+#include "compile/inline.hh"
+#include "compile/stencil.hh"
+#include "staticdata/embed.hh"
+#include "syntax/ast/nodes.hh"
+#include "syntax/types/check.hh"
+#include "syntax/types/export.hh"
+
+// Building a set of packages. Load finds the packages and their imports
+// under a root directory and builds the import graph from the import
+// clauses alone; Build then runs each package through its stages on the
+// TBB work-stealing pool as soon as the packages it imports are checked,
+// or restores its results from the build cache.
+namespace build {
+
+// Package is the unit of the build: the Go files of one directory.
+struct Package {
+    std::string Path; // import path: the directory relative to the root
+    std::string Dir;
+    std::vector<std::string> Files; // the .go files built for the target, except tests, sorted
+    // Imports are the import paths of the packages under the root that the
+    // files import, sorted; other imports, such as the standard library,
+    // are external to the build and not listed.
+    std::vector<std::string> Imports;
+    std::vector<Package *> Deps;      // the packages of Imports
+    std::vector<Package *> Importers; // the packages importing this one
+    size_t Index = 0;                 // index in Graph::Packages
+    // Cost estimates the work of building the package from the size of
+    // its source. Priority is the cost of the most expensive chain of
+    // builds from the package to one that nothing imports: the packages
+    // on the critical path of the build have the highest priority.
+    uint64_t Cost = 0;
+    uint64_t Priority = 0;
+
+    // results of the build
+    std::vector<ast::FilePtr> Syntax;
+    std::unique_ptr<types::Checker> Types;
+    std::unique_ptr<compile::Inliner> Inline; // the inlining plan, unless inlining is disabled
+    std::unique_ptr<compile::Stenciler> Stencil; // the instantiation plan of the generic functions
+    std::unique_ptr<compile::Devirtualizer> Devirt; // the devirtualization plan of the interface calls
+    std::unique_ptr<compile::EscapeAnalysis> Escape; // the escape decisions of the allocations
+    std::vector<std::string> Errors;  // "file:line:col: msg"
+    std::vector<std::string> Outputs; // the artifacts of the Compile stage
+    // Embeds are the files named by the //go:embed directives of the
+    // package, with their digests, in the order they were written to Data;
+    // those of a cached package were only hashed for its key.
+    std::vector<staticdata::EmbedFile> Embeds;
+    std::string ExportHash;           // the digest of the export data
+    bool Skipped = false;             // not built because a dependency failed
+    // Cached is set if the results were restored from the build cache:
+    // Syntax, Types, Inline, Stencil, Devirt and Escape are then empty, and Compile
+    // is not run.
+    bool Cached = false;
+
+    bool Failed() const { return Skipped || !Errors.empty(); }
+
+    // The files of Syntax are released from syntax::FileSet::Global() with
+    // the package, so that a process building again does not run out of
+    // positions.
+    ~Package();
+};
+
+// Graph is the import graph of a set of packages and their dependencies.
+struct Graph {
+    // Exports holds the export data of the packages built, which the
+    // checkers of their importers refer to.
+    std::unique_ptr<types::DirImporter> Exports;
+    // Instances holds the stencils of the generic functions instantiated
+    // by the packages built, each generated by the first package to need
+    // it. The packages restored from the cache do not claim theirs.
+    std::unique_ptr<compile::InstanceCache> Instances;
+    std::vector<std::unique_ptr<Package>> Packages; // dependencies first
+    std::vector<std::string> Errors;                // missing packages, import cycles
+};
+
+// Load loads the packages with the given import paths from root and,
+// transitively, the packages under root they import. The files of a
+// package are those its build constraints select for target, see
+// MatchFile; the import clauses of all files are parsed in parallel. The
+// packages of an import cycle, and those importing them, are reported and
+// left out of the graph.
+Graph Load(const std::string &root, std::span<const std::string> paths, const Target &target = {});
+
+// Options configure a build.
+struct Options {
+    // Compile is the last stage of a package, if set. It runs once the
+    // package is type-checked and its importers have been released, so
+    // that it overlaps with their builds, after the devirtualization of the
+    // package; it may add to Errors and Outputs.
+    std::function<void(Package &)> Compile;
+    // Data receives the contents of the files embedded by a package, if
+    // set: they are resolved and streamed to it once the package is
+    // devirtualized, before Compile, in the order of Embeds, chunk by
+    // chunk, see staticdata::WriteEmbed.
+    std::function<void(Package &, std::string_view)> Data;
+    // Flags are the flags of the Compile stage, which its outputs depend
+    // on.
+    std::vector<std::string> Flags;
+    // ParallelBodies checks the function bodies of a package in parallel.
+    bool ParallelBodies = true;
+    // InlineBudget is the budget of the functions the inliner inlines, 0
+    // to disable inlining. A package is planned for inlining once it is
+    // checked, and the bodies of its inlinable functions are exported
+    // with it, to be inlined by its importers.
+    int InlineBudget = compile::InlineMaxBudget;
+    // Profile is the text of the profile the interface calls are
+    // devirtualized from under a guard, see compile::CallProfile; it is
+    // ignored if it does not parse.
+    std::string Profile;
+    // ExportDir is the directory the export data of each package is
+    // written to once it is checked, as <path>.x; its importers map it
+    // from there. If empty, export data is kept in memory.
+    std::string ExportDir;
+    // CacheDir is the directory of the build cache, if any. The key of a
+    // package is the digest of its import path, the names and contents of
+    // its files and of the files they embed, Flags, InlineBudget, Profile,
+    // the compiler and the digests of the export data of its imports; its
+    // export data and Outputs are cached under it once it is built without
+    // errors. A change that leaves the export data of a package as it was
+    // does not invalidate its importers. The parsed files are cached there
+    // too, by content, so a package built again for a change elsewhere is
+    // not parsed again.
+    std::string CacheDir;
+    uint64_t CacheSize = Cache::DefaultSize;
+};
+
+// Build parses, type-checks and compiles the packages of g and reports
+// whether all succeeded. A package is checked against the export data of
+// the packages it imports, and starts as soon as they are all exported;
+// of the packages ready to start, those with the highest Priority go
+// first. A package importing one that failed is skipped, and one whose
+// key is in the cache is restored from it. The cache is trimmed to its
+// size once the build is done. The number of threads is that of the TBB
+// pool.
+bool Build(Graph &g, const Options &opts = {});
+
+} // namespace build
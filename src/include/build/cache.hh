@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/digest.hh"
+
+// Local build cache. The results of a build action are stored under the
+// action's key, the digest of everything they depend on, so that an
+// action whose inputs were seen before, in this build or any earlier one,
+// is not run again.
+namespace build {
+
+// Hasher computes the XXH3-128 digest of a sequence of fields. Each field
+// is length-prefixed, so that ("ab", "c") and ("a", "bc") differ.
+class Hasher {
+public:
+    Hasher &Add(std::string_view field);
+    Hasher &Add(uint64_t field);
+    // Sum returns the digest of the fields added so far, as 16 bytes.
+    std::string Sum() const;
+
+private:
+    common::DigestState _state;
+};
+
+// Cache is a directory of action entries and the outputs they refer to.
+// An entry maps the key of an action to the digests of its outputs, which
+// are stored once per content under their own digest; both live in
+// <dir>/<first two hex digits>/<hex digest> with a suffix of -a or -d.
+// Files are written to a temporary file and renamed into place, so
+// concurrent builds sharing a cache never see a partial file, and the
+// outputs are checked against their digest when read, so a damaged file
+// reads as a miss.
+//
+// The cache is bounded by size with least-recently-used eviction: the
+// modification time of a file is its last use, refreshed by Get when it is
+// older than an hour so that hits seldom write, and Trim removes the
+// oldest files once the cache outgrows its limit.
+class Cache {
+public:
+    // DefaultSize is the default bound on the size of a cache.
+    static constexpr uint64_t DefaultSize = uint64_t(1) << 30;
+
+    explicit Cache(std::string dir, uint64_t max_size = DefaultSize);
+
+    // Hash returns the XXH3-128 digest of data, as 16 bytes.
+    static std::string Hash(std::string_view data);
+    // ToolId returns the digest of the running executable, which stands
+    // for the version of the compiler in action keys: the results of one
+    // build of the compiler are never reused by another.
+    static const std::string &ToolId();
+
+    // Get returns the outputs of the action with the given key, in the
+    // order they were put, or nothing if the action or one of its outputs
+    // is missing or damaged.
+    std::optional<std::vector<std::string>> Get(std::string_view key) const;
+
+    // Put stores the outputs of the action with the given key. It reports
+    // whether they were all written.
+    bool Put(std::string_view key, const std::vector<std::string_view> &outputs) const;
+
+    // Trim removes the least recently used files until the cache holds at
+    // most 90% of its limit, if it is over the limit, and returns the size
+    // of the cache left. Temporary files left behind by crashed writers
+    // are removed once they are an hour old.
+    uint64_t Trim() const;
+
+    const std::string &Dir() const { return _dir; }
+
+private:
+    std::string file(std::string_view digest, char kind) const;
+    bool write(const std::string &file, std::string_view data) const;
+
+    std::string _dir;
+    uint64_t _max_size;
+};
+
+} // namespace build
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Build constraints: the //go:build lines and the _GOOS and _GOARCH file
+// name suffixes that select the files of a package for a platform, as
+// go/build applies them.
+namespace build {
+
+// Target is the platform the packages are built for.
+struct Target {
+    std::string GOOS = "linux";
+    std::string GOARCH = "amd64";
+
+    // Match reports whether the build tag tag is satisfied: the operating
+    // system and architecture, "unix" on Unix systems, "gc" and the release
+    // tags go1.1 to go1.21.
+    bool Match(std::string_view tag) const;
+};
+
+// MatchFile reports whether the Go file with the given name and source is
+// built for target: its name has no _GOOS or _GOARCH suffix naming another
+// platform, and the //go:build line of its header, or else its // +build
+// lines, are satisfied. A malformed //go:build line sets error and does not
+// match.
+bool MatchFile(std::string_view name, std::string_view src, const Target &target, std::string &error);
+
+} // namespace build
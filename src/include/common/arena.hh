@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace common {
+
+// Arena is a bump allocator for objects that die together. Memory is
+// carved out of chunks, each at least chunk_size bytes, and is only freed
+// all at once: Reset drops every object but keeps the first chunk, so an
+// arena reused for a sequence of units of work, such as the intermediate
+// representation of the functions of a package, settles at one chunk of
+// the right size and stops calling malloc. Objects are not destroyed, so
+// only trivially destructible types may live in an arena. An arena is not
+// safe for concurrent use.
+class Arena {
+public:
+    static constexpr size_t DefaultChunkSize = 32 << 10;
+
+    explicit Arena(size_t chunk_size = DefaultChunkSize) : _chunk_size(chunk_size) {}
+    ~Arena();
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // Allocate returns size bytes aligned to align, a power of two of at
+    // most alignof(std::max_align_t).
+    void *Allocate(size_t size, size_t align) {
+        auto p = (reinterpret_cast<uintptr_t>(_cur) + align - 1) & ~uintptr_t(align - 1);
+        if (p + size > reinterpret_cast<uintptr_t>(_end)) {
+            return grow(size, align);
+        }
+        _cur = reinterpret_cast<char *>(p + size);
+        return reinterpret_cast<void *>(p);
+    }
+
+    // New constructs a T in the arena.
+    template <typename T, typename... Args>
+    T *New(Args &&...args) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // NewArray returns n value-initialized Ts.
+    template <typename T>
+    T *NewArray(size_t n) {
+        static_assert(std::is_trivially_destructible_v<T>, "arena objects are never destroyed");
+        auto p = static_cast<T *>(Allocate(sizeof(T) * n, alignof(T)));
+        for (size_t i = 0; i < n; i++) {
+            new (p + i) T();
+        }
+        return p;
+    }
+
+    // Reset frees all objects at once. The first chunk is kept, grown to
+    // the size of everything allocated since the last reset if that did
+    // not fit in it.
+    void Reset();
+
+    // Used returns the number of bytes handed out since the last reset,
+    // including padding; Reserved the bytes of the chunks held.
+    size_t Used() const { return _used + size_t(_cur - _begin); }
+    size_t Reserved() const { return _reserved; }
+
+private:
+    // Chunk heads a block of memory; the chunks form a list, newest first.
+    struct Chunk {
+        Chunk *next;
+        size_t size; // bytes after the header
+    };
+
+    void *grow(size_t size, size_t align);
+    void push(size_t size);
+
+    size_t _chunk_size;
+    Chunk *_chunks = nullptr;
+    char *_begin = nullptr; // the free space of the current chunk
+    char *_cur = nullptr;
+    char *_end = nullptr;
+    size_t _used = 0; // bytes used in the chunks before the current one
+    size_t _reserved = 0;
+};
+
+} // namespace common
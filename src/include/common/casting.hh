@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cassert>
+#include <memory>
+#include <type_traits>
+
+#include <base/shared_ptr_helper.hh>
+
+/** Checked casts in the style of LLVM, driven by a kind tag instead of RTTI,
+  * so they work with -fno-rtti and cost a load and a compare.
+  *
+  * To must provide `static bool classof(const Base * from)` which tests the
+  * kind stored in from; see ast::Node for an example.
+  *
+  *   isa<To>(x)              x is a To; x must not be nil
+  *   isa_and_nonnull<To>(x)  x is not nil and a To
+  *   cast<To>(x)             x converted to To; x must be a To
+  *   dyn_cast<To>(x)         x converted to To, or nil if x is not a To
+  *   dyn_cast_or_null<To>(x) like dyn_cast, but x may be nil
+  *
+  * x may be a reference (isa and cast only), a pointer or a std::shared_ptr;
+  * the result of a cast has the same form, and the constness of x.
+  */
+
+namespace casting_detail
+{
+    template <typename To, typename From>
+    using with_const_of = std::conditional_t<std::is_const_v<From>, const To, To>;
+
+    // the overloads taking a reference must not catch pointers or shared_ptrs
+    template <typename From>
+    concept object = !std::is_pointer_v<From> && !is_shared_ptr_v<std::remove_const_t<From>>;
+}
+
+template <typename To, casting_detail::object From>
+inline bool isa(const From & from)
+{
+    return To::classof(&from);
+}
+
+template <typename To, typename From>
+inline bool isa(From * from)
+{
+    assert(from != nullptr && "isa<> used on a null pointer");
+    return To::classof(from);
+}
+
+template <typename To, typename From>
+inline bool isa(const std::shared_ptr<From> & from)
+{
+    return isa<To>(from.get());
+}
+
+template <typename To, typename From>
+inline bool isa_and_nonnull(From * from)
+{
+    return from != nullptr && To::classof(from);
+}
+
+template <typename To, typename From>
+inline bool isa_and_nonnull(const std::shared_ptr<From> & from)
+{
+    return isa_and_nonnull<To>(from.get());
+}
+
+template <typename To, casting_detail::object From>
+inline casting_detail::with_const_of<To, From> & cast(From & from)
+{
+    assert(isa<To>(from) && "cast<> argument of incompatible type");
+    return static_cast<casting_detail::with_const_of<To, From> &>(from);
+}
+
+template <typename To, typename From>
+inline casting_detail::with_const_of<To, From> * cast(From * from)
+{
+    assert(isa<To>(from) && "cast<> argument of incompatible type");
+    return static_cast<casting_detail::with_const_of<To, From> *>(from);
+}
+
+template <typename To, typename From>
+inline std::shared_ptr<casting_detail::with_const_of<To, From>> cast(const std::shared_ptr<From> & from)
+{
+    assert(isa<To>(from) && "cast<> argument of incompatible type");
+    return std::static_pointer_cast<casting_detail::with_const_of<To, From>>(from);
+}
+
+template <typename To, typename From>
+inline casting_detail::with_const_of<To, From> * dyn_cast(From * from)
+{
+    return isa<To>(from) ? static_cast<casting_detail::with_const_of<To, From> *>(from) : nullptr;
+}
+
+template <typename To, typename From>
+inline std::shared_ptr<casting_detail::with_const_of<To, From>> dyn_cast(const std::shared_ptr<From> & from)
+{
+    return isa<To>(from) ? std::static_pointer_cast<casting_detail::with_const_of<To, From>>(from) : nullptr;
+}
+
+template <typename To, typename From>
+inline casting_detail::with_const_of<To, From> * dyn_cast_or_null(From * from)
+{
+    return isa_and_nonnull<To>(from) ? static_cast<casting_detail::with_const_of<To, From> *>(from) : nullptr;
+}
+
+template <typename To, typename From>
+inline std::shared_ptr<casting_detail::with_const_of<To, From>> dyn_cast_or_null(const std::shared_ptr<From> & from)
+{
+    return isa_and_nonnull<To>(from) ? std::static_pointer_cast<casting_detail::with_const_of<To, From>>(from) : nullptr;
+}
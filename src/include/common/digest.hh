@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+struct XXH3_state_s;
+
+namespace common {
+
+// Digest returns the XXH3-128 digest of data, as 16 bytes, the high half
+// first. The build cache, the AST cache and embedded files all name their
+// contents by it.
+std::string Digest(std::string_view data);
+
+// DigestState computes the Digest of data added piece by piece.
+class DigestState {
+public:
+    DigestState();
+    ~DigestState();
+    DigestState(const DigestState &) = delete;
+    DigestState &operator=(const DigestState &) = delete;
+
+    void Update(std::string_view data);
+    // Sum returns the Digest of the data added so far.
+    std::string Sum() const;
+
+private:
+    XXH3_state_s *_state;
+};
+
+// HexDigest returns a digest in lowercase hexadecimal, as it appears in
+// the names of cache files.
+std::string HexDigest(std::string_view digest);
+
+} // namespace common
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include <libcuckoo/cuckoohash_map.hh>
+#include <tbb/spin_mutex.h>
+
+namespace common {
+
+// SymbolId is the dense ID of an interned string. IDs are handed out
+// consecutively from 0, which always denotes the empty string.
+using SymbolId = uint32_t;
+
+// Interner maps strings to dense 32-bit symbol IDs. Each distinct string is
+// stored once in an append-only arena owned by the interner, so the views it
+// returns stay valid for its whole lifetime. All methods are safe to call
+// concurrently, e.g. from parallel lexer threads.
+class Interner {
+public:
+    Interner();
+    ~Interner();
+    Interner(const Interner &) = delete;
+    Interner &operator=(const Interner &) = delete;
+
+    // Global returns the process-wide interner used for identifiers.
+    static Interner &Global();
+
+    // Intern returns the ID of s, adding s if it has not been seen before.
+    SymbolId Intern(std::string_view s);
+
+    // Lookup returns the ID of s, or false if s was never interned.
+    bool Lookup(std::string_view s, SymbolId &id) const;
+
+    // Name returns the string with the given ID.
+    std::string_view Name(SymbolId id) const {
+        return _chunks[id >> chunk_bits].load(std::memory_order_acquire)[id & (chunk_size - 1)];
+    }
+
+    // Size returns the number of distinct strings.
+    size_t Size() const { return _next.load(std::memory_order_acquire); }
+
+private:
+    struct Pending;
+    struct Hash {
+        size_t operator()(std::string_view s) const;
+        size_t operator()(const Pending &p) const;
+    };
+    struct Equal {
+        bool operator()(std::string_view a, std::string_view b) const { return a == b; }
+        bool operator()(std::string_view a, const Pending &b) const;
+    };
+
+    static constexpr int chunk_bits = 16;
+    static constexpr size_t chunk_size = size_t(1) << chunk_bits;
+    static constexpr size_t arena_block_size = 64 << 10;
+
+    std::string_view Store(std::string_view s);
+    SymbolId Publish(std::string_view s);
+
+    cuckoohash_map<std::string_view, SymbolId, Hash, Equal> _map;
+    std::atomic<SymbolId> _next{0};
+    // _chunks[i] holds the names of IDs [i << chunk_bits, (i + 1) << chunk_bits).
+    std::unique_ptr<std::atomic<std::string_view *>[]> _chunks;
+
+    // arena holding the bytes of all interned strings
+    tbb::spin_mutex _arena_mutex;
+    std::vector<std::unique_ptr<char[]>> _blocks;
+    char *_cur = nullptr;
+    size_t _avail = 0;
+};
+
+} // namespace common
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace common {
+
+// MappedFile is a read-only memory mapping of a whole file. The mapping is
+// page aligned and stays valid until the MappedFile is destroyed.
+class MappedFile {
+public:
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Open maps the named file. It returns nil if the file cannot be
+    // opened or mapped.
+    static std::unique_ptr<MappedFile> Open(const std::string &path);
+
+    const char *Data() const { return _data; }
+    size_t Size() const { return _size; }
+    std::string_view View() const { return std::string_view(_data, _size); }
+
+    // Sequential advises the kernel that the mapping will be read once from
+    // start to end, so that it reads ahead aggressively.
+    void Sequential() const;
+    // Release drops the pages of [offset, offset+size) from the process;
+    // offset must be page aligned. They are read from the file again if
+    // touched later, so reading a large file chunk by chunk and releasing
+    // each chunk keeps the resident size bounded by the chunk size.
+    void Release(size_t offset, size_t size) const;
+
+private:
+    MappedFile(const char *data, size_t size) : _data(data), _size(size) {}
+
+    const char *_data;
+    size_t _size;
+};
+
+} // namespace common
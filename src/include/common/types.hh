@@ -1,5 +1,7 @@
 #pragma once
 #include <stdlib.h>
+#include <cstdint>
+#include <iostream>
 
 typedef uint64_t uint64;
 typedef int64_t int64;
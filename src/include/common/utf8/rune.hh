@@ -3,6 +3,7 @@
 #include <cctype>
 #include <cstdint>
 #include <string>
+#include <string_view>
 
 #include "utf8proc.h"
 
@@ -165,29 +166,29 @@ codepoint_t decode(const char *str, size_t length);
 
 // full_rune reports whether the bytes in p begin with a full UTF-8 encoding of a rune.
 // An invalid encoding is considered a full Rune since it will convert as a width-1 error rune.
-inline bool full_rune(std::string p) {
+inline bool full_rune(std::string_view p) {
 	auto n = p.size();
 	if (n == 0) {
 		return false;
 	}
 
-	auto x = s_utf8_first[p[0]];
-	if (n >= int(x&7)) {
+	auto x = s_utf8_first[uint8_t(p[0])];
+	if (n >= size_t(x&7)) {
 		return true; // ASCII, invalid or valid.
 	}
 	// Must be short or invalid.
 	auto accept = s_utf8_accept_ranges[x>>4];
-	if (n > 1 && (p[1] < accept.low || accept.high < p[1])) {
+	if (n > 1 && (uint8_t(p[1]) < accept.low || accept.high < uint8_t(p[1]))) {
 		return true;
-	} else if ((n > 2) && (p[2] < 0x80 || 0xbf < p[2])) {
+	} else if ((n > 2) && (uint8_t(p[2]) < 0x80 || 0xbf < uint8_t(p[2]))) {
 		return true;
 	}
 	return false;
 }
 
-inline std::pair<rune_t, int> decode_rune(std::string dr) {
+inline std::pair<rune_t, int> decode_rune(std::string_view dr) {
     auto cp = decode(dr.data(), dr.size());
-    return {cp.value, cp.width};
+    return {cp.value, int(cp.width)};
 }
 
 }  // namespace common::utf8
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "syntax/ast/nodes.hh"
+#include "syntax/types/check.hh"
+
+// The static call graph of a package, shared by the analyses that process
+// functions bottom-up.
+namespace compile {
+
+// IsType reports whether e, an expression of a package checked by check,
+// denotes a type.
+bool IsType(const types::Checker &check, ast::ExprNode *e);
+
+// StaticCallee returns the function or method that call, in a package
+// checked by check, always calls, or nil: calls of declared and imported
+// functions by name and of methods on values of concrete types are
+// static, calls through function values, interfaces and built-ins are not.
+// For a method expression T.m(x), the receiver is the first argument.
+types::Object *StaticCallee(const types::Checker &check, const ast::CallExpr *call);
+
+// CallGraph is the graph of the static calls between the functions and
+// methods a package declares with bodies. Calls of functions of other
+// packages have no edges.
+struct CallGraph {
+    std::vector<ast::FuncDecl *> Funcs;
+    std::vector<types::Object *> Objects;   // parallel to Funcs; nil if not resolved
+    std::vector<std::vector<size_t>> Calls; // the callees of each function, in call order
+    std::unordered_map<const types::Object *, size_t> Index; // function -> index in Funcs
+
+    // Build builds the call graph of files, checked by check.
+    static CallGraph Build(const types::Checker &check, std::span<ast::File *const> files);
+
+    // Components returns the strongly connected components of the graph,
+    // callees before callers, each sorted by index.
+    std::vector<std::vector<size_t>> Components() const;
+    // Recursive reports whether the functions of a component call each
+    // other, or the only one calls itself.
+    bool Recursive(std::span<const size_t> component) const;
+};
+
+} // namespace compile
@@ -0,0 +1,147 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "compile/inline.hh"
+#include "syntax/ast/nodes.hh"
+#include "syntax/types/check.hh"
+
+// Devirtualization. A method call through an interface value whose
+// dynamic type is known is made directly, which saves the indirect call
+// and lets the inliner inline the method.
+//
+// The devirtualizer follows cmd/compile/internal/devirtualize, with the
+// local type flow of its static pass. Within a function, the dynamic type
+// of an interface value is that of the concrete value converted to the
+// interface, of the local variable it is read from if every value the
+// function assigns to the variable has the same dynamic type, or of the
+// result of an inlined call, which is computed from its body with the
+// dynamic types of the arguments. Variables whose address is taken, the
+// parameters and the package-level variables may hold anything. Calls in
+// the bodies the inliner inlines are devirtualized per call site as well,
+// with the dynamic types of the arguments of the site.
+//
+// A call whose receiver may have several dynamic types is devirtualized
+// under a guard if a profile shows that one type receives most of its
+// calls, as cmd/compile does with PGO: the call is made directly if the
+// receiver holds that type, and through the interface otherwise.
+//
+// A devirtualized call keeps the semantics of the interface call: the
+// receiver is asserted to its dynamic type, which panics if it is nil.
+// There is no intermediate representation to rewrite yet, so, like the
+// inliner, the devirtualizer produces a plan, and it adds the direct calls
+// it can inline to the inlining plan.
+namespace compile {
+
+// GuardedDevirtMinPercent is the share of the calls of a call site the
+// hottest dynamic type of the profile must receive for guarded
+// devirtualization.
+constexpr int GuardedDevirtMinPercent = 75;
+
+// CallProfile is a profile of the dynamic callees of interface calls. A
+// call site is identified by its function and its line relative to the
+// line the function is declared on, so that a profile stays valid as code
+// moves around the function. Functions and methods are named by import
+// path: "path.F", "path.T.m" or "path.(*T).m".
+class CallProfile {
+public:
+    // Edge is a callee of a call site and the number of calls to it.
+    struct Edge {
+        std::string Callee;
+        uint64_t Count = 0;
+    };
+
+    // Parse parses a profile in text form, one edge per line:
+    //
+    //     caller offset callee count
+    //
+    // where offset is the line of the call site relative to the caller.
+    // Blank lines and lines starting with # are ignored. It returns
+    // nothing and sets error for a malformed line.
+    static std::optional<CallProfile> Parse(std::string_view text, std::string &error);
+
+    // Callees returns the callees of a call site, the most called first.
+    std::span<const Edge> Callees(std::string_view caller, int offset) const;
+    size_t Size() const { return _sites.size(); }
+
+private:
+    std::unordered_map<std::string, std::vector<Edge>> _sites; // "caller offset" -> callees
+};
+
+// DevirtCall is the plan for an interface call made directly.
+struct DevirtCall {
+    types::Object *Method = nullptr; // the method called
+    types::TypeId Type = 0;          // the dynamic type of the receiver
+    // Guarded is set if the type comes from the profile: the call is made
+    // directly only if the receiver holds Type.
+    bool Guarded = false;
+};
+
+// DevirtDecision reports a devirtualized call.
+struct DevirtDecision {
+    syntax::Pos Pos;
+    std::string Call;   // the call, e.g. "w.Write"
+    std::string Type;   // the dynamic type, e.g. "*bytes.Buffer"
+    std::string Method; // the method called, e.g. "(*bytes.Buffer).Write"
+    bool Guarded = false;
+
+    // Message formats the decision as the Go compiler's -m flag does, e.g.
+    // "devirtualizing w.Write to *bytes.Buffer" or "PGO devirtualizing
+    // interface call w.Write to (*bytes.Buffer).Write".
+    std::string Message() const;
+};
+
+// Devirtualizer plans the devirtualization of the interface calls of a
+// type-checked package.
+class Devirtualizer {
+public:
+    // path is the import path of the package. The direct calls are added
+    // to the plan of inliner, if set, which must have analyzed the
+    // package; guarded calls are planned from profile, if set.
+    Devirtualizer(const types::Checker &check, std::string path, Inliner *inliner = nullptr,
+                  const CallProfile *profile = nullptr);
+
+    // Analyze analyzes the functions of files, which must have been
+    // checked without errors, and returns the decisions sorted by
+    // position.
+    const std::vector<DevirtDecision> &Analyze(std::span<ast::File *const> files);
+    const std::vector<DevirtDecision> &Decisions() const { return _decisions; }
+
+    // Devirtualized returns the plan for the interface call call, or nil
+    // if it stays indirect. For a call in the body of a function inlined
+    // at the call site, the plan is that of the inlined copy.
+    const DevirtCall *Devirtualized(const ast::CallExpr *call, const ast::CallExpr *site = nullptr) const;
+
+    struct Flow;
+
+private:
+    struct pairHash {
+        size_t operator()(const std::pair<const ast::CallExpr *, const ast::CallExpr *> &p) const {
+            return std::hash<const void *>()(p.first) * 31 + std::hash<const void *>()(p.second);
+        }
+    };
+
+    void analyze(ast::FuncDecl *decl);
+    void guarded(ast::FuncDecl *decl, const ast::CallExpr *call);
+    bool resolve(std::string_view callee, types::TypeId &type, common::SymbolId &method) const;
+    void add(const types::Checker &check, const ast::CallExpr *call, const ast::CallExpr *site, DevirtCall d,
+             bool spawned);
+    std::string typeName(const types::Checker &check, types::TypeId t) const;
+    std::string funcName(ast::FuncDecl *decl) const;
+
+    const types::Checker &_check;
+    std::string _path;
+    Inliner *_inliner;
+    const CallProfile *_profile;
+    std::unordered_map<std::pair<const ast::CallExpr *, const ast::CallExpr *>, DevirtCall, pairHash> _calls;
+    std::vector<DevirtDecision> _decisions;
+    std::vector<DirectCall> _direct; // the direct calls to inline
+};
+
+} // namespace compile
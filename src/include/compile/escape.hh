@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "syntax/ast/nodes.hh"
+#include "syntax/types/check.hh"
+#include "syntax/types/export.hh"
+
+// Escape analysis. It decides, for each value a function allocates, whether
+// the value can live in the function's stack frame or must be allocated on
+// the heap because a reference to it may outlive the frame.
+//
+// The analysis follows cmd/compile/internal/escape. The function bodies of
+// a package are turned into a graph whose nodes are locations (variables,
+// allocations, results and the heap) and whose edges are assignments
+// between them, each labeled with the number of dereferences applied to
+// the source: -1 for &x, 0 for a copy, 1 for *p. A value is heap allocated
+// if its address flows, by a path whose dereferences sum to less than 0,
+// into a location that outlives it: the heap, a result, a variable
+// declared outside the loop it is allocated in, or a variable of an
+// enclosing function if it is allocated in a closure.
+//
+// Functions are analyzed bottom-up over the static call graph, one strongly
+// connected component at a time, so a call to a function analyzed before
+// uses its summary: for each parameter, whether it leaks to the heap or to
+// a result, and with how many dereferences. The summaries of the functions
+// of a package go into its export data, so calls to the functions of the
+// packages it imports use theirs too. Calls through function values,
+// interfaces and functions without a summary are assumed to leak their
+// arguments to the heap.
+//
+// A closure captures a variable by value if the variable is small, its
+// address is never taken and it is not reassigned after the closure is
+// created; other captured variables are referenced by the closure.
+namespace compile {
+
+// EscapeDecision is the verdict on one allocation site or parameter.
+struct EscapeDecision {
+    enum Kind : uint8_t {
+        Var,   // a variable moved to the heap because its address outlives it
+        Alloc, // an allocation: &T{...}, new, make, a literal, a closure or an interface conversion
+        Param, // a parameter of pointer type, or one containing pointers
+    };
+    Kind kind = Alloc;
+    syntax::Pos Pos;
+    const ast::Node *Site = nullptr; // the declaring name, the allocating expression, or the parameter's name
+    std::string What;                // how the site is spelled, e.g. "x", "&T{...}" or "make([]int, n)"
+    bool Heap = false;               // for a parameter, whether it leaks anywhere
+    // Leak describes where a leaking parameter leaks to: empty if it leaks
+    // to the heap, "content" if what it points to does, or e.g. "to result
+    // ~r0 level=0".
+    std::string Leak;
+    // Explain holds the flow that forces a site to the heap, from the
+    // site to the location that outlives it, if explanations were asked
+    // for.
+    std::vector<std::string> Explain;
+
+    // Message formats the decision as the Go compiler's -m flag does, e.g.
+    // "moved to heap: x", "&T{...} does not escape" or "leaking param: p".
+    std::string Message() const;
+};
+
+// ParamLeaks summarizes where the value of a parameter flows once the
+// function returns: Heap and Results hold the least number of
+// dereferences applied on a path to the heap and to each result, or -1 if
+// there is none. A parameter leaking to a result at level 0 is returned
+// as is; at level 1, what it points to is returned.
+struct ParamLeaks {
+    int Heap = -1;
+    std::vector<int> Results;
+
+    bool Leaks() const;
+};
+
+// EscapeAnalysis analyzes the function bodies of a type-checked package.
+class EscapeAnalysis {
+public:
+    explicit EscapeAnalysis(const types::Checker &check) : _check(check) {}
+    ~EscapeAnalysis();
+    EscapeAnalysis(const EscapeAnalysis &) = delete;
+    EscapeAnalysis &operator=(const EscapeAnalysis &) = delete;
+
+    // Analyze analyzes the functions of files, which must have been
+    // checked without errors, and returns the decisions sorted by
+    // position. With explain, each decision to allocate on the heap
+    // records why.
+    std::vector<EscapeDecision> Analyze(std::span<ast::File *const> files, bool explain = false);
+
+    // OnHeap reports whether the allocation at site, an expression of a
+    // decision of kind Alloc, is heap allocated; sites that were not
+    // analyzed are.
+    bool OnHeap(const ast::Node *site) const;
+    // Moved reports whether the local variable var is heap allocated.
+    bool Moved(const types::Object *var) const;
+
+    // Leaks returns the summary of the parameters, receiver first, of the
+    // function or method fn declared by the package, or nil.
+    const std::vector<ParamLeaks> *Leaks(const types::Object *fn) const;
+    // Exports returns the summaries of the functions and methods of the
+    // package for its export data.
+    types::LeakSummaries Exports() const;
+
+    struct Location;
+    struct Batch;
+
+private:
+    // summary returns the summary of fn, decoding that of an imported
+    // function from its export data the first time, or nil.
+    const std::vector<ParamLeaks> *summary(const types::Object *fn);
+
+    const types::Checker &_check;
+    std::unordered_map<const ast::Node *, bool> _sites; // allocation site -> on the heap
+    std::unordered_map<const types::Object *, bool> _vars;
+    std::unordered_map<const types::Object *, std::vector<ParamLeaks>> _leaks;
+};
+
+// MaxStackVarSize is the size of the largest variable kept on the stack;
+// MaxImplicitStackVarSize that of the largest implicit allocation, such as
+// new(T), &T{...} or the backing array of make([]T, n).
+constexpr int64_t MaxStackVarSize = 128 << 10;
+constexpr int64_t MaxImplicitStackVarSize = 64 << 10;
+
+} // namespace compile
@@ -0,0 +1,173 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "syntax/ast/nodes.hh"
+#include "syntax/types/check.hh"
+#include "syntax/types/export.hh"
+
+// Inlining. A call of a small function is replaced by the body of the
+// function, which saves the call and lets the later analyses see through
+// it.
+//
+// The inliner follows cmd/compile/internal/inline. The cost of a function
+// is the number of syntax nodes of its body, where a call costs
+// InlineExtraCallCost more, unless the callee is inlinable itself: then it
+// costs what the callee costs, so a function whose calls are all inlined
+// can be inlined in turn (mid-stack inlining). Functions are analyzed
+// bottom-up over the static call graph for this. A function is inlinable
+// if it costs at most the budget, is not recursive, and contains nothing
+// the inliner does not handle: function literals, go, defer, select,
+// labels or recover. Generic functions are not inlined, but the calls in
+// their bodies are, and so are the interface calls the devirtualizer
+// makes direct, see devirt.hh.
+//
+// There is no intermediate representation to rewrite yet, so the inliner
+// produces a plan that code generation expands: for each call it inlines,
+// the body to inline and the arguments of its parameters. The call
+// evaluates its arguments into fresh copies of the parameters, then runs
+// the statements of the body, whose returns assign the results and leave
+// it; the arguments of a variadic parameter are packed into a new slice.
+// Bodies of assignments, expression statements, variable declarations, if
+// statements, for and range loops with their breaks and continues, and
+// returns are inlined, which covers getters, setters, predicates, small
+// helpers and loops over slices; a function with a switch is not, but
+// calls of it cost what it costs, as gc inlines it. Calls in the bodies
+// inlined are planned too.
+//
+// The bodies of the inlinable functions of a package are written to its
+// export data, so that its importers inline them as well. An imported
+// body is parsed and checked against the objects of its package the first
+// time a call of it is planned.
+namespace compile {
+
+// InlineMaxBudget is the default budget of an inlinable function.
+constexpr int InlineMaxBudget = 80;
+// InlineExtraCallCost is the cost of a call that is not inlined.
+constexpr int InlineExtraCallCost = 57;
+// A function of more than InlineBigFunctionNodes nodes only inlines
+// callees costing at most InlineBigFunctionMaxCost, since it grows beyond
+// what later phases handle well.
+constexpr int InlineBigFunctionNodes = 5000;
+constexpr int InlineBigFunctionMaxCost = 20;
+
+// InlineBody is the body of an inlinable function.
+struct InlineBody {
+    int Cost = 0;
+    const types::Checker *Check = nullptr; // the checker of the body's package, or of an imported body
+    ast::FuncDecl *Decl = nullptr;
+    // Result is the expression returned if the body is a single return
+    // statement of one value, and nil otherwise.
+    ast::ExprNode *Result = nullptr;
+    // Params are the parameters, the receiver of a method first, and
+    // Results the results; nil for unnamed and blank ones.
+    std::vector<types::Object *> Params;
+    std::vector<types::Object *> Results;
+    bool Variadic = false; // the last parameter is variadic
+};
+
+// InlinedCall is the plan for a call to inline.
+struct InlinedCall {
+    types::Object *Callee = nullptr;
+    const InlineBody *Body = nullptr;
+    // Args are the arguments of Body->Params, the receiver of a method
+    // call first. The receiver x of a call x.m() is passed as &x if m has
+    // a pointer receiver and x is not a pointer, and as *x in the reverse
+    // case.
+    std::vector<ast::ExprNode *> Args;
+    // Packed are the arguments of the variadic parameter of a call without
+    // ..., whose argument in Args is nil: they are passed as a new slice,
+    // or a nil one if there are none.
+    std::vector<ast::ExprNode *> Packed;
+    bool AddrRecv = false;
+    bool DerefRecv = false;
+    // Assert is the dynamic type of the receiver of a devirtualized
+    // interface call: the receiver x, an interface value, is passed as
+    // x.(Assert), or *x.(Assert) if DerefRecv is set.
+    types::TypeId Assert = 0;
+};
+
+// DirectCall is an interface method call made directly on a receiver of
+// the dynamic type Recv.
+struct DirectCall {
+    const ast::CallExpr *Call = nullptr;
+    types::Object *Method = nullptr;
+    types::TypeId Recv = 0;
+};
+
+// InlineDecision is a decision on a function or a call.
+struct InlineDecision {
+    enum Kind : uint8_t {
+        CanInline,    // the function is inlinable
+        CannotInline, // the function is not, for Reason
+        Call,         // the call is inlined
+    };
+    Kind kind = CanInline;
+    syntax::Pos Pos;
+    std::string Func; // the function or callee, e.g. "f", "(*T).m" or "pkg.F"
+    int Cost = 0;
+    std::string Reason;
+
+    // Message formats the decision as the Go compiler's -m flag does, e.g.
+    // "can inline f with cost 4", "cannot inline f: recursive" or
+    // "inlining call to f".
+    std::string Message() const;
+};
+
+// Inliner plans the inlining in the function bodies of a type-checked
+// package.
+class Inliner {
+public:
+    // A budget of 0 disables inlining.
+    explicit Inliner(const types::Checker &check, int budget = InlineMaxBudget);
+    ~Inliner();
+    Inliner(const Inliner &) = delete;
+    Inliner &operator=(const Inliner &) = delete;
+
+    // Analyze analyzes the functions of files, which must have been
+    // checked without errors, plans the calls to inline and returns the
+    // decisions sorted by position.
+    const std::vector<InlineDecision> &Analyze(std::span<ast::File *const> files);
+    const std::vector<InlineDecision> &Decisions() const { return _decisions; }
+
+    // Body returns the inlinable body of the function or method fn, of
+    // the package or an imported one, or nil. An imported body is loaded
+    // on first use.
+    const InlineBody *Body(types::Object *fn);
+    // Inlined returns the plan for call, or nil if it is not inlined.
+    const InlinedCall *Inlined(const ast::CallExpr *call) const;
+    // InlineDirect plans the inlining of the interface method calls of
+    // the package the devirtualizer makes direct, those whose method is
+    // inlinable; for a guarded call, the plan is that of the direct branch.
+    void InlineDirect(std::span<const DirectCall> calls);
+
+    // Exports returns the bodies of the inlinable functions of the package
+    // in the form of its export data.
+    types::InlineBodies Exports() const;
+
+    struct Imported;
+
+private:
+    struct Func;
+
+    int cost(Func &f);
+    void plan(const types::Checker &check, ast::FuncDecl *decl, bool report);
+    const InlineBody *load(types::Object *fn);
+    std::string name(const types::Checker &check, types::Object *fn, types::TypeId recv) const;
+
+    const types::Checker &_check;
+    int _budget;
+    std::unordered_map<const types::Object *, std::unique_ptr<InlineBody>> _bodies; // nil while loading
+    // _shaped holds the costs of the functions within the budget whose
+    // bodies the inliner cannot expand, but gc would inline.
+    std::unordered_map<const types::Object *, int> _shaped;
+    std::unordered_map<const ast::CallExpr *, InlinedCall> _calls;
+    std::vector<std::unique_ptr<Imported>> _imported;
+    std::vector<InlineDecision> _decisions;
+};
+
+} // namespace compile
@@ -0,0 +1,186 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <libcuckoo/cuckoohash_map.hh>
+
+#include "syntax/ast/nodes.hh"
+#include "syntax/types/check.hh"
+#include "syntax/types/export.hh"
+
+// Instantiation of generic functions by GC shape stenciling with
+// dictionaries.
+//
+// A generic function is compiled once per shape of its type arguments
+// rather than once per instance, following cmd/compile's implementation
+// of generics. The shape of a type is what the code generated for it
+// depends on: its underlying type, where all pointer-shaped types (pointers,
+// unsafe.Pointer, maps, channels and functions) share the shape *uint8.
+// So F[int] and F[MyInt] share the stencil F[go.shape.int], and F[*T],
+// F[map[K]V] and F[chan E] all share F[go.shape.*uint8].
+//
+// What the stencil cannot know from the shape is passed in a dictionary,
+// one per instance: the type arguments and the types derived from them
+// that the body needs at run time (for make, new, composite literals,
+// conversions to interfaces and type assertions), the methods it calls on
+// type parameters, the itabs of its conversions to non-empty interfaces
+// and the dictionaries of the generic functions it calls in turn. The
+// layout of these entries is computed once per generic function from its
+// body; the dictionary of an instance substitutes its type arguments.
+//
+// There is no intermediate representation to generate code from yet, so
+// the stenciler produces a plan, like the inliner: the stencils a package
+// generates and the dictionaries of its instances. The layouts of the
+// generic functions of a package are written to its export data, so that
+// its importers build the dictionaries of their instances without the
+// bodies. The stencils of a build are shared through an InstanceCache: the
+// first package of the build to need a stencil generates it, and the
+// packages needing it later refer to that one, which keeps the size of
+// the code linear in the number of shapes rather than of instances.
+namespace compile {
+
+// ShapeOf returns the GC shape of the type t.
+types::TypeId ShapeOf(types::TypeId t);
+
+// DictEntry is an entry of a dictionary, or of the layout of the
+// dictionaries of a generic function, where its types refer to the type
+// parameters.
+struct DictEntry {
+    enum Kind : uint8_t {
+        TypeDesc, // the type descriptor of Type
+        Method,   // the method Name of Type, called on a type parameter
+        Itab,     // the itab of Type converted to the interface Iface
+        SubDict,  // the dictionary of Callee instantiated with TypeArgs
+    };
+    Kind kind = TypeDesc;
+    types::TypeId Type = 0;
+    types::TypeId Iface = 0;
+    std::string Name; // of a method, or of a subdictionary once resolved
+    types::Object *Callee = nullptr;
+    std::vector<types::TypeId> TypeArgs;
+
+    bool operator==(const DictEntry &) const = default;
+};
+
+// GenericFunc is a generic function of the package or an imported one,
+// with the layout of its dictionaries.
+struct GenericFunc {
+    types::Object *Func = nullptr;
+    std::string Name; // the linker name of the function: "path.F"
+    // TParams are the type parameters Layout refers to: Func->TParams, or
+    // those of the signature decoded with the layout of an imported
+    // function.
+    std::vector<types::TypeId> TParams;
+    // Layout lists the entries of the dictionaries, the type arguments
+    // first.
+    std::vector<DictEntry> Layout;
+};
+
+// Stencil is the code of a generic function for one shape of its type
+// arguments.
+struct Stencil {
+    const GenericFunc *Generic = nullptr;
+    std::vector<types::TypeId> Shapes;
+    std::string Name; // e.g. "path.F[go.shape.int]"
+    // Owner is the import path of the package of the build that generates
+    // the stencil: the first one to need it.
+    std::string Owner;
+};
+
+// Dictionary is the dictionary of an instance.
+struct Dictionary {
+    std::string Name; // e.g. "path.F[int]"
+    const Stencil *Code = nullptr;
+    std::vector<types::TypeId> TypeArgs;
+    // Entries is the layout of the generic function with the type
+    // arguments substituted; the Name of a subdictionary is resolved.
+    std::vector<DictEntry> Entries;
+};
+
+// InstanceCache is the set of the stencils of a build, shared by the
+// stencilers of its packages, which may run concurrently.
+class InstanceCache {
+public:
+    // Claim claims the stencil named name for the package pkg and returns
+    // the package that generates it: pkg if it is the first to claim it.
+    std::string Claim(const std::string &name, std::string_view pkg);
+    size_t Size() const { return _owners.size(); }
+
+private:
+    cuckoohash_map<std::string, std::string> _owners{64};
+};
+
+// StencilReport reports how an instance of a generic function is
+// compiled.
+struct StencilReport {
+    syntax::Pos Pos;
+    std::string Instance; // e.g. "F[int]" or "lib.F[int]"
+    const Stencil *Code = nullptr;
+    bool New = false;       // the first instance of the package with its stencil
+    bool Elsewhere = false; // the stencil is generated by another package
+
+    // Message formats the report, e.g. "instantiating F[int] with new
+    // stencil p.F[go.shape.int]" or "instantiating lib.F[*T] with stencil
+    // lib.F[go.shape.*uint8] of package app".
+    std::string Message() const;
+};
+
+// Stenciler plans the instantiation of the generic functions of a
+// type-checked package.
+class Stenciler {
+public:
+    // path is the import path of the package. The stencils are shared
+    // with the other packages of the build through cache, if set.
+    Stenciler(const types::Checker &check, std::string path, InstanceCache *cache = nullptr);
+    ~Stenciler();
+    Stenciler(const Stenciler &) = delete;
+    Stenciler &operator=(const Stenciler &) = delete;
+
+    // Analyze computes the layouts of the generic functions of files,
+    // which must have been checked without errors, then the stencils and
+    // dictionaries of their instances, and returns the reports sorted by
+    // position.
+    const std::vector<StencilReport> &Analyze(std::span<ast::File *const> files);
+    const std::vector<StencilReport> &Reports() const { return _reports; }
+
+    // Generic returns the generic function fn, of the package or an
+    // imported one, or nil. The layout of an imported function is decoded
+    // on first use.
+    const GenericFunc *Generic(types::Object *fn);
+    // DictOf returns the dictionary of the instance named by name, or nil.
+    const Dictionary *DictOf(const ast::Name *name) const;
+    // Stencils returns the stencils the package needs, in the order they
+    // were first needed; those owned by another package are not generated.
+    std::span<const std::unique_ptr<Stencil>> Stencils() const { return _stencils; }
+    std::span<const std::unique_ptr<Dictionary>> Dictionaries() const { return _dicts; }
+
+    // Exports returns the layouts of the generic functions of the package
+    // in the form of its export data.
+    types::InlineBodies Exports() const;
+
+    struct Imported;
+
+private:
+    GenericFunc *layout(types::Object *fn, ast::FuncDecl *decl);
+    const GenericFunc *load(types::Object *fn);
+    const Dictionary *instantiate(types::Object *fn, std::span<const types::TypeId> targs);
+    std::string funcName(types::Object *fn) const;
+
+    const types::Checker &_check;
+    std::string _path;
+    InstanceCache *_cache;
+    std::unordered_map<const types::Object *, std::unique_ptr<GenericFunc>> _generics; // nil while loading
+    std::unordered_map<std::string, Stencil *> _stencilsByName;
+    std::unordered_map<std::string, Dictionary *> _dictsByName;
+    std::unordered_map<const ast::Name *, const Dictionary *> _instances;
+    std::vector<std::unique_ptr<Stencil>> _stencils;
+    std::vector<std::unique_ptr<Dictionary>> _dicts;
+    std::vector<std::unique_ptr<Imported>> _imported;
+    std::vector<StencilReport> _reports;
+};
+
+} // namespace compile
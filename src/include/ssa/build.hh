@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+
+#include "compile/devirt.hh"
+#include "compile/escape.hh"
+#include "ssa/func.hh"
+#include "syntax/ast/nodes.hh"
+#include "syntax/types/check.hh"
+
+// Construction of the SSA form of a function from its typed syntax tree.
+//
+// The builder follows Braun et al., "Simple and Efficient Construction of
+// Static Single Assignment Form", as cmd/compile's does: it lowers the
+// statements in order, and a read of a local variable looks up its
+// definition in the current block and, recursively, in the predecessors,
+// placing a Phi where definitions merge. A block is sealed once all its
+// predecessors are known; the Phis of a loop header are completed then.
+// Phis that turn out to select a single value are removed at the end.
+//
+// The memory is a variable of its own, so that the loads, stores and
+// calls of a function are ordered by their memory operands. Local
+// variables of scalar, pointer, slice, string, interface, map, channel
+// and function types, and of structs of at most four such fields, live in
+// SSA values, unless their address is taken; the others are allocated where
+// they are declared, and read and written through their address. These
+// variables and the values of new, &T{...}, slice literals and the
+// arguments of variadic parameters are allocated in the frame by an Alloc
+// if escape analysis proves they do not outlive it, and by a HeapAlloc
+// otherwise.
+//
+// Interface calls the devirtualizer resolves become static calls of the
+// method of the dynamic type: the receiver is asserted to hold the type,
+// and for a guarded call the interface call remains for the other types.
+// The inlining plan is not applied yet: inlined calls stay calls.
+//
+// Checks the language requires at run time are explicit: indexing and
+// slicing branch to a block that panics with PanicBounds if an index is
+// out of range, and a NilCheck precedes every dereference, so that the
+// passes can remove the checks they prove redundant. Operations the
+// runtime implements, such as map accesses, appends and channel
+// operations, are RuntimeCalls.
+namespace ssa {
+
+// Build lowers the body of decl, a function or method of a package
+// checked by check without errors, to SSA form in f, which is reset
+// first. It returns false and sets reason, if set, if the body uses what
+// the builder does not lower yet: closures, method values, defer, go and
+// select statements, type switches, goto, recover, complex numbers, map
+// literals, conversions of slices to arrays, ranging over anything but
+// integers, arrays and slices, the address of the variable of a
+// three-clause loop, and generic functions.
+//
+// escape and devirt, if set, are the plans of the package of decl;
+// without escape, the variables whose address is taken and what new and
+// the literals allocate are on the heap.
+bool Build(Func &f, const types::Checker &check, ast::FuncDecl *decl, std::string *reason = nullptr,
+           const compile::EscapeAnalysis *escape = nullptr, const compile::Devirtualizer *devirt = nullptr);
+
+// FuncName returns the name of the function declared by decl, as in
+// "F", "T.m" or "(*T).m".
+std::string FuncName(const ast::FuncDecl *decl);
+
+} // namespace ssa
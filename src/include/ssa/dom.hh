@@ -0,0 +1,48 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "ssa/func.hh"
+
+namespace ssa {
+
+// DomTree is the dominator tree of the reachable blocks of a function,
+// computed with the iterative algorithm of Cooper, Harvey and Kennedy, "A
+// Simple, Fast Dominance Algorithm". Its arrays are indexed by block ID,
+// and Dominates is a constant-time test on the preorder and postorder
+// numbers of the tree. It is invalidated by any change to the edges.
+class DomTree {
+public:
+    explicit DomTree(const Func &f);
+
+    // Idom returns the immediate dominator of b, nil for the entry and the
+    // unreachable blocks.
+    Block *Idom(const Block *b) const { return _idom[b->Id]; }
+    // Dominates reports whether a dominates b; a block dominates itself.
+    bool Dominates(const Block *a, const Block *b) const {
+        return _pre[a->Id] <= _pre[b->Id] && _post[b->Id] <= _post[a->Id] && Reachable(b);
+    }
+    bool Reachable(const Block *b) const { return b->Id < _rpoIndex.size() && _rpoIndex[b->Id] != unreachable; }
+    // Children returns the blocks b immediately dominates.
+    std::span<Block *const> Children(const Block *b) const {
+        return {_children.data() + _childStart[b->Id], _children.data() + _childStart[b->Id + 1]};
+    }
+    // ReversePostorder returns the reachable blocks in reverse postorder,
+    // in which a block comes after its dominators.
+    std::span<Block *const> ReversePostorder() const { return _rpo; }
+    // Preorder returns the reachable blocks in a preorder of the tree.
+    std::span<Block *const> Preorder() const { return _preorder; }
+
+private:
+    static constexpr uint32_t unreachable = ~uint32_t(0);
+
+    std::vector<Block *> _rpo;
+    std::vector<uint32_t> _rpoIndex;
+    std::vector<Block *> _idom;
+    std::vector<uint32_t> _childStart; // Children(b) is _children[_childStart[b]:_childStart[b+1]]
+    std::vector<Block *> _children;
+    std::vector<Block *> _preorder;
+    std::vector<uint32_t> _pre, _post;
+};
+
+} // namespace ssa
@@ -0,0 +1,295 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/arena.hh"
+#include "ssa/op.hh"
+#include "syntax/pos.hh"
+#include "syntax/types/object.hh"
+
+// The SSA intermediate representation, the form the optimization passes
+// work on. It follows cmd/compile/internal/ssa: a function is a control
+// flow graph of blocks, each a list of values, and each value is an
+// operation applied to other values, defined once. Where control flow
+// merges, a Phi value selects the definition of the predecessor control
+// came from.
+//
+// The layout is chosen for compile speed. All the values and blocks of a
+// function and their operand lists come from the arena of the function,
+// and are freed together when it is reset for the next function. Values
+// and blocks are numbered densely from 0 in the order they are created,
+// so an analysis keeps its facts in flat arrays and bitsets indexed by ID
+// instead of hash maps; the numbers are not reused while the function
+// lives. The operands of a value and the edges of a block are held
+// inline, as most values have at most three operands and most blocks at
+// most two predecessors, and only longer lists spill to the arena.
+namespace ssa {
+
+using ID = uint32_t;
+using types::TypeId;
+
+// TypeMem is the type of memory values; values without a result have
+// type 0.
+constexpr TypeId TypeMem = ~TypeId(0);
+
+struct Value;
+struct Block;
+class Func;
+
+// List is a list of arena objects whose first N elements are stored
+// inline. It grows into an arena and never frees; it must not be copied,
+// as the inline elements would not follow.
+template <typename T, uint32_t N>
+class List {
+public:
+    List() = default;
+    List(const List &) = delete;
+    List &operator=(const List &) = delete;
+
+    T *begin() { return _data; }
+    T *end() { return _data + _size; }
+    const T *begin() const { return _data; }
+    const T *end() const { return _data + _size; }
+    uint32_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    T &operator[](size_t i) { return _data[i]; }
+    const T &operator[](size_t i) const { return _data[i]; }
+    T &back() { return _data[_size - 1]; }
+    std::span<T> span() { return {_data, _size}; }
+    std::span<const T> span() const { return {_data, _size}; }
+
+    void push_back(common::Arena &arena, T x) {
+        if (_size == _cap) {
+            grow(arena);
+        }
+        _data[_size++] = x;
+    }
+    void insert(common::Arena &arena, size_t i, T x) {
+        push_back(arena, x);
+        for (size_t j = _size - 1; j > i; j--) {
+            _data[j] = _data[j - 1];
+        }
+        _data[i] = x;
+    }
+    // erase removes the i-th element, keeping the order of the others.
+    void erase(size_t i) {
+        for (size_t j = i + 1; j < _size; j++) {
+            _data[j - 1] = _data[j];
+        }
+        _size--;
+    }
+    void truncate(size_t n) { _size = uint32_t(n); }
+    void clear() { _size = 0; }
+
+private:
+    void grow(common::Arena &arena) {
+        auto data = static_cast<T *>(arena.Allocate(sizeof(T) * _cap * 2, alignof(T)));
+        for (uint32_t i = 0; i < _size; i++) {
+            data[i] = _data[i];
+        }
+        _data = data;
+        _cap *= 2;
+    }
+
+    T *_data = _inline.data();
+    uint32_t _size = 0;
+    uint32_t _cap = N;
+    std::array<T, N> _inline;
+};
+
+// BitSet is a set of dense IDs, such as those of the values or the blocks
+// of a function.
+class BitSet {
+public:
+    explicit BitSet(ID n = 0) : _words((n + 63) / 64) {}
+
+    // Reset empties the set and makes room for IDs below n.
+    void Reset(ID n) { _words.assign((n + 63) / 64, 0); }
+    bool Has(ID i) const { return i / 64 < _words.size() && (_words[i / 64] >> (i % 64) & 1) != 0; }
+    void Add(ID i) { _words[i / 64] |= uint64_t(1) << (i % 64); }
+    void Remove(ID i) { _words[i / 64] &= ~(uint64_t(1) << (i % 64)); }
+    // Insert adds i and reports whether it was not in the set yet.
+    bool Insert(ID i) {
+        auto &w = _words[i / 64];
+        auto bit = uint64_t(1) << (i % 64);
+        bool added = (w & bit) == 0;
+        w |= bit;
+        return added;
+    }
+    size_t Count() const;
+
+private:
+    std::vector<uint64_t> _words;
+};
+
+// Value is an operation and its operands. It lives in the arena of its
+// function, which owns it through the Values of its block.
+struct Value {
+    ID Id = 0;
+    ssa::Op Op = ssa::Op::Invalid;
+    TypeId Type = 0;
+    int64_t AuxInt = 0;
+    // Sym is the variable or function a value refers to, Str the string of
+    // a constant, the method of an interface call or the runtime function
+    // of a runtime call.
+    types::Object *Sym = nullptr;
+    std::string_view Str;
+    Block *Blk = nullptr;
+    syntax::Pos Pos{};
+    // Uses is the number of operands and control values that refer to the
+    // value.
+    uint32_t Uses = 0;
+    List<Value *, 3> Args;
+
+    void AddArg(Value *w);
+    void SetArg(size_t i, Value *w);
+    // ResetArgs drops the operands.
+    void ResetArgs();
+    // Reset turns the value into a value of op without operands or aux.
+    void Reset(ssa::Op op);
+    // CopyOf turns the value into a copy of w.
+    void CopyOf(Value *w);
+
+    bool IsMem() const { return Type == TypeMem; }
+    // Mem returns the memory operand of an operation that takes one.
+    Value *Mem() const { return Args[Args.size() - 1]; }
+    const OpInfo &Info() const { return ssa::Info(Op); }
+    // MayPanic reports whether the value may panic: its operation can, and
+    // its operands do not rule it out, as a constant divisor other than 0
+    // or a shift count that is constant or unsigned do.
+    bool MayPanic() const;
+
+    // LongString formats the value as a line of the dump of its function,
+    // e.g. "v4 = Add <int> v2 v3".
+    std::string LongString() const;
+};
+
+// BlockKind is the way control leaves a block.
+enum class BlockKind : uint8_t {
+    Invalid,
+    Plain, // to its only successor
+    If,    // to the first successor if the control value is true, else the second
+    Ret,   // returns from the function; the control value is a MakeResult
+    Exit,  // panics; the control value is the memory of the panic
+};
+
+std::string_view BlockKindName(BlockKind kind);
+
+// Block is a basic block: a list of values and the way control leaves it.
+// The values are not ordered, except by their dependencies: a value may
+// be scheduled anywhere its operands are available. The arguments of a
+// Phi are in the order of the predecessors of its block.
+struct Block {
+    ID Id = 0;
+    BlockKind Kind = BlockKind::Invalid;
+    syntax::Pos Pos{};
+    Func *Fn = nullptr;
+    Value *Control = nullptr;
+    List<Block *, 2> Succs;
+    List<Block *, 2> Preds;
+    List<Value *, 4> Values;
+
+    void SetControl(Value *v);
+    // AddEdgeTo adds an edge to c. The caller adds the arguments for the
+    // edge to the Phis of c.
+    void AddEdgeTo(Block *c);
+    // RemoveEdge removes the i-th successor edge, and the arguments of the
+    // Phis of the successor for it.
+    void RemoveEdge(size_t i);
+    // RemovePred removes the i-th predecessor edge, and the arguments of
+    // the Phis of the block for it.
+    void RemovePred(size_t i);
+
+    // LongString formats the block's header line, e.g. "b3: <- b1 b2".
+    std::string LongString() const;
+};
+
+// Func is a function in SSA form, and the arena its values and blocks
+// live in. A Func is reused for a sequence of functions: Reset frees the
+// previous one at once and starts the next.
+class Func {
+public:
+    Func() = default;
+    Func(const Func &) = delete;
+    Func &operator=(const Func &) = delete;
+
+    // Reset frees the function and starts a new, empty one.
+    void Reset(std::string_view name, TypeId sig);
+
+    std::string_view Name() const { return _name; }
+    TypeId Sig() const { return _sig; }
+    Block *Entry() const { return _blocks.empty() ? nullptr : _blocks[0]; }
+    std::span<Block *const> Blocks() const { return _blocks; }
+    // NumBlocks and NumValues bound the IDs of the blocks and values, for
+    // sizing the arrays indexed by them.
+    ID NumBlocks() const { return _next_block; }
+    ID NumValues() const { return _next_value; }
+
+    Block *NewBlock(BlockKind kind, syntax::Pos pos = {});
+    // NewValue appends a new value to b.
+    Value *NewValue(Block *b, ssa::Op op, TypeId t, std::initializer_list<Value *> args = {}, syntax::Pos pos = {});
+    Value *NewValue(Block *b, ssa::Op op, TypeId t, std::span<Value *const> args, syntax::Pos pos = {});
+    // NewPhi adds a Phi without operands to the front of b, with the other
+    // Phis, before the values that may use it.
+    Value *NewPhi(Block *b, TypeId t, syntax::Pos pos = {});
+
+    // Constants are created in the entry block.
+    Value *ConstInt(TypeId t, int64_t c);
+    Value *ConstBool(bool c);
+    Value *ConstNil(TypeId t);
+
+    // Intern copies s to the arena.
+    std::string_view Intern(std::string_view s);
+    // Pin returns data as the Str of a value without copying it, keeping
+    // its owner alive until Reset.
+    std::string_view Pin(std::shared_ptr<const void> owner, std::string_view data);
+
+    // RemoveUnreachable removes the blocks control cannot reach from the
+    // entry, and the edges and Phi arguments coming from them.
+    void RemoveUnreachable();
+    // Sweep removes the values of op, which must be unused, from all blocks.
+    void Sweep(ssa::Op op);
+
+    // Report is what a pass did at a position, for the debugging output of
+    // the driver.
+    struct Report {
+        syntax::Pos Pos;
+        std::string Msg;
+    };
+    // SetDebug makes the passes run report what they do with Warnl; Reset
+    // drops the reports.
+    void SetDebug(bool debug) { _debug = debug; }
+    bool Debug() const { return _debug; }
+    void Warnl(syntax::Pos pos, std::string msg) { _reports.push_back({pos, std::move(msg)}); }
+    std::span<const Report> Reports() const { return _reports; }
+
+    common::Arena &Mem() { return _arena; }
+    // Bytes returns the memory held by the function.
+    size_t Bytes() const { return _arena.Used() + _blocks.capacity() * sizeof(Block *); }
+
+    // String dumps the function, a block per paragraph, the way the
+    // SSA dump of the Go compiler does.
+    std::string String() const;
+    // Verify checks that the function is well formed and returns what is
+    // wrong, or an empty string.
+    std::string Verify() const;
+
+private:
+    common::Arena _arena;
+    std::string_view _name;
+    TypeId _sig = 0;
+    std::vector<Block *> _blocks;
+    ID _next_block = 0;
+    ID _next_value = 0;
+    bool _debug = false;
+    std::vector<Report> _reports;
+    std::vector<std::shared_ptr<const void>> _pinned;
+};
+
+} // namespace ssa
@@ -0,0 +1,49 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "ssa/dom.hh"
+
+namespace ssa {
+
+// Loop is a natural loop: the blocks that reach one of its back edges, the
+// edges to its header from blocks the header dominates, without passing
+// through the header.
+struct Loop {
+    Block *Header = nullptr;
+    Loop *Outer = nullptr;        // the innermost loop containing this one
+    uint32_t Depth = 1;           // 1 for an outermost loop
+    std::vector<Block *> Blocks;  // the header first, and those of the nested loops
+    std::vector<Block *> Latches; // the sources of the back edges
+    std::vector<Block *> Exits;   // the blocks with a successor outside the loop
+    bool Inner = true;            // no loop is nested in it
+
+    // Entry returns the predecessor of the header outside the loop, if it
+    // has a single one, or nil.
+    Block *Entry() const;
+};
+
+// LoopNest is the nest of the natural loops of a function, found from the
+// back edges of its dominator tree as in cmd/compile/internal/ssa. Cycles
+// entered other than through a block dominating them are not loops. Like
+// the dominator tree, it is invalidated by any change to the edges.
+class LoopNest {
+public:
+    LoopNest(const Func &f, const DomTree &dom);
+
+    // Loops returns the loops, each after the loops containing it.
+    std::span<Loop *const> Loops() const { return _order; }
+    // Of returns the innermost loop containing b, or nil.
+    Loop *Of(const Block *b) const { return b->Id < _of.size() ? _of[b->Id] : nullptr; }
+    // Contains reports whether b is in l or a loop nested in it.
+    bool Contains(const Loop *l, const Block *b) const;
+    // Invariant reports whether v is defined outside l.
+    bool Invariant(const Loop *l, const Value *v) const { return !Contains(l, v->Blk); }
+
+private:
+    std::vector<Loop> _loops;
+    std::vector<Loop *> _order;
+    std::vector<Loop *> _of;
+};
+
+} // namespace ssa
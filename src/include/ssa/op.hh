@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+// The operations of the SSA form. Like the generic operations of
+// cmd/compile/internal/ssa, they are machine independent: values are typed
+// with the types of the checker, and memory is threaded through the
+// operations that read or write it as a value of its own, so that the
+// order of the effects of a function is explicit in its data flow.
+namespace ssa {
+
+// SSA_OPS lists the operations as X(name, arity, flags, aux). An arity of
+// -1 is variable. aux is the meaning of the AuxInt of a value: None, Int,
+// Bool or Float (the bits of a float64). The named Sym and Str of a value
+// are printed whenever they are set.
+#define SSA_OPS(X)                                                                                                     \
+    X(Invalid, 0, 0, None)                                                                                             \
+    /* the memory state on entry to the function */                                                                   \
+    X(InitMem, 0, MemResult, None)                                                                                     \
+    /* the AuxInt-th parameter, receiver first; Sym is its variable, if named */                                       \
+    X(Arg, 0, 0, Int)                                                                                                  \
+    X(ConstBool, 0, 0, Bool)                                                                                           \
+    /* an integer of any size, sign-extended to 64 bits */                                                             \
+    X(ConstInt, 0, 0, Int)                                                                                             \
+    X(ConstFloat, 0, 0, Float)                                                                                         \
+    /* the string Str */                                                                                               \
+    X(ConstString, 0, 0, None)                                                                                         \
+    /* the nil pointer, slice, map, channel, function or interface */                                                  \
+    X(ConstNil, 0, 0, None)                                                                                            \
+    /* the address of the package-level variable Sym, or the function Sym as a value */                                \
+    X(Addr, 0, 0, None)                                                                                                \
+    /* the address of read-only static data holding the bytes Str */                                                  \
+    X(StaticData, 0, 0, None)                                                                                          \
+    /* the argument for the edge from the i-th predecessor of the block */                                             \
+    X(Phi, -1, 0, None)                                                                                                \
+    X(Copy, 1, 0, None)                                                                                                \
+    /* arithmetic on integers, floats and, for Add, strings */                                                         \
+    X(Add, 2, Commutative, None)                                                                                       \
+    X(Sub, 2, 0, None)                                                                                                 \
+    X(Mul, 2, Commutative, None)                                                                                       \
+    /* integer division panics if the divisor is 0 */                                                                  \
+    X(Div, 2, CanPanic, None)                                                                                          \
+    X(Mod, 2, CanPanic, None)                                                                                          \
+    X(And, 2, Commutative, None)                                                                                       \
+    X(Or, 2, Commutative, None)                                                                                        \
+    X(Xor, 2, Commutative, None)                                                                                       \
+    X(AndNot, 2, 0, None)                                                                                              \
+    /* shifts panic if the count is negative */                                                                        \
+    X(Shl, 2, CanPanic, None)                                                                                          \
+    X(Shr, 2, CanPanic, None)                                                                                          \
+    X(Neg, 1, 0, None)                                                                                                 \
+    X(Com, 1, 0, None)                                                                                                 \
+    X(Not, 1, 0, None)                                                                                                 \
+    /* comparisons; x > y is Less y x */                                                                               \
+    X(Eq, 2, Commutative, None)                                                                                        \
+    X(Neq, 2, Commutative, None)                                                                                       \
+    X(Less, 2, 0, None)                                                                                                \
+    X(Leq, 2, 0, None)                                                                                                 \
+    /* a conversion between numeric types, or between pointers, unsafe.Pointer and uintptr */                          \
+    X(Convert, 1, 0, None)                                                                                             \
+    /* aggregates: the fields of a struct, the words of slices and strings */                                          \
+    X(StructMake, -1, 0, None)                                                                                         \
+    X(StructSelect, 1, 0, Int)                                                                                         \
+    X(SliceMake, 3, 0, None)                                                                                           \
+    X(SlicePtr, 1, 0, None)                                                                                            \
+    X(SliceLen, 1, 0, None)                                                                                            \
+    X(SliceCap, 1, 0, None)                                                                                            \
+    X(StringMake, 2, 0, None)                                                                                          \
+    X(StringPtr, 1, 0, None)                                                                                           \
+    X(StringLen, 1, 0, None)                                                                                           \
+    /* the interface holding a concrete value or another interface's dynamic value */                                  \
+    X(IMake, 1, 0, None)                                                                                               \
+    /* bounds checks: 0 <= idx < len, and 0 <= idx <= len for slicing */                                               \
+    X(IsInBounds, 2, 0, None)                                                                                          \
+    X(IsSliceInBounds, 2, 0, None)                                                                                     \
+    /* memory: a new zeroed variable in the frame or on the heap, and loads and stores through pointers */             \
+    X(Alloc, 1, MemArg | NoCSE, None)                                                                                  \
+    X(HeapAlloc, 1, MemArg | NoCSE, None)                                                                              \
+    X(Load, 2, MemArg, None)                                                                                           \
+    X(Store, 3, MemArg | MemResult, None)                                                                              \
+    /* copies AuxInt bytes from the second pointer to the first */                                                     \
+    X(Move, 3, MemArg | MemResult, Int)                                                                                \
+    /* the address of the AuxInt-th field of the struct a pointer points to */                                         \
+    X(OffPtr, 1, 0, Int)                                                                                               \
+    /* the address of an element of the array a pointer points to */                                                  \
+    X(PtrIndex, 2, 0, None)                                                                                            \
+    /* panics if the pointer is nil */                                                                                 \
+    X(NilCheck, 2, MemArg | CanPanic, None)                                                                            \
+    /* control values of Exit blocks */                                                                                \
+    X(PanicBounds, 3, MemArg | MemResult | CanPanic, None)                                                             \
+    X(Panic, 2, MemArg | MemResult | CanPanic, None)                                                                   \
+    /* calls take the arguments and the memory and return the memory; SelectN picks a result */                        \
+    X(StaticCall, -1, MemArg | MemResult | CanPanic | Call, None)                                                      \
+    X(InterCall, -1, MemArg | MemResult | CanPanic | Call, None)                                                       \
+    X(ClosureCall, -1, MemArg | MemResult | CanPanic | Call, None)                                                     \
+    X(RuntimeCall, -1, MemArg | MemResult | CanPanic | Call, None)                                                     \
+    X(SelectN, 1, 0, Int)                                                                                              \
+    /* the control value of Ret blocks: the results and the memory */                                                  \
+    X(MakeResult, -1, MemArg, None)
+
+enum class Op : uint8_t {
+#define SSA_OP_ENUM(name, arity, flags, aux) name,
+    SSA_OPS(SSA_OP_ENUM)
+#undef SSA_OP_ENUM
+};
+
+// OpFlags describe the properties of an operation the passes rely on.
+enum OpFlags : uint8_t {
+    Commutative = 1 << 0, // the two arguments can be swapped
+    MemArg = 1 << 1,      // the last argument is the memory
+    MemResult = 1 << 2,   // the result is the memory
+    CanPanic = 1 << 3,    // may panic, so it cannot be executed speculatively
+    NoCSE = 1 << 4,       // two evaluations never yield the same value
+    Call = 1 << 5,
+};
+
+// AuxKind is the meaning of the AuxInt of a value.
+enum class AuxKind : uint8_t { None, Int, Bool, Float };
+
+// OpInfo describes an operation.
+struct OpInfo {
+    std::string_view Name;
+    int8_t Arity; // -1 if variable
+    uint8_t Flags;
+    AuxKind Aux;
+};
+
+// Info returns the description of op.
+const OpInfo &Info(Op op);
+
+} // namespace ssa
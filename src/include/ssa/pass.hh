@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ssa/func.hh"
+
+// The optimization passes over the SSA form, and the pass manager that
+// runs them in order. Each pass transforms a function in place and leaves
+// it well formed; the values a pass makes redundant are left for Deadcode
+// to remove.
+namespace ssa {
+
+// Deadcode removes the unreachable blocks and the values nothing live
+// depends on. The controls of blocks are live, and so are the values that
+// produce memory or may panic.
+void Deadcode(Func &f);
+
+// CopyElim replaces the uses of copies with the values copied, after
+// turning the Phis that select a single value into copies of it.
+void CopyElim(Func &f);
+
+// SCCP is the sparse conditional constant propagation of Wegman and
+// Zadeck over the integer and boolean values. Values found constant are
+// replaced by constants and the branches on constants by jumps, and the
+// blocks control never reaches are removed; Phis only merge the values
+// of the edges found executable.
+void SCCP(Func &f);
+
+// CSE replaces each value by an equivalent one that dominates it. Values
+// are equivalent if they apply the same operation to equivalent operands,
+// found by partitioning the values by operation and aux and refining the
+// partition by operands until it is stable, as the global value numbering
+// of Alpern, Wegman and Zadeck does. Memory operands are operands: two
+// loads of the same address from the same memory are equivalent.
+void CSE(Func &f);
+
+// Prove removes the bounds checks, nil checks and branches whose outcome
+// follows from the facts known where they are: the conditions of the
+// branches that dominate them, the checks made before, the limits of the
+// lengths and of the induction variables of loops. With debugging, it
+// reports each check and branch it removes.
+void Prove(Func &f);
+
+// IndVars simplifies the induction variables of loops, the Phis of their
+// headers stepped by a constant on the back edge: the exit tests are put
+// in the forms of 0 <= i < n that Prove recognizes, and the products of an
+// induction variable by a factor invariant in the loop, as in the index
+// arithmetic of a[i*n+j], are reduced to induction variables of their own
+// stepped by additions.
+void IndVars(Func &f);
+
+// LoopRotate turns the loops that test their condition in the header, as
+// for and range loops are built, into loops that test it once on entry and
+// then at the bottom of each iteration, so that an iteration takes a
+// single branch.
+void LoopRotate(Func &f);
+
+// LICM moves the values invariant in a loop to a block before it. Pure
+// computations are moved from anywhere in the loop. Those that may panic
+// or fault are moved only from where the loop always evaluates them
+// first, before any effect or panic of its own, so that they panic before
+// the loop exactly when the loop would have; this needs the loop rotated.
+void LICM(Func &f);
+
+// Pass is an optimization pass.
+struct Pass {
+    std::string_view Name;
+    void (*Run)(Func &f);
+};
+
+// Passes returns the passes a pipeline may name.
+std::span<const Pass> Passes();
+
+// PassManager runs a pipeline of passes on functions and accounts the time
+// each step takes. It is not safe for concurrent use: each thread
+// compiling functions uses its own, and their timings are merged.
+class PassManager {
+public:
+    // DefaultPipeline propagates constants first, so that the values
+    // they make equal are merged, and proves checks redundant once equal
+    // lengths and indexes are the same values and the loop tests are in
+    // canonical form. Loops are rotated after, as Prove learns from the
+    // tests in their headers, and then have their invariants moved out,
+    // where they meet the copies the tests on entry made of them; the
+    // pipeline removes what is left unused last.
+    static constexpr std::string_view DefaultPipeline =
+        "copyelim,sccp,copyelim,cse,indvars,prove,looprotate,copyelim,licm,cse,deadcode";
+
+    PassManager();
+
+    // SetPipeline sets the passes to run, a comma-separated list of names
+    // in order; a pass may appear more than once and the list may be
+    // empty. It returns an error for an unknown name and leaves the
+    // pipeline unchanged.
+    std::string SetPipeline(std::string_view names);
+    std::string Pipeline() const;
+    // SetVerify makes Run check the function after each step.
+    void SetVerify(bool verify) { _verify = verify; }
+    // SetDebug names the passes that report what they do to the function
+    // run, in a comma-separated list. It returns an error for an unknown
+    // name.
+    std::string SetDebug(std::string_view names);
+
+    // Run runs the pipeline on f. With verification, it stops at the first
+    // step that leaves f malformed and returns what is wrong; otherwise it
+    // returns an empty string.
+    std::string Run(Func &f);
+
+    // Timing accounts a step of the pipeline over the functions run.
+    struct Timing {
+        const ssa::Pass *Pass = nullptr;
+        uint64_t Nanos = 0;
+        uint64_t Runs = 0;
+        int64_t Removed = 0; // the values the step removed, net of those it added
+    };
+    std::span<const Timing> Timings() const { return _steps; }
+    // Merge adds the timings of other, which runs the same pipeline.
+    void Merge(const PassManager &other);
+    // Report formats the timings as a table, a step per line.
+    std::string Report() const;
+
+private:
+    std::vector<Timing> _steps;
+    std::vector<const ssa::Pass *> _debug;
+    bool _verify = false;
+};
+
+} // namespace ssa
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace staticdata {
+
+// SectionWriter appends bytes to the read-only data section of the object
+// being written. The view is only valid during the call.
+using SectionWriter = std::function<void(std::string_view)>;
+
+// EmbedChunkSize is the number of bytes of an embedded file handed to the
+// section writer, and resident in the compiler, at a time.
+constexpr size_t EmbedChunkSize = size_t(4) << 20;
+
+// EmbedFile describes a file embedded by a //go:embed directive.
+struct EmbedFile {
+    std::string Path;
+    uint64_t Size = 0;
+    std::string Hash; // common::Digest of the contents
+};
+
+// WriteEmbed maps the file at path and streams its contents to w in chunks
+// of EmbedChunkSize bytes, hashing each chunk as it is written. Chunks are
+// released from memory once written, so the resident size of the compiler
+// does not depend on the size of the file. w may be nil to only hash the
+// file. WriteEmbed fills in f and reports whether the file could be mapped.
+bool WriteEmbed(const std::string &path, const SectionWriter &w, EmbedFile &f);
+
+// ResolveEmbed returns the files under dir that the patterns of a //go:embed
+// directive name, as slash-separated paths relative to dir, sorted and
+// without duplicates. A pattern is a path.Match pattern of a relative path
+// without "." or ".." elements; a directory it matches stands for the files
+// under it, except those whose names begin with '.' or '_' unless the
+// pattern begins with "all:". A pattern that is malformed or names no file
+// is reported to error, as gc does, and the result is then empty.
+std::vector<std::string> ResolveEmbed(const std::string &dir, std::span<const std::string> patterns,
+                                      std::string &error);
+
+} // namespace staticdata
@@ -1,8 +1,11 @@
 #pragma once
 #include <string>
 #include <iostream>
+#include <memory>
 
-#include "syntax/types/field_type.hh"
+#include "common/casting.hh"
+#include "syntax/pos.hh"
+#include "syntax/types/type.hh"
 
 using namespace std;
 
@@ -14,11 +17,86 @@ namespace ast {
     struct Visitor;
     struct Node;
 
+    // NodeKind identifies the concrete type of a Node, for isa, cast and
+    // dyn_cast (see common/casting.hh). The kinds of the nodes derived from
+    // an abstract node type are contiguous, so its classof is a range check.
+    enum class NodeKind : uint8_t {
+        File,
+        Field,
+        CaseClause,
+        CommClause,
+
+        // DeclNode
+        ImportDecl,
+        ConstDecl,
+        TypeDecl,
+        VarDecl,
+        FuncDecl,
+
+        // ExprNode
+        BadExpr,
+        Name,
+        BasicLit,
+        CompositeLit,
+        KeyValueExpr,
+        FuncLit,
+        ParenExpr,
+        SelectorExpr,
+        IndexExpr,
+        SliceExpr,
+        AssertExpr,
+        TypeSwitchGuard,
+        Operation,
+        CallExpr,
+        ListExpr,
+        ArrayType,
+        SliceType,
+        DotsType,
+        StructType,
+        InterfaceType,
+        FuncType,
+        MapType,
+        ChanType,
+
+        // StmtNode, starting with SimpleStmtNode
+        EmptyStmt,
+        ExprStmt,
+        SendStmt,
+        AssignStmt,
+        RangeClause,
+        LabeledStmt,
+        BlockStmt,
+        DeclStmt,
+        BranchStmt,
+        CallStmt,
+        ReturnStmt,
+        IfStmt,
+        ForStmt,
+        SwitchStmt,
+        SelectStmt,
+
+        FirstDecl = ImportDecl,
+        LastDecl = FuncDecl,
+        FirstExpr = BadExpr,
+        LastExpr = ChanType,
+        FirstStmt = EmptyStmt,
+        LastStmt = SelectStmt,
+        FirstSimpleStmt = EmptyStmt,
+        LastSimpleStmt = RangeClause,
+    };
+
     using NodePtr = std::shared_ptr<Node>;
     // Node is the basic element of the AST.
     // Interfaces embed Node should have 'Node' name suffix.
     struct Node : public std::enable_shared_from_this<Node> {
-        std::string text;
+        syntax::Pos pos{};   // see syntax::FileSet
+        const NodeKind kind; // concrete type of the node
+        syntax::Span span{}; // source extent, set by the parser
+
+        explicit Node(NodeKind k) : kind(k) {}
+        // Kind returns the concrete type of the node.
+        NodeKind Kind() const { return kind; }
+        static bool classof(const Node *) { return true; }
         // Accept accepts Visitor to visit itself.
         // The returned node should replace original node.
         // ok returns false to stop visiting.
@@ -28,10 +106,22 @@ namespace ast {
         // children should be skipped. Otherwise, call its children in particular order that
         // later elements depends on former elements. Finally, return visitor.Leave.
         virtual bool Accept(Visitor *v, Node *node) = 0;
-        // Text returns the original text of the element.
-        virtual std::string Text() { return text; }
-        // SetText sets original text to the Node.
-        virtual void SetText(std::string txt) { this->text = txt; };
+        // Child stores the i-th child of the Node in child, in the order Accept
+        // visits them, and returns true; it returns false if there are at most
+        // i children. Absent optional children are stored as nil.
+        virtual bool Child(size_t i, Node *&child) = 0;
+        // Text returns the original text of the element. It is a view of
+        // the source pinned by the node's file, so nothing is copied; it is
+        // empty if the span is unknown, e.g. for decoded nodes.
+        std::string_view Text() const { return syntax::FileSet::Global().Text(span); }
+        // GetSpan returns the source extent of the Node.
+        syntax::Span GetSpan() const { return span; }
+        // SetSpan sets the source extent of the Node.
+        void SetSpan(syntax::Span s) { span = s; }
+        // GetPos returns the start position of the Node in the source file.
+        syntax::Pos GetPos() const { return pos; }
+        // SetPos sets the start position of the Node.
+        void SetPos(syntax::Pos p) { pos = p; }
 
         virtual ~Node() = default;
     };
@@ -49,15 +139,18 @@ namespace ast {
     // ExprNode is a node that can be evaluated.
     // Name of implementations should have 'Expr' suffix.
     struct ExprNode : Node {
-        types::FieldType Type;
-        uint64 flag;
+        using Node::Node;
+        static bool classof(const Node *n) { return n->Kind() >= NodeKind::FirstExpr && n->Kind() <= NodeKind::LastExpr; }
+
+        types::TypeId typ = 0; // canonical type, see types::TypeTable
+        uint64 flag = FlagConstant;
         // SetType sets evaluation type to the expression.
-        virtual void SetType(types::FieldTypePtr tp) {
-            Type = *tp;
+        virtual void SetType(types::TypeId tp) {
+            typ = tp;
         }
         // GetType gets the evaluation type of the expression.
-        virtual types::FieldTypePtr GetType() {
-            return std::make_shared<types::FieldType>(Type);
+        virtual types::TypeId GetType() {
+            return typ;
         }
         // SetFlag sets flag to the expression.
         // Flag indicates whether the expression contains
@@ -83,6 +176,7 @@ namespace ast {
 
     // FuncNode represents function call expression node.
     struct FuncNode : ExprNode {
+        using ExprNode::ExprNode;
         virtual void functionExpression() {};
     };
     using FuncNodePtr = std::shared_ptr<FuncNode>;
@@ -90,22 +184,35 @@ namespace ast {
     // StmtNode represents statement node.
     // Name of implementations should have 'Stmt' suffix.
     struct StmtNode : Node {
+        using Node::Node;
+        static bool classof(const Node *n) { return n->Kind() >= NodeKind::FirstStmt && n->Kind() <= NodeKind::LastStmt; }
         virtual void statement() {};
     };
     using StmtNodePtr = std::shared_ptr<StmtNode>;
 
     // DDLNode represents DDL statement node.
     struct DDLNode : StmtNode {
+        using StmtNode::StmtNode;
         virtual void ddlStatement() {};
     };
     using DDLNodePtr = std::shared_ptr<DDLNode>;
 
     // DMLNode represents DML statement node.
     struct DMLNode : StmtNode {
+        using StmtNode::StmtNode;
         virtual void dmlStatement() {};
     };
     using DMLNodePtr = std::shared_ptr<DMLNode>;
 
+    // DeclNode represents a top-level or local declaration.
+    // Name of implementations should have 'Decl' suffix.
+    struct DeclNode : Node {
+        using Node::Node;
+        static bool classof(const Node *n) { return n->Kind() >= NodeKind::FirstDecl && n->Kind() <= NodeKind::LastDecl; }
+        virtual void declaration() {};
+    };
+    using DeclNodePtr = std::shared_ptr<DeclNode>;
+
     // ResultField represents a result field which can be a column from a table,
     // or an expression in select field. It is a generated property during
     // binding process. ResultField is the key element to evaluate a ColumnNameExpr.
@@ -134,12 +241,14 @@ namespace ast {
     // ResultSetNode interface has a ResultFields property, represents a Node that returns result set.
     // Implementations include SelectStmt, SubqueryExpr, TableSource, TableName and Join.
     struct ResultSetNode : Node {
+        using Node::Node;
     };
     using ResultSetNodePtr = std::shared_ptr<ResultSetNode>;
 
 
     // SensitiveStmtNode overloads StmtNode and provides a SecureText method.
     struct SensitiveStmtNode : StmtNode {
+        using StmtNode::StmtNode;
         // SecureText is different from Text that it hide password information.
         virtual std::string SecureText() = 0;
     };
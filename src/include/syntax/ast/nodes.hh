@@ -0,0 +1,610 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common/interner.hh"
+#include "syntax/ast/ast.hh"
+#include "syntax/tokens.hh"
+
+// Go syntax tree nodes, following the layout of cmd/compile/internal/syntax/nodes.go.
+namespace ast {
+
+    using Pos = syntax::Pos;
+
+    struct Name;
+    struct BasicLit;
+    struct Field;
+    struct FuncType;
+    struct BlockStmt;
+    struct CaseClause;
+    struct CommClause;
+    using NamePtr = std::shared_ptr<Name>;
+    using BasicLitPtr = std::shared_ptr<BasicLit>;
+    using FieldPtr = std::shared_ptr<Field>;
+    using FuncTypePtr = std::shared_ptr<FuncType>;
+    using BlockStmtPtr = std::shared_ptr<BlockStmt>;
+    using CaseClausePtr = std::shared_ptr<CaseClause>;
+    using CommClausePtr = std::shared_ptr<CommClause>;
+
+    // ----------------------------------------------------------------------------
+    // Nodes
+
+    // File is the root of the syntax tree of a single source file.
+    // package PkgName; DeclList[0], DeclList[1], ...
+    struct File : Node {
+        NamePtr PkgName;
+        std::vector<DeclNodePtr> DeclList;
+        Pos Eof{};
+        File() : Node(NodeKind::File) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::File; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+    using FilePtr = std::shared_ptr<File>;
+
+    // ----------------------------------------------------------------------------
+    // Declarations
+
+    // Group identifies the declarations of a parenthesized declaration group;
+    // all members of a group share the same Group pointer.
+    struct Group {};
+    using GroupPtr = std::shared_ptr<Group>;
+
+    //              Path
+    // LocalPkgName Path
+    struct ImportDecl : DeclNode {
+        GroupPtr Group;
+        NamePtr LocalPkgName; // including "."; nil means no rename present
+        BasicLitPtr Path;     // Path->Bad || Path->Kind == StringLit; nil means no path
+        ImportDecl() : DeclNode(NodeKind::ImportDecl) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::ImportDecl; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    // NameList
+    // NameList      = Values
+    // NameList Type = Values
+    struct ConstDecl : DeclNode {
+        GroupPtr Group;
+        std::vector<NamePtr> NameList;
+        ExprNodePtr Type;   // nil means no type
+        ExprNodePtr Values; // nil means no values
+        ConstDecl() : DeclNode(NodeKind::ConstDecl) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::ConstDecl; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    // Name Type
+    struct TypeDecl : DeclNode {
+        GroupPtr Group;
+        NamePtr Name;
+        bool Alias = false;
+        ExprNodePtr Type;
+        TypeDecl() : DeclNode(NodeKind::TypeDecl) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::TypeDecl; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    // NameList Type
+    // NameList Type = Values
+    // NameList      = Values
+    struct VarDecl : DeclNode {
+        GroupPtr Group;
+        std::vector<NamePtr> NameList;
+        ExprNodePtr Type;   // nil means no type
+        ExprNodePtr Values; // nil means no values
+        std::vector<std::string> EmbedPatterns; // patterns of a preceding //go:embed directive
+        VarDecl() : DeclNode(NodeKind::VarDecl) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::VarDecl; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    // func          Name TParamList Type { Body }
+    // func          Name TParamList Type
+    // func Receiver Name Type { Body }
+    // func Receiver Name Type
+    struct FuncDecl : DeclNode {
+        FieldPtr Recv; // nil means regular function
+        NamePtr Name;
+        std::vector<FieldPtr> TParamList; // empty means not generic
+        FuncTypePtr Type;
+        BlockStmtPtr Body; // nil means no body (forward declaration) or a skipped body
+        // BodyLbrace and BodyRbrace delimit a body skipped by a SkipFuncBodies
+        // parse; they are zero otherwise.
+        Pos BodyLbrace{};
+        Pos BodyRbrace{};
+        // Skipped reports whether the body still has to be parsed.
+        bool Skipped() const { return Body == nullptr && BodyLbrace.IsKnown(); }
+        FuncDecl() : DeclNode(NodeKind::FuncDecl) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::FuncDecl; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Expressions
+
+    // Placeholder for an expression that failed to parse
+    // correctly and where we can't provide a better node.
+    struct BadExpr : ExprNode {
+        BadExpr() : ExprNode(NodeKind::BadExpr) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::BadExpr; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // Value
+    struct Name : ExprNode {
+        common::SymbolId Sym = 0; // identifiers are equal iff their symbols are
+        std::string_view Value;   // interned spelling of Sym
+        Name() : ExprNode(NodeKind::Name) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::Name; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // Value
+    struct BasicLit : ExprNode {
+        std::string Value;
+        syntax::LitKind Kind = IntLit;
+        bool Bad = false; // true means the literal Value has syntax errors
+        BasicLit() : ExprNode(NodeKind::BasicLit) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::BasicLit; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // PackedElems holds the elements of a large composite literal of integer
+    // constants, such as []byte{0x1f, 0x8b, ...}, as one typed buffer: the
+    // values little-endian, ElemSize bytes each, in a single allocation
+    // instead of a node per element. It is immutable once built and shared,
+    // so later stages can emit Data as read-only data as is.
+    struct PackedElems {
+        uint8_t ElemSize = 1; // 1, 2, 4 or 8
+        std::vector<uint8_t> Data;
+
+        size_t Len() const { return Data.size() / ElemSize; }
+        // At returns the i-th element.
+        uint64_t At(size_t i) const {
+            uint64_t v = 0;
+            for (size_t b = ElemSize; b-- > 0;) {
+                v = v << 8 | Data[i * ElemSize + b];
+            }
+            return v;
+        }
+    };
+    using PackedElemsPtr = std::shared_ptr<const PackedElems>;
+
+    // Type { ElemList[0], ElemList[1], ... }
+    struct CompositeLit : ExprNode {
+        ExprNodePtr Type; // nil means no literal type
+        std::vector<ExprNodePtr> ElemList;
+        PackedElemsPtr Packed; // if set, the elements instead of ElemList
+        int NKeys = 0; // number of elements with keys
+        Pos Rbrace{};
+        CompositeLit() : ExprNode(NodeKind::CompositeLit) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::CompositeLit; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // Key: Value
+    struct KeyValueExpr : ExprNode {
+        ExprNodePtr Key;
+        ExprNodePtr Value;
+        KeyValueExpr() : ExprNode(NodeKind::KeyValueExpr) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::KeyValueExpr; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // func Type { Body }
+    struct FuncLit : ExprNode {
+        FuncTypePtr Type;
+        BlockStmtPtr Body;
+        FuncLit() : ExprNode(NodeKind::FuncLit) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::FuncLit; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // (X)
+    struct ParenExpr : ExprNode {
+        ExprNodePtr X;
+        ParenExpr() : ExprNode(NodeKind::ParenExpr) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::ParenExpr; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // X.Sel
+    struct SelectorExpr : ExprNode {
+        ExprNodePtr X;
+        NamePtr Sel;
+        SelectorExpr() : ExprNode(NodeKind::SelectorExpr) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::SelectorExpr; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // X[Index]
+    struct IndexExpr : ExprNode {
+        ExprNodePtr X;
+        ExprNodePtr Index;
+        IndexExpr() : ExprNode(NodeKind::IndexExpr) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::IndexExpr; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // X[Index[0] : Index[1] : Index[2]]
+    struct SliceExpr : ExprNode {
+        ExprNodePtr X;
+        std::array<ExprNodePtr, 3> Index;
+        // Full indicates whether this is a simple or full slice expression.
+        // In a valid AST, this is equivalent to Index[2] != nil.
+        bool Full = false;
+        SliceExpr() : ExprNode(NodeKind::SliceExpr) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::SliceExpr; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // X.(Type)
+    struct AssertExpr : ExprNode {
+        ExprNodePtr X;
+        ExprNodePtr Type;
+        AssertExpr() : ExprNode(NodeKind::AssertExpr) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::AssertExpr; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // X.(type)
+    // Lhs := X.(type)
+    struct TypeSwitchGuard : ExprNode {
+        NamePtr Lhs; // nil means no Lhs :=
+        ExprNodePtr X; // X.(type)
+        TypeSwitchGuard() : ExprNode(NodeKind::TypeSwitchGuard) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::TypeSwitchGuard; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // Op X
+    // X Op Y
+    struct Operation : ExprNode {
+        syntax::Operator Op = 0;
+        ExprNodePtr X;
+        ExprNodePtr Y; // Y == nil means unary expression
+        Operation() : ExprNode(NodeKind::Operation) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::Operation; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // Fun(ArgList[0], ArgList[1], ...)
+    struct CallExpr : ExprNode {
+        ExprNodePtr Fun;
+        std::vector<ExprNodePtr> ArgList; // nil means no arguments
+        bool HasDots = false;             // last argument is followed by ...
+        CallExpr() : ExprNode(NodeKind::CallExpr) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::CallExpr; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // ElemList[0], ElemList[1], ...
+    struct ListExpr : ExprNode {
+        std::vector<ExprNodePtr> ElemList;
+        ListExpr() : ExprNode(NodeKind::ListExpr) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::ListExpr; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Types
+
+    // [Len]Elem
+    struct ArrayType : ExprNode {
+        ExprNodePtr Len; // nil means Len is ...
+        ExprNodePtr Elem;
+        ArrayType() : ExprNode(NodeKind::ArrayType) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::ArrayType; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // []Elem
+    struct SliceType : ExprNode {
+        ExprNodePtr Elem;
+        SliceType() : ExprNode(NodeKind::SliceType) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::SliceType; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // ...Elem
+    struct DotsType : ExprNode {
+        ExprNodePtr Elem;
+        DotsType() : ExprNode(NodeKind::DotsType) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::DotsType; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // struct { FieldList[0] TagList[0]; FieldList[1] TagList[1]; ... }
+    struct StructType : ExprNode {
+        std::vector<FieldPtr> FieldList;
+        std::vector<BasicLitPtr> TagList; // i >= len(TagList) || TagList[i] == nil means no tag for field i
+        StructType() : ExprNode(NodeKind::StructType) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::StructType; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // Name Type
+    //      Type
+    struct Field : Node {
+        NamePtr Name; // nil means anonymous field/parameter (structs/parameters), or embedded interface (interfaces)
+        ExprNodePtr Type; // field names declared in a list share the same Type (identical pointers)
+        Field() : Node(NodeKind::Field) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::Field; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    // interface { MethodList[0]; MethodList[1]; ... }
+    struct InterfaceType : ExprNode {
+        std::vector<FieldPtr> MethodList;
+        InterfaceType() : ExprNode(NodeKind::InterfaceType) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::InterfaceType; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    struct FuncType : ExprNode {
+        std::vector<FieldPtr> ParamList;
+        std::vector<FieldPtr> ResultList;
+        FuncType() : ExprNode(NodeKind::FuncType) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::FuncType; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // map[Key]Value
+    struct MapType : ExprNode {
+        ExprNodePtr Key;
+        ExprNodePtr Value;
+        MapType() : ExprNode(NodeKind::MapType) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::MapType; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    //   chan Elem
+    // <-chan Elem
+    // chan<- Elem
+    typedef uint32_t ChanDir;
+#define ChanBoth 0
+#define SendOnly 1
+#define RecvOnly 2
+
+    struct ChanType : ExprNode {
+        ChanDir Dir = ChanBoth; // 0 means no direction
+        ExprNodePtr Elem;
+        ChanType() : ExprNode(NodeKind::ChanType) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::ChanType; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+        void Format(std::iostream &writer) override;
+    };
+
+    // ----------------------------------------------------------------------------
+    // Statements
+
+    // SimpleStmtNode is a statement that may appear in the header of
+    // if, for and switch statements.
+    struct SimpleStmtNode : StmtNode {
+        using StmtNode::StmtNode;
+        static bool classof(const Node *n) {
+            return n->Kind() >= NodeKind::FirstSimpleStmt && n->Kind() <= NodeKind::LastSimpleStmt;
+        }
+        virtual void simpleStmt() {};
+    };
+    using SimpleStmtNodePtr = std::shared_ptr<SimpleStmtNode>;
+
+    struct EmptyStmt : SimpleStmtNode {
+        EmptyStmt() : SimpleStmtNode(NodeKind::EmptyStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::EmptyStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct LabeledStmt : StmtNode {
+        NamePtr Label;
+        StmtNodePtr Stmt;
+        LabeledStmt() : StmtNode(NodeKind::LabeledStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::LabeledStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct BlockStmt : StmtNode {
+        std::vector<StmtNodePtr> List;
+        Pos Rbrace{};
+        BlockStmt() : StmtNode(NodeKind::BlockStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::BlockStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct ExprStmt : SimpleStmtNode {
+        ExprNodePtr X;
+        ExprStmt() : SimpleStmtNode(NodeKind::ExprStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::ExprStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct SendStmt : SimpleStmtNode {
+        ExprNodePtr Chan;
+        ExprNodePtr Value; // Chan <- Value
+        SendStmt() : SimpleStmtNode(NodeKind::SendStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::SendStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct DeclStmt : StmtNode {
+        std::vector<DeclNodePtr> DeclList;
+        DeclStmt() : StmtNode(NodeKind::DeclStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::DeclStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct AssignStmt : SimpleStmtNode {
+        syntax::Operator Op = 0; // 0 means no operation
+        ExprNodePtr Lhs;
+        ExprNodePtr Rhs; // Rhs == nil means Lhs++ (Op == Add) or Lhs-- (Op == Sub)
+        AssignStmt() : SimpleStmtNode(NodeKind::AssignStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::AssignStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct BranchStmt : StmtNode {
+        syntax::token Tok = 0; // Break, Continue, Fallthrough, or Goto
+        NamePtr Label;
+        BranchStmt() : StmtNode(NodeKind::BranchStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::BranchStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct CallStmt : StmtNode {
+        syntax::token Tok = 0; // Go or Defer
+        std::shared_ptr<CallExpr> Call;
+        CallStmt() : StmtNode(NodeKind::CallStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::CallStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct ReturnStmt : StmtNode {
+        ExprNodePtr Results; // nil means no explicit return values
+        ReturnStmt() : StmtNode(NodeKind::ReturnStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::ReturnStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct IfStmt : StmtNode {
+        SimpleStmtNodePtr Init;
+        ExprNodePtr Cond;
+        BlockStmtPtr Then;
+        StmtNodePtr Else; // either nil, *IfStmt, or *BlockStmt
+        IfStmt() : StmtNode(NodeKind::IfStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::IfStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct ForStmt : StmtNode {
+        SimpleStmtNodePtr Init; // incl. *RangeClause
+        ExprNodePtr Cond;
+        SimpleStmtNodePtr Post;
+        BlockStmtPtr Body;
+        ForStmt() : StmtNode(NodeKind::ForStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::ForStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct SwitchStmt : StmtNode {
+        SimpleStmtNodePtr Init;
+        ExprNodePtr Tag; // incl. *TypeSwitchGuard
+        std::vector<CaseClausePtr> Body;
+        Pos Rbrace{};
+        SwitchStmt() : StmtNode(NodeKind::SwitchStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::SwitchStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct SelectStmt : StmtNode {
+        std::vector<CommClausePtr> Body;
+        Pos Rbrace{};
+        SelectStmt() : StmtNode(NodeKind::SelectStmt) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::SelectStmt; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    // Lhs = range X
+    // Lhs := range X
+    //        range X
+    struct RangeClause : SimpleStmtNode {
+        ExprNodePtr Lhs; // nil means no Lhs = or Lhs :=
+        bool Def = false; // means :=
+        ExprNodePtr X; // range X
+        RangeClause() : SimpleStmtNode(NodeKind::RangeClause) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::RangeClause; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct CaseClause : Node {
+        ExprNodePtr Cases; // nil means default clause
+        std::vector<StmtNodePtr> Body;
+        Pos Colon{};
+        CaseClause() : Node(NodeKind::CaseClause) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::CaseClause; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    struct CommClause : Node {
+        SimpleStmtNodePtr Comm; // send or receive stmt; nil means default clause
+        std::vector<StmtNodePtr> Body;
+        Pos Colon{};
+        CommClause() : Node(NodeKind::CommClause) {}
+        static bool classof(const Node *n) { return n->Kind() == NodeKind::CommClause; }
+        bool Accept(Visitor *v, Node *node) override;
+        bool Child(size_t i, Node *&child) override;
+    };
+
+    // String returns the Go source form of the expression x.
+    std::string String(ExprNode *x);
+}
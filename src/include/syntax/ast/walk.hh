@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "syntax/ast/ast.hh"
+
+namespace ast {
+
+    // Visit tells Walker::Walk how to continue after entering a node.
+    enum class Visit : uint8_t {
+        Children,     // visit the children of the node
+        SkipChildren, // go on with the next sibling
+        Stop,         // end the walk
+    };
+
+    // Walker traverses syntax trees depth-first without recursion. It keeps
+    // one frame per level of the tree on an explicit stack, so arbitrarily
+    // deep trees (e.g. long operator chains in generated code) can be walked
+    // in memory proportional to their depth. Nodes are passed as raw
+    // pointers: walking does not touch reference counts. A Walker may be
+    // reused to avoid reallocating its stack; it is not thread-safe.
+    class Walker {
+    public:
+        // Walk visits root and its descendants. pre(n) is called before the
+        // children of n and returns how to continue; post(n) is called after
+        // them, unless they were skipped, and returns false to stop. Nil
+        // children are not visited. Walk returns false if it was stopped.
+        template <typename Pre, typename Post>
+        bool Walk(Node *root, Pre &&pre, Post &&post);
+
+        // Walk visits root and its descendants in pre-order; pre(n) returns
+        // how to continue.
+        template <typename Pre>
+        bool Walk(Node *root, Pre &&pre) {
+            return Walk(root, pre, [](Node *) { return true; });
+        }
+
+        // Depth returns the number of ancestors of the node being visited.
+        size_t Depth() const { return _stack.empty() ? 0 : _stack.size() - 1; }
+
+        // Parent returns the parent of the node being visited, or nil.
+        Node *Parent() const { return _stack.size() < 2 ? nullptr : _stack[_stack.size() - 2].node; }
+
+    private:
+        struct Frame {
+            Node *node;
+            size_t next; // index of the next child to visit
+        };
+        std::vector<Frame> _stack;
+    };
+
+    template <typename Pre, typename Post>
+    bool Walker::Walk(Node *root, Pre &&pre, Post &&post) {
+        _stack.clear();
+        if (root == nullptr) {
+            return true;
+        }
+        _stack.push_back({root, 0});
+        switch (pre(root)) {
+        case Visit::Stop:
+            _stack.clear();
+            return false;
+        case Visit::SkipChildren:
+            _stack.clear();
+            return true;
+        case Visit::Children:
+            break;
+        }
+        while (!_stack.empty()) {
+            auto &top = _stack.back();
+            Node *child;
+            if (!top.node->Child(top.next, child)) {
+                // all children visited
+                auto n = top.node;
+                if (!post(n)) {
+                    _stack.clear();
+                    return false;
+                }
+                _stack.pop_back();
+                continue;
+            }
+            top.next++;
+            if (child == nullptr) {
+                continue;
+            }
+            _stack.push_back({child, 0});
+            switch (pre(child)) {
+            case Visit::Stop:
+                _stack.clear();
+                return false;
+            case Visit::SkipChildren:
+                _stack.pop_back();
+                break;
+            case Visit::Children:
+                break;
+            }
+        }
+        return true;
+    }
+
+    // Inspect walks root in pre-order, calling f for each node; if f returns
+    // false, the children of the node are skipped.
+    template <typename F>
+    void Inspect(Node *root, F &&f) {
+        Walker w;
+        w.Walk(root, [&](Node *n) { return f(n) ? Visit::Children : Visit::SkipChildren; });
+    }
+}
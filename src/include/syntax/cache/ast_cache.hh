@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "common/mapped_file.hh"
+#include "syntax/ast/nodes.hh"
+#include "syntax/cache/ast_cache_generated.h"
+#include "syntax/parser.hh"
+
+// On-disk cache of parsed files. A cache entry is an AstFile flatbuffer
+// (see ast_cache.fbs) named after the content hash of the source it was
+// parsed from. Entries are mapped into memory and read in place: NodeView
+// walks a cached tree without materializing it, Decode rebuilds the
+// ast::File when a mutable tree is needed.
+namespace syntax::cache {
+
+// Version is bumped whenever the encoding of trees changes.
+#define AstCacheVersion 5
+
+// Flags of Node::flags().
+#define NodeFlagBad (1u << 0)     // BasicLit.Bad
+#define NodeFlagFull (1u << 1)    // SliceExpr.Full
+#define NodeFlagAlias (1u << 2)   // TypeDecl.Alias
+#define NodeFlagDef (1u << 3)     // RangeClause.Def
+#define NodeFlagHasDots (1u << 4) // CallExpr.HasDots
+#define NodeFlagPacked (1u << 5)  // CompositeLit.Packed is set
+
+// NodeView is a cursor over a node of a cached tree. The children of a node
+// are laid out in the order of the fields of the corresponding ast node;
+// node lists and extra positions (e.g. BlockStmt.Rbrace) are List and Pos
+// children. Empty lists and zero positions are nil.
+class NodeView {
+public:
+    NodeView() = default;
+    NodeView(const AstFile *file, uint32_t index) : _file(file), _index(index) {}
+
+    // a nil view stands for a nil child
+    explicit operator bool() const { return _file != nullptr; }
+    uint32_t Index() const { return _index; }
+
+    NodeKind Kind() const { return node()->kind(); }
+    // Offset returns the byte offset of the node's position, or -1.
+    int64_t Offset() const { return int64_t(node()->pos()) - 1; }
+    uint32_t Flags() const { return node()->flags(); }
+    uint32_t Sub() const { return node()->sub(); }
+    uint32_t Value() const { return node()->value(); }
+
+    uint32_t NumChildren() const { return node()->count(); }
+    NodeView Child(uint32_t i) const {
+        auto c = _file->children()->Get(node()->first() + i);
+        return c == 0 ? NodeView() : NodeView(_file, c - 1);
+    }
+
+    // Str returns the spelling of a Name or the value of a BasicLit.
+    std::string_view Str() const {
+        auto s = _file->strings()->Get(node()->value());
+        return std::string_view(s->c_str(), s->size());
+    }
+
+    // Packed returns the packed elements of a CompositeLit with
+    // NodeFlagPacked, in the layout of ast::PackedElems; Sub is their size.
+    std::span<const uint8_t> Packed() const {
+        auto p = _file->data()->data() + node()->value();
+        return std::span<const uint8_t>(p + 4, uint32_t(p[0] | p[1] << 8 | p[2] << 16 | uint32_t(p[3]) << 24));
+    }
+
+private:
+    const Node *node() const { return _file->nodes()->Get(_index); }
+
+    const AstFile *_file = nullptr;
+    uint32_t _index = 0;
+};
+
+// CachedFile is a cache entry mapped into memory.
+class CachedFile {
+public:
+    // Open maps the cache entry at path and checks that it is a well-formed
+    // tree of the current version. It returns nil otherwise.
+    static std::unique_ptr<CachedFile> Open(const std::string &path);
+
+    const AstFile *File() const { return _file; }
+    NodeView Root() const { return NodeView(_file, _file->root()); }
+    uint32_t Mode() const { return _file->mode(); }
+    std::string_view Hash() const {
+        return std::string_view(reinterpret_cast<const char *>(_file->hash()->data()), _file->hash()->size());
+    }
+
+    // Decode rebuilds the syntax tree. The source is added to
+    // FileSet::Global() under the given name, and identifiers are interned
+    // again, so positions and symbols are those of the running process;
+    // src, if given, is pinned as its source, as the parser does. It
+    // returns nil if the position space of the file set is exhausted.
+    ast::FilePtr Decode(std::string filename = "", std::string_view src = {}) const;
+
+private:
+    CachedFile(std::unique_ptr<common::MappedFile> map, const AstFile *file) : _map(std::move(map)), _file(file) {}
+
+    std::unique_ptr<common::MappedFile> _map;
+    const AstFile *_file;
+};
+
+// Encode serializes file, parsed with the given mode from a source with the
+// given content hash, into a finished AstFile buffer. Positions are stored
+// relative to the file, together with its line table.
+flatbuffers::DetachedBuffer Encode(const ast::File &file, std::string_view hash, uint mode);
+
+// AstCache is a directory of cache entries.
+class AstCache {
+public:
+    explicit AstCache(std::string dir);
+
+    // Hash returns the XXH3-128 digest of src.
+    static std::string Hash(std::string_view src);
+
+    // Path returns the path of the entry for a source with the given hash,
+    // parsed with the given mode.
+    std::string Path(std::string_view hash, uint mode) const;
+
+    // Load returns the entry for src, or nil if there is none. Stale and
+    // corrupt entries are treated as missing.
+    std::unique_ptr<CachedFile> Load(std::string_view src, uint mode = 0) const;
+
+    // Store adds file, parsed from src with the given mode, to the cache.
+    // The entry is written to a temporary file and renamed into place, so
+    // concurrent readers never see a partial entry. It reports whether the
+    // entry was written.
+    bool Store(std::string_view src, const ast::File &file, uint mode = 0) const;
+
+private:
+    std::string _dir;
+};
+
+// ParseCached returns the syntax tree of src, decoding it from cache if an
+// entry exists and parsing and storing it otherwise. Files with syntax
+// errors are not cached, so their errors are reported on every call.
+ast::FilePtr ParseCached(const AstCache &cache, std::string_view src, err_handler errh, uint mode = 0,
+                         std::string filename = "");
+
+} // namespace syntax::cache
@@ -0,0 +1,459 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+
+#ifndef FLATBUFFERS_GENERATED_ASTCACHE_SYNTAX_CACHE_H_
+#define FLATBUFFERS_GENERATED_ASTCACHE_SYNTAX_CACHE_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+namespace syntax {
+namespace cache {
+
+struct Node;
+
+struct AstFile;
+
+enum NodeKind {
+  NodeKind_List = 0,
+  NodeKind_Pos = 1,
+  NodeKind_File = 2,
+  NodeKind_ImportDecl = 3,
+  NodeKind_ConstDecl = 4,
+  NodeKind_TypeDecl = 5,
+  NodeKind_VarDecl = 6,
+  NodeKind_FuncDecl = 7,
+  NodeKind_BadExpr = 8,
+  NodeKind_Name = 9,
+  NodeKind_BasicLit = 10,
+  NodeKind_CompositeLit = 11,
+  NodeKind_KeyValueExpr = 12,
+  NodeKind_FuncLit = 13,
+  NodeKind_ParenExpr = 14,
+  NodeKind_SelectorExpr = 15,
+  NodeKind_IndexExpr = 16,
+  NodeKind_SliceExpr = 17,
+  NodeKind_AssertExpr = 18,
+  NodeKind_TypeSwitchGuard = 19,
+  NodeKind_Operation = 20,
+  NodeKind_CallExpr = 21,
+  NodeKind_ListExpr = 22,
+  NodeKind_ArrayType = 23,
+  NodeKind_SliceType = 24,
+  NodeKind_DotsType = 25,
+  NodeKind_StructType = 26,
+  NodeKind_Field = 27,
+  NodeKind_InterfaceType = 28,
+  NodeKind_FuncType = 29,
+  NodeKind_MapType = 30,
+  NodeKind_ChanType = 31,
+  NodeKind_EmptyStmt = 32,
+  NodeKind_LabeledStmt = 33,
+  NodeKind_BlockStmt = 34,
+  NodeKind_ExprStmt = 35,
+  NodeKind_SendStmt = 36,
+  NodeKind_DeclStmt = 37,
+  NodeKind_AssignStmt = 38,
+  NodeKind_BranchStmt = 39,
+  NodeKind_CallStmt = 40,
+  NodeKind_ReturnStmt = 41,
+  NodeKind_IfStmt = 42,
+  NodeKind_ForStmt = 43,
+  NodeKind_SwitchStmt = 44,
+  NodeKind_SelectStmt = 45,
+  NodeKind_RangeClause = 46,
+  NodeKind_CaseClause = 47,
+  NodeKind_CommClause = 48,
+  NodeKind_MIN = NodeKind_List,
+  NodeKind_MAX = NodeKind_CommClause
+};
+
+inline const NodeKind (&EnumValuesNodeKind())[49] {
+  static const NodeKind values[] = {
+    NodeKind_List,
+    NodeKind_Pos,
+    NodeKind_File,
+    NodeKind_ImportDecl,
+    NodeKind_ConstDecl,
+    NodeKind_TypeDecl,
+    NodeKind_VarDecl,
+    NodeKind_FuncDecl,
+    NodeKind_BadExpr,
+    NodeKind_Name,
+    NodeKind_BasicLit,
+    NodeKind_CompositeLit,
+    NodeKind_KeyValueExpr,
+    NodeKind_FuncLit,
+    NodeKind_ParenExpr,
+    NodeKind_SelectorExpr,
+    NodeKind_IndexExpr,
+    NodeKind_SliceExpr,
+    NodeKind_AssertExpr,
+    NodeKind_TypeSwitchGuard,
+    NodeKind_Operation,
+    NodeKind_CallExpr,
+    NodeKind_ListExpr,
+    NodeKind_ArrayType,
+    NodeKind_SliceType,
+    NodeKind_DotsType,
+    NodeKind_StructType,
+    NodeKind_Field,
+    NodeKind_InterfaceType,
+    NodeKind_FuncType,
+    NodeKind_MapType,
+    NodeKind_ChanType,
+    NodeKind_EmptyStmt,
+    NodeKind_LabeledStmt,
+    NodeKind_BlockStmt,
+    NodeKind_ExprStmt,
+    NodeKind_SendStmt,
+    NodeKind_DeclStmt,
+    NodeKind_AssignStmt,
+    NodeKind_BranchStmt,
+    NodeKind_CallStmt,
+    NodeKind_ReturnStmt,
+    NodeKind_IfStmt,
+    NodeKind_ForStmt,
+    NodeKind_SwitchStmt,
+    NodeKind_SelectStmt,
+    NodeKind_RangeClause,
+    NodeKind_CaseClause,
+    NodeKind_CommClause
+  };
+  return values;
+}
+
+inline const char * const *EnumNamesNodeKind() {
+  static const char * const names[] = {
+    "List",
+    "Pos",
+    "File",
+    "ImportDecl",
+    "ConstDecl",
+    "TypeDecl",
+    "VarDecl",
+    "FuncDecl",
+    "BadExpr",
+    "Name",
+    "BasicLit",
+    "CompositeLit",
+    "KeyValueExpr",
+    "FuncLit",
+    "ParenExpr",
+    "SelectorExpr",
+    "IndexExpr",
+    "SliceExpr",
+    "AssertExpr",
+    "TypeSwitchGuard",
+    "Operation",
+    "CallExpr",
+    "ListExpr",
+    "ArrayType",
+    "SliceType",
+    "DotsType",
+    "StructType",
+    "Field",
+    "InterfaceType",
+    "FuncType",
+    "MapType",
+    "ChanType",
+    "EmptyStmt",
+    "LabeledStmt",
+    "BlockStmt",
+    "ExprStmt",
+    "SendStmt",
+    "DeclStmt",
+    "AssignStmt",
+    "BranchStmt",
+    "CallStmt",
+    "ReturnStmt",
+    "IfStmt",
+    "ForStmt",
+    "SwitchStmt",
+    "SelectStmt",
+    "RangeClause",
+    "CaseClause",
+    "CommClause",
+    nullptr
+  };
+  return names;
+}
+
+inline const char *EnumNameNodeKind(NodeKind e) {
+  if (e < NodeKind_List || e > NodeKind_CommClause) return "";
+  const size_t index = static_cast<size_t>(e);
+  return EnumNamesNodeKind()[index];
+}
+
+FLATBUFFERS_MANUALLY_ALIGNED_STRUCT(4) Node FLATBUFFERS_FINAL_CLASS {
+ private:
+  uint8_t kind_;
+  uint8_t flags_;
+  uint16_t sub_;
+  uint32_t value_;
+  uint32_t first_;
+  uint32_t count_;
+  uint32_t pos_;
+
+ public:
+  Node() {
+    memset(static_cast<void *>(this), 0, sizeof(Node));
+  }
+  Node(NodeKind _kind, uint8_t _flags, uint16_t _sub, uint32_t _value, uint32_t _first, uint32_t _count, uint32_t _pos)
+      : kind_(flatbuffers::EndianScalar(static_cast<uint8_t>(_kind))),
+        flags_(flatbuffers::EndianScalar(_flags)),
+        sub_(flatbuffers::EndianScalar(_sub)),
+        value_(flatbuffers::EndianScalar(_value)),
+        first_(flatbuffers::EndianScalar(_first)),
+        count_(flatbuffers::EndianScalar(_count)),
+        pos_(flatbuffers::EndianScalar(_pos)) {
+  }
+  NodeKind kind() const {
+    return static_cast<NodeKind>(flatbuffers::EndianScalar(kind_));
+  }
+  /// Bad, Full, Alias, Def or HasDots
+  uint8_t flags() const {
+    return flatbuffers::EndianScalar(flags_);
+  }
+  /// Op, Tok, literal Kind or channel Dir
+  uint16_t sub() const {
+    return flatbuffers::EndianScalar(sub_);
+  }
+  /// string index of Name and BasicLit, NKeys of CompositeLit,
+  /// group number (0 = none) of declarations
+  uint32_t value() const {
+    return flatbuffers::EndianScalar(value_);
+  }
+  uint32_t first() const {
+    return flatbuffers::EndianScalar(first_);
+  }
+  uint32_t count() const {
+    return flatbuffers::EndianScalar(count_);
+  }
+  /// byte offset + 1 of the node's position, 0 if unknown
+  uint32_t pos() const {
+    return flatbuffers::EndianScalar(pos_);
+  }
+};
+FLATBUFFERS_STRUCT_END(Node, 20);
+
+struct AstFile FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_VERSION = 4,
+    VT_MODE = 6,
+    VT_HASH = 8,
+    VT_NODES = 10,
+    VT_CHILDREN = 12,
+    VT_STRINGS = 14,
+    VT_ROOT = 16,
+    VT_SIZE = 18,
+    VT_LINES = 20,
+    VT_DATA = 22
+  };
+  uint32_t version() const {
+    return GetField<uint32_t>(VT_VERSION, 0);
+  }
+  /// parser mode the file was parsed with
+  uint32_t mode() const {
+    return GetField<uint32_t>(VT_MODE, 0);
+  }
+  /// XXH3-128 digest of the source
+  const flatbuffers::Vector<uint8_t> *hash() const {
+    return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_HASH);
+  }
+  const flatbuffers::Vector<const syntax::cache::Node *> *nodes() const {
+    return GetPointer<const flatbuffers::Vector<const syntax::cache::Node *> *>(VT_NODES);
+  }
+  const flatbuffers::Vector<uint32_t> *children() const {
+    return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_CHILDREN);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *strings() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *>(VT_STRINGS);
+  }
+  uint32_t root() const {
+    return GetField<uint32_t>(VT_ROOT, 0);
+  }
+  /// size and line table of the source, see syntax::SourceFile
+  uint32_t size() const {
+    return GetField<uint32_t>(VT_SIZE, 0);
+  }
+  const flatbuffers::Vector<uint32_t> *lines() const {
+    return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_LINES);
+  }
+  /// packed elements of composite literals, each a little-endian uint
+  /// byte count followed by the bytes
+  const flatbuffers::Vector<uint8_t> *data() const {
+    return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_DATA);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_VERSION) &&
+           VerifyField<uint32_t>(verifier, VT_MODE) &&
+           VerifyOffset(verifier, VT_HASH) &&
+           verifier.VerifyVector(hash()) &&
+           VerifyOffset(verifier, VT_NODES) &&
+           verifier.VerifyVector(nodes()) &&
+           VerifyOffset(verifier, VT_CHILDREN) &&
+           verifier.VerifyVector(children()) &&
+           VerifyOffset(verifier, VT_STRINGS) &&
+           verifier.VerifyVector(strings()) &&
+           verifier.VerifyVectorOfStrings(strings()) &&
+           VerifyField<uint32_t>(verifier, VT_ROOT) &&
+           VerifyField<uint32_t>(verifier, VT_SIZE) &&
+           VerifyOffset(verifier, VT_LINES) &&
+           verifier.VerifyVector(lines()) &&
+           VerifyOffset(verifier, VT_DATA) &&
+           verifier.VerifyVector(data()) &&
+           verifier.EndTable();
+  }
+};
+
+struct AstFileBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_version(uint32_t version) {
+    fbb_.AddElement<uint32_t>(AstFile::VT_VERSION, version, 0);
+  }
+  void add_mode(uint32_t mode) {
+    fbb_.AddElement<uint32_t>(AstFile::VT_MODE, mode, 0);
+  }
+  void add_hash(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> hash) {
+    fbb_.AddOffset(AstFile::VT_HASH, hash);
+  }
+  void add_nodes(flatbuffers::Offset<flatbuffers::Vector<const syntax::cache::Node *>> nodes) {
+    fbb_.AddOffset(AstFile::VT_NODES, nodes);
+  }
+  void add_children(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> children) {
+    fbb_.AddOffset(AstFile::VT_CHILDREN, children);
+  }
+  void add_strings(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> strings) {
+    fbb_.AddOffset(AstFile::VT_STRINGS, strings);
+  }
+  void add_root(uint32_t root) {
+    fbb_.AddElement<uint32_t>(AstFile::VT_ROOT, root, 0);
+  }
+  void add_size(uint32_t size) {
+    fbb_.AddElement<uint32_t>(AstFile::VT_SIZE, size, 0);
+  }
+  void add_lines(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> lines) {
+    fbb_.AddOffset(AstFile::VT_LINES, lines);
+  }
+  void add_data(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> data) {
+    fbb_.AddOffset(AstFile::VT_DATA, data);
+  }
+  explicit AstFileBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  AstFileBuilder &operator=(const AstFileBuilder &);
+  flatbuffers::Offset<AstFile> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<AstFile>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<AstFile> CreateAstFile(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t version = 0,
+    uint32_t mode = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> hash = 0,
+    flatbuffers::Offset<flatbuffers::Vector<const syntax::cache::Node *>> nodes = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> children = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> strings = 0,
+    uint32_t root = 0,
+    uint32_t size = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> lines = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> data = 0) {
+  AstFileBuilder builder_(_fbb);
+  builder_.add_data(data);
+  builder_.add_lines(lines);
+  builder_.add_size(size);
+  builder_.add_root(root);
+  builder_.add_strings(strings);
+  builder_.add_children(children);
+  builder_.add_nodes(nodes);
+  builder_.add_hash(hash);
+  builder_.add_mode(mode);
+  builder_.add_version(version);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<AstFile> CreateAstFileDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t version = 0,
+    uint32_t mode = 0,
+    const std::vector<uint8_t> *hash = nullptr,
+    const std::vector<syntax::cache::Node> *nodes = nullptr,
+    const std::vector<uint32_t> *children = nullptr,
+    const std::vector<flatbuffers::Offset<flatbuffers::String>> *strings = nullptr,
+    uint32_t root = 0,
+    uint32_t size = 0,
+    const std::vector<uint32_t> *lines = nullptr,
+    const std::vector<uint8_t> *data = nullptr) {
+  auto hash__ = hash ? _fbb.CreateVector<uint8_t>(*hash) : 0;
+  auto nodes__ = nodes ? _fbb.CreateVectorOfStructs<syntax::cache::Node>(*nodes) : 0;
+  auto children__ = children ? _fbb.CreateVector<uint32_t>(*children) : 0;
+  auto strings__ = strings ? _fbb.CreateVector<flatbuffers::Offset<flatbuffers::String>>(*strings) : 0;
+  auto lines__ = lines ? _fbb.CreateVector<uint32_t>(*lines) : 0;
+  auto data__ = data ? _fbb.CreateVector<uint8_t>(*data) : 0;
+  return syntax::cache::CreateAstFile(
+      _fbb,
+      version,
+      mode,
+      hash__,
+      nodes__,
+      children__,
+      strings__,
+      root,
+      size,
+      lines__,
+      data__);
+}
+
+inline const syntax::cache::AstFile *GetAstFile(const void *buf) {
+  return flatbuffers::GetRoot<syntax::cache::AstFile>(buf);
+}
+
+inline const syntax::cache::AstFile *GetSizePrefixedAstFile(const void *buf) {
+  return flatbuffers::GetSizePrefixedRoot<syntax::cache::AstFile>(buf);
+}
+
+inline const char *AstFileIdentifier() {
+  return "GOAS";
+}
+
+inline bool AstFileBufferHasIdentifier(const void *buf) {
+  return flatbuffers::BufferHasIdentifier(
+      buf, AstFileIdentifier());
+}
+
+inline bool VerifyAstFileBuffer(
+    flatbuffers::Verifier &verifier) {
+  return verifier.VerifyBuffer<syntax::cache::AstFile>(AstFileIdentifier());
+}
+
+inline bool VerifySizePrefixedAstFileBuffer(
+    flatbuffers::Verifier &verifier) {
+  return verifier.VerifySizePrefixedBuffer<syntax::cache::AstFile>(AstFileIdentifier());
+}
+
+inline const char *AstFileExtension() {
+  return "ast";
+}
+
+inline void FinishAstFileBuffer(
+    flatbuffers::FlatBufferBuilder &fbb,
+    flatbuffers::Offset<syntax::cache::AstFile> root) {
+  fbb.Finish(root, AstFileIdentifier());
+}
+
+inline void FinishSizePrefixedAstFileBuffer(
+    flatbuffers::FlatBufferBuilder &fbb,
+    flatbuffers::Offset<syntax::cache::AstFile> root) {
+  fbb.FinishSizePrefixed(root, AstFileIdentifier());
+}
+
+}  // namespace cache
+}  // namespace syntax
+
+#endif  // FLATBUFFERS_GENERATED_ASTCACHE_SYNTAX_CACHE_H_
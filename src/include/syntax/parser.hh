@@ -0,0 +1,175 @@
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "syntax/ast/nodes.hh"
+#include "syntax/scanner.hh"
+
+namespace syntax
+{
+
+// Parser modes. They share the mode word with the scanner modes; in
+// directives mode the parser interprets //go:embed directives.
+#define SkipFuncBodies (1u << 2) // record the extent of function bodies instead of parsing them
+#define ImportsOnly (1u << 3)    // stop after the import declarations
+
+// parser builds the syntax tree in a single pass over the token stream:
+// it is driven directly by scanner::next with one token of lookahead
+// and never backtracks.
+struct parser : public scanner {
+    err_handler _error_handler{};
+    std::string _first; // first error encountered
+    int _errcnt;        // number of errors encountered
+    int _fnest;         // function nesting level (for error handling)
+    int _xnest;         // expression nesting level (for complit ambiguity resolution)
+
+    // patterns of the last //go:embed directive not yet attached to a
+    // var declaration, and the position of that directive
+    std::vector<std::string> _embeds;
+    uint _embed_line;
+    uint _embed_col;
+
+    // init adds the source to FileSet::Global() under the given name; if
+    // its position space is exhausted, the error is reported and fileOrNil
+    // returns nil.
+    void init(std::string file, err_handler errh, uint mode);
+    void init(std::unique_ptr<std::istream> in, err_handler errh, uint mode, std::string name = "");
+    // init reads a fragment of an already parsed source from in; at is the
+    // position of its first byte, so that node positions refer to the
+    // original source.
+    void init(std::unique_ptr<std::istream> in, ast::Pos at, err_handler errh, uint mode);
+
+    // error handling
+    ast::Pos pos() const { return _file->At(_offset); }
+    void errorAt(ast::Pos pos, std::string msg);
+    void errorAt(uint line, uint col, std::string msg);
+    void error(std::string msg) { errorAt(pos(), std::move(msg)); }
+    void syntaxErrorAt(ast::Pos pos, std::string msg);
+    void syntaxError(std::string msg) { syntaxErrorAt(pos(), std::move(msg)); }
+    void advance(std::initializer_list<token> followlist = {});
+
+    // directives
+    void directive(uint line, uint col, std::string_view text);
+    std::vector<std::string> takeEmbeds();
+    void clearEmbeds();
+
+    // span records that n covers the source from offset start up to the
+    // end of the last consumed token, unless a nested production that
+    // returned n already did, and returns n.
+    template <typename N>
+    N span(N n, int64_t start) {
+        if (n != nullptr && !n->span.IsKnown()) {
+            n->span = {_file->At(start), uint32_t(std::max(_prev_end - start, int64_t(0)))};
+        }
+        return n;
+    }
+
+    bool got(token tok);
+    void want(token tok);
+    bool gotAssign();
+
+    // declarations
+    ast::FilePtr fileOrNil();
+    template <typename F>
+    ast::Pos list(token sep, token close, F f);
+    void appendGroup(std::vector<ast::DeclNodePtr> &list, ast::DeclNodePtr (parser::*f)(ast::GroupPtr));
+    ast::DeclNodePtr importDecl(ast::GroupPtr group);
+    ast::DeclNodePtr constDecl(ast::GroupPtr group);
+    ast::DeclNodePtr typeDecl(ast::GroupPtr group);
+    ast::DeclNodePtr varDecl(ast::GroupPtr group);
+    std::shared_ptr<ast::FuncDecl> funcDeclOrNil();
+    ast::BlockStmtPtr funcBody();
+    void skipFuncBody(ast::FuncDecl *f);
+
+    // expressions
+    ast::ExprNodePtr expr();
+    ast::ExprNodePtr binaryExpr(ast::ExprNodePtr x, int64_t prec);
+    ast::ExprNodePtr unaryExpr();
+    std::shared_ptr<ast::CallStmt> callStmt();
+    ast::ExprNodePtr operand(bool keep_parens);
+    ast::ExprNodePtr pexpr(ast::ExprNodePtr x, bool keep_parens);
+    std::shared_ptr<ast::CompositeLit> complitexpr(const ast::ExprNode *typ = nullptr);
+    ast::ExprNodePtr bare_complitexpr();
+    int packedElemSize(const ast::ExprNode *typ, uint64_t &max);
+    ast::ExprNodePtr packElems(ast::CompositeLit *x, int size, uint64_t max);
+    void rescanElems(ast::CompositeLit *x, int64_t from, int64_t to);
+
+    // types
+    ast::ExprNodePtr type_();
+    ast::ExprNodePtr typeOrNil();
+    ast::ExprNodePtr chanElem();
+    ast::ExprNodePtr dotname(ast::NamePtr name);
+    ast::FuncTypePtr funcType();
+    std::vector<ast::FieldPtr> funcResult();
+    ast::ExprNodePtr structType();
+    ast::ExprNodePtr interfaceType();
+    void addField(ast::StructType *styp, ast::Pos pos, ast::NamePtr name, ast::ExprNodePtr typ, ast::BasicLitPtr tag);
+    void fieldDecl(ast::StructType *styp);
+    ast::BasicLitPtr oliteral();
+    ast::FieldPtr methodDecl();
+    ast::ExprNodePtr embeddedElem(ast::ExprNodePtr x);
+    ast::ExprNodePtr embeddedTerm();
+    std::vector<ast::FieldPtr> typeParamList();
+    ast::FieldPtr paramDeclOrNil();
+    ast::ExprNodePtr dotsType();
+    std::vector<ast::FieldPtr> paramList();
+    ast::ExprNodePtr badExpr();
+
+    // statements
+    ast::SimpleStmtNodePtr simpleStmt(ast::ExprNodePtr lhs, token keyword);
+    ast::SimpleStmtNodePtr newRangeClause(ast::ExprNodePtr lhs, bool def);
+    ast::SimpleStmtNodePtr newAssignStmt(ast::Pos pos, Operator op, ast::ExprNodePtr lhs, ast::ExprNodePtr rhs);
+    ast::StmtNodePtr labeledStmtOrNil(ast::NamePtr label);
+    ast::BlockStmtPtr blockStmt(std::string context);
+    ast::StmtNodePtr declStmt(ast::DeclNodePtr (parser::*f)(ast::GroupPtr));
+    ast::StmtNodePtr forStmt();
+    void header(token keyword, ast::SimpleStmtNodePtr &init, ast::ExprNodePtr &cond, ast::SimpleStmtNodePtr &post);
+    std::shared_ptr<ast::IfStmt> ifStmt();
+    ast::StmtNodePtr switchStmt();
+    ast::StmtNodePtr selectStmt();
+    ast::CaseClausePtr caseClause();
+    ast::CommClausePtr commClause();
+    ast::StmtNodePtr stmtOrNil();
+    std::vector<ast::StmtNodePtr> stmtList();
+
+    // common productions
+    std::vector<ast::ExprNodePtr> argList(bool &hasDots);
+    ast::NamePtr name();
+    std::vector<ast::NamePtr> nameList(ast::NamePtr first);
+    ast::ExprNodePtr qualifiedName(ast::NamePtr name);
+    ast::ExprNodePtr exprList();
+};
+
+// Parse parses a single Go source file from in and returns the corresponding
+// syntax tree. Errors are reported to errh as they are found; parsing continues
+// after an error so that errh may be called multiple times. If errh is nil,
+// errors are printed. The result is nil if the package clause is missing or
+// malformed, or if the file cannot be added to FileSet::Global() for its
+// position space is exhausted; the files of the trees no longer needed are
+// released from it with FileSet::Release.
+ast::FilePtr Parse(std::unique_ptr<std::istream> in, err_handler errh, uint mode = 0);
+
+// ParseFile behaves like Parse but it reads the source from the named file.
+ast::FilePtr ParseFile(std::string filename, err_handler errh, uint mode = 0);
+
+// ParseFuncBody parses the body of f skipped by a SkipFuncBodies parse and
+// stores it in f->Body. src must be the complete source f was parsed from.
+// It returns f->Body, or nil if f has no skipped body.
+ast::BlockStmtPtr ParseFuncBody(std::string_view src, ast::FuncDecl *f, err_handler errh);
+
+// ParseFuncBodies parses all skipped function bodies of file in parallel.
+// Errors are reported to errh in source order once all bodies are parsed.
+void ParseFuncBodies(std::string_view src, ast::File *file, err_handler errh);
+
+// ParseGoEmbed splits the arguments of a //go:embed directive into patterns.
+// A pattern is either a sequence of non-space characters or a Go string
+// literal. It returns false if args contain an invalid string literal.
+bool ParseGoEmbed(std::string_view args, std::vector<std::string> &patterns);
+
+// unparen removes all parentheses around an expression.
+ast::ExprNodePtr unparen(ast::ExprNodePtr x);
+
+} // namespace syntax
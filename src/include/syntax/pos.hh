@@ -0,0 +1,143 @@
+#pragma once
+#include <compare>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <tbb/spin_mutex.h>
+
+namespace syntax {
+
+// Pos is a compact source position. The files of a FileSet share one 32-bit
+// position space: each file owns the range [base, base + size], and the
+// position of the byte at offset o of the file is base + o. The zero Pos is
+// unknown. Positions compare as integers; those of different files compare
+// in the order in which the files were added, of the files in the set.
+class Pos {
+public:
+    constexpr Pos() = default;
+    constexpr explicit Pos(uint32_t x) : _x(x) {}
+
+    constexpr bool IsKnown() const { return _x != 0; }
+    constexpr uint32_t Raw() const { return _x; }
+    constexpr auto operator<=>(const Pos &) const = default;
+
+private:
+    uint32_t _x = 0;
+};
+
+// Span is the extent of a syntax node: the Len bytes of source starting at
+// Start. The zero Span is unknown.
+struct Span {
+    Pos Start{};
+    uint32_t Len = 0;
+
+    bool IsKnown() const { return Start.IsKnown(); }
+    // End returns the position just after the span.
+    Pos End() const { return Pos(Start.Raw() + Len); }
+};
+
+// Position is the resolved form of a Pos, used for diagnostics. Line and
+// Col are 1-based, Col counts bytes; Offset is the 0-based byte offset.
+struct Position {
+    std::string_view Filename;
+    int Line = 0;
+    int Col = 0;
+    int64_t Offset = 0;
+
+    bool operator==(const Position &) const = default;
+};
+
+// SourceFile is a file of a FileSet. Its line table and a pinned copy of its
+// source are filled while the file is scanned, so any position scanned so
+// far can be resolved and any span scanned so far can be sliced.
+class SourceFile {
+public:
+    SourceFile(std::string name, uint32_t base, uint32_t size) : _name(std::move(name)), _base(base), _size(size) {}
+
+    const std::string &Name() const { return _name; }
+    uint32_t Base() const { return _base; }
+    uint32_t Size() const { return _size; }
+
+    // At returns the position of the byte at offset.
+    Pos At(int64_t offset) const { return Pos(_base + uint32_t(offset)); }
+    // Offset returns the offset of p, which must be a position of the file.
+    int64_t Offset(Pos p) const { return int64_t(p.Raw() - _base); }
+
+    // AddLine records that a line starts at offset. Offsets that do not
+    // follow the last line start are ignored, so rescanning a part of the
+    // file, e.g. a function body, leaves the table unchanged. Lines must
+    // be added by one thread only.
+    void AddLine(int64_t offset) {
+        if (offset > _lines.back() && offset <= int64_t(_size)) {
+            _lines.push_back(uint32_t(offset));
+        }
+    }
+    // Lines returns the offsets of the line starts.
+    std::span<const uint32_t> Lines() const { return _lines; }
+
+    // AddSource appends the bytes read at offset to the pinned source. As
+    // with AddLine, bytes that do not continue the source added so far are
+    // ignored, and the source must be added by one thread only.
+    void AddSource(int64_t offset, std::string_view bytes);
+    // Source returns the part of the source added so far.
+    std::string_view Source() const { return std::string_view(_src.get(), _nsrc); }
+    // Text returns the source of s, which must be a span of the file; it is
+    // empty if that part of the source was not added.
+    std::string_view Text(Span s) const;
+
+    Position Resolve(Pos p) const;
+
+private:
+    std::string _name;
+    uint32_t _base;
+    uint32_t _size;
+    std::vector<uint32_t> _lines{0};
+    // the pinned source is allocated once, so views of it stay valid
+    std::unique_ptr<char[]> _src;
+    uint32_t _nsrc = 0;
+};
+
+// FileSet maps positions to the files they belong to. Adding, releasing
+// and looking up files is safe to call concurrently.
+class FileSet {
+public:
+    // Global returns the process-wide file set used by the parser.
+    static FileSet &Global();
+
+    // AddFile adds a file of the given size. The file lives until it is
+    // released, or as long as the set. It returns nil if the position
+    // space of the set is exhausted.
+    SourceFile *AddFile(std::string name, int64_t size);
+
+    // Release removes the file containing p, if any, and frees its line
+    // table and source; the positions of the file must not be used
+    // afterwards. The position range of the files released after the last
+    // one still in the set is given to the files added next.
+    void Release(Pos p);
+
+    // File returns the file containing p, or nil.
+    SourceFile *File(Pos p) const;
+
+    // Resolve returns the file position of p; unknown positions resolve to
+    // the zero Position.
+    Position Resolve(Pos p) const;
+
+    // Text returns the source of s; it is empty if s is unknown or its
+    // source is not pinned.
+    std::string_view Text(Span s) const;
+
+private:
+    // find returns the index in _files of the file containing the known
+    // position p, or the size of _files; the mutex must be held.
+    size_t find(Pos p) const;
+
+    mutable tbb::spin_mutex _mutex;
+    uint32_t _base = 1; // 0 is the unknown position
+    std::vector<std::unique_ptr<SourceFile>> _files;
+};
+
+} // namespace syntax
@@ -2,12 +2,16 @@
 #include "common/types.hh"
 #include "common/utf8/rune.hh"
 #include "common/hex_formatter.hh"
+#include "syntax/pos.hh"
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <tuple>
 #include <fstream>
+#include <functional>
+#include <memory>
 
 template <typename T>
 std::vector<T> slice(std::vector<T>& v, std::size_t low, std::size_t high = -1) {
@@ -25,7 +29,7 @@ namespace syntax
 
 int64_t nextSize(int64_t size);
 
-typedef void (*err_handler)(uint line, uint col, std::string msg);
+typedef std::function<void(uint line, uint col, std::string msg)> err_handler;
 
 // The source buffer is accessed using three indices b (begin),
 // r (read), and e (end):
@@ -53,27 +57,36 @@ typedef void (*err_handler)(uint line, uint col, std::string msg);
 //
 // Invariant: -1 <= b < r <= e < len(buf) && buf[e] == sentinel
 struct source {
-    std::ifstream _ifs;
+    std::unique_ptr<std::istream> _in;
     err_handler _errh{};
     std::string _buf;
     int64_t _b;
     int64_t _r;
     int64_t _e;
+    // number of bytes of the input that were dropped from the front of _buf
+    int64_t _base;
     int _line;
     int _col;
+    // file whose line table and source are filled while reading, or nil
+    SourceFile *_file = nullptr;
     common::utf8::rune_t _ch;
     int _chw;
 
     void init(std::string file, err_handler errh);
+    // init reads the source from in instead of a named file.
+    void init(std::unique_ptr<std::istream> in, err_handler errh);
     std::pair<int, int> pos();
+    // offset returns the byte offset of _ch from the start of the input.
+    int64_t offset() const { return _base + _r - _chw; }
 
     void error(std::string msg);
 
     void start();
     void stop();
 
-    // std::string segment() { return slice(buf, b, r - chw); }
-    std::string segment();
+    // segment returns the most recently read characters since start();
+    // the view is invalidated by the next call of nextch.
+    std::string_view segment();
 
     void rewind();
 
@@ -0,0 +1,400 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "syntax/ast/nodes.hh"
+#include "syntax/types/object.hh"
+#include "syntax/types/scope.hh"
+#include "syntax/types/type.hh"
+
+namespace types {
+
+    class Importer;
+
+    // Error is a type checking diagnostic.
+    struct Error {
+        syntax::Pos Pos;
+        std::string Msg;
+    };
+
+    // Instance is an instantiation of a generic function: explicit, as in
+    // F[int], or with type arguments inferred from the arguments of a call.
+    struct Instance {
+        Object *Func = nullptr;
+        std::vector<TypeId> TypeArgs; // parallel to Func->TParams
+        TypeId Type = 0;              // the signature with the type arguments substituted
+    };
+
+    // Checker type-checks one package.
+    //
+    // Checking runs in two phases. First the package-level declarations of
+    // all files are collected and resolved into a dependency graph, whose
+    // nodes are the package-level objects and whose edges are the objects a
+    // declaration refers to outside function bodies. The declarations are
+    // checked sequentially, one strongly connected component of the graph
+    // at a time with dependencies first; a cycle through a constant or
+    // variable is an error. Once all package-level objects are known, the
+    // function bodies only read them, so each body is checked as an
+    // independent work unit on the TBB thread pool. Each unit records its
+    // own diagnostics, and all diagnostics are sorted by position at the
+    // end, so the result does not depend on the schedule.
+    //
+    // The types of expressions are recorded in ast::ExprNode::typ. Imported
+    // packages are read from their export data through the importer, which
+    // decodes only the objects the package uses. Selectors on packages the
+    // importer does not have, or on all packages if there is no importer,
+    // are left untyped and do not cause errors.
+    //
+    // A generic function is checked once, with its type parameters as
+    // types of their own whose operations are those all the types of their
+    // type set allow. Its uses instantiate it with type arguments, given or
+    // inferred by unifying the parameter types with the argument types, that
+    // must satisfy the constraints; the instances are recorded by the name
+    // of the function used.
+    //
+    // The package scope is enclosed by the universe, or by an outer scope
+    // whose objects the package refers to as its own: this checks code
+    // lifted out of another package, such as the inlinable function bodies
+    // of its export data, against that package's objects. Objects of the
+    // outer scope are shared, like imported ones, and never written.
+    class Checker {
+    public:
+        explicit Checker(Importer *importer = nullptr, const Scope *outer = nullptr);
+        ~Checker();
+        Checker(const Checker &) = delete;
+        Checker &operator=(const Checker &) = delete;
+
+        // Check type-checks the files of a package and returns the errors
+        // sorted by position. If parallel is false, the function bodies are
+        // checked one after the other on the calling thread.
+        std::vector<Error> Check(std::span<ast::File *const> files, bool parallel = true);
+
+        // Name returns the package name.
+        std::string_view Name() const { return _name; }
+
+        // Scope returns the package scope.
+        const Scope &PackageScope() const { return *_pkg; }
+
+        // Objects returns the package-level objects, including methods, in
+        // declaration order.
+        std::span<Object *const> Objects() const { return _decl_order; }
+
+        Importer *GetImporter() const { return _importer; }
+
+        // ObjectOf returns the object a name denotes or declares, or nil.
+        Object *ObjectOf(const ast::Name *name) const;
+
+        // Implicit returns the variable a type switch with a short variable
+        // declaration declares for the clause c, or nil.
+        Object *Implicit(const ast::CaseClause *c) const;
+
+        // InstanceOf returns the instance of the generic function named by
+        // name, or nil if name does not denote an instantiated generic
+        // function.
+        const Instance *InstanceOf(const ast::Name *name) const;
+
+        // Methods returns the methods declared on the named type t, by this
+        // package or by an imported one.
+        std::span<Object *const> Methods(TypeId t) const;
+
+        // InitOrder returns the package-level variables in the order in
+        // which they are initialized.
+        const std::vector<Object *> &InitOrder() const { return _init_order; }
+
+        struct Context;
+        struct DeclInfo;
+
+    private:
+        friend struct Context;
+
+        void collect(Context &ctx, ast::File *file, Scope *fileScope);
+        void declare(Context &ctx, Scope *scope, Object *obj);
+        std::vector<std::vector<Object *>> components();
+        void objDecl(Context &ctx, Object *obj);
+        void constDecl(Context &ctx, Object *obj, DeclInfo &d);
+        void varDecl(Context &ctx, Object *obj, DeclInfo &d);
+        void typeDecl(Context &ctx, Object *obj, DeclInfo &d);
+        void funcDecl(Context &ctx, Object *obj, DeclInfo &d);
+        void initOrder(std::vector<Error> &errors);
+        void merge(Context &ctx, std::vector<Error> &errors);
+
+        Importer *_importer;
+        const Scope *_outer;
+        std::string _name;
+        std::unique_ptr<Scope> _pkg;
+        std::deque<Scope> _file_scopes;
+        std::deque<Object> _objects;
+        // the package-level objects in declaration order, with their
+        // declarations
+        std::vector<Object *> _decl_order;
+        std::unordered_map<const Object *, std::unique_ptr<DeclInfo>> _decls;
+        std::vector<Object *> _imports;
+        std::unordered_map<TypeId, Object *> _type_names;           // named type -> its TypeName
+        std::unordered_map<TypeId, std::vector<Object *>> _methods; // named type -> methods
+        // method declarations by the name of their receiver base type
+        std::unordered_map<common::SymbolId, std::vector<Object *>> _method_decls;
+        std::unordered_map<const ast::Name *, Object *> _uses;
+        std::unordered_map<const ast::CaseClause *, Object *> _implicits;
+        std::unordered_map<const ast::Name *, Instance> _instances;
+        std::vector<std::deque<Object>> _locals;
+        std::vector<Object *> _init_order;
+    };
+
+    // DeclInfo describes the declaration of a package-level object.
+    struct Checker::DeclInfo {
+        enum State : uint8_t { Unresolved, Resolving, Resolved };
+
+        Scope *FileScope = nullptr;
+        ast::ExprNode *Type = nullptr; // declared type, if any
+        ast::ExprNode *Init = nullptr; // initialization expression(s), if any
+        // Lhs lists all variables of a declaration like var a, b = f() that
+        // are initialized by a single expression; empty otherwise.
+        std::vector<Object *> Lhs;
+        int64_t Iota = 0;    // value of iota for a constant
+        size_t Index = 0;    // index of the object in its name list
+        ast::FuncDecl *Func = nullptr;
+        TypeId Recv = 0; // receiver type of a method
+        // TParams are the type names of the type parameters of a generic
+        // function, declared in its body.
+        std::vector<Object *> TParams;
+        State state = Unresolved;
+        bool Cyclic = false; // a cycle through the declaration was reported
+        // Deps are the package-level objects the declaration refers to,
+        // outside function bodies; Uses adds those the function body of a
+        // function refers to, for the initialization order.
+        std::vector<Object *> Deps;
+        std::vector<Object *> Uses;
+    };
+
+    // Mode is the kind of value an expression denotes.
+    enum class Mode : uint8_t {
+        Invalid,  // the expression has errors, which were reported
+        NoValue,  // a call without results
+        Builtin,  // a built-in function
+        TypeExpr, // a type
+        Constant, // a constant
+        Variable, // an addressable value
+        MapIndex, // a map index expression, usable in comma-ok form
+        Value,    // a computed value
+        CommaOk,  // a receive or type assertion, usable in comma-ok form
+    };
+
+    // Operand is the result of checking an expression.
+    struct Operand {
+        Mode mode = Mode::Invalid;
+        TypeId type = 0;
+        ast::ExprNode *expr = nullptr;
+        BuiltinId builtin = BuiltinId::Append;
+        // value of a constant; unknown if it could not be computed
+        Value val;
+        // results of a call with more than one result
+        std::span<const TypeId> tuple;
+        // generic function denoted by a function value that is not
+        // instantiated yet, and the type arguments given so far
+        Object *generic = nullptr;
+        std::span<const TypeId> targs;
+
+        bool Invalid() const { return mode == Mode::Invalid; }
+    };
+
+    // Context holds the state of checking one unit of work: the package-level
+    // declarations, or one function body. A Context is only used by one
+    // thread at a time.
+    struct Checker::Context {
+        Context(Checker &check, const Scope *outer) : check(check), table(TypeTable::Global()), blocks(outer) {}
+
+        Checker &check;
+        TypeTable &table;
+        BlockScopes blocks; // enclosed by the file scope of the declaration being checked
+        ScopeId scope = NoScope; // innermost block scope; NoScope outside function bodies
+        std::vector<Error> errors;
+        std::deque<Object> objects; // local objects
+        std::vector<std::pair<const ast::Name *, Object *>> uses;
+        std::vector<std::pair<const ast::CaseClause *, Object *>> implicits;
+        std::vector<std::pair<const ast::Name *, Instance>> instances;
+        std::deque<std::vector<TypeId>> targ_lists; // storage of Operand::targs
+        // sink receives the package-level objects used; deps collects them
+        // for a function body
+        std::vector<Object *> *sink = nullptr;
+        std::vector<Object *> deps;
+        // local variables declared, to report the unused ones
+        std::vector<Object *> vars;
+        // calls of the built-in panic, for the terminating statement analysis
+        std::unordered_set<const ast::CallExpr *> panics;
+        // shifts of untyped constants by non-constant counts, whose type
+        // comes from the context, see updateType
+        std::unordered_set<const ast::Operation *> delayed_shifts;
+
+        // state of the function being checked
+        struct Label {
+            syntax::Pos Pos;
+            bool Used = false;
+        };
+        struct Target {
+            common::SymbolId Label; // 0 if unlabeled
+            bool Loop;
+        };
+        TypeId sig = 0;
+        bool named_results = false;
+        std::unordered_map<common::SymbolId, Label> labels;
+        std::vector<Target> targets;        // enclosing loops, switches and selects
+        common::SymbolId pending_label = 0; // label of the statement being checked
+        int64_t iota = -1;           // value of iota, -1 outside a constant declaration
+
+        void errorf(syntax::Pos pos, std::string msg);
+        void error(ast::Node *n, std::string msg) { errorf(n->pos, std::move(msg)); }
+        // describe formats an operand for diagnostics, e.g. "x (variable of type int)".
+        std::string describe(const Operand &x);
+
+        // scopes and objects
+        void openScope();
+        void closeScope();
+        Object *newObject(ObjKind kind, const ast::Name *name, TypeId type);
+        void declare(Object *obj, const ast::Name *name);
+        Object *declareVar(const ast::Name *name, TypeId type);
+        Object *lookup(const ast::Name *name);
+        void use(const ast::Name *name, Object *obj, bool value = true);
+
+        // expressions (expr.cc)
+        void rawExpr(Operand &x, ast::ExprNode *e, TypeId hint);
+        void exprInternal(Operand &x, ast::ExprNode *e, TypeId hint);
+        void expr(Operand &x, ast::ExprNode *e, TypeId hint = 0);
+        void multiExpr(Operand &x, ast::ExprNode *e, TypeId hint = 0);
+        void value(Operand &x);
+        void singleValue(Operand &x);
+        void exprOrType(Operand &x, ast::ExprNode *e);
+        void ident(Operand &x, ast::Name *e);
+        void object(Operand &x, ast::Name *e, Object *obj);
+        void basicLit(Operand &x, ast::BasicLit *e);
+        void compositeLit(Operand &x, ast::CompositeLit *e, TypeId hint);
+        void funcLit(Operand &x, ast::FuncLit *e);
+        void selector(Operand &x, ast::SelectorExpr *e);
+        void index(Operand &x, ast::IndexExpr *e);
+        void sliceExpr(Operand &x, ast::SliceExpr *e);
+        void unary(Operand &x, ast::Operation *e);
+        void binary(Operand &x, ast::Operation *e, ast::ExprNode *lhs, ast::ExprNode *rhs, syntax::Operator op);
+        void shift(Operand &x, Operand &y, ast::Operation *e, syntax::Operator op);
+        void comparison(Operand &x, Operand &y, syntax::Operator op);
+        void overflow(Operand &x, ast::Node *at, syntax::Operator op, bool unary);
+        void call(Operand &x, ast::CallExpr *e);
+        std::vector<Operand> argumentValues(ast::CallExpr *e, TypeId sig);
+        void arguments(ast::CallExpr *e, TypeId sig, std::vector<Operand> &xs);
+        void builtin(Operand &x, ast::CallExpr *e, BuiltinId id);
+        void conversion(Operand &x, TypeId t);
+        bool indexValue(ast::ExprNode *e, int64_t max, int64_t &val);
+        void matchTypes(Operand &x, Operand &y);
+        bool convertUntyped(Operand &x, TypeId target);
+        void updateType(ast::ExprNode *e, TypeId t);
+        void assignment(Operand &x, TypeId t, std::string_view context);
+        bool assignable(const Operand &x, TypeId t);
+        void useExprs(std::span<const ast::ExprNodePtr> list);
+        TypeId under(TypeId t);
+
+        // generic functions (instantiate.cc)
+        void typeParams(std::span<const ast::FieldPtr> list, Object *fn, DeclInfo &d);
+        void funcInst(Operand &x, ast::IndexExpr *e);
+        bool infer(ast::CallExpr *e, const Operand &x, std::span<const Operand> args, std::vector<TypeId> &targs);
+        void instantiate(Operand &x, ast::Node *at, std::vector<TypeId> targs);
+        bool satisfies(TypeId targ, TypeId constraint, std::string &cause);
+        TypeId coreType(TypeId t);
+        bool convertibleTo(TypeId v, TypeId t);
+
+        // type expressions (typexpr.cc)
+        TypeId typExpr(ast::ExprNode *e, bool constraint = false);
+        TypeId constraint(ast::ExprNode *e);
+        bool typeTerms(ast::ExprNode *e, std::vector<TypeId> &terms);
+        TypeId arrayLength(ast::ExprNode *e, TypeId elem);
+        TypeId funcType(ast::FuncType *e);
+        TypeId structType(ast::StructType *e);
+        TypeId interfaceType(ast::InterfaceType *e);
+        void declareParams(ast::FuncType *e, ast::Field *recv, TypeId sig, TypeId recvType);
+
+        // statements (stmt.cc)
+        void funcBody(ast::FuncType *type, ast::Field *recv, TypeId sig, TypeId recvType, ast::BlockStmt *body);
+        void collectLabels(std::span<const ast::StmtNodePtr> list);
+        void stmtList(std::span<const ast::StmtNodePtr> list, bool fallthroughOk);
+        bool isTerminating(ast::StmtNode *s, common::SymbolId label);
+        void stmt(ast::StmtNode *s, bool fallthroughOk);
+        void simpleStmt(ast::SimpleStmtNode *s);
+        void declStmt(ast::DeclStmt *s);
+        void localConst(ast::ConstDecl *d, ast::ConstDecl *last, int64_t iota);
+        void localVar(ast::VarDecl *d);
+        void localType(ast::TypeDecl *d);
+        void assignStmt(ast::AssignStmt *s);
+        void shortVarDecl(ast::AssignStmt *s, std::span<const ast::ExprNodePtr> lhs,
+                          std::span<const ast::ExprNodePtr> rhs);
+        void assignVars(std::span<const ast::ExprNodePtr> lhs, std::span<const ast::ExprNodePtr> rhs, ast::Node *at);
+        void initVars(std::span<Object *const> lhs, std::span<const ast::ExprNodePtr> rhs, ast::Node *at);
+        void assignVar(ast::ExprNode *lhs, Operand &x);
+        bool unpack(std::span<const ast::ExprNodePtr> rhs, size_t n, std::vector<Operand> &xs);
+        void mismatch(std::span<const ast::ExprNodePtr> rhs, size_t n, const std::vector<Operand> &xs,
+                      ast::Node *at);
+        void returnStmt(ast::ReturnStmt *s);
+        void ifStmt(ast::IfStmt *s);
+        void forStmt(ast::ForStmt *s);
+        void rangeStmt(ast::ForStmt *s, ast::RangeClause *r);
+        void switchStmt(ast::SwitchStmt *s);
+        void typeSwitchStmt(ast::SwitchStmt *s, ast::TypeSwitchGuard *g);
+        void selectStmt(ast::SelectStmt *s);
+        void branchStmt(ast::BranchStmt *s, bool fallthroughOk);
+    };
+
+    // predicates and lookups (predicates.cc)
+
+    bool IsUntyped(TypeId t);
+    bool IsBoolean(TypeId t);
+    bool IsInteger(TypeId t);
+    bool IsUnsigned(TypeId t);
+    bool IsFloat(TypeId t);
+    bool IsComplex(TypeId t);
+    bool IsNumeric(TypeId t);
+    bool IsString(TypeId t);
+    bool IsInterface(TypeId t);
+    bool IsConstType(TypeId t);
+    // Comparable reports whether values of type t can be compared with ==.
+    bool Comparable(TypeId t);
+    // Ordered reports whether values of type t can be compared with <.
+    bool Ordered(TypeId t);
+    // HasNil reports whether nil is assignable to type t.
+    bool HasNil(TypeId t);
+    // TermSubset reports whether the type set of the term a, T or ~T, is a
+    // subset of that of the term b.
+    bool TermSubset(TypeId a, TypeId b);
+    // Subst returns t with the type parameters tparams replaced by the type
+    // arguments targs.
+    TypeId Subst(TypeId t, std::span<const TypeId> tparams, std::span<const TypeId> targs);
+    // DefaultType returns the type an untyped constant of type t assumes
+    // where a typed value is needed.
+    TypeId DefaultType(TypeId t);
+
+    // Selection describes the result of looking up a field or method.
+    struct Selection {
+        enum Kind : uint8_t { None, Field, Method, Ambiguous };
+        Kind kind = None;
+        TypeId type = 0;         // type of the field, or signature of the method
+        Object *method = nullptr; // declared method; nil for interface methods
+        std::vector<int> index;  // path of field indices to the field or the embedded method receiver
+        bool indirect = false;    // a pointer is dereferenced on the path
+    };
+
+    // LookupFieldOrMethod looks up the field or method name of type t, or
+    // of the type t points to, including those promoted from embedded
+    // fields. Methods of named types come from check.
+    Selection LookupFieldOrMethod(const Checker &check, TypeId t, common::SymbolId name);
+
+    // Sizeof and Alignof return the size and alignment of values of type t
+    // on 64-bit targets.
+    int64_t Sizeof(TypeId t);
+    int64_t Alignof(TypeId t);
+
+    // MissingMethod returns the first method of the interface iface that
+    // type t does not implement, or 0 if it implements all.
+    common::SymbolId MissingMethod(const Checker &check, TypeId t, TypeId iface);
+
+} // namespace types
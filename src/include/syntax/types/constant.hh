@@ -0,0 +1,165 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "syntax/tokens.hh"
+
+namespace types {
+
+    // BigInt is an arbitrary-precision integer: a sign and the 32-bit words of
+    // the magnitude, least significant first, without leading zero words.
+    class BigInt {
+    public:
+        BigInt() = default;
+        explicit BigInt(int64_t v);
+        static BigInt FromUint64(uint64_t v);
+        // Parse returns the value of the digits in the given base; '_'
+        // separators are skipped. The digits must be valid.
+        static BigInt Parse(std::string_view digits, int base);
+        // Pow10 returns 10**n.
+        static BigInt Pow10(uint32_t n);
+
+        int Sign() const { return _mag.empty() ? 0 : _neg ? -1 : 1; }
+        // BitLen returns the length of the magnitude in bits.
+        int64_t BitLen() const;
+        bool IsInt64() const;
+        int64_t Int64() const; // the low 64 bits, as two's complement
+        bool IsUint64() const;
+        std::string String() const;
+
+        BigInt operator-() const;
+        friend BigInt operator+(const BigInt &a, const BigInt &b);
+        friend BigInt operator-(const BigInt &a, const BigInt &b);
+        friend BigInt operator*(const BigInt &a, const BigInt &b);
+        // the quotient truncated towards zero and its remainder
+        friend BigInt operator/(const BigInt &a, const BigInt &b);
+        friend BigInt operator%(const BigInt &a, const BigInt &b);
+        // the bitwise operators act on the infinite two's complement form
+        friend BigInt operator&(const BigInt &a, const BigInt &b);
+        friend BigInt operator|(const BigInt &a, const BigInt &b);
+        friend BigInt operator^(const BigInt &a, const BigInt &b);
+        BigInt operator~() const;
+        BigInt operator<<(uint64_t s) const;
+        BigInt operator>>(uint64_t s) const; // rounds towards negative infinity
+        // Cmp returns -1, 0 or +1 as a is less than, equal to or greater than b.
+        static int Cmp(const BigInt &a, const BigInt &b);
+        static BigInt Gcd(BigInt a, BigInt b);
+
+        friend bool operator==(const BigInt &a, const BigInt &b) { return a._neg == b._neg && a._mag == b._mag; }
+
+    private:
+        bool _neg = false;
+        std::vector<uint32_t> _mag;
+    };
+
+    // ConstKind is the kind of a constant Value.
+    enum class ConstKind : uint8_t {
+        Unknown, // the value of an erroneous or overflowing expression
+        Bool,
+        String,
+        Int,
+        Float, // an exact rational value
+        Complex,
+    };
+
+    // Value is the exact value of a constant expression. Integers that fit
+    // in an int64 and rationals whose numerator and denominator both do are
+    // held inline and computed with machine arithmetic; a result that does
+    // not fit is promoted to a shared, immutable BigInt representation. So
+    // iota tables, bit masks and decimal literals fold without allocation.
+    class Value {
+    public:
+        Value() = default;
+        static Value MakeBool(bool b);
+        static Value MakeString(std::string s);
+        static Value MakeInt64(int64_t v);
+        static Value MakeUint64(uint64_t v);
+        static Value MakeInt(BigInt v);
+        // MakeRat returns the Float num/den in lowest terms, or an unknown
+        // value if den is zero.
+        static Value MakeRat(BigInt num, BigInt den);
+        static Value MakeRat(int64_t num, int64_t den);
+        // MakeFloat64 returns the exact value of a finite f.
+        static Value MakeFloat64(double f);
+        // MakeComplex returns re + im*i of two Int or Float values.
+        static Value MakeComplex(const Value &re, const Value &im);
+        // MakeFromLiteral returns the value of a literal of the given kind,
+        // or an unknown value if it is malformed or its exponent exceeds the
+        // supported range.
+        static Value MakeFromLiteral(std::string_view lit, syntax::LitKind kind);
+
+        ConstKind Kind() const { return _kind; }
+        bool IsKnown() const { return _kind != ConstKind::Unknown; }
+        // IsInline reports whether the value is held without a heap allocation.
+        bool IsInline() const { return _rep == nullptr; }
+
+        bool BoolVal() const { return _num != 0; }
+        std::string_view StringVal() const;
+        // Int64Val and Uint64Val return the value of an Int, if it fits.
+        std::optional<int64_t> Int64Val() const;
+        std::optional<uint64_t> Uint64Val() const;
+        // Float64Val returns the nearest float64 to a numeric value; Float32Val
+        // rounds to float32 precision. Both return ±Inf if the value is out
+        // of range.
+        double Float64Val() const;
+        float Float32Val() const;
+        // Sign returns the sign of an Int or Float; for a Complex, 0 if both
+        // parts are 0 and 1 otherwise.
+        int Sign() const;
+        // BitLen returns the bit length of the magnitude of an Int.
+        int64_t BitLen() const;
+        // Num and Denom return the numerator and denominator of an Int or Float.
+        BigInt Num() const;
+        BigInt Denom() const;
+        // Real and Imag return the parts of a numeric value.
+        Value Real() const;
+        Value Imag() const;
+
+        // ToInt, ToFloat and ToComplex convert a numeric value to the given
+        // kind; the result is unknown if the value is not exactly representable.
+        Value ToInt() const;
+        Value ToFloat() const;
+        Value ToComplex() const;
+
+        // String formats the value for diagnostics: floats are shown with
+        // six significant digits and long values are shortened.
+        std::string String() const;
+
+    private:
+        struct Rep;
+        Value(ConstKind kind, int64_t num, int64_t den) : _kind(kind), _num(num), _den(den) {}
+        // makeRat returns the Float num/den for den > 0, inline if it fits.
+        static Value makeRat(__int128 num, __int128 den);
+        const Rep &rep() const { return *_rep; }
+
+        ConstKind _kind = ConstKind::Unknown;
+        // inline Bool (0 or 1), Int, or Float _num/_den in lowest terms with
+        // _den > 0; neither is INT64_MIN so that negation cannot overflow
+        int64_t _num = 0;
+        int64_t _den = 1;
+        std::shared_ptr<const Rep> _rep;
+
+        friend Value UnaryOp(syntax::Operator op, const Value &x, unsigned prec);
+        friend Value BinaryOp(const Value &x, syntax::Operator op, const Value &y);
+        friend Value Shift(const Value &x, syntax::Operator op, uint64_t s);
+        friend bool Compare(const Value &x, syntax::Operator op, const Value &y);
+    };
+
+    // UnaryOp returns op x for + - ^ and !. For ^, prec is the size in bits of
+    // an unsigned operand type, whose bits are complemented; 0 otherwise.
+    Value UnaryOp(syntax::Operator op, const Value &x, unsigned prec);
+    // BinaryOp returns x op y for the arithmetic, bitwise and logical
+    // operators. The operands are converted to the larger of their kinds
+    // first; / on two Ints truncates. The result is unknown if either
+    // operand is, or for a division by zero.
+    Value BinaryOp(const Value &x, syntax::Operator op, const Value &y);
+    // Shift returns x << s or x >> s for an Int x.
+    Value Shift(const Value &x, syntax::Operator op, uint64_t s);
+    // Compare returns x op y for a comparison operator op.
+    bool Compare(const Value &x, syntax::Operator op, const Value &y);
+
+} // namespace types
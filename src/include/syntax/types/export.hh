@@ -0,0 +1,181 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <libcuckoo/cuckoohash_map.hh>
+
+#include "common/mapped_file.hh"
+#include "syntax/types/check.hh"
+#include "syntax/types/export_data_generated.h"
+
+namespace types {
+
+// Version is bumped whenever the encoding of export data changes.
+#define ExportDataVersion 4
+
+    // IsExported reports whether name starts with an upper-case letter.
+    // Only ASCII letters are recognized.
+    inline bool IsExported(std::string_view name) { return !name.empty() && name[0] >= 'A' && name[0] <= 'Z'; }
+
+    // InlineBodies maps the functions and methods of a package that other
+    // packages may inline to the source of their bodies, and its generic
+    // functions, which they instantiate, to their dictionary layouts, in
+    // the form of export_data.fbs.
+    using InlineBodies = std::unordered_map<const Object *, std::string>;
+
+    // LeakSummaries maps the functions and methods of a package to their
+    // escape summaries, in the form of Object.leaks of export_data.fbs, for
+    // the escape analysis of the packages calling them.
+    using LeakSummaries = std::unordered_map<const Object *, std::vector<int32_t>>;
+
+    // Export serializes the package-level objects of the package checked by
+    // check, with import path path, and the types they refer to into a
+    // finished export data buffer (see export_data.fbs), with the bodies
+    // of the functions in bodies and the escape summaries in leaks, if any.
+    // Named types of imported packages
+    // are referenced by package and name; the package must have been
+    // checked without errors.
+    flatbuffers::DetachedBuffer Export(const Checker &check, std::string_view path,
+                                       const InlineBodies *bodies = nullptr, const LeakSummaries *leaks = nullptr);
+
+    class ImportedPackage;
+
+    // Importer resolves import paths to the export data of packages. The
+    // named types decoded from export data are registered with the
+    // importer, which finds their methods: all packages importing a
+    // package through one importer share its types.
+    class Importer {
+    public:
+        virtual ~Importer() = default;
+
+        // Import returns the package with the given import path, or nil if
+        // there is no usable export data for it. It may be called
+        // concurrently.
+        virtual ImportedPackage *Import(std::string_view path) = 0;
+
+        // Owner returns the imported package that declares the named type
+        // t, or nil.
+        ImportedPackage *Owner(TypeId t) const {
+            ImportedPackage *pkg = nullptr;
+            _owners.find(t, pkg);
+            return pkg;
+        }
+
+    private:
+        friend class ImportedPackage;
+        cuckoohash_map<TypeId, ImportedPackage *> _owners{64};
+    };
+
+    // ImportedPackage is the export data of a package, read in place.
+    // Nothing is decoded up front: opening it checks the root table and
+    // the name index, and Lookup binary-searches the index and decodes the
+    // object found, with the types it refers to, on first use. Each
+    // object, type and method set is verified and decoded once, so the
+    // cost of an import is proportional to what the importer uses, not to
+    // the size of the package. Malformed entries, which are only detected
+    // when they are decoded, read as missing objects and invalid types.
+    // All methods may be called concurrently.
+    class ImportedPackage {
+    public:
+        // Open maps the export data file at file. It returns nil if it
+        // cannot be read or is not export data of the current version.
+        static std::unique_ptr<ImportedPackage> Open(const std::string &file, Importer &importer);
+        // Read is like Open for export data in memory.
+        static std::unique_ptr<ImportedPackage> Read(flatbuffers::DetachedBuffer data, Importer &importer);
+
+        ~ImportedPackage();
+        ImportedPackage(const ImportedPackage &) = delete;
+        ImportedPackage &operator=(const ImportedPackage &) = delete;
+
+        std::string_view Path() const;
+        std::string_view Name() const;
+        // Size returns the number of package-level objects.
+        size_t Size() const { return _pkg->names()->size(); }
+
+        // Lookup returns the package-level object of the given name, or
+        // nil. Unexported objects are found too.
+        Object *Lookup(common::SymbolId name);
+
+        // Methods returns the methods of the named type t, which must be
+        // declared by this package.
+        std::span<Object *const> Methods(TypeId t);
+
+        // Decoded returns the number of objects and types decoded so far.
+        size_t Decoded() const { return _decoded.load(std::memory_order_relaxed); }
+
+    private:
+        ImportedPackage(Importer &importer, const uint8_t *data, size_t size, const exportdata::Package *pkg);
+        static std::unique_ptr<ImportedPackage> open(Importer &importer, const uint8_t *data, size_t size);
+
+        template <typename T> bool verify(const T *entry) const;
+        int64_t find(std::string_view name) const;
+        Object *object(uint32_t i);
+        TypeId type(uint32_t ref);
+        TypeId &typeSlot(uint32_t i);
+        Value value(const exportdata::Object *d) const;
+
+        Importer &_importer;
+        std::unique_ptr<common::MappedFile> _map;
+        flatbuffers::DetachedBuffer _buf;
+        const uint8_t *_data = nullptr;
+        size_t _size = 0;
+        const exportdata::Package *_pkg;
+        // the decoded objects and types are kept by index in chunks
+        // allocated when first written, so that opening a package does not
+        // allocate in proportion to its size
+        static constexpr int chunk_bits = 10;
+        static constexpr size_t chunk_size = size_t(1) << chunk_bits;
+        // decoded objects, nil until decoded; published once complete, so
+        // that a hit needs no lock
+        std::unique_ptr<std::atomic<std::atomic<Object *> *>[]> _objs;
+        std::atomic<size_t> _decoded{0};
+
+        // mu guards decoding and the fields below. It is recursive since a
+        // type refers to other types, and it is only held while decoding:
+        // a package may lock the packages it imports but not the reverse.
+        std::recursive_mutex _mu;
+        std::deque<Object> _objects;                   // the decoded objects and methods
+        std::vector<std::unique_ptr<TypeId[]>> _types; // decoded types, 0 until decoded
+        std::unordered_map<TypeId, uint32_t> _named;   // named type -> index of its description
+        std::deque<std::vector<Object *>> _method_lists;
+        // the decoded methods of the named types, read without the lock
+        cuckoohash_map<TypeId, const std::vector<Object *> *> _methods{16};
+    };
+
+    // DirImporter imports packages from the export data files in a
+    // directory, where the package with import path p is p.x, or from
+    // memory if there is no directory. Packages are opened on first import
+    // and kept until the importer is destroyed.
+    class DirImporter : public Importer {
+    public:
+        explicit DirImporter(std::string dir = "");
+
+        ImportedPackage *Import(std::string_view path) override;
+
+        // File returns the path of the export data file of the package with
+        // the given import path.
+        std::string File(std::string_view path) const;
+
+        // Add makes data the export data of the package with the given
+        // import path. With a directory, data is written to its file, by a
+        // temporary file renamed into place so that concurrent readers
+        // never see a partial file, and mapped back from there; otherwise
+        // it is kept in memory. It reports whether the data was stored. The
+        // package must not have been imported before.
+        bool Add(std::string_view path, flatbuffers::DetachedBuffer data);
+
+    private:
+        std::string _dir;
+        std::mutex _mu; // guards _packages
+        std::unordered_map<std::string, std::unique_ptr<ImportedPackage>> _packages; // nil if not importable
+    };
+
+} // namespace types
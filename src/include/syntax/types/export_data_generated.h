@@ -0,0 +1,618 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+
+#ifndef FLATBUFFERS_GENERATED_EXPORTDATA_TYPES_EXPORTDATA_H_
+#define FLATBUFFERS_GENERATED_EXPORTDATA_TYPES_EXPORTDATA_H_
+
+#include "flatbuffers/flatbuffers.h"
+
+namespace types {
+namespace exportdata {
+
+struct Method;
+
+struct Type;
+
+struct Object;
+
+struct Package;
+
+/// Method is a method of a named type.
+struct Method FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_NAME = 4,
+    VT_SIG = 6,
+    VT_PTR_RECV = 8,
+    VT_BODY = 10,
+    VT_LEAKS = 12
+  };
+  const flatbuffers::String *name() const {
+    return GetPointer<const flatbuffers::String *>(VT_NAME);
+  }
+  /// TypeRef of the signature, without the receiver
+  uint32_t sig() const {
+    return GetField<uint32_t>(VT_SIG, 0);
+  }
+  bool ptr_recv() const {
+    return GetField<uint8_t>(VT_PTR_RECV, 0) != 0;
+  }
+  /// source of the inlinable body, if any; see Object.body
+  const flatbuffers::String *body() const {
+    return GetPointer<const flatbuffers::String *>(VT_BODY);
+  }
+  /// escape summary of the parameters, if any; see Object.leaks
+  const flatbuffers::Vector<int32_t> *leaks() const {
+    return GetPointer<const flatbuffers::Vector<int32_t> *>(VT_LEAKS);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyOffset(verifier, VT_NAME) &&
+           verifier.VerifyString(name()) &&
+           VerifyField<uint32_t>(verifier, VT_SIG) &&
+           VerifyField<uint8_t>(verifier, VT_PTR_RECV) &&
+           VerifyOffset(verifier, VT_BODY) &&
+           verifier.VerifyString(body()) &&
+           VerifyOffset(verifier, VT_LEAKS) &&
+           verifier.VerifyVector(leaks()) &&
+           verifier.EndTable();
+  }
+};
+
+struct MethodBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_name(flatbuffers::Offset<flatbuffers::String> name) {
+    fbb_.AddOffset(Method::VT_NAME, name);
+  }
+  void add_sig(uint32_t sig) {
+    fbb_.AddElement<uint32_t>(Method::VT_SIG, sig, 0);
+  }
+  void add_ptr_recv(bool ptr_recv) {
+    fbb_.AddElement<uint8_t>(Method::VT_PTR_RECV, static_cast<uint8_t>(ptr_recv), 0);
+  }
+  void add_body(flatbuffers::Offset<flatbuffers::String> body) {
+    fbb_.AddOffset(Method::VT_BODY, body);
+  }
+  void add_leaks(flatbuffers::Offset<flatbuffers::Vector<int32_t>> leaks) {
+    fbb_.AddOffset(Method::VT_LEAKS, leaks);
+  }
+  explicit MethodBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  MethodBuilder &operator=(const MethodBuilder &);
+  flatbuffers::Offset<Method> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<Method>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Method> CreateMethod(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    flatbuffers::Offset<flatbuffers::String> name = 0,
+    uint32_t sig = 0,
+    bool ptr_recv = false,
+    flatbuffers::Offset<flatbuffers::String> body = 0,
+    flatbuffers::Offset<flatbuffers::Vector<int32_t>> leaks = 0) {
+  MethodBuilder builder_(_fbb);
+  builder_.add_leaks(leaks);
+  builder_.add_body(body);
+  builder_.add_sig(sig);
+  builder_.add_name(name);
+  builder_.add_ptr_recv(ptr_recv);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<Method> CreateMethodDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    const char *name = nullptr,
+    uint32_t sig = 0,
+    bool ptr_recv = false,
+    const char *body = nullptr,
+    const std::vector<int32_t> *leaks = nullptr) {
+  auto name__ = name ? _fbb.CreateString(name) : 0;
+  auto body__ = body ? _fbb.CreateString(body) : 0;
+  auto leaks__ = leaks ? _fbb.CreateVector<int32_t>(*leaks) : 0;
+  return types::exportdata::CreateMethod(
+      _fbb,
+      name__,
+      sig,
+      ptr_recv,
+      body__,
+      leaks__);
+}
+
+struct Type FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_KIND = 4,
+    VT_VARIADIC = 6,
+    VT_LEN = 8,
+    VT_ELEMS = 10,
+    VT_NAMES = 12,
+    VT_EMBEDDED = 14,
+    VT_NAME = 16,
+    VT_PKG = 18,
+    VT_UNDERLYING = 20,
+    VT_METHODS = 22
+  };
+  /// Kind* of the type
+  uint8_t kind() const {
+    return GetField<uint8_t>(VT_KIND, 0);
+  }
+  bool variadic() const {
+    return GetField<uint8_t>(VT_VARIADIC, 0) != 0;
+  }
+  /// length of an array, direction of a channel or number of parameters
+  int64_t len() const {
+    return GetField<int64_t>(VT_LEN, 0);
+  }
+  /// TypeRefs of the element, key/value, field, method, or
+  /// parameter/result types
+  const flatbuffers::Vector<uint32_t> *elems() const {
+    return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_ELEMS);
+  }
+  /// field and method names of structs and interfaces
+  const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *names() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *>(VT_NAMES);
+  }
+  /// 1 for the embedded fields of a struct, parallel to names
+  const flatbuffers::Vector<uint8_t> *embedded() const {
+    return GetPointer<const flatbuffers::Vector<uint8_t> *>(VT_EMBEDDED);
+  }
+  /// name of a named type
+  const flatbuffers::String *name() const {
+    return GetPointer<const flatbuffers::String *>(VT_NAME);
+  }
+  /// import path of the package declaring a named type, if it is not this
+  /// package; such a type is looked up there by name, and has no
+  /// underlying type or methods here
+  const flatbuffers::String *pkg() const {
+    return GetPointer<const flatbuffers::String *>(VT_PKG);
+  }
+  /// TypeRef of the underlying type of a named type
+  uint32_t underlying() const {
+    return GetField<uint32_t>(VT_UNDERLYING, 0);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<types::exportdata::Method>> *methods() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<types::exportdata::Method>> *>(VT_METHODS);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint8_t>(verifier, VT_KIND) &&
+           VerifyField<uint8_t>(verifier, VT_VARIADIC) &&
+           VerifyField<int64_t>(verifier, VT_LEN) &&
+           VerifyOffset(verifier, VT_ELEMS) &&
+           verifier.VerifyVector(elems()) &&
+           VerifyOffset(verifier, VT_NAMES) &&
+           verifier.VerifyVector(names()) &&
+           verifier.VerifyVectorOfStrings(names()) &&
+           VerifyOffset(verifier, VT_EMBEDDED) &&
+           verifier.VerifyVector(embedded()) &&
+           VerifyOffset(verifier, VT_NAME) &&
+           verifier.VerifyString(name()) &&
+           VerifyOffset(verifier, VT_PKG) &&
+           verifier.VerifyString(pkg()) &&
+           VerifyField<uint32_t>(verifier, VT_UNDERLYING) &&
+           VerifyOffset(verifier, VT_METHODS) &&
+           verifier.VerifyVector(methods()) &&
+           verifier.VerifyVectorOfTables(methods()) &&
+           verifier.EndTable();
+  }
+};
+
+struct TypeBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_kind(uint8_t kind) {
+    fbb_.AddElement<uint8_t>(Type::VT_KIND, kind, 0);
+  }
+  void add_variadic(bool variadic) {
+    fbb_.AddElement<uint8_t>(Type::VT_VARIADIC, static_cast<uint8_t>(variadic), 0);
+  }
+  void add_len(int64_t len) {
+    fbb_.AddElement<int64_t>(Type::VT_LEN, len, 0);
+  }
+  void add_elems(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> elems) {
+    fbb_.AddOffset(Type::VT_ELEMS, elems);
+  }
+  void add_names(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> names) {
+    fbb_.AddOffset(Type::VT_NAMES, names);
+  }
+  void add_embedded(flatbuffers::Offset<flatbuffers::Vector<uint8_t>> embedded) {
+    fbb_.AddOffset(Type::VT_EMBEDDED, embedded);
+  }
+  void add_name(flatbuffers::Offset<flatbuffers::String> name) {
+    fbb_.AddOffset(Type::VT_NAME, name);
+  }
+  void add_pkg(flatbuffers::Offset<flatbuffers::String> pkg) {
+    fbb_.AddOffset(Type::VT_PKG, pkg);
+  }
+  void add_underlying(uint32_t underlying) {
+    fbb_.AddElement<uint32_t>(Type::VT_UNDERLYING, underlying, 0);
+  }
+  void add_methods(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<types::exportdata::Method>>> methods) {
+    fbb_.AddOffset(Type::VT_METHODS, methods);
+  }
+  explicit TypeBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  TypeBuilder &operator=(const TypeBuilder &);
+  flatbuffers::Offset<Type> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<Type>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Type> CreateType(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint8_t kind = 0,
+    bool variadic = false,
+    int64_t len = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> elems = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> names = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint8_t>> embedded = 0,
+    flatbuffers::Offset<flatbuffers::String> name = 0,
+    flatbuffers::Offset<flatbuffers::String> pkg = 0,
+    uint32_t underlying = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<types::exportdata::Method>>> methods = 0) {
+  TypeBuilder builder_(_fbb);
+  builder_.add_len(len);
+  builder_.add_methods(methods);
+  builder_.add_underlying(underlying);
+  builder_.add_pkg(pkg);
+  builder_.add_name(name);
+  builder_.add_embedded(embedded);
+  builder_.add_names(names);
+  builder_.add_elems(elems);
+  builder_.add_variadic(variadic);
+  builder_.add_kind(kind);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<Type> CreateTypeDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint8_t kind = 0,
+    bool variadic = false,
+    int64_t len = 0,
+    const std::vector<uint32_t> *elems = nullptr,
+    const std::vector<flatbuffers::Offset<flatbuffers::String>> *names = nullptr,
+    const std::vector<uint8_t> *embedded = nullptr,
+    const char *name = nullptr,
+    const char *pkg = nullptr,
+    uint32_t underlying = 0,
+    const std::vector<flatbuffers::Offset<types::exportdata::Method>> *methods = nullptr) {
+  auto elems__ = elems ? _fbb.CreateVector<uint32_t>(*elems) : 0;
+  auto names__ = names ? _fbb.CreateVector<flatbuffers::Offset<flatbuffers::String>>(*names) : 0;
+  auto embedded__ = embedded ? _fbb.CreateVector<uint8_t>(*embedded) : 0;
+  auto name__ = name ? _fbb.CreateString(name) : 0;
+  auto pkg__ = pkg ? _fbb.CreateString(pkg) : 0;
+  auto methods__ = methods ? _fbb.CreateVector<flatbuffers::Offset<types::exportdata::Method>>(*methods) : 0;
+  return types::exportdata::CreateType(
+      _fbb,
+      kind,
+      variadic,
+      len,
+      elems__,
+      names__,
+      embedded__,
+      name__,
+      pkg__,
+      underlying,
+      methods__);
+}
+
+struct Object FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_KIND = 4,
+    VT_TYPE = 6,
+    VT_CONST_KIND = 8,
+    VT_CONST_PARTS = 10,
+    VT_BODY = 12,
+    VT_TPARAMS = 14,
+    VT_LEAKS = 16
+  };
+  /// types::ObjKind: Const, TypeName, Var or Func
+  uint8_t kind() const {
+    return GetField<uint8_t>(VT_KIND, 0);
+  }
+  /// TypeRef
+  uint32_t type() const {
+    return GetField<uint32_t>(VT_TYPE, 0);
+  }
+  /// value of a constant: its types::ConstKind, and the decimal numerator
+  /// and denominator of an Int or Float, those of the real and imaginary
+  /// parts of a Complex, the String, or "0" or "1" for a Bool
+  uint8_t const_kind() const {
+    return GetField<uint8_t>(VT_CONST_KIND, 0);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *const_parts() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *>(VT_CONST_PARTS);
+  }
+  /// source of the inlinable body of a function: a file of the package
+  /// declaring the function as the single function _, whose parameters are
+  /// the receiver, if any, and the parameters of the function; or the
+  /// dictionary layout of a generic function, see compile/stencil.hh
+  const flatbuffers::String *body() const {
+    return GetPointer<const flatbuffers::String *>(VT_BODY);
+  }
+  /// TypeRefs of the type parameters of a generic function
+  const flatbuffers::Vector<uint32_t> *tparams() const {
+    return GetPointer<const flatbuffers::Vector<uint32_t> *>(VT_TPARAMS);
+  }
+  /// escape summary of a function, see compile/escape.hh: for each
+  /// parameter, the receiver first, the least number of dereferences on a
+  /// path to the heap and then to each result, or -1 where there is none
+  const flatbuffers::Vector<int32_t> *leaks() const {
+    return GetPointer<const flatbuffers::Vector<int32_t> *>(VT_LEAKS);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint8_t>(verifier, VT_KIND) &&
+           VerifyField<uint32_t>(verifier, VT_TYPE) &&
+           VerifyField<uint8_t>(verifier, VT_CONST_KIND) &&
+           VerifyOffset(verifier, VT_CONST_PARTS) &&
+           verifier.VerifyVector(const_parts()) &&
+           verifier.VerifyVectorOfStrings(const_parts()) &&
+           VerifyOffset(verifier, VT_BODY) &&
+           verifier.VerifyString(body()) &&
+           VerifyOffset(verifier, VT_TPARAMS) &&
+           verifier.VerifyVector(tparams()) &&
+           VerifyOffset(verifier, VT_LEAKS) &&
+           verifier.VerifyVector(leaks()) &&
+           verifier.EndTable();
+  }
+};
+
+struct ObjectBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_kind(uint8_t kind) {
+    fbb_.AddElement<uint8_t>(Object::VT_KIND, kind, 0);
+  }
+  void add_type(uint32_t type) {
+    fbb_.AddElement<uint32_t>(Object::VT_TYPE, type, 0);
+  }
+  void add_const_kind(uint8_t const_kind) {
+    fbb_.AddElement<uint8_t>(Object::VT_CONST_KIND, const_kind, 0);
+  }
+  void add_const_parts(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> const_parts) {
+    fbb_.AddOffset(Object::VT_CONST_PARTS, const_parts);
+  }
+  void add_body(flatbuffers::Offset<flatbuffers::String> body) {
+    fbb_.AddOffset(Object::VT_BODY, body);
+  }
+  void add_tparams(flatbuffers::Offset<flatbuffers::Vector<uint32_t>> tparams) {
+    fbb_.AddOffset(Object::VT_TPARAMS, tparams);
+  }
+  void add_leaks(flatbuffers::Offset<flatbuffers::Vector<int32_t>> leaks) {
+    fbb_.AddOffset(Object::VT_LEAKS, leaks);
+  }
+  explicit ObjectBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  ObjectBuilder &operator=(const ObjectBuilder &);
+  flatbuffers::Offset<Object> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<Object>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Object> CreateObject(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint8_t kind = 0,
+    uint32_t type = 0,
+    uint8_t const_kind = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> const_parts = 0,
+    flatbuffers::Offset<flatbuffers::String> body = 0,
+    flatbuffers::Offset<flatbuffers::Vector<uint32_t>> tparams = 0,
+    flatbuffers::Offset<flatbuffers::Vector<int32_t>> leaks = 0) {
+  ObjectBuilder builder_(_fbb);
+  builder_.add_leaks(leaks);
+  builder_.add_tparams(tparams);
+  builder_.add_body(body);
+  builder_.add_const_parts(const_parts);
+  builder_.add_type(type);
+  builder_.add_const_kind(const_kind);
+  builder_.add_kind(kind);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<Object> CreateObjectDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint8_t kind = 0,
+    uint32_t type = 0,
+    uint8_t const_kind = 0,
+    const std::vector<flatbuffers::Offset<flatbuffers::String>> *const_parts = nullptr,
+    const char *body = nullptr,
+    const std::vector<uint32_t> *tparams = nullptr,
+    const std::vector<int32_t> *leaks = nullptr) {
+  auto const_parts__ = const_parts ? _fbb.CreateVector<flatbuffers::Offset<flatbuffers::String>>(*const_parts) : 0;
+  auto body__ = body ? _fbb.CreateString(body) : 0;
+  auto tparams__ = tparams ? _fbb.CreateVector<uint32_t>(*tparams) : 0;
+  auto leaks__ = leaks ? _fbb.CreateVector<int32_t>(*leaks) : 0;
+  return types::exportdata::CreateObject(
+      _fbb,
+      kind,
+      type,
+      const_kind,
+      const_parts__,
+      body__,
+      tparams__,
+      leaks__);
+}
+
+struct Package FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table {
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE {
+    VT_VERSION = 4,
+    VT_PATH = 6,
+    VT_NAME = 8,
+    VT_TYPES = 10,
+    VT_OBJECTS = 12,
+    VT_NAMES = 14
+  };
+  uint32_t version() const {
+    return GetField<uint32_t>(VT_VERSION, 0);
+  }
+  const flatbuffers::String *path() const {
+    return GetPointer<const flatbuffers::String *>(VT_PATH);
+  }
+  const flatbuffers::String *name() const {
+    return GetPointer<const flatbuffers::String *>(VT_NAME);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<types::exportdata::Type>> *types() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<types::exportdata::Type>> *>(VT_TYPES);
+  }
+  /// the package-level objects, parallel to names
+  const flatbuffers::Vector<flatbuffers::Offset<types::exportdata::Object>> *objects() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<types::exportdata::Object>> *>(VT_OBJECTS);
+  }
+  /// names of the package-level objects, sorted
+  const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *names() const {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>> *>(VT_NAMES);
+  }
+  bool Verify(flatbuffers::Verifier &verifier) const {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_VERSION) &&
+           VerifyOffset(verifier, VT_PATH) &&
+           verifier.VerifyString(path()) &&
+           VerifyOffset(verifier, VT_NAME) &&
+           verifier.VerifyString(name()) &&
+           VerifyOffset(verifier, VT_TYPES) &&
+           verifier.VerifyVector(types()) &&
+           verifier.VerifyVectorOfTables(types()) &&
+           VerifyOffset(verifier, VT_OBJECTS) &&
+           verifier.VerifyVector(objects()) &&
+           verifier.VerifyVectorOfTables(objects()) &&
+           VerifyOffset(verifier, VT_NAMES) &&
+           verifier.VerifyVector(names()) &&
+           verifier.VerifyVectorOfStrings(names()) &&
+           verifier.EndTable();
+  }
+};
+
+struct PackageBuilder {
+  flatbuffers::FlatBufferBuilder &fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_version(uint32_t version) {
+    fbb_.AddElement<uint32_t>(Package::VT_VERSION, version, 0);
+  }
+  void add_path(flatbuffers::Offset<flatbuffers::String> path) {
+    fbb_.AddOffset(Package::VT_PATH, path);
+  }
+  void add_name(flatbuffers::Offset<flatbuffers::String> name) {
+    fbb_.AddOffset(Package::VT_NAME, name);
+  }
+  void add_types(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<types::exportdata::Type>>> types) {
+    fbb_.AddOffset(Package::VT_TYPES, types);
+  }
+  void add_objects(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<types::exportdata::Object>>> objects) {
+    fbb_.AddOffset(Package::VT_OBJECTS, objects);
+  }
+  void add_names(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> names) {
+    fbb_.AddOffset(Package::VT_NAMES, names);
+  }
+  explicit PackageBuilder(flatbuffers::FlatBufferBuilder &_fbb)
+        : fbb_(_fbb) {
+    start_ = fbb_.StartTable();
+  }
+  PackageBuilder &operator=(const PackageBuilder &);
+  flatbuffers::Offset<Package> Finish() {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<Package>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<Package> CreatePackage(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t version = 0,
+    flatbuffers::Offset<flatbuffers::String> path = 0,
+    flatbuffers::Offset<flatbuffers::String> name = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<types::exportdata::Type>>> types = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<types::exportdata::Object>>> objects = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> names = 0) {
+  PackageBuilder builder_(_fbb);
+  builder_.add_names(names);
+  builder_.add_objects(objects);
+  builder_.add_types(types);
+  builder_.add_name(name);
+  builder_.add_path(path);
+  builder_.add_version(version);
+  return builder_.Finish();
+}
+
+inline flatbuffers::Offset<Package> CreatePackageDirect(
+    flatbuffers::FlatBufferBuilder &_fbb,
+    uint32_t version = 0,
+    const char *path = nullptr,
+    const char *name = nullptr,
+    const std::vector<flatbuffers::Offset<types::exportdata::Type>> *types = nullptr,
+    const std::vector<flatbuffers::Offset<types::exportdata::Object>> *objects = nullptr,
+    const std::vector<flatbuffers::Offset<flatbuffers::String>> *names = nullptr) {
+  auto path__ = path ? _fbb.CreateString(path) : 0;
+  auto name__ = name ? _fbb.CreateString(name) : 0;
+  auto types__ = types ? _fbb.CreateVector<flatbuffers::Offset<types::exportdata::Type>>(*types) : 0;
+  auto objects__ = objects ? _fbb.CreateVector<flatbuffers::Offset<types::exportdata::Object>>(*objects) : 0;
+  auto names__ = names ? _fbb.CreateVector<flatbuffers::Offset<flatbuffers::String>>(*names) : 0;
+  return types::exportdata::CreatePackage(
+      _fbb,
+      version,
+      path__,
+      name__,
+      types__,
+      objects__,
+      names__);
+}
+
+inline const types::exportdata::Package *GetPackage(const void *buf) {
+  return flatbuffers::GetRoot<types::exportdata::Package>(buf);
+}
+
+inline const types::exportdata::Package *GetSizePrefixedPackage(const void *buf) {
+  return flatbuffers::GetSizePrefixedRoot<types::exportdata::Package>(buf);
+}
+
+inline const char *PackageIdentifier() {
+  return "GOEX";
+}
+
+inline bool PackageBufferHasIdentifier(const void *buf) {
+  return flatbuffers::BufferHasIdentifier(
+      buf, PackageIdentifier());
+}
+
+inline bool VerifyPackageBuffer(
+    flatbuffers::Verifier &verifier) {
+  return verifier.VerifyBuffer<types::exportdata::Package>(PackageIdentifier());
+}
+
+inline bool VerifySizePrefixedPackageBuffer(
+    flatbuffers::Verifier &verifier) {
+  return verifier.VerifySizePrefixedBuffer<types::exportdata::Package>(PackageIdentifier());
+}
+
+inline const char *PackageExtension() {
+  return "x";
+}
+
+inline void FinishPackageBuffer(
+    flatbuffers::FlatBufferBuilder &fbb,
+    flatbuffers::Offset<types::exportdata::Package> root) {
+  fbb.Finish(root, PackageIdentifier());
+}
+
+inline void FinishSizePrefixedPackageBuffer(
+    flatbuffers::FlatBufferBuilder &fbb,
+    flatbuffers::Offset<types::exportdata::Package> root) {
+  fbb.FinishSizePrefixed(root, PackageIdentifier());
+}
+
+}  // namespace exportdata
+}  // namespace types
+
+#endif  // FLATBUFFERS_GENERATED_EXPORTDATA_TYPES_EXPORTDATA_H_
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "common/interner.hh"
+#include "syntax/ast/nodes.hh"
+#include "syntax/types/constant.hh"
+#include "syntax/types/type.hh"
+
+namespace types {
+
+    class ImportedPackage;
+
+    // ObjKind identifies what an Object denotes.
+    enum class ObjKind : uint8_t {
+        PkgName,  // an imported package
+        Const,    // a declared constant, or iota
+        TypeName, // a declared or predeclared type
+        Var,      // a variable, parameter, result or struct field
+        Func,     // a function or method
+        Builtin,  // a built-in function
+        Nil,      // the predeclared nil
+        Label,    // a statement label
+    };
+
+    // BuiltinId identifies a built-in function.
+    enum class BuiltinId : uint8_t {
+        Append,
+        Cap,
+        Clear,
+        Close,
+        Complex,
+        Copy,
+        Delete,
+        Imag,
+        Len,
+        Make,
+        Max,
+        Min,
+        New,
+        Panic,
+        Print,
+        Println,
+        Real,
+        Recover,
+    };
+
+    // Object is a named language entity. Package-level objects are owned by
+    // the Checker that declared them; the objects of the universe live for
+    // the whole process.
+    struct Object {
+        ObjKind Kind = ObjKind::Var;
+        common::SymbolId Name = 0;
+        syntax::Pos Pos{}; // position of the declaring name; unknown for predeclared objects
+        TypeId Type = 0;
+        // Decl is the declaration of a package-level object, nil for local
+        // and predeclared objects.
+        ast::DeclNode *Decl = nullptr;
+        // Builtin identifies a built-in function.
+        BuiltinId Builtin = BuiltinId::Append;
+        // PtrRecv marks a method with a pointer receiver.
+        bool PtrRecv = false;
+        // Val is the value of a constant.
+        Value Val;
+        // Used marks a local variable that is used. Only the context that
+        // declared the variable writes it.
+        bool Used = false;
+        // Path is the import path of a package name, and Imported the
+        // package it denotes; nil if the package could not be imported.
+        // Imported is also the package declaring an imported function or
+        // method.
+        std::string_view Path;
+        ImportedPackage *Imported = nullptr;
+        // Body is the source of the inlinable body of an imported function
+        // or method, or the dictionary layout of an imported generic
+        // function, in the form of export_data.fbs, or empty. It is a view of the export data.
+        std::string_view Body;
+        // Leaks is the escape summary of an imported function or method, in
+        // the form of Object.leaks of export_data.fbs, or empty. It is a view
+        // of the export data.
+        std::span<const int32_t> Leaks;
+        // TParams are the type parameters of a generic function, in order;
+        // its Type is its signature in terms of them.
+        std::vector<TypeId> TParams;
+
+        bool IsPackageLevel() const { return Decl != nullptr; }
+    };
+
+} // namespace types
@@ -0,0 +1,139 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "syntax/types/object.hh"
+
+namespace types {
+
+    // Scope maps names to the objects declared in a block. Up to small_size
+    // names are kept in an inline open-addressed array indexed by the hash
+    // of their symbol ID, so that the typical block needs no allocation and
+    // a lookup touches one cache line; a larger scope moves its names to a
+    // heap table probed the same way.
+    //
+    // The universe, package and file scopes are shared: they are filled
+    // before any function body is checked and frozen, and are then read
+    // concurrently without locks. They are linked to their parents by
+    // pointer. Block scopes are private to one Context and live in its
+    // BlockScopes, linked by index.
+    class alignas(64) Scope {
+    public:
+        explicit Scope(const Scope *parent = nullptr) : _parent(parent) {}
+        Scope(Scope &&) = default;
+        Scope &operator=(Scope &&) = default;
+
+        const Scope *Parent() const { return _parent; }
+        size_t Size() const { return _size; }
+
+        // Insert adds obj to the scope and returns nil, unless the scope
+        // already holds an object of the same name, which it returns. The
+        // scope must not be frozen.
+        Object *Insert(Object *obj);
+
+        // LookupLocal returns the object of the given name in this scope,
+        // or nil.
+        Object *LookupLocal(common::SymbolId name) const {
+            auto [names, objs, mask] = slots();
+            for (auto i = hash(name) & mask;; i = (i + 1) & mask) {
+                if (names[i] == name) {
+                    return objs[i];
+                }
+                if (names[i] == 0) {
+                    return nullptr;
+                }
+            }
+        }
+
+        // Lookup returns the object of the given name in the innermost
+        // scope from this one outwards that has one, or nil.
+        Object *Lookup(common::SymbolId name) const;
+
+        // Freeze marks the scope as complete; it may then be shared.
+        void Freeze() { _frozen = true; }
+        bool Frozen() const { return _frozen; }
+
+    private:
+        // an empty slot has name 0, the empty string, which no object has
+        static constexpr uint32_t small_size = 8;
+        struct Table {
+            std::unique_ptr<common::SymbolId[]> names;
+            std::unique_ptr<Object *[]> objs;
+        };
+        struct Slots {
+            const common::SymbolId *names;
+            Object *const *objs;
+            uint32_t mask;
+        };
+
+        static uint32_t hash(common::SymbolId name) { return name * 0x9e3779b1u >> 7; }
+        Slots slots() const {
+            return _table ? Slots{_table->names.get(), _table->objs.get(), _mask}
+                          : Slots{_names, _objs, small_size - 1};
+        }
+        void grow();
+
+        // a lookup that misses reads only the first cache line
+        common::SymbolId _names[small_size] = {};
+        std::unique_ptr<Table> _table;
+        const Scope *_parent;
+        uint32_t _size = 0;
+        uint32_t _mask = small_size - 1; // capacity - 1 of the heap table
+        bool _frozen = false;
+        Object *_objs[small_size] = {};
+    };
+
+    // ScopeId is the index of a block scope in its BlockScopes.
+    using ScopeId = uint32_t;
+    constexpr ScopeId NoScope = ~ScopeId(0);
+
+    // BlockScopes holds the block scopes of the function bodies checked by
+    // one Context. Each block records the index of its enclosing block; the
+    // outermost blocks are enclosed by a shared scope, the file scope of
+    // the declaration being checked. Blocks are kept until the Context is
+    // destroyed, since the objects they name are.
+    class BlockScopes {
+    public:
+        explicit BlockScopes(const Scope *outer) : _outer(outer) {}
+
+        // Open returns a new empty block enclosed by parent, or by the
+        // shared outer scope if parent is NoScope.
+        ScopeId Open(ScopeId parent) {
+            _scopes.emplace_back();
+            _parents.push_back(parent);
+            return ScopeId(_scopes.size() - 1);
+        }
+
+        Scope &operator[](ScopeId s) { return _scopes[s]; }
+        const Scope &operator[](ScopeId s) const { return _scopes[s]; }
+        ScopeId Parent(ScopeId s) const { return _parents[s]; }
+
+        const Scope *Outer() const { return _outer; }
+        void SetOuter(const Scope *outer) { _outer = outer; }
+
+        // Lookup returns the object of the given name in the innermost
+        // block from s outwards that has one, else in the shared scopes.
+        Object *Lookup(ScopeId s, common::SymbolId name) const {
+            for (; s != NoScope; s = _parents[s]) {
+                if (auto obj = _scopes[s].LookupLocal(name)) {
+                    return obj;
+                }
+            }
+            return _outer->Lookup(name);
+        }
+
+    private:
+        std::vector<Scope> _scopes;
+        std::vector<ScopeId> _parents; // kept apart, so a walk up the chain stays in cache
+        const Scope *_outer;
+    };
+
+    // Universe returns the scope of the predeclared identifiers. Its types
+    // live in TypeTable::Global().
+    const Scope &Universe();
+
+    // ErrorType returns the predeclared error type.
+    TypeId ErrorType();
+
+} // namespace types
@@ -0,0 +1,211 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <libcuckoo/cuckoohash_map.hh>
+#include <tbb/spin_mutex.h>
+
+#include "common/interner.hh"
+#include "common/types.hh"
+
+namespace types {
+
+// Kinds of Go types.
+#define KindInvalid 0
+#define KindBool 1
+#define KindInt 2
+#define KindInt8 3
+#define KindInt16 4
+#define KindInt32 5
+#define KindInt64 6
+#define KindUint 7
+#define KindUint8 8
+#define KindUint16 9
+#define KindUint32 10
+#define KindUint64 11
+#define KindUintptr 12
+#define KindFloat32 13
+#define KindFloat64 14
+#define KindComplex64 15
+#define KindComplex128 16
+#define KindString 17
+#define KindUnsafePointer 18
+// Kinds of the types of untyped constants and of nil.
+#define KindUntypedBool 19
+#define KindUntypedInt 20
+#define KindUntypedRune 21
+#define KindUntypedFloat 22
+#define KindUntypedComplex 23
+#define KindUntypedString 24
+#define KindUntypedNil 25
+#define KindArray 26
+#define KindSlice 27
+#define KindStruct 28
+#define KindPointer 29
+#define KindFunc 30
+#define KindInterface 31
+#define KindMap 32
+#define KindChan 33
+#define KindNamed 34
+#define KindTypeParam 35
+
+    // TypeId is the handle of a canonical type. Every distinct type is
+    // created once, so two types are identical iff their IDs are equal.
+    // The ID of a basic or untyped type is its kind; 0 is the invalid type.
+    using TypeId = uint32_t;
+
+    // EmbeddedField marks the name of an embedded field in the Names of a
+    // struct type; FieldName strips it.
+    constexpr common::SymbolId EmbeddedField = common::SymbolId(1) << 31;
+    inline common::SymbolId FieldName(common::SymbolId name) { return name & ~EmbeddedField; }
+
+    // TildeTerm marks a term ~T in the terms of an interface; TermType
+    // strips it.
+    constexpr TypeId TildeTerm = TypeId(1) << 31;
+    inline TypeId TermType(TypeId term) { return term & ~TildeTerm; }
+
+    // Type is the canonical description of a type. Records are immutable
+    // once published, except for the underlying type of a named type and
+    // the constraint of a type parameter, which are set once after
+    // creation.
+    //
+    // An interface that is a constraint may restrict its type set to the
+    // union of its terms, which follow its methods in Elems: a term T
+    // stands for the type T, ~T for all types whose underlying type is T.
+    // A type parameter is its own underlying type; its Elems hold its
+    // constraint.
+    struct Type {
+        uint8 Kind = KindInvalid;
+        // Variadic marks a function whose last parameter is ...T, and the
+        // interfaces that only comparable types implement.
+        bool Variadic = false;
+        // Name is the type name of a named type or type parameter.
+        common::SymbolId Name = 0;
+        // Len is the length of an array, the direction of a channel, the
+        // number of parameters of a function, the number of terms of an
+        // interface, or the index of a type parameter in its list.
+        int64 Len = 0;
+        // Underlying is the underlying type; a type other than a named type
+        // is its own underlying type.
+        TypeId Underlying = 0;
+        // Elems holds the element, key/value, field, method, or
+        // parameter/result types, depending on Kind.
+        std::span<const TypeId> Elems;
+        // Names holds the field or method names of structs and interfaces.
+        std::span<const common::SymbolId> Names;
+
+        TypeId Elem() const { return Elems.back(); }
+        TypeId Key() const { return Elems[0]; }
+        std::span<const TypeId> Params() const { return Elems.first(size_t(Len)); }
+        std::span<const TypeId> Results() const { return Elems.subspan(size_t(Len)); }
+        std::span<const TypeId> Methods() const { return Elems.first(Names.size()); }
+        std::span<const TypeId> Terms() const { return Elems.subspan(Names.size()); }
+    };
+
+    // TypeTable is the universe of canonical types. Structural types are
+    // hash-consed: constructing a type that already exists returns the
+    // existing ID without allocating. Named types are nominal, each call to
+    // NewNamed creates a distinct type. All methods are safe to call
+    // concurrently.
+    class TypeTable {
+    public:
+        TypeTable();
+        ~TypeTable();
+        TypeTable(const TypeTable &) = delete;
+        TypeTable &operator=(const TypeTable &) = delete;
+
+        // Global returns the process-wide type table.
+        static TypeTable &Global();
+
+        // Get returns the record of t.
+        const Type &Get(TypeId t) const {
+            return _chunks[t >> chunk_bits].load(std::memory_order_acquire)[t & (chunk_size - 1)];
+        }
+        const Type &operator[](TypeId t) const { return Get(t); }
+        uint8 Kind(TypeId t) const { return Get(t).Kind; }
+        TypeId Underlying(TypeId t) const { return Get(t).Underlying; }
+
+        TypeId Array(int64 len, TypeId elem);
+        TypeId Slice(TypeId elem);
+        TypeId Pointer(TypeId elem);
+        TypeId Map(TypeId key, TypeId value);
+        // Chan returns the channel type with the given direction (ChanBoth,
+        // SendOnly or RecvOnly) and element type.
+        TypeId Chan(uint32_t dir, TypeId elem);
+        TypeId Func(std::span<const TypeId> params, std::span<const TypeId> results, bool variadic = false);
+        // Struct returns the struct type with the given fields in order; the
+        // names of embedded fields are marked with EmbeddedField.
+        TypeId Struct(std::span<const common::SymbolId> names, std::span<const TypeId> fields);
+        // Interface returns the interface type with the given methods; the
+        // order of the methods does not matter. The type set of a
+        // constraint is further restricted to the union of terms, if any,
+        // which keep their order, and to comparable types.
+        TypeId Interface(std::span<const common::SymbolId> names, std::span<const TypeId> methods,
+                         std::span<const TypeId> terms = {}, bool comparable = false);
+
+        // NewNamed creates a new named type. Its underlying type must be
+        // set with SetUnderlying before the type is shared between threads.
+        TypeId NewNamed(common::SymbolId name);
+        void SetUnderlying(TypeId named, TypeId underlying);
+
+        // NewTypeParam creates a new type parameter with the given index in
+        // its list. Its constraint, an interface that may refer to the type
+        // parameter, must be set with SetConstraint before it is shared.
+        TypeId NewTypeParam(common::SymbolId name, int64 index);
+        void SetConstraint(TypeId param, TypeId constraint);
+
+        // Size returns the number of types.
+        size_t Size() const { return _next.load(std::memory_order_acquire); }
+
+        // String returns the Go spelling of t.
+        std::string String(TypeId t) const;
+
+    private:
+        // Key is the structure of a type that identifies it.
+        struct Key {
+            uint8 kind;
+            bool variadic;
+            int64 len;
+            std::span<const TypeId> elems;
+            std::span<const common::SymbolId> names;
+        };
+        struct Pending;
+        struct Hash {
+            size_t operator()(const Key &k) const;
+            size_t operator()(const Pending &p) const;
+        };
+        struct Equal {
+            bool operator()(const Key &a, const Key &b) const;
+            bool operator()(const Key &a, const Pending &b) const;
+        };
+
+        static constexpr int chunk_bits = 12;
+        static constexpr size_t chunk_size = size_t(1) << chunk_bits;
+        static constexpr size_t max_chunks = size_t(1) << 12;
+        static constexpr size_t arena_block_size = 16 << 10;
+
+        TypeId Intern(const Key &k);
+        Key Store(const Key &k);
+        TypeId Publish(const Type &t);
+        void WriteTo(std::string &s, TypeId t) const;
+        void WriteTerms(std::string &s, std::span<const TypeId> terms) const;
+
+        cuckoohash_map<Key, TypeId, Hash, Equal> _map;
+        std::atomic<TypeId> _next{0};
+        // _chunks[i] holds the records of IDs [i << chunk_bits, (i + 1) << chunk_bits).
+        std::unique_ptr<std::atomic<Type *>[]> _chunks;
+
+        // arena holding the element and name arrays of all types
+        tbb::spin_mutex _arena_mutex;
+        std::vector<std::unique_ptr<uint32_t[]>> _blocks;
+        uint32_t *_cur = nullptr;
+        size_t _avail = 0;
+    };
+
+    // Identical reports whether x and y are identical types.
+    inline bool Identical(TypeId x, TypeId y) { return x == y; }
+}
@@ -1,35 +1,250 @@
+#include <tbb/global_control.h>
+
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
 
-#include "syntax/token_string.hh"
-#include "syntax/operator_string.hh"
-#include "syntax/source.hh"
+#include "build/build.hh"
+#include "common/mapped_file.hh"
+#include "compile/devirt.hh"
+#include "compile/escape.hh"
+#include "compile/inline.hh"
+#include "ssa/build.hh"
+#include "ssa/pass.hh"
 
-void test_token_string() {
-    std::cout << syntax::TokenString(Token_EOF) << std::endl;
-    std::cout << syntax::TokenString(Token_Name) << std::endl;
-    std::cout << syntax::TokenString(Token_Literal) << std::endl;
+// pxcppgo builds the packages named by their import paths, which are
+// directories relative to the root directory. With -x, the export data of
+// the packages is written to the given directory; with -cache, the
+// results of the packages are cached in the given directory. -l disables
+// inlining. -pgo names the profile of the dynamic callees of interface
+// calls that guarded devirtualization uses. With -m, the inlining,
+// devirtualization and escape analysis decisions and the stencils of the
+// generic functions instantiated are printed, and with -m=2 the flows that
+// force values to the heap as well. -ssa prints the SSA form of the
+// functions of the packages after the optimization passes, which -passes
+// lists in the order they run, and -passtime prints the time each pass
+// takes on each package. -d prints what the passes it lists do, such as
+// the bounds and nil checks prove removes, by position.
+//
+//     pxcppgo [-C root] [-j threads] [-x exportdir] [-cache cachedir] [-pgo profile] [-l] [-m | -m=2] [-ssa]
+//             [-passes list] [-passtime] [-d list] package...
+static int usage() {
+    std::cerr << "usage: pxcppgo [-C root] [-j threads] [-x exportdir] [-cache cachedir] [-pgo profile] [-l] "
+                 "[-m | -m=2] [-ssa] [-passes list] [-passtime] [-d list] package..."
+              << std::endl;
+    std::cerr << "passes:";
+    for (auto &p : ssa::Passes()) {
+        std::cerr << " " << p.Name;
+    }
+    std::cerr << " (default " << ssa::PassManager::DefaultPipeline << ")" << std::endl;
+    return 2;
 }
 
-void test_operator_string() {
-    std::cout << syntax::OperatorString(Operator_Def) << std::endl;
-    std::cout << syntax::OperatorString(Operator_Tilde) << std::endl;
-    std::cout << syntax::OperatorString(Operator_Shr) << std::endl;
+// decisions returns the inlining, devirtualization, instantiation and
+// escape analysis decisions on the functions of pkg, one per line, by position.
+static std::string decisions(const build::Package &pkg, bool explain) {
+    std::vector<ast::File *> files;
+    for (auto &f : pkg.Syntax) {
+        files.push_back(f.get());
+    }
+    std::vector<std::pair<syntax::Pos, std::string>> lines;
+    auto add = [&](syntax::Pos pos, const std::string &msg) {
+        auto p = syntax::FileSet::Global().Resolve(pos);
+        lines.emplace_back(pos, fmt::format("{}:{}:{}: {}\n", p.Filename, p.Line, p.Col, msg));
+    };
+    if (pkg.Inline != nullptr) {
+        for (auto &d : pkg.Inline->Decisions()) {
+            add(d.Pos, d.Message());
+        }
+    }
+    if (pkg.Devirt != nullptr) {
+        for (auto &d : pkg.Devirt->Decisions()) {
+            add(d.Pos, d.Message());
+        }
+    }
+    if (pkg.Stencil != nullptr) {
+        for (auto &r : pkg.Stencil->Reports()) {
+            add(r.Pos, r.Message());
+        }
+    }
+    compile::EscapeAnalysis escape(*pkg.Types);
+    for (auto &d : escape.Analyze(files, explain)) {
+        add(d.Pos, d.Message());
+        for (auto &line : d.Explain) {
+            add(d.Pos, "  " + line);
+        }
+    }
+    std::stable_sort(lines.begin(), lines.end(), [](auto &a, auto &b) { return a.first < b.first; });
+    std::string out;
+    for (auto &[pos, line] : lines) {
+        out += line;
+    }
+    return out;
 }
 
-void test_source() {
-    syntax::source source;
-    source.init("test.cc", nullptr);
-    int cnt = 0;
-    while (source._ch != common::utf8::rune_eof) {
-        cnt++;
-        source.nextch();
-        std::cout << "\t: " << source._ch << std::endl;
+// ssaDump returns the SSA form of the functions of pkg after the passes of
+// pipeline, or why a function is not lowered, what the passes of debug did
+// by position, and the time the passes took if timing. A function the
+// passes leave malformed is an error of pkg.
+static std::string ssaDump(build::Package &pkg, const std::string &pipeline, const std::string &debug,
+                           bool dump, bool timing) {
+    std::string out;
+    ssa::Func f;
+    ssa::PassManager pm;
+    pm.SetPipeline(pipeline);
+    pm.SetDebug(debug);
+    pm.SetVerify(true);
+    std::vector<ssa::Func::Report> reports;
+    for (auto &file : pkg.Syntax) {
+        for (auto &d : file->DeclList) {
+            auto decl = dyn_cast<ast::FuncDecl>(d.get());
+            if (decl == nullptr || decl->Body == nullptr) {
+                continue;
+            }
+            std::string reason;
+            if (ssa::Build(f, *pkg.Types, decl, &reason, pkg.Escape.get(), pkg.Devirt.get())) {
+                auto err = f.Verify();
+                if (err.empty()) {
+                    err = pm.Run(f);
+                }
+                if (dump) {
+                    out += f.String();
+                }
+                if (!err.empty()) {
+                    auto p = syntax::FileSet::Global().Resolve(decl->GetPos());
+                    pkg.Errors.push_back(
+                        fmt::format("{}:{}:{}: {}: malformed: {}", p.Filename, p.Line, p.Col, f.Name(), err));
+                }
+                reports.insert(reports.end(), f.Reports().begin(), f.Reports().end());
+            } else if (dump) {
+                auto p = syntax::FileSet::Global().Resolve(decl->GetPos());
+                out += fmt::format("{}:{}:{}: {} not lowered: {}\n", p.Filename, p.Line, p.Col, ssa::FuncName(decl),
+                                   reason);
+            }
+        }
     }
+    std::stable_sort(reports.begin(), reports.end(), [](auto &a, auto &b) { return a.Pos < b.Pos; });
+    for (auto &r : reports) {
+        auto p = syntax::FileSet::Global().Resolve(r.Pos);
+        out += fmt::format("{}:{}:{}: {}\n", p.Filename, p.Line, p.Col, r.Msg);
+    }
+    if (timing) {
+        out += fmt::format("# {}\n{}", pkg.Path, pm.Report());
+    }
+    return out;
 }
 
-int main() {
-    test_token_string();
-    test_operator_string();
-    test_source();
-    return 0;
-}
\ No newline at end of file
+int main(int argc, char **argv) {
+    std::string root = ".";
+    int threads = 0;
+    build::Options opts;
+    std::vector<std::string> paths;
+    std::string pipeline(ssa::PassManager::DefaultPipeline), debug;
+    bool decide = false, explain = false, dump = false, timing = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "-C" || arg == "-j" || arg == "-x" || arg == "-cache" || arg == "-pgo" || arg == "-passes" ||
+             arg == "-d") &&
+            i + 1 < argc) {
+            if (arg == "-C") {
+                root = argv[++i];
+            } else if (arg == "-j") {
+                threads = std::atoi(argv[++i]);
+            } else if (arg == "-x") {
+                opts.ExportDir = argv[++i];
+            } else if (arg == "-pgo") {
+                std::string file = argv[++i], error;
+                auto profile = common::MappedFile::Open(file);
+                if (profile == nullptr || !compile::CallProfile::Parse(profile->View(), error)) {
+                    std::cerr << "pxcppgo: " << file << ": " << (profile == nullptr ? "cannot read" : error)
+                              << std::endl;
+                    return 2;
+                }
+                opts.Profile = profile->View();
+            } else if (arg == "-passes") {
+                pipeline = argv[++i];
+                if (auto err = ssa::PassManager().SetPipeline(pipeline); !err.empty()) {
+                    std::cerr << "pxcppgo: -passes: " << err << std::endl;
+                    return usage();
+                }
+            } else if (arg == "-d") {
+                debug = argv[++i];
+                if (auto err = ssa::PassManager().SetDebug(debug); !err.empty()) {
+                    std::cerr << "pxcppgo: -d: " << err << std::endl;
+                    return usage();
+                }
+            } else {
+                opts.CacheDir = argv[++i];
+            }
+        } else if (arg == "-l") {
+            opts.InlineBudget = 0;
+        } else if (arg == "-m" || arg == "-m=2") {
+            opts.Flags.push_back(arg);
+            decide = true;
+            explain = arg == "-m=2";
+        } else if (arg == "-ssa" || arg == "-passtime") {
+            opts.Flags.push_back(arg);
+            dump = dump || arg == "-ssa";
+            timing = timing || arg == "-passtime";
+        } else if (arg.starts_with("-")) {
+            return usage();
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty() || threads < 0) {
+        return usage();
+    }
+    auto passes = dump || timing || !debug.empty();
+    if (passes) {
+        opts.Flags.push_back("-passes=" + pipeline);
+    }
+    if (!debug.empty()) {
+        opts.Flags.push_back("-d=" + debug);
+    }
+    if (decide || passes) {
+        opts.Compile = [=](build::Package &pkg) {
+            if (decide) {
+                pkg.Outputs.push_back(decisions(pkg, explain));
+            }
+            if (passes) {
+                pkg.Outputs.push_back(ssaDump(pkg, pipeline, debug, dump, timing));
+            }
+        };
+    }
+
+    std::unique_ptr<tbb::global_control> limit;
+    if (threads > 0) {
+        limit = std::make_unique<tbb::global_control>(tbb::global_control::max_allowed_parallelism, threads);
+    }
+    // the files are selected for $GOOS and $GOARCH, as by the go command
+    build::Target target;
+    if (auto os = std::getenv("GOOS"); os != nullptr && *os != '\0') {
+        target.GOOS = os;
+    }
+    if (auto arch = std::getenv("GOARCH"); arch != nullptr && *arch != '\0') {
+        target.GOARCH = arch;
+    }
+    auto g = build::Load(root, paths, target);
+    for (auto &e : g.Errors) {
+        std::cerr << e << std::endl;
+    }
+    auto ok = build::Build(g, opts) && g.Errors.empty();
+    for (auto &pkg : g.Packages) {
+        for (auto &out : pkg->Outputs) {
+            std::cerr << out;
+        }
+        if (!pkg->Errors.empty()) {
+            std::cerr << "# " << pkg->Path << std::endl;
+        }
+        for (auto &e : pkg->Errors) {
+            std::cerr << e << std::endl;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,2188 @@
+#include "ssa/build.hh"
+
+#include <fmt/format.h>
+
+#include <bit>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "compile/callgraph.hh"
+#include "ssa/pass.hh"
+#include "syntax/ast/walk.hh"
+
+namespace ssa {
+
+using types::BuiltinId;
+using types::ObjKind;
+using types::Object;
+using types::Selection;
+using types::TypeTable;
+
+namespace {
+
+const types::Type &under(TypeId t) {
+    auto &table = TypeTable::Global();
+    return table[table.Underlying(t)];
+}
+
+uint8_t kindOf(TypeId t) { return t == 0 || t == TypeMem ? KindInvalid : under(t).Kind; }
+
+bool isPointer(TypeId t) { return kindOf(t) == KindPointer; }
+
+TypeId elemOf(TypeId t) { return under(t).Elem(); }
+
+ast::ExprNode *unparen(ast::ExprNode *e) {
+    while (auto p = dyn_cast_or_null<ast::ParenExpr>(e)) {
+        e = p->X.get();
+    }
+    return e;
+}
+
+// exprList returns the expressions of a list, or the single expression e.
+std::vector<ast::ExprNode *> exprList(ast::ExprNode *e) {
+    std::vector<ast::ExprNode *> out;
+    if (auto l = dyn_cast_or_null<ast::ListExpr>(e)) {
+        for (auto &x : l->ElemList) {
+            out.push_back(x.get());
+        }
+    } else if (e != nullptr) {
+        out.push_back(e);
+    }
+    return out;
+}
+
+// ssaable reports whether a variable of type t can live in SSA values.
+bool ssaable(TypeId t) {
+    auto &u = under(t);
+    switch (u.Kind) {
+    case KindArray:
+        return false;
+    case KindStruct:
+        if (u.Elems.size() > 4) {
+            return false;
+        }
+        for (auto f : u.Elems) {
+            if (!ssaable(f)) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+// target is where break and continue statements go.
+struct target {
+    common::SymbolId label = 0;
+    Block *brk = nullptr;
+    Block *cont = nullptr; // nil for a switch
+};
+
+// place is a location holding a value of type Type: a variable in memory
+// at Ptr, or a value held in SSA form, Val.
+struct place {
+    Value *Ptr = nullptr;
+    Value *Val = nullptr;
+    TypeId Type = 0;
+};
+
+// lvalue is the left-hand side of an assignment.
+struct lvalue {
+    enum Kind : uint8_t { Blank, Var, Decl, Mem, MapElem };
+    Kind kind = Blank;
+    TypeId type = 0;
+    uint32_t var = 0;        // Var
+    Object *obj = nullptr;   // Decl
+    Value *ptr = nullptr;    // Mem: the address; MapElem: the map
+    Value *key = nullptr;    // MapElem
+};
+
+class builder {
+public:
+    builder(Func &f, const types::Checker &check, const compile::EscapeAnalysis *escape,
+            const compile::Devirtualizer *devirt)
+        : _f(f), _check(check), _escape(escape), _devirt(devirt), _table(TypeTable::Global()) {}
+
+    // build lowers decl, or returns why it cannot.
+    std::string build(ast::FuncDecl *decl);
+
+private:
+    // ------------------------------------------------------------------------
+    // Blocks and values
+
+    Block *newBlock() {
+        auto b = _f.NewBlock(BlockKind::Plain, _pos);
+        if (b->Id >= _defs.size()) {
+            _defs.resize(b->Id + 1);
+            _sealed.resize(b->Id + 1);
+            _incomplete.resize(b->Id + 1);
+        }
+        return b;
+    }
+
+    Value *val(Op op, TypeId t, std::initializer_list<Value *> args = {}) {
+        return _f.NewValue(_cur, op, t, args, _pos);
+    }
+    Value *val(Op op, TypeId t, std::span<Value *const> args) { return _f.NewValue(_cur, op, t, args, _pos); }
+
+    // reachable makes sure there is a current block: code following a
+    // return, a panic or a branch is lowered into a block without
+    // predecessors, which is removed at the end.
+    void reachable() {
+        if (_cur == nullptr) {
+            _cur = newBlock();
+            seal(_cur);
+        }
+    }
+
+    void jump(Block *to) {
+        if (_cur != nullptr) {
+            _cur->Kind = BlockKind::Plain;
+            _cur->AddEdgeTo(to);
+            _cur = nullptr;
+        }
+    }
+
+    void branch(Value *cond, Block *yes, Block *no) {
+        if (_cur != nullptr) {
+            _cur->Kind = BlockKind::If;
+            _cur->SetControl(cond);
+            _cur->AddEdgeTo(yes);
+            _cur->AddEdgeTo(no);
+            _cur = nullptr;
+        }
+    }
+
+    // exit ends the current block with the panic p.
+    void exit(Value *p) {
+        _cur->Kind = BlockKind::Exit;
+        _cur->SetControl(p);
+        _cur = nullptr;
+    }
+
+    // ------------------------------------------------------------------------
+    // Variables
+
+    uint32_t newVar(TypeId t) {
+        _vars.push_back(t);
+        return uint32_t(_vars.size() - 1);
+    }
+
+    void write(uint32_t var, Block *b, Value *v) {
+        auto &d = _defs[b->Id];
+        if (d.size() <= var) {
+            d.resize(_vars.size());
+        }
+        d[var] = v;
+    }
+
+    Value *read(uint32_t var, Block *b) {
+        auto &d = _defs[b->Id];
+        if (var < d.size() && d[var] != nullptr) {
+            return d[var];
+        }
+        Value *v;
+        if (!_sealed[b->Id]) {
+            v = phi(b, var);
+            _incomplete[b->Id].emplace_back(var, v);
+        } else if (b->Preds.size() == 1) {
+            v = read(var, b->Preds[0]);
+        } else if (b->Preds.empty()) {
+            v = undefined(var);
+        } else {
+            // the Phi breaks cycles through loops
+            v = phi(b, var);
+            write(var, b, v);
+            v = addPhiOperands(var, v);
+        }
+        write(var, b, v);
+        return v;
+    }
+
+    Value *phi(Block *b, uint32_t var) { return _f.NewPhi(b, _vars[var], b->Pos); }
+
+    Value *addPhiOperands(uint32_t var, Value *phi) {
+        for (auto p : phi->Blk->Preds) {
+            phi->AddArg(read(var, p));
+        }
+        return removeTrivialPhi(phi, var);
+    }
+
+    static Value *resolve(Value *v) {
+        while (v->Op == Op::Copy) {
+            v = v->Args[0];
+        }
+        return v;
+    }
+
+    // removeTrivialPhi turns a Phi that selects a single value, other than
+    // itself, into a copy of the value, which the end of the construction
+    // removes.
+    Value *removeTrivialPhi(Value *phi, uint32_t var) {
+        Value *same = nullptr;
+        for (size_t i = 0; i < phi->Args.size(); i++) {
+            auto a = resolve(phi->Args[i]);
+            if (a != phi->Args[i]) {
+                phi->SetArg(i, a);
+            }
+            if (a == same || a == phi) {
+                continue;
+            }
+            if (same != nullptr) {
+                return phi;
+            }
+            same = a;
+        }
+        if (same == nullptr) {
+            same = undefined(var); // unreachable
+        }
+        phi->CopyOf(same);
+        return same;
+    }
+
+    // undefined returns the value of a variable read where it was never
+    // written, which only happens in unreachable code.
+    Value *undefined(uint32_t var) { return var == memVar ? _initMem : zero(_vars[var]); }
+
+    void seal(Block *b) {
+        auto incomplete = std::move(_incomplete[b->Id]);
+        _sealed[b->Id] = true;
+        for (auto [var, phi] : incomplete) {
+            addPhiOperands(var, phi);
+        }
+    }
+
+    Value *mem() { return read(memVar, _cur); }
+    void setMem(Value *m) { write(memVar, _cur, m); }
+
+    // alloc allocates a zeroed variable of type t for site, the expression
+    // allocating it: on the heap unless escape analysis keeps it in the
+    // frame. A temporary, without a site, is in the frame.
+    Value *alloc(TypeId t, const ast::Node *site) {
+        bool heap = site != nullptr && (_escape == nullptr || _escape->OnHeap(site));
+        return val(heap ? Op::HeapAlloc : Op::Alloc, _table.Pointer(t), {mem()});
+    }
+
+    // declare declares the local variable obj with the initial value v; if
+    // v is nil, obj lives in memory and its initialization is up to the
+    // caller.
+    void declare(Object *obj, Value *v) {
+        if (_addrTaken.contains(obj) || !ssaable(obj->Type)) {
+            // a variable whose address is not taken cannot outlive the frame
+            bool heap = _addrTaken.contains(obj) && (_escape == nullptr || _escape->Moved(obj));
+            auto p = val(heap ? Op::HeapAlloc : Op::Alloc, _table.Pointer(obj->Type), {mem()});
+            p->Sym = obj;
+            _mem[obj] = p;
+            if (v != nullptr) {
+                store(p, v);
+            }
+            return;
+        }
+        auto [it, added] = _ssa.try_emplace(obj, 0);
+        if (added) {
+            it->second = newVar(obj->Type);
+        }
+        write(it->second, _cur, v != nullptr ? v : zero(obj->Type));
+    }
+
+    // readVar returns the value of the variable obj.
+    Value *readVar(Object *obj, TypeId t) {
+        if (auto it = _ssa.find(obj); it != _ssa.end()) {
+            return read(it->second, _cur);
+        }
+        return load(t, varAddr(obj));
+    }
+
+    // varAddr returns the address of a variable in memory.
+    Value *varAddr(Object *obj) {
+        if (auto it = _mem.find(obj); it != _mem.end()) {
+            return it->second;
+        }
+        if (_ssa.contains(obj)) {
+            panic("ssa: address of a register variable");
+        }
+        auto p = val(Op::Addr, _table.Pointer(obj->Type));
+        p->Sym = obj;
+        return p;
+    }
+
+    // ------------------------------------------------------------------------
+    // Memory
+
+    Value *load(TypeId t, Value *p) { return val(Op::Load, t, {p, mem()}); }
+    void store(Value *p, Value *v) { setMem(val(Op::Store, TypeMem, {p, v, mem()})); }
+    void nilCheck(Value *p) { val(Op::NilCheck, 0, {p, mem()}); }
+
+    // boundsCheck continues in a new block if 0 <= idx < len, or <= len for
+    // slicing, and panics otherwise.
+    void boundsCheck(Value *idx, Value *len, bool slicing = false) {
+        if (idx->Op == Op::ConstInt && len->Op == Op::ConstInt && idx->AuxInt >= 0 &&
+            (idx->AuxInt < len->AuxInt || (slicing && idx->AuxInt == len->AuxInt))) {
+            return; // checked by the type checker
+        }
+        auto ok = val(slicing ? Op::IsSliceInBounds : Op::IsInBounds, KindBool, {idx, len});
+        auto in = newBlock(), out = newBlock();
+        branch(ok, in, out);
+        seal(out);
+        _cur = out;
+        exit(val(Op::PanicBounds, TypeMem, {idx, len, mem()}));
+        seal(in);
+        _cur = in;
+    }
+
+    // runtime calls the runtime function name and returns its results.
+    std::vector<Value *> runtime(std::string_view name, std::span<const TypeId> results, std::vector<Value *> args) {
+        args.push_back(mem());
+        auto c = val(Op::RuntimeCall, TypeMem, args);
+        c->Str = _f.Intern(name);
+        setMem(c);
+        return selectResults(c, results);
+    }
+    Value *runtime1(std::string_view name, TypeId result, std::vector<Value *> args) {
+        return runtime(name, std::span(&result, 1), std::move(args))[0];
+    }
+
+    std::vector<Value *> selectResults(Value *call, std::span<const TypeId> results) {
+        std::vector<Value *> out;
+        for (size_t i = 0; i < results.size(); i++) {
+            auto r = val(Op::SelectN, results[i], {call});
+            r->AuxInt = int64_t(i);
+            out.push_back(r);
+        }
+        return out;
+    }
+
+    // ------------------------------------------------------------------------
+    // Constants and conversions
+
+    std::optional<types::Value> constant(ast::ExprNode *e) const;
+    Value *constValue(const types::Value &c, TypeId t);
+    Value *zero(TypeId t);
+    Value *convert(Value *v, TypeId to);
+    Value *conversion(ast::CallExpr *call);
+
+    // ------------------------------------------------------------------------
+    // Expressions
+
+    Value *expr(ast::ExprNode *e, TypeId want = 0);
+    std::vector<Value *> exprN(ast::ExprNode *e);
+    Value *name(ast::Name *n, TypeId want);
+    Value *operation(ast::Operation *op, TypeId want);
+    Value *binary(syntax::Operator op, Value *x, Value *y, TypeId t);
+    Value *index(ast::IndexExpr *e);
+    Value *indexAddr(ast::IndexExpr *e);
+    Value *intIndex(ast::ExprNode *e);
+    Value *slice(ast::SliceExpr *e);
+    Value *composite(ast::CompositeLit *lit);
+    Value *newComposite(ast::CompositeLit *lit, const ast::Node *site);
+    void initComposite(Value *p, TypeId t, ast::CompositeLit *lit);
+    Value *elemValue(ast::ExprNode *e, TypeId t);
+    std::vector<Value *> call(ast::CallExpr *call);
+    std::vector<Value *> devirtualized(ast::CallExpr *call, ast::SelectorExpr *sel, const compile::DevirtCall &d);
+    std::vector<Value *> builtin(ast::CallExpr *call, BuiltinId id);
+    std::vector<Value *> args(ast::CallExpr *call, TypeId sig);
+    void cond(ast::ExprNode *e, Block *yes, Block *no);
+
+    // places
+    Value *addr(ast::ExprNode *e);
+    place at(ast::ExprNode *e);
+    place step(place p, int field);
+    Value *get(const place &p) { return p.Ptr != nullptr ? load(p.Type, p.Ptr) : p.Val; }
+    place selection(ast::ExprNode *x, std::span<const int> path);
+    Value *receiver(ast::ExprNode *x, std::span<const int> path, bool ptrRecv);
+    bool inRegister(ast::ExprNode *e) const;
+    bool isPackage(ast::ExprNode *e) const;
+
+    // ------------------------------------------------------------------------
+    // Statements
+
+    void stmts(const std::vector<ast::StmtNodePtr> &list) {
+        for (auto &s : list) {
+            stmt(s.get());
+        }
+    }
+    void stmt(ast::StmtNode *s, common::SymbolId label = 0);
+    void simpleStmt(ast::SimpleStmtNode *s);
+    void assign(ast::AssignStmt *s);
+    void opAssign(ast::ExprNode *lhs, syntax::Operator op, ast::ExprNode *rhs);
+    lvalue lhs(ast::ExprNode *e, bool def);
+    void assignTo(const lvalue &lv, Value *v);
+    void varDecl(ast::VarDecl *d);
+    void ifStmt(ast::IfStmt *s);
+    void forStmt(ast::ForStmt *s, common::SymbolId label);
+    void rangeStmt(ast::ForStmt *s, ast::RangeClause *r, common::SymbolId label);
+    void switchStmt(ast::SwitchStmt *s, common::SymbolId label);
+    void returnStmt(ast::ReturnStmt *s);
+    void branchStmt(ast::BranchStmt *s);
+    void ret(std::vector<Value *> results);
+    void markAddrTaken(ast::Node *body);
+    std::string unsupported(ast::FuncDecl *decl) const;
+
+    static constexpr uint32_t memVar = 0;
+
+    Func &_f;
+    const types::Checker &_check;
+    const compile::EscapeAnalysis *_escape;
+    const compile::Devirtualizer *_devirt;
+    TypeTable &_table;
+    Block *_cur = nullptr;
+    syntax::Pos _pos{};
+    Value *_initMem = nullptr;
+
+    // the type of each variable, the memory first
+    std::vector<TypeId> _vars;
+    // per block ID: the current definition of each variable, whether all
+    // predecessors are known, and the Phis to complete once they are
+    std::vector<std::vector<Value *>> _defs;
+    std::vector<bool> _sealed;
+    std::vector<std::vector<std::pair<uint32_t, Value *>>> _incomplete;
+
+    std::unordered_map<const Object *, uint32_t> _ssa; // variables in SSA form
+    std::unordered_map<const Object *, Value *> _mem;  // variables in memory -> their Alloc
+    std::unordered_set<const Object *> _addrTaken;
+    std::vector<Object *> _results; // nil for unnamed results
+    std::vector<TypeId> _resultTypes;
+    std::vector<target> _targets;
+    Block *_fallthrough = nullptr;
+};
+
+// ----------------------------------------------------------------------------
+// Constants and conversions
+
+// constant returns the value of e if it is a constant expression.
+std::optional<types::Value> builder::constant(ast::ExprNode *e) const {
+    e = unparen(e);
+    if (auto b = dyn_cast_or_null<ast::BasicLit>(e)) {
+        return types::Value::MakeFromLiteral(b->Value, b->Kind);
+    }
+    const ast::Name *name = dyn_cast_or_null<ast::Name>(e);
+    if (auto s = dyn_cast_or_null<ast::SelectorExpr>(e); s && isPackage(s->X.get())) {
+        name = s->Sel.get();
+    }
+    if (name != nullptr) {
+        auto obj = _check.ObjectOf(name);
+        if (obj != nullptr && obj->Kind == ObjKind::Const) {
+            return obj->Val;
+        }
+        return std::nullopt;
+    }
+    if (auto op = dyn_cast_or_null<ast::Operation>(e)) {
+        auto x = constant(op->X.get());
+        if (!x) {
+            return std::nullopt;
+        }
+        if (op->Y == nullptr) {
+            if (op->Op == Operator_Recv || op->Op == Operator_And || op->Op == Operator_Mul) {
+                return std::nullopt;
+            }
+            auto bits = types::IsUnsigned(e->typ) ? unsigned(types::Sizeof(e->typ) * 8) : 0;
+            return types::UnaryOp(op->Op, *x, bits);
+        }
+        auto y = constant(op->Y.get());
+        if (!y) {
+            return std::nullopt;
+        }
+        if (op->Op == Operator_Shl || op->Op == Operator_Shr) {
+            auto s = y->Uint64Val();
+            return s ? std::optional(types::Shift(*x, op->Op, *s)) : std::nullopt;
+        }
+        if (op->Op >= Operator_Eql && op->Op <= Operator_Geq) {
+            return types::Value::MakeBool(types::Compare(*x, op->Op, *y));
+        }
+        if (op->Op == Operator_OrOr || op->Op == Operator_AndAnd) {
+            bool v = op->Op == Operator_OrOr ? x->BoolVal() || y->BoolVal() : x->BoolVal() && y->BoolVal();
+            return types::Value::MakeBool(v);
+        }
+        return types::BinaryOp(*x, op->Op, *y);
+    }
+    if (auto c = dyn_cast_or_null<ast::CallExpr>(e); c && c->ArgList.size() == 1 && compile::IsType(_check, c->Fun.get())) {
+        // a conversion of a constant to a type whose values are constants
+        auto x = constant(c->ArgList[0].get());
+        if (!x || !types::IsConstType(e->typ)) {
+            return std::nullopt;
+        }
+        bool str = types::IsString(e->typ), isStr = x->Kind() == types::ConstKind::String;
+        return str == isStr ? x : std::nullopt;
+    }
+    return std::nullopt;
+}
+
+// constValue returns the constant c of type t.
+Value *builder::constValue(const types::Value &c, TypeId t) {
+    if (!c.IsKnown()) {
+        panic("ssa: unknown constant");
+    }
+    if (types::IsInterface(t)) {
+        // a constant assigned to an interface has its default type
+        TypeId def = KindInt;
+        switch (c.Kind()) {
+        case types::ConstKind::Bool:
+            def = KindBool;
+            break;
+        case types::ConstKind::String:
+            def = KindString;
+            break;
+        case types::ConstKind::Float:
+            def = KindFloat64;
+            break;
+        default:
+            break;
+        }
+        return val(Op::IMake, t, {constValue(c, def)});
+    }
+    auto entry = _f.Entry();
+    Value *v = nullptr;
+    if (types::IsBoolean(t)) {
+        v = _f.NewValue(entry, Op::ConstBool, t, {}, _pos);
+        v->AuxInt = c.BoolVal();
+    } else if (types::IsInteger(t)) {
+        v = _f.NewValue(entry, Op::ConstInt, t, {}, _pos);
+        if (auto i = c.Int64Val()) {
+            v->AuxInt = *i;
+        } else if (auto u = c.Uint64Val()) {
+            v->AuxInt = int64_t(*u);
+        } else {
+            v->AuxInt = int64_t(c.Float64Val());
+        }
+    } else if (types::IsFloat(t)) {
+        v = _f.NewValue(entry, Op::ConstFloat, t, {}, _pos);
+        auto d = kindOf(t) == KindFloat32 ? double(c.Float32Val()) : c.Float64Val();
+        v->AuxInt = std::bit_cast<int64_t>(d);
+    } else if (types::IsString(t)) {
+        v = _f.NewValue(entry, Op::ConstString, t, {}, _pos);
+        v->Str = _f.Intern(c.StringVal());
+    } else {
+        panic("ssa: complex constant");
+    }
+    return v;
+}
+
+// zero returns the zero value of type t.
+Value *builder::zero(TypeId t) {
+    auto entry = _f.Entry();
+    auto &u = under(t);
+    switch (u.Kind) {
+    case KindBool:
+        return _f.NewValue(entry, Op::ConstBool, t);
+    case KindFloat32:
+    case KindFloat64:
+        return _f.NewValue(entry, Op::ConstFloat, t);
+    case KindString:
+        return _f.NewValue(entry, Op::ConstString, t);
+    case KindStruct:
+        if (ssaable(t)) {
+            std::vector<Value *> fields;
+            for (auto ft : u.Elems) {
+                fields.push_back(zero(ft));
+            }
+            return _f.NewValue(entry, Op::StructMake, t, fields);
+        }
+        [[fallthrough]];
+    case KindArray:
+        // a zeroed temporary
+        return load(t, alloc(t, nullptr));
+    default:
+        if (types::IsInteger(t)) {
+            return _f.NewValue(entry, Op::ConstInt, t);
+        }
+        return _f.NewValue(entry, Op::ConstNil, t);
+    }
+}
+
+// convert converts v to type to as an assignment does.
+Value *builder::convert(Value *v, TypeId to) {
+    if (to == 0 || v->Type == to) {
+        return v;
+    }
+    if (v->Op == Op::ConstNil) {
+        return _f.ConstNil(to);
+    }
+    if (types::IsInterface(to)) {
+        return val(Op::IMake, to, {v});
+    }
+    auto from = _table.Underlying(v->Type), ut = _table.Underlying(to);
+    if (from == ut) {
+        return v;
+    }
+    if ((types::IsNumeric(from) && types::IsNumeric(ut)) || kindOf(from) == KindPointer ||
+        kindOf(from) == KindUnsafePointer) {
+        return val(Op::Convert, to, {v});
+    }
+    return v;
+}
+
+// conversion lowers the conversion call.
+Value *builder::conversion(ast::CallExpr *call) {
+    auto to = call->typ;
+    auto x = call->ArgList[0].get();
+    auto v = expr(x, to);
+    auto from = v->Type;
+    if (types::IsString(to) && !types::IsString(from)) {
+        if (types::IsInteger(from)) {
+            return runtime1("intstring", to, {v});
+        }
+        return runtime1(kindOf(elemOf(from)) == KindInt32 ? "slicerunetostring" : "slicebytetostring", to, {v});
+    }
+    if (kindOf(to) == KindSlice && types::IsString(from)) {
+        return runtime1(kindOf(elemOf(to)) == KindInt32 ? "stringtoslicerune" : "stringtoslicebyte", to, {v});
+    }
+    return convert(v, to);
+}
+
+// ----------------------------------------------------------------------------
+// Places
+
+bool builder::isPackage(ast::ExprNode *e) const {
+    auto n = dyn_cast<ast::Name>(unparen(e));
+    auto obj = n == nullptr ? nullptr : _check.ObjectOf(n);
+    return obj != nullptr && obj->Kind == ObjKind::PkgName;
+}
+
+// inRegister reports whether e is a variable in SSA form, or a field of
+// one.
+bool builder::inRegister(ast::ExprNode *e) const {
+    for (;;) {
+        e = unparen(e);
+        if (auto n = dyn_cast<ast::Name>(e)) {
+            return _ssa.contains(_check.ObjectOf(n));
+        }
+        auto s = dyn_cast<ast::SelectorExpr>(e);
+        if (s == nullptr || isPackage(s->X.get()) || isPointer(s->X->typ)) {
+            return false;
+        }
+        e = s->X.get();
+    }
+}
+
+// at returns the place holding the value of e: its variable if it is one
+// in memory, or its value.
+place builder::at(ast::ExprNode *e) {
+    e = unparen(e);
+    bool addressable = false;
+    if (auto n = dyn_cast<ast::Name>(e)) {
+        auto obj = _check.ObjectOf(n);
+        addressable = obj != nullptr && obj->Kind == ObjKind::Var && !_ssa.contains(obj);
+    } else if (auto s = dyn_cast<ast::SelectorExpr>(e)) {
+        addressable = isPackage(s->X.get()) || !inRegister(s);
+    } else if (auto x = dyn_cast<ast::IndexExpr>(e)) {
+        addressable = kindOf(x->X->typ) != KindString && kindOf(x->X->typ) != KindMap &&
+                      (kindOf(x->X->typ) != KindArray || !inRegister(x->X.get()));
+    } else if (auto op = dyn_cast<ast::Operation>(e)) {
+        addressable = op->Op == Operator_Mul && op->Y == nullptr;
+    }
+    if (addressable) {
+        return {addr(e), nullptr, e->typ};
+    }
+    return {nullptr, expr(e), e->typ};
+}
+
+// step returns the place of the field-th field of the struct at p, or of
+// the struct p points to.
+place builder::step(place p, int field) {
+    if (isPointer(p.Type)) {
+        auto ptr = get(p);
+        nilCheck(ptr);
+        p = {ptr, nullptr, elemOf(p.Type)};
+    }
+    auto ft = under(p.Type).Elems[size_t(field)];
+    if (p.Ptr != nullptr) {
+        auto f = val(Op::OffPtr, _table.Pointer(ft), {p.Ptr});
+        f->AuxInt = field;
+        return {f, nullptr, ft};
+    }
+    auto f = val(Op::StructSelect, ft, {p.Val});
+    f->AuxInt = field;
+    return {nullptr, f, ft};
+}
+
+place builder::selection(ast::ExprNode *x, std::span<const int> path) {
+    auto p = at(x);
+    for (auto i : path) {
+        p = step(p, i);
+    }
+    return p;
+}
+
+// receiver returns the receiver of a method with a pointer receiver or
+// not, selected on x through the embedded fields path.
+Value *builder::receiver(ast::ExprNode *x, std::span<const int> path, bool ptrRecv) {
+    auto p = selection(x, path);
+    if (isPointer(p.Type)) {
+        auto ptr = get(p);
+        if (ptrRecv) {
+            return ptr;
+        }
+        nilCheck(ptr);
+        return load(elemOf(p.Type), ptr);
+    }
+    if (ptrRecv) {
+        if (p.Ptr == nullptr) {
+            panic("ssa: pointer method on a register variable");
+        }
+        return p.Ptr;
+    }
+    return get(p);
+}
+
+// addr returns the address of the addressable expression e, or of the
+// new variable a composite literal &T{...} allocates.
+Value *builder::addr(ast::ExprNode *e) {
+    e = unparen(e);
+    _pos = e->GetPos();
+    if (auto n = dyn_cast<ast::Name>(e)) {
+        return varAddr(_check.ObjectOf(n));
+    }
+    if (auto s = dyn_cast<ast::SelectorExpr>(e)) {
+        if (isPackage(s->X.get())) {
+            return varAddr(_check.ObjectOf(s->Sel.get()));
+        }
+        auto sel = types::LookupFieldOrMethod(_check, s->X->typ, s->Sel->Sym);
+        auto p = selection(s->X.get(), sel.index);
+        if (p.Ptr == nullptr) {
+            panic("ssa: address of a field of a register variable");
+        }
+        return p.Ptr;
+    }
+    if (auto x = dyn_cast<ast::IndexExpr>(e)) {
+        return indexAddr(x);
+    }
+    if (auto op = dyn_cast<ast::Operation>(e); op && op->Op == Operator_Mul && op->Y == nullptr) {
+        auto p = expr(op->X.get());
+        nilCheck(p);
+        return p;
+    }
+    if (auto lit = dyn_cast<ast::CompositeLit>(e)) {
+        return newComposite(lit, lit);
+    }
+    panic("ssa: address of " + ast::String(e));
+    return nullptr;
+}
+
+// markAddrTaken finds the local variables that must live in memory: those
+// whose address is taken, explicitly or by calling a method with a pointer
+// receiver, whose array is sliced, or whose parts are assigned.
+void builder::markAddrTaken(ast::Node *body) {
+    auto mark = [&](ast::ExprNode *e) {
+        for (;;) {
+            e = unparen(e);
+            if (auto n = dyn_cast<ast::Name>(e)) {
+                if (auto obj = _check.ObjectOf(n); obj != nullptr && obj->Kind == ObjKind::Var && !obj->IsPackageLevel()) {
+                    _addrTaken.insert(obj);
+                }
+                return;
+            }
+            if (auto s = dyn_cast<ast::SelectorExpr>(e); s && !isPackage(s->X.get()) && !isPointer(s->X->typ)) {
+                e = s->X.get();
+            } else if (auto x = dyn_cast<ast::IndexExpr>(e); x && kindOf(x->X->typ) == KindArray) {
+                e = x->X.get();
+            } else {
+                return;
+            }
+        }
+    };
+    auto parts = [&](ast::ExprNode *lhs) {
+        for (auto e : exprList(lhs)) {
+            if (!isa<ast::Name>(unparen(e))) {
+                mark(e);
+            }
+        }
+    };
+    ast::Inspect(body, [&](ast::Node *n) {
+        if (auto op = dyn_cast<ast::Operation>(n); op && op->Op == Operator_And && op->Y == nullptr) {
+            mark(op->X.get());
+        } else if (auto s = dyn_cast<ast::SliceExpr>(n); s && kindOf(s->X->typ) == KindArray) {
+            mark(s->X.get());
+        } else if (auto sel = dyn_cast<ast::SelectorExpr>(n); sel && !isPackage(sel->X.get())) {
+            auto s = types::LookupFieldOrMethod(_check, sel->X->typ, sel->Sel->Sym);
+            if (s.kind == Selection::Method && s.method != nullptr && s.method->PtrRecv) {
+                mark(sel->X.get());
+            }
+        } else if (auto a = dyn_cast<ast::AssignStmt>(n)) {
+            parts(a->Lhs.get());
+        } else if (auto r = dyn_cast<ast::RangeClause>(n); r && !r->Def) {
+            parts(r->Lhs.get());
+        }
+        return true;
+    });
+}
+
+// unsupported returns what the builder does not lower in decl, or an
+// empty string. It runs after markAddrTaken.
+std::string builder::unsupported(ast::FuncDecl *decl) const {
+    auto obj = _check.ObjectOf(decl->Name.get());
+    if (!decl->TParamList.empty() || (obj != nullptr && !obj->TParams.empty())) {
+        return "generic function";
+    }
+    if (decl->Recv != nullptr) {
+        auto rt = unparen(decl->Recv->Type.get());
+        if (auto op = dyn_cast<ast::Operation>(rt); op && op->Op == Operator_Mul && op->Y == nullptr) {
+            rt = unparen(op->X.get());
+        }
+        if (!isa<ast::Name>(rt)) {
+            return "generic function";
+        }
+    }
+    auto &sig = under(decl->Type->typ);
+    for (auto ts : {sig.Params(), sig.Results()}) {
+        for (auto t : ts) {
+            if (types::IsComplex(t)) {
+                return "complex numbers";
+            }
+        }
+    }
+    std::string why;
+    std::unordered_set<const ast::Node *> callees;
+    ast::Inspect(decl->Body.get(), [&](ast::Node *n) {
+        if (!why.empty()) {
+            return false;
+        }
+        if (auto e = dyn_cast<ast::ExprNode>(n); e && types::IsComplex(e->typ)) {
+            why = "complex numbers";
+            return false;
+        }
+        switch (n->Kind()) {
+        case ast::NodeKind::FuncLit:
+            why = "closure";
+            break;
+        case ast::NodeKind::CallStmt:
+            why = cast<ast::CallStmt>(n)->Tok == Token_Defer ? "defer statement" : "go statement";
+            break;
+        case ast::NodeKind::SelectStmt:
+            why = "select statement";
+            break;
+        case ast::NodeKind::SwitchStmt:
+            if (isa_and_nonnull<ast::TypeSwitchGuard>(cast<ast::SwitchStmt>(n)->Tag.get())) {
+                why = "type switch";
+            }
+            break;
+        case ast::NodeKind::BranchStmt:
+            if (cast<ast::BranchStmt>(n)->Tok == Token_Goto) {
+                why = "goto";
+            }
+            break;
+        case ast::NodeKind::ForStmt: {
+            auto a = dyn_cast_or_null<ast::AssignStmt>(cast<ast::ForStmt>(n)->Init.get());
+            if (a == nullptr || a->Op != Operator_Def) {
+                break;
+            }
+            for (auto e : exprList(a->Lhs.get())) {
+                auto v = dyn_cast<ast::Name>(e);
+                if (v != nullptr && _addrTaken.contains(_check.ObjectOf(v))) {
+                    // each iteration has its own copy of the variable
+                    why = "address-taken loop variable";
+                }
+            }
+            break;
+        }
+        case ast::NodeKind::RangeClause: {
+            auto xt = cast<ast::RangeClause>(n)->X->typ;
+            auto k = kindOf(isPointer(xt) ? elemOf(xt) : xt);
+            if (!types::IsInteger(xt) && k != KindUntypedInt && k != KindUntypedRune && k != KindSlice &&
+                k != KindArray) {
+                why = "range over " + _table.String(xt);
+            }
+            break;
+        }
+        case ast::NodeKind::CompositeLit:
+            if (kindOf(cast<ast::CompositeLit>(n)->typ) == KindMap) {
+                why = "map literal";
+            }
+            break;
+        case ast::NodeKind::Name:
+            if (_check.InstanceOf(cast<ast::Name>(n)) != nullptr) {
+                why = "generic function";
+            }
+            break;
+        case ast::NodeKind::IndexExpr:
+            if (kindOf(cast<ast::IndexExpr>(n)->X->typ) == KindFunc) {
+                why = "generic function";
+            }
+            break;
+        case ast::NodeKind::SelectorExpr: {
+            auto sel = cast<ast::SelectorExpr>(n);
+            if (isPackage(sel->X.get()) || callees.contains(sel)) {
+                break;
+            }
+            if (types::LookupFieldOrMethod(_check, sel->X->typ, sel->Sel->Sym).kind != Selection::Field) {
+                why = "method value";
+            }
+            break;
+        }
+        case ast::NodeKind::CallExpr: {
+            auto c = cast<ast::CallExpr>(n);
+            auto fun = unparen(c->Fun.get());
+            callees.insert(fun);
+            if (auto name = dyn_cast<ast::Name>(fun)) {
+                auto b = _check.ObjectOf(name);
+                if (b != nullptr && b->Kind == ObjKind::Builtin && b->Builtin == BuiltinId::Recover) {
+                    why = "recover";
+                }
+            } else if (compile::IsType(_check, fun) && kindOf(c->ArgList[0]->typ) == KindSlice &&
+                       kindOf(c->typ) != KindSlice && !types::IsString(c->typ)) {
+                why = "slice to array conversion";
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        return why.empty();
+    });
+    return why;
+}
+
+// ----------------------------------------------------------------------------
+// Expressions
+
+// expr returns the value of the single-valued expression e; untyped
+// constants and nil take the type want, if set.
+Value *builder::expr(ast::ExprNode *e, TypeId want) {
+    e = unparen(e);
+    reachable();
+    _pos = e->GetPos();
+    if (auto c = constant(e)) {
+        auto t = e->typ;
+        if (t == 0 || types::IsUntyped(t)) {
+            t = want != 0 ? want : types::DefaultType(t);
+        }
+        return constValue(*c, t);
+    }
+    switch (e->Kind()) {
+    case ast::NodeKind::Name:
+        return name(cast<ast::Name>(e), want);
+    case ast::NodeKind::SelectorExpr: {
+        auto s = cast<ast::SelectorExpr>(e);
+        if (isPackage(s->X.get())) {
+            return name(s->Sel.get(), want);
+        }
+        auto sel = types::LookupFieldOrMethod(_check, s->X->typ, s->Sel->Sym);
+        return get(selection(s->X.get(), sel.index));
+    }
+    case ast::NodeKind::IndexExpr:
+        return index(cast<ast::IndexExpr>(e));
+    case ast::NodeKind::SliceExpr:
+        return slice(cast<ast::SliceExpr>(e));
+    case ast::NodeKind::Operation:
+        return operation(cast<ast::Operation>(e), want);
+    case ast::NodeKind::CallExpr: {
+        auto results = call(cast<ast::CallExpr>(e));
+        if (results.size() != 1) {
+            panic("ssa: call without a single result");
+        }
+        return results[0];
+    }
+    case ast::NodeKind::CompositeLit:
+        return composite(cast<ast::CompositeLit>(e));
+    case ast::NodeKind::AssertExpr: {
+        auto a = cast<ast::AssertExpr>(e);
+        return runtime1("typeAssert", e->typ, {expr(a->X.get())});
+    }
+    default:
+        panic("ssa: unexpected expression " + ast::String(e));
+        return nullptr;
+    }
+}
+
+// exprN returns the values of a multi-valued expression: a call, or the
+// comma-ok form of a map index, a type assertion or a receive.
+std::vector<Value *> builder::exprN(ast::ExprNode *e) {
+    e = unparen(e);
+    reachable();
+    _pos = e->GetPos();
+    if (auto c = dyn_cast<ast::CallExpr>(e)) {
+        return call(c);
+    }
+    TypeId types[] = {e->typ, KindBool};
+    if (auto x = dyn_cast<ast::IndexExpr>(e)) {
+        auto m = expr(x->X.get());
+        return runtime("mapaccess2", types, {m, expr(x->Index.get(), under(m->Type).Key())});
+    }
+    if (auto a = dyn_cast<ast::AssertExpr>(e)) {
+        return runtime("typeAssert2", types, {expr(a->X.get())});
+    }
+    if (auto op = dyn_cast<ast::Operation>(e); op && op->Op == Operator_Recv) {
+        return runtime("chanrecv2", types, {expr(op->X.get())});
+    }
+    panic("ssa: unexpected expression " + ast::String(e));
+    return {};
+}
+
+Value *builder::name(ast::Name *n, TypeId want) {
+    auto obj = _check.ObjectOf(n);
+    switch (obj->Kind) {
+    case ObjKind::Nil:
+        return _f.ConstNil(want != 0 ? want : n->typ);
+    case ObjKind::Var:
+        return readVar(obj, obj->Type);
+    case ObjKind::Func: {
+        auto v = val(Op::Addr, obj->Type);
+        v->Sym = obj;
+        return v;
+    }
+    default:
+        panic("ssa: unexpected name " + std::string(n->Value));
+        return nullptr;
+    }
+}
+
+Value *builder::operation(ast::Operation *op, TypeId want) {
+    auto t = op->typ;
+    if (t == 0 || types::IsUntyped(t)) {
+        t = want != 0 ? want : types::DefaultType(t);
+    }
+    if (op->Y == nullptr) {
+        switch (op->Op) {
+        case Operator_And:
+            if (auto lit = dyn_cast<ast::CompositeLit>(unparen(op->X.get()))) {
+                return newComposite(lit, op); // the allocation site of &T{...}
+            }
+            return addr(op->X.get());
+        case Operator_Mul: {
+            auto p = expr(op->X.get());
+            nilCheck(p);
+            return load(t, p);
+        }
+        case Operator_Recv:
+            return runtime1("chanrecv1", t, {expr(op->X.get())});
+        case Operator_Add:
+            return expr(op->X.get(), t);
+        case Operator_Sub:
+            return val(Op::Neg, t, {expr(op->X.get(), t)});
+        case Operator_Xor:
+            return val(Op::Com, t, {expr(op->X.get(), t)});
+        case Operator_Not:
+            return val(Op::Not, t, {expr(op->X.get(), t)});
+        default:
+            panic("ssa: unexpected operation " + ast::String(op));
+            return nullptr;
+        }
+    }
+    if (op->Op == Operator_AndAnd || op->Op == Operator_OrOr) {
+        auto v = newVar(t);
+        auto yes = newBlock(), no = newBlock(), done = newBlock();
+        cond(op, yes, no);
+        seal(yes);
+        seal(no);
+        _cur = yes;
+        write(v, _cur, constValue(types::Value::MakeBool(true), t));
+        jump(done);
+        _cur = no;
+        write(v, _cur, constValue(types::Value::MakeBool(false), t));
+        jump(done);
+        seal(done);
+        _cur = done;
+        return read(v, done);
+    }
+    if (op->Op >= Operator_Eql && op->Op <= Operator_Geq) {
+        auto xt = op->X->typ, yt = op->Y->typ;
+        auto x = expr(op->X.get(), types::IsUntyped(xt) && !types::IsUntyped(yt) ? yt : 0);
+        auto y = expr(op->Y.get(), x->Type);
+        if (types::IsInterface(x->Type) != types::IsInterface(y->Type)) {
+            // comparing an interface to a concrete value
+            if (types::IsInterface(x->Type)) {
+                y = convert(y, x->Type);
+            } else {
+                x = convert(x, y->Type);
+            }
+        }
+        switch (op->Op) {
+        case Operator_Eql:
+            return val(Op::Eq, t, {x, y});
+        case Operator_Neq:
+            return val(Op::Neq, t, {x, y});
+        case Operator_Lss:
+            return val(Op::Less, t, {x, y});
+        case Operator_Leq:
+            return val(Op::Leq, t, {x, y});
+        case Operator_Gtr:
+            return val(Op::Less, t, {y, x});
+        default:
+            return val(Op::Leq, t, {y, x});
+        }
+    }
+    auto x = expr(op->X.get(), t);
+    auto shift = op->Op == Operator_Shl || op->Op == Operator_Shr;
+    auto y = expr(op->Y.get(), shift ? TypeId(KindUint) : t);
+    return binary(op->Op, x, y, t);
+}
+
+// binary returns x op y for an arithmetic operator op.
+Value *builder::binary(syntax::Operator op, Value *x, Value *y, TypeId t) {
+    if (op != Operator_Shl && op != Operator_Shr) {
+        y = convert(y, t);
+    }
+    switch (op) {
+    case Operator_Add:
+        if (types::IsString(t)) {
+            return runtime1("concatstrings", t, {x, y});
+        }
+        return val(Op::Add, t, {x, y});
+    case Operator_Sub:
+        return val(Op::Sub, t, {x, y});
+    case Operator_Mul:
+        return val(Op::Mul, t, {x, y});
+    case Operator_Div:
+        return val(Op::Div, t, {x, y});
+    case Operator_Rem:
+        return val(Op::Mod, t, {x, y});
+    case Operator_And:
+        return val(Op::And, t, {x, y});
+    case Operator_Or:
+        return val(Op::Or, t, {x, y});
+    case Operator_Xor:
+        return val(Op::Xor, t, {x, y});
+    case Operator_AndNot:
+        return val(Op::AndNot, t, {x, y});
+    case Operator_Shl:
+        return val(Op::Shl, t, {x, y});
+    case Operator_Shr:
+        return val(Op::Shr, t, {x, y});
+    default:
+        panic(fmt::format("ssa: unexpected operator {}", int(op)));
+        return nullptr;
+    }
+}
+
+// intIndex returns the value of an index as an int.
+Value *builder::intIndex(ast::ExprNode *e) {
+    auto i = expr(e, KindInt);
+    return _table.Underlying(i->Type) == KindInt ? i : val(Op::Convert, KindInt, {i});
+}
+
+Value *builder::index(ast::IndexExpr *e) {
+    auto xt = e->X->typ;
+    switch (kindOf(xt)) {
+    case KindString: {
+        auto s = expr(e->X.get());
+        auto i = intIndex(e->Index.get());
+        boundsCheck(i, val(Op::StringLen, KindInt, {s}));
+        auto p = val(Op::PtrIndex, _table.Pointer(KindUint8), {val(Op::StringPtr, _table.Pointer(KindUint8), {s}), i});
+        return load(e->typ, p);
+    }
+    case KindMap: {
+        auto m = expr(e->X.get());
+        return runtime1("mapaccess1", e->typ, {m, expr(e->Index.get(), under(xt).Key())});
+    }
+    default:
+        return load(e->typ, indexAddr(e));
+    }
+}
+
+// indexAddr returns the address of the element of an array or slice
+// e.X[e.Index], after checking the index.
+Value *builder::indexAddr(ast::IndexExpr *e) {
+    auto xt = e->X->typ;
+    Value *base, *len;
+    TypeId elem;
+    if (kindOf(xt) == KindSlice) {
+        auto s = expr(e->X.get());
+        elem = elemOf(xt);
+        auto i = intIndex(e->Index.get());
+        boundsCheck(i, val(Op::SliceLen, KindInt, {s}));
+        base = val(Op::SlicePtr, _table.Pointer(elem), {s});
+        return val(Op::PtrIndex, _table.Pointer(elem), {base, i});
+    }
+    if (kindOf(xt) == KindMap) {
+        auto m = expr(e->X.get());
+        auto k = expr(e->Index.get(), under(xt).Key());
+        return runtime1("mapassign", _table.Pointer(e->typ), {m, k});
+    }
+    auto at = xt;
+    if (isPointer(xt)) {
+        base = expr(e->X.get());
+        nilCheck(base);
+        at = elemOf(xt);
+    } else {
+        base = addr(e->X.get());
+    }
+    elem = under(at).Elem();
+    len = _f.ConstInt(KindInt, under(at).Len);
+    auto i = intIndex(e->Index.get());
+    boundsCheck(i, len);
+    return val(Op::PtrIndex, _table.Pointer(elem), {base, i});
+}
+
+Value *builder::slice(ast::SliceExpr *e) {
+    auto xt = e->X->typ;
+    bool str = types::IsString(xt);
+    Value *ptr, *len, *cap;
+    if (str || kindOf(xt) == KindSlice) {
+        auto s = expr(e->X.get());
+        auto pt = _table.Pointer(str ? TypeId(KindUint8) : elemOf(xt));
+        ptr = val(str ? Op::StringPtr : Op::SlicePtr, pt, {s});
+        len = val(str ? Op::StringLen : Op::SliceLen, KindInt, {s});
+        cap = str ? len : val(Op::SliceCap, KindInt, {s});
+    } else {
+        auto at = xt;
+        if (isPointer(xt)) {
+            ptr = expr(e->X.get());
+            nilCheck(ptr);
+            at = elemOf(xt);
+        } else {
+            ptr = addr(e->X.get());
+        }
+        ptr = val(Op::Convert, _table.Pointer(under(at).Elem()), {ptr});
+        len = cap = _f.ConstInt(KindInt, under(at).Len);
+    }
+    auto lo = e->Index[0] != nullptr ? intIndex(e->Index[0].get()) : nullptr;
+    auto hi = e->Index[1] != nullptr ? intIndex(e->Index[1].get()) : len;
+    auto max = e->Index[2] != nullptr ? intIndex(e->Index[2].get()) : cap;
+    // 0 <= lo <= hi <= max <= cap
+    if (e->Index[2] != nullptr) {
+        boundsCheck(max, cap, true);
+    }
+    if (e->Index[1] != nullptr) {
+        boundsCheck(hi, max, true);
+    }
+    if (lo != nullptr) {
+        boundsCheck(lo, hi, true);
+        ptr = val(Op::PtrIndex, ptr->Type, {ptr, lo});
+        hi = val(Op::Sub, KindInt, {hi, lo});
+        max = val(Op::Sub, KindInt, {max, lo});
+    }
+    if (str) {
+        return val(Op::StringMake, e->typ, {ptr, hi});
+    }
+    return val(Op::SliceMake, e->typ, {ptr, hi, max});
+}
+
+// composite returns the value of a composite literal.
+Value *builder::composite(ast::CompositeLit *lit) {
+    auto t = lit->typ;
+    auto &u = under(t);
+    if (u.Kind == KindStruct && ssaable(t)) {
+        std::vector<Value *> fields(u.Elems.size());
+        for (size_t i = 0; i < lit->ElemList.size(); i++) {
+            auto e = lit->ElemList[i].get();
+            size_t f = i;
+            if (auto kv = dyn_cast<ast::KeyValueExpr>(e)) {
+                auto key = cast<ast::Name>(kv->Key.get())->Sym;
+                for (f = 0; f < u.Names.size() && types::FieldName(u.Names[f]) != key; f++) {
+                }
+                e = kv->Value.get();
+            }
+            fields[f] = elemValue(e, u.Elems[f]);
+        }
+        for (size_t f = 0; f < fields.size(); f++) {
+            if (fields[f] == nullptr) {
+                fields[f] = zero(u.Elems[f]);
+            }
+        }
+        return val(Op::StructMake, t, fields);
+    }
+    if (u.Kind == KindSlice) {
+        int64_t n = 0, i = 0;
+        if (lit->Packed != nullptr) {
+            n = int64_t(lit->Packed->Len());
+        }
+        for (auto &e : lit->ElemList) {
+            if (auto kv = dyn_cast<ast::KeyValueExpr>(e.get())) {
+                i = constant(kv->Key.get())->Int64Val().value_or(0);
+            }
+            n = std::max(n, ++i);
+        }
+        auto p = alloc(_table.Array(n, u.Elem()), lit);
+        initComposite(p, _table.Array(n, u.Elem()), lit);
+        auto ptr = val(Op::Convert, _table.Pointer(u.Elem()), {p});
+        auto len = _f.ConstInt(KindInt, n);
+        return val(Op::SliceMake, t, {ptr, len, len});
+    }
+    // an array or large struct is built in a temporary
+    return load(t, newComposite(lit, nullptr));
+}
+
+// newComposite allocates a new variable holding the value of a composite
+// literal for the allocation site site, or a temporary if nil, and returns
+// its address.
+Value *builder::newComposite(ast::CompositeLit *lit, const ast::Node *site) {
+    auto p = alloc(lit->typ, site);
+    initComposite(p, lit->typ, lit);
+    return p;
+}
+
+// initComposite stores the elements of a composite literal of type t to
+// the zeroed variable at p.
+void builder::initComposite(Value *p, TypeId t, ast::CompositeLit *lit) {
+    auto &u = under(t);
+    if (u.Kind == KindStruct) {
+        for (size_t i = 0; i < lit->ElemList.size(); i++) {
+            auto e = lit->ElemList[i].get();
+            size_t f = i;
+            if (auto kv = dyn_cast<ast::KeyValueExpr>(e)) {
+                auto key = cast<ast::Name>(kv->Key.get())->Sym;
+                for (f = 0; f < u.Names.size() && types::FieldName(u.Names[f]) != key; f++) {
+                }
+                e = kv->Value.get();
+            }
+            auto v = elemValue(e, u.Elems[f]);
+            auto fp = val(Op::OffPtr, _table.Pointer(u.Elems[f]), {p});
+            fp->AuxInt = int64_t(f);
+            store(fp, v);
+        }
+        return;
+    }
+    auto elem = u.Elem();
+    auto ep = _table.Pointer(elem);
+    if (lit->Packed != nullptr) {
+        // the packed elements are the bytes of the array as is, copied from
+        // read-only data in one move
+        auto &data = lit->Packed->Data;
+        auto n = int64_t(lit->Packed->Len());
+        auto src = val(Op::StaticData, _table.Pointer(_table.Array(n, elem)));
+        src->Str = _f.Pin(lit->Packed, {reinterpret_cast<const char *>(data.data()), data.size()});
+        auto m = val(Op::Move, TypeMem, {p, src, mem()});
+        m->AuxInt = int64_t(data.size());
+        setMem(m);
+        return;
+    }
+    int64_t i = 0;
+    for (auto &x : lit->ElemList) {
+        auto e = x.get();
+        if (auto kv = dyn_cast<ast::KeyValueExpr>(e)) {
+            i = constant(kv->Key.get())->Int64Val().value_or(0);
+            e = kv->Value.get();
+        }
+        auto v = elemValue(e, elem);
+        store(val(Op::PtrIndex, ep, {p, _f.ConstInt(KindInt, i)}), v);
+        i++;
+    }
+}
+
+// elemValue returns the value of an element of a composite literal of
+// type t, whose literal type may be elided.
+Value *builder::elemValue(ast::ExprNode *e, TypeId t) {
+    auto lit = dyn_cast<ast::CompositeLit>(unparen(e));
+    if (lit != nullptr && lit->Type == nullptr && isPointer(t) && !isPointer(lit->typ)) {
+        return newComposite(lit, lit); // &T elided
+    }
+    return convert(expr(e, t), t);
+}
+
+// args returns the arguments of a call of a function of signature sig,
+// converted to the parameter types, with the variadic ones in a slice.
+std::vector<Value *> builder::args(ast::CallExpr *call, TypeId sig) {
+    auto &s = under(sig);
+    auto params = s.Params();
+    std::vector<Value *> in;
+    if (call->ArgList.size() == 1 && params.size() > 1) {
+        in = exprN(call->ArgList[0].get()); // f(g())
+    } else {
+        for (size_t i = 0; i < call->ArgList.size(); i++) {
+            TypeId want = 0;
+            if (i < params.size()) {
+                want = params[i];
+            }
+            if (s.Variadic && !call->HasDots && i + 1 >= params.size()) {
+                want = elemOf(params.back());
+            }
+            in.push_back(expr(call->ArgList[i].get(), want));
+        }
+    }
+    std::vector<Value *> out;
+    size_t fixed = s.Variadic && !call->HasDots ? params.size() - 1 : params.size();
+    for (size_t i = 0; i < fixed && i < in.size(); i++) {
+        out.push_back(convert(in[i], params[i]));
+    }
+    if (fixed < params.size()) {
+        auto st = params.back();
+        auto elem = elemOf(st);
+        auto n = int64_t(in.size() > fixed ? in.size() - fixed : 0);
+        if (n == 0) {
+            out.push_back(_f.ConstNil(st));
+        } else {
+            auto at = _table.Array(n, elem);
+            auto p = alloc(at, call);
+            for (int64_t i = 0; i < n; i++) {
+                auto ep = val(Op::PtrIndex, _table.Pointer(elem), {p, _f.ConstInt(KindInt, i)});
+                store(ep, convert(in[fixed + size_t(i)], elem));
+            }
+            auto len = _f.ConstInt(KindInt, n);
+            out.push_back(val(Op::SliceMake, st, {val(Op::Convert, _table.Pointer(elem), {p}), len, len}));
+        }
+    }
+    return out;
+}
+
+std::vector<Value *> builder::call(ast::CallExpr *c) {
+    auto fun = unparen(c->Fun.get());
+    if (compile::IsType(_check, fun)) {
+        return {conversion(c)};
+    }
+    ast::Name *fname = dyn_cast<ast::Name>(fun);
+    if (auto s = dyn_cast<ast::SelectorExpr>(fun); s && isPackage(s->X.get())) {
+        fname = s->Sel.get();
+    }
+    if (fname != nullptr) {
+        auto obj = _check.ObjectOf(fname);
+        if (obj != nullptr && obj->Kind == ObjKind::Builtin) {
+            return builtin(c, obj->Builtin);
+        }
+    }
+    auto sig = fun->typ;
+    std::vector<Value *> in;
+    Value *call;
+    if (auto callee = compile::StaticCallee(_check, c)) {
+        auto sel = dyn_cast<ast::SelectorExpr>(fun);
+        if (sel != nullptr && !isPackage(sel->X.get()) && !compile::IsType(_check, sel->X.get())) {
+            auto s = types::LookupFieldOrMethod(_check, sel->X->typ, sel->Sel->Sym);
+            in.push_back(receiver(sel->X.get(), s.index, callee->PtrRecv));
+        }
+        for (auto a : args(c, sig)) {
+            in.push_back(a);
+        }
+        in.push_back(mem());
+        _pos = c->GetPos();
+        call = val(Op::StaticCall, TypeMem, in);
+        call->Sym = callee;
+    } else if (auto sel = dyn_cast<ast::SelectorExpr>(fun); sel && types::IsInterface(sel->X->typ)) {
+        if (auto d = _devirt != nullptr ? _devirt->Devirtualized(c) : nullptr) {
+            return devirtualized(c, sel, *d);
+        }
+        in.push_back(expr(sel->X.get()));
+        for (auto a : args(c, sig)) {
+            in.push_back(a);
+        }
+        in.push_back(mem());
+        _pos = c->GetPos();
+        call = val(Op::InterCall, TypeMem, in);
+        call->Str = sel->Sel->Value;
+    } else {
+        if (sel != nullptr && !isPackage(sel->X.get())) {
+            auto s = types::LookupFieldOrMethod(_check, sel->X->typ, sel->Sel->Sym);
+            if (s.kind == Selection::Method) {
+                // a method promoted from an embedded interface
+                in.push_back(receiver(sel->X.get(), s.index, false));
+                for (auto a : args(c, sig)) {
+                    in.push_back(a);
+                }
+                in.push_back(mem());
+                _pos = c->GetPos();
+                call = val(Op::InterCall, TypeMem, in);
+                call->Str = sel->Sel->Value;
+                setMem(call);
+                return selectResults(call, under(sig).Results());
+            }
+        }
+        in.push_back(expr(fun));
+        for (auto a : args(c, sig)) {
+            in.push_back(a);
+        }
+        in.push_back(mem());
+        _pos = c->GetPos();
+        call = val(Op::ClosureCall, TypeMem, in);
+    }
+    setMem(call);
+    return selectResults(call, under(sig).Results());
+}
+
+// devirtualized lowers the interface call c of the method sel to a static
+// call of the method of the dynamic type d resolves it to, on the value the
+// receiver is asserted to hold. A guarded call is made only if the receiver
+// holds the type, and through the interface otherwise.
+std::vector<Value *> builder::devirtualized(ast::CallExpr *c, ast::SelectorExpr *sel, const compile::DevirtCall &d) {
+    auto sig = c->Fun->typ;
+    auto results = under(sig).Results();
+    auto x = expr(sel->X.get());
+    auto in = args(c, sig);
+    auto emit = [&](Op op, Value *recv) {
+        std::vector<Value *> vs{recv};
+        vs.insert(vs.end(), in.begin(), in.end());
+        vs.push_back(mem());
+        _pos = c->GetPos();
+        auto v = val(op, TypeMem, vs);
+        setMem(v);
+        return v;
+    };
+    auto direct = [&](Value *v) {
+        if (isPointer(d.Type) && !d.Method->PtrRecv) {
+            // a method of T called on the *T the interface holds
+            nilCheck(v);
+            v = load(elemOf(d.Type), v);
+        }
+        auto call = emit(Op::StaticCall, v);
+        call->Sym = d.Method;
+        return selectResults(call, results);
+    };
+    if (!d.Guarded) {
+        return direct(runtime1("typeAssert", d.Type, {x}));
+    }
+    TypeId types[] = {d.Type, KindBool};
+    auto asserted = runtime("typeAssert2", types, {x});
+    std::vector<uint32_t> vars;
+    for (auto t : results) {
+        vars.push_back(newVar(t));
+    }
+    auto yes = newBlock(), no = newBlock(), done = newBlock();
+    branch(asserted[1], yes, no);
+    seal(yes);
+    seal(no);
+    _cur = yes;
+    auto rs = direct(asserted[0]);
+    for (size_t i = 0; i < vars.size(); i++) {
+        write(vars[i], _cur, rs[i]);
+    }
+    jump(done);
+    _cur = no;
+    auto indirect = emit(Op::InterCall, x);
+    indirect->Str = sel->Sel->Value;
+    rs = selectResults(indirect, results);
+    for (size_t i = 0; i < vars.size(); i++) {
+        write(vars[i], _cur, rs[i]);
+    }
+    jump(done);
+    seal(done);
+    _cur = done;
+    std::vector<Value *> out;
+    for (auto v : vars) {
+        out.push_back(read(v, done));
+    }
+    return out;
+}
+
+std::vector<Value *> builder::builtin(ast::CallExpr *c, BuiltinId id) {
+    auto arg = [&](size_t i, TypeId want = 0) { return expr(c->ArgList[i].get(), want); };
+    auto t = c->typ;
+    switch (id) {
+    case BuiltinId::Len:
+    case BuiltinId::Cap: {
+        bool len = id == BuiltinId::Len;
+        auto xt = c->ArgList[0]->typ;
+        if (isPointer(xt)) {
+            xt = elemOf(xt);
+        }
+        switch (kindOf(xt)) {
+        case KindArray:
+            return {_f.ConstInt(t, under(xt).Len)};
+        case KindString:
+            return {val(Op::StringLen, t, {arg(0)})};
+        case KindSlice:
+            return {val(len ? Op::SliceLen : Op::SliceCap, t, {arg(0)})};
+        case KindMap:
+            return {runtime1("maplen", t, {arg(0)})};
+        default:
+            return {runtime1(len ? "chanlen" : "chancap", t, {arg(0)})};
+        }
+    }
+    case BuiltinId::New:
+        return {alloc(elemOf(t), c)};
+    case BuiltinId::Make: {
+        std::vector<Value *> sizes;
+        for (size_t i = 1; i < c->ArgList.size(); i++) {
+            auto v = arg(i, KindInt);
+            sizes.push_back(_table.Underlying(v->Type) == KindInt ? v : val(Op::Convert, KindInt, {v}));
+        }
+        switch (kindOf(t)) {
+        case KindSlice:
+            if (sizes.size() == 1) {
+                sizes.push_back(sizes[0]);
+            }
+            return {runtime1("makeslice", t, sizes)};
+        case KindMap:
+            return {runtime1("makemap", t, sizes)};
+        default:
+            return {runtime1("makechan", t, sizes)};
+        }
+    }
+    case BuiltinId::Append: {
+        auto s = arg(0, t);
+        if (c->HasDots) {
+            return {runtime1("appendslice", t, {s, arg(1)})};
+        }
+        std::vector<Value *> in{s};
+        for (size_t i = 1; i < c->ArgList.size(); i++) {
+            in.push_back(convert(arg(i, elemOf(t)), elemOf(t)));
+        }
+        return {runtime1("append", t, in)};
+    }
+    case BuiltinId::Copy:
+        return {runtime1("slicecopy", KindInt, {arg(0), arg(1)})};
+    case BuiltinId::Delete: {
+        auto m = arg(0);
+        runtime("mapdelete", {}, {m, arg(1, under(m->Type).Key())});
+        return {};
+    }
+    case BuiltinId::Clear:
+        runtime("clear", {}, {arg(0)});
+        return {};
+    case BuiltinId::Close:
+        runtime("closechan", {}, {arg(0)});
+        return {};
+    case BuiltinId::Panic: {
+        auto any = _table.Interface({}, {});
+        auto v = convert(arg(0, any), any);
+        exit(val(Op::Panic, TypeMem, {v, mem()}));
+        return {};
+    }
+    case BuiltinId::Print:
+    case BuiltinId::Println: {
+        std::vector<Value *> in;
+        for (size_t i = 0; i < c->ArgList.size(); i++) {
+            in.push_back(arg(i));
+        }
+        runtime(id == BuiltinId::Print ? "print" : "println", {}, in);
+        return {};
+    }
+    case BuiltinId::Min:
+    case BuiltinId::Max: {
+        std::vector<Value *> in;
+        for (size_t i = 0; i < c->ArgList.size(); i++) {
+            in.push_back(convert(arg(i, t), t));
+        }
+        return {runtime1(id == BuiltinId::Min ? "min" : "max", t, in)};
+    }
+    default:
+        panic("ssa: unexpected builtin");
+        return {};
+    }
+}
+
+// cond branches to yes if e is true and to no otherwise, evaluating the
+// operands of && and || only as far as needed.
+void builder::cond(ast::ExprNode *e, Block *yes, Block *no) {
+    e = unparen(e);
+    if (auto op = dyn_cast<ast::Operation>(e)) {
+        if (op->Op == Operator_AndAnd || op->Op == Operator_OrOr) {
+            auto mid = newBlock();
+            if (op->Op == Operator_AndAnd) {
+                cond(op->X.get(), mid, no);
+            } else {
+                cond(op->X.get(), yes, mid);
+            }
+            seal(mid);
+            _cur = mid;
+            cond(op->Y.get(), yes, no);
+            return;
+        }
+        if (op->Op == Operator_Not && op->Y == nullptr) {
+            cond(op->X.get(), no, yes);
+            return;
+        }
+    }
+    auto v = expr(e, KindBool);
+    branch(v, yes, no);
+}
+
+// ----------------------------------------------------------------------------
+// Statements
+
+void builder::stmt(ast::StmtNode *s, common::SymbolId label) {
+    if (s == nullptr) {
+        return;
+    }
+    reachable();
+    _pos = s->GetPos();
+    switch (s->Kind()) {
+    case ast::NodeKind::BlockStmt:
+        stmts(cast<ast::BlockStmt>(s)->List);
+        break;
+    case ast::NodeKind::LabeledStmt: {
+        auto l = cast<ast::LabeledStmt>(s);
+        stmt(l->Stmt.get(), l->Label->Sym);
+        break;
+    }
+    case ast::NodeKind::DeclStmt:
+        for (auto &d : cast<ast::DeclStmt>(s)->DeclList) {
+            if (auto v = dyn_cast<ast::VarDecl>(d.get())) {
+                varDecl(v);
+            }
+        }
+        break;
+    case ast::NodeKind::IfStmt:
+        ifStmt(cast<ast::IfStmt>(s));
+        break;
+    case ast::NodeKind::ForStmt:
+        forStmt(cast<ast::ForStmt>(s), label);
+        break;
+    case ast::NodeKind::SwitchStmt:
+        switchStmt(cast<ast::SwitchStmt>(s), label);
+        break;
+    case ast::NodeKind::ReturnStmt:
+        returnStmt(cast<ast::ReturnStmt>(s));
+        break;
+    case ast::NodeKind::BranchStmt:
+        branchStmt(cast<ast::BranchStmt>(s));
+        break;
+    default:
+        simpleStmt(cast<ast::SimpleStmtNode>(s));
+        break;
+    }
+}
+
+void builder::simpleStmt(ast::SimpleStmtNode *s) {
+    if (s == nullptr) {
+        return;
+    }
+    reachable();
+    _pos = s->GetPos();
+    if (auto e = dyn_cast<ast::ExprStmt>(s)) {
+        auto x = unparen(e->X.get());
+        if (auto c = dyn_cast<ast::CallExpr>(x)) {
+            call(c);
+        } else {
+            expr(x);
+        }
+    } else if (auto send = dyn_cast<ast::SendStmt>(s)) {
+        auto ch = expr(send->Chan.get());
+        auto elem = elemOf(ch->Type);
+        runtime("chansend1", {}, {ch, convert(expr(send->Value.get(), elem), elem)});
+    } else if (auto a = dyn_cast<ast::AssignStmt>(s)) {
+        assign(a);
+    } else if (!isa<ast::EmptyStmt>(s)) {
+        panic("ssa: unexpected statement");
+    }
+}
+
+lvalue builder::lhs(ast::ExprNode *e, bool def) {
+    e = unparen(e);
+    lvalue lv;
+    lv.type = e->typ;
+    if (auto n = dyn_cast<ast::Name>(e)) {
+        auto obj = _check.ObjectOf(n);
+        if (obj == nullptr || n->Value == "_") {
+            return lv;
+        }
+        lv.type = obj->Type;
+        if (def && obj->Pos == n->GetPos()) {
+            lv.kind = lvalue::Decl;
+            lv.obj = obj;
+        } else if (auto it = _ssa.find(obj); it != _ssa.end()) {
+            lv.kind = lvalue::Var;
+            lv.var = it->second;
+        } else {
+            lv.kind = lvalue::Mem;
+            lv.ptr = varAddr(obj);
+        }
+        return lv;
+    }
+    if (auto x = dyn_cast<ast::IndexExpr>(e); x && kindOf(x->X->typ) == KindMap) {
+        lv.kind = lvalue::MapElem;
+        lv.ptr = expr(x->X.get());
+        lv.key = expr(x->Index.get(), under(lv.ptr->Type).Key());
+        return lv;
+    }
+    lv.kind = lvalue::Mem;
+    lv.ptr = addr(e);
+    return lv;
+}
+
+void builder::assignTo(const lvalue &lv, Value *v) {
+    switch (lv.kind) {
+    case lvalue::Blank:
+        break;
+    case lvalue::Var:
+        write(lv.var, _cur, convert(v, lv.type));
+        break;
+    case lvalue::Decl:
+        declare(lv.obj, convert(v, lv.type));
+        break;
+    case lvalue::Mem:
+        store(lv.ptr, convert(v, lv.type));
+        break;
+    case lvalue::MapElem:
+        store(runtime1("mapassign", _table.Pointer(lv.type), {lv.ptr, lv.key}), convert(v, lv.type));
+        break;
+    }
+}
+
+void builder::assign(ast::AssignStmt *s) {
+    if (s->Rhs == nullptr) {
+        // x++ and x--
+        opAssign(s->Lhs.get(), s->Op, nullptr);
+        return;
+    }
+    if (s->Op != 0 && s->Op != Operator_Def) {
+        opAssign(s->Lhs.get(), s->Op, s->Rhs.get());
+        return;
+    }
+    auto lhsList = exprList(s->Lhs.get()), rhsList = exprList(s->Rhs.get());
+    bool def = s->Op == Operator_Def;
+    // the operands of the left-hand side are evaluated first, then the
+    // right-hand side, then the assignments are made
+    std::vector<lvalue> lvs;
+    for (auto e : lhsList) {
+        lvs.push_back(lhs(e, def));
+    }
+    std::vector<Value *> values;
+    if (rhsList.size() == 1 && lhsList.size() > 1) {
+        values = exprN(rhsList[0]);
+    } else {
+        for (size_t i = 0; i < rhsList.size(); i++) {
+            values.push_back(expr(rhsList[i], lvs[i].type));
+        }
+    }
+    for (size_t i = 0; i < lvs.size(); i++) {
+        assignTo(lvs[i], values[i]);
+    }
+}
+
+// opAssign lowers lhs op= rhs, or lhs++ and lhs-- if rhs is nil.
+void builder::opAssign(ast::ExprNode *e, syntax::Operator op, ast::ExprNode *rhs) {
+    auto lv = lhs(e, false);
+    Value *ptr = nullptr, *old;
+    switch (lv.kind) {
+    case lvalue::Var:
+        old = read(lv.var, _cur);
+        break;
+    case lvalue::MapElem:
+        ptr = runtime1("mapassign", _table.Pointer(lv.type), {lv.ptr, lv.key});
+        old = load(lv.type, ptr);
+        break;
+    default:
+        ptr = lv.ptr;
+        old = load(lv.type, ptr);
+        break;
+    }
+    Value *y;
+    if (rhs == nullptr) {
+        y = constValue(types::Value::MakeInt64(1), lv.type);
+    } else {
+        bool shift = op == Operator_Shl || op == Operator_Shr;
+        y = expr(rhs, shift ? TypeId(KindUint) : lv.type);
+    }
+    auto v = binary(op, old, y, lv.type);
+    if (lv.kind == lvalue::Var) {
+        write(lv.var, _cur, v);
+    } else {
+        store(ptr, v);
+    }
+}
+
+void builder::varDecl(ast::VarDecl *d) {
+    std::vector<Object *> objs;
+    for (auto &n : d->NameList) {
+        objs.push_back(n->Value == "_" ? nullptr : _check.ObjectOf(n.get()));
+    }
+    auto values = exprList(d->Values.get());
+    std::vector<Value *> vals;
+    if (values.size() == 1 && objs.size() > 1) {
+        vals = exprN(values[0]);
+    } else {
+        for (size_t i = 0; i < values.size(); i++) {
+            auto t = objs[i] != nullptr ? objs[i]->Type : 0;
+            vals.push_back(expr(values[i], t));
+        }
+    }
+    for (size_t i = 0; i < objs.size(); i++) {
+        if (objs[i] != nullptr) {
+            declare(objs[i], i < vals.size() ? convert(vals[i], objs[i]->Type) : nullptr);
+        }
+    }
+}
+
+void builder::ifStmt(ast::IfStmt *s) {
+    simpleStmt(s->Init.get());
+    reachable();
+    auto then = newBlock(), done = newBlock();
+    auto els = s->Else != nullptr ? newBlock() : done;
+    cond(s->Cond.get(), then, els);
+    seal(then);
+    _cur = then;
+    stmt(s->Then.get());
+    jump(done);
+    if (els != done) {
+        seal(els);
+        _cur = els;
+        stmt(s->Else.get());
+        jump(done);
+    }
+    seal(done);
+    _cur = done;
+}
+
+void builder::forStmt(ast::ForStmt *s, common::SymbolId label) {
+    if (auto r = dyn_cast_or_null<ast::RangeClause>(s->Init.get())) {
+        rangeStmt(s, r, label);
+        return;
+    }
+    simpleStmt(s->Init.get());
+    reachable();
+    auto header = newBlock(), body = newBlock(), post = newBlock(), done = newBlock();
+    jump(header);
+    _cur = header;
+    if (s->Cond != nullptr) {
+        cond(s->Cond.get(), body, done);
+    } else {
+        jump(body);
+    }
+    seal(body);
+    _cur = body;
+    _targets.push_back({label, done, post});
+    stmt(s->Body.get());
+    _targets.pop_back();
+    jump(post);
+    seal(post);
+    _cur = post;
+    simpleStmt(s->Post.get());
+    jump(header);
+    seal(header);
+    seal(done);
+    _cur = done;
+}
+
+void builder::rangeStmt(ast::ForStmt *s, ast::RangeClause *r, common::SymbolId label) {
+    auto xt = r->X->typ;
+    auto kind = kindOf(xt);
+    bool intRange = types::IsInteger(xt) || kind == KindUntypedInt || kind == KindUntypedRune;
+    if (isPointer(xt) && kindOf(elemOf(xt)) == KindArray) {
+        kind = KindArray;
+    }
+    auto lhsList = exprList(r->Lhs.get());
+    // the range expression is evaluated once, before the loop
+    Value *n, *s0 = nullptr, *base = nullptr;
+    TypeId elem = 0, keyType = KindInt;
+    if (intRange) {
+        keyType = types::IsUntyped(xt) ? TypeId(KindInt) : xt;
+        n = expr(r->X.get(), keyType);
+    } else if (kind == KindSlice) {
+        s0 = expr(r->X.get());
+        n = val(Op::SliceLen, KindInt, {s0});
+        elem = elemOf(xt);
+    } else {
+        auto at = isPointer(xt) ? elemOf(xt) : xt;
+        elem = under(at).Elem();
+        n = _f.ConstInt(KindInt, under(at).Len);
+        if (lhsList.size() > 1) {
+            base = isPointer(xt) ? expr(r->X.get()) : addr(r->X.get());
+        }
+    }
+    auto i = newVar(keyType);
+    write(i, _cur, constValue(types::Value::MakeInt64(0), keyType));
+    auto header = newBlock(), body = newBlock(), post = newBlock(), done = newBlock();
+    jump(header);
+    _cur = header;
+    auto iv = read(i, header);
+    branch(val(Op::Less, KindBool, {iv, n}), body, done);
+    seal(body);
+    _cur = body;
+    iv = read(i, body);
+    std::vector<Value *> values{iv};
+    if (lhsList.size() > 1) {
+        // the index is in range
+        if (s0 != nullptr) {
+            base = val(Op::SlicePtr, _table.Pointer(elem), {s0});
+        } else if (isPointer(xt)) {
+            nilCheck(base);
+        }
+        values.push_back(load(elem, val(Op::PtrIndex, _table.Pointer(elem), {base, iv})));
+    }
+    for (size_t k = 0; k < lhsList.size(); k++) {
+        assignTo(lhs(lhsList[k], r->Def), values[k]);
+    }
+    _targets.push_back({label, done, post});
+    stmt(s->Body.get());
+    _targets.pop_back();
+    jump(post);
+    seal(post);
+    _cur = post;
+    write(i, _cur, val(Op::Add, keyType, {read(i, post), constValue(types::Value::MakeInt64(1), keyType)}));
+    jump(header);
+    seal(header);
+    seal(done);
+    _cur = done;
+}
+
+void builder::switchStmt(ast::SwitchStmt *s, common::SymbolId label) {
+    simpleStmt(s->Init.get());
+    reachable();
+    Value *tag = s->Tag != nullptr ? expr(s->Tag.get()) : nullptr;
+    std::vector<Block *> bodies;
+    for (size_t i = 0; i < s->Body.size(); i++) {
+        bodies.push_back(newBlock());
+    }
+    auto done = newBlock();
+    Block *dflt = done;
+    for (size_t i = 0; i < s->Body.size(); i++) {
+        auto &c = s->Body[i];
+        if (c->Cases == nullptr) {
+            dflt = bodies[i];
+            continue;
+        }
+        for (auto e : exprList(c->Cases.get())) {
+            auto next = newBlock();
+            if (tag == nullptr) {
+                cond(e, bodies[i], next);
+            } else {
+                auto v = expr(e, tag->Type);
+                auto x = tag;
+                if (types::IsInterface(x->Type) != types::IsInterface(v->Type)) {
+                    if (types::IsInterface(x->Type)) {
+                        v = convert(v, x->Type);
+                    } else {
+                        x = convert(x, v->Type);
+                    }
+                }
+                branch(val(Op::Eq, KindBool, {x, v}), bodies[i], next);
+            }
+            seal(next);
+            _cur = next;
+        }
+    }
+    jump(dflt);
+    _targets.push_back({label, done, nullptr});
+    auto outer = _fallthrough;
+    for (size_t i = 0; i < s->Body.size(); i++) {
+        seal(bodies[i]);
+        _cur = bodies[i];
+        _fallthrough = i + 1 < bodies.size() ? bodies[i + 1] : nullptr;
+        stmts(s->Body[i]->Body);
+        jump(done);
+    }
+    _fallthrough = outer;
+    _targets.pop_back();
+    seal(done);
+    _cur = done;
+}
+
+void builder::branchStmt(ast::BranchStmt *s) {
+    if (s->Tok == Token_Fallthrough) {
+        jump(_fallthrough);
+        return;
+    }
+    bool brk = s->Tok == Token_Break;
+    for (auto t = _targets.rbegin(); t != _targets.rend(); ++t) {
+        if (s->Label != nullptr ? t->label == s->Label->Sym : (brk || t->cont != nullptr)) {
+            jump(brk ? t->brk : t->cont);
+            return;
+        }
+    }
+    panic("ssa: branch without target");
+}
+
+void builder::returnStmt(ast::ReturnStmt *s) {
+    auto results = exprList(s->Results.get());
+    std::vector<Value *> vals;
+    if (results.empty()) {
+        for (size_t i = 0; i < _results.size(); i++) {
+            vals.push_back(_results[i] != nullptr ? readVar(_results[i], _resultTypes[i]) : zero(_resultTypes[i]));
+        }
+    } else if (results.size() == 1 && _resultTypes.size() > 1) {
+        vals = exprN(results[0]);
+    } else {
+        for (size_t i = 0; i < results.size(); i++) {
+            vals.push_back(expr(results[i], _resultTypes[i]));
+        }
+    }
+    for (size_t i = 0; i < vals.size(); i++) {
+        vals[i] = convert(vals[i], _resultTypes[i]);
+    }
+    ret(std::move(vals));
+}
+
+void builder::ret(std::vector<Value *> results) {
+    results.push_back(mem());
+    auto r = val(Op::MakeResult, 0, results);
+    _cur->Kind = BlockKind::Ret;
+    _cur->SetControl(r);
+    _cur = nullptr;
+}
+
+std::string builder::build(ast::FuncDecl *decl) {
+    auto sig = decl->Type->typ;
+    _f.Reset(FuncName(decl), sig);
+    if (decl->Body == nullptr) {
+        return "function without body";
+    }
+    markAddrTaken(decl->Body.get());
+    if (auto why = unsupported(decl); !why.empty()) {
+        return why;
+    }
+    _pos = decl->GetPos();
+    _vars.push_back(TypeMem);
+    _cur = newBlock();
+    seal(_cur);
+    _initMem = val(Op::InitMem, TypeMem);
+    setMem(_initMem);
+
+    // the parameters, the receiver first
+    std::vector<std::pair<ast::Field *, TypeId>> params;
+    if (decl->Recv != nullptr) {
+        auto rt = unparen(decl->Recv->Type.get());
+        bool ptr = false;
+        if (auto op = dyn_cast<ast::Operation>(rt); op && op->Op == Operator_Mul && op->Y == nullptr) {
+            rt = unparen(op->X.get());
+            ptr = true;
+        }
+        auto tn = _check.ObjectOf(cast<ast::Name>(rt));
+        params.emplace_back(decl->Recv.get(), ptr ? _table.Pointer(tn->Type) : tn->Type);
+    }
+    auto &s = under(sig);
+    for (size_t i = 0; i < decl->Type->ParamList.size(); i++) {
+        params.emplace_back(decl->Type->ParamList[i].get(), s.Params()[i]);
+    }
+    for (size_t i = 0; i < params.size(); i++) {
+        auto [field, t] = params[i];
+        auto v = val(Op::Arg, t);
+        v->AuxInt = int64_t(i);
+        auto p = field->Name != nullptr && field->Name->Value != "_" ? _check.ObjectOf(field->Name.get()) : nullptr;
+        if (p != nullptr) {
+            v->Sym = p;
+            declare(p, v);
+        }
+    }
+    for (size_t i = 0; i < decl->Type->ResultList.size(); i++) {
+        auto field = decl->Type->ResultList[i].get();
+        auto t = s.Results()[i];
+        auto r = field->Name != nullptr && field->Name->Value != "_" ? _check.ObjectOf(field->Name.get()) : nullptr;
+        if (r != nullptr) {
+            declare(r, _addrTaken.contains(r) || !ssaable(t) ? nullptr : zero(t));
+        }
+        _results.push_back(r);
+        _resultTypes.push_back(t);
+    }
+
+    stmts(decl->Body->List);
+    if (_cur != nullptr) {
+        _pos = decl->Body->Rbrace;
+        std::vector<Value *> vals;
+        for (size_t i = 0; i < _results.size(); i++) {
+            vals.push_back(_results[i] != nullptr ? readVar(_results[i], _resultTypes[i]) : zero(_resultTypes[i]));
+        }
+        ret(std::move(vals));
+    }
+
+    // drop the unreachable code, then the Phis found to be trivial once
+    // the code that kept them alive is gone, and the copies of both
+    _f.RemoveUnreachable();
+    CopyElim(_f);
+    return "";
+}
+
+} // namespace
+
+bool Build(Func &f, const types::Checker &check, ast::FuncDecl *decl, std::string *reason,
+           const compile::EscapeAnalysis *escape, const compile::Devirtualizer *devirt) {
+    auto why = builder(f, check, escape, devirt).build(decl);
+    if (why.empty()) {
+        return true;
+    }
+    if (reason != nullptr) {
+        *reason = std::move(why);
+    }
+    return false;
+}
+
+std::string FuncName(const ast::FuncDecl *decl) {
+    if (decl->Recv == nullptr) {
+        return std::string(decl->Name->Value);
+    }
+    auto t = decl->Recv->Type.get();
+    while (auto p = dyn_cast<ast::ParenExpr>(t)) {
+        t = p->X.get();
+    }
+    std::string star;
+    if (auto op = dyn_cast<ast::Operation>(t); op && op->Op == Operator_Mul && op->Y == nullptr) {
+        t = op->X.get();
+        star = "*";
+    }
+    if (auto x = dyn_cast<ast::IndexExpr>(t)) {
+        t = x->X.get();
+    }
+    auto base = dyn_cast<ast::Name>(t);
+    auto name = base != nullptr ? std::string(base->Value) : ast::String(t);
+    return star.empty() ? fmt::format("{}.{}", name, decl->Name->Value)
+                        : fmt::format("(*{}).{}", name, decl->Name->Value);
+}
+
+} // namespace ssa
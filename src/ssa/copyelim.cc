@@ -0,0 +1,61 @@
+#include "ssa/pass.hh"
+
+namespace ssa {
+
+namespace {
+
+Value *resolve(Value *v) {
+    while (v->Op == Op::Copy) {
+        v = v->Args[0];
+    }
+    return v;
+}
+
+} // namespace
+
+void CopyElim(Func &f) {
+    // a Phi whose arguments are itself and a single other value is that
+    // value; turning it into a copy may make the Phis using it trivial
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto b : f.Blocks()) {
+            for (auto v : b->Values) {
+                if (v->Op != Op::Phi) {
+                    continue;
+                }
+                Value *same = nullptr;
+                bool trivial = true;
+                for (auto a : v->Args) {
+                    a = resolve(a);
+                    if (a == v || a == same) {
+                        continue;
+                    }
+                    if (same != nullptr) {
+                        trivial = false;
+                        break;
+                    }
+                    same = a;
+                }
+                if (trivial && same != nullptr) {
+                    v->CopyOf(same);
+                    changed = true;
+                }
+            }
+        }
+    }
+    for (auto b : f.Blocks()) {
+        for (auto v : b->Values) {
+            for (size_t i = 0; i < v->Args.size(); i++) {
+                if (auto a = resolve(v->Args[i]); a != v->Args[i]) {
+                    v->SetArg(i, a);
+                }
+            }
+        }
+        if (b->Control != nullptr && b->Control->Op == Op::Copy) {
+            b->SetControl(resolve(b->Control));
+        }
+    }
+    f.Sweep(Op::Copy);
+}
+
+} // namespace ssa
@@ -0,0 +1,188 @@
+#include "ssa/pass.hh"
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+
+#include "ssa/dom.hh"
+
+namespace ssa {
+
+namespace {
+
+// candidate reports whether v may be equivalent to another value: it has a
+// result other than memory, and evaluating it twice yields the same.
+bool candidate(const Value *v) {
+    if (v->Type == 0 || v->IsMem() || v->Op == Op::Copy) {
+        return false;
+    }
+    return (v->Info().Flags & (NoCSE | Call)) == 0;
+}
+
+// before orders the values by their operation and aux, the way the
+// initial partition groups them. Phis are only equivalent within a block.
+bool before(const Value *v, const Value *w) {
+    if (v->Op != w->Op) {
+        return v->Op < w->Op;
+    }
+    if (v->Type != w->Type) {
+        return v->Type < w->Type;
+    }
+    if (v->AuxInt != w->AuxInt) {
+        return v->AuxInt < w->AuxInt;
+    }
+    if (v->Args.size() != w->Args.size()) {
+        return v->Args.size() < w->Args.size();
+    }
+    if (v->Op == Op::Phi && v->Blk != w->Blk) {
+        return v->Blk->Id < w->Blk->Id;
+    }
+    if (v->Sym != w->Sym) {
+        return std::less<>()(v->Sym, w->Sym);
+    }
+    return v->Str < w->Str;
+}
+
+bool same(const Value *v, const Value *w) { return !before(v, w) && !before(w, v); }
+
+} // namespace
+
+void CSE(Func &f) {
+    std::vector<Value *> values;
+    for (auto b : f.Blocks()) {
+        for (auto v : b->Values) {
+            if (candidate(v)) {
+                values.push_back(v);
+            }
+        }
+    }
+
+    // partition the values by operation, then refine the partition by the
+    // classes of the operands until it is stable. The values outside the
+    // partition are each in a class of their own, and so are those left
+    // alone in their class, which are dropped from the refinement as they
+    // cannot be split further.
+    std::vector<uint32_t> cls(f.NumValues());
+    for (ID i = 0; i < cls.size(); i++) {
+        cls[i] = i;
+    }
+    auto classes = uint32_t(cls.size());
+    // split numbers the runs of values equal by eq with new classes, drops
+    // the values alone in theirs and returns the number of runs
+    auto split = [&](auto eq) {
+        size_t n = 0, runs = 0;
+        for (size_t i = 0, j; i < values.size(); i = j) {
+            for (j = i + 1; j < values.size() && eq(values[j - 1], values[j]);) {
+                j++;
+            }
+            runs++;
+            classes++;
+            for (size_t k = i; k < j; k++) {
+                cls[values[k]->Id] = classes;
+                if (j - i > 1) {
+                    values[n++] = values[k];
+                }
+            }
+        }
+        values.resize(n);
+        return runs;
+    };
+    std::sort(values.begin(), values.end(), before);
+    split(same);
+    // the classes of a value and its operands before the step, the pair
+    // of a commutative operation in order; values of a class have as many
+    // operands
+    std::vector<uint32_t> old;
+    auto compare = [&](const Value *v, const Value *w) {
+        if (old[v->Id] != old[w->Id]) {
+            return old[v->Id] < old[w->Id] ? -1 : 1;
+        }
+        if ((v->Info().Flags & Commutative) != 0) {
+            auto x0 = old[v->Args[0]->Id], x1 = old[v->Args[1]->Id];
+            auto y0 = old[w->Args[0]->Id], y1 = old[w->Args[1]->Id];
+            auto x = x0 < x1 ? uint64_t(x0) << 32 | x1 : uint64_t(x1) << 32 | x0;
+            auto y = y0 < y1 ? uint64_t(y0) << 32 | y1 : uint64_t(y1) << 32 | y0;
+            return x != y ? (x < y ? -1 : 1) : 0;
+        }
+        for (size_t i = 0; i < v->Args.size(); i++) {
+            if (auto x = old[v->Args[i]->Id], y = old[w->Args[i]->Id]; x != y) {
+                return x < y ? -1 : 1;
+            }
+        }
+        return 0;
+    };
+    while (!values.empty()) {
+        old = cls;
+        std::sort(values.begin(), values.end(), [&](const Value *v, const Value *w) { return compare(v, w) < 0; });
+        size_t runs = 1;
+        for (size_t i = 1; i < values.size(); i++) {
+            runs += old[values[i - 1]->Id] != old[values[i]->Id];
+        }
+        if (split([&](const Value *v, const Value *w) { return compare(v, w) == 0; }) == runs) {
+            break;
+        }
+    }
+    if (values.empty()) {
+        return;
+    }
+    DomTree dom(f);
+    std::erase_if(values, [&](const Value *v) { return !dom.Reachable(v->Blk); });
+
+    // in each class, a value replaces the later ones it dominates: walking
+    // the class in dominator tree preorder, the values that are kept form
+    // a chain of dominators of the current one
+    std::vector<uint32_t> pre(f.NumBlocks()), pos(f.NumValues());
+    for (uint32_t i = 0; auto b : dom.Preorder()) {
+        pre[b->Id] = i++;
+        for (uint32_t j = 0; auto v : b->Values) {
+            pos[v->Id] = j++;
+        }
+    }
+    std::sort(values.begin(), values.end(), [&](const Value *v, const Value *w) {
+        return std::tuple(cls[v->Id], pre[v->Blk->Id], pos[v->Id]) <
+               std::tuple(cls[w->Id], pre[w->Blk->Id], pos[w->Id]);
+    });
+    std::vector<Value *> rep(f.NumValues()), chain;
+    bool changed = false;
+    for (size_t i = 0; i < values.size(); i++) {
+        auto v = values[i];
+        if (i == 0 || cls[values[i - 1]->Id] != cls[v->Id]) {
+            chain.clear();
+        }
+        while (!chain.empty() && !dom.Dominates(chain.back()->Blk, v->Blk)) {
+            chain.pop_back();
+        }
+        if (chain.empty()) {
+            chain.push_back(v);
+        } else {
+            rep[v->Id] = chain.back();
+            changed = true;
+        }
+    }
+    if (!changed) {
+        return;
+    }
+    for (auto b : f.Blocks()) {
+        for (auto v : b->Values) {
+            for (size_t i = 0; i < v->Args.size(); i++) {
+                if (auto r = rep[v->Args[i]->Id]) {
+                    v->SetArg(i, r);
+                }
+            }
+        }
+        if (b->Control != nullptr) {
+            if (auto r = rep[b->Control->Id]) {
+                b->SetControl(r);
+            }
+        }
+    }
+    // the values replaced become copies, which Deadcode removes even where
+    // the value may panic: the value replacing it would have panicked first
+    for (auto v : values) {
+        if (auto r = rep[v->Id]) {
+            v->CopyOf(r);
+        }
+    }
+}
+
+} // namespace ssa
@@ -0,0 +1,52 @@
+#include "ssa/pass.hh"
+
+namespace ssa {
+
+void Deadcode(Func &f) {
+    f.RemoveUnreachable();
+    BitSet live(f.NumValues());
+    std::vector<Value *> work;
+    auto mark = [&](Value *v) {
+        if (live.Insert(v->Id)) {
+            work.push_back(v);
+        }
+    };
+    for (auto b : f.Blocks()) {
+        if (b->Control != nullptr) {
+            mark(b->Control);
+        }
+        for (auto v : b->Values) {
+            if ((v->Info().Flags & MemResult) != 0 || v->MayPanic()) {
+                mark(v);
+            }
+        }
+    }
+    while (!work.empty()) {
+        auto v = work.back();
+        work.pop_back();
+        for (auto a : v->Args) {
+            mark(a);
+        }
+    }
+
+    // drop the operands of all the dead values first, as they may refer to
+    // each other across blocks
+    for (auto b : f.Blocks()) {
+        for (auto v : b->Values) {
+            if (!live.Has(v->Id)) {
+                v->ResetArgs();
+            }
+        }
+    }
+    for (auto b : f.Blocks()) {
+        size_t n = 0;
+        for (auto v : b->Values) {
+            if (live.Has(v->Id)) {
+                b->Values[n++] = v;
+            }
+        }
+        b->Values.truncate(n);
+    }
+}
+
+} // namespace ssa
@@ -0,0 +1,104 @@
+#include "ssa/dom.hh"
+
+namespace ssa {
+
+DomTree::DomTree(const Func &f) {
+    auto n = f.NumBlocks();
+    _rpoIndex.assign(n, unreachable);
+    _idom.assign(n, nullptr);
+    _pre.assign(n, 0);
+    _post.assign(n, 0);
+    auto entry = f.Entry();
+
+    // number the blocks in postorder with an explicit stack of (block,
+    // next successor) pairs
+    std::vector<Block *> post;
+    std::vector<std::pair<Block *, uint32_t>> stack{{entry, 0}};
+    _rpoIndex[entry->Id] = 0;
+    while (!stack.empty()) {
+        auto &[b, i] = stack.back();
+        if (i < b->Succs.size()) {
+            auto s = b->Succs[i++];
+            if (_rpoIndex[s->Id] == unreachable) {
+                _rpoIndex[s->Id] = 0;
+                stack.emplace_back(s, 0);
+            }
+            continue;
+        }
+        post.push_back(b);
+        stack.pop_back();
+    }
+    _rpo.assign(post.rbegin(), post.rend());
+    for (uint32_t i = 0; i < _rpo.size(); i++) {
+        _rpoIndex[_rpo[i]->Id] = i;
+    }
+
+    auto intersect = [&](Block *a, Block *b) {
+        while (a != b) {
+            while (_rpoIndex[a->Id] > _rpoIndex[b->Id]) {
+                a = _idom[a->Id];
+            }
+            while (_rpoIndex[b->Id] > _rpoIndex[a->Id]) {
+                b = _idom[b->Id];
+            }
+        }
+        return a;
+    };
+    _idom[entry->Id] = entry;
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = 1; i < _rpo.size(); i++) {
+            auto b = _rpo[i];
+            Block *idom = nullptr;
+            for (auto p : b->Preds) {
+                if (_idom[p->Id] == nullptr) {
+                    continue; // not processed yet, or unreachable
+                }
+                idom = idom == nullptr ? p : intersect(p, idom);
+            }
+            if (_idom[b->Id] != idom) {
+                _idom[b->Id] = idom;
+                changed = true;
+            }
+        }
+    }
+    _idom[entry->Id] = nullptr;
+
+    // the children of each block, in reverse postorder, then the preorder
+    // and postorder numbers of the tree
+    _childStart.assign(n + 1, 0);
+    for (auto b : _rpo) {
+        if (auto d = _idom[b->Id]) {
+            _childStart[d->Id + 1]++;
+        }
+    }
+    for (ID i = 0; i < n; i++) {
+        _childStart[i + 1] += _childStart[i];
+    }
+    _children.resize(_childStart[n]);
+    std::vector<uint32_t> next(_childStart.begin(), _childStart.end() - 1);
+    for (auto b : _rpo) {
+        if (auto d = _idom[b->Id]) {
+            _children[next[d->Id]++] = b;
+        }
+    }
+    uint32_t clock = 0;
+    std::vector<std::pair<Block *, uint32_t>> walk{{entry, 0}};
+    _pre[entry->Id] = clock++;
+    _preorder.push_back(entry);
+    while (!walk.empty()) {
+        auto &[b, i] = walk.back();
+        auto children = Children(b);
+        if (i < children.size()) {
+            auto c = children[i++];
+            _pre[c->Id] = clock++;
+            _preorder.push_back(c);
+            walk.emplace_back(c, 0);
+            continue;
+        }
+        _post[b->Id] = clock++;
+        walk.pop_back();
+    }
+}
+
+} // namespace ssa
@@ -0,0 +1,488 @@
+#include "ssa/func.hh"
+
+#include <fmt/format.h>
+
+#include <bit>
+#include <cstring>
+
+#include "common/interner.hh"
+#include "ssa/dom.hh"
+#include "syntax/types/check.hh"
+
+namespace ssa {
+
+namespace {
+
+std::string typeString(TypeId t) {
+    if (t == TypeMem) {
+        return "mem";
+    }
+    return t == 0 ? "void" : types::TypeTable::Global().String(t);
+}
+
+std::string quote(std::string_view s) {
+    std::string out = "\"";
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += char(c);
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c < 0x20 || c == 0x7f) {
+            out += fmt::format("\\x{:02x}", c);
+        } else {
+            out += char(c);
+        }
+    }
+    return out + "\"";
+}
+
+} // namespace
+
+size_t BitSet::Count() const {
+    size_t n = 0;
+    for (auto w : _words) {
+        n += size_t(std::popcount(w));
+    }
+    return n;
+}
+
+// ----------------------------------------------------------------------------
+// Values
+
+void Value::AddArg(Value *w) {
+    Args.push_back(Blk->Fn->Mem(), w);
+    w->Uses++;
+}
+
+void Value::SetArg(size_t i, Value *w) {
+    Args[i]->Uses--;
+    Args[i] = w;
+    w->Uses++;
+}
+
+void Value::ResetArgs() {
+    for (auto a : Args) {
+        a->Uses--;
+    }
+    Args.clear();
+}
+
+void Value::Reset(ssa::Op op) {
+    ResetArgs();
+    Op = op;
+    AuxInt = 0;
+    Sym = nullptr;
+    Str = {};
+}
+
+void Value::CopyOf(Value *w) {
+    w->Uses++; // w may be an operand of the value
+    Reset(ssa::Op::Copy);
+    Args.push_back(Blk->Fn->Mem(), w);
+    Type = w->Type;
+}
+
+bool Value::MayPanic() const {
+    switch (Op) {
+    case ssa::Op::Div:
+    case ssa::Op::Mod:
+        return Args[1]->Op != ssa::Op::ConstInt || Args[1]->AuxInt == 0;
+    case ssa::Op::Shl:
+    case ssa::Op::Shr:
+        if (Args[1]->Op == ssa::Op::ConstInt) {
+            return Args[1]->AuxInt < 0 && !types::IsUnsigned(Args[1]->Type);
+        }
+        return !types::IsUnsigned(Args[1]->Type);
+    default:
+        return (Info().Flags & CanPanic) != 0;
+    }
+}
+
+std::string Value::LongString() const {
+    auto s = fmt::format("v{} = {} <{}>", Id, Info().Name, typeString(Type));
+    switch (Info().Aux) {
+    case AuxKind::Int:
+        s += fmt::format(" [{}]", AuxInt);
+        break;
+    case AuxKind::Bool:
+        s += AuxInt != 0 ? " [true]" : " [false]";
+        break;
+    case AuxKind::Float:
+        s += fmt::format(" [{}]", std::bit_cast<double>(AuxInt));
+        break;
+    case AuxKind::None:
+        break;
+    }
+    if (Sym != nullptr) {
+        s += fmt::format(" {{{}}}", common::Interner::Global().Name(Sym->Name));
+    }
+    if (Op == ssa::Op::ConstString) {
+        s += " {" + quote(Str) + "}";
+    } else if (Op == ssa::Op::StaticData) {
+        s += fmt::format(" {{{} bytes}}", Str.size());
+    } else if (!Str.empty()) {
+        s += fmt::format(" {{{}}}", Str);
+    }
+    for (auto a : Args) {
+        s += fmt::format(" v{}", a->Id);
+    }
+    return s;
+}
+
+// ----------------------------------------------------------------------------
+// Blocks
+
+std::string_view BlockKindName(BlockKind kind) {
+    switch (kind) {
+    case BlockKind::Plain:
+        return "Plain";
+    case BlockKind::If:
+        return "If";
+    case BlockKind::Ret:
+        return "Ret";
+    case BlockKind::Exit:
+        return "Exit";
+    case BlockKind::Invalid:
+        break;
+    }
+    return "Invalid";
+}
+
+void Block::SetControl(Value *v) {
+    if (Control != nullptr) {
+        Control->Uses--;
+    }
+    Control = v;
+    if (v != nullptr) {
+        v->Uses++;
+    }
+}
+
+void Block::AddEdgeTo(Block *c) {
+    Succs.push_back(Fn->Mem(), c);
+    c->Preds.push_back(Fn->Mem(), this);
+}
+
+// The k-th edge from b to c is the k-th occurrence of c in b.Succs and of
+// b in c.Preds, as edges are added and removed on both sides at once.
+void Block::RemoveEdge(size_t i) {
+    auto c = Succs[i];
+    size_t k = 0;
+    for (size_t j = 0; j < i; j++) {
+        k += Succs[j] == c;
+    }
+    Succs.erase(i);
+    for (size_t j = 0; j < c->Preds.size(); j++) {
+        if (c->Preds[j] == this && k-- == 0) {
+            c->RemovePred(j);
+            return;
+        }
+    }
+}
+
+void Block::RemovePred(size_t i) {
+    Preds.erase(i);
+    for (auto v : Values) {
+        if (v->Op == Op::Phi) {
+            v->Args[i]->Uses--;
+            v->Args.erase(i);
+        }
+    }
+}
+
+std::string Block::LongString() const {
+    auto s = fmt::format("b{}:", Id);
+    if (!Preds.empty()) {
+        s += " <-";
+        for (auto p : Preds) {
+            s += fmt::format(" b{}", p->Id);
+        }
+    }
+    return s;
+}
+
+// ----------------------------------------------------------------------------
+// Functions
+
+void Func::Reset(std::string_view name, TypeId sig) {
+    _arena.Reset();
+    _blocks.clear();
+    _next_block = _next_value = 0;
+    _reports.clear();
+    _pinned.clear();
+    _name = Intern(name);
+    _sig = sig;
+}
+
+Block *Func::NewBlock(BlockKind kind, syntax::Pos pos) {
+    auto b = _arena.New<Block>();
+    b->Id = _next_block++;
+    b->Kind = kind;
+    b->Pos = pos;
+    b->Fn = this;
+    _blocks.push_back(b);
+    return b;
+}
+
+Value *Func::NewValue(Block *b, ssa::Op op, TypeId t, std::initializer_list<Value *> args, syntax::Pos pos) {
+    return NewValue(b, op, t, std::span<Value *const>(args.begin(), args.size()), pos);
+}
+
+Value *Func::NewValue(Block *b, ssa::Op op, TypeId t, std::span<Value *const> args, syntax::Pos pos) {
+    auto v = _arena.New<Value>();
+    v->Id = _next_value++;
+    v->Op = op;
+    v->Type = t;
+    v->Blk = b;
+    v->Pos = pos;
+    for (auto a : args) {
+        v->AddArg(a);
+    }
+    b->Values.push_back(_arena, v);
+    return v;
+}
+
+Value *Func::NewPhi(Block *b, TypeId t, syntax::Pos pos) {
+    auto v = NewValue(b, Op::Phi, t, {}, pos);
+    b->Values.truncate(b->Values.size() - 1);
+    b->Values.insert(_arena, 0, v);
+    return v;
+}
+
+Value *Func::ConstInt(TypeId t, int64_t c) {
+    auto v = NewValue(Entry(), Op::ConstInt, t);
+    v->AuxInt = c;
+    return v;
+}
+
+Value *Func::ConstBool(bool c) {
+    auto v = NewValue(Entry(), Op::ConstBool, KindBool);
+    v->AuxInt = c;
+    return v;
+}
+
+Value *Func::ConstNil(TypeId t) { return NewValue(Entry(), Op::ConstNil, t); }
+
+std::string_view Func::Intern(std::string_view s) {
+    if (s.empty()) {
+        return {};
+    }
+    auto p = static_cast<char *>(_arena.Allocate(s.size(), 1));
+    std::memcpy(p, s.data(), s.size());
+    return {p, s.size()};
+}
+
+std::string_view Func::Pin(std::shared_ptr<const void> owner, std::string_view data) {
+    _pinned.push_back(std::move(owner));
+    return data;
+}
+
+void Func::RemoveUnreachable() {
+    BitSet reachable(NumBlocks());
+    std::vector<Block *> stack{Entry()};
+    reachable.Add(Entry()->Id);
+    while (!stack.empty()) {
+        auto b = stack.back();
+        stack.pop_back();
+        for (auto s : b->Succs) {
+            if (reachable.Insert(s->Id)) {
+                stack.push_back(s);
+            }
+        }
+    }
+    size_t n = 0;
+    for (auto b : _blocks) {
+        if (!reachable.Has(b->Id)) {
+            // drop the uses of the dead values, so that the counts of the
+            // values they refer to stay exact
+            for (auto v : b->Values) {
+                v->ResetArgs();
+            }
+            b->SetControl(nullptr);
+            continue;
+        }
+        for (size_t i = b->Preds.size(); i-- > 0;) {
+            if (!reachable.Has(b->Preds[i]->Id)) {
+                b->RemovePred(i);
+            }
+        }
+        _blocks[n++] = b;
+    }
+    _blocks.resize(n);
+}
+
+void Func::Sweep(ssa::Op op) {
+    for (auto b : _blocks) {
+        size_t n = 0;
+        for (auto v : b->Values) {
+            if (v->Op == op) {
+                v->ResetArgs();
+            } else {
+                b->Values[n++] = v;
+            }
+        }
+        b->Values.truncate(n);
+    }
+}
+
+std::string Func::String() const {
+    auto s = fmt::format("{} {}\n", _name, typeString(_sig));
+    for (auto b : _blocks) {
+        s += b->LongString() + "\n";
+        for (auto v : b->Values) {
+            s += "  " + v->LongString() + "\n";
+        }
+        s += fmt::format("  {}", BlockKindName(b->Kind));
+        if (b->Control != nullptr) {
+            s += fmt::format(" v{}", b->Control->Id);
+        }
+        if (!b->Succs.empty()) {
+            s += " ->";
+            for (auto c : b->Succs) {
+                s += fmt::format(" b{}", c->Id);
+            }
+        }
+        s += "\n";
+    }
+    return s;
+}
+
+std::string Func::Verify() const {
+    if (_blocks.empty()) {
+        return "no entry block";
+    }
+    BitSet blocks(NumBlocks()), values(NumValues());
+    for (auto b : _blocks) {
+        if (b->Fn != this || b->Id >= NumBlocks() || !blocks.Insert(b->Id)) {
+            return fmt::format("b{}: foreign or duplicate block", b->Id);
+        }
+        for (auto v : b->Values) {
+            if (v->Blk != b || v->Id >= NumValues() || !values.Insert(v->Id)) {
+                return fmt::format("b{}: v{}: foreign or duplicate value", b->Id, v->Id);
+            }
+        }
+    }
+    if (!Entry()->Preds.empty()) {
+        return fmt::format("b{}: entry block has predecessors", Entry()->Id);
+    }
+    std::vector<uint32_t> uses(NumValues());
+    for (auto b : _blocks) {
+        size_t succs = 0;
+        switch (b->Kind) {
+        case BlockKind::Plain:
+            succs = 1;
+            break;
+        case BlockKind::If:
+            succs = 2;
+            if (b->Control == nullptr || types::TypeTable::Global().Underlying(b->Control->Type) != KindBool) {
+                return fmt::format("b{}: If needs a bool control value", b->Id);
+            }
+            break;
+        case BlockKind::Ret:
+            if (b->Control == nullptr || b->Control->Op != Op::MakeResult) {
+                return fmt::format("b{}: Ret needs a MakeResult control value", b->Id);
+            }
+            break;
+        case BlockKind::Exit:
+            if (b->Control == nullptr || !b->Control->IsMem()) {
+                return fmt::format("b{}: Exit needs a memory control value", b->Id);
+            }
+            break;
+        case BlockKind::Invalid:
+            return fmt::format("b{}: invalid kind", b->Id);
+        }
+        if (b->Succs.size() != succs) {
+            return fmt::format("b{}: {} has {} successors", b->Id, BlockKindName(b->Kind), b->Succs.size());
+        }
+        if (b->Kind == BlockKind::Plain && b->Control != nullptr) {
+            return fmt::format("b{}: Plain with a control value", b->Id);
+        }
+        if (b->Control != nullptr) {
+            if (!values.Has(b->Control->Id) || b->Control->Blk->Fn != this) {
+                return fmt::format("b{}: control value v{} is not in the function", b->Id, b->Control->Id);
+            }
+            uses[b->Control->Id]++;
+        }
+        // each edge is on both sides, as often
+        for (auto c : b->Succs) {
+            if (!blocks.Has(c->Id)) {
+                return fmt::format("b{}: successor b{} is not in the function", b->Id, c->Id);
+            }
+            size_t out = 0, in = 0;
+            for (auto x : b->Succs) {
+                out += x == c;
+            }
+            for (auto p : c->Preds) {
+                in += p == b;
+            }
+            if (in != out) {
+                return fmt::format("b{}: edge to b{} is missing its predecessor", b->Id, c->Id);
+            }
+        }
+        for (auto p : b->Preds) {
+            if (!blocks.Has(p->Id)) {
+                return fmt::format("b{}: predecessor b{} is not in the function", b->Id, p->Id);
+            }
+            bool found = false;
+            for (auto x : p->Succs) {
+                found |= x == b;
+            }
+            if (!found) {
+                return fmt::format("b{}: edge from b{} is missing its successor", b->Id, p->Id);
+            }
+        }
+        for (auto v : b->Values) {
+            auto &info = v->Info();
+            if (info.Arity >= 0 && v->Args.size() != size_t(info.Arity)) {
+                return fmt::format("b{}: {}: want {} arguments", b->Id, v->LongString(), info.Arity);
+            }
+            if (v->Op == Op::Phi && v->Args.size() != b->Preds.size()) {
+                return fmt::format("b{}: {}: want an argument per predecessor", b->Id, v->LongString());
+            }
+            if ((info.Flags & MemArg) != 0 && (v->Args.empty() || !v->Mem()->IsMem())) {
+                return fmt::format("b{}: {}: last argument is not memory", b->Id, v->LongString());
+            }
+            if ((info.Flags & MemResult) != 0 && !v->IsMem()) {
+                return fmt::format("b{}: {}: result is not memory", b->Id, v->LongString());
+            }
+            for (auto a : v->Args) {
+                if (a == nullptr || !values.Has(a->Id) || a->Blk->Fn != this) {
+                    return fmt::format("b{}: {}: argument is not in the function", b->Id, v->LongString());
+                }
+                uses[a->Id]++;
+            }
+        }
+    }
+    for (auto b : _blocks) {
+        for (auto v : b->Values) {
+            if (v->Uses != uses[v->Id]) {
+                return fmt::format("b{}: {}: has {} uses, counted {}", b->Id, v->LongString(), v->Uses,
+                                   uses[v->Id]);
+            }
+        }
+    }
+    // each definition dominates its uses: those in its own block follow
+    // it, and the argument of a Phi for an edge dominates the edge
+    DomTree dom(*this);
+    BitSet defined(NumValues());
+    for (auto b : dom.ReversePostorder()) {
+        for (auto v : b->Values) {
+            for (size_t i = 0; i < v->Args.size(); i++) {
+                auto a = v->Args[i];
+                bool ok = v->Op == Op::Phi ? dom.Dominates(a->Blk, b->Preds[i])
+                                           : (a->Blk == b ? defined.Has(a->Id) : dom.Dominates(a->Blk, b));
+                if (!ok) {
+                    return fmt::format("b{}: {}: v{} does not dominate its use", b->Id, v->LongString(), a->Id);
+                }
+            }
+            defined.Add(v->Id);
+        }
+        if (b->Control != nullptr && !dom.Dominates(b->Control->Blk, b)) {
+            return fmt::format("b{}: control value v{} does not dominate its use", b->Id, b->Control->Id);
+        }
+    }
+    return "";
+}
+
+} // namespace ssa
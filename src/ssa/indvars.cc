@@ -0,0 +1,195 @@
+#include "ssa/pass.hh"
+
+#include <fmt/format.h>
+
+#include <limits>
+
+#include "ssa/loop.hh"
+#include "syntax/types/check.hh"
+
+namespace ssa {
+
+namespace {
+
+using types::TypeTable;
+
+bool integer(TypeId t) {
+    if (t == 0 || t == TypeMem) {
+        return false;
+    }
+    auto k = TypeTable::Global().Underlying(t);
+    return k >= KindInt && k <= KindUintptr;
+}
+
+// maxOf returns the largest value of the integer type t, if its values
+// compare as 64-bit signed integers: it is not an unsigned 64-bit type.
+bool maxOf(TypeId t, int64_t *max) {
+    auto bits = types::Sizeof(t) * 8;
+    if (types::IsUnsigned(t)) {
+        if (bits >= 64) {
+            return false;
+        }
+        *max = (int64_t(1) << bits) - 1;
+    } else {
+        *max = bits >= 64 ? std::numeric_limits<int64_t>::max() : (int64_t(1) << (bits - 1)) - 1;
+    }
+    return true;
+}
+
+bool isLen(const Value *v) { return v->Op == Op::SliceLen || v->Op == Op::SliceCap || v->Op == Op::StringLen; }
+
+// canonicalTest rewrites the exit test c of a loop to compare strictly
+// with an upper bound and not strictly with a lower one, the forms of
+// 0 <= i < n that Prove recognizes: i <= len(s)-1 becomes i < len(s), i
+// <= c becomes i < c+1 and c < i becomes c+1 <= i.
+void canonicalTest(Func &f, Value *c) {
+    if ((c->Op != Op::Less && c->Op != Op::Leq) || !integer(c->Args[0]->Type)) {
+        return;
+    }
+    auto x = c->Args[0], y = c->Args[1];
+    int64_t max = 0;
+    if (!maxOf(x->Type, &max)) {
+        return;
+    }
+    if (c->Op == Op::Leq && y->Op == Op::Sub && isLen(y->Args[0]) && y->Args[1]->Op == Op::ConstInt &&
+        y->Args[1]->AuxInt == 1) {
+        // a length less 1 does not wrap
+        c->Reset(Op::Less);
+        c->AddArg(x);
+        c->AddArg(y->Args[0]);
+    } else if (c->Op == Op::Leq && y->Op == Op::ConstInt && y->AuxInt < max) {
+        c->Reset(Op::Less);
+        c->AddArg(x);
+        c->AddArg(f.ConstInt(y->Type, y->AuxInt + 1));
+    } else if (c->Op == Op::Less && x->Op == Op::ConstInt && x->AuxInt < max) {
+        c->Reset(Op::Leq);
+        c->AddArg(f.ConstInt(x->Type, x->AuxInt + 1));
+        c->AddArg(y);
+    }
+}
+
+// stepOf returns the constant next adds to or subtracts from phi, with its
+// operands in the order phi, constant, or nil if next does not step phi.
+Value *stepOf(Value *phi, Value *next) {
+    if (next->Op == Op::Add && next->Args[1] == phi && next->Args[0]->Op == Op::ConstInt) {
+        auto c = next->Args[0];
+        next->SetArg(0, phi);
+        next->SetArg(1, c);
+    }
+    if ((next->Op == Op::Add || next->Op == Op::Sub) && next->Args[0] == phi && next->Args[1]->Op == Op::ConstInt) {
+        return next->Args[1];
+    }
+    return nullptr;
+}
+
+// factorOf returns the factor v multiplies phi by, if it is invariant in
+// l: v is phi * k, k * phi, or phi << c for a constant c whose power of 2
+// is a value of the type.
+Value *factorOf(Func &f, const LoopNest &nest, const Loop *l, Value *phi, Value *v) {
+    if (v->Type != phi->Type) {
+        return nullptr;
+    }
+    if (v->Op == Op::Mul) {
+        auto k = v->Args[0] == phi ? v->Args[1] : v->Args[1] == phi ? v->Args[0] : nullptr;
+        return k != nullptr && nest.Invariant(l, k) ? k : nullptr;
+    }
+    int64_t max = 0;
+    if (v->Op == Op::Shl && v->Args[0] == phi && v->Args[1]->Op == Op::ConstInt && maxOf(v->Type, &max)) {
+        auto c = v->Args[1]->AuxInt;
+        if (c >= 0 && c < 62 && (int64_t(1) << c) <= max) {
+            return f.ConstInt(v->Type, int64_t(1) << c);
+        }
+    }
+    return nullptr;
+}
+
+// reduce replaces the products of the induction variable phi of l by
+// invariant factors with induction variables of their own, stepped by the
+// product of the step and the factor: (i+s)*k is i*k + s*k, wrapping the
+// same way.
+void reduce(Func &f, const LoopNest &nest, const Loop *l, Value *phi, size_t back, Value *step) {
+    auto h = l->Header;
+    auto entry = l->Entry(), latch = h->Preds[back];
+    auto next = phi->Args[back];
+    std::vector<std::pair<Value *, Value *>> reduced; // by factor
+    for (auto b : l->Blocks) {
+        for (size_t i = 0; i < b->Values.size(); i++) {
+            auto v = b->Values[i];
+            auto k = factorOf(f, nest, l, phi, v);
+            if (k == nullptr) {
+                continue;
+            }
+            Value *j = nullptr;
+            for (auto [factor, iv] : reduced) {
+                auto same = factor->Op == Op::ConstInt && k->Op == Op::ConstInt && factor->AuxInt == k->AuxInt;
+                if (factor == k || same) {
+                    j = iv;
+                }
+            }
+            if (j == nullptr) {
+                // i*k on entry, and s*k folded if it is a constant of the
+                // type
+                auto t = phi->Type;
+                auto start = phi->Args[1 - back];
+                Value *init = nullptr;
+                if (start->Op == Op::ConstInt && start->AuxInt == 0) {
+                    init = start;
+                } else {
+                    init = f.NewValue(entry, Op::Mul, t, {start, k}, v->Pos);
+                }
+                int64_t max = 0, s = 0;
+                Value *by = nullptr;
+                if (step->AuxInt == 1) {
+                    by = k;
+                } else if (k->Op == Op::ConstInt && maxOf(t, &max) &&
+                           !__builtin_mul_overflow(step->AuxInt, k->AuxInt, &s) && s <= max &&
+                           s >= (types::IsUnsigned(t) ? 0 : -max - 1)) {
+                    by = f.ConstInt(t, s);
+                } else {
+                    by = f.NewValue(entry, Op::Mul, t, {step, k}, v->Pos);
+                }
+                j = f.NewPhi(h, t, v->Pos);
+                auto jnext = f.NewValue(latch, next->Op, t, {j, by}, v->Pos);
+                for (size_t p = 0; p < h->Preds.size(); p++) {
+                    j->AddArg(p == back ? jnext : init);
+                }
+                reduced.emplace_back(k, j);
+            }
+            if (f.Debug()) {
+                f.Warnl(v->Pos, fmt::format("reduced {} of induction variable", v->Info().Name));
+            }
+            v->CopyOf(j);
+        }
+    }
+}
+
+} // namespace
+
+void IndVars(Func &f) {
+    DomTree dom(f);
+    LoopNest nest(f, dom);
+    for (auto l : nest.Loops()) {
+        auto h = l->Header;
+        if (h->Kind == BlockKind::If) {
+            canonicalTest(f, h->Control);
+        }
+        if (h->Preds.size() != 2 || l->Latches.size() != 1 || l->Entry() == nullptr) {
+            continue;
+        }
+        size_t back = h->Preds[0] == l->Latches[0] ? 0 : 1;
+        // the Phis, but not those reduce adds
+        std::vector<Value *> phis;
+        for (auto v : h->Values) {
+            if (v->Op == Op::Phi && integer(v->Type)) {
+                phis.push_back(v);
+            }
+        }
+        for (auto phi : phis) {
+            if (auto step = stepOf(phi, phi->Args[back])) {
+                reduce(f, nest, l, phi, back, step);
+            }
+        }
+    }
+}
+
+} // namespace ssa
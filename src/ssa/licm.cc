@@ -0,0 +1,198 @@
+#include "ssa/pass.hh"
+
+#include <fmt/format.h>
+
+#include "ssa/loop.hh"
+
+namespace ssa {
+
+namespace {
+
+// redirect replaces b by c as a successor of a, and a by c as a
+// predecessor of b, keeping the index of the edge on both sides and so the
+// arguments of the Phis of b.
+void redirect(Block *a, Block *b, Block *c) {
+    for (auto &s : a->Succs) {
+        if (s == b) {
+            s = c;
+            break;
+        }
+    }
+    for (auto &p : b->Preds) {
+        if (p == a) {
+            p = c;
+            break;
+        }
+    }
+}
+
+// preheader returns a block that only enters l, splitting the edge from
+// its entry if that branches elsewhere too, or nil if l has several
+// entries.
+Block *preheader(Func &f, const Loop *l) {
+    auto entry = l->Entry();
+    if (entry == nullptr || entry->Succs.size() == 1) {
+        return entry;
+    }
+    auto h = l->Header;
+    auto b = f.NewBlock(BlockKind::Plain, h->Pos);
+    redirect(entry, h, b);
+    b->Preds.push_back(f.Mem(), entry);
+    b->Succs.push_back(f.Mem(), h);
+    return b;
+}
+
+class licm {
+public:
+    licm(Func &f, const DomTree &dom, const LoopNest &nest) : _f(f), _dom(dom), _nest(nest), _mark(f.NumBlocks()) {}
+
+    void hoist(const Loop *l, Block *pre);
+
+private:
+    bool invariant(const Loop *l, const Value *v) const;
+    bool always(const Loop *l, const Value *v);
+
+    Func &_f;
+    const DomTree &_dom;
+    const LoopNest &_nest;
+    BitSet _mark;
+    std::vector<Block *> _stack;
+};
+
+// invariant reports whether v may be computed before l: its operands are
+// defined outside l, and it is a pure computation or a load, or a nil
+// check, which do not change memory and may be executed again.
+bool licm::invariant(const Loop *l, const Value *v) const {
+    if (v->Op == Op::Phi || v->Op == Op::Copy || (v->Info().Flags & (MemResult | NoCSE | Call)) != 0) {
+        return false;
+    }
+    for (auto a : v->Args) {
+        if (!_nest.Invariant(l, a)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// always reports whether the loop does v each time it is entered, before
+// anything else that could be seen: the block of v dominates the exits
+// and the back edges of l, and the blocks from the header to it, in l and
+// not in a nested loop that may not terminate, do not change memory or
+// panic. Evaluating v before the loop then panics where the loop would
+// have, as Go requires.
+bool licm::always(const Loop *l, const Value *v) {
+    auto b = v->Blk;
+    if (_nest.Of(b) != l) {
+        return false;
+    }
+    for (auto e : l->Exits) {
+        if (!_dom.Dominates(b, e)) {
+            return false;
+        }
+    }
+    for (auto latch : l->Latches) {
+        if (!_dom.Dominates(b, latch)) {
+            return false;
+        }
+    }
+    _mark.Reset(_f.NumBlocks());
+    _mark.Add(b->Id);
+    _stack.assign(1, b);
+    while (!_stack.empty()) {
+        auto c = _stack.back();
+        _stack.pop_back();
+        if (_nest.Of(c) != l) {
+            return false;
+        }
+        for (auto w : c->Values) {
+            if (w != v && ((w->Info().Flags & MemResult) != 0 || w->MayPanic())) {
+                return false;
+            }
+        }
+        if (c == l->Header) {
+            continue;
+        }
+        for (auto p : c->Preds) {
+            if (_mark.Insert(p->Id)) {
+                _stack.push_back(p);
+            }
+        }
+    }
+    return true;
+}
+
+// hoist moves the values of l that are invariant to pre, until no more
+// are: the operands of one may be those moved before it. A value that may
+// fault, by panicking or loading through a pointer that may not be valid
+// where the loop is not entered, is moved only if the loop always does it
+// first.
+void licm::hoist(const Loop *l, Block *pre) {
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (auto b : l->Blocks) {
+            for (size_t i = 0; i < b->Values.size();) {
+                auto v = b->Values[i];
+                if (!invariant(l, v) || ((v->MayPanic() || v->Op == Op::Load) && !always(l, v))) {
+                    i++;
+                    continue;
+                }
+                b->Values.erase(i);
+                pre->Values.push_back(_f.Mem(), v);
+                v->Blk = pre;
+                changed = true;
+                if (_f.Debug()) {
+                    _f.Warnl(v->Pos, fmt::format("hoisted {} out of loop", v->Info().Name));
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+void LICM(Func &f) {
+    // give the loops preheaders first, as splitting edges changes the
+    // loops; those left empty are removed at the end
+    std::vector<std::pair<Block *, Block *>> split; // the preheader made, and the entry
+    {
+        DomTree dom(f);
+        LoopNest nest(f, dom);
+        if (nest.Loops().empty()) {
+            return;
+        }
+        for (auto l : nest.Loops()) {
+            auto entry = l->Entry();
+            if (auto pre = preheader(f, l); pre != nullptr && pre != entry) {
+                split.emplace_back(pre, entry);
+            }
+        }
+    }
+    DomTree dom(f);
+    LoopNest nest(f, dom);
+    licm m(f, dom, nest);
+    // the nested loops first, so that what is moved out of one may be
+    // moved out of the loop containing it too
+    auto loops = nest.Loops();
+    for (auto it = loops.rbegin(); it != loops.rend(); it++) {
+        auto l = *it;
+        if (auto pre = l->Entry(); pre != nullptr && pre->Succs.size() == 1) {
+            m.hoist(l, pre);
+        }
+    }
+    bool removed = false;
+    for (auto [pre, entry] : split) {
+        if (pre->Values.empty()) {
+            // the entry branches to the header again, and the preheader is
+            // left unreachable
+            auto h = pre->Succs[0];
+            redirect(entry, pre, h);
+            redirect(pre, h, entry);
+            removed = true;
+        }
+    }
+    if (removed) {
+        f.RemoveUnreachable();
+    }
+}
+
+} // namespace ssa
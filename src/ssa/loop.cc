@@ -0,0 +1,91 @@
+#include "ssa/loop.hh"
+
+#include <algorithm>
+
+namespace ssa {
+
+Block *Loop::Entry() const {
+    Block *entry = nullptr;
+    for (auto p : Header->Preds) {
+        if (std::find(Latches.begin(), Latches.end(), p) != Latches.end()) {
+            continue;
+        }
+        if (entry != nullptr) {
+            return nullptr;
+        }
+        entry = p;
+    }
+    return entry;
+}
+
+LoopNest::LoopNest(const Func &f, const DomTree &dom) : _of(f.NumBlocks()) {
+    auto rpo = dom.ReversePostorder();
+    size_t headers = 0;
+    for (auto b : rpo) {
+        headers += std::any_of(b->Preds.begin(), b->Preds.end(), [&](Block *p) { return dom.Dominates(b, p); });
+    }
+    // the loops by header in reverse postorder, so that a loop is found
+    // after those containing it: the blocks of each are marked as in it,
+    // and then again as in the loops nested in it
+    _loops.reserve(headers);
+    std::vector<Block *> stack;
+    for (auto h : rpo) {
+        Loop *l = nullptr;
+        for (auto p : h->Preds) {
+            if (!dom.Dominates(h, p)) {
+                continue;
+            }
+            if (l == nullptr) {
+                l = &_loops.emplace_back();
+                l->Header = h;
+            }
+            if (std::find(l->Latches.begin(), l->Latches.end(), p) == l->Latches.end()) {
+                l->Latches.push_back(p);
+            }
+        }
+        if (l == nullptr) {
+            continue;
+        }
+        if (auto outer = _of[h->Id]) {
+            l->Outer = outer;
+            l->Depth = outer->Depth + 1;
+            outer->Inner = false;
+        }
+        _of[h->Id] = l;
+        l->Blocks.push_back(h);
+        stack.assign(l->Latches.begin(), l->Latches.end());
+        while (!stack.empty()) {
+            auto b = stack.back();
+            stack.pop_back();
+            if (_of[b->Id] == l) {
+                continue;
+            }
+            _of[b->Id] = l;
+            l->Blocks.push_back(b);
+            for (auto p : b->Preds) {
+                if (dom.Reachable(p) && _of[p->Id] != l) {
+                    stack.push_back(p);
+                }
+            }
+        }
+        _order.push_back(l);
+    }
+    for (auto &l : _loops) {
+        for (auto b : l.Blocks) {
+            if (std::any_of(b->Succs.begin(), b->Succs.end(), [&](Block *s) { return !Contains(&l, s); })) {
+                l.Exits.push_back(b);
+            }
+        }
+    }
+}
+
+bool LoopNest::Contains(const Loop *l, const Block *b) const {
+    for (auto m = Of(b); m != nullptr; m = m->Outer) {
+        if (m == l) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace ssa
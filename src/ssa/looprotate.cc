@@ -0,0 +1,247 @@
+#include "ssa/pass.hh"
+
+#include "ssa/loop.hh"
+
+namespace ssa {
+
+namespace {
+
+// rotator turns a loop that tests its condition in its header before the
+// body into one that tests it at the bottom, after the body:
+//
+//     entry: ...                        entry: ...; If cond(init) -> body exit
+//     header: phis; If cond -> body exit
+//     body: ...; -> latch                body: phis of the header values
+//     latch: ...; -> header              latch: ...; -> header
+//                                        header: If cond(next) -> body exit
+//
+// The header keeps its values, computed from the values of the back edge
+// only, and becomes the test at the bottom; the entry tests a copy of them
+// computed from the values on entry, and the body is the new header. The
+// values of the header are used in the body through Phis of the two, and
+// after the loop through Phis of the exit. The loop then runs its body at
+// least once whenever its entry branches to it, which lets LICM hoist what
+// the body always does.
+class rotator {
+public:
+    rotator(Func &f, const DomTree &dom, const LoopNest &nest) : _f(f), _dom(dom), _nest(nest) {}
+
+    bool rotate(const Loop *l);
+
+private:
+    // use is the i-th operand of a value, or the control of a block if v
+    // is nil
+    struct use {
+        Value *V;
+        Block *B;
+        size_t I;
+    };
+
+    bool uses();
+    Value *clone(Value *v);
+
+    Func &_f;
+    const DomTree &_dom;
+    const LoopNest &_nest;
+    Block *_h = nullptr, *_entry = nullptr, *_body = nullptr, *_exit = nullptr;
+    size_t _in = 0; // the index of the entry among the predecessors of the header
+    std::vector<use> _body_uses, _exit_uses;
+    std::vector<Value *> _clone;
+};
+
+// uses finds the uses of the values of the header outside it, and
+// reports whether each is in the body or after the exit.
+bool rotator::uses() {
+    _body_uses.clear();
+    _exit_uses.clear();
+    auto add = [&](Value *w, Block *at, use u) {
+        if (w->Blk != _h || at == _h) {
+            return true;
+        }
+        if (_dom.Dominates(_body, at)) {
+            _body_uses.push_back(u);
+        } else if (_dom.Dominates(_exit, at)) {
+            _exit_uses.push_back(u);
+        } else {
+            return false;
+        }
+        return true;
+    };
+    for (auto b : _dom.ReversePostorder()) {
+        for (auto v : b->Values) {
+            for (size_t i = 0; i < v->Args.size(); i++) {
+                // the operand of a Phi is used at the end of the predecessor
+                if (!add(v->Args[i], v->Op == Op::Phi ? b->Preds[i] : b, {v, b, i})) {
+                    return false;
+                }
+            }
+        }
+        if (b->Control != nullptr && !add(b->Control, b, {nullptr, b, 0})) {
+            return false;
+        }
+    }
+    // the Phis of the exit take the values of the header for the edges
+    // from the loop, through the Phis of the body, and from the blocks
+    // after the exit in a loop of their own
+    if (!_exit_uses.empty()) {
+        for (auto p : _exit->Preds) {
+            if (p != _h && !_dom.Dominates(_body, p) && !_dom.Dominates(_exit, p)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// clone returns the value v has on entry: its copy computed in the entry
+// for a value of the header, the argument for the entry of a Phi of the
+// header, and v itself otherwise.
+Value *rotator::clone(Value *v) {
+    if (v->Blk != _h) {
+        return v;
+    }
+    if (auto c = _clone[v->Id]) {
+        return c;
+    }
+    if (v->Op == Op::Phi) {
+        return _clone[v->Id] = v->Args[_in];
+    }
+    auto c = _f.NewValue(_entry, v->Op, v->Type, {}, v->Pos);
+    c->AuxInt = v->AuxInt;
+    c->Sym = v->Sym;
+    c->Str = v->Str;
+    for (auto a : v->Args) {
+        c->AddArg(clone(a));
+    }
+    return _clone[v->Id] = c;
+}
+
+bool rotator::rotate(const Loop *l) {
+    _h = l->Header;
+    _entry = l->Entry();
+    if (_h->Kind != BlockKind::If || _h->Preds.size() != 2 || l->Latches.size() != 1 || _entry == nullptr ||
+        _entry->Succs.size() != 1 || l->Latches[0] == _h) {
+        return false;
+    }
+    auto in0 = _nest.Contains(l, _h->Succs[0]), in1 = _nest.Contains(l, _h->Succs[1]);
+    if (in0 == in1) {
+        return false;
+    }
+    _body = in0 ? _h->Succs[0] : _h->Succs[1];
+    _exit = in0 ? _h->Succs[1] : _h->Succs[0];
+    if (_body->Preds.size() != 1) {
+        return false;
+    }
+    // the header values are computed again on entry; they must be free of
+    // effects other than panics, which happen where they did
+    for (auto v : _h->Values) {
+        if ((v->Info().Flags & (MemResult | NoCSE | Call)) != 0) {
+            return false;
+        }
+    }
+    if (!uses()) {
+        return false;
+    }
+    _in = _h->Preds[0] == _entry ? 0 : 1;
+
+    // the test on entry, and the values of the header for the entry edge,
+    // taken before the edge goes; the Phis of the successors take them for
+    // their new edge
+    _clone.assign(_f.NumValues(), nullptr);
+    std::vector<Value *> values(_h->Values.begin(), _h->Values.end());
+    for (auto v : values) {
+        clone(v);
+    }
+    auto cond = clone(_h->Control);
+    auto succs = std::array{_h->Succs[0], _h->Succs[1]};
+    for (auto s : succs) {
+        for (auto v : s->Values) {
+            if (v->Op != Op::Phi) {
+                continue;
+            }
+            for (size_t i = 0; i < s->Preds.size(); i++) {
+                if (s->Preds[i] == _h) {
+                    v->AddArg(clone(v->Args[i]));
+                    break;
+                }
+            }
+        }
+    }
+    _entry->RemoveEdge(0);
+    // the Phis of the header lost their operand for the entry, and those
+    // after it moved down
+    for (auto uses : {&_body_uses, &_exit_uses}) {
+        for (auto &u : *uses) {
+            if (u.V != nullptr && u.V->Op == Op::Phi && u.B == _h && u.I > _in) {
+                u.I--;
+            }
+        }
+    }
+    _entry->Kind = BlockKind::If;
+    _entry->SetControl(cond);
+    for (auto s : succs) {
+        _entry->AddEdgeTo(s);
+    }
+
+    // the Phis of the body and the exit for the values of the header used
+    // there
+    std::vector<Value *> inBody(_f.NumValues()), inExit(_f.NumValues());
+    auto bodyPhi = [&](Value *w) {
+        auto &phi = inBody[w->Id];
+        if (phi == nullptr) {
+            phi = _f.NewPhi(_body, w->Type, w->Pos);
+            for (auto p : _body->Preds) {
+                phi->AddArg(p == _h ? w : clone(w));
+            }
+        }
+        return phi;
+    };
+    auto exitPhi = [&](Value *w) {
+        auto &phi = inExit[w->Id];
+        if (phi == nullptr) {
+            phi = _f.NewPhi(_exit, w->Type, w->Pos);
+            for (auto p : _exit->Preds) {
+                phi->AddArg(p == _h ? w : p == _entry ? clone(w) : _dom.Dominates(_body, p) ? bodyPhi(w) : phi);
+            }
+        }
+        return phi;
+    };
+    auto rewrite = [&](const use &u, Value *w) {
+        if (u.V == nullptr) {
+            u.B->SetControl(w);
+        } else {
+            u.V->SetArg(u.I, w);
+        }
+    };
+    for (auto &u : _exit_uses) {
+        rewrite(u, exitPhi(u.V == nullptr ? u.B->Control : u.V->Args[u.I]));
+    }
+    for (auto &u : _body_uses) {
+        rewrite(u, bodyPhi(u.V == nullptr ? u.B->Control : u.V->Args[u.I]));
+    }
+    if (_f.Debug()) {
+        _f.Warnl(_h->Control->Pos, "rotated loop");
+    }
+    return true;
+}
+
+} // namespace
+
+void LoopRotate(Func &f) {
+    // rotating a loop changes the dominator tree, so the loops are found
+    // again after each
+    for (bool changed = true; changed;) {
+        changed = false;
+        DomTree dom(f);
+        LoopNest nest(f, dom);
+        rotator r(f, dom, nest);
+        for (auto l : nest.Loops()) {
+            if (r.rotate(l)) {
+                changed = true;
+                break;
+            }
+        }
+    }
+}
+
+} // namespace ssa
@@ -0,0 +1,22 @@
+#include "ssa/op.hh"
+
+#include <iterator>
+
+namespace ssa {
+
+namespace {
+
+constexpr OpInfo infos[] = {
+#define SSA_OP_INFO(name, arity, flags, aux) {#name, arity, flags, AuxKind::aux},
+    SSA_OPS(SSA_OP_INFO)
+#undef SSA_OP_INFO
+};
+
+} // namespace
+
+const OpInfo &Info(Op op) {
+    static_assert(std::size(infos) == size_t(Op::MakeResult) + 1);
+    return infos[size_t(op)];
+}
+
+} // namespace ssa
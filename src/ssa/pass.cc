@@ -0,0 +1,132 @@
+#include "ssa/pass.hh"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace ssa {
+
+namespace {
+
+constexpr Pass passes[] = {
+    {"copyelim", CopyElim},
+    {"cse", CSE},
+    {"deadcode", Deadcode},
+    {"indvars", IndVars},
+    {"licm", LICM},
+    {"looprotate", LoopRotate},
+    {"prove", Prove},
+    {"sccp", SCCP},
+};
+
+const Pass *lookup(std::string_view name) {
+    for (auto &p : passes) {
+        if (p.Name == name) {
+            return &p;
+        }
+    }
+    return nullptr;
+}
+
+size_t countValues(const Func &f) {
+    size_t n = 0;
+    for (auto b : f.Blocks()) {
+        n += b->Values.size();
+    }
+    return n;
+}
+
+// parse looks up the passes of a comma-separated list of names.
+std::string parse(std::string_view names, std::vector<const Pass *> &out) {
+    while (!names.empty()) {
+        auto comma = names.find(',');
+        auto name = names.substr(0, comma);
+        names = comma == std::string_view::npos ? std::string_view() : names.substr(comma + 1);
+        auto p = lookup(name);
+        if (p == nullptr) {
+            return fmt::format("unknown pass \"{}\"", name);
+        }
+        out.push_back(p);
+    }
+    return "";
+}
+
+} // namespace
+
+std::span<const Pass> Passes() { return passes; }
+
+PassManager::PassManager() { SetPipeline(DefaultPipeline); }
+
+std::string PassManager::SetPipeline(std::string_view names) {
+    std::vector<const Pass *> pipeline;
+    if (auto err = parse(names, pipeline); !err.empty()) {
+        return err;
+    }
+    _steps.clear();
+    for (auto p : pipeline) {
+        _steps.push_back({p});
+    }
+    return "";
+}
+
+std::string PassManager::SetDebug(std::string_view names) {
+    std::vector<const Pass *> debug;
+    if (auto err = parse(names, debug); !err.empty()) {
+        return err;
+    }
+    _debug = std::move(debug);
+    return "";
+}
+
+std::string PassManager::Pipeline() const {
+    std::string s;
+    for (auto &step : _steps) {
+        s += (s.empty() ? "" : ",") + std::string(step.Pass->Name);
+    }
+    return s;
+}
+
+std::string PassManager::Run(Func &f) {
+    auto values = countValues(f);
+    for (auto &step : _steps) {
+        f.SetDebug(std::find(_debug.begin(), _debug.end(), step.Pass) != _debug.end());
+        auto start = std::chrono::steady_clock::now();
+        step.Pass->Run(f);
+        step.Nanos += uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - start)
+                                   .count());
+        step.Runs++;
+        f.SetDebug(false);
+        auto after = countValues(f);
+        step.Removed += int64_t(values) - int64_t(after);
+        values = after;
+        if (_verify) {
+            if (auto err = f.Verify(); !err.empty()) {
+                return fmt::format("after {}: {}", step.Pass->Name, err);
+            }
+        }
+    }
+    return "";
+}
+
+void PassManager::Merge(const PassManager &other) {
+    for (size_t i = 0; i < _steps.size() && i < other._steps.size(); i++) {
+        _steps[i].Nanos += other._steps[i].Nanos;
+        _steps[i].Runs += other._steps[i].Runs;
+        _steps[i].Removed += other._steps[i].Removed;
+    }
+}
+
+std::string PassManager::Report() const {
+    auto s = fmt::format("{:<10} {:>12} {:>8} {:>10}\n", "pass", "time", "runs", "removed");
+    uint64_t total = 0;
+    for (auto &step : _steps) {
+        s += fmt::format("{:<10} {:>10.3f}ms {:>8} {:>10}\n", step.Pass->Name, double(step.Nanos) / 1e6, step.Runs,
+                         step.Removed);
+        total += step.Nanos;
+    }
+    return s + fmt::format("{:<10} {:>10.3f}ms\n", "total", double(total) / 1e6);
+}
+
+} // namespace ssa
@@ -0,0 +1,555 @@
+#include "ssa/pass.hh"
+
+#include <fmt/format.h>
+
+#include <limits>
+
+#include "ssa/dom.hh"
+#include "syntax/types/check.hh"
+
+namespace ssa {
+
+namespace {
+
+using types::TypeTable;
+
+constexpr int64_t minInt = std::numeric_limits<int64_t>::min();
+constexpr int64_t maxInt = std::numeric_limits<int64_t>::max();
+
+// maxLen bounds the lengths of slices and strings: no allocation exceeds
+// the address space of the targets, which is 48 bits.
+constexpr int64_t maxLen = int64_t(1) << 48;
+
+// limit is the range of the values a value may have, as 64-bit signed
+// integers.
+struct limit {
+    int64_t min = minInt;
+    int64_t max = maxInt;
+};
+
+bool integer(TypeId t) {
+    if (t == 0 || t == TypeMem) {
+        return false;
+    }
+    auto k = TypeTable::Global().Underlying(t);
+    return k >= KindInt && k <= KindUintptr;
+}
+
+// ordered reports whether the values of type t compare as their 64-bit
+// signed forms do: those of signed types, and of unsigned types narrower
+// than 64 bits, which are zero-extended.
+bool ordered(TypeId t) { return integer(t) && (!types::IsUnsigned(t) || types::Sizeof(t) < 8); }
+
+// typeRange returns the values of type t.
+limit typeRange(TypeId t) {
+    auto bits = types::Sizeof(t) * 8;
+    if (bits >= 64) {
+        return {};
+    }
+    if (types::IsUnsigned(t)) {
+        return {0, (int64_t(1) << bits) - 1};
+    }
+    return {-(int64_t(1) << (bits - 1)), (int64_t(1) << (bits - 1)) - 1};
+}
+
+bool isConst(const Value *v, int64_t *c) {
+    if (v->Op != Op::ConstInt) {
+        return false;
+    }
+    *c = v->AuxInt;
+    return true;
+}
+
+// prover walks the dominator tree and keeps the facts known on entry to
+// the current block: the limits of values, the orderings between values
+// and the pointers known not to be nil. The facts of a block hold in the
+// blocks it dominates, and are undone when the walk leaves it.
+class prover {
+public:
+    explicit prover(Func &f) : _f(f), _dom(f) {}
+
+    void run();
+
+private:
+    // fact is v < To, or v <= To if not Strict, for the value v it is kept
+    // for.
+    struct fact {
+        Value *To;
+        bool Strict;
+    };
+    struct undo {
+        enum Kind : uint8_t { Limit, Fact, NonNil } K;
+        ID Id;
+        limit Old;
+    };
+
+    void initLimits(const BitSet *keep);
+    limit initLimit(Value *v) const;
+    void inductionVars(BitSet &ivs);
+    void setLimit(Value *v, limit l);
+    void addFact(Value *x, Value *y, bool strict);
+    void addBranch(Value *c, bool taken);
+    void setNonNil(Value *p);
+    bool nonNil(const Value *p) const;
+    bool less(Value *x, Value *y, bool strict);
+    int decide(Value *c);
+    void enter(Block *b);
+    void leave(size_t mark);
+
+    Func &_f;
+    DomTree _dom;
+    std::vector<limit> _limits;
+    std::vector<std::vector<fact>> _facts;
+    BitSet _nonNil;
+    std::vector<undo> _undo;
+    // the search of less
+    std::vector<std::pair<Value *, bool>> _work;
+    BitSet _seen;
+    // the edges found never taken, by block and successor, the blocks they
+    // lead to, and the nil checks found redundant
+    std::vector<std::pair<Block *, size_t>> _deadEdges;
+    BitSet _deadBlocks;
+    std::vector<Value *> _nilChecks;
+};
+
+limit prover::initLimit(Value *v) const {
+    auto t = v->Type;
+    auto r = typeRange(t);
+    auto of = [&](const Value *a) { return _limits[a->Id]; };
+    auto intersect = [&](limit l) { return limit{std::max(l.min, r.min), std::min(l.max, r.max)}; };
+    int64_t c = 0;
+    switch (v->Op) {
+    case Op::ConstInt:
+        return {v->AuxInt, v->AuxInt};
+    case Op::SliceLen:
+    case Op::SliceCap:
+    case Op::StringLen:
+        return {0, maxLen};
+    case Op::And:
+        if (isConst(v->Args[0], &c) || isConst(v->Args[1], &c)) {
+            if (c >= 0) {
+                return intersect({0, c});
+            }
+        }
+        break;
+    case Op::Mod:
+        if (isConst(v->Args[1], &c) && c > 0 && (of(v->Args[0]).min >= 0 || types::IsUnsigned(t))) {
+            return intersect({0, c - 1});
+        }
+        break;
+    case Op::Shr:
+        if (isConst(v->Args[1], &c) && c >= 0 && c < 64 && of(v->Args[0]).min >= 0) {
+            return {0, of(v->Args[0]).max >> c};
+        }
+        break;
+    case Op::Add:
+    case Op::Sub: {
+        auto x = of(v->Args[0]), y = of(v->Args[1]);
+        limit l;
+        bool overflow = v->Op == Op::Add ? __builtin_add_overflow(x.min, y.min, &l.min) ||
+                                               __builtin_add_overflow(x.max, y.max, &l.max)
+                                         : __builtin_sub_overflow(x.min, y.max, &l.min) ||
+                                               __builtin_sub_overflow(x.max, y.min, &l.max);
+        if (!overflow && l.min >= r.min && l.max <= r.max) {
+            return l;
+        }
+        break;
+    }
+    case Op::Convert: {
+        // a conversion keeps the value if the type holds all the values of
+        // the operand
+        if (integer(v->Args[0]->Type)) {
+            auto x = of(v->Args[0]);
+            if (x.min >= r.min && x.max <= r.max) {
+                return x;
+            }
+        }
+        break;
+    }
+    case Op::Phi: {
+        // the limits of the arguments of back edges are not known yet
+        limit l{maxInt, minInt};
+        for (size_t i = 0; i < v->Args.size(); i++) {
+            if (_dom.Dominates(v->Blk, v->Blk->Preds[i])) {
+                return r;
+            }
+            l = {std::min(l.min, of(v->Args[i]).min), std::max(l.max, of(v->Args[i]).max)};
+        }
+        return v->Args.empty() ? r : intersect(l);
+    }
+    default:
+        break;
+    }
+    return r;
+}
+
+// initLimits computes the limits of the values from those of their
+// operands, but for the values of keep.
+void prover::initLimits(const BitSet *keep) {
+    _limits.resize(_f.NumValues());
+    for (auto b : _dom.ReversePostorder()) {
+        for (auto v : b->Values) {
+            if (integer(v->Type) && (keep == nullptr || !keep->Has(v->Id))) {
+                _limits[v->Id] = initLimit(v);
+            }
+        }
+    }
+}
+
+// inductionVars finds the Phis of loop headers that step by a constant
+// from an initial value while a test on the header keeps them, or them
+// plus a constant, below or above a bound, and limits them to the values
+// between: an increment only happens after the test, so it cannot
+// overflow past the bound. The Phis are added to ivs.
+void prover::inductionVars(BitSet &ivs) {
+    for (auto h : _dom.ReversePostorder()) {
+        if (h->Kind != BlockKind::If || h->Preds.size() != 2) {
+            continue;
+        }
+        auto body = h->Succs[0];
+        if (body == h->Succs[1] || body->Preds.size() != 1) {
+            continue;
+        }
+        for (auto phi : h->Values) {
+            if (phi->Op != Op::Phi || !ordered(phi->Type)) {
+                continue;
+            }
+            // the entry edge and the back edge, taken from within the body
+            size_t back = _dom.Dominates(h, h->Preds[0]) ? 0 : 1;
+            if (_dom.Dominates(h, h->Preds[1 - back]) || !_dom.Dominates(body, h->Preds[back])) {
+                continue;
+            }
+            auto init = phi->Args[1 - back], next = phi->Args[back];
+            int64_t step = 0;
+            bool stepped = next->Op == Op::Add && ((next->Args[0] == phi && isConst(next->Args[1], &step)) ||
+                                                   (next->Args[1] == phi && isConst(next->Args[0], &step)));
+            if (!stepped && next->Op == Op::Sub && next->Args[0] == phi && isConst(next->Args[1], &step) &&
+                step != minInt) {
+                step = -step;
+                stepped = true;
+            }
+            auto test = h->Control;
+            if (!stepped || step == 0 || (test->Op != Op::Less && test->Op != Op::Leq)) {
+                continue;
+            }
+            auto strict = test->Op == Op::Less;
+            auto r = typeRange(phi->Type), i = _limits[init->Id];
+            // the test may be on phi + c, as in i+1 < len(s)
+            int64_t c = 0;
+            auto x = test->Args[0];
+            auto below = x == phi || (x->Op == Op::Add && x->Args[0] == phi && isConst(x->Args[1], &c) && c > 0);
+            if (step > 0 && below) {
+                // phi + c < n, or phi + c <= n, before each step; phi + c
+                // does not overflow either
+                auto n = _limits[test->Args[1]->Id];
+                int64_t last = 0, top = 0;
+                if (__builtin_sub_overflow(n.max, int64_t(strict) + c, &last) ||
+                    __builtin_add_overflow(last, step, &last) || __builtin_add_overflow(last, c, &top) ||
+                    top > r.max || i.max > r.max - c) {
+                    continue;
+                }
+                setLimit(phi, {i.min, std::max(i.max, last)});
+                ivs.Add(phi->Id);
+                addFact(init, phi, false);
+            } else if (step < 0 && test->Args[1] == phi) {
+                // n < phi, or n <= phi, before each step
+                auto n = _limits[test->Args[0]->Id];
+                int64_t last = 0;
+                if (__builtin_add_overflow(n.min, int64_t(strict), &last) ||
+                    __builtin_add_overflow(last, step, &last) || last < r.min) {
+                    continue;
+                }
+                setLimit(phi, {std::min(i.min, last), i.max});
+                ivs.Add(phi->Id);
+                addFact(phi, init, false);
+            }
+        }
+    }
+}
+
+void prover::setLimit(Value *v, limit l) {
+    auto &old = _limits[v->Id];
+    _undo.push_back({undo::Limit, v->Id, old});
+    old = l;
+}
+
+// addFact records x < y, or x <= y if not strict, and narrows the limits
+// of x and y to those it allows.
+void prover::addFact(Value *x, Value *y, bool strict) {
+    if (!ordered(x->Type) || !ordered(y->Type)) {
+        return;
+    }
+    _facts[x->Id].push_back({y, strict});
+    _undo.push_back({undo::Fact, x->Id, {}});
+    auto lx = _limits[x->Id], ly = _limits[y->Id];
+    if (ly.max != minInt && ly.max - strict < lx.max) {
+        setLimit(x, {lx.min, ly.max - strict});
+    }
+    if (lx.min != maxInt && lx.min + strict > ly.min) {
+        setLimit(y, {lx.min + strict, ly.max});
+    }
+    // a + c <= y, for c > 0 and no overflow, gives a < y too
+    int64_t c = 0;
+    if (x->Op == Op::Add && isConst(x->Args[1], &c) && (c > 0 || (c == 0 && strict)) &&
+        _limits[x->Args[0]->Id].max <= typeRange(x->Type).max - c) {
+        addFact(x->Args[0], y, true);
+    }
+}
+
+// addBranch records the facts that hold where the branch on c was taken,
+// or not.
+void prover::addBranch(Value *c, bool taken) {
+    auto x = c->Args.empty() ? nullptr : c->Args[0];
+    auto y = c->Args.size() < 2 ? nullptr : c->Args[1];
+    switch (c->Op) {
+    case Op::Not:
+        addBranch(x, !taken);
+        break;
+    case Op::Less:
+        taken ? addFact(x, y, true) : addFact(y, x, false);
+        break;
+    case Op::Leq:
+        taken ? addFact(x, y, false) : addFact(y, x, true);
+        break;
+    case Op::Eq:
+    case Op::Neq:
+        if (taken != (c->Op == Op::Eq)) {
+            if (x->Op == Op::ConstNil) {
+                setNonNil(y);
+            } else if (y->Op == Op::ConstNil) {
+                setNonNil(x);
+            }
+        } else {
+            addFact(x, y, false);
+            addFact(y, x, false);
+        }
+        break;
+    case Op::IsInBounds:
+    case Op::IsSliceInBounds:
+        if (taken) {
+            if (auto l = _limits[x->Id]; l.min < 0) {
+                setLimit(x, {0, l.max});
+            }
+            addFact(x, y, c->Op == Op::IsInBounds);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void prover::setNonNil(Value *p) {
+    if (_nonNil.Insert(p->Id)) {
+        _undo.push_back({undo::NonNil, p->Id, {}});
+    }
+}
+
+bool prover::nonNil(const Value *p) const {
+    while (p->Op == Op::OffPtr) {
+        if (_nonNil.Has(p->Id)) {
+            return true;
+        }
+        p = p->Args[0];
+    }
+    return _nonNil.Has(p->Id) || p->Op == Op::Addr || p->Op == Op::StaticData || p->Op == Op::Alloc ||
+           p->Op == Op::HeapAlloc;
+}
+
+// less reports whether x < y, or x <= y if not strict, follows from the
+// facts and the limits: it searches the chains of facts from x for one
+// that reaches y, or a value whose limits are below those of y.
+bool prover::less(Value *x, Value *y, bool strict) {
+    if (x == y) {
+        return !strict;
+    }
+    if (!ordered(x->Type) || !ordered(y->Type)) {
+        return false;
+    }
+    auto ly = _limits[y->Id];
+    _work.clear();
+    _work.emplace_back(x, false);
+    // a value reached both ways is searched from once for each
+    _seen.Reset(_f.NumValues() * 2);
+    _seen.Add(x->Id * 2);
+    // bound the search, as the facts of a long function may chain
+    for (size_t n = 0; !_work.empty() && n < 64; n++) {
+        auto [u, s] = _work.back();
+        _work.pop_back();
+        // x < u, or x <= u if not s; then x < y follows from u <= y if s
+        // or x need not be below y, and from u < y otherwise
+        auto weak = s || !strict;
+        if (u == y) {
+            if (weak) {
+                return true;
+            }
+        } else if (auto lu = _limits[u->Id]; weak ? lu.max <= ly.min : lu.max < ly.min) {
+            return true;
+        }
+        auto push = [&](Value *w, bool strict) {
+            if (_seen.Insert(w->Id * 2 + (s || strict))) {
+                _work.emplace_back(w, s || strict);
+            }
+        };
+        for (auto &f : _facts[u->Id]) {
+            push(f.To, f.Strict);
+        }
+        // u = a - c for c > 0, if it does not overflow
+        int64_t c = 0;
+        if (u->Op == Op::Sub && isConst(u->Args[1], &c) && c > 0 &&
+            _limits[u->Args[0]->Id].min >= typeRange(u->Type).min + c) {
+            push(u->Args[0], true);
+        } else if (u->Op == Op::Add && isConst(u->Args[1], &c) && c < 0 && c != minInt &&
+                   _limits[u->Args[0]->Id].min >= typeRange(u->Type).min - c) {
+            push(u->Args[0], true);
+        }
+    }
+    return false;
+}
+
+// decide returns 1 if the branch on c is always taken where it is, 0 if
+// it never is, and -1 if it is not known.
+int prover::decide(Value *c) {
+    auto x = c->Args.empty() ? nullptr : c->Args[0];
+    auto y = c->Args.size() < 2 ? nullptr : c->Args[1];
+    switch (c->Op) {
+    case Op::IsInBounds:
+    case Op::IsSliceInBounds:
+        if (_limits[x->Id].min >= 0 && less(x, y, c->Op == Op::IsInBounds)) {
+            return 1;
+        }
+        return -1;
+    case Op::Less:
+        return less(x, y, true) ? 1 : less(y, x, false) ? 0 : -1;
+    case Op::Leq:
+        return less(x, y, false) ? 1 : less(y, x, true) ? 0 : -1;
+    case Op::Eq:
+    case Op::Neq:
+        if ((x->Op == Op::ConstNil && nonNil(y)) || (y->Op == Op::ConstNil && nonNil(x))) {
+            return c->Op == Op::Neq;
+        }
+        return -1;
+    default:
+        return -1;
+    }
+}
+
+void prover::enter(Block *b) {
+    // the facts of the edge from the immediate dominator, if it is the
+    // only way in
+    if (b->Preds.size() == 1) {
+        auto p = b->Preds[0];
+        if (p->Kind == BlockKind::If && p->Succs[0] != p->Succs[1]) {
+            addBranch(p->Control, p->Succs[0] == b);
+        }
+    }
+    for (auto v : b->Values) {
+        if (v->Op != Op::NilCheck) {
+            continue;
+        }
+        if (nonNil(v->Args[0])) {
+            _nilChecks.push_back(v);
+            if (_f.Debug()) {
+                _f.Warnl(v->Pos, "removed nil check");
+            }
+        } else {
+            setNonNil(v->Args[0]);
+        }
+    }
+    if (b->Kind != BlockKind::If) {
+        return;
+    }
+    auto c = b->Control;
+    auto taken = decide(c);
+    if (taken < 0) {
+        return;
+    }
+    auto dead = b->Succs[taken];
+    _deadEdges.emplace_back(b, taken);
+    if (dead->Preds.size() == 1) {
+        _deadBlocks.Add(dead->Id);
+    }
+    if (_f.Debug()) {
+        _f.Warnl(c->Pos, fmt::format("{} {}", taken == 1 ? "Proved" : "Disproved", c->Info().Name));
+    }
+}
+
+void prover::leave(size_t mark) {
+    while (_undo.size() > mark) {
+        auto &u = _undo.back();
+        switch (u.K) {
+        case undo::Limit:
+            _limits[u.Id] = u.Old;
+            break;
+        case undo::Fact:
+            _facts[u.Id].pop_back();
+            break;
+        case undo::NonNil:
+            _nonNil.Remove(u.Id);
+            break;
+        }
+        _undo.pop_back();
+    }
+}
+
+void prover::run() {
+    _facts.assign(_f.NumValues(), {});
+    _nonNil.Reset(_f.NumValues());
+    _deadBlocks.Reset(_f.NumBlocks());
+    _limits.clear();
+    initLimits(nullptr);
+    // the limits of the induction variables hold everywhere, and narrow
+    // those of the values computed from them
+    BitSet ivs(_f.NumValues());
+    inductionVars(ivs);
+    _undo.clear();
+    initLimits(&ivs);
+
+    // walk the dominator tree, skipping the blocks only a dead edge leads
+    // to, with the mark of the undo log on entry to each block
+    std::vector<std::pair<Block *, size_t>> stack{{_f.Entry(), 0}};
+    std::vector<size_t> marks;
+    while (!stack.empty()) {
+        auto [b, i] = stack.back();
+        if (i == 0) {
+            marks.push_back(_undo.size());
+            enter(b);
+        }
+        auto children = _dom.Children(b);
+        if (i < children.size()) {
+            stack.back().second++;
+            if (!_deadBlocks.Has(children[i]->Id)) {
+                stack.emplace_back(children[i], 0);
+            }
+            continue;
+        }
+        leave(marks.back());
+        marks.pop_back();
+        stack.pop_back();
+    }
+
+    if (_deadEdges.empty() && _nilChecks.empty()) {
+        return;
+    }
+    for (auto [b, i] : _deadEdges) {
+        b->RemoveEdge(i);
+        b->Kind = BlockKind::Plain;
+        b->SetControl(nullptr);
+    }
+    for (auto v : _nilChecks) {
+        v->ResetArgs();
+        auto &values = v->Blk->Values;
+        for (size_t i = 0; i < values.size(); i++) {
+            if (values[i] == v) {
+                values.erase(i);
+                break;
+            }
+        }
+    }
+    _f.RemoveUnreachable();
+}
+
+} // namespace
+
+void Prove(Func &f) { prover(f).run(); }
+
+} // namespace ssa
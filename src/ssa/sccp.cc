@@ -0,0 +1,451 @@
+#include "ssa/pass.hh"
+
+#include <limits>
+
+#include "syntax/types/check.hh"
+
+namespace ssa {
+
+namespace {
+
+using types::TypeTable;
+
+// lattice is the state of a value: nothing known yet, a constant, or not a
+// constant. States only go down, from top to bottom.
+enum lattice : uint8_t { top, constant, bottom };
+
+struct cell {
+    lattice state = top;
+    int64_t val = 0;
+
+    bool operator==(const cell &) const = default;
+};
+
+cell meet(cell x, cell y) {
+    if (x.state == top) {
+        return y;
+    }
+    if (y.state == top || x == y) {
+        return x;
+    }
+    return {bottom};
+}
+
+// tracked reports whether SCCP computes the values of type t: integers and
+// booleans.
+bool tracked(TypeId t) {
+    if (t == 0 || t == TypeMem) {
+        return false;
+    }
+    auto k = TypeTable::Global().Underlying(t);
+    return k >= KindBool && k <= KindUintptr;
+}
+
+// normalize returns x as a value of type t: truncated to its size and
+// sign- or zero-extended to 64 bits.
+int64_t normalize(TypeId t, int64_t x) {
+    auto k = TypeTable::Global().Underlying(t);
+    if (k == KindBool) {
+        return x != 0;
+    }
+    auto bits = types::Sizeof(t) * 8;
+    if (bits >= 64) {
+        return x;
+    }
+    auto mask = (uint64_t(1) << bits) - 1;
+    if (types::IsUnsigned(t)) {
+        return int64_t(uint64_t(x) & mask);
+    }
+    auto sign = uint64_t(1) << (bits - 1);
+    return int64_t(((uint64_t(x) & mask) ^ sign) - sign);
+}
+
+class sccp {
+public:
+    explicit sccp(Func &f) : _f(f) {}
+
+    void run();
+
+private:
+    // forward returns the value whose state v takes, for the selections of
+    // an aggregate built in the function, or nil.
+    static Value *forward(const Value *v) {
+        if (v->Args.empty()) {
+            return nullptr;
+        }
+        auto a = v->Args[0];
+        switch (v->Op) {
+        case Op::SliceLen:
+            return a->Op == Op::SliceMake ? a->Args[1] : nullptr;
+        case Op::SliceCap:
+            return a->Op == Op::SliceMake ? a->Args[2] : nullptr;
+        case Op::StringLen:
+            return a->Op == Op::StringMake ? a->Args[1] : nullptr;
+        case Op::StructSelect:
+            return a->Op == Op::StructMake && size_t(v->AuxInt) < a->Args.size() ? a->Args[v->AuxInt] : nullptr;
+        default:
+            return nullptr;
+        }
+    }
+
+    void index();
+    cell eval(Value *v) const;
+    cell fold(Value *v, int64_t x, int64_t y) const;
+    void visit(Value *v);
+    void visitControl(Block *b);
+    void markEdge(Block *b, size_t i);
+    void rewrite();
+
+    Func &_f;
+    std::vector<cell> _cells;
+    // the users of each value, and the blocks it controls, in flat arrays:
+    // the users of v are _users[_userStart[v]:_userStart[v+1]]
+    std::vector<uint32_t> _userStart;
+    std::vector<Value *> _users;
+    std::vector<std::vector<Block *>> _controls;
+    // the executable blocks, and the executable edges into each block: the
+    // edge from its i-th predecessor is _predStart[b]+i
+    BitSet _executable;
+    BitSet _edges;
+    std::vector<uint32_t> _predStart;
+    std::vector<Block *> _blockWork;
+    std::vector<Value *> _valueWork;
+};
+
+void sccp::index() {
+    auto n = _f.NumValues();
+    _cells.assign(n, cell{});
+    _controls.assign(n, {});
+    _userStart.assign(n + 1, 0);
+    // the values SCCP does not compute are not constants
+    for (auto b : _f.Blocks()) {
+        for (auto v : b->Values) {
+            if (!tracked(v->Type)) {
+                _cells[v->Id] = {bottom};
+            }
+        }
+    }
+    auto each = [&](auto fn) {
+        for (auto b : _f.Blocks()) {
+            for (auto v : b->Values) {
+                for (auto a : v->Args) {
+                    fn(a, v);
+                }
+                if (auto w = forward(v)) {
+                    fn(w, v);
+                }
+            }
+        }
+    };
+    each([&](Value *a, Value *) { _userStart[a->Id + 1]++; });
+    for (ID i = 0; i < n; i++) {
+        _userStart[i + 1] += _userStart[i];
+    }
+    _users.resize(_userStart[n]);
+    std::vector<uint32_t> next(_userStart.begin(), _userStart.end() - 1);
+    each([&](Value *a, Value *v) { _users[next[a->Id]++] = v; });
+
+    _predStart.assign(_f.NumBlocks() + 1, 0);
+    uint32_t edges = 0;
+    for (auto b : _f.Blocks()) {
+        _predStart[b->Id] = edges;
+        edges += b->Preds.size();
+        if (b->Control != nullptr) {
+            _controls[b->Control->Id].push_back(b);
+        }
+    }
+    _executable.Reset(_f.NumBlocks());
+    _edges.Reset(edges);
+}
+
+cell sccp::eval(Value *v) const {
+    switch (v->Op) {
+    case Op::ConstInt:
+    case Op::ConstBool:
+        return {constant, v->AuxInt};
+    case Op::Phi: {
+        cell c;
+        for (size_t i = 0; i < v->Args.size(); i++) {
+            if (_edges.Has(_predStart[v->Blk->Id] + i)) {
+                c = meet(c, _cells[v->Args[i]->Id]);
+            }
+        }
+        return c;
+    }
+    case Op::StringLen:
+        if (v->Args[0]->Op == Op::ConstString) {
+            return {constant, int64_t(v->Args[0]->Str.size())};
+        }
+        break;
+    case Op::Eq:
+    case Op::Neq: {
+        // the constants SCCP does not track
+        auto x = v->Args[0], y = v->Args[1];
+        if (x->Op == Op::ConstString && y->Op == Op::ConstString) {
+            return {constant, (x->Str == y->Str) == (v->Op == Op::Eq)};
+        }
+        if (x->Op == Op::ConstNil && y->Op == Op::ConstNil) {
+            return {constant, v->Op == Op::Eq};
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    if (auto w = forward(v)) {
+        return _cells[w->Id];
+    }
+    switch (v->Op) {
+    case Op::Add:
+    case Op::Sub:
+    case Op::Mul:
+    case Op::Div:
+    case Op::Mod:
+    case Op::And:
+    case Op::Or:
+    case Op::Xor:
+    case Op::AndNot:
+    case Op::Shl:
+    case Op::Shr:
+    case Op::Eq:
+    case Op::Neq:
+    case Op::Less:
+    case Op::Leq:
+    case Op::IsInBounds:
+    case Op::IsSliceInBounds: {
+        auto x = _cells[v->Args[0]->Id], y = _cells[v->Args[1]->Id];
+        if (x.state == bottom || y.state == bottom) {
+            return {bottom};
+        }
+        if (x.state == top || y.state == top) {
+            return {top};
+        }
+        return fold(v, x.val, y.val);
+    }
+    case Op::Neg:
+    case Op::Com:
+    case Op::Not:
+    case Op::Convert: {
+        auto x = _cells[v->Args[0]->Id];
+        if (x.state != constant) {
+            return x;
+        }
+        return fold(v, x.val, 0);
+    }
+    default:
+        return {bottom};
+    }
+}
+
+// fold applies the operation of v to constant operands; the result is
+// bottom where the operation panics.
+cell sccp::fold(Value *v, int64_t x, int64_t y) const {
+    auto t = v->Type;
+    auto ux = uint64_t(x), uy = uint64_t(y);
+    auto at = v->Args[0]->Type;
+    auto unsignedArgs = types::IsUnsigned(at);
+    int64_t r = 0;
+    switch (v->Op) {
+    case Op::Add:
+        r = int64_t(ux + uy);
+        break;
+    case Op::Sub:
+        r = int64_t(ux - uy);
+        break;
+    case Op::Mul:
+        r = int64_t(ux * uy);
+        break;
+    case Op::Div:
+    case Op::Mod:
+        if (y == 0) {
+            return {bottom};
+        }
+        if (types::IsUnsigned(t)) {
+            r = int64_t(v->Op == Op::Div ? ux / uy : ux % uy);
+        } else if (x == std::numeric_limits<int64_t>::min() && y == -1) {
+            r = v->Op == Op::Div ? x : 0; // overflows and wraps
+        } else {
+            r = v->Op == Op::Div ? x / y : x % y;
+        }
+        break;
+    case Op::And:
+        r = x & y;
+        break;
+    case Op::Or:
+        r = x | y;
+        break;
+    case Op::Xor:
+        r = x ^ y;
+        break;
+    case Op::AndNot:
+        r = x & ~y;
+        break;
+    case Op::Shl:
+    case Op::Shr: {
+        if (!types::IsUnsigned(v->Args[1]->Type) && y < 0) {
+            return {bottom};
+        }
+        auto bits = uint64_t(types::Sizeof(t) * 8);
+        if (v->Op == Op::Shl) {
+            r = uy >= bits ? 0 : int64_t(ux << uy);
+        } else if (types::IsUnsigned(t)) {
+            r = uy >= bits ? 0 : int64_t(ux >> uy);
+        } else {
+            r = x >> (uy >= 64 ? 63 : uy);
+        }
+        break;
+    }
+    case Op::Neg:
+        r = int64_t(-ux);
+        break;
+    case Op::Com:
+        r = ~x;
+        break;
+    case Op::Not:
+        r = x == 0;
+        break;
+    case Op::Convert:
+        r = x;
+        break;
+    case Op::Eq:
+        r = x == y;
+        break;
+    case Op::Neq:
+        r = x != y;
+        break;
+    case Op::Less:
+        r = unsignedArgs ? ux < uy : x < y;
+        break;
+    case Op::Leq:
+        r = unsignedArgs ? ux <= uy : x <= y;
+        break;
+    case Op::IsInBounds:
+        r = ux < uy;
+        break;
+    case Op::IsSliceInBounds:
+        r = ux <= uy;
+        break;
+    default:
+        return {bottom};
+    }
+    return {constant, normalize(t, r)};
+}
+
+void sccp::visit(Value *v) {
+    if (!tracked(v->Type)) {
+        return;
+    }
+    auto c = eval(v);
+    auto &old = _cells[v->Id];
+    if (c != old) {
+        old = c;
+        _valueWork.push_back(v);
+    }
+}
+
+void sccp::visitControl(Block *b) {
+    switch (b->Kind) {
+    case BlockKind::Plain:
+        markEdge(b, 0);
+        break;
+    case BlockKind::If: {
+        auto c = _cells[b->Control->Id];
+        if (c.state == constant) {
+            markEdge(b, c.val != 0 ? 0 : 1);
+        } else if (c.state == bottom) {
+            markEdge(b, 0);
+            markEdge(b, 1);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+// markEdge makes the i-th successor edge of b executable.
+void sccp::markEdge(Block *b, size_t i) {
+    auto c = b->Succs[i];
+    size_t k = 0;
+    for (size_t j = 0; j < i; j++) {
+        k += b->Succs[j] == c;
+    }
+    for (size_t j = 0; j < c->Preds.size(); j++) {
+        if (c->Preds[j] != b || k-- != 0) {
+            continue;
+        }
+        if (!_edges.Insert(_predStart[c->Id] + j)) {
+            return;
+        }
+        if (_executable.Insert(c->Id)) {
+            _blockWork.push_back(c);
+            return;
+        }
+        // a new edge into a block already visited changes its Phis only
+        for (auto v : c->Values) {
+            if (v->Op == Op::Phi) {
+                visit(v);
+            }
+        }
+        return;
+    }
+}
+
+void sccp::run() {
+    index();
+    _executable.Add(_f.Entry()->Id);
+    _blockWork.push_back(_f.Entry());
+    while (!_blockWork.empty() || !_valueWork.empty()) {
+        if (!_blockWork.empty()) {
+            auto b = _blockWork.back();
+            _blockWork.pop_back();
+            for (auto v : b->Values) {
+                visit(v);
+            }
+            visitControl(b);
+            continue;
+        }
+        auto v = _valueWork.back();
+        _valueWork.pop_back();
+        for (auto i = _userStart[v->Id]; i < _userStart[v->Id + 1]; i++) {
+            if (auto u = _users[i]; _executable.Has(u->Blk->Id)) {
+                visit(u);
+            }
+        }
+        for (auto b : _controls[v->Id]) {
+            if (_executable.Has(b->Id)) {
+                visitControl(b);
+            }
+        }
+    }
+    rewrite();
+}
+
+void sccp::rewrite() {
+    for (auto b : _f.Blocks()) {
+        if (!_executable.Has(b->Id)) {
+            continue;
+        }
+        for (auto v : b->Values) {
+            auto c = _cells[v->Id];
+            if (c.state != constant || v->Op == Op::ConstInt || v->Op == Op::ConstBool) {
+                continue;
+            }
+            auto bol = TypeTable::Global().Underlying(v->Type) == KindBool;
+            v->Reset(bol ? Op::ConstBool : Op::ConstInt);
+            v->AuxInt = c.val;
+        }
+        if (b->Kind == BlockKind::If && _cells[b->Control->Id].state == constant) {
+            b->RemoveEdge(_cells[b->Control->Id].val != 0 ? 1 : 0);
+            b->Kind = BlockKind::Plain;
+            b->SetControl(nullptr);
+        }
+    }
+    _f.RemoveUnreachable();
+}
+
+} // namespace
+
+void SCCP(Func &f) { sccp(f).run(); }
+
+} // namespace ssa
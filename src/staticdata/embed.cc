@@ -0,0 +1,145 @@
+#include "staticdata/embed.hh"
+
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <filesystem>
+
+#include <fmt/format.h>
+
+#include "common/digest.hh"
+#include "common/mapped_file.hh"
+
+namespace staticdata {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// valid reports whether pattern is a relative path of non-empty elements
+// other than "." and "..".
+bool valid(std::string_view pattern) {
+    if (pattern.empty()) {
+        return false;
+    }
+    for (size_t i = 0; i <= pattern.size();) {
+        auto j = std::min(pattern.find('/', i), pattern.size());
+        auto elem = pattern.substr(i, j - i);
+        if (elem.empty() || elem == "." || elem == "..") {
+            return false;
+        }
+        i = j + 1;
+    }
+    return true;
+}
+
+// resolver matches the elements of a pattern against the tree under dir.
+struct resolver {
+    fs::path dir;
+    bool all = false;
+    std::vector<std::string> files;
+
+    // walk adds the files under the directory rel, and reports whether it
+    // found any.
+    bool walk(const std::string &rel) {
+        std::error_code ec;
+        bool found = false;
+        for (auto &e : fs::directory_iterator(dir / rel, ec)) {
+            auto name = e.path().filename().string();
+            if (!all && (name[0] == '.' || name[0] == '_')) {
+                continue;
+            }
+            if (e.is_directory(ec)) {
+                found = walk(rel + "/" + name) || found;
+            } else if (e.is_regular_file(ec)) {
+                files.push_back(rel + "/" + name);
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // match adds the files the elements of pattern from elem on name under
+    // rel, and reports whether a match named no files.
+    bool match(const std::string &rel, std::string_view pattern, size_t elem) {
+        auto end = std::min(pattern.find('/', elem), pattern.size());
+        std::string glob(pattern.substr(elem, end - elem));
+        auto last = end == pattern.size();
+        bool empty = false;
+        std::error_code ec;
+        for (auto &e : fs::directory_iterator(rel.empty() ? dir : dir / rel, ec)) {
+            auto name = e.path().filename().string();
+            if (fnmatch(glob.c_str(), name.c_str(), 0) != 0) {
+                continue;
+            }
+            auto path = rel.empty() ? name : rel + "/" + name;
+            if (!last) {
+                if (e.is_directory(ec)) {
+                    empty = match(path, pattern, end + 1) || empty;
+                }
+            } else if (e.is_directory(ec)) {
+                empty = !walk(path) || empty;
+            } else if (e.is_regular_file(ec)) {
+                files.push_back(path);
+            }
+        }
+        return empty;
+    }
+};
+
+} // namespace
+
+bool WriteEmbed(const std::string &path, const SectionWriter &w, EmbedFile &f) {
+    auto map = common::MappedFile::Open(path);
+    if (map == nullptr) {
+        return false;
+    }
+    map->Sequential();
+
+    common::DigestState state;
+    auto data = map->View();
+    for (size_t off = 0; off < data.size(); off += EmbedChunkSize) {
+        auto chunk = data.substr(off, EmbedChunkSize);
+        state.Update(chunk);
+        if (w) {
+            w(chunk);
+        }
+        map->Release(off, chunk.size());
+    }
+
+    f.Path = path;
+    f.Size = data.size();
+    f.Hash = state.Sum();
+    return true;
+}
+
+std::vector<std::string> ResolveEmbed(const std::string &dir, std::span<const std::string> patterns,
+                                      std::string &error) {
+    std::vector<std::string> files;
+    for (auto &p : patterns) {
+        resolver r{dir};
+        std::string_view pattern = p;
+        if (pattern.starts_with("all:")) {
+            r.all = true;
+            pattern.remove_prefix(4);
+        }
+        if (!valid(pattern)) {
+            error = fmt::format("pattern {}: invalid pattern syntax", p);
+            return {};
+        }
+        if (r.match("", pattern, 0)) {
+            error = fmt::format("pattern {}: cannot embed directory: contains no embeddable files", p);
+            return {};
+        }
+        if (r.files.empty()) {
+            error = fmt::format("pattern {}: no matching files found", p);
+            return {};
+        }
+        files.insert(files.end(), r.files.begin(), r.files.end());
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    return files;
+}
+
+} // namespace staticdata
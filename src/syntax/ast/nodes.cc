@@ -0,0 +1,616 @@
+#include "syntax/ast/nodes.hh"
+
+#include <sstream>
+
+#include "syntax/operator_string.hh"
+
+namespace ast {
+
+    namespace {
+        // acceptChild visits child if it is present; it returns false to stop visiting.
+        template <typename T>
+        bool acceptChild(Visitor *v, const std::shared_ptr<T> &child) {
+            return !child || child->Accept(v, child.get());
+        }
+
+        template <typename T>
+        bool acceptList(Visitor *v, const std::vector<std::shared_ptr<T>> &list) {
+            for (auto &child : list) {
+                if (!acceptChild(v, child)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // accept implements the Accept protocol shared by all nodes:
+        // Enter, then the children unless skipped, then Leave.
+        template <typename F>
+        bool accept(Node *self, Visitor *v, F children) {
+            auto n = self->shared_from_this();
+            if (v->Enter(n, n)) {
+                return v->Leave(n, n);
+            }
+            if (!children()) {
+                return false;
+            }
+            return v->Leave(n, n);
+        }
+
+        // childAt implements Node::Child over the child fields of a node,
+        // given in the order Accept visits them; lists contribute each of
+        // their elements.
+        template <typename T>
+        bool pick(size_t &i, Node *&child, const std::shared_ptr<T> &field) {
+            if (i == 0) {
+                child = field.get();
+                return true;
+            }
+            i--;
+            return false;
+        }
+
+        template <typename L>
+        bool pickList(size_t &i, Node *&child, const L &list) {
+            if (i < list.size()) {
+                child = list[i].get();
+                return true;
+            }
+            i -= list.size();
+            return false;
+        }
+
+        template <typename T>
+        bool pick(size_t &i, Node *&child, const std::vector<std::shared_ptr<T>> &list) {
+            return pickList(i, child, list);
+        }
+
+        template <typename T, size_t N>
+        bool pick(size_t &i, Node *&child, const std::array<std::shared_ptr<T>, N> &list) {
+            return pickList(i, child, list);
+        }
+
+        template <typename... Fields>
+        bool childAt(size_t i, Node *&child, const Fields &...fields) {
+            return (pick(i, child, fields) || ...);
+        }
+
+        void formatExpr(std::iostream &w, const ExprNodePtr &x) {
+            if (x) {
+                x->Format(w);
+            }
+        }
+
+        void formatList(std::iostream &w, const std::vector<ExprNodePtr> &list) {
+            for (size_t i = 0; i < list.size(); i++) {
+                if (i > 0) {
+                    w << ", ";
+                }
+                formatExpr(w, list[i]);
+            }
+        }
+
+        void formatFields(std::iostream &w, const std::vector<FieldPtr> &list, const char *sep) {
+            for (size_t i = 0; i < list.size(); i++) {
+                auto &f = list[i];
+                if (i > 0) {
+                    // fields declared in a list share the same Type
+                    w << (f->Type == list[i - 1]->Type && f->Name ? ", " : sep);
+                }
+                if (f->Name) {
+                    f->Name->Format(w);
+                    if (i + 1 < list.size() && list[i + 1]->Type == f->Type && list[i + 1]->Name) {
+                        continue;
+                    }
+                    w << " ";
+                }
+                formatExpr(w, f->Type);
+            }
+        }
+
+        void formatSignature(std::iostream &w, FuncType *t) {
+            w << "(";
+            formatFields(w, t->ParamList, ", ");
+            w << ")";
+            if (t->ResultList.empty()) {
+                return;
+            }
+            w << " ";
+            if (t->ResultList.size() == 1 && !t->ResultList[0]->Name) {
+                formatExpr(w, t->ResultList[0]->Type);
+                return;
+            }
+            w << "(";
+            formatFields(w, t->ResultList, ", ");
+            w << ")";
+        }
+    }
+
+    // ----------------------------------------------------------------------------
+    // Nodes
+
+    bool File::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, PkgName) && acceptList(v, DeclList); });
+    }
+
+    bool File::Child(size_t i, Node *&child) { return childAt(i, child, PkgName, DeclList); }
+
+    // ----------------------------------------------------------------------------
+    // Declarations
+
+    bool ImportDecl::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, LocalPkgName) && acceptChild(v, Path); });
+    }
+
+    bool ImportDecl::Child(size_t i, Node *&child) { return childAt(i, child, LocalPkgName, Path); }
+
+    bool ConstDecl::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] {
+            return acceptList(v, NameList) && acceptChild(v, Type) && acceptChild(v, Values);
+        });
+    }
+
+    bool ConstDecl::Child(size_t i, Node *&child) { return childAt(i, child, NameList, Type, Values); }
+
+    bool TypeDecl::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Name) && acceptChild(v, Type); });
+    }
+
+    bool TypeDecl::Child(size_t i, Node *&child) { return childAt(i, child, Name, Type); }
+
+    bool VarDecl::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] {
+            return acceptList(v, NameList) && acceptChild(v, Type) && acceptChild(v, Values);
+        });
+    }
+
+    bool VarDecl::Child(size_t i, Node *&child) { return childAt(i, child, NameList, Type, Values); }
+
+    bool FuncDecl::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] {
+            return acceptChild(v, Recv) && acceptChild(v, Name) && acceptList(v, TParamList) && acceptChild(v, Type) &&
+                   acceptChild(v, Body);
+        });
+    }
+
+    bool FuncDecl::Child(size_t i, Node *&child) { return childAt(i, child, Recv, Name, TParamList, Type, Body); }
+
+    // ----------------------------------------------------------------------------
+    // Expressions
+
+    bool BadExpr::Accept(Visitor *v, Node *) {
+        return accept(this, v, [] { return true; });
+    }
+
+    bool BadExpr::Child(size_t i, Node *&child) { return childAt(i, child); }
+
+    void BadExpr::Format(std::iostream &writer) { writer << "BadExpr"; }
+
+    bool Name::Accept(Visitor *v, Node *) {
+        return accept(this, v, [] { return true; });
+    }
+
+    bool Name::Child(size_t i, Node *&child) { return childAt(i, child); }
+
+    void Name::Format(std::iostream &writer) { writer << Value; }
+
+    bool BasicLit::Accept(Visitor *v, Node *) {
+        return accept(this, v, [] { return true; });
+    }
+
+    bool BasicLit::Child(size_t i, Node *&child) { return childAt(i, child); }
+
+    void BasicLit::Format(std::iostream &writer) { writer << Value; }
+
+    bool CompositeLit::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Type) && acceptList(v, ElemList); });
+    }
+
+    bool CompositeLit::Child(size_t i, Node *&child) { return childAt(i, child, Type, ElemList); }
+
+    void CompositeLit::Format(std::iostream &writer) {
+        formatExpr(writer, Type);
+        writer << "{";
+        formatList(writer, ElemList);
+        if (Packed != nullptr) {
+            for (size_t i = 0; i < Packed->Len(); i++) {
+                writer << (i > 0 ? ", " : "") << Packed->At(i);
+            }
+        }
+        writer << "}";
+    }
+
+    bool KeyValueExpr::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Key) && acceptChild(v, Value); });
+    }
+
+    bool KeyValueExpr::Child(size_t i, Node *&child) { return childAt(i, child, Key, Value); }
+
+    void KeyValueExpr::Format(std::iostream &writer) {
+        formatExpr(writer, Key);
+        writer << ": ";
+        formatExpr(writer, Value);
+    }
+
+    bool FuncLit::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Type) && acceptChild(v, Body); });
+    }
+
+    bool FuncLit::Child(size_t i, Node *&child) { return childAt(i, child, Type, Body); }
+
+    void FuncLit::Format(std::iostream &writer) {
+        writer << "func";
+        formatSignature(writer, Type.get());
+        writer << " {…}";
+    }
+
+    bool ParenExpr::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, X); });
+    }
+
+    bool ParenExpr::Child(size_t i, Node *&child) { return childAt(i, child, X); }
+
+    void ParenExpr::Format(std::iostream &writer) {
+        writer << "(";
+        formatExpr(writer, X);
+        writer << ")";
+    }
+
+    bool SelectorExpr::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, X) && acceptChild(v, Sel); });
+    }
+
+    bool SelectorExpr::Child(size_t i, Node *&child) { return childAt(i, child, X, Sel); }
+
+    void SelectorExpr::Format(std::iostream &writer) {
+        formatExpr(writer, X);
+        writer << ".";
+        Sel->Format(writer);
+    }
+
+    bool IndexExpr::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, X) && acceptChild(v, Index); });
+    }
+
+    bool IndexExpr::Child(size_t i, Node *&child) { return childAt(i, child, X, Index); }
+
+    void IndexExpr::Format(std::iostream &writer) {
+        formatExpr(writer, X);
+        writer << "[";
+        formatExpr(writer, Index);
+        writer << "]";
+    }
+
+    bool SliceExpr::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] {
+            return acceptChild(v, X) && acceptChild(v, Index[0]) && acceptChild(v, Index[1]) &&
+                   acceptChild(v, Index[2]);
+        });
+    }
+
+    bool SliceExpr::Child(size_t i, Node *&child) { return childAt(i, child, X, Index); }
+
+    void SliceExpr::Format(std::iostream &writer) {
+        formatExpr(writer, X);
+        writer << "[";
+        formatExpr(writer, Index[0]);
+        writer << ":";
+        formatExpr(writer, Index[1]);
+        if (Full) {
+            writer << ":";
+            formatExpr(writer, Index[2]);
+        }
+        writer << "]";
+    }
+
+    bool AssertExpr::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, X) && acceptChild(v, Type); });
+    }
+
+    bool AssertExpr::Child(size_t i, Node *&child) { return childAt(i, child, X, Type); }
+
+    void AssertExpr::Format(std::iostream &writer) {
+        formatExpr(writer, X);
+        writer << ".(";
+        formatExpr(writer, Type);
+        writer << ")";
+    }
+
+    bool TypeSwitchGuard::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Lhs) && acceptChild(v, X); });
+    }
+
+    bool TypeSwitchGuard::Child(size_t i, Node *&child) { return childAt(i, child, Lhs, X); }
+
+    void TypeSwitchGuard::Format(std::iostream &writer) {
+        if (Lhs) {
+            Lhs->Format(writer);
+            writer << " := ";
+        }
+        formatExpr(writer, X);
+        writer << ".(type)";
+    }
+
+    bool Operation::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, X) && acceptChild(v, Y); });
+    }
+
+    bool Operation::Child(size_t i, Node *&child) { return childAt(i, child, X, Y); }
+
+    void Operation::Format(std::iostream &writer) {
+        if (!Y) {
+            writer << syntax::OperatorString(Op);
+            formatExpr(writer, X);
+            return;
+        }
+        formatExpr(writer, X);
+        writer << " " << syntax::OperatorString(Op) << " ";
+        formatExpr(writer, Y);
+    }
+
+    bool CallExpr::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Fun) && acceptList(v, ArgList); });
+    }
+
+    bool CallExpr::Child(size_t i, Node *&child) { return childAt(i, child, Fun, ArgList); }
+
+    void CallExpr::Format(std::iostream &writer) {
+        formatExpr(writer, Fun);
+        writer << "(";
+        formatList(writer, ArgList);
+        if (HasDots) {
+            writer << "...";
+        }
+        writer << ")";
+    }
+
+    bool ListExpr::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptList(v, ElemList); });
+    }
+
+    bool ListExpr::Child(size_t i, Node *&child) { return childAt(i, child, ElemList); }
+
+    void ListExpr::Format(std::iostream &writer) { formatList(writer, ElemList); }
+
+    // ----------------------------------------------------------------------------
+    // Types
+
+    bool ArrayType::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Len) && acceptChild(v, Elem); });
+    }
+
+    bool ArrayType::Child(size_t i, Node *&child) { return childAt(i, child, Len, Elem); }
+
+    void ArrayType::Format(std::iostream &writer) {
+        writer << "[";
+        if (Len) {
+            Len->Format(writer);
+        } else {
+            writer << "...";
+        }
+        writer << "]";
+        formatExpr(writer, Elem);
+    }
+
+    bool SliceType::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Elem); });
+    }
+
+    bool SliceType::Child(size_t i, Node *&child) { return childAt(i, child, Elem); }
+
+    void SliceType::Format(std::iostream &writer) {
+        writer << "[]";
+        formatExpr(writer, Elem);
+    }
+
+    bool DotsType::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Elem); });
+    }
+
+    bool DotsType::Child(size_t i, Node *&child) { return childAt(i, child, Elem); }
+
+    void DotsType::Format(std::iostream &writer) {
+        writer << "...";
+        formatExpr(writer, Elem);
+    }
+
+    bool StructType::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptList(v, FieldList) && acceptList(v, TagList); });
+    }
+
+    bool StructType::Child(size_t i, Node *&child) { return childAt(i, child, FieldList, TagList); }
+
+    void StructType::Format(std::iostream &writer) {
+        writer << "struct{";
+        formatFields(writer, FieldList, "; ");
+        writer << "}";
+    }
+
+    bool Field::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Name) && acceptChild(v, Type); });
+    }
+
+    bool Field::Child(size_t i, Node *&child) { return childAt(i, child, Name, Type); }
+
+    bool InterfaceType::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptList(v, MethodList); });
+    }
+
+    bool InterfaceType::Child(size_t i, Node *&child) { return childAt(i, child, MethodList); }
+
+    void InterfaceType::Format(std::iostream &writer) {
+        writer << "interface{";
+        for (size_t i = 0; i < MethodList.size(); i++) {
+            auto &m = MethodList[i];
+            if (i > 0) {
+                writer << "; ";
+            }
+            if (m->Name) {
+                m->Name->Format(writer);
+                formatSignature(writer, static_cast<FuncType *>(m->Type.get()));
+            } else {
+                formatExpr(writer, m->Type);
+            }
+        }
+        writer << "}";
+    }
+
+    bool FuncType::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptList(v, ParamList) && acceptList(v, ResultList); });
+    }
+
+    bool FuncType::Child(size_t i, Node *&child) { return childAt(i, child, ParamList, ResultList); }
+
+    void FuncType::Format(std::iostream &writer) {
+        writer << "func";
+        formatSignature(writer, this);
+    }
+
+    bool MapType::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Key) && acceptChild(v, Value); });
+    }
+
+    bool MapType::Child(size_t i, Node *&child) { return childAt(i, child, Key, Value); }
+
+    void MapType::Format(std::iostream &writer) {
+        writer << "map[";
+        formatExpr(writer, Key);
+        writer << "]";
+        formatExpr(writer, Value);
+    }
+
+    bool ChanType::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Elem); });
+    }
+
+    bool ChanType::Child(size_t i, Node *&child) { return childAt(i, child, Elem); }
+
+    void ChanType::Format(std::iostream &writer) {
+        if (Dir == RecvOnly) {
+            writer << "<-";
+        }
+        writer << "chan";
+        if (Dir == SendOnly) {
+            writer << "<-";
+        }
+        writer << " ";
+        formatExpr(writer, Elem);
+    }
+
+    // ----------------------------------------------------------------------------
+    // Statements
+
+    bool EmptyStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [] { return true; });
+    }
+
+    bool EmptyStmt::Child(size_t i, Node *&child) { return childAt(i, child); }
+
+    bool LabeledStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Label) && acceptChild(v, Stmt); });
+    }
+
+    bool LabeledStmt::Child(size_t i, Node *&child) { return childAt(i, child, Label, Stmt); }
+
+    bool BlockStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptList(v, List); });
+    }
+
+    bool BlockStmt::Child(size_t i, Node *&child) { return childAt(i, child, List); }
+
+    bool ExprStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, X); });
+    }
+
+    bool ExprStmt::Child(size_t i, Node *&child) { return childAt(i, child, X); }
+
+    bool SendStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Chan) && acceptChild(v, Value); });
+    }
+
+    bool SendStmt::Child(size_t i, Node *&child) { return childAt(i, child, Chan, Value); }
+
+    bool DeclStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptList(v, DeclList); });
+    }
+
+    bool DeclStmt::Child(size_t i, Node *&child) { return childAt(i, child, DeclList); }
+
+    bool AssignStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Lhs) && acceptChild(v, Rhs); });
+    }
+
+    bool AssignStmt::Child(size_t i, Node *&child) { return childAt(i, child, Lhs, Rhs); }
+
+    bool BranchStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Label); });
+    }
+
+    bool BranchStmt::Child(size_t i, Node *&child) { return childAt(i, child, Label); }
+
+    bool CallStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Call); });
+    }
+
+    bool CallStmt::Child(size_t i, Node *&child) { return childAt(i, child, Call); }
+
+    bool ReturnStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Results); });
+    }
+
+    bool ReturnStmt::Child(size_t i, Node *&child) { return childAt(i, child, Results); }
+
+    bool IfStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] {
+            return acceptChild(v, Init) && acceptChild(v, Cond) && acceptChild(v, Then) && acceptChild(v, Else);
+        });
+    }
+
+    bool IfStmt::Child(size_t i, Node *&child) { return childAt(i, child, Init, Cond, Then, Else); }
+
+    bool ForStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] {
+            return acceptChild(v, Init) && acceptChild(v, Cond) && acceptChild(v, Post) && acceptChild(v, Body);
+        });
+    }
+
+    bool ForStmt::Child(size_t i, Node *&child) { return childAt(i, child, Init, Cond, Post, Body); }
+
+    bool SwitchStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Init) && acceptChild(v, Tag) && acceptList(v, Body); });
+    }
+
+    bool SwitchStmt::Child(size_t i, Node *&child) { return childAt(i, child, Init, Tag, Body); }
+
+    bool SelectStmt::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptList(v, Body); });
+    }
+
+    bool SelectStmt::Child(size_t i, Node *&child) { return childAt(i, child, Body); }
+
+    bool RangeClause::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Lhs) && acceptChild(v, X); });
+    }
+
+    bool RangeClause::Child(size_t i, Node *&child) { return childAt(i, child, Lhs, X); }
+
+    bool CaseClause::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Cases) && acceptList(v, Body); });
+    }
+
+    bool CaseClause::Child(size_t i, Node *&child) { return childAt(i, child, Cases, Body); }
+
+    bool CommClause::Accept(Visitor *v, Node *) {
+        return accept(this, v, [&] { return acceptChild(v, Comm) && acceptList(v, Body); });
+    }
+
+    bool CommClause::Child(size_t i, Node *&child) { return childAt(i, child, Comm, Body); }
+
+    std::string String(ExprNode *x) {
+        std::stringstream ss;
+        if (x) {
+            x->Format(ss);
+        }
+        return ss.str();
+    }
+}
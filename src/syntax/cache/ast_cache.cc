@@ -0,0 +1,1018 @@
+#include "syntax/cache/ast_cache.hh"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+#include <fmt/format.h>
+
+#include "common/digest.hh"
+
+namespace syntax::cache {
+
+namespace {
+
+// slots holds the number of children of each node kind; -1 means any.
+constexpr int slots[] = {
+    -1, // List
+    0,  // Pos
+    3,  // File: PkgName, DeclList, Eof
+    2,  // ImportDecl: LocalPkgName, Path
+    3,  // ConstDecl: NameList, Type, Values
+    2,  // TypeDecl: Name, Type
+    4,  // VarDecl: NameList, Type, Values, EmbedPatterns
+    7,  // FuncDecl: Recv, Name, Type, Body, BodyLbrace, BodyRbrace, TParamList
+    0,  // BadExpr
+    0,  // Name
+    0,  // BasicLit
+    3,  // CompositeLit: Type, ElemList, Rbrace
+    2,  // KeyValueExpr: Key, Value
+    2,  // FuncLit: Type, Body
+    1,  // ParenExpr: X
+    2,  // SelectorExpr: X, Sel
+    2,  // IndexExpr: X, Index
+    4,  // SliceExpr: X, Index[0], Index[1], Index[2]
+    2,  // AssertExpr: X, Type
+    2,  // TypeSwitchGuard: Lhs, X
+    2,  // Operation: X, Y
+    2,  // CallExpr: Fun, ArgList
+    1,  // ListExpr: ElemList
+    2,  // ArrayType: Len, Elem
+    1,  // SliceType: Elem
+    1,  // DotsType: Elem
+    2,  // StructType: FieldList, TagList
+    2,  // Field: Name, Type
+    1,  // InterfaceType: MethodList
+    2,  // FuncType: ParamList, ResultList
+    2,  // MapType: Key, Value
+    1,  // ChanType: Elem
+    0,  // EmptyStmt
+    2,  // LabeledStmt: Label, Stmt
+    2,  // BlockStmt: List, Rbrace
+    1,  // ExprStmt: X
+    2,  // SendStmt: Chan, Value
+    1,  // DeclStmt: DeclList
+    2,  // AssignStmt: Lhs, Rhs
+    1,  // BranchStmt: Label
+    1,  // CallStmt: Call
+    1,  // ReturnStmt: Results
+    4,  // IfStmt: Init, Cond, Then, Else
+    4,  // ForStmt: Init, Cond, Post, Body
+    4,  // SwitchStmt: Init, Tag, Body, Rbrace
+    2,  // SelectStmt: Body, Rbrace
+    2,  // RangeClause: Lhs, X
+    3,  // CaseClause: Cases, Body, Colon
+    3,  // CommClause: Comm, Body, Colon
+};
+static_assert(sizeof(slots) / sizeof(slots[0]) == NodeKind_MAX + 1);
+
+// kindOf returns the cache kind of n.
+NodeKind kindOf(const ast::Node *n) {
+    // indexed by ast::NodeKind
+    static const NodeKind kinds[] = {
+        NodeKind_File,
+        NodeKind_Field,
+        NodeKind_CaseClause,
+        NodeKind_CommClause,
+        NodeKind_ImportDecl,
+        NodeKind_ConstDecl,
+        NodeKind_TypeDecl,
+        NodeKind_VarDecl,
+        NodeKind_FuncDecl,
+        NodeKind_BadExpr,
+        NodeKind_Name,
+        NodeKind_BasicLit,
+        NodeKind_CompositeLit,
+        NodeKind_KeyValueExpr,
+        NodeKind_FuncLit,
+        NodeKind_ParenExpr,
+        NodeKind_SelectorExpr,
+        NodeKind_IndexExpr,
+        NodeKind_SliceExpr,
+        NodeKind_AssertExpr,
+        NodeKind_TypeSwitchGuard,
+        NodeKind_Operation,
+        NodeKind_CallExpr,
+        NodeKind_ListExpr,
+        NodeKind_ArrayType,
+        NodeKind_SliceType,
+        NodeKind_DotsType,
+        NodeKind_StructType,
+        NodeKind_InterfaceType,
+        NodeKind_FuncType,
+        NodeKind_MapType,
+        NodeKind_ChanType,
+        NodeKind_EmptyStmt,
+        NodeKind_ExprStmt,
+        NodeKind_SendStmt,
+        NodeKind_AssignStmt,
+        NodeKind_RangeClause,
+        NodeKind_LabeledStmt,
+        NodeKind_BlockStmt,
+        NodeKind_DeclStmt,
+        NodeKind_BranchStmt,
+        NodeKind_CallStmt,
+        NodeKind_ReturnStmt,
+        NodeKind_IfStmt,
+        NodeKind_ForStmt,
+        NodeKind_SwitchStmt,
+        NodeKind_SelectStmt,
+    };
+    static_assert(sizeof(kinds) / sizeof(kinds[0]) == size_t(ast::NodeKind::LastStmt) + 1);
+    return kinds[size_t(n->Kind())];
+}
+
+// encoder flattens a syntax tree into post-order node and child arrays.
+// Nodes reachable along several paths, such as the Type shared by the
+// fields of a name list, are emitted once.
+struct encoder {
+    const SourceFile *file;
+    std::vector<Node> nodes;
+    std::vector<uint32_t> children;
+    std::vector<uint8_t> data;
+    std::vector<std::string_view> strings;
+    std::unordered_map<std::string_view, uint32_t> string_index;
+    std::unordered_map<const ast::Node *, uint32_t> done; // node -> slot
+    std::unordered_map<const ast::Group *, uint32_t> groups;
+
+    uint32_t str(std::string_view s) {
+        auto [it, inserted] = string_index.emplace(s, uint32_t(strings.size()));
+        if (inserted) {
+            strings.push_back(s);
+        }
+        return it->second;
+    }
+
+    // blob appends b to data and returns its offset.
+    uint32_t blob(const std::vector<uint8_t> &b) {
+        auto offset = uint32_t(data.size());
+        for (int i = 0; i < 4; i++) {
+            data.push_back(uint8_t(b.size() >> (8 * i)));
+        }
+        data.insert(data.end(), b.begin(), b.end());
+        return offset;
+    }
+
+    // strs emits l as a list of string BasicLits without position.
+    uint32_t strs(const std::vector<std::string> &l) {
+        if (l.empty()) {
+            return 0;
+        }
+        std::vector<uint32_t> elems;
+        elems.reserve(l.size());
+        for (auto &s : l) {
+            elems.push_back(add(NodeKind_BasicLit, {}, {}, 0, StringLit, str(s)));
+        }
+        auto first = uint32_t(children.size());
+        children.insert(children.end(), elems.begin(), elems.end());
+        nodes.emplace_back(NodeKind_List, 0, 0, 0, first, uint32_t(elems.size()), 0);
+        return uint32_t(nodes.size());
+    }
+
+    uint32_t group(const ast::GroupPtr &g) {
+        if (g == nullptr) {
+            return 0;
+        }
+        return groups.emplace(g.get(), uint32_t(groups.size() + 1)).first->second;
+    }
+
+    // add appends a node with the given child slots and returns its slot.
+    uint32_t add(NodeKind kind, ast::Pos pos, std::initializer_list<uint32_t> slots, uint32_t flags = 0,
+                 uint32_t sub = 0, uint32_t value = 0) {
+        auto first = uint32_t(children.size());
+        children.insert(children.end(), slots);
+        nodes.emplace_back(kind, uint8_t(flags), uint16_t(sub), value, first, uint32_t(slots.size()),
+                           pos.IsKnown() ? uint32_t(file->Offset(pos) + 1) : 0);
+        return uint32_t(nodes.size());
+    }
+
+    uint32_t pos(ast::Pos p) { return p.IsKnown() ? add(NodeKind_Pos, p, {}) : 0; }
+
+    template <typename T>
+    uint32_t list(const std::vector<std::shared_ptr<T>> &l) {
+        if (l.empty()) {
+            return 0;
+        }
+        std::vector<uint32_t> elems;
+        elems.reserve(l.size());
+        for (auto &x : l) {
+            elems.push_back(node(x.get()));
+        }
+        auto first = uint32_t(children.size());
+        children.insert(children.end(), elems.begin(), elems.end());
+        nodes.emplace_back(NodeKind_List, 0, 0, 0, first, uint32_t(elems.size()), 0);
+        return uint32_t(nodes.size());
+    }
+
+    template <typename T>
+    uint32_t node(const std::shared_ptr<T> &n) {
+        return node(n.get());
+    }
+
+    uint32_t node(const ast::Node *n) {
+        if (n == nullptr) {
+            return 0;
+        }
+        if (auto it = done.find(n); it != done.end()) {
+            return it->second;
+        }
+        auto slot = encode(n);
+        done.emplace(n, slot);
+        return slot;
+    }
+
+    uint32_t encode(const ast::Node *n) {
+        auto p = n->pos;
+        switch (auto kind = kindOf(n)) {
+        case NodeKind_File: {
+            auto x = cast<ast::File>(n);
+            return add(kind, p, {node(x->PkgName), list(x->DeclList), pos(x->Eof)});
+        }
+        case NodeKind_ImportDecl: {
+            auto x = cast<ast::ImportDecl>(n);
+            return add(kind, p, {node(x->LocalPkgName), node(x->Path)}, 0, 0, group(x->Group));
+        }
+        case NodeKind_ConstDecl: {
+            auto x = cast<ast::ConstDecl>(n);
+            return add(kind, p, {list(x->NameList), node(x->Type), node(x->Values)}, 0, 0, group(x->Group));
+        }
+        case NodeKind_TypeDecl: {
+            auto x = cast<ast::TypeDecl>(n);
+            return add(kind, p, {node(x->Name), node(x->Type)}, x->Alias ? NodeFlagAlias : 0, 0, group(x->Group));
+        }
+        case NodeKind_VarDecl: {
+            auto x = cast<ast::VarDecl>(n);
+            return add(kind, p, {list(x->NameList), node(x->Type), node(x->Values), strs(x->EmbedPatterns)}, 0, 0,
+                       group(x->Group));
+        }
+        case NodeKind_FuncDecl: {
+            auto x = cast<ast::FuncDecl>(n);
+            return add(kind, p,
+                       {node(x->Recv), node(x->Name), node(x->Type), node(x->Body), pos(x->BodyLbrace),
+                        pos(x->BodyRbrace), list(x->TParamList)});
+        }
+        case NodeKind_Name: {
+            auto x = cast<ast::Name>(n);
+            return add(kind, p, {}, 0, 0, str(x->Value));
+        }
+        case NodeKind_BasicLit: {
+            auto x = cast<ast::BasicLit>(n);
+            return add(kind, p, {}, x->Bad ? NodeFlagBad : 0, x->Kind, str(x->Value));
+        }
+        case NodeKind_CompositeLit: {
+            auto x = cast<ast::CompositeLit>(n);
+            if (x->Packed != nullptr) {
+                return add(kind, p, {node(x->Type), list(x->ElemList), pos(x->Rbrace)}, NodeFlagPacked,
+                           x->Packed->ElemSize, blob(x->Packed->Data));
+            }
+            return add(kind, p, {node(x->Type), list(x->ElemList), pos(x->Rbrace)}, 0, 0, uint32_t(x->NKeys));
+        }
+        case NodeKind_KeyValueExpr: {
+            auto x = cast<ast::KeyValueExpr>(n);
+            return add(kind, p, {node(x->Key), node(x->Value)});
+        }
+        case NodeKind_FuncLit: {
+            auto x = cast<ast::FuncLit>(n);
+            return add(kind, p, {node(x->Type), node(x->Body)});
+        }
+        case NodeKind_ParenExpr: {
+            auto x = cast<ast::ParenExpr>(n);
+            return add(kind, p, {node(x->X)});
+        }
+        case NodeKind_SelectorExpr: {
+            auto x = cast<ast::SelectorExpr>(n);
+            return add(kind, p, {node(x->X), node(x->Sel)});
+        }
+        case NodeKind_IndexExpr: {
+            auto x = cast<ast::IndexExpr>(n);
+            return add(kind, p, {node(x->X), node(x->Index)});
+        }
+        case NodeKind_SliceExpr: {
+            auto x = cast<ast::SliceExpr>(n);
+            return add(kind, p, {node(x->X), node(x->Index[0]), node(x->Index[1]), node(x->Index[2])},
+                       x->Full ? NodeFlagFull : 0);
+        }
+        case NodeKind_AssertExpr: {
+            auto x = cast<ast::AssertExpr>(n);
+            return add(kind, p, {node(x->X), node(x->Type)});
+        }
+        case NodeKind_TypeSwitchGuard: {
+            auto x = cast<ast::TypeSwitchGuard>(n);
+            return add(kind, p, {node(x->Lhs), node(x->X)});
+        }
+        case NodeKind_Operation: {
+            auto x = cast<ast::Operation>(n);
+            return add(kind, p, {node(x->X), node(x->Y)}, 0, x->Op);
+        }
+        case NodeKind_CallExpr: {
+            auto x = cast<ast::CallExpr>(n);
+            return add(kind, p, {node(x->Fun), list(x->ArgList)}, x->HasDots ? NodeFlagHasDots : 0);
+        }
+        case NodeKind_ListExpr: {
+            auto x = cast<ast::ListExpr>(n);
+            return add(kind, p, {list(x->ElemList)});
+        }
+        case NodeKind_ArrayType: {
+            auto x = cast<ast::ArrayType>(n);
+            return add(kind, p, {node(x->Len), node(x->Elem)});
+        }
+        case NodeKind_SliceType: {
+            auto x = cast<ast::SliceType>(n);
+            return add(kind, p, {node(x->Elem)});
+        }
+        case NodeKind_DotsType: {
+            auto x = cast<ast::DotsType>(n);
+            return add(kind, p, {node(x->Elem)});
+        }
+        case NodeKind_StructType: {
+            auto x = cast<ast::StructType>(n);
+            return add(kind, p, {list(x->FieldList), list(x->TagList)});
+        }
+        case NodeKind_Field: {
+            auto x = cast<ast::Field>(n);
+            return add(kind, p, {node(x->Name), node(x->Type)});
+        }
+        case NodeKind_InterfaceType: {
+            auto x = cast<ast::InterfaceType>(n);
+            return add(kind, p, {list(x->MethodList)});
+        }
+        case NodeKind_FuncType: {
+            auto x = cast<ast::FuncType>(n);
+            return add(kind, p, {list(x->ParamList), list(x->ResultList)});
+        }
+        case NodeKind_MapType: {
+            auto x = cast<ast::MapType>(n);
+            return add(kind, p, {node(x->Key), node(x->Value)});
+        }
+        case NodeKind_ChanType: {
+            auto x = cast<ast::ChanType>(n);
+            return add(kind, p, {node(x->Elem)}, 0, x->Dir);
+        }
+        case NodeKind_LabeledStmt: {
+            auto x = cast<ast::LabeledStmt>(n);
+            return add(kind, p, {node(x->Label), node(x->Stmt)});
+        }
+        case NodeKind_BlockStmt: {
+            auto x = cast<ast::BlockStmt>(n);
+            return add(kind, p, {list(x->List), pos(x->Rbrace)});
+        }
+        case NodeKind_ExprStmt: {
+            auto x = cast<ast::ExprStmt>(n);
+            return add(kind, p, {node(x->X)});
+        }
+        case NodeKind_SendStmt: {
+            auto x = cast<ast::SendStmt>(n);
+            return add(kind, p, {node(x->Chan), node(x->Value)});
+        }
+        case NodeKind_DeclStmt: {
+            auto x = cast<ast::DeclStmt>(n);
+            return add(kind, p, {list(x->DeclList)});
+        }
+        case NodeKind_AssignStmt: {
+            auto x = cast<ast::AssignStmt>(n);
+            return add(kind, p, {node(x->Lhs), node(x->Rhs)}, 0, x->Op);
+        }
+        case NodeKind_BranchStmt: {
+            auto x = cast<ast::BranchStmt>(n);
+            return add(kind, p, {node(x->Label)}, 0, x->Tok);
+        }
+        case NodeKind_CallStmt: {
+            auto x = cast<ast::CallStmt>(n);
+            return add(kind, p, {node(x->Call)}, 0, x->Tok);
+        }
+        case NodeKind_ReturnStmt: {
+            auto x = cast<ast::ReturnStmt>(n);
+            return add(kind, p, {node(x->Results)});
+        }
+        case NodeKind_IfStmt: {
+            auto x = cast<ast::IfStmt>(n);
+            return add(kind, p, {node(x->Init), node(x->Cond), node(x->Then), node(x->Else)});
+        }
+        case NodeKind_ForStmt: {
+            auto x = cast<ast::ForStmt>(n);
+            return add(kind, p, {node(x->Init), node(x->Cond), node(x->Post), node(x->Body)});
+        }
+        case NodeKind_SwitchStmt: {
+            auto x = cast<ast::SwitchStmt>(n);
+            return add(kind, p, {node(x->Init), node(x->Tag), list(x->Body), pos(x->Rbrace)});
+        }
+        case NodeKind_SelectStmt: {
+            auto x = cast<ast::SelectStmt>(n);
+            return add(kind, p, {list(x->Body), pos(x->Rbrace)});
+        }
+        case NodeKind_RangeClause: {
+            auto x = cast<ast::RangeClause>(n);
+            return add(kind, p, {node(x->Lhs), node(x->X)}, x->Def ? NodeFlagDef : 0);
+        }
+        case NodeKind_CaseClause: {
+            auto x = cast<ast::CaseClause>(n);
+            return add(kind, p, {node(x->Cases), list(x->Body), pos(x->Colon)});
+        }
+        case NodeKind_CommClause: {
+            auto x = cast<ast::CommClause>(n);
+            return add(kind, p, {node(x->Comm), list(x->Body), pos(x->Colon)});
+        }
+        default: // BadExpr, EmptyStmt
+            return add(kind, p, {});
+        }
+    }
+};
+
+// decoder rebuilds a syntax tree from a validated cached file.
+struct decoder {
+    const SourceFile *file;
+    // the nodes with several parents, decoded once; the others are handed
+    // to their parent as they are decoded
+    std::vector<uint8_t> parents;
+    std::vector<ast::NodePtr> done;
+    std::vector<ast::GroupPtr> groups;
+    // the symbols of the strings of the file, interned on first use: names
+    // repeat, and the strings are stored once
+    std::vector<common::SymbolId> syms;
+    std::vector<bool> interned;
+
+    common::SymbolId sym(NodeView v) {
+        auto i = v.Value();
+        if (!interned[i]) {
+            syms[i] = common::Interner::Global().Intern(v.Str());
+            interned[i] = true;
+        }
+        return syms[i];
+    }
+
+    ast::GroupPtr group(uint32_t id) {
+        if (id == 0) {
+            return nullptr;
+        }
+        if (id > groups.size()) {
+            groups.resize(id);
+        }
+        if (groups[id - 1] == nullptr) {
+            groups[id - 1] = std::make_shared<ast::Group>();
+        }
+        return groups[id - 1];
+    }
+
+    ast::Pos pos(NodeView v) { return v ? at(v) : ast::Pos{}; }
+    ast::Pos at(NodeView v) { return v.Offset() < 0 ? ast::Pos{} : file->At(v.Offset()); }
+
+    // get returns the child as a T, or nil if it is not one.
+    template <typename T>
+    std::shared_ptr<T> get(NodeView v) {
+        auto n = node(v);
+        return isa_and_nonnull<T>(n) ? std::static_pointer_cast<T>(std::move(n)) : nullptr;
+    }
+
+    template <typename T>
+    std::vector<std::shared_ptr<T>> list(NodeView v) {
+        std::vector<std::shared_ptr<T>> l;
+        if (!v || v.Kind() != NodeKind_List) {
+            return l;
+        }
+        l.reserve(v.NumChildren());
+        for (uint32_t i = 0; i < v.NumChildren(); i++) {
+            l.push_back(get<T>(v.Child(i)));
+        }
+        return l;
+    }
+
+    ast::NodePtr node(NodeView v) {
+        if (!v || v.Kind() == NodeKind_List || v.Kind() == NodeKind_Pos) {
+            return nullptr;
+        }
+        if (parents[v.Index()] <= 1) {
+            auto n = decode(v);
+            n->pos = at(v);
+            return n;
+        }
+        auto &n = done[v.Index()];
+        if (n == nullptr) {
+            n = decode(v);
+            n->pos = at(v);
+        }
+        return n;
+    }
+
+    ast::NodePtr decode(NodeView v) {
+        auto c = [&](uint32_t i) { return v.Child(i); };
+        switch (v.Kind()) {
+        case NodeKind_File: {
+            auto x = std::make_shared<ast::File>();
+            x->PkgName = get<ast::Name>(c(0));
+            x->DeclList = list<ast::DeclNode>(c(1));
+            x->Eof = pos(c(2));
+            return x;
+        }
+        case NodeKind_ImportDecl: {
+            auto x = std::make_shared<ast::ImportDecl>();
+            x->Group = group(v.Value());
+            x->LocalPkgName = get<ast::Name>(c(0));
+            x->Path = get<ast::BasicLit>(c(1));
+            return x;
+        }
+        case NodeKind_ConstDecl: {
+            auto x = std::make_shared<ast::ConstDecl>();
+            x->Group = group(v.Value());
+            x->NameList = list<ast::Name>(c(0));
+            x->Type = get<ast::ExprNode>(c(1));
+            x->Values = get<ast::ExprNode>(c(2));
+            return x;
+        }
+        case NodeKind_TypeDecl: {
+            auto x = std::make_shared<ast::TypeDecl>();
+            x->Group = group(v.Value());
+            x->Name = get<ast::Name>(c(0));
+            x->Alias = v.Flags() & NodeFlagAlias;
+            x->Type = get<ast::ExprNode>(c(1));
+            return x;
+        }
+        case NodeKind_VarDecl: {
+            auto x = std::make_shared<ast::VarDecl>();
+            x->Group = group(v.Value());
+            x->NameList = list<ast::Name>(c(0));
+            x->Type = get<ast::ExprNode>(c(1));
+            x->Values = get<ast::ExprNode>(c(2));
+            if (auto l = c(3)) {
+                for (uint32_t i = 0; i < l.NumChildren(); i++) {
+                    if (auto e = l.Child(i); e && e.Kind() == NodeKind_BasicLit) {
+                        x->EmbedPatterns.emplace_back(e.Str());
+                    }
+                }
+            }
+            return x;
+        }
+        case NodeKind_FuncDecl: {
+            auto x = std::make_shared<ast::FuncDecl>();
+            x->Recv = get<ast::Field>(c(0));
+            x->Name = get<ast::Name>(c(1));
+            x->Type = get<ast::FuncType>(c(2));
+            x->Body = get<ast::BlockStmt>(c(3));
+            x->BodyLbrace = pos(c(4));
+            x->BodyRbrace = pos(c(5));
+            x->TParamList = list<ast::Field>(c(6));
+            return x;
+        }
+        case NodeKind_BadExpr:
+            return std::make_shared<ast::BadExpr>();
+        case NodeKind_Name: {
+            auto x = std::make_shared<ast::Name>();
+            x->Sym = sym(v);
+            x->Value = common::Interner::Global().Name(x->Sym);
+            return x;
+        }
+        case NodeKind_BasicLit: {
+            auto x = std::make_shared<ast::BasicLit>();
+            x->Value = std::string(v.Str());
+            x->Kind = v.Sub();
+            x->Bad = v.Flags() & NodeFlagBad;
+            return x;
+        }
+        case NodeKind_CompositeLit: {
+            auto x = std::make_shared<ast::CompositeLit>();
+            x->Type = get<ast::ExprNode>(c(0));
+            x->ElemList = list<ast::ExprNode>(c(1));
+            if (v.Flags() & NodeFlagPacked) {
+                auto packed = std::make_shared<ast::PackedElems>();
+                packed->ElemSize = uint8_t(v.Sub());
+                packed->Data.assign(v.Packed().begin(), v.Packed().end());
+                x->Packed = std::move(packed);
+            } else {
+                x->NKeys = int(v.Value());
+            }
+            x->Rbrace = pos(c(2));
+            return x;
+        }
+        case NodeKind_KeyValueExpr: {
+            auto x = std::make_shared<ast::KeyValueExpr>();
+            x->Key = get<ast::ExprNode>(c(0));
+            x->Value = get<ast::ExprNode>(c(1));
+            return x;
+        }
+        case NodeKind_FuncLit: {
+            auto x = std::make_shared<ast::FuncLit>();
+            x->Type = get<ast::FuncType>(c(0));
+            x->Body = get<ast::BlockStmt>(c(1));
+            return x;
+        }
+        case NodeKind_ParenExpr: {
+            auto x = std::make_shared<ast::ParenExpr>();
+            x->X = get<ast::ExprNode>(c(0));
+            return x;
+        }
+        case NodeKind_SelectorExpr: {
+            auto x = std::make_shared<ast::SelectorExpr>();
+            x->X = get<ast::ExprNode>(c(0));
+            x->Sel = get<ast::Name>(c(1));
+            return x;
+        }
+        case NodeKind_IndexExpr: {
+            auto x = std::make_shared<ast::IndexExpr>();
+            x->X = get<ast::ExprNode>(c(0));
+            x->Index = get<ast::ExprNode>(c(1));
+            return x;
+        }
+        case NodeKind_SliceExpr: {
+            auto x = std::make_shared<ast::SliceExpr>();
+            x->X = get<ast::ExprNode>(c(0));
+            for (int i = 0; i < 3; i++) {
+                x->Index[i] = get<ast::ExprNode>(c(1 + i));
+            }
+            x->Full = v.Flags() & NodeFlagFull;
+            return x;
+        }
+        case NodeKind_AssertExpr: {
+            auto x = std::make_shared<ast::AssertExpr>();
+            x->X = get<ast::ExprNode>(c(0));
+            x->Type = get<ast::ExprNode>(c(1));
+            return x;
+        }
+        case NodeKind_TypeSwitchGuard: {
+            auto x = std::make_shared<ast::TypeSwitchGuard>();
+            x->Lhs = get<ast::Name>(c(0));
+            x->X = get<ast::ExprNode>(c(1));
+            return x;
+        }
+        case NodeKind_Operation: {
+            auto x = std::make_shared<ast::Operation>();
+            x->Op = v.Sub();
+            x->X = get<ast::ExprNode>(c(0));
+            x->Y = get<ast::ExprNode>(c(1));
+            return x;
+        }
+        case NodeKind_CallExpr: {
+            auto x = std::make_shared<ast::CallExpr>();
+            x->Fun = get<ast::ExprNode>(c(0));
+            x->ArgList = list<ast::ExprNode>(c(1));
+            x->HasDots = v.Flags() & NodeFlagHasDots;
+            return x;
+        }
+        case NodeKind_ListExpr: {
+            auto x = std::make_shared<ast::ListExpr>();
+            x->ElemList = list<ast::ExprNode>(c(0));
+            return x;
+        }
+        case NodeKind_ArrayType: {
+            auto x = std::make_shared<ast::ArrayType>();
+            x->Len = get<ast::ExprNode>(c(0));
+            x->Elem = get<ast::ExprNode>(c(1));
+            return x;
+        }
+        case NodeKind_SliceType: {
+            auto x = std::make_shared<ast::SliceType>();
+            x->Elem = get<ast::ExprNode>(c(0));
+            return x;
+        }
+        case NodeKind_DotsType: {
+            auto x = std::make_shared<ast::DotsType>();
+            x->Elem = get<ast::ExprNode>(c(0));
+            return x;
+        }
+        case NodeKind_StructType: {
+            auto x = std::make_shared<ast::StructType>();
+            x->FieldList = list<ast::Field>(c(0));
+            x->TagList = list<ast::BasicLit>(c(1));
+            return x;
+        }
+        case NodeKind_Field: {
+            auto x = std::make_shared<ast::Field>();
+            x->Name = get<ast::Name>(c(0));
+            x->Type = get<ast::ExprNode>(c(1));
+            return x;
+        }
+        case NodeKind_InterfaceType: {
+            auto x = std::make_shared<ast::InterfaceType>();
+            x->MethodList = list<ast::Field>(c(0));
+            return x;
+        }
+        case NodeKind_FuncType: {
+            auto x = std::make_shared<ast::FuncType>();
+            x->ParamList = list<ast::Field>(c(0));
+            x->ResultList = list<ast::Field>(c(1));
+            return x;
+        }
+        case NodeKind_MapType: {
+            auto x = std::make_shared<ast::MapType>();
+            x->Key = get<ast::ExprNode>(c(0));
+            x->Value = get<ast::ExprNode>(c(1));
+            return x;
+        }
+        case NodeKind_ChanType: {
+            auto x = std::make_shared<ast::ChanType>();
+            x->Dir = v.Sub();
+            x->Elem = get<ast::ExprNode>(c(0));
+            return x;
+        }
+        case NodeKind_EmptyStmt:
+            return std::make_shared<ast::EmptyStmt>();
+        case NodeKind_LabeledStmt: {
+            auto x = std::make_shared<ast::LabeledStmt>();
+            x->Label = get<ast::Name>(c(0));
+            x->Stmt = get<ast::StmtNode>(c(1));
+            return x;
+        }
+        case NodeKind_BlockStmt: {
+            auto x = std::make_shared<ast::BlockStmt>();
+            x->List = list<ast::StmtNode>(c(0));
+            x->Rbrace = pos(c(1));
+            return x;
+        }
+        case NodeKind_ExprStmt: {
+            auto x = std::make_shared<ast::ExprStmt>();
+            x->X = get<ast::ExprNode>(c(0));
+            return x;
+        }
+        case NodeKind_SendStmt: {
+            auto x = std::make_shared<ast::SendStmt>();
+            x->Chan = get<ast::ExprNode>(c(0));
+            x->Value = get<ast::ExprNode>(c(1));
+            return x;
+        }
+        case NodeKind_DeclStmt: {
+            auto x = std::make_shared<ast::DeclStmt>();
+            x->DeclList = list<ast::DeclNode>(c(0));
+            return x;
+        }
+        case NodeKind_AssignStmt: {
+            auto x = std::make_shared<ast::AssignStmt>();
+            x->Op = v.Sub();
+            x->Lhs = get<ast::ExprNode>(c(0));
+            x->Rhs = get<ast::ExprNode>(c(1));
+            return x;
+        }
+        case NodeKind_BranchStmt: {
+            auto x = std::make_shared<ast::BranchStmt>();
+            x->Tok = v.Sub();
+            x->Label = get<ast::Name>(c(0));
+            return x;
+        }
+        case NodeKind_CallStmt: {
+            auto x = std::make_shared<ast::CallStmt>();
+            x->Tok = v.Sub();
+            x->Call = get<ast::CallExpr>(c(0));
+            return x;
+        }
+        case NodeKind_ReturnStmt: {
+            auto x = std::make_shared<ast::ReturnStmt>();
+            x->Results = get<ast::ExprNode>(c(0));
+            return x;
+        }
+        case NodeKind_IfStmt: {
+            auto x = std::make_shared<ast::IfStmt>();
+            x->Init = get<ast::SimpleStmtNode>(c(0));
+            x->Cond = get<ast::ExprNode>(c(1));
+            x->Then = get<ast::BlockStmt>(c(2));
+            x->Else = get<ast::StmtNode>(c(3));
+            return x;
+        }
+        case NodeKind_ForStmt: {
+            auto x = std::make_shared<ast::ForStmt>();
+            x->Init = get<ast::SimpleStmtNode>(c(0));
+            x->Cond = get<ast::ExprNode>(c(1));
+            x->Post = get<ast::SimpleStmtNode>(c(2));
+            x->Body = get<ast::BlockStmt>(c(3));
+            return x;
+        }
+        case NodeKind_SwitchStmt: {
+            auto x = std::make_shared<ast::SwitchStmt>();
+            x->Init = get<ast::SimpleStmtNode>(c(0));
+            x->Tag = get<ast::ExprNode>(c(1));
+            x->Body = list<ast::CaseClause>(c(2));
+            x->Rbrace = pos(c(3));
+            return x;
+        }
+        case NodeKind_SelectStmt: {
+            auto x = std::make_shared<ast::SelectStmt>();
+            x->Body = list<ast::CommClause>(c(0));
+            x->Rbrace = pos(c(1));
+            return x;
+        }
+        case NodeKind_RangeClause: {
+            auto x = std::make_shared<ast::RangeClause>();
+            x->Lhs = get<ast::ExprNode>(c(0));
+            x->Def = v.Flags() & NodeFlagDef;
+            x->X = get<ast::ExprNode>(c(1));
+            return x;
+        }
+        case NodeKind_CaseClause: {
+            auto x = std::make_shared<ast::CaseClause>();
+            x->Cases = get<ast::ExprNode>(c(0));
+            x->Body = list<ast::StmtNode>(c(1));
+            x->Colon = pos(c(2));
+            return x;
+        }
+        case NodeKind_CommClause: {
+            auto x = std::make_shared<ast::CommClause>();
+            x->Comm = get<ast::SimpleStmtNode>(c(0));
+            x->Body = list<ast::StmtNode>(c(1));
+            x->Colon = pos(c(2));
+            return x;
+        }
+        default:
+            return nullptr; // unreachable: List and Pos are filtered by node
+        }
+    }
+};
+
+// validPacked reports whether the packed elements of the CompositeLit n lie
+// within the data of file and are a whole number of elements.
+bool validPacked(const AstFile *file, const Node *n) {
+    auto data = file->data();
+    if (data == nullptr || n->sub() == 0 || n->sub() > 8 || (n->sub() & (n->sub() - 1)) != 0 ||
+        uint64_t(n->value()) + 4 > data->size()) {
+        return false;
+    }
+    uint64_t size = 0;
+    for (int i = 0; i < 4; i++) {
+        size |= uint64_t(data->Get(n->value() + i)) << (8 * i);
+    }
+    return n->value() + 4 + size <= data->size() && size % n->sub() == 0;
+}
+
+// valid reports whether the tree of file is well-formed: all indices are in
+// range, children precede their parents (so the tree is acyclic), and every
+// node has the number of children of its kind.
+bool valid(const AstFile *file) {
+    auto nodes = file->nodes();
+    auto children = file->children();
+    auto strings = file->strings();
+    if (nodes == nullptr || children == nullptr || strings == nullptr || file->hash() == nullptr ||
+        file->lines() == nullptr) {
+        return false;
+    }
+    if (file->root() >= nodes->size() || nodes->Get(file->root())->kind() != NodeKind_File) {
+        return false;
+    }
+    for (uint32_t i = 0; i < nodes->size(); i++) {
+        auto n = nodes->Get(i);
+        if (n->kind() > NodeKind_MAX) {
+            return false;
+        }
+        if (slots[n->kind()] >= 0 && n->count() != uint32_t(slots[n->kind()])) {
+            return false;
+        }
+        if (uint64_t(n->first()) + n->count() > children->size()) {
+            return false;
+        }
+        for (uint32_t j = 0; j < n->count(); j++) {
+            if (children->Get(n->first() + j) > i) {
+                return false;
+            }
+        }
+        if ((n->kind() == NodeKind_Name || n->kind() == NodeKind_BasicLit) && n->value() >= strings->size()) {
+            return false;
+        }
+        if (n->pos() > file->size() + 1) {
+            return false;
+        }
+        if (n->kind() == NodeKind_CompositeLit && (n->flags() & NodeFlagPacked) && !validPacked(file, n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+std::unique_ptr<CachedFile> CachedFile::Open(const std::string &path) {
+    auto map = common::MappedFile::Open(path);
+    if (map == nullptr) {
+        return nullptr;
+    }
+    auto data = reinterpret_cast<const uint8_t *>(map->Data());
+    flatbuffers::Verifier verifier(data, map->Size());
+    if (!VerifyAstFileBuffer(verifier)) {
+        return nullptr;
+    }
+    auto file = GetAstFile(data);
+    if (file->version() != AstCacheVersion || !valid(file)) {
+        return nullptr;
+    }
+    return std::unique_ptr<CachedFile>(new CachedFile(std::move(map), file));
+}
+
+ast::FilePtr CachedFile::Decode(std::string filename, std::string_view src) const {
+    auto file = FileSet::Global().AddFile(std::move(filename), _file->size());
+    if (file == nullptr) {
+        return nullptr;
+    }
+    for (auto line : *_file->lines()) {
+        file->AddLine(line);
+    }
+    file->AddSource(0, src);
+    decoder d{file};
+    auto nodes = _file->nodes();
+    auto children = _file->children();
+    d.parents.resize(nodes->size());
+    for (uint32_t i = 0; i < nodes->size(); i++) {
+        auto n = nodes->Get(i);
+        for (uint32_t j = 0; j < n->count(); j++) {
+            if (auto c = children->Get(n->first() + j); c != 0 && d.parents[c - 1] < 2) {
+                d.parents[c - 1]++;
+            }
+        }
+    }
+    d.done.resize(nodes->size());
+    d.syms.resize(_file->strings()->size());
+    d.interned.resize(_file->strings()->size());
+    return std::static_pointer_cast<ast::File>(d.node(Root()));
+}
+
+flatbuffers::DetachedBuffer Encode(const ast::File &file, std::string_view hash, uint mode) {
+    encoder e{FileSet::Global().File(file.pos)};
+    auto root = e.node(&file) - 1;
+
+    flatbuffers::FlatBufferBuilder fbb(1024 + e.nodes.size() * sizeof(Node));
+    std::vector<flatbuffers::Offset<flatbuffers::String>> strings;
+    strings.reserve(e.strings.size());
+    for (auto s : e.strings) {
+        strings.push_back(fbb.CreateString(s.data(), s.size()));
+    }
+    auto f = CreateAstFile(fbb, AstCacheVersion, mode,
+                           fbb.CreateVector(reinterpret_cast<const uint8_t *>(hash.data()), hash.size()),
+                           fbb.CreateVectorOfStructs(e.nodes), fbb.CreateVector(e.children), fbb.CreateVector(strings),
+                           root, e.file->Size(), fbb.CreateVector(e.file->Lines().data(), e.file->Lines().size()),
+                           fbb.CreateVector(e.data));
+    FinishAstFileBuffer(fbb, f);
+    return fbb.Release();
+}
+
+AstCache::AstCache(std::string dir) : _dir(std::move(dir)) {}
+
+std::string AstCache::Hash(std::string_view src) { return common::Digest(src); }
+
+std::string AstCache::Path(std::string_view hash, uint mode) const {
+    auto name = common::HexDigest(hash);
+    if (mode != 0) {
+        name += fmt::format("-{:x}", mode);
+    }
+    return _dir + "/" + name + "." + AstFileExtension();
+}
+
+std::unique_ptr<CachedFile> AstCache::Load(std::string_view src, uint mode) const {
+    auto hash = Hash(src);
+    auto f = CachedFile::Open(Path(hash, mode));
+    if (f == nullptr || f->Hash() != hash || f->Mode() != mode) {
+        return nullptr;
+    }
+    return f;
+}
+
+bool AstCache::Store(std::string_view src, const ast::File &file, uint mode) const {
+    static std::atomic<uint64_t> seq{0};
+
+    auto hash = Hash(src);
+    auto buf = Encode(file, hash, mode);
+    std::error_code ec;
+    std::filesystem::create_directories(_dir, ec);
+    auto path = Path(hash, mode);
+    auto tmp = fmt::format("{}.{}.{}.tmp", path, getpid(), seq.fetch_add(1));
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(buf.data()), std::streamsize(buf.size()));
+        if (!out.flush()) {
+            out.close();
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+    return true;
+}
+
+ast::FilePtr ParseCached(const AstCache &cache, std::string_view src, err_handler errh, uint mode,
+                         std::string filename) {
+    if (auto cached = cache.Load(src, mode); cached != nullptr) {
+        if (auto f = cached->Decode(filename, src)) {
+            return f;
+        }
+    }
+    int errors = 0;
+    parser p;
+    p.init(
+        std::make_unique<std::istringstream>(std::string(src)),
+        [&](uint line, uint col, std::string msg) {
+            errors++;
+            if (errh) {
+                errh(line, col, std::move(msg));
+            } else {
+                std::cout << line << ":" << col << ": " << msg << std::endl;
+            }
+        },
+        mode, std::move(filename));
+    auto f = p.fileOrNil();
+    if (f != nullptr && errors == 0) {
+        cache.Store(src, *f, mode);
+    }
+    return f;
+}
+
+} // namespace syntax::cache
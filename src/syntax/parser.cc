@@ -0,0 +1,2454 @@
+#include "syntax/parser.hh"
+
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+#include <tbb/parallel_for.h>
+
+#include "syntax/operator_string.hh"
+#include "syntax/token_string.hh"
+
+namespace syntax
+{
+
+using namespace ast;
+
+// stopset contains keywords that start a statement.
+// They are good synchronization points in case of syntax
+// errors and (usually) shouldn't be skipped over.
+static const uint64_t stopset = 1ul << Token_Break | 1ul << Token_Const | 1ul << Token_Continue |
+                                1ul << Token_Defer | 1ul << Token_Fallthrough | 1ul << Token_For |
+                                1ul << Token_Go | 1ul << Token_Goto | 1ul << Token_If | 1ul << Token_Return |
+                                1ul << Token_Select | 1ul << Token_Switch | 1ul << Token_Type | 1ul << Token_Var;
+
+// Composite literals of integer constants with at least this many elements
+// are packed, see parser::packElems.
+static const size_t packedMinElems = 64;
+
+template <typename T>
+static std::shared_ptr<T> newNode(Pos pos) {
+    auto n = std::make_shared<T>();
+    n->pos = pos;
+    return n;
+}
+
+static NamePtr newName(Pos pos, common::SymbolId sym) {
+    auto n = newNode<ast::Name>(pos);
+    n->Sym = sym;
+    n->Value = common::Interner::Global().Name(sym);
+    return n;
+}
+
+static NamePtr newName(Pos pos, std::string_view value) {
+    return newName(pos, common::Interner::Global().Intern(value));
+}
+
+static ExprNodePtr newIndirect(Pos pos, ExprNodePtr typ) {
+    auto o = newNode<Operation>(pos);
+    o->Op = Operator_Mul;
+    o->X = std::move(typ);
+    return o;
+}
+
+static bool hasPrefix(std::string_view s, std::string_view prefix) { return s.substr(0, prefix.size()) == prefix; }
+
+// tokstring returns the English word for selected punctuation tokens
+// for more readable error messages.
+static std::string tokstring(token tok) {
+    switch (tok) {
+        case Token_Comma:
+            return "comma";
+        case Token_Semi:
+            return "semicolon or newline";
+    }
+    return TokenString(tok);
+}
+
+static bool isEmptyFuncDecl(const DeclNodePtr &d) {
+    auto f = dyn_cast<FuncDecl>(d.get());
+    return f != nullptr && f->Body == nullptr;
+}
+
+// intLitValue stores the value of the well-formed integer literal lit in v.
+// It returns false if the value does not fit in 64 bits.
+static bool intLitValue(std::string_view lit, uint64_t &v) {
+    uint64_t base = 10;
+    if (lit.size() > 1 && lit[0] == '0') {
+        switch (lit[1] | 0x20) {
+            case 'x':
+                base = 16;
+                lit.remove_prefix(2);
+                break;
+            case 'b':
+                base = 2;
+                lit.remove_prefix(2);
+                break;
+            case 'o':
+                base = 8;
+                lit.remove_prefix(2);
+                break;
+            default:
+                base = 8;
+        }
+    }
+    v = 0;
+    for (auto c : lit) {
+        uint64_t d;
+        if (c == '_') {
+            continue;
+        } else if (c >= '0' && c <= '9') {
+            d = c - '0';
+        } else {
+            d = (c | 0x20) - 'a' + 10;
+        }
+        if (v > (UINT64_MAX - d) / base) {
+            return false;
+        }
+        v = v * base + d;
+    }
+    return true;
+}
+
+ExprNodePtr unparen(ExprNodePtr x) {
+    for (;;) {
+        auto p = dyn_cast_or_null<ParenExpr>(x.get());
+        if (p == nullptr) {
+            break;
+        }
+        x = p->X;
+    }
+    return x;
+}
+
+void parser::init(std::string file, err_handler errh, uint mode) {
+    auto in = std::make_unique<std::ifstream>(file, std::ios::binary);
+    if (!in->is_open()) {
+        panic("open file failed: " + file);
+    }
+    init(std::move(in), std::move(errh), mode, std::move(file));
+}
+
+void parser::init(std::unique_ptr<std::istream> in, err_handler errh, uint mode, std::string name) {
+    // The file's position range is reserved up front, so the size of the
+    // input must be known: measure seekable streams, buffer the others.
+    auto start = in->tellg();
+    int64_t size = -1;
+    if (start != std::streampos(-1) && in->seekg(0, std::ios::end)) {
+        size = int64_t(in->tellg() - start);
+        in->seekg(start);
+    }
+    if (size < 0) {
+        in->clear();
+        auto buf = std::make_unique<std::stringstream>();
+        *buf << in->rdbuf();
+        size = int64_t(buf->str().size());
+        in = std::move(buf);
+    }
+    auto file = FileSet::Global().AddFile(std::move(name), size);
+    if (file == nullptr) {
+        // the file is not parsed: fileOrNil returns nil
+        _error_handler = std::move(errh);
+        _first.clear();
+        _errcnt = 0;
+        _file = nullptr;
+        errorAt(1, 1, "too many files: position space exhausted");
+        return;
+    }
+    init(std::move(in), file->At(0), std::move(errh), mode);
+}
+
+void parser::init(std::unique_ptr<std::istream> in, Pos at, err_handler errh, uint mode) {
+    _error_handler = std::move(errh);
+    _first.clear();
+    _errcnt = 0;
+    _fnest = 0;
+    _xnest = 0;
+    _embeds.clear();
+    _embed_line = 0;
+    _embed_col = 0;
+    scanner::init(
+        std::move(in),
+        // Error and directive handler for scanner.
+        // Comments are only reported in directives mode and start with '/'.
+        [this](uint line, uint col, std::string msg) {
+            if (!msg.empty() && msg[0] == '/') {
+                directive(line, col, msg);
+                return;
+            }
+            errorAt(line, col, std::move(msg));
+        },
+        mode);
+    // source counts lines and columns from 0 and offsets from the start of in
+    _file = FileSet::Global().File(at);
+    auto p = _file->Resolve(at);
+    source::_line = p.Line - 1;
+    source::_col = p.Col - 1;
+    source::_base = p.Offset;
+    next();
+}
+
+// ----------------------------------------------------------------------------
+// Error handling
+
+// errorAt reports an error at the given position.
+void parser::errorAt(Pos pos, std::string msg) {
+    auto p = _file->Resolve(pos);
+    errorAt(uint(p.Line), uint(p.Col), std::move(msg));
+}
+
+void parser::errorAt(uint line, uint col, std::string msg) {
+    if (_errcnt == 0) {
+        _first = fmt::format("{}:{}: {}", line, col, msg);
+    }
+    _errcnt++;
+    if (_error_handler) {
+        _error_handler(line, col, std::move(msg));
+        return;
+    }
+    std::cout << line << ":" << col << ": " << msg << std::endl;
+}
+
+// syntaxErrorAt reports a syntax error at the given position.
+void parser::syntaxErrorAt(Pos pos, std::string msg) {
+    if (_tok == Token_EOF && _errcnt > 0) {
+        return; // avoid meaningless follow-up errors
+    }
+
+    // add punctuation etc. as needed to msg
+    if (msg.empty()) {
+        // nothing to do
+    } else if (hasPrefix(msg, "in ") || hasPrefix(msg, "at ") || hasPrefix(msg, "after ")) {
+        msg = " " + msg;
+    } else if (hasPrefix(msg, "expecting ")) {
+        msg = ", " + msg;
+    } else {
+        // plain error - we don't care about current token
+        errorAt(pos, "syntax error: " + msg);
+        return;
+    }
+
+    // determine token string
+    std::string tok;
+    switch (_tok) {
+        case Token_Name:
+            tok = common::Interner::Global().Name(_sym);
+            break;
+        case Token_Semi:
+            tok = _lit;
+            break;
+        case Token_Literal:
+            tok = "literal " + _lit;
+            break;
+        case Token_Operator:
+            tok = OperatorString(_op);
+            break;
+        case Token_AssignOp:
+            tok = OperatorString(_op) + "=";
+            break;
+        case Token_IncOp:
+            tok = OperatorString(_op);
+            tok += tok;
+            break;
+        default:
+            tok = tokstring(_tok);
+    }
+
+    errorAt(pos, "syntax error: unexpected " + tok + msg);
+}
+
+// advance consumes tokens until it finds a token of the stopset or followlist.
+// The stopset is only considered if we are inside a function (_fnest > 0).
+// The followlist is the list of valid tokens that can follow a production;
+// if it is empty, exactly one (non-EOF) token is consumed to ensure progress.
+void parser::advance(std::initializer_list<token> followlist) {
+    // compute follow set
+    // (not speed critical, advance is only called in error situations)
+    uint64_t followset = 1ul << Token_EOF; // don't skip over EOF
+    if (followlist.size() > 0) {
+        if (_fnest > 0) {
+            followset |= stopset;
+        }
+        for (auto tok : followlist) {
+            followset |= 1ul << tok;
+        }
+    }
+
+    while (!contains(followset, _tok)) {
+        next();
+        if (followlist.size() == 0) {
+            break;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Directives
+
+// directive interprets the comment text at line:col reported by the scanner.
+// Only //go:embed is recognized; its patterns are kept until the next var
+// declaration takes them.
+void parser::directive(uint line, uint col, std::string_view text) {
+    std::string_view prefix = "//go:embed";
+    if (!hasPrefix(text, prefix) || (text.size() > prefix.size() && text[prefix.size()] != ' ' &&
+                                     text[prefix.size()] != '\t')) {
+        return;
+    }
+    clearEmbeds(); // an earlier directive was not followed by a var declaration
+    std::vector<std::string> patterns;
+    if (!ParseGoEmbed(text.substr(prefix.size()), patterns)) {
+        errorAt(line, col, fmt::format("invalid quoted string in {}", text));
+        return;
+    }
+    if (patterns.empty()) {
+        errorAt(line, col, "usage: //go:embed pattern...");
+        return;
+    }
+    _embeds = std::move(patterns);
+    _embed_line = line;
+    _embed_col = col;
+}
+
+std::vector<std::string> parser::takeEmbeds() { return std::exchange(_embeds, {}); }
+
+// clearEmbeds reports a pending //go:embed directive as misplaced.
+void parser::clearEmbeds() {
+    if (!_embeds.empty()) {
+        errorAt(_embed_line, _embed_col, "misplaced compiler directive");
+        _embeds.clear();
+    }
+}
+
+bool parser::got(token tok) {
+    if (_tok == tok) {
+        next();
+        return true;
+    }
+    return false;
+}
+
+void parser::want(token tok) {
+    if (!got(tok)) {
+        syntaxError("expecting " + tokstring(tok));
+        advance();
+    }
+}
+
+// gotAssign is like got(Token_Assign) but it also accepts ":="
+// (and reports an error) for better parser error recovery.
+bool parser::gotAssign() {
+    switch (_tok) {
+        case Token_Define:
+            syntaxError("expecting =");
+            [[fallthrough]];
+        case Token_Assign:
+            next();
+            return true;
+    }
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// Source files
+//
+// Parse methods are annotated with matching Go productions as appropriate.
+// The annotations are intended as guidelines only since a single Go grammar
+// rule may be covered by multiple parse methods and vice versa.
+//
+// Excluding methods returning slices, parse methods named xOrNil may return
+// nil; all others are expected to return a valid non-nil node.
+
+// SourceFile = PackageClause ";" { ImportDecl ";" } { TopLevelDecl ";" } .
+FilePtr parser::fileOrNil() {
+    if (_file == nullptr) {
+        return nullptr; // not added to the file set
+    }
+    auto start = _offset;
+    auto f = newNode<File>(pos());
+
+    // PackageClause
+    if (!got(Token_Package)) {
+        syntaxError("package statement must be first");
+        return nullptr;
+    }
+    f->PkgName = name();
+    want(Token_Semi);
+
+    // don't bother continuing if package clause has errors
+    if (_errcnt > 0) {
+        return nullptr;
+    }
+
+    // { ImportDecl ";" }
+    while (got(Token_Import)) {
+        appendGroup(f->DeclList, &parser::importDecl);
+        want(Token_Semi);
+    }
+    if (_mode & ImportsOnly) {
+        f->Eof = pos();
+        return span(f, start);
+    }
+
+    // { TopLevelDecl ";" }
+    while (_tok != Token_EOF) {
+        auto dstart = _offset;
+        switch (_tok) {
+            case Token_Const:
+                next();
+                appendGroup(f->DeclList, &parser::constDecl);
+                break;
+            case Token_Type:
+                next();
+                appendGroup(f->DeclList, &parser::typeDecl);
+                break;
+            case Token_Var:
+                next();
+                appendGroup(f->DeclList, &parser::varDecl);
+                break;
+            case Token_Func: {
+                next();
+                if (auto d = funcDeclOrNil()) {
+                    f->DeclList.push_back(span(std::move(d), dstart));
+                }
+                break;
+            }
+            default:
+                if (_tok == Token_Lbrace && !f->DeclList.empty() && isEmptyFuncDecl(f->DeclList.back())) {
+                    // opening { of function declaration on next line
+                    syntaxError("unexpected semicolon or newline before {");
+                } else {
+                    syntaxError("non-declaration statement outside function body");
+                }
+                advance({Token_Const, Token_Type, Token_Var, Token_Func});
+                continue;
+        }
+
+        if (_tok != Token_EOF && !got(Token_Semi)) {
+            syntaxError("after top level declaration");
+            advance({Token_Const, Token_Type, Token_Var, Token_Func});
+        }
+    }
+    // _tok == Token_EOF
+    clearEmbeds();
+
+    f->Eof = pos();
+    return span(f, start);
+}
+
+// list parses a possibly empty, sep-separated list of elements, optionally
+// followed by sep, and closed by close (or EOF). sep must be one of Token_Comma
+// or Token_Semi, and close must be one of Token_Rparen, Token_Rbrace, or Token_Rbrack.
+//
+// For each list element, f is called. Specifically, unless we're at close
+// (or EOF), f is called at least once. After f returns true, no more list
+// elements are accepted. list returns the position of the closing token.
+template <typename F>
+Pos parser::list(token sep, token close, F f) {
+    auto done = false;
+    while (_tok != Token_EOF && _tok != close && !done) {
+        done = f();
+        // sep is optional before close
+        if (!got(sep) && _tok != close) {
+            syntaxError(fmt::format("expecting {} or {}", tokstring(sep), tokstring(close)));
+            advance({Token_Rparen, Token_Rbrack, Token_Rbrace});
+            if (_tok != close) {
+                // position could be better but we had an error so we don't care
+                return pos();
+            }
+        }
+    }
+
+    auto p = pos();
+    want(close);
+    return p;
+}
+
+// appendGroup(f) = f | "(" { f ";" } ")" . // ";" is optional before ")"
+void parser::appendGroup(std::vector<DeclNodePtr> &list, DeclNodePtr (parser::*f)(GroupPtr)) {
+    if (_tok == Token_Lparen) {
+        auto g = std::make_shared<Group>();
+        clearEmbeds();
+        next(); // must consume "(" after calling clearEmbeds
+
+        this->list(Token_Semi, Token_Rparen, [&] {
+            auto start = _offset;
+            if (auto x = (this->*f)(g)) {
+                list.push_back(span(std::move(x), start));
+            }
+            return false;
+        });
+    } else {
+        auto start = _offset;
+        if (auto x = (this->*f)(nullptr)) {
+            list.push_back(span(std::move(x), start));
+        }
+    }
+}
+
+// ImportSpec = [ "." | PackageName ] ImportPath .
+// ImportPath = string_lit .
+DeclNodePtr parser::importDecl(GroupPtr group) {
+    clearEmbeds();
+    auto d = newNode<ImportDecl>(pos());
+    d->Group = std::move(group);
+
+    switch (_tok) {
+        case Token_Name:
+            d->LocalPkgName = name();
+            break;
+        case Token_Dot:
+            d->LocalPkgName = newName(pos(), ".");
+            next();
+            break;
+    }
+    d->Path = oliteral();
+    if (d->Path == nullptr) {
+        syntaxError("missing import path");
+        advance({Token_Semi, Token_Rparen});
+        return d;
+    }
+    if (!d->Path->Bad && d->Path->Kind != StringLit) {
+        syntaxError("import path must be a string");
+        d->Path->Bad = true;
+    }
+    // d->Path->Bad || d->Path->Kind == StringLit
+
+    return d;
+}
+
+// ConstSpec = IdentifierList [ [ Type ] "=" ExpressionList ] .
+DeclNodePtr parser::constDecl(GroupPtr group) {
+    clearEmbeds();
+    auto d = newNode<ConstDecl>(pos());
+    d->Group = std::move(group);
+
+    d->NameList = nameList(name());
+    if (_tok != Token_EOF && _tok != Token_Semi && _tok != Token_Rparen) {
+        d->Type = typeOrNil();
+        if (gotAssign()) {
+            d->Values = exprList();
+        }
+    }
+
+    return d;
+}
+
+// TypeSpec = identifier [ "=" ] Type .
+DeclNodePtr parser::typeDecl(GroupPtr group) {
+    clearEmbeds();
+    auto d = newNode<TypeDecl>(pos());
+    d->Group = std::move(group);
+
+    d->Name = name();
+    d->Alias = gotAssign();
+    d->Type = typeOrNil();
+    if (d->Type == nullptr) {
+        d->Type = badExpr();
+        syntaxError("in type declaration");
+        advance({Token_Semi, Token_Rparen});
+    }
+
+    return d;
+}
+
+// VarSpec = IdentifierList ( Type [ "=" ExpressionList ] | "=" ExpressionList ) .
+DeclNodePtr parser::varDecl(GroupPtr group) {
+    auto d = newNode<VarDecl>(pos());
+    d->Group = std::move(group);
+    auto line = _embed_line, col = _embed_col;
+    d->EmbedPatterns = takeEmbeds();
+
+    d->NameList = nameList(name());
+    if (gotAssign()) {
+        d->Values = exprList();
+    } else {
+        d->Type = type_();
+        if (gotAssign()) {
+            d->Values = exprList();
+        }
+    }
+
+    if (!d->EmbedPatterns.empty()) {
+        if (_fnest > 0) {
+            errorAt(line, col, "go:embed cannot apply to var inside func");
+        } else if (d->NameList.size() > 1) {
+            errorAt(line, col, "go:embed cannot apply to multiple vars");
+        } else if (d->Values != nullptr) {
+            errorAt(line, col, "go:embed cannot apply to var with initializer");
+        }
+    }
+
+    return d;
+}
+
+// FunctionDecl = "func" FunctionName [ TypeParameters ] Signature [ FunctionBody ] .
+// MethodDecl   = "func" Receiver MethodName Signature [ FunctionBody ] .
+// Receiver     = Parameters .
+std::shared_ptr<FuncDecl> parser::funcDeclOrNil() {
+    clearEmbeds();
+    auto f = newNode<FuncDecl>(pos());
+
+    if (got(Token_Lparen)) {
+        auto rcvr = paramList();
+        switch (rcvr.size()) {
+            case 0:
+                error("method has no receiver");
+                break;
+            default:
+                error("method has multiple receivers");
+                [[fallthrough]];
+            case 1:
+                f->Recv = rcvr[0];
+        }
+    }
+
+    if (_tok != Token_Name) {
+        syntaxError("expecting name or (");
+        advance({Token_Lbrace, Token_Semi});
+        return nullptr;
+    }
+
+    f->Name = name();
+    if (got(Token_Lbrack)) {
+        if (f->Recv != nullptr) {
+            syntaxError("method must have no type parameters");
+        }
+        f->TParamList = typeParamList();
+    }
+    f->Type = funcType();
+    if (_tok == Token_Lbrace) {
+        if (_mode & SkipFuncBodies) {
+            skipFuncBody(f.get());
+        } else {
+            f->Body = funcBody();
+        }
+    }
+
+    return f;
+}
+
+BlockStmtPtr parser::funcBody() {
+    _fnest++;
+    auto body = blockStmt("");
+    _fnest--;
+    return body;
+}
+
+// skipFuncBody consumes the body of f by matching braces on the token
+// stream and records its extent for a later ParseFuncBody.
+void parser::skipFuncBody(FuncDecl *f) {
+    f->BodyLbrace = pos();
+    int depth = 0;
+    for (;;) {
+        switch (_tok) {
+            case Token_Lbrace:
+                depth++;
+                break;
+            case Token_Rbrace:
+                depth--;
+                break;
+            case Token_EOF:
+                f->BodyRbrace = pos();
+                syntaxError("expecting }");
+                return;
+        }
+        if (depth == 0) {
+            break;
+        }
+        next();
+    }
+    f->BodyRbrace = pos();
+    next();
+}
+
+// ----------------------------------------------------------------------------
+// Expressions
+
+ExprNodePtr parser::expr() { return binaryExpr(nullptr, 0); }
+
+// Expression = UnaryExpr | Expression binary_op Expression .
+// If x is not nil, it is the already parsed first operand.
+ExprNodePtr parser::binaryExpr(ExprNodePtr x, int64_t prec) {
+    // don't trace binaryExpr - only leads to overly nested trace output
+
+    auto start = x != nullptr ? _file->Offset(x->span.Start) : _offset;
+    if (x == nullptr) {
+        x = unaryExpr();
+    }
+    while ((_tok == Token_Operator || _tok == Token_Star) && _prec > prec) {
+        auto t = newNode<Operation>(pos());
+        t->Op = _op;
+        auto tprec = _prec;
+        next();
+        t->X = std::move(x);
+        t->Y = binaryExpr(nullptr, tprec);
+        x = span(std::move(t), start);
+    }
+    return x;
+}
+
+// UnaryExpr = PrimaryExpr | unary_op UnaryExpr .
+ExprNodePtr parser::unaryExpr() {
+    auto start = _offset;
+    switch (_tok) {
+        case Token_Operator:
+        case Token_Star:
+            switch (_op) {
+                case Operator_Mul:
+                case Operator_Add:
+                case Operator_Sub:
+                case Operator_Not:
+                case Operator_Xor:
+                case Operator_Tilde: {
+                    auto x = newNode<Operation>(pos());
+                    x->Op = _op;
+                    next();
+                    x->X = unaryExpr();
+                    return span(x, start);
+                }
+                case Operator_And: {
+                    auto x = newNode<Operation>(pos());
+                    x->Op = Operator_And;
+                    next();
+                    // unaryExpr may have returned a parenthesized composite literal
+                    // (see comment in operand) - remove parentheses if any
+                    x->X = unparen(unaryExpr());
+                    return span(x, start);
+                }
+            }
+            break;
+
+        case Token_Arrow: {
+            auto p = pos();
+            next();
+
+            // If the next token is Token_Chan we still don't know if it is
+            // a channel (<-chan int) or a receive op (<-chan int(ch)).
+            // We only know once we have found the end of the unaryExpr.
+
+            auto x = unaryExpr();
+
+            if (isa<ChanType>(x)) {
+                // x is a channel type => re-associate <-
+                ChanDir dir = SendOnly;
+                auto t = x;
+                while (dir == SendOnly) {
+                    auto c = dyn_cast<ChanType>(t.get());
+                    if (c == nullptr) {
+                        break;
+                    }
+                    dir = c->Dir;
+                    if (dir == RecvOnly) {
+                        // t is type <-chan E but <-<-chan E is not permitted
+                        // (report same error as for "type _ <-<-chan E")
+                        syntaxError("unexpected <-, expecting chan");
+                        // already progressed, no need to advance
+                    }
+                    c->Dir = RecvOnly;
+                    t = c->Elem;
+                }
+                if (dir == SendOnly) {
+                    // channel dir is <- but channel element E is not a channel
+                    // (report same error as for "type _ <-chan<-E")
+                    syntaxError(fmt::format("unexpected {}, expecting chan", String(t.get())));
+                    // already progressed, no need to advance
+                }
+                // the type now starts at the leading <-
+                x->span = {};
+                return span(x, start);
+            }
+
+            // x is not a channel type => we have a receive op
+            auto o = newNode<Operation>(p);
+            o->Op = Operator_Recv;
+            o->X = std::move(x);
+            return span(o, start);
+        }
+    }
+
+    // TODO(gri) We need parens here so we can report an
+    // error for "(x) := true". It should be possible to detect
+    // and reject that more efficiently though.
+    return pexpr(nullptr, true);
+}
+
+// callStmt parses call-like statements that can be preceded by 'defer' and 'go'.
+std::shared_ptr<CallStmt> parser::callStmt() {
+    auto s = newNode<CallStmt>(pos());
+    s->Tok = _tok; // Token_Defer or Token_Go
+    next();
+
+    auto x = pexpr(nullptr, _tok == Token_Lparen); // keep_parens so we can report error below
+    if (auto t = unparen(x); t != x) {
+        errorAt(x->pos, fmt::format("expression in {} must not be parenthesized", TokenString(s->Tok)));
+        // already progressed, no need to advance
+        x = t;
+    }
+
+    auto cx = dyn_cast<CallExpr>(x);
+    if (cx == nullptr) {
+        errorAt(x->pos, fmt::format("expression in {} must be function call", TokenString(s->Tok)));
+        // already progressed, no need to advance
+        cx = newNode<CallExpr>(x->pos);
+        cx->Fun = x; // assume common error of missing parentheses (function invocation)
+    }
+
+    s->Call = std::move(cx);
+    return s;
+}
+
+// Operand     = Literal | OperandName | MethodExpr | "(" Expression ")" .
+// Literal     = BasicLit | CompositeLit | FunctionLit .
+// BasicLit    = int_lit | float_lit | imaginary_lit | rune_lit | string_lit .
+// OperandName = identifier | QualifiedIdent.
+ExprNodePtr parser::operand(bool keep_parens) {
+    switch (_tok) {
+        case Token_Name:
+            return name();
+
+        case Token_Literal:
+            return oliteral();
+
+        case Token_Lparen: {
+            auto px = newNode<ParenExpr>(pos());
+            next();
+            _xnest++;
+            px->X = expr();
+            _xnest--;
+            want(Token_Rparen);
+
+            // Unlike cmd/compile we always record the parentheses so that
+            // String reproduces the source; the cost is one node per pair.
+            // Parentheses are not permitted around T in a composite literal
+            // T{}, nor around the expression in a go/defer statement (in
+            // which case operand is called with keep_parens set); both are
+            // diagnosed by the caller via unparen.
+            (void)keep_parens;
+            return px;
+        }
+
+        case Token_Func: {
+            auto p = pos();
+            next();
+            auto ftyp = funcType();
+            if (_tok == Token_Lbrace) {
+                _xnest++;
+
+                auto f = newNode<FuncLit>(p);
+                f->Type = std::move(ftyp);
+                f->Body = funcBody();
+
+                _xnest--;
+                return f;
+            }
+            return ftyp;
+        }
+
+        case Token_Lbrack:
+        case Token_Chan:
+        case Token_Map:
+        case Token_Struct:
+        case Token_Interface:
+            return type_(); // othertype
+
+        default: {
+            auto x = badExpr();
+            syntaxError("expecting expression");
+            advance({Token_Rparen, Token_Rbrack, Token_Rbrace});
+            return x;
+        }
+    }
+}
+
+// PrimaryExpr =
+// 	Operand |
+// 	Conversion |
+// 	PrimaryExpr Selector |
+// 	PrimaryExpr Index |
+// 	PrimaryExpr Slice |
+// 	PrimaryExpr TypeAssertion |
+// 	PrimaryExpr Arguments .
+//
+// Selector       = "." identifier .
+// Index          = "[" Expression "]" .
+// Slice          = "[" ( [ Expression ] ":" [ Expression ] ) |
+//                      ( [ Expression ] ":" Expression ":" Expression )
+//                  "]" .
+// TypeAssertion  = "." "(" Type ")" .
+// Arguments      = "(" [ ( ExpressionList | Type [ "," ExpressionList ] ) [ "..." ] [ "," ] ] ")" .
+//
+// If x is not nil, it is the already parsed operand.
+ExprNodePtr parser::pexpr(ExprNodePtr x, bool keep_parens) {
+    auto start = x != nullptr ? _file->Offset(x->span.Start) : _offset;
+    if (x == nullptr) {
+        x = operand(keep_parens);
+    }
+
+    for (;;) {
+        // x is complete: it is the operand or the node built in the
+        // previous iteration
+        x = span(std::move(x), start);
+        auto p = pos();
+        switch (_tok) {
+            case Token_Dot: {
+                next();
+                switch (_tok) {
+                    case Token_Name: {
+                        // pexpr '.' sym
+                        auto t = newNode<SelectorExpr>(p);
+                        t->X = std::move(x);
+                        t->Sel = name();
+                        x = std::move(t);
+                        break;
+                    }
+                    case Token_Lparen:
+                        next();
+                        if (got(Token_Type)) {
+                            auto t = newNode<TypeSwitchGuard>(p);
+                            // t->Lhs is filled in by parser::simpleStmt
+                            t->X = std::move(x);
+                            x = std::move(t);
+                        } else {
+                            auto t = newNode<AssertExpr>(p);
+                            t->X = std::move(x);
+                            t->Type = type_();
+                            x = std::move(t);
+                        }
+                        want(Token_Rparen);
+                        break;
+
+                    default:
+                        syntaxError("expecting name or (");
+                        advance({Token_Semi, Token_Rparen});
+                }
+                continue;
+            }
+
+            case Token_Lbrack: {
+                next();
+                _xnest++;
+
+                ExprNodePtr i;
+                if (_tok != Token_Colon) {
+                    i = expr();
+                    if (_tok == Token_Comma) {
+                        // x[T1, T2, ...], an instantiation
+                        auto l = newNode<ListExpr>(i->pos);
+                        l->ElemList.push_back(std::move(i));
+                        while (got(Token_Comma) && _tok != Token_Rbrack) {
+                            l->ElemList.push_back(expr());
+                        }
+                        i = std::move(l);
+                        want(Token_Rbrack);
+                        auto t = newNode<IndexExpr>(p);
+                        t->X = std::move(x);
+                        t->Index = std::move(i);
+                        x = std::move(t);
+                        _xnest--;
+                        continue;
+                    }
+                    if (got(Token_Rbrack)) {
+                        // x[i]
+                        auto t = newNode<IndexExpr>(p);
+                        t->X = std::move(x);
+                        t->Index = std::move(i);
+                        x = std::move(t);
+                        _xnest--;
+                        continue;
+                    }
+                }
+
+                // x[i:...
+                auto t = newNode<SliceExpr>(p);
+                t->X = std::move(x);
+                t->Index[0] = std::move(i);
+                want(Token_Colon);
+                if (_tok != Token_Colon && _tok != Token_Rbrack) {
+                    // x[i:j...
+                    t->Index[1] = expr();
+                }
+                if (got(Token_Colon)) {
+                    t->Full = true;
+                    // x[i:j:...]
+                    if (t->Index[1] == nullptr) {
+                        error("middle index required in 3-index slice");
+                    }
+                    if (_tok != Token_Rbrack) {
+                        // x[i:j:k...
+                        t->Index[2] = expr();
+                    } else {
+                        error("final index required in 3-index slice");
+                    }
+                }
+                want(Token_Rbrack);
+
+                x = std::move(t);
+                _xnest--;
+                continue;
+            }
+
+            case Token_Lparen: {
+                auto t = newNode<CallExpr>(p);
+                next();
+                t->Fun = std::move(x);
+                t->ArgList = argList(t->HasDots);
+                x = std::move(t);
+                continue;
+            }
+
+            case Token_Lbrace: {
+                // operand may have returned a parenthesized complit
+                // type; accept it but complain if we have a complit
+                auto t = unparen(x);
+                // determine if '{' belongs to a composite literal or a block statement
+                auto complit_ok = false;
+                if (isa<ast::Name>(t) || isa<SelectorExpr>(t)) {
+                    if (_xnest >= 0) {
+                        // x is possibly a composite literal type
+                        complit_ok = true;
+                    }
+                } else if (isa<ArrayType>(t) || isa<SliceType>(t) || isa<StructType>(t) || isa<MapType>(t)) {
+                    // x is a comptype
+                    complit_ok = true;
+                }
+                if (!complit_ok) {
+                    return x;
+                }
+                if (t != x) {
+                    syntaxError("cannot parenthesize type in composite literal");
+                    // already progressed, no need to advance
+                }
+                auto n = complitexpr(t.get());
+                n->Type = std::move(x);
+                x = std::move(n);
+                continue;
+            }
+
+            default:
+                return x;
+        }
+    }
+}
+
+// Element = Expression | LiteralValue .
+ExprNodePtr parser::bare_complitexpr() {
+    if (_tok == Token_Lbrace) {
+        // '{' start_complit braced_keyval_list '}'
+        auto start = _offset;
+        return span(complitexpr(), start);
+    }
+
+    return expr();
+}
+
+// LiteralValue = "{" [ ElementList [ "," ] ] "}" .
+// typ is the literal type, or nil if it is elided.
+std::shared_ptr<CompositeLit> parser::complitexpr(const ExprNode *typ) {
+    auto x = newNode<CompositeLit>(pos());
+
+    _xnest++;
+    want(Token_Lbrace);
+    ExprNodePtr lit;
+    if (uint64_t max; typ != nullptr && _tok == Token_Literal) {
+        if (auto size = packedElemSize(typ, max)) {
+            lit = packElems(x.get(), size, max);
+        }
+    }
+    x->Rbrace = list(Token_Comma, Token_Rbrace, [&] {
+        // value
+        auto start = _offset;
+        ExprNodePtr e;
+        if (lit != nullptr) {
+            // continue the expression starting with the literal left
+            // over by packElems
+            start = _file->Offset(lit->span.Start);
+            e = binaryExpr(pexpr(std::move(lit), false), 0);
+        } else {
+            e = bare_complitexpr();
+        }
+        if (_tok == Token_Colon) {
+            // key ':' value
+            auto l = newNode<KeyValueExpr>(pos());
+            next();
+            l->Key = std::move(e);
+            auto vstart = _offset;
+            if (_tok == Token_Lbrace) {
+                l->Value = span(complitexpr(), vstart);
+            } else {
+                l->Value = expr();
+            }
+            e = span(std::move(l), start);
+            x->NKeys++;
+        }
+        x->ElemList.push_back(std::move(e));
+        return false;
+    });
+    _xnest--;
+    return x;
+}
+
+// packedElemSize returns the size of the elements of the literal type typ
+// if it is a slice or array of a predeclared integer type, and stores
+// their maximum value in max. It returns 0 otherwise.
+int parser::packedElemSize(const ExprNode *typ, uint64_t &max) {
+    ExprNode *elem = nullptr;
+    if (auto t = dyn_cast<SliceType>(typ)) {
+        elem = t->Elem.get();
+    } else if (auto t = dyn_cast<ArrayType>(typ)) {
+        elem = t->Elem.get();
+    }
+    auto name = dyn_cast_or_null<ast::Name>(elem);
+    if (name == nullptr) {
+        return 0;
+    }
+    static const std::unordered_map<std::string_view, std::pair<int, uint64_t>> sizes = {
+        {"byte", {1, UINT8_MAX}},     {"uint8", {1, UINT8_MAX}},   {"int8", {1, INT8_MAX}},
+        {"uint16", {2, UINT16_MAX}},  {"int16", {2, INT16_MAX}},   {"uint32", {4, UINT32_MAX}},
+        {"int32", {4, INT32_MAX}},    {"rune", {4, INT32_MAX}},    {"uint64", {8, UINT64_MAX}},
+        {"int64", {8, INT64_MAX}},    {"uint", {8, UINT64_MAX}},   {"int", {8, INT64_MAX}},
+        {"uintptr", {8, UINT64_MAX}},
+    };
+    auto it = sizes.find(name->Value);
+    if (it == sizes.end()) {
+        return 0;
+    }
+    max = it->second.second;
+    return it->second.first;
+}
+
+// packElems is the fast path for literals such as []byte{0x1f, 0x8b, ...}
+// in generated code: it consumes the leading elements of x that are
+// integer literals fitting in size bytes without creating a node per
+// element. If all elements are such literals and there are at least
+// packedMinElems of them, they are stored in x->Packed. Otherwise the
+// consumed elements are added to x->ElemList; if the last consumed
+// literal does not end its element, e.g. in {1, 2 << 8}, it is returned
+// for the caller to continue parsing the element.
+//
+// The fast path never backtracks: the nodes of consumed elements are
+// rebuilt from the pinned source (see rescanElems).
+ExprNodePtr parser::packElems(CompositeLit *x, int size, uint64_t max) {
+    auto first = _offset;
+    auto end = first; // end of the last element packed
+    auto packed = std::make_shared<PackedElems>();
+    packed->ElemSize = uint8_t(size);
+    while (_tok == Token_Literal) {
+        uint64_t v;
+        if (_kind != IntLit || _bad || !intLitValue(_lit, v) || v > max) {
+            break;
+        }
+        auto lit = _offset;
+        auto p = pos();
+        next();
+        if (_tok != Token_Comma && _tok != Token_Rbrace) {
+            rescanElems(x, first, end);
+            auto b = newNode<BasicLit>(p);
+            b->Value = std::string(_file->Source().substr(lit, _prev_end - lit));
+            b->Kind = IntLit;
+            return span(b, lit);
+        }
+        for (int i = 0; i < size; i++) {
+            packed->Data.push_back(uint8_t(v >> (8 * i)));
+        }
+        end = _prev_end;
+        if (!got(Token_Comma)) {
+            break;
+        }
+    }
+    if (_tok != Token_Rbrace || packed->Len() < packedMinElems) {
+        rescanElems(x, first, end);
+        return nullptr;
+    }
+    packed->Data.shrink_to_fit();
+    x->Packed = std::move(packed);
+    return nullptr;
+}
+
+// rescanElems appends a BasicLit to x->ElemList for each literal in the
+// source between the offsets from and to, which was consumed by packElems.
+void parser::rescanElems(CompositeLit *x, int64_t from, int64_t to) {
+    if (to <= from) {
+        return;
+    }
+    scanner s;
+    s.init(std::make_unique<std::istringstream>(std::string(_file->Source().substr(from, to - from))), nullptr, 0);
+    s.next();
+    for (; s._tok != Token_EOF; s.next()) {
+        if (s._tok != Token_Literal) {
+            continue;
+        }
+        auto b = newNode<BasicLit>(_file->At(from + s._offset));
+        b->Value = s._lit;
+        b->Kind = s._kind;
+        b->span = {b->pos, uint32_t(s._lit.size())};
+        x->ElemList.push_back(std::move(b));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Types
+
+ExprNodePtr parser::type_() {
+    auto typ = typeOrNil();
+    if (typ == nullptr) {
+        typ = badExpr();
+        syntaxError("expecting type");
+        advance({Token_Comma, Token_Colon, Token_Semi, Token_Rparen, Token_Rbrack, Token_Rbrace});
+    }
+
+    return typ;
+}
+
+// typeOrNil is like type_ but it returns nil if there was no type
+// instead of reporting an error.
+//
+// Type     = TypeName | TypeLit | "(" Type ")" .
+// TypeName = identifier | QualifiedIdent .
+// TypeLit  = ArrayType | StructType | PointerType | FunctionType | InterfaceType |
+// 	      SliceType | MapType | Channel_Type .
+ExprNodePtr parser::typeOrNil() {
+    auto start = _offset;
+    auto p = pos();
+    switch (_tok) {
+        case Token_Star:
+            // ptrtype
+            next();
+            return span(newIndirect(p, type_()), start);
+
+        case Token_Arrow: {
+            // recvchantype
+            next();
+            want(Token_Chan);
+            auto t = newNode<ChanType>(p);
+            t->Dir = RecvOnly;
+            t->Elem = chanElem();
+            return span(t, start);
+        }
+
+        case Token_Func:
+            // fntype
+            next();
+            return span(funcType(), start);
+
+        case Token_Lbrack: {
+            // '[' oexpr ']' ntype
+            // '[' _DotDotDot ']' ntype
+            next();
+            _xnest++;
+            if (got(Token_Rbrack)) {
+                // []T
+                _xnest--;
+                auto t = newNode<SliceType>(p);
+                t->Elem = type_();
+                return span(t, start);
+            }
+
+            // [n]T
+            auto t = newNode<ArrayType>(p);
+            if (!got(Token_DotDotDot)) {
+                t->Len = expr();
+            }
+            want(Token_Rbrack);
+            _xnest--;
+            t->Elem = type_();
+            return span(t, start);
+        }
+
+        case Token_Chan: {
+            // _Chan non_recvchantype
+            // _Chan _Comm ntype
+            next();
+            auto t = newNode<ChanType>(p);
+            if (got(Token_Arrow)) {
+                t->Dir = SendOnly;
+            }
+            t->Elem = chanElem();
+            return span(t, start);
+        }
+
+        case Token_Map: {
+            // _Map '[' ntype ']' ntype
+            next();
+            want(Token_Lbrack);
+            auto t = newNode<MapType>(p);
+            t->Key = type_();
+            want(Token_Rbrack);
+            t->Value = type_();
+            return span(t, start);
+        }
+
+        case Token_Struct:
+            return span(structType(), start);
+
+        case Token_Interface:
+            return span(interfaceType(), start);
+
+        case Token_Name:
+            return span(dotname(name()), start);
+
+        case Token_Lparen: {
+            next();
+            auto t = newNode<ParenExpr>(p);
+            t->X = type_();
+            want(Token_Rparen);
+            return span(t, start);
+        }
+    }
+
+    return nullptr;
+}
+
+ExprNodePtr parser::chanElem() {
+    auto typ = typeOrNil();
+    if (typ == nullptr) {
+        typ = badExpr();
+        syntaxError("missing channel element type");
+        // assume element type is simply absent - don't advance
+    }
+
+    return typ;
+}
+
+ExprNodePtr parser::dotname(NamePtr name) {
+    if (_tok == Token_Dot) {
+        auto start = _file->Offset(name->span.Start);
+        auto s = newNode<SelectorExpr>(pos());
+        next();
+        s->X = std::move(name);
+        s->Sel = this->name();
+        return span(s, start);
+    }
+    return name;
+}
+
+// FunctionType = "func" Signature .
+// Signature    = Parameters [ Result ] .
+FuncTypePtr parser::funcType() {
+    auto typ = newNode<FuncType>(pos());
+    want(Token_Lparen);
+    typ->ParamList = paramList();
+    typ->ResultList = funcResult();
+
+    return typ;
+}
+
+// Result = Parameters | Type .
+std::vector<FieldPtr> parser::funcResult() {
+    if (got(Token_Lparen)) {
+        return paramList();
+    }
+
+    auto p = pos();
+    if (auto typ = typeOrNil()) {
+        auto f = newNode<Field>(p);
+        f->Type = std::move(typ);
+        return {f};
+    }
+
+    return {};
+}
+
+// StructType = "struct" "{" { FieldDecl ";" } "}" .
+ExprNodePtr parser::structType() {
+    auto typ = newNode<StructType>(pos());
+
+    want(Token_Struct);
+    want(Token_Lbrace);
+    list(Token_Semi, Token_Rbrace, [&] {
+        fieldDecl(typ.get());
+        return false;
+    });
+
+    return typ;
+}
+
+// InterfaceType = "interface" "{" { MethodSpec ";" } "}" .
+ExprNodePtr parser::interfaceType() {
+    auto typ = newNode<InterfaceType>(pos());
+
+    want(Token_Interface);
+    want(Token_Lbrace);
+    list(Token_Semi, Token_Rbrace, [&] {
+        if (auto m = methodDecl()) {
+            typ->MethodList.push_back(std::move(m));
+        }
+        return false;
+    });
+
+    return typ;
+}
+
+void parser::addField(StructType *styp, Pos pos, NamePtr name, ExprNodePtr typ, BasicLitPtr tag) {
+    if (tag != nullptr) {
+        for (auto i = styp->FieldList.size() - styp->TagList.size(); i > 0; i--) {
+            styp->TagList.push_back(nullptr);
+        }
+        styp->TagList.push_back(std::move(tag));
+    }
+
+    auto f = newNode<Field>(pos);
+    f->Name = std::move(name);
+    f->Type = std::move(typ);
+    styp->FieldList.push_back(span(std::move(f), _file->Offset(pos)));
+}
+
+// FieldDecl      = (IdentifierList Type | AnonymousField) [ Tag ] .
+// AnonymousField = [ "*" ] TypeName .
+// Tag            = string_lit .
+void parser::fieldDecl(StructType *styp) {
+    auto p = pos();
+    switch (_tok) {
+        case Token_Name: {
+            auto name = this->name();
+            if (_tok == Token_Dot || _tok == Token_Literal || _tok == Token_Semi || _tok == Token_Rbrace) {
+                // embed oliteral
+                auto typ = qualifiedName(name);
+                auto tag = oliteral();
+                addField(styp, p, nullptr, typ, tag);
+                return;
+            }
+
+            // new_name_list ntype oliteral
+            auto names = nameList(name);
+            auto typ = type_();
+            auto tag = oliteral();
+
+            for (auto &name : names) {
+                addField(styp, name->pos, name, typ, tag);
+            }
+            break;
+        }
+
+        case Token_Star: {
+            next();
+            auto typ = newIndirect(p, qualifiedName(nullptr));
+            auto tag = oliteral();
+            addField(styp, p, nullptr, typ, tag);
+            break;
+        }
+
+        case Token_Lparen:
+            syntaxError("cannot parenthesize embedded type");
+            advance({Token_Semi, Token_Rbrace});
+            break;
+
+        default:
+            syntaxError("expecting field name or embedded type");
+            advance({Token_Semi, Token_Rbrace});
+    }
+}
+
+BasicLitPtr parser::oliteral() {
+    if (_tok == Token_Literal) {
+        auto start = _offset;
+        auto b = newNode<BasicLit>(pos());
+        b->Value = _lit;
+        b->Kind = _kind;
+        b->Bad = _bad;
+        next();
+        return span(b, start);
+    }
+    return nullptr;
+}
+
+// InterfaceElem     = MethodElem | TypeElem .
+// MethodElem        = MethodName Signature .
+// MethodName        = identifier .
+// TypeElem          = TypeTerm { "|" TypeTerm } .
+FieldPtr parser::methodDecl() {
+    auto start = _offset;
+    auto f = newNode<Field>(pos());
+    switch (_tok) {
+        case Token_Name: {
+            auto name = this->name();
+            if (_tok == Token_Lparen) {
+                // method
+                f->Name = std::move(name);
+                f->Type = funcType();
+            } else {
+                // embedded interface or type term
+                f->Type = embeddedElem(qualifiedName(std::move(name)));
+            }
+            return span(f, start);
+        }
+
+        case Token_Operator:
+            if (_op != Operator_Tilde) {
+                break;
+            }
+            [[fallthrough]];
+        case Token_Star:
+        case Token_Arrow:
+        case Token_Func:
+        case Token_Lbrack:
+        case Token_Chan:
+        case Token_Map:
+        case Token_Struct:
+        case Token_Interface:
+            f->Type = embeddedElem(nullptr);
+            return span(f, start);
+
+        case Token_Lparen:
+            syntaxError("cannot parenthesize embedded type");
+            advance({Token_Semi, Token_Rbrace});
+            return nullptr;
+
+        default:
+            break;
+    }
+    syntaxError("expecting method or interface name");
+    advance({Token_Semi, Token_Rbrace});
+    return nullptr;
+}
+
+// TypeElem = TypeTerm { "|" TypeTerm } .
+// If x is not nil, it is the already parsed first term.
+ExprNodePtr parser::embeddedElem(ExprNodePtr x) {
+    auto start = x != nullptr ? _file->Offset(x->span.Start) : _offset;
+    if (x == nullptr) {
+        x = embeddedTerm();
+    }
+    while (_tok == Token_Operator && _op == Operator_Or) {
+        auto t = newNode<Operation>(pos());
+        t->Op = Operator_Or;
+        next();
+        t->X = std::move(x);
+        t->Y = embeddedTerm();
+        x = span(std::move(t), start);
+    }
+    return x;
+}
+
+// TypeTerm = Type | "~" Type .
+ExprNodePtr parser::embeddedTerm() {
+    auto start = _offset;
+    if (_tok == Token_Operator && _op == Operator_Tilde) {
+        auto t = newNode<Operation>(pos());
+        t->Op = Operator_Tilde;
+        next();
+        t->X = type_();
+        return span(t, start);
+    }
+    auto t = typeOrNil();
+    if (t == nullptr) {
+        t = badExpr();
+        syntaxError("expecting ~ term or type");
+        advance({Token_Operator, Token_Comma, Token_Semi, Token_Rparen, Token_Rbrack, Token_Rbrace});
+    }
+    return t;
+}
+
+// TypeParameters = "[" TypeParamList [ "," ] "]" .
+// TypeParamList  = TypeParamDecl { "," TypeParamDecl } .
+// TypeParamDecl  = IdentifierList TypeConstraint .
+// The opening "[" is consumed; the names of a list share their constraint.
+std::vector<FieldPtr> parser::typeParamList() {
+    std::vector<FieldPtr> list;
+    size_t untyped = 0; // names waiting for their constraint
+    this->list(Token_Comma, Token_Rbrack, [&] {
+        auto start = _offset;
+        auto f = newNode<Field>(pos());
+        f->Name = name();
+        if (_tok != Token_Comma && _tok != Token_Rbrack) {
+            f->Type = embeddedElem(nullptr);
+            for (auto i = list.size() - untyped; i < list.size(); i++) {
+                list[i]->Type = f->Type;
+            }
+            untyped = 0;
+        } else {
+            untyped++;
+        }
+        list.push_back(span(f, start));
+        return false;
+    });
+    if (list.empty()) {
+        syntaxError("empty type parameter list");
+    } else if (untyped > 0) {
+        syntaxError("missing type constraint");
+        for (auto i = list.size() - untyped; i < list.size(); i++) {
+            list[i]->Type = badExpr();
+        }
+    }
+    return list;
+}
+
+// ParameterDecl = [ IdentifierList ] [ "..." ] Type .
+FieldPtr parser::paramDeclOrNil() {
+    auto start = _offset;
+    auto f = newNode<Field>(pos());
+
+    switch (_tok) {
+        case Token_Name:
+            f->Name = name();
+            switch (_tok) {
+                case Token_Name:
+                case Token_Star:
+                case Token_Arrow:
+                case Token_Func:
+                case Token_Lbrack:
+                case Token_Chan:
+                case Token_Map:
+                case Token_Struct:
+                case Token_Interface:
+                case Token_Lparen:
+                    // sym name_or_type
+                    f->Type = type_();
+                    break;
+
+                case Token_DotDotDot:
+                    // sym dotdotdot
+                    f->Type = dotsType();
+                    break;
+
+                case Token_Dot:
+                    // name_or_type
+                    // from dotname
+                    f->Type = dotname(f->Name);
+                    f->Name = nullptr;
+                    break;
+            }
+            break;
+
+        case Token_Arrow:
+        case Token_Star:
+        case Token_Func:
+        case Token_Lbrack:
+        case Token_Chan:
+        case Token_Map:
+        case Token_Struct:
+        case Token_Interface:
+        case Token_Lparen:
+            // name_or_type
+            f->Type = type_();
+            break;
+
+        case Token_DotDotDot:
+            // dotdotdot
+            f->Type = dotsType();
+            break;
+
+        default:
+            syntaxError("expecting )");
+            advance({Token_Comma, Token_Rparen});
+            return nullptr;
+    }
+
+    return span(f, start);
+}
+
+ExprNodePtr parser::dotsType() {
+    auto t = newNode<DotsType>(pos());
+
+    want(Token_DotDotDot);
+    t->Elem = typeOrNil();
+    if (t->Elem == nullptr) {
+        t->Elem = badExpr();
+        syntaxError("final argument in variadic function missing type");
+    }
+
+    return t;
+}
+
+// Parameters    = "(" [ ParameterList [ "," ] ] ")" .
+// ParameterList = ParameterDecl { "," ParameterDecl } .
+std::vector<FieldPtr> parser::paramList() {
+    auto p = pos();
+
+    std::vector<FieldPtr> list;
+    size_t named = 0; // number of parameters that have an explicit name and type
+    this->list(Token_Comma, Token_Rparen, [&] {
+        if (auto par = paramDeclOrNil()) {
+            if (par->Name != nullptr && par->Type != nullptr) {
+                named++;
+            }
+            list.push_back(std::move(par));
+        }
+        return false;
+    });
+
+    // distribute parameter types
+    if (named == 0) {
+        // all unnamed => found names are named types
+        for (auto &par : list) {
+            if (par->Name != nullptr) {
+                par->Type = std::move(par->Name);
+                par->Name = nullptr;
+            }
+        }
+    } else if (named != list.size()) {
+        // some named => all must be named
+        auto ok = true;
+        ExprNodePtr typ;
+        for (auto i = list.size(); i-- > 0;) {
+            auto &par = list[i];
+            if (par->Type != nullptr) {
+                typ = par->Type;
+                if (par->Name == nullptr) {
+                    ok = false;
+                    par->Name = newName(typ->pos, "_");
+                }
+            } else if (typ != nullptr) {
+                par->Type = typ;
+            } else {
+                // par->Type == nil && typ == nil => we only have a par->Name
+                ok = false;
+                auto t = badExpr();
+                t->pos = par->Name->pos; // correct position
+                par->Type = std::move(t);
+            }
+        }
+        if (!ok) {
+            syntaxErrorAt(p, "mixed named and unnamed function parameters");
+        }
+    }
+
+    return list;
+}
+
+ExprNodePtr parser::badExpr() { return newNode<BadExpr>(pos()); }
+
+// ----------------------------------------------------------------------------
+// Statements
+
+// SimpleStmt = EmptyStmt | ExpressionStmt | SendStmt | IncDecStmt | Assignment | ShortVarDecl .
+SimpleStmtNodePtr parser::simpleStmt(ExprNodePtr lhs, token keyword) {
+    if (keyword == Token_For && _tok == Token_Range) {
+        // _Range expr
+        return newRangeClause(nullptr, false);
+    }
+
+    if (lhs == nullptr) {
+        lhs = exprList();
+    }
+
+    if (!isa<ListExpr>(lhs) && _tok != Token_Assign && _tok != Token_Define) {
+        // expr
+        auto p = pos();
+        switch (_tok) {
+            case Token_AssignOp: {
+                // lhs op= rhs
+                auto op = _op;
+                next();
+                return newAssignStmt(p, op, lhs, expr());
+            }
+
+            case Token_IncOp: {
+                // lhs++ or lhs--
+                auto op = _op;
+                next();
+                return newAssignStmt(p, op, lhs, nullptr);
+            }
+
+            case Token_Arrow: {
+                // lhs <- rhs
+                auto s = newNode<SendStmt>(p);
+                next();
+                s->Chan = std::move(lhs);
+                s->Value = expr();
+                return s;
+            }
+
+            default: {
+                // expr
+                auto s = newNode<ExprStmt>(lhs->pos);
+                s->X = std::move(lhs);
+                return s;
+            }
+        }
+    }
+
+    // expr_list
+    switch (_tok) {
+        case Token_Assign:
+        case Token_Define: {
+            auto p = pos();
+            Operator op = 0;
+            if (_tok == Token_Define) {
+                op = Operator_Def;
+            }
+            next();
+
+            if (keyword == Token_For && _tok == Token_Range) {
+                // expr_list op= _Range expr
+                return newRangeClause(lhs, op == Operator_Def);
+            }
+
+            // expr_list op= expr_list
+            auto rhs = exprList();
+
+            if (auto x = dyn_cast<TypeSwitchGuard>(rhs.get());
+                x != nullptr && keyword == Token_Switch && op == Operator_Def) {
+                if (auto name = dyn_cast<ast::Name>(lhs)) {
+                    // switch … lhs := rhs.(type)
+                    x->Lhs = std::move(name);
+                    auto s = newNode<ExprStmt>(x->pos);
+                    s->X = std::move(rhs);
+                    return s;
+                }
+            }
+
+            return newAssignStmt(p, op, lhs, rhs);
+        }
+
+        default: {
+            syntaxError("expecting := or = or comma");
+            advance({Token_Semi, Token_Rbrace});
+            // make the best of what we have
+            if (auto x = dyn_cast<ListExpr>(lhs.get())) {
+                lhs = x->ElemList[0];
+            }
+            auto s = newNode<ExprStmt>(lhs->pos);
+            s->X = std::move(lhs);
+            return s;
+        }
+    }
+}
+
+SimpleStmtNodePtr parser::newRangeClause(ExprNodePtr lhs, bool def) {
+    auto r = newNode<RangeClause>(pos());
+    next(); // consume Token_Range
+    r->Lhs = std::move(lhs);
+    r->Def = def;
+    r->X = expr();
+    return r;
+}
+
+SimpleStmtNodePtr parser::newAssignStmt(Pos pos, Operator op, ExprNodePtr lhs, ExprNodePtr rhs) {
+    auto a = newNode<AssignStmt>(pos);
+    a->Op = op;
+    a->Lhs = std::move(lhs);
+    a->Rhs = std::move(rhs);
+    return a;
+}
+
+StmtNodePtr parser::labeledStmtOrNil(NamePtr label) {
+    auto s = newNode<LabeledStmt>(pos());
+    s->Label = std::move(label);
+
+    want(Token_Colon);
+
+    if (_tok == Token_Rbrace) {
+        // We expect a statement (incl. an empty statement), which must be
+        // terminated by a semicolon - we may omit the semicolon before a
+        // closing "}" and on a line by itself.
+        s->Stmt = newNode<EmptyStmt>(pos());
+        return s;
+    }
+
+    auto start = _offset;
+    s->Stmt = span(stmtOrNil(), start);
+    if (s->Stmt != nullptr) {
+        return s;
+    }
+
+    // report error at line of ':' token
+    syntaxErrorAt(s->pos, "missing statement after label");
+    // we are already at the end of the labeled statement - no need to advance
+    return nullptr; // avoids follow-on errors (see e.g., fixedbugs/bug274.go)
+}
+
+// context must be a non-empty string unless we know that _tok == Token_Lbrace.
+BlockStmtPtr parser::blockStmt(std::string context) {
+    auto start = _offset;
+    auto s = newNode<BlockStmt>(pos());
+
+    // people coming from C may forget that braces are mandatory in Go
+    if (!got(Token_Lbrace)) {
+        syntaxError("expecting { after " + context);
+        advance({Token_Name, Token_Rbrace});
+        s->Rbrace = pos(); // in case we found "}"
+        if (got(Token_Rbrace)) {
+            return span(s, start);
+        }
+    }
+
+    s->List = stmtList();
+    s->Rbrace = pos();
+    want(Token_Rbrace);
+
+    return span(s, start);
+}
+
+StmtNodePtr parser::declStmt(DeclNodePtr (parser::*f)(GroupPtr)) {
+    auto s = newNode<DeclStmt>(pos());
+
+    next(); // Token_Const, Token_Type, or Token_Var
+    appendGroup(s->DeclList, f);
+
+    return s;
+}
+
+StmtNodePtr parser::forStmt() {
+    auto s = newNode<ForStmt>(pos());
+
+    header(Token_For, s->Init, s->Cond, s->Post);
+    s->Body = blockStmt("for clause");
+
+    return s;
+}
+
+void parser::header(token keyword, SimpleStmtNodePtr &init, ExprNodePtr &cond, SimpleStmtNodePtr &post) {
+    want(keyword);
+
+    if (_tok == Token_Lbrace) {
+        if (keyword == Token_If) {
+            syntaxError("missing condition in if statement");
+            cond = badExpr();
+        }
+        return;
+    }
+    // _tok != Token_Lbrace
+
+    auto outer = _xnest;
+    _xnest = -1;
+
+    if (_tok != Token_Semi) {
+        // accept potential varDecl but complain
+        if (got(Token_Var)) {
+            syntaxError(fmt::format("var declaration not allowed in {} initializer", tokstring(keyword)));
+        }
+        auto start = _offset;
+        init = span(simpleStmt(nullptr, keyword), start);
+        // If we have a range clause, we are done (can only happen for keyword == Token_For).
+        if (isa<RangeClause>(init)) {
+            _xnest = outer;
+            return;
+        }
+    }
+
+    SimpleStmtNodePtr condStmt;
+    struct {
+        Pos pos{};
+        std::string lit; // valid if pos.IsKnown()
+    } semi;
+    if (_tok != Token_Lbrace) {
+        if (_tok == Token_Semi) {
+            semi.pos = pos();
+            semi.lit = _lit;
+            next();
+        } else {
+            // asking for a '{' rather than a ';' here leads to a better error message
+            want(Token_Lbrace);
+            if (_tok != Token_Lbrace) {
+                advance({Token_Lbrace, Token_Rbrace}); // for better synchronization (e.g., issue #22581)
+            }
+        }
+        if (keyword == Token_For) {
+            if (_tok != Token_Semi) {
+                if (_tok == Token_Lbrace) {
+                    syntaxError("expecting for loop condition");
+                    goto done;
+                }
+                auto start = _offset;
+                condStmt = span(simpleStmt(nullptr, 0 /* range not permitted */), start);
+            }
+            want(Token_Semi);
+            if (_tok != Token_Lbrace) {
+                auto start = _offset;
+                post = span(simpleStmt(nullptr, 0 /* range not permitted */), start);
+                if (auto a = dyn_cast<AssignStmt>(post.get()); a != nullptr && a->Op == Operator_Def) {
+                    syntaxErrorAt(a->pos, "cannot declare in post statement of for loop");
+                }
+            }
+        } else if (_tok != Token_Lbrace) {
+            auto start = _offset;
+            condStmt = span(simpleStmt(nullptr, keyword), start);
+        }
+    } else {
+        condStmt = std::move(init);
+        init = nullptr;
+    }
+
+done:
+    // unpack condStmt
+    if (condStmt == nullptr) {
+        if (keyword == Token_If && semi.pos.IsKnown()) {
+            if (semi.lit == "semicolon") {
+                syntaxErrorAt(semi.pos, "missing condition in if statement");
+            } else {
+                errorAt(semi.pos, "unexpected newline, expecting { after if clause");
+            }
+            cond = newNode<BadExpr>(semi.pos);
+        }
+    } else if (auto s = dyn_cast<ExprStmt>(condStmt.get())) {
+        cond = s->X;
+    } else {
+        // A common syntax error is to write "if x := 0 {" instead
+        // of "if x = 0 {" (or "if x == 0 {").
+        std::string str;
+        if (auto as = dyn_cast<AssignStmt>(condStmt.get()); as != nullptr && as->Rhs != nullptr) {
+            // Emphasize Lhs and Rhs of assignment with parentheses to highlight '='.
+            auto op = as->Op == Operator_Def ? ":=" : as->Op == 0 ? "=" : OperatorString(as->Op) + "=";
+            str = fmt::format("assignment ({}) {} ({})", String(as->Lhs.get()), op, String(as->Rhs.get()));
+        } else {
+            str = "simple statement";
+        }
+        syntaxErrorAt(condStmt->pos, fmt::format("cannot use {} as value", str));
+    }
+
+    _xnest = outer;
+}
+
+std::shared_ptr<IfStmt> parser::ifStmt() {
+    auto start = _offset;
+    auto s = newNode<IfStmt>(pos());
+
+    SimpleStmtNodePtr post;
+    header(Token_If, s->Init, s->Cond, post);
+    s->Then = blockStmt("if clause");
+
+    if (got(Token_Else)) {
+        switch (_tok) {
+            case Token_If:
+                s->Else = ifStmt();
+                break;
+            case Token_Lbrace:
+                s->Else = blockStmt("");
+                break;
+            default:
+                syntaxError("else must be followed by if or statement block");
+                advance({Token_Name, Token_Rbrace});
+        }
+    }
+    return span(s, start);
+}
+
+StmtNodePtr parser::switchStmt() {
+    auto s = newNode<SwitchStmt>(pos());
+
+    SimpleStmtNodePtr post;
+    header(Token_Switch, s->Init, s->Tag, post);
+
+    if (!got(Token_Lbrace)) {
+        syntaxError("missing { after switch clause");
+        advance({Token_Case, Token_Default, Token_Rbrace});
+    }
+    while (_tok != Token_EOF && _tok != Token_Rbrace) {
+        s->Body.push_back(caseClause());
+    }
+    s->Rbrace = pos();
+    want(Token_Rbrace);
+
+    return s;
+}
+
+StmtNodePtr parser::selectStmt() {
+    auto s = newNode<SelectStmt>(pos());
+
+    want(Token_Select);
+    if (!got(Token_Lbrace)) {
+        syntaxError("missing { after select clause");
+        advance({Token_Case, Token_Default, Token_Rbrace});
+    }
+    while (_tok != Token_EOF && _tok != Token_Rbrace) {
+        s->Body.push_back(commClause());
+    }
+    s->Rbrace = pos();
+    want(Token_Rbrace);
+
+    return s;
+}
+
+CaseClausePtr parser::caseClause() {
+    auto start = _offset;
+    auto c = newNode<CaseClause>(pos());
+
+    switch (_tok) {
+        case Token_Case:
+            next();
+            c->Cases = exprList();
+            break;
+
+        case Token_Default:
+            next();
+            break;
+
+        default:
+            syntaxError("expecting case or default or }");
+            advance({Token_Colon, Token_Case, Token_Default, Token_Rbrace});
+    }
+
+    c->Colon = pos();
+    want(Token_Colon);
+    c->Body = stmtList();
+
+    return span(c, start);
+}
+
+CommClausePtr parser::commClause() {
+    auto start = _offset;
+    auto c = newNode<CommClause>(pos());
+
+    switch (_tok) {
+        case Token_Case: {
+            next();
+            auto cstart = _offset;
+            c->Comm = span(simpleStmt(nullptr, 0), cstart);
+
+            // The syntax restricts the possible simple statements here to:
+            //
+            //     lhs <- x (send statement)
+            //     <-x
+            //     lhs = <-x
+            //     lhs := <-x
+            //
+            // All these (and more) are recognized by simpleStmt and invalid
+            // syntax trees are flagged later, during type checking.
+            break;
+        }
+
+        case Token_Default:
+            next();
+            break;
+
+        default:
+            syntaxError("expecting case or default or }");
+            advance({Token_Colon, Token_Case, Token_Default, Token_Rbrace});
+    }
+
+    c->Colon = pos();
+    want(Token_Colon);
+    c->Body = stmtList();
+
+    return span(c, start);
+}
+
+// Statement =
+// 	Declaration | LabeledStmt | SimpleStmt |
+// 	GoStmt | ReturnStmt | BreakStmt | ContinueStmt | GotoStmt |
+// 	FallthroughStmt | Block | IfStmt | SwitchStmt | SelectStmt | ForStmt |
+// 	DeferStmt .
+StmtNodePtr parser::stmtOrNil() {
+    // Most statements (assignments) start with an identifier;
+    // look for it first before doing anything more expensive.
+    if (_tok == Token_Name) {
+        auto lhs = exprList();
+        if (auto label = dyn_cast<ast::Name>(lhs); label != nullptr && _tok == Token_Colon) {
+            return labeledStmtOrNil(std::move(label));
+        }
+        return simpleStmt(std::move(lhs), 0);
+    }
+
+    switch (_tok) {
+        case Token_Var:
+            return declStmt(&parser::varDecl);
+        case Token_Const:
+            return declStmt(&parser::constDecl);
+        case Token_Type:
+            return declStmt(&parser::typeDecl);
+
+        case Token_Lbrace:
+            return blockStmt("");
+
+        case Token_Operator:
+        case Token_Star:
+            switch (_op) {
+                case Operator_Add:
+                case Operator_Sub:
+                case Operator_Mul:
+                case Operator_And:
+                case Operator_Xor:
+                case Operator_Not:
+                    return simpleStmt(nullptr, 0); // unary operators
+            }
+            break;
+
+        case Token_Literal:
+        case Token_Func:
+        case Token_Lparen: // operands
+        case Token_Lbrack:
+        case Token_Struct:
+        case Token_Map:
+        case Token_Chan:
+        case Token_Interface: // composite types
+        case Token_Arrow:     // receive operator
+            return simpleStmt(nullptr, 0);
+
+        case Token_For:
+            return forStmt();
+
+        case Token_Switch:
+            return switchStmt();
+
+        case Token_Select:
+            return selectStmt();
+
+        case Token_If:
+            return ifStmt();
+
+        case Token_Fallthrough: {
+            auto s = newNode<BranchStmt>(pos());
+            next();
+            s->Tok = Token_Fallthrough;
+            return s;
+        }
+
+        case Token_Break:
+        case Token_Continue: {
+            auto s = newNode<BranchStmt>(pos());
+            s->Tok = _tok;
+            next();
+            if (_tok == Token_Name) {
+                s->Label = name();
+            }
+            return s;
+        }
+
+        case Token_Go:
+        case Token_Defer:
+            return callStmt();
+
+        case Token_Goto: {
+            auto s = newNode<BranchStmt>(pos());
+            s->Tok = Token_Goto;
+            next();
+            s->Label = name();
+            return s;
+        }
+
+        case Token_Return: {
+            auto s = newNode<ReturnStmt>(pos());
+            next();
+            if (_tok != Token_Semi && _tok != Token_Rbrace) {
+                s->Results = exprList();
+            }
+            return s;
+        }
+
+        case Token_Semi:
+            return newNode<EmptyStmt>(pos());
+    }
+
+    return nullptr;
+}
+
+// StatementList = { Statement ";" } .
+std::vector<StmtNodePtr> parser::stmtList() {
+    std::vector<StmtNodePtr> l;
+    while (_tok != Token_EOF && _tok != Token_Rbrace && _tok != Token_Case && _tok != Token_Default) {
+        auto start = _offset;
+        auto s = span(stmtOrNil(), start);
+        if (s == nullptr) {
+            break;
+        }
+        l.push_back(std::move(s));
+        // ";" is optional before "}"
+        if (!got(Token_Semi) && _tok != Token_Rbrace) {
+            syntaxError("at end of statement");
+            advance({Token_Semi, Token_Rbrace, Token_Case, Token_Default});
+            got(Token_Semi); // avoid spurious empty statement
+        }
+    }
+    return l;
+}
+
+// argList parses a possibly empty, comma-separated list of arguments,
+// optionally followed by a comma (if not empty), and closed by ")".
+std::vector<ExprNodePtr> parser::argList(bool &hasDots) {
+    std::vector<ExprNodePtr> list;
+    _xnest++;
+    this->list(Token_Comma, Token_Rparen, [&] {
+        list.push_back(expr());
+        hasDots = got(Token_DotDotDot);
+        return hasDots;
+    });
+    _xnest--;
+    return list;
+}
+
+// ----------------------------------------------------------------------------
+// Common productions
+
+NamePtr parser::name() {
+    // no tracing to avoid overly verbose output
+
+    auto start = _offset;
+    if (_tok == Token_Name) {
+        auto n = newName(pos(), _sym);
+        next();
+        return span(n, start);
+    }
+
+    auto n = newName(pos(), "_");
+    syntaxError("expecting name");
+    advance();
+    return span(n, start);
+}
+
+// IdentifierList = identifier { "," identifier } .
+// The first name must be provided.
+std::vector<NamePtr> parser::nameList(NamePtr first) {
+    std::vector<NamePtr> l{std::move(first)};
+    while (got(Token_Comma)) {
+        l.push_back(name());
+    }
+
+    return l;
+}
+
+// The first name may be provided, or nil.
+ExprNodePtr parser::qualifiedName(NamePtr name) {
+    auto start = name != nullptr ? _file->Offset(name->span.Start) : _offset;
+    ExprNodePtr x;
+    if (name != nullptr) {
+        x = std::move(name);
+    } else if (_tok == Token_Name) {
+        x = this->name();
+    } else {
+        x = newName(pos(), "_");
+        syntaxError("expecting name");
+        advance({Token_Dot, Token_Semi, Token_Rbrace});
+    }
+
+    if (_tok == Token_Dot) {
+        auto s = newNode<SelectorExpr>(pos());
+        next();
+        s->X = std::move(x);
+        s->Sel = this->name();
+        x = span(std::move(s), start);
+    }
+
+    return x;
+}
+
+// ExpressionList = Expression { "," Expression } .
+ExprNodePtr parser::exprList() {
+    auto start = _offset;
+    auto x = expr();
+    if (got(Token_Comma)) {
+        auto t = newNode<ListExpr>(x->pos);
+        t->ElemList.push_back(std::move(x));
+        t->ElemList.push_back(expr());
+        while (got(Token_Comma)) {
+            t->ElemList.push_back(expr());
+        }
+        x = span(std::move(t), start);
+    }
+    return x;
+}
+
+// ----------------------------------------------------------------------------
+
+FilePtr Parse(std::unique_ptr<std::istream> in, err_handler errh, uint mode) {
+    parser p;
+    p.init(std::move(in), std::move(errh), mode);
+    return p.fileOrNil();
+}
+
+BlockStmtPtr ParseFuncBody(std::string_view src, FuncDecl *f, err_handler errh) {
+    if (!f->Skipped()) {
+        return nullptr;
+    }
+    auto file = FileSet::Global().File(f->BodyLbrace);
+    auto lbrace = file->Offset(f->BodyLbrace);
+    auto body = src.substr(lbrace, file->Offset(f->BodyRbrace) + 1 - lbrace);
+    parser p;
+    p.init(std::make_unique<std::istringstream>(std::string(body)), f->BodyLbrace, std::move(errh), 0);
+    f->Body = p.funcBody();
+    return f->Body;
+}
+
+void ParseFuncBodies(std::string_view src, File *file, err_handler errh) {
+    struct error {
+        uint line;
+        uint col;
+        std::string msg;
+    };
+    std::vector<FuncDecl *> funcs;
+    for (auto &d : file->DeclList) {
+        if (auto f = dyn_cast<FuncDecl>(d.get()); f != nullptr && f->Skipped()) {
+            funcs.push_back(f);
+        }
+    }
+
+    // Each body collects its own errors so that they can be reported in
+    // source order independent of scheduling.
+    std::vector<std::vector<error>> errs(funcs.size());
+    tbb::parallel_for(size_t(0), funcs.size(), [&](size_t i) {
+        ParseFuncBody(src, funcs[i], [&errs, i](uint line, uint col, std::string msg) {
+            errs[i].push_back({line, col, std::move(msg)});
+        });
+    });
+
+    for (auto &list : errs) {
+        for (auto &e : list) {
+            if (errh) {
+                errh(e.line, e.col, std::move(e.msg));
+            } else {
+                std::cout << e.line << ":" << e.col << ": " << e.msg << std::endl;
+            }
+        }
+    }
+}
+
+bool ParseGoEmbed(std::string_view args, std::vector<std::string> &patterns) {
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'; };
+    auto trim = [&] {
+        while (!args.empty() && isSpace(args.front())) {
+            args.remove_prefix(1);
+        }
+    };
+    for (trim(); !args.empty(); trim()) {
+        std::string path;
+        switch (args[0]) {
+            default: {
+                size_t i = 0;
+                while (i < args.size() && !isSpace(args[i])) {
+                    i++;
+                }
+                path = args.substr(0, i);
+                args.remove_prefix(i);
+                break;
+            }
+            case '`': {
+                auto i = args.find('`', 1);
+                if (i == std::string_view::npos) {
+                    return false;
+                }
+                path = args.substr(1, i - 1);
+                args.remove_prefix(i + 1);
+                break;
+            }
+            case '"': {
+                size_t i = 1;
+                for (; i < args.size() && args[i] != '"'; i++) {
+                    if (args[i] == '\n') {
+                        return false;
+                    }
+                    if (args[i] != '\\') {
+                        path += args[i];
+                        continue;
+                    }
+                    if (++i == args.size()) {
+                        return false;
+                    }
+                    // pairs of escaped character and its value
+                    std::string_view escapes = "a\ab\bf\fn\nr\rt\tv\v\\\\\"\"";
+                    auto e = escapes.find(args[i]);
+                    if (e == std::string_view::npos || e % 2 != 0) {
+                        return false;
+                    }
+                    path += escapes[e + 1];
+                }
+                if (i == args.size()) {
+                    return false;
+                }
+                args.remove_prefix(i + 1);
+                break;
+            }
+        }
+        if (!args.empty() && !isSpace(args[0])) {
+            return false;
+        }
+        patterns.push_back(std::move(path));
+    }
+    return true;
+}
+
+FilePtr ParseFile(std::string filename, err_handler errh, uint mode) {
+    parser p;
+    p.init(std::move(filename), std::move(errh), mode);
+    return p.fileOrNil();
+}
+
+} // namespace syntax
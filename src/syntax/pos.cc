@@ -0,0 +1,97 @@
+#include "syntax/pos.hh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace syntax {
+
+Position SourceFile::Resolve(Pos p) const {
+    auto offset = Offset(p);
+    // the last line starting at or before offset
+    auto line = std::upper_bound(_lines.begin(), _lines.end(), uint32_t(offset)) - _lines.begin();
+    return Position{_name, int(line), int(offset - _lines[line - 1]) + 1, offset};
+}
+
+void SourceFile::AddSource(int64_t offset, std::string_view bytes) {
+    if (offset != _nsrc || bytes.empty()) {
+        return;
+    }
+    if (_src == nullptr) {
+        _src = std::make_unique<char[]>(size_t(_size) + 1);
+    }
+    auto n = std::min(bytes.size(), size_t(_size - _nsrc));
+    std::memcpy(_src.get() + _nsrc, bytes.data(), n);
+    _nsrc += uint32_t(n);
+}
+
+std::string_view SourceFile::Text(Span s) const {
+    auto offset = Offset(s.Start);
+    if (offset + s.Len > _nsrc) {
+        return {};
+    }
+    return Source().substr(offset, s.Len);
+}
+
+FileSet &FileSet::Global() {
+    static FileSet global;
+    return global;
+}
+
+SourceFile *FileSet::AddFile(std::string name, int64_t size) {
+    tbb::spin_mutex::scoped_lock lock(_mutex);
+    // one extra position for EOF
+    if (size < 0 || uint64_t(_base) + uint64_t(size) + 1 > UINT32_MAX) {
+        return nullptr;
+    }
+    _files.push_back(std::make_unique<SourceFile>(std::move(name), _base, uint32_t(size)));
+    _base += uint32_t(size) + 1;
+    return _files.back().get();
+}
+
+void FileSet::Release(Pos p) {
+    std::unique_ptr<SourceFile> released; // freed outside the lock
+    if (!p.IsKnown()) {
+        return;
+    }
+    tbb::spin_mutex::scoped_lock lock(_mutex);
+    auto i = find(p);
+    if (i == _files.size()) {
+        return;
+    }
+    released = std::move(_files[i]);
+    _files.erase(_files.begin() + i);
+    // the range of the files after the last one left is free again
+    _base = _files.empty() ? 1 : _files.back()->Base() + _files.back()->Size() + 1;
+}
+
+SourceFile *FileSet::File(Pos p) const {
+    if (!p.IsKnown()) {
+        return nullptr;
+    }
+    tbb::spin_mutex::scoped_lock lock(_mutex);
+    auto i = find(p);
+    return i == _files.size() ? nullptr : _files[i].get();
+}
+
+size_t FileSet::find(Pos p) const {
+    // files are sorted by base: find the last file starting at or before p
+    auto it = std::upper_bound(_files.begin(), _files.end(), p.Raw(),
+                               [](uint32_t x, const std::unique_ptr<SourceFile> &f) { return x < f->Base(); });
+    if (it == _files.begin()) {
+        return _files.size();
+    }
+    auto &f = *--it;
+    return p.Raw() <= f->Base() + f->Size() ? size_t(it - _files.begin()) : _files.size();
+}
+
+Position FileSet::Resolve(Pos p) const {
+    auto f = File(p);
+    return f ? f->Resolve(p) : Position{};
+}
+
+std::string_view FileSet::Text(Span s) const {
+    auto f = File(s.Start);
+    return f ? f->Text(s) : std::string_view{};
+}
+
+} // namespace syntax
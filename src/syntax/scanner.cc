@@ -0,0 +1,857 @@
+#include "syntax/scanner.hh"
+
+#include <array>
+#include <string_view>
+
+namespace syntax
+{
+
+#define colbase 1
+
+static std::string_view tokStrFast(token tok) {
+    return std::string_view(g_token_name).substr(g_token_index[tok - 1], g_token_index[tok] - g_token_index[tok - 1]);
+}
+
+// keywordNames lists the keyword spellings in token order, starting at Token_Break.
+static constexpr std::string_view keywordNames[] = {
+    "break", "case", "chan", "const", "continue", "default", "defer", "else", "fallthrough", "for", "func",
+    "go", "goto", "if", "import", "interface", "map", "package", "range", "return", "select", "struct",
+    "switch", "type", "var",
+};
+
+// hash is a perfect hash function for keywords.
+// It assumes that s has at least length 2.
+static constexpr uint hash(std::string_view s) {
+    return ((uint(uint8_t(s[0])) << 4 ^ uint(uint8_t(s[1]))) + uint(s.size())) & uint((1 << 6) - 1);
+}
+
+static constexpr std::array<token, 1 << 6> makeKeywordMap() {
+    std::array<token, 1 << 6> m{};
+    for (token tok = Token_Break; tok <= Token_Var; tok++) {
+        auto h = hash(keywordNames[tok - Token_Break]);
+        if (m[h] != 0) {
+            throw "imperfect hash";
+        }
+        m[h] = tok;
+    }
+    return m;
+}
+
+static constexpr std::array<token, 1 << 6> keywordMap = makeKeywordMap();
+
+// runeString formats ch like Go's %#U verb, e.g. U+0041 'A'.
+static std::string runeString(rune_t ch) {
+    auto s = fmt::format("U+{:04X}", uint32_t(ch));
+    if (ch >= 0x20 && !ch.is_invalid()) {
+        s += " '" + std::string(ch) + "'";
+    }
+    return s;
+}
+
+// quoteRune formats ch like Go's %q verb for runes.
+static std::string quoteRune(rune_t ch) { return "'" + std::string(ch) + "'"; }
+
+static rune lower(rune ch) { return ('a' - 'A') | ch; }
+static bool isLetter(rune ch) { return ('a' <= lower(ch) && lower(ch) <= 'z') || ch == '_'; }
+static bool isDecimal(rune ch) { return '0' <= ch && ch <= '9'; }
+static bool isHex(rune ch) { return ('0' <= ch && ch <= '9') || ('a' <= lower(ch) && lower(ch) <= 'f'); }
+static std::string baseName(int64_t base) {
+    switch (base) {
+        case 2: {
+            return "binary";
+        } break;
+        case 8: {
+            return "octal";
+        } break;
+        case 10: {
+            return "decimal";
+        } break;
+        case 16: {
+            return "hexadecimal";
+        } break;
+    }
+    panic("invalid base");
+    return "";
+}
+
+static int64_t invalidSep(const string &x) {
+    rune x1 = rune((unsigned char)' ');
+    rune d = rune((unsigned char)'.');
+    size_t i = 0;
+    if (x.size() >= 2 && x[0] == '0') {
+        x1 = lower(rune((unsigned char)x[1]));
+        if (x1 == 'x' || x1 == 'o' || x1 == 'b') {
+            d = '0';
+            i = 2;
+        }
+    }
+    for (; i < x.size(); i++) {
+        auto p = d;
+        d = rune((unsigned char)x[i]);
+        if (d == '_') {
+            if (p != '0') {
+                return i;
+            }
+        } else if (isDecimal(d) || (x1 == 'x' && isHex(d))) {
+            d = '0';
+        } else
+
+        {
+            if (p == '_') {
+                return i - 1;
+            }
+            d = '.';
+        }
+    }
+    if (d == '_') {
+        return int64_t(x.size()) - 1;
+    }
+    return -1;
+}
+
+void scanner::init(std::string src, err_handler errh, uint mode) {
+    source::init(src, std::move(errh));
+    (*this)._mode = mode;
+    (*this)._nlsemi = false;
+}
+void scanner::init(std::unique_ptr<std::istream> in, err_handler errh, uint mode) {
+    source::init(std::move(in), std::move(errh));
+    (*this)._mode = mode;
+    (*this)._nlsemi = false;
+}
+void scanner::setLit(LitKind kind, bool ok) {
+    (*this)._nlsemi = true;
+    (*this)._tok = Token_Literal;
+    (*this)._lit = string((*this).segment());
+    (*this)._bad = !ok;
+    (*this)._kind = kind;
+}
+void scanner::next() {
+    (*this)._prev_end = (*this).offset();
+    auto nlsemi = (*this)._nlsemi;
+    (*this)._nlsemi = false;
+redo:
+    (*this).stop();
+    auto [startLine, startCol] = (*this).pos();
+    for (; (*this)._ch == ' ' || (*this)._ch == '\t' || ((*this)._ch == '\n' && !nlsemi) || (*this)._ch == '\r';) {
+        (*this).nextch();
+    }
+    std::tie((*this)._line, (*this)._col) = (*this).pos();
+    (*this)._offset = (*this).offset();
+    (*this)._blank = (*this)._line > uint(startLine) || startCol == colbase;
+    (*this).start();
+    if (isLetter((*this)._ch) || ((*this)._ch >= common::utf8::rune_self && (*this).atIdentChar(true))) {
+        (*this).nextch();
+        (*this).ident();
+        return;
+    }
+    switch ((int)(*this)._ch) {
+        case -1: {
+            if (nlsemi) {
+                (*this)._lit = "EOF";
+                (*this)._tok = Token_Semi;
+                break;
+            }
+            (*this)._tok = Token_EOF;
+        } break;
+        case '\n': {
+            (*this).nextch();
+            (*this)._lit = "newline";
+            (*this)._tok = Token_Semi;
+        } break;
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9': {
+            (*this).number(false);
+        } break;
+        case '"': {
+            (*this).stdString();
+        } break;
+        case '`': {
+            (*this).rawString();
+        } break;
+        case '\'': {
+            (*this).rune();
+        } break;
+        case '(': {
+            (*this).nextch();
+            (*this)._tok = Token_Lparen;
+        } break;
+        case '[': {
+            (*this).nextch();
+            (*this)._tok = Token_Lbrack;
+        } break;
+        case '{': {
+            (*this).nextch();
+            (*this)._tok = Token_Lbrace;
+        } break;
+        case ',': {
+            (*this).nextch();
+            (*this)._tok = Token_Comma;
+        } break;
+        case ';': {
+            (*this).nextch();
+            (*this)._lit = "semicolon";
+            (*this)._tok = Token_Semi;
+        } break;
+        case ')': {
+            (*this).nextch();
+            (*this)._nlsemi = true;
+            (*this)._tok = Token_Rparen;
+        } break;
+        case ']': {
+            (*this).nextch();
+            (*this)._nlsemi = true;
+            (*this)._tok = Token_Rbrack;
+        } break;
+        case '}': {
+            (*this).nextch();
+            (*this)._nlsemi = true;
+            (*this)._tok = Token_Rbrace;
+        } break;
+        case ':': {
+            (*this).nextch();
+            if ((*this)._ch == '=') {
+                (*this).nextch();
+                (*this)._tok = Token_Define;
+                break;
+            }
+            (*this)._tok = Token_Colon;
+        } break;
+        case '.': {
+            (*this).nextch();
+            if (isDecimal((*this)._ch)) {
+                (*this).number(true);
+                break;
+            }
+            if ((*this)._ch == '.') {
+                (*this).nextch();
+                if ((*this)._ch == '.') {
+                    (*this).nextch();
+                    (*this)._tok = Token_DotDotDot;
+                    break;
+                }
+                (*this).rewind();
+                (*this).nextch();
+            }
+            (*this)._tok = Token_Dot;
+        } break;
+        case '+': {
+            (*this).nextch();
+            (*this)._op = Operator_Add;
+            (*this)._prec = precAdd;
+            if ((*this)._ch != '+') {
+                goto assignop;
+            }
+            (*this).nextch();
+            (*this)._nlsemi = true;
+            (*this)._tok = Token_IncOp;
+        } break;
+        case '-': {
+            (*this).nextch();
+            (*this)._op = Operator_Sub;
+            (*this)._prec = precAdd;
+            if ((*this)._ch != '-') {
+                goto assignop;
+            }
+            (*this).nextch();
+            (*this)._nlsemi = true;
+            (*this)._tok = Token_IncOp;
+        } break;
+        case '*': {
+            (*this).nextch();
+            (*this)._op = Operator_Mul;
+            (*this)._prec = precMul;
+            if ((*this)._ch == '=') {
+                (*this).nextch();
+                (*this)._tok = Token_AssignOp;
+                break;
+            }
+            (*this)._tok = Token_Star;
+        } break;
+        case '/': {
+            (*this).nextch();
+            if ((*this)._ch == '/') {
+                (*this).nextch();
+                (*this).lineComment();
+                goto redo;
+            }
+            if ((*this)._ch == '*') {
+                (*this).nextch();
+                (*this).fullComment();
+                {
+                    auto [line, _] = (*this).pos();
+                    if (uint(line) > (*this)._line && nlsemi) {
+                        (*this)._lit = "newline";
+                        (*this)._tok = Token_Semi;
+                        break;
+                    }
+                }
+                goto redo;
+            }
+            (*this)._op = Operator_Div;
+            (*this)._prec = precMul;
+            goto assignop;
+        } break;
+        case '%': {
+            (*this).nextch();
+            (*this)._op = Operator_Rem;
+            (*this)._prec = precMul;
+            goto assignop;
+        } break;
+        case '&': {
+            (*this).nextch();
+            if ((*this)._ch == '&') {
+                (*this).nextch();
+                (*this)._op = Operator_AndAnd;
+                (*this)._prec = precAndAnd;
+                (*this)._tok = Token_Operator;
+                break;
+            }
+            (*this)._op = Operator_And;
+            (*this)._prec = precMul;
+            if ((*this)._ch == '^') {
+                (*this).nextch();
+                (*this)._op = Operator_AndNot;
+            }
+            goto assignop;
+        } break;
+        case '|': {
+            (*this).nextch();
+            if ((*this)._ch == '|') {
+                (*this).nextch();
+                (*this)._op = Operator_OrOr;
+                (*this)._prec = precOrOr;
+                (*this)._tok = Token_Operator;
+                break;
+            }
+            (*this)._op = Operator_Or;
+            (*this)._prec = precAdd;
+            goto assignop;
+        } break;
+        case '^': {
+            (*this).nextch();
+            (*this)._op = Operator_Xor;
+            (*this)._prec = precAdd;
+            goto assignop;
+        } break;
+        case '<': {
+            (*this).nextch();
+            if ((*this)._ch == '=') {
+                (*this).nextch();
+                (*this)._op = Operator_Leq;
+                (*this)._prec = precCmp;
+                (*this)._tok = Token_Operator;
+                break;
+            }
+            if ((*this)._ch == '<') {
+                (*this).nextch();
+                (*this)._op = Operator_Shl;
+                (*this)._prec = precMul;
+                goto assignop;
+            }
+            if ((*this)._ch == '-') {
+                (*this).nextch();
+                (*this)._tok = Token_Arrow;
+                break;
+            }
+            (*this)._op = Operator_Lss;
+            (*this)._prec = precCmp;
+            (*this)._tok = Token_Operator;
+        } break;
+        case '>': {
+            (*this).nextch();
+            if ((*this)._ch == '=') {
+                (*this).nextch();
+                (*this)._op = Operator_Geq;
+                (*this)._prec = precCmp;
+                (*this)._tok = Token_Operator;
+                break;
+            }
+            if ((*this)._ch == '>') {
+                (*this).nextch();
+                (*this)._op = Operator_Shr;
+                (*this)._prec = precMul;
+                goto assignop;
+            }
+            (*this)._op = Operator_Gtr;
+            (*this)._prec = precCmp;
+            (*this)._tok = Token_Operator;
+        } break;
+        case '=': {
+            (*this).nextch();
+            if ((*this)._ch == '=') {
+                (*this).nextch();
+                (*this)._op = Operator_Eql;
+                (*this)._prec = precCmp;
+                (*this)._tok = Token_Operator;
+                break;
+            }
+            (*this)._tok = Token_Assign;
+        } break;
+        case '!': {
+            (*this).nextch();
+            if ((*this)._ch == '=') {
+                (*this).nextch();
+                (*this)._op = Operator_Neq;
+                (*this)._prec = precCmp;
+                (*this)._tok = Token_Operator;
+                break;
+            }
+            (*this)._op = Operator_Not;
+            (*this)._prec = 0;
+            (*this)._tok = Token_Operator;
+        } break;
+        case '~': {
+            (*this).nextch();
+            (*this)._op = Operator_Tilde;
+            (*this)._prec = 0;
+            (*this)._tok = Token_Operator;
+        } break;
+        default: {
+            (*this).errorf("invalid character {}", runeString((*this)._ch));
+            (*this).nextch();
+            goto redo;
+        } break;
+    }
+    return;
+assignop:
+    if ((*this)._ch == '=') {
+        (*this).nextch();
+        (*this)._tok = Token_AssignOp;
+        return;
+    }
+    (*this)._tok = Token_Operator;
+}
+void scanner::ident() {
+    for (; isLetter((*this)._ch) || isDecimal((*this)._ch);) {
+        (*this).nextch();
+    }
+    if ((*this)._ch >= common::utf8::rune_self) {
+        for (; (*this).atIdentChar(false);) {
+            (*this).nextch();
+        }
+    }
+    auto lit = (*this).segment();
+    if (lit.size() >= 2) {
+        {
+            auto tok = keywordMap[hash(lit)];
+            if (tok != 0 && tokStrFast(tok) == lit) {
+                (*this)._nlsemi = contains(1ul << Token_Break | 1ul << Token_Continue | 1ul << Token_Fallthrough | 1ul << Token_Return, tok);
+                (*this)._tok = tok;
+                return;
+            }
+        }
+    }
+    (*this)._nlsemi = true;
+    (*this)._sym = common::Interner::Global().Intern(lit);
+    (*this)._tok = Token_Name;
+}
+bool scanner::atIdentChar(bool first) {
+    // Unicode letters are classified by utf8proc, as unicode.IsLetter does
+    if (isLetter((*this)._ch) || (*this)._ch.is_alpha()) {
+
+    } else if ((*this)._ch.is_digit()) {
+        if (first) {
+            (*this).errorf("identifier cannot begin with digit {}", runeString((*this)._ch));
+        }
+    } else if ((*this)._ch >= common::utf8::rune_self) {
+        (*this).errorf("invalid character {} in identifier", runeString((*this)._ch));
+    } else
+
+    {
+        return false;
+    }
+    return true;
+}
+int64_t scanner::digits(int64_t base, int* invalid) {
+    int64_t digsep = 0;
+    if (base <= 10) {
+        auto max = rune_t((unsigned char)('0' + base));
+        for (; isDecimal((*this)._ch) || (*this)._ch == '_';) {
+            auto ds = 1;
+            if ((*this)._ch == '_') {
+                ds = 2;
+            } else {
+                if ((*this)._ch >= max && *invalid < 0) {
+                    auto [_, col] = (*this).pos();
+                    *invalid = int(col - (*this)._col);
+                }
+            }
+            digsep |= ds;
+            (*this).nextch();
+        }
+    } else {
+        for (; isHex((*this)._ch) || (*this)._ch == '_'; ) {
+            auto ds = 1;
+            if ((*this)._ch == '_') {
+                ds = 2;
+            }
+            digsep |= ds;
+            (*this).nextch();
+        }
+    }
+    return digsep;
+}
+void scanner::number(bool seenPoint) {
+    auto ok = true;
+    LitKind kind = IntLit;
+    auto base = 10;
+    auto prefix = rune_t(0);
+    int64_t digsep = 0;
+    auto invalid = -1;
+    if (!seenPoint) {
+        if ((*this)._ch == '0') {
+            (*this).nextch();
+            switch (lower((*this)._ch)) {
+                case 'x': {
+                    (*this).nextch();
+                    base = 16;
+                    prefix = 'x';
+                } break;
+                case 'o': {
+                    (*this).nextch();
+                    base = 8;
+                    prefix = 'o';
+                } break;
+                case 'b': {
+                    (*this).nextch();
+                    base = 2;
+                    prefix = 'b';
+                } break;
+                default: {
+                    base = 8;
+                    prefix = '0';
+                    digsep = 1;
+                } break;
+            }
+        }
+        digsep |= (*this).digits(base, &invalid);
+        if ((*this)._ch == '.') {
+            if (prefix == 'o' || prefix == 'b') {
+                (*this).errorf("invalid radix point in {} literal", baseName(base));
+                ok = false;
+            }
+            (*this).nextch();
+            seenPoint = true;
+        }
+    }
+    if (seenPoint) {
+        kind = FloatLit;
+        digsep |= (*this).digits(base, &invalid);
+    }
+    if ((digsep & 1) == 0 && ok) {
+        (*this).errorf("{} literal has no digits", baseName(base));
+        ok = false;
+    }
+    {
+        auto e = lower((*this)._ch);
+        if (e == 'e' || e == 'p') {
+            if (ok) {
+                if (e == 'e' && prefix != rune_t(0) && prefix != '0') {
+                    (*this).errorf("{} exponent requires decimal mantissa", quoteRune((*this)._ch));
+                    ok = false;
+                } else if (e == 'p' && prefix != 'x') {
+                    (*this).errorf("{} exponent requires hexadecimal mantissa", quoteRune((*this)._ch));
+                    ok = false;
+                }
+            }
+            (*this).nextch();
+            kind = FloatLit;
+            if ((*this)._ch == '+' || (*this)._ch == '-') {
+                (*this).nextch();
+            }
+            digsep = (*this).digits(10, nullptr) | (digsep & 2);
+            if ((digsep & 1) == 0 && ok) {
+                (*this).errorf("exponent has no digits");
+                ok = false;
+            }
+        } else {
+            if (prefix == 'x' && kind == FloatLit && ok) {
+                (*this).errorf("hexadecimal mantissa requires a 'p' exponent");
+                ok = false;
+            }
+        }
+    }
+    if ((*this)._ch == 'i') {
+        kind = ImagLit;
+        (*this).nextch();
+    }
+    (*this).setLit(kind, ok);
+    if (kind == IntLit && invalid >= 0 && ok) {
+        (*this).errorAtf(invalid, "invalid digit {} in {} literal", quoteRune(rune_t((unsigned char)(*this)._lit[invalid])), baseName(base));
+        ok = false;
+    }
+    if ((digsep & 2) != 0 && ok) {
+        {
+            auto i = invalidSep((*this)._lit);
+            if (i >= 0) {
+                (*this).errorAtf(i, "'_' must separate successive digits");
+                ok = false;
+            }
+        }
+    }
+    (*this)._bad = !ok;
+}
+void scanner::rune() {
+    auto ok = true;
+    (*this).nextch();
+    auto n = 0;
+    for (;; n++) {
+        if ((*this)._ch == '\'') {
+            if (ok) {
+                if (n == 0) {
+                    (*this).errorf("empty rune literal or unescaped '");
+                    ok = false;
+                } else {
+                    if (n != 1) {
+                        (*this).errorAtf(0, "more than one character in rune literal");
+                        ok = false;
+                    }
+                }
+            }
+            (*this).nextch();
+            break;
+        }
+        if ((*this)._ch == '\\') {
+            (*this).nextch();
+            if (!(*this).escape(rune_t((unsigned char)'\''))) {
+                ok = false;
+            }
+            continue;
+        }
+        if ((*this)._ch == '\n') {
+            if (ok) {
+                (*this).errorf("newline in rune literal");
+                ok = false;
+            }
+            break;
+        }
+        if ((*this)._ch < 0) {
+            if (ok) {
+                (*this).errorAtf(0, "rune literal not terminated");
+                ok = false;
+            }
+            break;
+        }
+        (*this).nextch();
+    }
+    (*this).setLit(RuneLit, ok);
+}
+void scanner::stdString() {
+    auto ok = true;
+    (*this).nextch();
+    for (;;) {
+        if ((*this)._ch == '"') {
+            (*this).nextch();
+            break;
+        }
+        if ((*this)._ch == '\\') {
+            (*this).nextch();
+            if (!(*this).escape(rune_t((unsigned char)'"'))) {
+                ok = false;
+            }
+            continue;
+        }
+        if ((*this)._ch == '\n') {
+            (*this).errorf("newline in string");
+            ok = false;
+            break;
+        }
+        if ((*this)._ch < 0) {
+            (*this).errorAtf(0, "string not terminated");
+            ok = false;
+            break;
+        }
+        (*this).nextch();
+    }
+    (*this).setLit(StringLit, ok);
+}
+void scanner::rawString() {
+    auto ok = true;
+    (*this).nextch();
+    for (;;) {
+        if ((*this)._ch == '`') {
+            (*this).nextch();
+            break;
+        }
+        if ((*this)._ch < 0) {
+            (*this).errorAtf(0, "string not terminated");
+            ok = false;
+            break;
+        }
+        (*this).nextch();
+    }
+    (*this).setLit(StringLit, ok);
+}
+void scanner::comment(string text) { (*this).errorAtf(0, "{}", text); }
+void scanner::skipLine() {
+    for (; (*this)._ch >= 0 && (*this)._ch != '\n';) {
+        (*this).nextch();
+    }
+}
+void scanner::lineComment() {
+    if (((*this)._mode & comments) != 0) {
+        (*this).skipLine();
+        (*this).comment(string((*this).segment()));
+        return;
+    }
+    if (((*this)._mode & directives) == 0 || ((*this)._ch != 'g' && (*this)._ch != 'l')) {
+        (*this).stop();
+        (*this).skipLine();
+        return;
+    }
+    // recognize go: or line directives
+    std::string_view prefix = "go:";
+    if ((*this)._ch == 'l') {
+        prefix = "line ";
+    }
+    for (auto m : prefix) {
+        if ((*this)._ch != m) {
+            (*this).stop();
+            (*this).skipLine();
+            return;
+        }
+        (*this).nextch();
+    }
+    (*this).skipLine();
+    (*this).comment(string((*this).segment()));
+}
+bool scanner::skipComment() {
+    for (; (*this)._ch >= 0;) {
+        for (; (*this)._ch == '*';) {
+            (*this).nextch();
+            if ((*this)._ch == '/') {
+                (*this).nextch();
+                return true;
+            }
+        }
+        (*this).nextch();
+    }
+    (*this).errorAtf(0, "comment not terminated");
+    return false;
+}
+void scanner::fullComment() {
+    if (((*this)._mode & comments) != 0) {
+        if ((*this).skipComment()) {
+            (*this).comment(string((*this).segment()));
+        }
+        return;
+    }
+    if (((*this)._mode & directives) == 0 || (*this)._ch != 'l') {
+        (*this).stop();
+        (*this).skipComment();
+        return;
+    }
+    // recognize line directive
+    for (auto m : std::string_view("line ")) {
+        if ((*this)._ch != m) {
+            (*this).stop();
+            (*this).skipComment();
+            return;
+        }
+        (*this).nextch();
+    }
+    if ((*this).skipComment()) {
+        (*this).comment(string((*this).segment()));
+    }
+}
+bool scanner::escape(rune_t quote) {
+    int n;
+    uint32_t base;
+    uint32_t max;
+    if ((*this)._ch == quote) {
+        (*this).nextch();
+        return true;
+    }
+    switch ((int)(*this)._ch) {
+        case 'a':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+        case 'v':
+        case '\\': {
+            (*this).nextch();
+            return true;
+        } break;
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7': {
+            n = 3;
+            base = 8;
+            max = 255;
+        } break;
+        case 'x': {
+            (*this).nextch();
+            n = 2;
+            base = 16;
+            max = 255;
+        } break;
+        case 'u': {
+            (*this).nextch();
+            n = 4;
+            base = 16;
+            max = common::utf8::rune_max;
+        } break;
+        case 'U': {
+            (*this).nextch();
+            n = 8;
+            base = 16;
+            max = common::utf8::rune_max;
+        } break;
+        default: {
+            if ((*this)._ch < 0) {
+                return true;
+            }
+            (*this).errorf("unknown escape");
+            return false;
+        } break;
+    }
+    uint32_t x = 0;
+    {
+        auto i = n;
+        for (; i > 0; i--) {
+            if ((*this)._ch < 0) {
+                return true;
+            }
+            auto d = base;
+            if (isDecimal((*this)._ch)) {
+                d = uint32_t((*this)._ch) - '0';
+            } else {
+                if ('a' <= lower((*this)._ch) && lower((*this)._ch) <= 'f') {
+                    d = uint32_t(lower((*this)._ch)) - 'a' + 10;
+                }
+            }
+            if (d >= base) {
+                (*this).errorf("invalid character {} in {} escape", quoteRune((*this)._ch), baseName(int(base)));
+                return false;
+            }
+            x = x * base + d;
+            (*this).nextch();
+        }
+    }
+    if (x > max && base == 8) {
+        (*this).errorf("octal escape value {} > 255", x);
+        return false;
+    }
+    if (x > max || (0xD800 <= x && x < 0xE000)) {
+        (*this).errorf("escape is invalid Unicode code point {}", runeString(rune_t(int32_t(x))));
+        return false;
+    }
+    return true;
+}
+} // namespace syntax
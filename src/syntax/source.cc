@@ -38,24 +38,28 @@ int64_t nextSize(int64_t size) {
 
 
     void source::init(std::string file, err_handler errh)  {
-        _ifs.open(file);
-        if (!_ifs.good()) {
+        auto ifs = std::make_unique<std::ifstream>(file, std::ios::binary);
+        if (!ifs->good()) {
             std::cout << "open file: " << file << " failed" << std::endl;
             exit(0);
         }
-        _errh = errh;
-        _buf.resize(nextSize(0), 0);
+        init(std::move(ifs), std::move(errh));
+    }
+
+    void source::init(std::unique_ptr<std::istream> in, err_handler errh) {
+        _in = std::move(in);
+        _errh = std::move(errh);
+        _buf.assign(nextSize(0), 0);
         _buf[0] = sentinel;
         _b = -1;
         _r = 0;
         _e = 0;
+        _base = 0;
         _line = 0;
         _col = 0;
+        _file = nullptr;
         _ch = ' ';
         _chw = 0;
-        std::cout << "init buf: " << std::endl
-            << common::HexFormatter::dump_to_string(_buf.data(), 10)
-            << std::endl;
     }
     std::pair<int, int> source::pos() {
         return {linebase + _line, colbase + _col};
@@ -65,15 +69,15 @@ int64_t nextSize(int64_t size) {
         auto [line, col] = pos();
         if (_errh) {
             _errh(line, col, msg);
+            return;
         }
-        std::cout << msg << std::endl;
-        exit(0);
+        std::cout << line << ":" << col << ": " << msg << std::endl;
     }
 
     void source::start() { _b = _r - _chw; }
     void source::stop() { _b = -1; }
 
-    std::string source::segment() { return _buf.substr(_b, _r - _chw - _b); }
+    std::string_view source::segment() { return std::string_view(_buf).substr(_b, _r - _chw - _b); }
 
     void source::rewind() {
         if (_b < 0) {
@@ -90,6 +94,9 @@ int64_t nextSize(int64_t size) {
         if (_ch == '\n') {
             _line++;
             _col = 0;
+            if (_file) {
+                _file->AddLine(_base + _r);
+            }
         }
 
         {
@@ -108,22 +115,20 @@ int64_t nextSize(int64_t size) {
 #define UTFMax 4
 // FullRune reports whether the bytes in p begin with a full UTF-8 encoding of a rune.
 // An invalid encoding is considered a full Rune since it will convert as a width-1 error rune.
-        auto fr = _buf.substr(_r, _e - _r);
         while((_e - _r < UTFMax) &&
-              !common::utf8::full_rune(fr) &&
-              _ifs.good()) {
+              !common::utf8::full_rune(std::string_view(_buf).substr(_r, _e - _r)) &&
+              _in->good()) {
             fill();
         }
         if (_r == _e) {
-            if (!_ifs.eof()) {
+            if (!_in->eof()) {
                 error("I/O error: ");
             }
             _ch = common::utf8::rune_eof;
             _chw = 0;
             return;
         }
-        auto dr = _buf.substr(_r, _e - _r);
-        std::tie(_ch, _chw) = common::utf8::decode_rune(dr);
+        std::tie(_ch, _chw) = common::utf8::decode_rune(std::string_view(_buf).substr(_r, _e - _r));
         _r += _chw;
         if (_ch == common::utf8::rune_invalid && _chw == 1) {
             error("invalid UTF-8 encoding");
@@ -142,33 +147,38 @@ int64_t nextSize(int64_t size) {
         auto bb = _r;
         if (_b >= 0) {
             bb = _b;
-            _b = 0;
+            _b = 0; // after buffer has grown or content has been moved down
         }
 
-        auto content = _buf.substr(bb, _e - bb);
-        if (content.size() * 2 > _buf.size()) {
-            _buf.resize(nextSize(_buf.size()));
-            std::copy(content.begin(), content.end(), _buf.begin());
-        } else if (_b > 0) {
-            std::copy(content.begin(), content.end(), _buf.begin());
+        // grow buffer or move content down
+        auto n = _e - bb;
+        if (n * 2 > int64_t(_buf.size())) {
+            std::string buf(nextSize(_buf.size()), 0);
+            std::copy(_buf.begin() + bb, _buf.begin() + _e, buf.begin());
+            _buf.swap(buf);
+        } else if (bb > 0) {
+            std::copy(_buf.begin() + bb, _buf.begin() + _e, _buf.begin());
         }
         _r -= bb;
         _e -= bb;
-        {
-            auto i = 0;
-            for (; i < 10; i++) {
-                 // -1 to leave space for sentinel
-                _ifs.read(&_buf.front() + _e, _buf.size() - 1 - _e);
-                int n = _ifs.gcount();
-
-                if (n < 0) {
-                    panic("negative read");
-                }
-                if (n > 0 || !_ifs.eof()) {
-                    _e += n;
-                    _buf[_e] = sentinel;
-                    return;
+        _base += bb;
+
+        // read more data: try a limited number of times
+        for (auto i = 0; i < 10; i++) {
+            // -1 to leave space for sentinel
+            _in->read(&_buf.front() + _e, _buf.size() - 1 - _e);
+            auto n = _in->gcount();
+
+            if (n < 0) {
+                panic("negative read");
+            }
+            if (n > 0 || !_in->good()) {
+                if (_file) {
+                    _file->AddSource(_base + _e, std::string_view(_buf).substr(_e, n));
                 }
+                _e += n;
+                _buf[_e] = sentinel;
+                return;
             }
         }
         _buf[_e] = sentinel;
@@ -0,0 +1,841 @@
+#include "syntax/types/check.hh"
+
+#include <algorithm>
+#include <queue>
+#include <unordered_set>
+
+#include <fmt/format.h>
+#include <tbb/parallel_for.h>
+
+#include "syntax/ast/walk.hh"
+#include "syntax/types/export.hh"
+
+namespace types {
+
+namespace {
+
+std::string_view nameOf(common::SymbolId sym) { return common::Interner::Global().Name(sym); }
+
+bool isBlank(const ast::Name *n) { return n->Value == "_"; }
+
+// receiverBase returns the type name of a method receiver of the form
+// T, *T or (T), or 0.
+common::SymbolId receiverBase(ast::ExprNode *t) {
+    for (;;) {
+        if (auto p = dyn_cast<ast::ParenExpr>(t)) {
+            t = p->X.get();
+        } else if (auto op = dyn_cast<ast::Operation>(t); op && op->Op == Operator_Mul && op->Y == nullptr) {
+            t = op->X.get();
+        } else {
+            break;
+        }
+    }
+    auto n = dyn_cast_or_null<ast::Name>(t);
+    return n == nullptr ? 0 : n->Sym;
+}
+
+// contains reports whether a value of type t contains a value of the named
+// type named, which makes named invalid as the underlying type of named.
+bool contains(TypeId t, TypeId named) {
+    auto &table = TypeTable::Global();
+    std::vector<TypeId> work{t};
+    std::unordered_set<TypeId> seen;
+    while (!work.empty()) {
+        auto u = work.back();
+        work.pop_back();
+        if (u == named) {
+            return true;
+        }
+        if (!seen.insert(u).second) {
+            continue;
+        }
+        switch (table.Kind(u)) {
+        case KindNamed:
+            if (auto under = table.Underlying(u)) {
+                work.push_back(under);
+            }
+            break;
+        case KindArray:
+            work.push_back(table[u].Elem());
+            break;
+        case KindStruct:
+            work.insert(work.end(), table[u].Elems.begin(), table[u].Elems.end());
+            break;
+        default:
+            break; // pointers, slices, maps, channels and functions break the containment
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+Checker::Checker(Importer *importer, const Scope *outer) : _importer(importer), _outer(outer) {}
+Checker::~Checker() = default;
+
+Object *Checker::ObjectOf(const ast::Name *name) const {
+    auto it = _uses.find(name);
+    return it == _uses.end() ? nullptr : it->second;
+}
+
+Object *Checker::Implicit(const ast::CaseClause *c) const {
+    auto it = _implicits.find(c);
+    return it == _implicits.end() ? nullptr : it->second;
+}
+
+const Instance *Checker::InstanceOf(const ast::Name *name) const {
+    auto it = _instances.find(name);
+    return it == _instances.end() ? nullptr : &it->second;
+}
+
+std::span<Object *const> Checker::Methods(TypeId t) const {
+    if (auto it = _methods.find(t); it != _methods.end()) {
+        return it->second;
+    }
+    if (auto pkg = _importer == nullptr ? nullptr : _importer->Owner(t)) {
+        return pkg->Methods(t);
+    }
+    return {};
+}
+
+std::vector<Error> Checker::Check(std::span<ast::File *const> files, bool parallel) {
+    _pkg = std::make_unique<Scope>(_outer != nullptr ? _outer : &Universe());
+    Context ctx(*this, _pkg.get());
+    if (!files.empty() && files[0]->PkgName != nullptr) {
+        _name = files[0]->PkgName->Value;
+    }
+
+    // collect the package-level objects of all files
+    for (auto file : files) {
+        collect(ctx, file, &_file_scopes.emplace_back(_pkg.get()));
+    }
+    // the function bodies share these scopes, read-only
+    _pkg->Freeze();
+    for (auto &s : _file_scopes) {
+        s.Freeze();
+    }
+
+    // check the declarations, dependencies first
+    for (auto &component : components()) {
+        for (auto obj : component) {
+            objDecl(ctx, obj);
+        }
+    }
+
+    // check the function bodies
+    std::vector<Object *> funcs;
+    for (auto obj : _decl_order) {
+        auto &d = *_decls.at(obj);
+        if (d.Func != nullptr && d.Func->Body != nullptr) {
+            funcs.push_back(obj);
+        }
+    }
+    std::vector<std::unique_ptr<Context>> units(funcs.size());
+    auto body = [&](size_t i) {
+        auto &d = *_decls.at(funcs[i]);
+        units[i] = std::make_unique<Context>(*this, d.FileScope);
+        units[i]->sink = &units[i]->deps;
+        if (!d.TParams.empty()) {
+            // the type parameters are in scope in the body
+            units[i]->openScope();
+            for (auto tp : d.TParams) {
+                if (nameOf(tp->Name) != "_") {
+                    units[i]->blocks[units[i]->scope].Insert(tp);
+                }
+            }
+        }
+        units[i]->funcBody(d.Func->Type.get(), d.Func->Recv.get(), funcs[i]->Type, d.Recv, d.Func->Body.get());
+    };
+    if (parallel) {
+        tbb::parallel_for(size_t(0), funcs.size(), body);
+    } else {
+        for (size_t i = 0; i < funcs.size(); i++) {
+            body(i);
+        }
+    }
+
+    std::vector<Error> errors;
+    merge(ctx, errors);
+    for (size_t i = 0; i < funcs.size(); i++) {
+        _decls.at(funcs[i])->Uses = std::move(units[i]->deps);
+        merge(*units[i], errors);
+    }
+    units.clear();
+
+    for (auto obj : _imports) {
+        if (!obj->Used) {
+            errors.push_back({obj->Pos, fmt::format("\"{}\" imported and not used", obj->Path)});
+        }
+    }
+    initOrder(errors);
+
+    std::stable_sort(errors.begin(), errors.end(), [](const Error &a, const Error &b) { return a.Pos < b.Pos; });
+    return errors;
+}
+
+// merge adds the results of a finished context to the checker.
+void Checker::merge(Context &ctx, std::vector<Error> &errors) {
+    errors.insert(errors.end(), std::make_move_iterator(ctx.errors.begin()),
+                  std::make_move_iterator(ctx.errors.end()));
+    for (auto [name, obj] : ctx.uses) {
+        _uses.emplace(name, obj);
+        if (obj != nullptr && obj->Kind == ObjKind::PkgName) {
+            obj->Used = true;
+        }
+    }
+    _implicits.insert(ctx.implicits.begin(), ctx.implicits.end());
+    for (auto &[name, inst] : ctx.instances) {
+        _instances.emplace(name, std::move(inst));
+    }
+    if (!ctx.objects.empty()) {
+        _locals.push_back(std::move(ctx.objects));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Collection of package-level objects
+
+void Checker::collect(Context &ctx, ast::File *file, Scope *fileScope) {
+    auto &interner = common::Interner::Global();
+    auto newObject = [&](ObjKind kind, ast::Name *name, ast::DeclNode *decl) {
+        auto obj = &_objects.emplace_back();
+        obj->Kind = kind;
+        obj->Name = name->Sym;
+        obj->Pos = name->pos;
+        obj->Decl = decl;
+        auto &d = *_decls.emplace(obj, std::make_unique<DeclInfo>()).first->second;
+        d.FileScope = fileScope;
+        _decl_order.push_back(obj);
+        ctx.uses.emplace_back(name, obj);
+        return std::pair<Object *, DeclInfo &>(obj, d);
+    };
+
+    const ast::Group *group = nullptr;
+    ast::ConstDecl *last = nullptr; // last constant spec with a type or values in the group
+    int64_t iota = 0;
+    for (auto &decl : file->DeclList) {
+        if (auto c = dyn_cast<ast::ConstDecl>(decl.get()); c == nullptr || c->Group == nullptr ||
+                                                              c->Group.get() != group) {
+            group = c == nullptr ? nullptr : c->Group.get();
+            last = nullptr;
+            iota = 0;
+        }
+        switch (decl->Kind()) {
+        case ast::NodeKind::ImportDecl: {
+            auto d = cast<ast::ImportDecl>(decl.get());
+            if (d->Path == nullptr || d->Path->Bad || d->Path->Value.size() < 2) {
+                break;
+            }
+            auto path = std::string_view(d->Path->Value).substr(1, d->Path->Value.size() - 2);
+            auto pkg = _importer == nullptr ? nullptr : _importer->Import(path);
+            if (pkg == nullptr && _importer != nullptr) {
+                // reported once here; the uses of the package are left
+                // unresolved without errors of their own
+                ctx.errorf(d->Path->pos, fmt::format("could not import {}", path));
+            }
+            auto name = d->LocalPkgName != nullptr ? std::string_view(d->LocalPkgName->Value)
+                        : pkg != nullptr           ? pkg->Name()
+                                                   : path.substr(path.rfind('/') + 1);
+            if (name == "_" || name == ".") {
+                break; // nothing to declare; dot imports need the imported package
+            }
+            auto obj = &_objects.emplace_back();
+            obj->Kind = ObjKind::PkgName;
+            obj->Name = interner.Intern(name);
+            obj->Pos = d->pos;
+            obj->Path = interner.Name(interner.Intern(path));
+            obj->Imported = pkg;
+            obj->Used = pkg == nullptr && _importer != nullptr; // not reported unused as well
+            if (fileScope->Insert(obj) != nullptr) {
+                ctx.errorf(d->pos, fmt::format("{} redeclared in this block", name));
+            }
+            if (d->LocalPkgName != nullptr) {
+                ctx.uses.emplace_back(d->LocalPkgName.get(), obj);
+            }
+            _imports.push_back(obj);
+            break;
+        }
+        case ast::NodeKind::ConstDecl: {
+            auto d = cast<ast::ConstDecl>(decl.get());
+            if (d->Type != nullptr || d->Values != nullptr) {
+                last = d;
+            }
+            for (size_t i = 0; i < d->NameList.size(); i++) {
+                auto [obj, info] = newObject(ObjKind::Const, d->NameList[i].get(), d);
+                info.Type = last == nullptr ? nullptr : last->Type.get();
+                info.Init = last == nullptr ? nullptr : last->Values.get();
+                info.Iota = iota;
+                info.Index = i;
+                declare(ctx, _pkg.get(), obj);
+            }
+            iota++;
+            break;
+        }
+        case ast::NodeKind::VarDecl: {
+            auto d = cast<ast::VarDecl>(decl.get());
+            std::vector<Object *> lhs;
+            for (size_t i = 0; i < d->NameList.size(); i++) {
+                auto [obj, info] = newObject(ObjKind::Var, d->NameList[i].get(), d);
+                info.Type = d->Type.get();
+                info.Init = d->Values.get();
+                info.Index = i;
+                lhs.push_back(obj);
+                declare(ctx, _pkg.get(), obj);
+            }
+            // var a, b = f() initializes all names at once
+            if (d->Values != nullptr && lhs.size() > 1 && !isa<ast::ListExpr>(d->Values.get())) {
+                for (auto obj : lhs) {
+                    _decls.at(obj)->Lhs = lhs;
+                }
+            }
+            break;
+        }
+        case ast::NodeKind::TypeDecl: {
+            auto d = cast<ast::TypeDecl>(decl.get());
+            auto [obj, info] = newObject(ObjKind::TypeName, d->Name.get(), d);
+            info.Type = d->Type.get();
+            if (!d->Alias) {
+                obj->Type = TypeTable::Global().NewNamed(obj->Name);
+                _type_names.emplace(obj->Type, obj);
+            }
+            declare(ctx, _pkg.get(), obj);
+            break;
+        }
+        case ast::NodeKind::FuncDecl: {
+            auto d = cast<ast::FuncDecl>(decl.get());
+            auto [obj, info] = newObject(ObjKind::Func, d->Name.get(), d);
+            info.Func = d;
+            if (d->Recv != nullptr) {
+                // methods are associated with their receiver type when it is declared
+                if (auto base = receiverBase(d->Recv->Type.get())) {
+                    _method_decls[base].push_back(obj);
+                }
+            } else if (d->Name->Value == "init") {
+                if (!d->TParamList.empty()) {
+                    ctx.error(d->Name.get(), "func init must have no type parameters");
+                } else if (!d->Type->ParamList.empty() || !d->Type->ResultList.empty()) {
+                    ctx.error(d->Name.get(), "func init must have no arguments and no return values");
+                }
+            } else {
+                declare(ctx, _pkg.get(), obj);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+void Checker::declare(Context &ctx, Scope *scope, Object *obj) {
+    if (nameOf(obj->Name) == "_") {
+        return;
+    }
+    if (scope->Insert(obj) != nullptr) {
+        ctx.errorf(obj->Pos, fmt::format("{} redeclared in this block", nameOf(obj->Name)));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Dependency graph
+
+// components returns the strongly connected components of the dependency
+// graph of the package-level objects, dependencies first. The objects of a
+// component, and independent components, are in declaration order.
+std::vector<std::vector<Object *>> Checker::components() {
+    std::unordered_map<const Object *, size_t> index;
+    for (size_t i = 0; i < _decl_order.size(); i++) {
+        index.emplace(_decl_order[i], i);
+    }
+
+    // the edges of an object are the package-level objects its declaration
+    // refers to, except from within function bodies
+    std::vector<std::vector<size_t>> edges(_decl_order.size());
+    ast::Walker w;
+    for (size_t i = 0; i < _decl_order.size(); i++) {
+        auto &d = *_decls.at(_decl_order[i]);
+        auto visit = [&](ast::Node *n) {
+            if (isa<ast::BlockStmt>(n)) {
+                return ast::Visit::SkipChildren;
+            }
+            auto name = dyn_cast<ast::Name>(n);
+            if (name == nullptr) {
+                return ast::Visit::Children;
+            }
+            // skip selectors, field and parameter names and literal keys
+            auto parent = w.Parent();
+            if (auto s = dyn_cast_or_null<ast::SelectorExpr>(parent); s && s->Sel.get() == name) {
+                return ast::Visit::SkipChildren;
+            }
+            if (auto f = dyn_cast_or_null<ast::Field>(parent); f && f->Name.get() == name) {
+                return ast::Visit::SkipChildren;
+            }
+            if (auto kv = dyn_cast_or_null<ast::KeyValueExpr>(parent); kv && kv->Key.get() == name) {
+                return ast::Visit::SkipChildren;
+            }
+            auto obj = d.FileScope->Lookup(name->Sym);
+            if (obj != nullptr && obj->IsPackageLevel()) {
+                auto j = index.at(obj);
+                if (std::find(edges[i].begin(), edges[i].end(), j) == edges[i].end()) {
+                    edges[i].push_back(j);
+                    d.Deps.push_back(obj);
+                }
+            }
+            return ast::Visit::SkipChildren;
+        };
+        if (d.Func != nullptr) {
+            w.Walk(d.Func->Recv.get(), visit);
+            for (auto &f : d.Func->TParamList) {
+                w.Walk(f.get(), visit);
+            }
+            w.Walk(d.Func->Type.get(), visit);
+        } else {
+            w.Walk(d.Type, visit);
+            w.Walk(d.Init, visit);
+        }
+    }
+
+    // Tarjan's algorithm, without recursion
+    const size_t none = ~size_t(0);
+    std::vector<size_t> order(edges.size(), none), low(edges.size());
+    std::vector<bool> on_stack(edges.size());
+    std::vector<size_t> stack;
+    std::vector<std::pair<size_t, size_t>> frames; // node, next edge
+    std::vector<std::vector<Object *>> result;
+    size_t counter = 0;
+    for (size_t root = 0; root < edges.size(); root++) {
+        if (order[root] != none) {
+            continue;
+        }
+        frames.push_back({root, 0});
+        while (!frames.empty()) {
+            auto &[v, next] = frames.back();
+            if (next == 0 && order[v] == none) {
+                order[v] = low[v] = counter++;
+                stack.push_back(v);
+                on_stack[v] = true;
+            }
+            if (next < edges[v].size()) {
+                auto u = edges[v][next++];
+                if (order[u] == none) {
+                    frames.push_back({u, 0});
+                } else if (on_stack[u]) {
+                    low[v] = std::min(low[v], order[u]);
+                }
+                continue;
+            }
+            if (low[v] == order[v]) {
+                auto &component = result.emplace_back();
+                size_t u;
+                do {
+                    u = stack.back();
+                    stack.pop_back();
+                    on_stack[u] = false;
+                    component.push_back(_decl_order[u]);
+                } while (u != v);
+                std::sort(component.begin(), component.end(),
+                          [&](Object *a, Object *b) { return index.at(a) < index.at(b); });
+            }
+            auto done = v;
+            frames.pop_back();
+            if (!frames.empty()) {
+                auto parent = frames.back().first;
+                low[parent] = std::min(low[parent], low[done]);
+            }
+        }
+    }
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// Package-level declarations
+
+// objDecl checks the declaration of a package-level object unless it has
+// been checked already. Objects are normally checked in dependency order;
+// objDecl is also called on demand when an object is used, which detects
+// the cycles that make a declaration invalid.
+void Checker::objDecl(Context &ctx, Object *obj) {
+    auto it = _decls.find(obj);
+    if (it == _decls.end()) {
+        return;
+    }
+    auto &d = *it->second;
+    if (d.state == DeclInfo::Resolved) {
+        return;
+    }
+    if (d.state == DeclInfo::Resolving) {
+        switch (obj->Kind) {
+        case ObjKind::Const:
+        case ObjKind::Var:
+            if (!d.Cyclic) {
+                ctx.errorf(obj->Pos, fmt::format("initialization cycle for {}", nameOf(obj->Name)));
+                d.Cyclic = true;
+            }
+            break;
+        case ObjKind::TypeName:
+            if (!d.Cyclic) {
+                ctx.errorf(obj->Pos, fmt::format("invalid recursive type {}", nameOf(obj->Name)));
+                d.Cyclic = true;
+            }
+            break;
+        default:
+            break;
+        }
+        return;
+    }
+
+    d.state = DeclInfo::Resolving;
+    auto scope = std::exchange(ctx.scope, NoScope);
+    auto outer = ctx.blocks.Outer();
+    ctx.blocks.SetOuter(d.FileScope);
+    auto sink = std::exchange(ctx.sink, &d.Uses);
+    auto iota = std::exchange(ctx.iota, -1);
+    switch (obj->Kind) {
+    case ObjKind::Const:
+        constDecl(ctx, obj, d);
+        break;
+    case ObjKind::Var:
+        varDecl(ctx, obj, d);
+        break;
+    case ObjKind::TypeName:
+        typeDecl(ctx, obj, d);
+        break;
+    case ObjKind::Func:
+        funcDecl(ctx, obj, d);
+        break;
+    default:
+        break;
+    }
+    ctx.scope = scope;
+    ctx.blocks.SetOuter(outer);
+    ctx.sink = sink;
+    ctx.iota = iota;
+    d.state = DeclInfo::Resolved;
+}
+
+void Checker::constDecl(Context &ctx, Object *obj, DeclInfo &d) {
+    ctx.iota = d.Iota;
+    TypeId t = 0;
+    if (d.Type != nullptr) {
+        t = ctx.typExpr(d.Type);
+        if (t != 0 && !IsConstType(t)) {
+            ctx.error(d.Type, fmt::format("invalid constant type {}", TypeTable::Global().String(t)));
+            return;
+        }
+    }
+    ast::ExprNode *init = d.Init;
+    if (auto l = dyn_cast_or_null<ast::ListExpr>(init)) {
+        init = d.Index < l->ElemList.size() ? l->ElemList[d.Index].get() : nullptr;
+    } else if (d.Index > 0) {
+        init = nullptr;
+    }
+    if (init == nullptr) {
+        ctx.errorf(obj->Pos, "missing init expr for const declaration");
+        return;
+    }
+    Operand x;
+    ctx.expr(x, init);
+    if (x.Invalid()) {
+        return;
+    }
+    if (x.mode != Mode::Constant) {
+        ctx.error(init, fmt::format("{} is not constant", ctx.describe(x)));
+        return;
+    }
+    if (t != 0) {
+        ctx.assignment(x, t, "constant declaration");
+        if (x.Invalid()) {
+            return;
+        }
+    }
+    obj->Type = x.type;
+    obj->Val = x.val;
+}
+
+void Checker::varDecl(Context &ctx, Object *obj, DeclInfo &d) {
+    auto declared = [&](Object *v) {
+        auto &vd = *_decls.at(v);
+        if (vd.Type != nullptr && v->Type == 0) {
+            v->Type = ctx.typExpr(vd.Type);
+        }
+    };
+    if (!d.Lhs.empty()) {
+        // all variables are initialized together
+        for (auto v : d.Lhs) {
+            declared(v);
+            if (v != obj) {
+                _decls.at(v)->state = DeclInfo::Resolving;
+            }
+        }
+        ast::ExprNodePtr init[] = {cast<ast::ExprNode>(d.Init->shared_from_this())};
+        ctx.initVars(d.Lhs, init, obj->Decl);
+        for (auto v : d.Lhs) {
+            if (v != obj) {
+                _decls.at(v)->state = DeclInfo::Resolved;
+                _decls.at(v)->Uses = d.Uses;
+            }
+        }
+        return;
+    }
+    declared(obj);
+    if (d.Init == nullptr) {
+        return;
+    }
+    std::vector<ast::ExprNodePtr> values;
+    if (auto l = dyn_cast<ast::ListExpr>(d.Init)) {
+        values = l->ElemList;
+    } else {
+        values.push_back(cast<ast::ExprNode>(d.Init->shared_from_this()));
+    }
+    if (d.Index == 0 && values.size() != cast<ast::VarDecl>(obj->Decl)->NameList.size()) {
+        auto n = cast<ast::VarDecl>(obj->Decl)->NameList.size();
+        ctx.errorf(obj->Pos, fmt::format("assignment mismatch: {} variable{} but {} value{}", n, n == 1 ? "" : "s",
+                                         values.size(), values.size() == 1 ? "" : "s"));
+    }
+    if (d.Index >= values.size()) {
+        return;
+    }
+    Object *lhs[] = {obj};
+    ast::ExprNodePtr rhs[] = {values[d.Index]};
+    ctx.initVars(lhs, rhs, obj->Decl);
+}
+
+void Checker::typeDecl(Context &ctx, Object *obj, DeclInfo &d) {
+    auto &table = TypeTable::Global();
+    auto rhs = ctx.typExpr(d.Type, true);
+    if (cast<ast::TypeDecl>(obj->Decl)->Alias) {
+        obj->Type = rhs;
+        return;
+    }
+    // the underlying type of a named type on the right is needed now
+    if (rhs != 0 && table.Kind(rhs) == KindNamed && table.Underlying(rhs) == 0) {
+        bool reported = false;
+        if (auto it = _type_names.find(rhs); it != _type_names.end()) {
+            objDecl(ctx, it->second);
+            reported = _decls.at(it->second)->Cyclic;
+        }
+        // the cycle is reported once, at the declaration that closes it
+        if (table.Underlying(rhs) == 0 && !d.Cyclic && !reported) {
+            ctx.errorf(obj->Pos, fmt::format("invalid recursive type {}", nameOf(obj->Name)));
+        }
+        d.Cyclic = d.Cyclic || table.Underlying(rhs) == 0;
+    }
+    auto under = rhs == 0 ? TypeId(0) : table.Underlying(rhs);
+    if (under != 0 && contains(under, obj->Type) && !d.Cyclic) {
+        ctx.errorf(obj->Pos, fmt::format("invalid recursive type {}", nameOf(obj->Name)));
+        d.Cyclic = true;
+        under = 0;
+    }
+    table.SetUnderlying(obj->Type, under);
+
+    // the methods are part of the type
+    if (auto it = _method_decls.find(obj->Name); it != _method_decls.end()) {
+        for (auto m : it->second) {
+            objDecl(ctx, m);
+        }
+    }
+}
+
+void Checker::funcDecl(Context &ctx, Object *obj, DeclInfo &d) {
+    auto &table = TypeTable::Global();
+    auto f = d.Func;
+    if (f->Recv != nullptr) {
+        d.Recv = ctx.typExpr(f->Recv->Type.get());
+    }
+    if (!f->TParamList.empty()) {
+        // the type parameters are in scope in the signature
+        ctx.openScope();
+        ctx.typeParams(f->TParamList, obj, d);
+        obj->Type = ctx.funcType(f->Type.get());
+        ctx.closeScope();
+    } else {
+        obj->Type = ctx.funcType(f->Type.get());
+    }
+    if (f->Body == nullptr && f->Recv == nullptr && !f->Skipped() && f->Name->Value == "init") {
+        ctx.error(f->Name.get(), "missing function body");
+    }
+    if (f->Recv == nullptr || d.Recv == 0) {
+        return;
+    }
+
+    // the receiver must be a type T or *T declared in this package, where
+    // T is neither a pointer nor an interface
+    auto base = d.Recv;
+    if (table.Kind(base) == KindPointer) {
+        base = table[base].Elem();
+        obj->PtrRecv = true;
+    }
+    auto tn = _type_names.find(base);
+    if (table.Kind(base) != KindNamed || tn == _type_names.end()) {
+        ctx.error(f->Recv->Type.get(),
+                  fmt::format("cannot define new methods on non-local type {}", table.String(base)));
+        return;
+    }
+    auto under = table.Underlying(base);
+    if (under != 0 && (table.Kind(under) == KindPointer || table.Kind(under) == KindInterface)) {
+        ctx.error(f->Recv->Type.get(), fmt::format("invalid receiver type {}", table.String(d.Recv)));
+        return;
+    }
+    auto &methods = _methods[base];
+    for (auto m : methods) {
+        if (m->Name == obj->Name && nameOf(obj->Name) != "_") {
+            ctx.errorf(obj->Pos, fmt::format("method {}.{} already declared", table.String(base), nameOf(obj->Name)));
+            return;
+        }
+    }
+    if (under != 0 && table.Kind(under) == KindStruct) {
+        for (auto name : table[under].Names) {
+            if (FieldName(name) == obj->Name) {
+                ctx.errorf(obj->Pos, fmt::format("field and method with the same name {}", nameOf(obj->Name)));
+                return;
+            }
+        }
+    }
+    methods.push_back(obj);
+}
+
+// ----------------------------------------------------------------------------
+// Initialization order
+
+// initOrder computes the order in which the package-level variables are
+// initialized: repeatedly the earliest variable in declaration order that
+// does not depend on uninitialized variables, where dependencies through
+// functions count.
+void Checker::initOrder(std::vector<Error> &errors) {
+    std::vector<Object *> vars;
+    std::unordered_map<const Object *, size_t> index;
+    for (auto obj : _decl_order) {
+        if (obj->Kind == ObjKind::Var) {
+            index.emplace(obj, vars.size());
+            vars.push_back(obj);
+        }
+    }
+
+    // the variables each variable depends on, directly or through functions
+    // a cycle found while checking the declarations is reported already
+    auto cycle = [&](size_t i) {
+        auto &d = *_decls.at(vars[i]);
+        if (!d.Cyclic) {
+            errors.push_back({vars[i]->Pos, fmt::format("initialization cycle for {}", nameOf(vars[i]->Name))});
+            d.Cyclic = true;
+        }
+    };
+
+    std::vector<std::vector<size_t>> deps(vars.size());
+    std::vector<size_t> count(vars.size());
+    std::vector<std::vector<size_t>> dependents(vars.size());
+    for (size_t i = 0; i < vars.size(); i++) {
+        std::vector<const Object *> work(_decls.at(vars[i])->Uses.begin(), _decls.at(vars[i])->Uses.end());
+        std::unordered_map<const Object *, bool> seen;
+        while (!work.empty()) {
+            auto obj = work.back();
+            work.pop_back();
+            if (!seen.emplace(obj, true).second) {
+                continue;
+            }
+            if (obj->Kind == ObjKind::Var) {
+                auto j = index.at(obj);
+                if (j == i) {
+                    cycle(i);
+                } else {
+                    deps[i].push_back(j);
+                }
+            } else if (obj->Kind == ObjKind::Func) {
+                auto &uses = _decls.at(obj)->Uses;
+                work.insert(work.end(), uses.begin(), uses.end());
+            }
+        }
+        count[i] = deps[i].size();
+        for (auto j : deps[i]) {
+            dependents[j].push_back(i);
+        }
+    }
+
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<>> ready;
+    for (size_t i = 0; i < vars.size(); i++) {
+        if (count[i] == 0) {
+            ready.push(i);
+        }
+    }
+    std::vector<bool> done(vars.size());
+    while (_init_order.size() < vars.size()) {
+        if (ready.empty()) {
+            // a cycle through functions: report it and break it at the
+            // earliest variable
+            size_t i = 0;
+            while (done[i]) {
+                i++;
+            }
+            cycle(i);
+            count[i] = 0;
+            ready.push(i);
+        }
+        auto i = ready.top();
+        ready.pop();
+        if (done[i]) {
+            continue;
+        }
+        done[i] = true;
+        _init_order.push_back(vars[i]);
+        for (auto j : dependents[i]) {
+            if (--count[j] == 0 && !done[j]) {
+                ready.push(j);
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Context
+
+void Checker::Context::errorf(syntax::Pos pos, std::string msg) { errors.push_back({pos, std::move(msg)}); }
+
+void Checker::Context::openScope() { scope = blocks.Open(scope); }
+
+void Checker::Context::closeScope() { scope = blocks.Parent(scope); }
+
+Object *Checker::Context::newObject(ObjKind kind, const ast::Name *name, TypeId type) {
+    auto obj = &objects.emplace_back();
+    obj->Kind = kind;
+    obj->Name = name->Sym;
+    obj->Pos = name->pos;
+    obj->Type = type;
+    return obj;
+}
+
+void Checker::Context::declare(Object *obj, const ast::Name *name) {
+    uses.emplace_back(name, obj);
+    if (isBlank(name)) {
+        return;
+    }
+    if (blocks[scope].Insert(obj) != nullptr) {
+        errorf(name->pos, fmt::format("{} redeclared in this block", name->Value));
+    }
+}
+
+Object *Checker::Context::declareVar(const ast::Name *name, TypeId type) {
+    auto obj = newObject(ObjKind::Var, name, type);
+    declare(obj, name);
+    if (!isBlank(name)) {
+        vars.push_back(obj);
+    }
+    return obj;
+}
+
+Object *Checker::Context::lookup(const ast::Name *name) { return blocks.Lookup(scope, name->Sym); }
+
+void Checker::Context::use(const ast::Name *name, Object *obj, bool value) {
+    uses.emplace_back(name, obj);
+    if (obj->IsPackageLevel()) {
+        if (sink != nullptr) {
+            sink->push_back(obj);
+        }
+    } else if (value && obj->Kind == ObjKind::Var) {
+        // the objects of the outer scope are shared: nothing to mark
+        if (check._outer == nullptr || check._outer->LookupLocal(obj->Name) != obj) {
+            obj->Used = true;
+        }
+    }
+}
+
+} // namespace types
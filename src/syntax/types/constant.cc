@@ -0,0 +1,1465 @@
+#include "syntax/types/constant.hh"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+#include <fmt/format.h>
+
+namespace types {
+
+namespace {
+
+using Mag = std::vector<uint32_t>;
+using u128 = unsigned __int128;
+
+// ----------------------------------------------------------------------------
+// Magnitudes
+
+void trim(Mag &m) {
+    while (!m.empty() && m.back() == 0) {
+        m.pop_back();
+    }
+}
+
+Mag magOf(uint64_t v) {
+    Mag m{uint32_t(v), uint32_t(v >> 32)};
+    trim(m);
+    return m;
+}
+
+int cmpMag(const Mag &a, const Mag &b) {
+    if (a.size() != b.size()) {
+        return a.size() < b.size() ? -1 : 1;
+    }
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+Mag addMag(const Mag &a, const Mag &b) {
+    auto &x = a.size() >= b.size() ? a : b;
+    auto &y = a.size() >= b.size() ? b : a;
+    Mag r(x.size() + 1);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < x.size(); i++) {
+        carry += uint64_t(x[i]) + (i < y.size() ? y[i] : 0);
+        r[i] = uint32_t(carry);
+        carry >>= 32;
+    }
+    r[x.size()] = uint32_t(carry);
+    trim(r);
+    return r;
+}
+
+// subMag returns a - b for a >= b.
+Mag subMag(const Mag &a, const Mag &b) {
+    Mag r(a.size());
+    int64_t borrow = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        int64_t d = int64_t(a[i]) - (i < b.size() ? b[i] : 0) - borrow;
+        borrow = d < 0;
+        r[i] = uint32_t(d);
+    }
+    trim(r);
+    return r;
+}
+
+Mag mulMag(const Mag &a, const Mag &b) {
+    if (a.empty() || b.empty()) {
+        return {};
+    }
+    Mag r(a.size() + b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < b.size(); j++) {
+            uint64_t t = uint64_t(a[i]) * b[j] + r[i + j] + carry;
+            r[i + j] = uint32_t(t);
+            carry = t >> 32;
+        }
+        r[i + b.size()] = uint32_t(carry);
+    }
+    trim(r);
+    return r;
+}
+
+// mulAddSmall sets m to m*mul + add.
+void mulAddSmall(Mag &m, uint32_t mul, uint32_t add) {
+    uint64_t carry = add;
+    for (auto &w : m) {
+        carry += uint64_t(w) * mul;
+        w = uint32_t(carry);
+        carry >>= 32;
+    }
+    if (carry != 0) {
+        m.push_back(uint32_t(carry));
+    }
+}
+
+// divSmall sets m to m/d and returns the remainder.
+uint32_t divSmall(Mag &m, uint32_t d) {
+    uint64_t rem = 0;
+    for (size_t i = m.size(); i-- > 0;) {
+        uint64_t cur = rem << 32 | m[i];
+        m[i] = uint32_t(cur / d);
+        rem = cur % d;
+    }
+    trim(m);
+    return uint32_t(rem);
+}
+
+Mag shlMag(const Mag &a, uint64_t s) {
+    if (a.empty()) {
+        return {};
+    }
+    size_t words = s / 32;
+    unsigned bits = s % 32;
+    Mag r(a.size() + words + 1);
+    for (size_t i = 0; i < a.size(); i++) {
+        r[i + words] |= a[i] << bits;
+        if (bits != 0) {
+            r[i + words + 1] |= a[i] >> (32 - bits);
+        }
+    }
+    trim(r);
+    return r;
+}
+
+Mag shrMag(const Mag &a, uint64_t s) {
+    size_t words = s / 32;
+    unsigned bits = s % 32;
+    if (words >= a.size()) {
+        return {};
+    }
+    Mag r(a.size() - words);
+    for (size_t i = 0; i < r.size(); i++) {
+        r[i] = a[i + words] >> bits;
+        if (bits != 0 && i + words + 1 < a.size()) {
+            r[i] |= a[i + words + 1] << (32 - bits);
+        }
+    }
+    trim(r);
+    return r;
+}
+
+// divModMag computes the quotient and remainder of u/v for a non-zero v,
+// with Knuth's algorithm D.
+void divModMag(const Mag &u, const Mag &v, Mag &q, Mag &r) {
+    if (cmpMag(u, v) < 0) {
+        q.clear();
+        r = u;
+        return;
+    }
+    if (v.size() == 1) {
+        q = u;
+        auto rem = divSmall(q, v[0]);
+        r = rem == 0 ? Mag{} : Mag{rem};
+        return;
+    }
+    // normalize so that the top bit of the divisor is set
+    int s = __builtin_clz(v.back());
+    Mag vn = shlMag(v, s);
+    Mag un = shlMag(u, s);
+    un.resize(u.size() + 1);
+    size_t n = v.size(), m = u.size() - n;
+    q.assign(m + 1, 0);
+    for (size_t j = m + 1; j-- > 0;) {
+        uint64_t num = uint64_t(un[j + n]) << 32 | un[j + n - 1];
+        uint64_t qhat = num / vn[n - 1], rhat = num % vn[n - 1];
+        while (qhat >> 32 != 0 || qhat * vn[n - 2] > (rhat << 32 | un[j + n - 2])) {
+            qhat--;
+            rhat += vn[n - 1];
+            if (rhat >> 32 != 0) {
+                break;
+            }
+        }
+        // multiply and subtract
+        uint64_t carry = 0;
+        int64_t borrow = 0;
+        for (size_t i = 0; i < n; i++) {
+            uint64_t p = qhat * vn[i] + carry;
+            carry = p >> 32;
+            int64_t t = int64_t(un[i + j]) - borrow - int64_t(p & 0xffffffff);
+            un[i + j] = uint32_t(t);
+            borrow = t < 0;
+        }
+        int64_t t = int64_t(un[j + n]) - borrow - int64_t(carry);
+        un[j + n] = uint32_t(t);
+        if (t < 0) {
+            // qhat was one too large: add the divisor back
+            qhat--;
+            uint64_t c = 0;
+            for (size_t i = 0; i < n; i++) {
+                c += uint64_t(un[i + j]) + vn[i];
+                un[i + j] = uint32_t(c);
+                c >>= 32;
+            }
+            un[j + n] += uint32_t(c);
+        }
+        q[j] = uint32_t(qhat);
+    }
+    trim(q);
+    un.resize(n);
+    trim(un);
+    r = shrMag(un, s);
+}
+
+// toTwos returns the n-word two's complement form of a value.
+Mag toTwos(bool neg, const Mag &mag, size_t n) {
+    Mag r = mag;
+    r.resize(n);
+    if (neg) {
+        uint64_t carry = 1;
+        for (auto &w : r) {
+            carry += uint32_t(~w);
+            w = uint32_t(carry);
+            carry >>= 32;
+        }
+    }
+    return r;
+}
+
+// fromTwos returns the magnitude of the two's complement form r and sets
+// neg to its sign.
+Mag fromTwos(Mag r, bool &neg) {
+    neg = !r.empty() && r.back() >> 31 != 0;
+    if (neg) {
+        uint64_t carry = 1;
+        for (auto &w : r) {
+            carry += uint32_t(~w);
+            w = uint32_t(carry);
+            carry >>= 32;
+        }
+    }
+    trim(r);
+    return r;
+}
+
+BigInt fromInt128(__int128 v) {
+    auto u = u128(v < 0 ? -v : v);
+    auto r = (BigInt::FromUint64(uint64_t(u >> 64)) << 64) + BigInt::FromUint64(uint64_t(u));
+    return v < 0 ? -r : r;
+}
+
+u128 gcd128(u128 a, u128 b) {
+    if (a >> 64 == 0 && b >> 64 == 0) {
+        return std::gcd(uint64_t(a), uint64_t(b)); // 128-bit division is slow
+    }
+    while (b != 0) {
+        auto t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+bool fitsInline(__int128 v) { return v > INT64_MIN && v <= INT64_MAX; }
+
+bool fitsInline(const BigInt &v) { return v.IsInt64() && v.Int64() != INT64_MIN; }
+
+// ratToFloat returns num/den rounded to a binary floating-point number with
+// a prec-bit mantissa, rounding half to even.
+double ratToFloat(const BigInt &num, const BigInt &den, int prec) {
+    if (num.Sign() == 0) {
+        return 0;
+    }
+    auto a = num.Sign() < 0 ? -num : num;
+    // q has prec+2 or prec+3 bits; the remainder is the sticky bit
+    int64_t sh = den.BitLen() - a.BitLen() + prec + 2;
+    BigInt q, r;
+    if (sh >= 0) {
+        auto t = a << uint64_t(sh);
+        q = t / den;
+        r = t % den;
+    } else {
+        auto d = den << uint64_t(-sh);
+        q = a / d;
+        r = a % d;
+    }
+    int64_t drop = q.BitLen() - prec;
+    auto mant = uint64_t((q >> uint64_t(drop)).Int64());
+    auto low = q - ((q >> uint64_t(drop - 1)) << uint64_t(drop - 1));
+    bool half = ((q >> uint64_t(drop - 1)).Int64() & 1) != 0;
+    if (half && (low.Sign() != 0 || r.Sign() != 0 || (mant & 1) != 0)) {
+        mant++;
+    }
+    int64_t exp = drop - sh;
+    double d = exp > 4096 ? HUGE_VAL : exp < -4096 ? 0 : std::ldexp(double(mant), int(exp));
+    return num.Sign() < 0 ? -d : d;
+}
+
+// ----------------------------------------------------------------------------
+// Literals
+
+int digitVal(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;
+    return c >= 'a' && c <= 'f' ? c - 'a' + 10 : 16;
+}
+
+// validDigits reports whether s has at least one digit and only digits of
+// the given base and '_' separators.
+bool validDigits(std::string_view s, int base) {
+    bool any = false;
+    for (auto c : s) {
+        if (c == '_') {
+            continue;
+        }
+        if (digitVal(c) >= base) {
+            return false;
+        }
+        any = true;
+    }
+    return any;
+}
+
+Value parseInt(std::string_view lit) {
+    int base = 10;
+    if (lit.size() > 1 && lit[0] == '0') {
+        switch (lit[1] | 0x20) {
+        case 'x':
+            base = 16;
+            lit.remove_prefix(2);
+            break;
+        case 'b':
+            base = 2;
+            lit.remove_prefix(2);
+            break;
+        case 'o':
+            base = 8;
+            lit.remove_prefix(2);
+            break;
+        default:
+            base = 8;
+            break;
+        }
+    }
+    if (!validDigits(lit, base)) {
+        return {};
+    }
+    int64_t v = 0;
+    for (auto c : lit) {
+        if (c != '_' && (__builtin_mul_overflow(v, base, &v) || __builtin_add_overflow(v, digitVal(c), &v))) {
+            return Value::MakeInt(BigInt::Parse(lit, base));
+        }
+    }
+    return Value::MakeInt64(v);
+}
+
+// maxExp bounds the exponent of a floating-point literal, so that a value
+// like 1e1000000000 cannot exhaust memory.
+constexpr int64_t maxExp = 10000;
+
+Value parseFloat(std::string_view lit) {
+    bool hex = lit.size() > 1 && lit[0] == '0' && (lit[1] | 0x20) == 'x';
+    if (hex) {
+        lit.remove_prefix(2);
+    }
+    int base = hex ? 16 : 10;
+    auto e = lit.find_first_of(hex ? "pP" : "eE");
+    auto mant = lit.substr(0, e);
+    int64_t exp = 0;
+    if (e != std::string_view::npos) {
+        auto s = lit.substr(e + 1);
+        bool neg = !s.empty() && s[0] == '-';
+        if (!s.empty() && (s[0] == '-' || s[0] == '+')) {
+            s.remove_prefix(1);
+        }
+        if (!validDigits(s, 10)) {
+            return {};
+        }
+        for (auto c : s) {
+            if (c != '_') {
+                exp = exp * 10 + (c - '0');
+                if (exp > maxExp * 4) {
+                    return {};
+                }
+            }
+        }
+        exp = neg ? -exp : exp;
+    } else if (hex) {
+        return {}; // a hexadecimal mantissa requires a p exponent
+    }
+    // the digits of the mantissa, and the number of fractional ones
+    std::string digits;
+    int64_t frac = 0;
+    bool dot = false;
+    for (auto c : mant) {
+        if (c == '.') {
+            if (dot) {
+                return {};
+            }
+            dot = true;
+        } else if (c != '_') {
+            if (digitVal(c) >= base) {
+                return {};
+            }
+            digits += c;
+            frac += dot;
+        }
+    }
+    if (digits.empty()) {
+        return {};
+    }
+    // value = digits * base**-frac * (2 or 10)**exp
+    if (hex) {
+        exp -= 4 * frac;
+        if (exp > maxExp * 4 || exp < -maxExp * 4) {
+            return {};
+        }
+        auto m = BigInt::Parse(digits, 16);
+        if (exp >= 0) {
+            return Value::MakeRat(m << uint64_t(exp), BigInt(1));
+        }
+        return Value::MakeRat(m, BigInt(1) << uint64_t(-exp));
+    }
+    exp -= frac;
+    if (exp > maxExp || exp < -maxExp) {
+        return {};
+    }
+    // fast path: a mantissa and a power of ten that fit in 64 bits
+    int64_t m = 0;
+    bool fits = digits.size() <= 18 && exp >= -18 && exp <= 18;
+    for (auto c : digits) {
+        m = fits ? m * 10 + (c - '0') : 0;
+    }
+    if (fits) {
+        int64_t p = 1;
+        for (int64_t i = 0; i < (exp < 0 ? -exp : exp); i++) {
+            p *= 10;
+        }
+        int64_t r;
+        if (exp < 0) {
+            return Value::MakeRat(m, p);
+        }
+        if (!__builtin_mul_overflow(m, p, &r)) {
+            return Value::MakeRat(r, 1);
+        }
+    }
+    auto big = BigInt::Parse(digits, 10);
+    if (exp >= 0) {
+        return Value::MakeRat(big * BigInt::Pow10(uint32_t(exp)), BigInt(1));
+    }
+    return Value::MakeRat(big, BigInt::Pow10(uint32_t(-exp)));
+}
+
+// unescape decodes the escape sequence at the start of s, after the
+// backslash, and advances s past it. It sets isByte for \x and octal
+// escapes, which denote a single byte.
+bool unescape(std::string_view &s, char quote, uint32_t &v, bool &isByte) {
+    if (s.empty()) {
+        return false;
+    }
+    isByte = false;
+    auto c = s[0];
+    s.remove_prefix(1);
+    switch (c) {
+    case 'a': v = '\a'; return true;
+    case 'b': v = '\b'; return true;
+    case 'f': v = '\f'; return true;
+    case 'n': v = '\n'; return true;
+    case 'r': v = '\r'; return true;
+    case 't': v = '\t'; return true;
+    case 'v': v = '\v'; return true;
+    case '\\': v = '\\'; return true;
+    case '\'':
+    case '"':
+        v = uint32_t(c);
+        return c == quote;
+    case 'x':
+    case 'u':
+    case 'U': {
+        size_t n = c == 'x' ? 2 : c == 'u' ? 4 : 8;
+        if (s.size() < n || !validDigits(s.substr(0, n), 16)) {
+            return false;
+        }
+        v = 0;
+        for (size_t i = 0; i < n; i++) {
+            v = v << 4 | uint32_t(digitVal(s[i]));
+        }
+        s.remove_prefix(n);
+        isByte = c == 'x';
+        return isByte || (v <= 0x10ffff && !(v >= 0xd800 && v < 0xe000));
+    }
+    default:
+        if (c < '0' || c > '7' || s.size() < 2 || !validDigits(s.substr(0, 2), 8)) {
+            return false;
+        }
+        v = uint32_t(c - '0') << 6 | uint32_t(s[0] - '0') << 3 | uint32_t(s[1] - '0');
+        s.remove_prefix(2);
+        isByte = true;
+        return v <= 255;
+    }
+}
+
+void appendRune(std::string &s, uint32_t r) {
+    if (r < 0x80) {
+        s += char(r);
+    } else if (r < 0x800) {
+        s += char(0xc0 | r >> 6);
+        s += char(0x80 | (r & 0x3f));
+    } else if (r < 0x10000) {
+        s += char(0xe0 | r >> 12);
+        s += char(0x80 | (r >> 6 & 0x3f));
+        s += char(0x80 | (r & 0x3f));
+    } else {
+        s += char(0xf0 | r >> 18);
+        s += char(0x80 | (r >> 12 & 0x3f));
+        s += char(0x80 | (r >> 6 & 0x3f));
+        s += char(0x80 | (r & 0x3f));
+    }
+}
+
+// decodeRune decodes the UTF-8 sequence at the start of s and advances s
+// past it; invalid bytes decode one at a time.
+uint32_t decodeRune(std::string_view &s) {
+    auto c = uint8_t(s[0]);
+    size_t n = c < 0xc0 ? 1 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : 4;
+    if (n > s.size()) {
+        n = 1;
+    }
+    uint32_t r = n == 1 ? c : c & (0x7f >> n);
+    for (size_t i = 1; i < n; i++) {
+        r = r << 6 | (uint8_t(s[i]) & 0x3f);
+    }
+    s.remove_prefix(n);
+    return r;
+}
+
+Value parseRune(std::string_view lit) {
+    if (lit.size() < 3 || lit.front() != '\'' || lit.back() != '\'') {
+        return {};
+    }
+    auto s = lit.substr(1, lit.size() - 2);
+    uint32_t v;
+    if (s[0] == '\\') {
+        s.remove_prefix(1);
+        bool isByte;
+        if (!unescape(s, '\'', v, isByte)) {
+            return {};
+        }
+    } else {
+        v = decodeRune(s);
+    }
+    return s.empty() ? Value::MakeInt64(v) : Value{};
+}
+
+Value parseString(std::string_view lit) {
+    if (lit.size() < 2 || lit.front() != lit.back() || (lit[0] != '"' && lit[0] != '`')) {
+        return {};
+    }
+    auto s = lit.substr(1, lit.size() - 2);
+    std::string out;
+    out.reserve(s.size());
+    if (lit[0] == '`') {
+        // carriage returns are discarded from raw strings
+        for (auto c : s) {
+            if (c != '\r') {
+                out += c;
+            }
+        }
+        return Value::MakeString(std::move(out));
+    }
+    while (!s.empty()) {
+        if (s[0] != '\\') {
+            out += s[0];
+            s.remove_prefix(1);
+            continue;
+        }
+        s.remove_prefix(1);
+        uint32_t v;
+        bool isByte;
+        if (!unescape(s, '"', v, isByte)) {
+            return {};
+        }
+        if (isByte) {
+            out += char(v);
+        } else {
+            appendRune(out, v);
+        }
+    }
+    return Value::MakeString(std::move(out));
+}
+
+// quote returns s as a Go string literal, shortened to about maxLen bytes.
+std::string quote(std::string_view s) {
+    constexpr size_t maxLen = 72;
+    bool shortened = s.size() > maxLen;
+    if (shortened) {
+        s = s.substr(0, maxLen - 3);
+    }
+    std::string r = "\"";
+    for (auto c : s) {
+        switch (c) {
+        case '\a': r += "\\a"; break;
+        case '\b': r += "\\b"; break;
+        case '\f': r += "\\f"; break;
+        case '\n': r += "\\n"; break;
+        case '\r': r += "\\r"; break;
+        case '\t': r += "\\t"; break;
+        case '\v': r += "\\v"; break;
+        case '\\': r += "\\\\"; break;
+        case '"': r += "\\\""; break;
+        default:
+            if (uint8_t(c) < 0x20 || c == 0x7f) {
+                r += fmt::format("\\x{:02x}", uint8_t(c));
+            } else {
+                r += c;
+            }
+        }
+    }
+    return r + (shortened ? "...\"" : "\"");
+}
+
+// formatFloat formats num/den with six significant digits like %.6g, for
+// values beyond the range of float64.
+std::string formatFloat(const BigInt &num, const BigInt &den) {
+    auto a = num.Sign() < 0 ? -num : num;
+    // estimate the decimal exponent, then correct it
+    auto e10 = int64_t(std::floor(double(a.BitLen() - den.BitLen()) * 0.30102999566398120));
+    BigInt m;
+    auto scale = [&](int64_t e) {
+        int64_t s = 5 - e;
+        auto n = s >= 0 ? a * BigInt::Pow10(uint32_t(s)) : a;
+        auto d = s >= 0 ? den : den * BigInt::Pow10(uint32_t(-s));
+        auto r = n % d;
+        m = n / d;
+        if (BigInt::Cmp(r + r, d) >= 0) {
+            m = m + BigInt(1);
+        }
+    };
+    for (int i = 0; i < 4; i++) {
+        scale(e10);
+        if (BigInt::Cmp(m, BigInt(1000000)) >= 0) {
+            e10++;
+        } else if (BigInt::Cmp(m, BigInt(100000)) < 0) {
+            e10--;
+        } else {
+            break;
+        }
+    }
+    auto digits = m.String();
+    while (digits.size() > 1 && digits.back() == '0') {
+        digits.pop_back();
+    }
+    if (digits.size() > 1) {
+        digits.insert(1, ".");
+    }
+    return fmt::format("{}{}e{}{:02}", num.Sign() < 0 ? "-" : "", digits, e10 < 0 ? '-' : '+',
+                       e10 < 0 ? -e10 : e10);
+}
+
+int rankOf(ConstKind k) {
+    switch (k) {
+    case ConstKind::Int:
+        return 1;
+    case ConstKind::Float:
+        return 2;
+    case ConstKind::Complex:
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+Value convert(const Value &x, ConstKind k) {
+    switch (k) {
+    case ConstKind::Float:
+        return x.ToFloat();
+    case ConstKind::Complex:
+        return x.ToComplex();
+    default:
+        return x;
+    }
+}
+
+bool cmpResult(int c, syntax::Operator op) {
+    switch (op) {
+    case Operator_Eql:
+        return c == 0;
+    case Operator_Neq:
+        return c != 0;
+    case Operator_Lss:
+        return c < 0;
+    case Operator_Leq:
+        return c <= 0;
+    case Operator_Gtr:
+        return c > 0;
+    case Operator_Geq:
+        return c >= 0;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// BigInt
+
+BigInt::BigInt(int64_t v) : _neg(v < 0), _mag(magOf(v < 0 ? 0 - uint64_t(v) : uint64_t(v))) {}
+
+BigInt BigInt::FromUint64(uint64_t v) {
+    BigInt r;
+    r._mag = magOf(v);
+    return r;
+}
+
+BigInt BigInt::Parse(std::string_view digits, int base) {
+    BigInt r;
+    uint64_t acc = 0, mul = 1;
+    for (auto c : digits) {
+        if (c == '_') {
+            continue;
+        }
+        acc = acc * base + digitVal(c);
+        mul *= base;
+        if (mul > UINT32_MAX / 16) {
+            mulAddSmall(r._mag, uint32_t(mul), uint32_t(acc));
+            acc = 0;
+            mul = 1;
+        }
+    }
+    if (mul > 1) {
+        mulAddSmall(r._mag, uint32_t(mul), uint32_t(acc));
+    }
+    trim(r._mag);
+    return r;
+}
+
+BigInt BigInt::Pow10(uint32_t n) {
+    BigInt r(1);
+    for (; n >= 9; n -= 9) {
+        mulAddSmall(r._mag, 1000000000, 0);
+    }
+    uint32_t p = 1;
+    for (; n > 0; n--) {
+        p *= 10;
+    }
+    mulAddSmall(r._mag, p, 0);
+    return r;
+}
+
+int64_t BigInt::BitLen() const { return _mag.empty() ? 0 : int64_t(_mag.size()) * 32 - __builtin_clz(_mag.back()); }
+
+bool BigInt::IsInt64() const {
+    if (_mag.size() > 2) {
+        return false;
+    }
+    auto u = uint64_t(Int64());
+    u = _neg ? 0 - u : u;
+    return _neg ? u <= uint64_t(1) << 63 : u < uint64_t(1) << 63;
+}
+
+int64_t BigInt::Int64() const {
+    uint64_t u = 0;
+    for (size_t i = 0; i < _mag.size() && i < 2; i++) {
+        u |= uint64_t(_mag[i]) << (32 * i);
+    }
+    return int64_t(_neg ? 0 - u : u);
+}
+
+bool BigInt::IsUint64() const { return !_neg && _mag.size() <= 2; }
+
+std::string BigInt::String() const {
+    if (_mag.empty()) {
+        return "0";
+    }
+    std::vector<uint32_t> chunks;
+    auto m = _mag;
+    while (!m.empty()) {
+        chunks.push_back(divSmall(m, 1000000000));
+    }
+    std::string s = _neg ? "-" : "";
+    s += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;) {
+        s += fmt::format("{:09}", chunks[i]);
+    }
+    return s;
+}
+
+BigInt BigInt::operator-() const {
+    BigInt r = *this;
+    r._neg = !r._mag.empty() && !_neg;
+    return r;
+}
+
+BigInt operator+(const BigInt &a, const BigInt &b) {
+    BigInt r;
+    if (a._neg == b._neg) {
+        r._mag = addMag(a._mag, b._mag);
+        r._neg = a._neg;
+    } else if (cmpMag(a._mag, b._mag) >= 0) {
+        r._mag = subMag(a._mag, b._mag);
+        r._neg = a._neg;
+    } else {
+        r._mag = subMag(b._mag, a._mag);
+        r._neg = b._neg;
+    }
+    r._neg = r._neg && !r._mag.empty();
+    return r;
+}
+
+BigInt operator-(const BigInt &a, const BigInt &b) { return a + -b; }
+
+BigInt operator*(const BigInt &a, const BigInt &b) {
+    BigInt r;
+    r._mag = mulMag(a._mag, b._mag);
+    r._neg = (a._neg != b._neg) && !r._mag.empty();
+    return r;
+}
+
+BigInt operator/(const BigInt &a, const BigInt &b) {
+    BigInt q;
+    Mag r;
+    divModMag(a._mag, b._mag, q._mag, r);
+    q._neg = (a._neg != b._neg) && !q._mag.empty();
+    return q;
+}
+
+BigInt operator%(const BigInt &a, const BigInt &b) {
+    Mag q;
+    BigInt r;
+    divModMag(a._mag, b._mag, q, r._mag);
+    r._neg = a._neg && !r._mag.empty();
+    return r;
+}
+
+BigInt operator&(const BigInt &a, const BigInt &b) {
+    auto n = std::max(a._mag.size(), b._mag.size()) + 1;
+    auto x = toTwos(a._neg, a._mag, n), y = toTwos(b._neg, b._mag, n);
+    for (size_t i = 0; i < n; i++) {
+        x[i] &= y[i];
+    }
+    BigInt r;
+    r._mag = fromTwos(std::move(x), r._neg);
+    return r;
+}
+
+BigInt operator|(const BigInt &a, const BigInt &b) {
+    auto n = std::max(a._mag.size(), b._mag.size()) + 1;
+    auto x = toTwos(a._neg, a._mag, n), y = toTwos(b._neg, b._mag, n);
+    for (size_t i = 0; i < n; i++) {
+        x[i] |= y[i];
+    }
+    BigInt r;
+    r._mag = fromTwos(std::move(x), r._neg);
+    return r;
+}
+
+BigInt operator^(const BigInt &a, const BigInt &b) {
+    auto n = std::max(a._mag.size(), b._mag.size()) + 1;
+    auto x = toTwos(a._neg, a._mag, n), y = toTwos(b._neg, b._mag, n);
+    for (size_t i = 0; i < n; i++) {
+        x[i] ^= y[i];
+    }
+    BigInt r;
+    r._mag = fromTwos(std::move(x), r._neg);
+    return r;
+}
+
+BigInt BigInt::operator~() const { return -*this - BigInt(1); }
+
+BigInt BigInt::operator<<(uint64_t s) const {
+    BigInt r;
+    r._mag = shlMag(_mag, s);
+    r._neg = _neg && !r._mag.empty();
+    return r;
+}
+
+BigInt BigInt::operator>>(uint64_t s) const {
+    if (!_neg) {
+        BigInt r;
+        r._mag = shrMag(_mag, s);
+        return r;
+    }
+    // -x >> s == -((x-1) >> s) - 1
+    BigInt r;
+    r._mag = addMag(shrMag(subMag(_mag, {1}), s), {1});
+    r._neg = true;
+    return r;
+}
+
+int BigInt::Cmp(const BigInt &a, const BigInt &b) {
+    if (a._neg != b._neg) {
+        return a._neg ? -1 : 1;
+    }
+    auto c = cmpMag(a._mag, b._mag);
+    return a._neg ? -c : c;
+}
+
+BigInt BigInt::Gcd(BigInt a, BigInt b) {
+    a._neg = b._neg = false;
+    while (!b._mag.empty()) {
+        auto r = a % b;
+        a = std::move(b);
+        b = std::move(r);
+    }
+    return a;
+}
+
+// ----------------------------------------------------------------------------
+// Value
+
+struct Value::Rep {
+    BigInt num, den; // an Int, or a Float num/den in lowest terms with den > 0
+    std::string str;
+    Value re, im; // the Float parts of a Complex
+};
+
+Value Value::MakeBool(bool b) { return Value(ConstKind::Bool, b, 1); }
+
+Value Value::MakeString(std::string s) {
+    Value v(ConstKind::String, 0, 1);
+    auto rep = std::make_shared<Rep>();
+    rep->str = std::move(s);
+    v._rep = std::move(rep);
+    return v;
+}
+
+Value Value::MakeInt64(int64_t v) { return v == INT64_MIN ? MakeInt(BigInt(v)) : Value(ConstKind::Int, v, 1); }
+
+Value Value::MakeUint64(uint64_t v) {
+    return v <= INT64_MAX ? Value(ConstKind::Int, int64_t(v), 1) : MakeInt(BigInt::FromUint64(v));
+}
+
+Value Value::MakeInt(BigInt v) {
+    if (fitsInline(v)) {
+        return Value(ConstKind::Int, v.Int64(), 1);
+    }
+    Value r(ConstKind::Int, 0, 1);
+    auto rep = std::make_shared<Rep>();
+    rep->num = std::move(v);
+    rep->den = BigInt(1);
+    r._rep = std::move(rep);
+    return r;
+}
+
+Value Value::MakeRat(BigInt num, BigInt den) {
+    if (den.Sign() == 0) {
+        return {};
+    }
+    if (den.Sign() < 0) {
+        num = -num;
+        den = -den;
+    }
+    auto g = BigInt::Gcd(num, den);
+    if (!(g == BigInt(1)) && g.Sign() != 0) {
+        num = num / g;
+        den = den / g;
+    }
+    if (fitsInline(num) && fitsInline(den)) {
+        return Value(ConstKind::Float, num.Int64(), den.Int64());
+    }
+    Value r(ConstKind::Float, 0, 1);
+    auto rep = std::make_shared<Rep>();
+    rep->num = std::move(num);
+    rep->den = std::move(den);
+    r._rep = std::move(rep);
+    return r;
+}
+
+Value Value::MakeRat(int64_t num, int64_t den) {
+    if (den == 0) {
+        return {};
+    }
+    return den < 0 ? makeRat(-__int128(num), -__int128(den)) : makeRat(num, den);
+}
+
+Value Value::makeRat(__int128 n, __int128 d) {
+    auto g = gcd128(u128(n < 0 ? -n : n), u128(d));
+    if (g > 1) {
+        n /= __int128(g);
+        d /= __int128(g);
+    }
+    if (fitsInline(n) && fitsInline(d)) {
+        return Value(ConstKind::Float, int64_t(n), int64_t(d));
+    }
+    return MakeRat(fromInt128(n), fromInt128(d));
+}
+
+Value Value::MakeFloat64(double f) {
+    if (!std::isfinite(f)) {
+        return {};
+    }
+    int exp;
+    double m = std::frexp(f, &exp);
+    auto mant = int64_t(std::ldexp(m, 53));
+    exp -= 53;
+    if (exp >= 0) {
+        return MakeRat(BigInt(mant) << uint64_t(exp), BigInt(1));
+    }
+    return MakeRat(BigInt(mant), BigInt(1) << uint64_t(-exp));
+}
+
+Value Value::MakeComplex(const Value &re, const Value &im) {
+    auto r = re.ToFloat(), i = im.ToFloat();
+    if (!r.IsKnown() || !i.IsKnown()) {
+        return {};
+    }
+    Value v(ConstKind::Complex, 0, 1);
+    auto rep = std::make_shared<Rep>();
+    rep->re = std::move(r);
+    rep->im = std::move(i);
+    v._rep = std::move(rep);
+    return v;
+}
+
+Value Value::MakeFromLiteral(std::string_view lit, syntax::LitKind kind) {
+    switch (kind) {
+    case IntLit:
+        return parseInt(lit);
+    case FloatLit:
+        return parseFloat(lit);
+    case ImagLit: {
+        if (lit.empty() || lit.back() != 'i') {
+            return {};
+        }
+        lit.remove_suffix(1);
+        // an integer mantissa with a 0b, 0o or 0x prefix; 0123i is decimal
+        // for backward compatibility
+        bool prefixed = lit.size() > 1 && lit[0] == '0' && std::string_view("bBoOxX").find(lit[1]) != std::string_view::npos;
+        auto v = prefixed && lit.find_first_of(".pP") == std::string_view::npos ? parseInt(lit) : parseFloat(lit);
+        return v.IsKnown() ? MakeComplex(MakeInt64(0), v) : v;
+    }
+    case RuneLit:
+        return parseRune(lit);
+    default:
+        return parseString(lit);
+    }
+}
+
+std::string_view Value::StringVal() const { return rep().str; }
+
+std::optional<int64_t> Value::Int64Val() const {
+    if (_kind != ConstKind::Int) {
+        return std::nullopt;
+    }
+    if (IsInline()) {
+        return _num;
+    }
+    if (rep().num.IsInt64()) {
+        return rep().num.Int64();
+    }
+    return std::nullopt;
+}
+
+std::optional<uint64_t> Value::Uint64Val() const {
+    if (_kind != ConstKind::Int) {
+        return std::nullopt;
+    }
+    if (IsInline()) {
+        return _num >= 0 ? std::optional<uint64_t>(uint64_t(_num)) : std::nullopt;
+    }
+    if (rep().num.IsUint64()) {
+        return uint64_t(rep().num.Int64());
+    }
+    return std::nullopt;
+}
+
+double Value::Float64Val() const {
+    switch (_kind) {
+    case ConstKind::Int:
+    case ConstKind::Float:
+        if (IsInline()) {
+            constexpr int64_t exact = int64_t(1) << 53;
+            if (_num > -exact && _num < exact && _den < exact) {
+                return double(_num) / double(_den); // both exact, so correctly rounded
+            }
+        }
+        return ratToFloat(Num(), Denom(), 53);
+    case ConstKind::Complex:
+        return rep().re.Float64Val();
+    default:
+        return 0;
+    }
+}
+
+float Value::Float32Val() const {
+    if (_kind == ConstKind::Complex) {
+        return rep().re.Float32Val();
+    }
+    if (_kind != ConstKind::Int && _kind != ConstKind::Float) {
+        return 0;
+    }
+    auto d = ratToFloat(Num(), Denom(), 24);
+    if (std::fabs(d) > FLT_MAX) {
+        return d < 0 ? -HUGE_VALF : HUGE_VALF;
+    }
+    return float(d);
+}
+
+int Value::Sign() const {
+    switch (_kind) {
+    case ConstKind::Int:
+    case ConstKind::Float:
+        if (IsInline()) {
+            return _num < 0 ? -1 : _num > 0;
+        }
+        return rep().num.Sign();
+    case ConstKind::Complex:
+        return rep().re.Sign() != 0 || rep().im.Sign() != 0;
+    default:
+        return 0;
+    }
+}
+
+int64_t Value::BitLen() const {
+    if (!IsInline()) {
+        return rep().num.BitLen();
+    }
+    auto u = uint64_t(_num < 0 ? -_num : _num);
+    return u == 0 ? 0 : 64 - __builtin_clzll(u);
+}
+
+BigInt Value::Num() const { return IsInline() ? BigInt(_num) : rep().num; }
+
+BigInt Value::Denom() const { return IsInline() ? BigInt(_den) : rep().den; }
+
+Value Value::Real() const { return _kind == ConstKind::Complex ? rep().re : *this; }
+
+Value Value::Imag() const { return _kind == ConstKind::Complex ? rep().im : Value(ConstKind::Float, 0, 1); }
+
+Value Value::ToInt() const {
+    switch (_kind) {
+    case ConstKind::Int:
+        return *this;
+    case ConstKind::Float:
+        if (IsInline()) {
+            return _den == 1 ? Value(ConstKind::Int, _num, 1) : Value{};
+        }
+        return rep().den == BigInt(1) ? MakeInt(rep().num) : Value{};
+    case ConstKind::Complex:
+        return rep().im.Sign() == 0 ? rep().re.ToInt() : Value{};
+    default:
+        return {};
+    }
+}
+
+Value Value::ToFloat() const {
+    switch (_kind) {
+    case ConstKind::Int:
+        return IsInline() ? Value(ConstKind::Float, _num, 1) : MakeRat(rep().num, BigInt(1));
+    case ConstKind::Float:
+        return *this;
+    case ConstKind::Complex:
+        return rep().im.Sign() == 0 ? rep().re : Value{};
+    default:
+        return {};
+    }
+}
+
+Value Value::ToComplex() const {
+    switch (_kind) {
+    case ConstKind::Int:
+    case ConstKind::Float:
+        return MakeComplex(*this, Value(ConstKind::Float, 0, 1));
+    case ConstKind::Complex:
+        return *this;
+    default:
+        return {};
+    }
+}
+
+std::string Value::String() const {
+    switch (_kind) {
+    case ConstKind::Unknown:
+        return "unknown";
+    case ConstKind::Bool:
+        return _num != 0 ? "true" : "false";
+    case ConstKind::String:
+        return quote(rep().str);
+    case ConstKind::Int:
+        return IsInline() ? std::to_string(_num) : rep().num.String();
+    case ConstKind::Float: {
+        auto d = Float64Val();
+        if (std::isfinite(d) && (d != 0 || Sign() == 0)) {
+            return fmt::format("{:.6g}", d);
+        }
+        return formatFloat(Num(), Denom());
+    }
+    case ConstKind::Complex:
+        return fmt::format("({} + {}i)", rep().re.String(), rep().im.String());
+    }
+    return "";
+}
+
+// ----------------------------------------------------------------------------
+// Operations
+
+Value UnaryOp(syntax::Operator op, const Value &x, unsigned prec) {
+    switch (op) {
+    case Operator_Add:
+        return x;
+    case Operator_Sub:
+        switch (x._kind) {
+        case ConstKind::Int:
+            return x.IsInline() ? Value(ConstKind::Int, -x._num, 1) : Value::MakeInt(-x.rep().num);
+        case ConstKind::Float:
+            return x.IsInline() ? Value(ConstKind::Float, -x._num, x._den) : Value::MakeRat(-x.rep().num, x.rep().den);
+        case ConstKind::Complex:
+            return Value::MakeComplex(UnaryOp(op, x.rep().re, 0), UnaryOp(op, x.rep().im, 0));
+        default:
+            return {};
+        }
+    case Operator_Xor:
+        if (x._kind != ConstKind::Int) {
+            return {};
+        }
+        if (x.IsInline() && prec < 63) {
+            // ~v has no overflow; for an unsigned type, keep prec bits
+            auto v = ~x._num;
+            return Value::MakeInt64(prec == 0 ? v : v & ((int64_t(1) << prec) - 1));
+        }
+        if (prec == 0) {
+            return Value::MakeInt(~x.Num());
+        }
+        return Value::MakeInt(~x.Num() & ((BigInt(1) << prec) - BigInt(1)));
+    case Operator_Not:
+        return x._kind == ConstKind::Bool ? Value::MakeBool(!x.BoolVal()) : Value{};
+    default:
+        return {};
+    }
+}
+
+namespace {
+
+// bigIntOp and bigRatOp are the slow paths of BinaryOp.
+Value bigIntOp(const Value &x, syntax::Operator op, const Value &y) {
+    auto a = x.Num(), b = y.Num();
+    switch (op) {
+    case Operator_Add:
+        return Value::MakeInt(a + b);
+    case Operator_Sub:
+        return Value::MakeInt(a - b);
+    case Operator_Mul:
+        return Value::MakeInt(a * b);
+    case Operator_Div:
+        return b.Sign() == 0 ? Value{} : Value::MakeInt(a / b);
+    case Operator_Rem:
+        return b.Sign() == 0 ? Value{} : Value::MakeInt(a % b);
+    case Operator_And:
+        return Value::MakeInt(a & b);
+    case Operator_Or:
+        return Value::MakeInt(a | b);
+    case Operator_Xor:
+        return Value::MakeInt(a ^ b);
+    case Operator_AndNot:
+        return Value::MakeInt(a & ~b);
+    default:
+        return {};
+    }
+}
+
+Value bigRatOp(const Value &x, syntax::Operator op, const Value &y) {
+    auto a = x.Num(), b = x.Denom(), c = y.Num(), d = y.Denom();
+    switch (op) {
+    case Operator_Add:
+        return Value::MakeRat(a * d + c * b, b * d);
+    case Operator_Sub:
+        return Value::MakeRat(a * d - c * b, b * d);
+    case Operator_Mul:
+        return Value::MakeRat(a * c, b * d);
+    case Operator_Div:
+        return Value::MakeRat(a * d, b * c);
+    default:
+        return {};
+    }
+}
+
+Value complexOp(const Value &x, syntax::Operator op, const Value &y) {
+    auto a = x.Real(), b = x.Imag(), c = y.Real(), d = y.Imag();
+    switch (op) {
+    case Operator_Add:
+    case Operator_Sub:
+        return Value::MakeComplex(BinaryOp(a, op, c), BinaryOp(b, op, d));
+    case Operator_Mul:
+        // (a+bi)(c+di) = (ac-bd) + (ad+bc)i
+        return Value::MakeComplex(BinaryOp(BinaryOp(a, Operator_Mul, c), Operator_Sub, BinaryOp(b, Operator_Mul, d)),
+                                  BinaryOp(BinaryOp(a, Operator_Mul, d), Operator_Add, BinaryOp(b, Operator_Mul, c)));
+    case Operator_Div: {
+        // (a+bi)/(c+di) = ((ac+bd) + (bc-ad)i) / (c²+d²)
+        auto n = BinaryOp(BinaryOp(c, Operator_Mul, c), Operator_Add, BinaryOp(d, Operator_Mul, d));
+        if (n.Sign() == 0) {
+            return {};
+        }
+        auto re = BinaryOp(BinaryOp(a, Operator_Mul, c), Operator_Add, BinaryOp(b, Operator_Mul, d));
+        auto im = BinaryOp(BinaryOp(b, Operator_Mul, c), Operator_Sub, BinaryOp(a, Operator_Mul, d));
+        return Value::MakeComplex(BinaryOp(re, Operator_Div, n), BinaryOp(im, Operator_Div, n));
+    }
+    default:
+        return {};
+    }
+}
+
+} // namespace
+
+Value BinaryOp(const Value &x, syntax::Operator op, const Value &y) {
+    if (!x.IsKnown() || !y.IsKnown()) {
+        return {};
+    }
+    if (x._kind == ConstKind::Bool || y._kind == ConstKind::Bool) {
+        if (x._kind != y._kind) {
+            return {};
+        }
+        switch (op) {
+        case Operator_AndAnd:
+            return Value::MakeBool(x.BoolVal() && y.BoolVal());
+        case Operator_OrOr:
+            return Value::MakeBool(x.BoolVal() || y.BoolVal());
+        default:
+            return {};
+        }
+    }
+    if (x._kind == ConstKind::String || y._kind == ConstKind::String) {
+        if (x._kind != y._kind || op != Operator_Add) {
+            return {};
+        }
+        return Value::MakeString(std::string(x.StringVal()) + std::string(y.StringVal()));
+    }
+    if (x._kind != y._kind) {
+        auto k = rankOf(x._kind) > rankOf(y._kind) ? x._kind : y._kind;
+        return BinaryOp(convert(x, k), op, convert(y, k));
+    }
+
+    switch (x._kind) {
+    case ConstKind::Int:
+        if (x.IsInline() && y.IsInline()) {
+            // neither operand is INT64_MIN, so / and % cannot overflow
+            auto a = x._num, b = y._num;
+            int64_t r;
+            switch (op) {
+            case Operator_Add:
+                if (!__builtin_add_overflow(a, b, &r)) {
+                    return Value::MakeInt64(r);
+                }
+                break;
+            case Operator_Sub:
+                if (!__builtin_sub_overflow(a, b, &r)) {
+                    return Value::MakeInt64(r);
+                }
+                break;
+            case Operator_Mul:
+                if (!__builtin_mul_overflow(a, b, &r)) {
+                    return Value::MakeInt64(r);
+                }
+                break;
+            case Operator_Div:
+                return b == 0 ? Value{} : Value::MakeInt64(a / b);
+            case Operator_Rem:
+                return b == 0 ? Value{} : Value::MakeInt64(a % b);
+            case Operator_And:
+                return Value::MakeInt64(a & b);
+            case Operator_Or:
+                return Value::MakeInt64(a | b);
+            case Operator_Xor:
+                return Value::MakeInt64(a ^ b);
+            case Operator_AndNot:
+                return Value::MakeInt64(a & ~b);
+            default:
+                return {};
+            }
+        }
+        return bigIntOp(x, op, y);
+    case ConstKind::Float:
+        if (x.IsInline() && y.IsInline()) {
+            // the products of the inline terms fit in 127 bits
+            __int128 a = x._num, b = x._den, c = y._num, d = y._den;
+            switch (op) {
+            case Operator_Add:
+                return Value::makeRat(a * d + c * b, b * d);
+            case Operator_Sub:
+                return Value::makeRat(a * d - c * b, b * d);
+            case Operator_Mul:
+                return Value::makeRat(a * c, b * d);
+            case Operator_Div:
+                if (c == 0) {
+                    return {};
+                }
+                return c < 0 ? Value::makeRat(-a * d, -b * c) : Value::makeRat(a * d, b * c);
+            default:
+                return {};
+            }
+        }
+        return bigRatOp(x, op, y);
+    case ConstKind::Complex:
+        return complexOp(x, op, y);
+    default:
+        return {};
+    }
+}
+
+Value Shift(const Value &x, syntax::Operator op, uint64_t s) {
+    if (x._kind != ConstKind::Int) {
+        return {};
+    }
+    if (x.IsInline()) {
+        auto v = x._num;
+        if (op == Operator_Shr) {
+            return Value::MakeInt64(s >= 63 ? (v < 0 ? -1 : 0) : v >> s);
+        }
+        if (v == 0) {
+            return x;
+        }
+        if (s < 63) {
+            auto r = int64_t(uint64_t(v) << s);
+            if (r >> s == v) {
+                return Value::MakeInt64(r);
+            }
+        }
+    }
+    return Value::MakeInt(op == Operator_Shl ? x.Num() << s : x.Num() >> s);
+}
+
+bool Compare(const Value &x, syntax::Operator op, const Value &y) {
+    if (!x.IsKnown() || !y.IsKnown()) {
+        return false;
+    }
+    if (x._kind == ConstKind::Bool || y._kind == ConstKind::Bool) {
+        if (x._kind != y._kind || (op != Operator_Eql && op != Operator_Neq)) {
+            return false;
+        }
+        return cmpResult(x._num == y._num ? 0 : 1, op);
+    }
+    if (x._kind == ConstKind::String || y._kind == ConstKind::String) {
+        if (x._kind != y._kind) {
+            return false;
+        }
+        auto c = x.StringVal().compare(y.StringVal());
+        return cmpResult(c < 0 ? -1 : c > 0, op);
+    }
+    if (x._kind != y._kind) {
+        auto k = rankOf(x._kind) > rankOf(y._kind) ? x._kind : y._kind;
+        return Compare(convert(x, k), op, convert(y, k));
+    }
+    switch (x._kind) {
+    case ConstKind::Int:
+        if (x.IsInline() && y.IsInline()) {
+            return cmpResult(x._num < y._num ? -1 : x._num > y._num, op);
+        }
+        return cmpResult(BigInt::Cmp(x.Num(), y.Num()), op);
+    case ConstKind::Float:
+        if (x.IsInline() && y.IsInline()) {
+            auto a = __int128(x._num) * y._den, b = __int128(y._num) * x._den;
+            return cmpResult(a < b ? -1 : a > b, op);
+        }
+        return cmpResult(BigInt::Cmp(x.Num() * y.Denom(), y.Num() * x.Denom()), op);
+    case ConstKind::Complex: {
+        if (op != Operator_Eql && op != Operator_Neq) {
+            return false;
+        }
+        bool eq = Compare(x.Real(), Operator_Eql, y.Real()) && Compare(x.Imag(), Operator_Eql, y.Imag());
+        return eq == (op == Operator_Eql);
+    }
+    default:
+        return false;
+    }
+}
+
+} // namespace types
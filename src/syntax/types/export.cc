@@ -0,0 +1,579 @@
+#include "syntax/types/export.hh"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+
+#include <fmt/format.h>
+
+namespace types {
+
+namespace {
+
+// TypeRefs below firstTypeRef stand for the basic types, by kind, and for
+// the predeclared error type; the others index the types of the package.
+constexpr uint32_t errorTypeRef = 63;
+constexpr uint32_t firstTypeRef = 64;
+
+std::string_view view(const flatbuffers::String *s) {
+    return s == nullptr ? std::string_view() : std::string_view(s->c_str(), s->size());
+}
+
+// parseInt returns the value of a decimal integer with an optional sign.
+std::optional<BigInt> parseInt(std::string_view s) {
+    bool neg = !s.empty() && s[0] == '-';
+    if (neg) {
+        s.remove_prefix(1);
+    }
+    if (s.empty() || !std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return std::nullopt;
+    }
+    auto v = BigInt::Parse(s, 10);
+    return neg ? -v : v;
+}
+
+// exporter serializes a checked package. The types are numbered as they
+// are first referenced and serialized after the objects, since a type may
+// refer to types not numbered yet.
+struct exporter {
+    const Checker &check;
+    const InlineBodies *bodies;
+    const LeakSummaries *leaks;
+    TypeTable &table = TypeTable::Global();
+    common::Interner &interner = common::Interner::Global();
+    flatbuffers::FlatBufferBuilder fbb{1024};
+    std::unordered_map<TypeId, uint32_t> refs;
+    std::vector<TypeId> types; // types[i] has TypeRef firstTypeRef + i
+
+    flatbuffers::Offset<flatbuffers::String> str(std::string_view s) { return fbb.CreateString(s.data(), s.size()); }
+    flatbuffers::Offset<flatbuffers::String> str(common::SymbolId s) { return str(interner.Name(s)); }
+
+    flatbuffers::Offset<flatbuffers::String> body(const Object *fn) {
+        if (bodies == nullptr) {
+            return 0;
+        }
+        auto it = bodies->find(fn);
+        return it == bodies->end() ? 0 : str(it->second);
+    }
+
+    flatbuffers::Offset<flatbuffers::Vector<int32_t>> leaksOf(const Object *fn) {
+        if (leaks == nullptr) {
+            return 0;
+        }
+        auto it = leaks->find(fn);
+        return it == leaks->end() || it->second.empty() ? 0 : fbb.CreateVector(it->second);
+    }
+
+    uint32_t ref(TypeId t) {
+        if (t == 0 || table.Kind(t) <= KindUntypedNil) {
+            return t; // the ID of a basic type is its kind
+        }
+        if (t == ErrorType()) {
+            return errorTypeRef;
+        }
+        auto [it, added] = refs.emplace(t, firstTypeRef + uint32_t(types.size()));
+        if (added) {
+            types.push_back(t);
+        }
+        return it->second;
+    }
+
+    flatbuffers::Offset<exportdata::Type> type(TypeId t) {
+        auto &d = table[t];
+        if (d.Kind == KindNamed) {
+            auto importer = check.GetImporter();
+            if (auto owner = importer == nullptr ? nullptr : importer->Owner(t)) {
+                return exportdata::CreateType(fbb, KindNamed, false, 0, 0, 0, 0, str(d.Name), str(owner->Path()));
+            }
+            std::vector<flatbuffers::Offset<exportdata::Method>> methods;
+            for (auto m : check.Methods(t)) {
+                methods.push_back(exportdata::CreateMethod(fbb, str(m->Name), ref(m->Type), m->PtrRecv, body(m), leaksOf(m)));
+            }
+            return exportdata::CreateType(fbb, KindNamed, false, 0, 0, 0, 0, str(d.Name), 0, ref(d.Underlying),
+                                          methods.empty() ? 0 : fbb.CreateVector(methods));
+        }
+        std::vector<uint32_t> elems;
+        for (auto e : d.Elems) {
+            elems.push_back(ref(TermType(e)) | (e & TildeTerm));
+        }
+        if (d.Kind == KindTypeParam) {
+            return exportdata::CreateType(fbb, KindTypeParam, false, d.Len, fbb.CreateVector(elems), 0, 0,
+                                          str(d.Name));
+        }
+        std::vector<flatbuffers::Offset<flatbuffers::String>> names;
+        std::vector<uint8_t> embedded;
+        for (auto name : d.Names) {
+            names.push_back(str(FieldName(name)));
+            embedded.push_back(name != FieldName(name));
+        }
+        return exportdata::CreateType(fbb, d.Kind, d.Variadic, d.Len, fbb.CreateVector(elems),
+                                      names.empty() ? 0 : fbb.CreateVector(names),
+                                      d.Kind == KindStruct && !names.empty() ? fbb.CreateVector(embedded) : 0);
+    }
+
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<flatbuffers::String>>> value(const Value &v) {
+        std::vector<flatbuffers::Offset<flatbuffers::String>> parts;
+        auto rat = [&](const Value &x) {
+            parts.push_back(str(x.Num().String()));
+            parts.push_back(str(x.Denom().String()));
+        };
+        switch (v.Kind()) {
+        case ConstKind::Unknown:
+            return 0;
+        case ConstKind::Bool:
+            parts.push_back(str(v.BoolVal() ? "1" : "0"));
+            break;
+        case ConstKind::String:
+            parts.push_back(str(v.StringVal()));
+            break;
+        case ConstKind::Int:
+            parts.push_back(str(v.Num().String()));
+            break;
+        case ConstKind::Float:
+            rat(v);
+            break;
+        case ConstKind::Complex:
+            rat(v.Real());
+            rat(v.Imag());
+            break;
+        }
+        return fbb.CreateVector(parts);
+    }
+};
+
+} // namespace
+
+flatbuffers::DetachedBuffer Export(const Checker &check, std::string_view path, const InlineBodies *bodies,
+                                   const LeakSummaries *leaks) {
+    exporter e{check, bodies, leaks};
+    auto &interner = common::Interner::Global();
+
+    // the package-level objects, except methods and blank or init functions
+    std::vector<Object *> objs;
+    for (auto obj : check.Objects()) {
+        if (check.PackageScope().LookupLocal(obj->Name) == obj) {
+            objs.push_back(obj);
+        }
+    }
+    std::sort(objs.begin(), objs.end(),
+              [&](Object *a, Object *b) { return interner.Name(a->Name) < interner.Name(b->Name); });
+
+    std::vector<flatbuffers::Offset<exportdata::Object>> objects;
+    for (auto obj : objs) {
+        auto isConst = obj->Kind == ObjKind::Const;
+        std::vector<uint32_t> tparams;
+        for (auto t : obj->TParams) {
+            tparams.push_back(e.ref(t));
+        }
+        objects.push_back(exportdata::CreateObject(e.fbb, uint8_t(obj->Kind), e.ref(obj->Type),
+                                                   isConst ? uint8_t(obj->Val.Kind()) : 0,
+                                                   isConst ? e.value(obj->Val) : 0, e.body(obj),
+                                                   tparams.empty() ? 0 : e.fbb.CreateVector(tparams),
+                                                   e.leaksOf(obj)));
+    }
+    std::vector<flatbuffers::Offset<exportdata::Type>> types;
+    for (size_t i = 0; i < e.types.size(); i++) {
+        types.push_back(e.type(e.types[i]));
+    }
+    auto typesVec = e.fbb.CreateVector(types);
+    auto objectsVec = e.fbb.CreateVector(objects);
+    auto pathStr = e.str(path);
+    auto nameStr = e.str(check.Name());
+
+    // the index goes last, to come first in the buffer
+    std::vector<flatbuffers::Offset<flatbuffers::String>> names;
+    for (auto obj : objs) {
+        names.push_back(e.str(obj->Name));
+    }
+    auto namesVec = e.fbb.CreateVector(names);
+    exportdata::FinishPackageBuffer(
+        e.fbb, exportdata::CreatePackage(e.fbb, ExportDataVersion, pathStr, nameStr, typesVec, objectsVec, namesVec));
+    return e.fbb.Release();
+}
+
+// ----------------------------------------------------------------------------
+// Import
+
+namespace {
+
+// verifyRoot verifies the root table of export data and the vectors it
+// holds, but not the entries they point to, which are verified when they
+// are decoded.
+bool verifyRoot(flatbuffers::Verifier &v, const exportdata::Package *pkg) {
+    using P = exportdata::Package;
+    auto t = reinterpret_cast<const flatbuffers::Table *>(pkg);
+    return t->VerifyTableStart(v) && t->VerifyField<uint32_t>(v, P::VT_VERSION) && t->VerifyOffset(v, P::VT_PATH) &&
+           v.VerifyString(pkg->path()) && t->VerifyOffset(v, P::VT_NAME) && v.VerifyString(pkg->name()) &&
+           t->VerifyOffset(v, P::VT_TYPES) && v.VerifyVector(pkg->types()) && t->VerifyOffset(v, P::VT_OBJECTS) &&
+           v.VerifyVector(pkg->objects()) && t->VerifyOffset(v, P::VT_NAMES) && v.VerifyVector(pkg->names()) &&
+           v.EndTable() && pkg->types() != nullptr && pkg->objects() != nullptr && pkg->names() != nullptr &&
+           pkg->objects()->size() == pkg->names()->size();
+}
+
+} // namespace
+
+ImportedPackage::ImportedPackage(Importer &importer, const uint8_t *data, size_t size, const exportdata::Package *pkg)
+    : _importer(importer), _data(data), _size(size), _pkg(pkg),
+      _objs(new std::atomic<std::atomic<Object *> *>[(pkg->names()->size() >> chunk_bits) + 1]()),
+      _types((pkg->types()->size() >> chunk_bits) + 1) {}
+
+ImportedPackage::~ImportedPackage() {
+    for (size_t i = 0; i <= _pkg->names()->size() >> chunk_bits; i++) {
+        delete[] _objs[i].load(std::memory_order_relaxed);
+    }
+}
+
+std::unique_ptr<ImportedPackage> ImportedPackage::open(Importer &importer, const uint8_t *data, size_t size) {
+    flatbuffers::Verifier v(data, size);
+    if (size < 2 * sizeof(flatbuffers::uoffset_t) || !exportdata::PackageBufferHasIdentifier(data) ||
+        v.VerifyOffset(0) == 0) {
+        return nullptr;
+    }
+    auto pkg = exportdata::GetPackage(data);
+    if (!verifyRoot(v, pkg) || pkg->version() != ExportDataVersion) {
+        return nullptr;
+    }
+    return std::unique_ptr<ImportedPackage>(new ImportedPackage(importer, data, size, pkg));
+}
+
+std::unique_ptr<ImportedPackage> ImportedPackage::Open(const std::string &file, Importer &importer) {
+    auto map = common::MappedFile::Open(file);
+    if (map == nullptr) {
+        return nullptr;
+    }
+    auto pkg = open(importer, reinterpret_cast<const uint8_t *>(map->Data()), map->Size());
+    if (pkg != nullptr) {
+        pkg->_map = std::move(map);
+    }
+    return pkg;
+}
+
+std::unique_ptr<ImportedPackage> ImportedPackage::Read(flatbuffers::DetachedBuffer data, Importer &importer) {
+    auto pkg = open(importer, data.data(), data.size());
+    if (pkg != nullptr) {
+        pkg->_buf = std::move(data);
+    }
+    return pkg;
+}
+
+std::string_view ImportedPackage::Path() const { return view(_pkg->path()); }
+std::string_view ImportedPackage::Name() const { return view(_pkg->name()); }
+
+template <typename T> bool ImportedPackage::verify(const T *entry) const {
+    flatbuffers::Verifier v(_data, _size);
+    return entry->Verify(v);
+}
+
+// find returns the index of the object of the given name, or -1. Only the
+// names compared are verified.
+int64_t ImportedPackage::find(std::string_view name) const {
+    auto names = _pkg->names();
+    flatbuffers::Verifier v(_data, _size);
+    uint32_t lo = 0, hi = names->size();
+    while (lo < hi) {
+        auto mid = lo + (hi - lo) / 2;
+        auto s = names->Get(mid);
+        if (!v.VerifyString(s)) {
+            return -1;
+        }
+        auto c = view(s).compare(name);
+        if (c == 0) {
+            return mid;
+        }
+        if (c < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return -1;
+}
+
+Object *ImportedPackage::Lookup(common::SymbolId name) {
+    auto i = find(common::Interner::Global().Name(name));
+    return i < 0 ? nullptr : object(uint32_t(i));
+}
+
+Object *ImportedPackage::object(uint32_t i) {
+    auto &chunk = _objs[i >> chunk_bits];
+    auto slots = chunk.load(std::memory_order_acquire);
+    if (slots != nullptr) {
+        if (auto obj = slots[i & (chunk_size - 1)].load(std::memory_order_acquire)) {
+            return obj;
+        }
+    }
+    std::lock_guard lock(_mu);
+    slots = chunk.load(std::memory_order_relaxed);
+    if (slots == nullptr) {
+        slots = new std::atomic<Object *>[chunk_size]();
+        chunk.store(slots, std::memory_order_release);
+    }
+    auto &slot = slots[i & (chunk_size - 1)];
+    if (auto obj = slot.load(std::memory_order_relaxed)) {
+        return obj;
+    }
+    auto d = _pkg->objects()->Get(i);
+    if (!verify(d)) {
+        return nullptr;
+    }
+    auto kind = ObjKind(d->kind());
+    if (kind != ObjKind::Const && kind != ObjKind::TypeName && kind != ObjKind::Var && kind != ObjKind::Func) {
+        return nullptr;
+    }
+    _decoded.fetch_add(1, std::memory_order_relaxed);
+    auto obj = &_objects.emplace_back();
+    obj->Kind = kind;
+    obj->Name = common::Interner::Global().Intern(view(_pkg->names()->Get(i)));
+    obj->Type = type(d->type());
+    if (kind == ObjKind::Const) {
+        obj->Val = value(d);
+    }
+    if (kind == ObjKind::Func) {
+        obj->Imported = this;
+        obj->Body = view(d->body());
+        if (auto leaks = d->leaks()) {
+            obj->Leaks = {leaks->data(), leaks->size()};
+        }
+        if (d->tparams() != nullptr) {
+            for (auto ref : *d->tparams()) {
+                auto t = type(ref);
+                if (t == 0 || TypeTable::Global().Kind(t) != KindTypeParam) {
+                    return nullptr;
+                }
+                obj->TParams.push_back(t);
+            }
+        }
+    }
+    slot.store(obj, std::memory_order_release);
+    return obj;
+}
+
+// typeSlot returns the slot of the decoded type with index i; mu is held.
+TypeId &ImportedPackage::typeSlot(uint32_t i) {
+    auto &chunk = _types[i >> chunk_bits];
+    if (chunk == nullptr) {
+        chunk = std::make_unique<TypeId[]>(chunk_size);
+    }
+    return chunk[i & (chunk_size - 1)];
+}
+
+// type returns the type with the given TypeRef, decoding it on first use;
+// mu is held. A named type of the package is recorded before its
+// underlying type is decoded, which may refer to it, and so is a type
+// parameter before its constraint.
+TypeId ImportedPackage::type(uint32_t ref) {
+    if (ref < firstTypeRef) {
+        return ref == errorTypeRef ? ErrorType() : ref <= KindUntypedNil ? ref : 0;
+    }
+    auto i = ref - firstTypeRef;
+    if (i >= _pkg->types()->size()) {
+        return 0;
+    }
+    if (auto t = typeSlot(i)) {
+        return t;
+    }
+    auto d = _pkg->types()->Get(i);
+    if (!verify(d)) {
+        return 0;
+    }
+    _decoded.fetch_add(1, std::memory_order_relaxed);
+    auto &table = TypeTable::Global();
+    auto &interner = common::Interner::Global();
+    if (d->kind() == KindNamed) {
+        auto name = interner.Intern(view(d->name()));
+        if (d->pkg() != nullptr) {
+            auto pkg = _importer.Import(view(d->pkg()));
+            auto obj = pkg == nullptr ? nullptr : pkg->Lookup(name);
+            return typeSlot(i) = obj != nullptr && obj->Kind == ObjKind::TypeName ? obj->Type : 0;
+        }
+        auto t = typeSlot(i) = table.NewNamed(name);
+        _named.emplace(t, i);
+        _importer._owners.insert(t, this);
+        table.SetUnderlying(t, table.Underlying(type(d->underlying())));
+        return t;
+    }
+    if (d->kind() == KindTypeParam) {
+        auto t = typeSlot(i) = table.NewTypeParam(interner.Intern(view(d->name())), d->len());
+        auto c = d->elems() != nullptr && d->elems()->size() == 1 ? type(d->elems()->Get(0)) : 0;
+        table.SetConstraint(t, c != 0 ? c : table.Interface({}, {}));
+        return t;
+    }
+
+    std::vector<TypeId> elems;
+    if (d->elems() != nullptr) {
+        for (auto e : *d->elems()) {
+            auto t = type(TermType(e));
+            if (t == 0) {
+                return 0;
+            }
+            elems.push_back(t | (e & TildeTerm));
+        }
+    }
+    std::vector<common::SymbolId> names;
+    if (d->names() != nullptr) {
+        for (uint32_t j = 0; j < d->names()->size(); j++) {
+            auto name = interner.Intern(view(d->names()->Get(j)));
+            auto embedded = d->embedded() != nullptr && j < d->embedded()->size() && d->embedded()->Get(j) != 0;
+            names.push_back(embedded ? name | EmbeddedField : name);
+        }
+    }
+    auto n = elems.size();
+    TypeId t = 0;
+    switch (d->kind()) {
+    case KindArray:
+        t = n == 1 ? table.Array(d->len(), elems[0]) : 0;
+        break;
+    case KindSlice:
+        t = n == 1 ? table.Slice(elems[0]) : 0;
+        break;
+    case KindPointer:
+        t = n == 1 ? table.Pointer(elems[0]) : 0;
+        break;
+    case KindMap:
+        t = n == 2 ? table.Map(elems[0], elems[1]) : 0;
+        break;
+    case KindChan:
+        t = n == 1 ? table.Chan(uint32_t(d->len()), elems[0]) : 0;
+        break;
+    case KindFunc:
+        if (d->len() >= 0 && uint64_t(d->len()) <= n) {
+            auto params = std::span<const TypeId>(elems).first(size_t(d->len()));
+            auto results = std::span<const TypeId>(elems).subspan(size_t(d->len()));
+            t = table.Func(params, results, d->variadic());
+        }
+        break;
+    case KindStruct:
+        t = names.size() == n ? table.Struct(names, elems) : 0;
+        break;
+    case KindInterface:
+        if (d->len() >= 0 && names.size() + uint64_t(d->len()) == n) {
+            auto list = std::span<const TypeId>(elems);
+            t = table.Interface(names, list.first(names.size()), list.subspan(names.size()), d->variadic());
+        }
+        break;
+    default:
+        break;
+    }
+    return typeSlot(i) = t;
+}
+
+Value ImportedPackage::value(const exportdata::Object *d) const {
+    auto parts = d->const_parts();
+    auto n = parts == nullptr ? 0 : parts->size();
+    auto part = [&](uint32_t i) { return view(parts->Get(i)); };
+    auto rat = [&](uint32_t i) {
+        auto num = parseInt(part(i)), den = parseInt(part(i + 1));
+        return num && den ? Value::MakeRat(*num, *den) : Value();
+    };
+    switch (ConstKind(d->const_kind())) {
+    case ConstKind::Bool:
+        return n == 1 ? Value::MakeBool(part(0) == "1") : Value();
+    case ConstKind::String:
+        return n == 1 ? Value::MakeString(std::string(part(0))) : Value();
+    case ConstKind::Int:
+        if (auto v = n == 1 ? parseInt(part(0)) : std::nullopt) {
+            return Value::MakeInt(*v);
+        }
+        return {};
+    case ConstKind::Float:
+        return n == 2 ? rat(0) : Value();
+    case ConstKind::Complex:
+        return n == 4 ? Value::MakeComplex(rat(0), rat(2)) : Value();
+    default:
+        return {};
+    }
+}
+
+std::span<Object *const> ImportedPackage::Methods(TypeId t) {
+    const std::vector<Object *> *methods = nullptr;
+    if (_methods.find(t, methods)) {
+        return *methods;
+    }
+    std::lock_guard lock(_mu);
+    if (_methods.find(t, methods)) {
+        return *methods;
+    }
+    auto it = _named.find(t);
+    if (it == _named.end()) {
+        return {};
+    }
+    auto &list = _method_lists.emplace_back();
+    // the description of a decoded type is verified
+    if (auto ms = _pkg->types()->Get(it->second)->methods()) {
+        auto &interner = common::Interner::Global();
+        for (auto m : *ms) {
+            _decoded.fetch_add(1, std::memory_order_relaxed);
+            auto obj = &_objects.emplace_back();
+            obj->Kind = ObjKind::Func;
+            obj->Name = interner.Intern(view(m->name()));
+            obj->Type = type(m->sig());
+            obj->PtrRecv = m->ptr_recv();
+            obj->Imported = this;
+            obj->Body = view(m->body());
+            if (auto leaks = m->leaks()) {
+                obj->Leaks = {leaks->data(), leaks->size()};
+            }
+            list.push_back(obj);
+        }
+    }
+    _methods.insert(t, &list);
+    return list;
+}
+
+// ----------------------------------------------------------------------------
+// DirImporter
+
+DirImporter::DirImporter(std::string dir) : _dir(std::move(dir)) {}
+
+std::string DirImporter::File(std::string_view path) const {
+    return fmt::format("{}/{}.{}", _dir, path, exportdata::PackageExtension());
+}
+
+ImportedPackage *DirImporter::Import(std::string_view path) {
+    std::lock_guard lock(_mu);
+    auto [it, added] = _packages.try_emplace(std::string(path));
+    if (added && !_dir.empty()) {
+        it->second = ImportedPackage::Open(File(path), *this);
+    }
+    return it->second.get();
+}
+
+bool DirImporter::Add(std::string_view path, flatbuffers::DetachedBuffer data) {
+    static std::atomic<uint64_t> seq{0};
+
+    std::unique_ptr<ImportedPackage> pkg;
+    if (_dir.empty()) {
+        pkg = ImportedPackage::Read(std::move(data), *this);
+    } else {
+        auto file = File(path);
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(file).parent_path(), ec);
+        auto tmp = fmt::format("{}.{}.{}.tmp", file, getpid(), seq.fetch_add(1));
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(data.data()), std::streamsize(data.size()));
+            if (!out.flush()) {
+                out.close();
+                std::filesystem::remove(tmp, ec);
+                return false;
+            }
+        }
+        std::filesystem::rename(tmp, file, ec);
+        if (ec) {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        pkg = ImportedPackage::Open(file, *this);
+    }
+    if (pkg == nullptr) {
+        return false;
+    }
+    std::lock_guard lock(_mu);
+    _packages[std::string(path)] = std::move(pkg);
+    return true;
+}
+
+} // namespace types
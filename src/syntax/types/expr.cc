@@ -0,0 +1,2110 @@
+#include <cmath>
+#include <limits>
+
+#include <fmt/format.h>
+
+#include "syntax/operator_string.hh"
+#include "syntax/types/check.hh"
+#include "syntax/types/export.hh"
+
+namespace types {
+
+using Context = Checker::Context;
+
+namespace {
+
+std::string_view nameOf(common::SymbolId sym) { return common::Interner::Global().Name(sym); }
+
+// representable reports whether the constant v can be represented in the
+// basic type t, and stores it rounded to t in rounded: floating-point
+// constants of a sized type have the precision of the type.
+bool representable(const Value &v, TypeId t, Value &rounded) {
+    auto u = TypeTable::Global().Underlying(t);
+    if (IsInteger(u)) {
+        auto x = v.ToInt();
+        if (!x.IsKnown()) {
+            return false;
+        }
+        rounded = x;
+        auto i = x.Int64Val();
+        switch (u) {
+        case KindInt8:
+            return i && *i >= INT8_MIN && *i <= INT8_MAX;
+        case KindInt16:
+            return i && *i >= INT16_MIN && *i <= INT16_MAX;
+        case KindInt32:
+            return i && *i >= INT32_MIN && *i <= INT32_MAX;
+        case KindInt:
+        case KindInt64:
+            return i.has_value();
+        case KindUint8:
+            return i && *i >= 0 && *i <= UINT8_MAX;
+        case KindUint16:
+            return i && *i >= 0 && *i <= UINT16_MAX;
+        case KindUint32:
+            return i && *i >= 0 && *i <= UINT32_MAX;
+        case KindUint:
+        case KindUint64:
+        case KindUintptr:
+            return x.Uint64Val().has_value();
+        default:
+            return true; // untyped
+        }
+    }
+    auto round = [](const Value &x, TypeId k) {
+        if (k == KindFloat32 || k == KindComplex64) {
+            auto f = x.Float32Val();
+            return std::isinf(f) ? Value{} : Value::MakeFloat64(f);
+        }
+        if (k == KindFloat64 || k == KindComplex128) {
+            auto f = x.Float64Val();
+            return std::isinf(f) ? Value{} : Value::MakeFloat64(f);
+        }
+        return x;
+    };
+    if (IsFloat(u)) {
+        rounded = round(v.ToFloat(), u);
+        return rounded.IsKnown();
+    }
+    if (IsComplex(u)) {
+        auto c = v.ToComplex();
+        if (!c.IsKnown()) {
+            return false;
+        }
+        auto re = round(c.Real(), u), im = round(c.Imag(), u);
+        rounded = Value::MakeComplex(re, im);
+        return re.IsKnown() && im.IsKnown();
+    }
+    rounded = v;
+    return IsBoolean(u) ? v.Kind() == ConstKind::Bool : IsString(u) && v.Kind() == ConstKind::String;
+}
+
+// truncated reports whether v is not representable in the basic type t
+// because of a fractional or imaginary part, rather than its magnitude.
+bool truncated(const Value &v, TypeId t) {
+    auto u = TypeTable::Global().Underlying(t);
+    return IsInteger(u) ? !v.ToInt().IsKnown() : IsFloat(u) && !v.ToFloat().IsKnown();
+}
+
+// appendRune appends the UTF-8 encoding of r, or of U+FFFD if r is not a
+// valid code point.
+void appendRune(std::string &s, int64_t r) {
+    if (r < 0 || r > 0x10ffff || (r >= 0xd800 && r < 0xe000)) {
+        r = 0xfffd;
+    }
+    if (r < 0x80) {
+        s += char(r);
+    } else if (r < 0x800) {
+        s += char(0xc0 | r >> 6);
+        s += char(0x80 | (r & 0x3f));
+    } else if (r < 0x10000) {
+        s += char(0xe0 | r >> 12);
+        s += char(0x80 | (r >> 6 & 0x3f));
+        s += char(0x80 | (r & 0x3f));
+    } else {
+        s += char(0xf0 | r >> 18);
+        s += char(0x80 | (r >> 12 & 0x3f));
+        s += char(0x80 | (r >> 6 & 0x3f));
+        s += char(0x80 | (r & 0x3f));
+    }
+}
+
+// unsignedBits returns the size in bits of an unsigned integer type, and 0
+// for other types.
+unsigned unsignedBits(TypeId t) {
+    switch (TypeTable::Global().Underlying(t)) {
+    case KindUint8:
+        return 8;
+    case KindUint16:
+        return 16;
+    case KindUint32:
+        return 32;
+    case KindUint:
+    case KindUint64:
+    case KindUintptr:
+        return 64;
+    default:
+        return 0;
+    }
+}
+
+// opName names an operation for overflow errors.
+const char *opName(syntax::Operator op, bool unary) {
+    switch (op) {
+    case Operator_Add:
+        return unary ? "" : "addition ";
+    case Operator_Sub:
+        return unary ? "negation " : "subtraction ";
+    case Operator_Mul:
+        return "multiplication ";
+    case Operator_Xor:
+        return unary ? "bitwise complement " : "bitwise XOR ";
+    case Operator_Shl:
+        return "shift ";
+    default:
+        return "";
+    }
+}
+
+// rank orders the untyped numeric kinds: a binary operation on two untyped
+// operands has the kind of the larger one.
+int rank(TypeId t) {
+    switch (t) {
+    case KindUntypedInt:
+        return 1;
+    case KindUntypedRune:
+        return 2;
+    case KindUntypedFloat:
+        return 3;
+    case KindUntypedComplex:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+bool isComparison(syntax::Operator op) { return op >= Operator_Eql && op <= Operator_Geq; }
+
+bool isShift(syntax::Operator op) { return op == Operator_Shl || op == Operator_Shr; }
+
+} // namespace
+
+// updateType records the final type of an untyped expression e and of the
+// untyped operands it was computed from. A delayed shift takes its type
+// there, which must be an integer type.
+void Context::updateType(ast::ExprNode *e, TypeId t) {
+    while (e != nullptr && IsUntyped(e->typ) && !IsUntyped(t)) {
+        e->SetType(t);
+        if (auto p = dyn_cast<ast::ParenExpr>(e)) {
+            e = p->X.get();
+        } else if (auto op = dyn_cast<ast::Operation>(e); op && !isComparison(op->Op)) {
+            if (op->Y != nullptr && !isShift(op->Op)) {
+                updateType(op->Y.get(), t);
+            }
+            if (delayed_shifts.erase(op) != 0 && !IsInteger(t)) {
+                error(op->X.get(), fmt::format("invalid operation: shifted operand {} (type {}) must be integer",
+                                      ast::String(op->X.get()), table.String(t)));
+            }
+            e = op->X.get();
+        } else {
+            break;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Operands
+
+std::string Context::describe(const Operand &x) {
+    auto e = x.expr == nullptr ? std::string() : ast::String(x.expr);
+    if (x.type == KindUntypedNil) {
+        return "nil";
+    }
+    switch (x.mode) {
+    case Mode::Invalid:
+        return fmt::format("{} (invalid operand)", e);
+    case Mode::NoValue:
+        return fmt::format("{} (no value)", e);
+    case Mode::Builtin:
+        return fmt::format("{} (built-in)", e);
+    case Mode::TypeExpr:
+        return fmt::format("{} (type)", e);
+    case Mode::Constant:
+        if (IsUntyped(x.type)) {
+            return fmt::format("{} ({} constant)", e, table.String(x.type));
+        }
+        return fmt::format("{} (constant of type {})", e, table.String(x.type));
+    case Mode::Variable:
+        return fmt::format("{} (variable of type {})", e, table.String(x.type));
+    case Mode::MapIndex:
+        return fmt::format("{} (map index expression of type {})", e, table.String(x.type));
+    default:
+        if (IsUntyped(x.type)) {
+            return fmt::format("{} ({} value)", e, table.String(x.type));
+        }
+        return fmt::format("{} (value of type {})", e, table.String(x.type));
+    }
+}
+
+// rawExpr checks e and records its type. The result may be a type, a
+// built-in, no value or several values; hint is the type of the enclosing
+// composite literal element, for literals with elided types.
+void Context::rawExpr(Operand &x, ast::ExprNode *e, TypeId hint) {
+    x = Operand{};
+    exprInternal(x, e, hint);
+    x.expr = e;
+    if (!x.Invalid() && x.tuple.empty()) {
+        e->SetType(x.type);
+    }
+}
+
+void Context::expr(Operand &x, ast::ExprNode *e, TypeId hint) {
+    rawExpr(x, e, hint);
+    value(x);
+    singleValue(x);
+}
+
+void Context::multiExpr(Operand &x, ast::ExprNode *e, TypeId hint) {
+    rawExpr(x, e, hint);
+    value(x);
+}
+
+// value reports an operand x that is not a value, or a generic function
+// that is not instantiated, and invalidates it.
+void Context::value(Operand &x) {
+    auto e = x.expr;
+    switch (x.mode) {
+    case Mode::NoValue:
+        error(e, fmt::format("{} (no value) used as value", ast::String(e)));
+        x.mode = Mode::Invalid;
+        break;
+    case Mode::Builtin:
+        error(e, fmt::format("{} (built-in) must be called", ast::String(e)));
+        x.mode = Mode::Invalid;
+        break;
+    case Mode::TypeExpr:
+        error(e, fmt::format("{} (type) is not an expression", ast::String(e)));
+        x.mode = Mode::Invalid;
+        break;
+    default:
+        if (x.generic != nullptr && !x.Invalid()) {
+            error(e, fmt::format("cannot use generic function {} without instantiation", ast::String(e)));
+            x.mode = Mode::Invalid;
+        }
+        break;
+    }
+}
+
+// singleValue reports a call with several results used as one value, and
+// invalidates x.
+void Context::singleValue(Operand &x) {
+    if (x.tuple.size() > 1) {
+        std::string types;
+        for (auto t : x.tuple) {
+            types += types.empty() ? "" : ", ";
+            types += table.String(t);
+        }
+        error(x.expr, fmt::format("multiple-value {} (value of type ({})) in single-value context",
+                                  ast::String(x.expr), types));
+        x.mode = Mode::Invalid;
+    }
+}
+
+void Context::exprOrType(Operand &x, ast::ExprNode *e) {
+    rawExpr(x, e, 0);
+    if (x.mode == Mode::NoValue) {
+        error(e, fmt::format("{} (no value) used as value or type", ast::String(e)));
+        x.mode = Mode::Invalid;
+    } else if (x.mode == Mode::Builtin) {
+        error(e, fmt::format("{} (built-in) must be called", ast::String(e)));
+        x.mode = Mode::Invalid;
+    } else if (x.generic != nullptr && !x.Invalid()) {
+        error(e, fmt::format("cannot use generic function {} without instantiation", ast::String(e)));
+        x.mode = Mode::Invalid;
+    }
+}
+
+// useExprs checks expressions whose values are not needed because of an
+// earlier error, so that the objects they refer to count as used.
+void Context::useExprs(std::span<const ast::ExprNodePtr> list) {
+    for (auto &e : list) {
+        if (e != nullptr) {
+            Operand x;
+            rawExpr(x, e.get(), 0);
+        }
+    }
+}
+
+void Context::exprInternal(Operand &x, ast::ExprNode *e, TypeId hint) {
+    switch (e->Kind()) {
+    case ast::NodeKind::BadExpr:
+        return;
+    case ast::NodeKind::Name:
+        ident(x, cast<ast::Name>(e));
+        return;
+    case ast::NodeKind::BasicLit:
+        basicLit(x, cast<ast::BasicLit>(e));
+        return;
+    case ast::NodeKind::CompositeLit:
+        compositeLit(x, cast<ast::CompositeLit>(e), hint);
+        return;
+    case ast::NodeKind::FuncLit:
+        funcLit(x, cast<ast::FuncLit>(e));
+        return;
+    case ast::NodeKind::ParenExpr:
+        rawExpr(x, cast<ast::ParenExpr>(e)->X.get(), hint);
+        return;
+    case ast::NodeKind::SelectorExpr:
+        selector(x, cast<ast::SelectorExpr>(e));
+        return;
+    case ast::NodeKind::IndexExpr:
+        index(x, cast<ast::IndexExpr>(e));
+        return;
+    case ast::NodeKind::SliceExpr:
+        sliceExpr(x, cast<ast::SliceExpr>(e));
+        return;
+    case ast::NodeKind::AssertExpr: {
+        auto a = cast<ast::AssertExpr>(e);
+        expr(x, a->X.get());
+        auto t = typExpr(a->Type.get());
+        if (x.Invalid() || t == 0) {
+            x.mode = Mode::Invalid;
+            return;
+        }
+        if (!IsInterface(x.type)) {
+            error(a->X.get(), fmt::format("invalid operation: {} is not an interface", describe(x)));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        if (!IsInterface(t)) {
+            if (auto m = MissingMethod(check, t, x.type)) {
+                error(a->Type.get(), fmt::format("impossible type assertion: {}\n\t{} does not implement {} (missing "
+                                                 "method {})",
+                                                 ast::String(e), table.String(t), table.String(x.type), nameOf(m)));
+                x.mode = Mode::Invalid;
+                return;
+            }
+        }
+        x.mode = Mode::CommaOk;
+        x.type = t;
+        return;
+    }
+    case ast::NodeKind::TypeSwitchGuard:
+        error(e, "use of .(type) outside type switch");
+        return;
+    case ast::NodeKind::Operation: {
+        auto op = cast<ast::Operation>(e);
+        if (op->Y == nullptr) {
+            unary(x, op);
+        } else {
+            binary(x, op, op->X.get(), op->Y.get(), op->Op);
+        }
+        return;
+    }
+    case ast::NodeKind::CallExpr:
+        call(x, cast<ast::CallExpr>(e));
+        return;
+    case ast::NodeKind::KeyValueExpr:
+        error(e, "invalid use of key-value expression");
+        return;
+    case ast::NodeKind::ListExpr:
+        error(e, fmt::format("unexpected list of expressions {}", ast::String(e)));
+        return;
+    case ast::NodeKind::DotsType:
+        error(e, "invalid use of ...");
+        return;
+    case ast::NodeKind::ArrayType: {
+        auto a = cast<ast::ArrayType>(e);
+        if (a->Len == nullptr) {
+            error(e, "invalid use of [...] array (outside a composite literal)");
+            typExpr(a->Elem.get());
+            return;
+        }
+        auto elem = typExpr(a->Elem.get());
+        x.type = arrayLength(a->Len.get(), elem);
+        break;
+    }
+    case ast::NodeKind::SliceType: {
+        auto elem = typExpr(cast<ast::SliceType>(e)->Elem.get());
+        x.type = elem == 0 ? 0 : table.Slice(elem);
+        break;
+    }
+    case ast::NodeKind::StructType:
+        x.type = structType(cast<ast::StructType>(e));
+        break;
+    case ast::NodeKind::InterfaceType:
+        x.type = interfaceType(cast<ast::InterfaceType>(e));
+        break;
+    case ast::NodeKind::FuncType:
+        x.type = funcType(cast<ast::FuncType>(e));
+        break;
+    case ast::NodeKind::MapType: {
+        auto m = cast<ast::MapType>(e);
+        auto key = typExpr(m->Key.get());
+        auto value = typExpr(m->Value.get());
+        if (key == 0 || value == 0) {
+            return;
+        }
+        // the key type of a named type declared later is checked when known
+        if (table.Underlying(key) != 0 && !Comparable(key)) {
+            error(m->Key.get(), fmt::format("invalid map key type {}", table.String(key)));
+            return;
+        }
+        x.type = table.Map(key, value);
+        break;
+    }
+    case ast::NodeKind::ChanType: {
+        auto c = cast<ast::ChanType>(e);
+        auto elem = typExpr(c->Elem.get());
+        x.type = elem == 0 ? 0 : table.Chan(c->Dir, elem);
+        break;
+    }
+    default:
+        error(e, fmt::format("unexpected {} in expression", ast::String(e)));
+        return;
+    }
+    // type literals
+    x.mode = x.type == 0 ? Mode::Invalid : Mode::TypeExpr;
+}
+
+void Context::ident(Operand &x, ast::Name *e) {
+    if (e->Value == "_") {
+        error(e, "cannot use _ as value");
+        return;
+    }
+    auto obj = lookup(e);
+    if (obj == nullptr) {
+        error(e, fmt::format("undefined: {}", e->Value));
+        return;
+    }
+    // a named type is known before its declaration is checked, which
+    // allows recursive types
+    if (obj->IsPackageLevel() && !(obj->Kind == ObjKind::TypeName && obj->Type != 0)) {
+        check.objDecl(*this, obj);
+    }
+    use(e, obj);
+    if (obj->Kind == ObjKind::PkgName) {
+        error(e, fmt::format("use of package {} without selector", e->Value));
+        return;
+    }
+    if (static const auto universeIota = Universe().LookupLocal(common::Interner::Global().Intern("iota"));
+        obj == universeIota) {
+        if (iota < 0) {
+            error(e, "cannot use iota outside constant declaration");
+            return;
+        }
+        x.mode = Mode::Constant;
+        x.type = KindUntypedInt;
+        x.val = Value::MakeInt64(iota);
+        return;
+    }
+    object(x, e, obj);
+}
+
+// object sets x to the value, type or function the object obj named by e
+// denotes.
+void Context::object(Operand &x, ast::Name *e, Object *obj) {
+    switch (obj->Kind) {
+    case ObjKind::PkgName:
+    case ObjKind::Label:
+        error(e, fmt::format("undefined: {}", e->Value));
+        return;
+    case ObjKind::Const:
+        x.mode = Mode::Constant;
+        x.val = obj->Val;
+        break;
+    case ObjKind::TypeName:
+        x.mode = Mode::TypeExpr;
+        break;
+    case ObjKind::Var:
+        x.mode = Mode::Variable;
+        break;
+    case ObjKind::Func:
+        x.mode = Mode::Value;
+        if (!obj->TParams.empty()) {
+            x.generic = obj;
+        }
+        break;
+    case ObjKind::Builtin:
+        x.mode = Mode::Builtin;
+        x.builtin = obj->Builtin;
+        return;
+    case ObjKind::Nil:
+        x.mode = Mode::Value;
+        break;
+    }
+    x.type = obj->Type;
+    if (x.type == 0) {
+        x.mode = Mode::Invalid; // the declaration has errors
+    }
+}
+
+void Context::basicLit(Operand &x, ast::BasicLit *e) {
+    if (e->Bad) {
+        return;
+    }
+    x.val = Value::MakeFromLiteral(e->Value, e->Kind);
+    if (!x.val.IsKnown()) {
+        error(e, fmt::format("malformed constant: {}", e->Value));
+        return;
+    }
+    x.mode = Mode::Constant;
+    switch (e->Kind) {
+    case IntLit:
+        x.type = KindUntypedInt;
+        break;
+    case FloatLit:
+        x.type = KindUntypedFloat;
+        break;
+    case ImagLit:
+        x.type = KindUntypedComplex;
+        break;
+    case RuneLit:
+        x.type = KindUntypedRune;
+        break;
+    default:
+        x.type = KindUntypedString;
+        break;
+    }
+}
+
+void Context::compositeLit(Operand &x, ast::CompositeLit *e, TypeId hint) {
+    TypeId typ = 0, base = 0;
+    if (auto a = dyn_cast_or_null<ast::ArrayType>(e->Type.get()); a && a->Len == nullptr) {
+        // [...]T{...}: the length is the number of elements
+        auto elem = typExpr(a->Elem.get());
+        if (elem != 0) {
+            int64_t n = 0;
+            if (e->Packed != nullptr) {
+                n = int64_t(e->Packed->Len());
+            } else {
+                int64_t i = 0;
+                for (auto &el : e->ElemList) {
+                    if (auto kv = dyn_cast<ast::KeyValueExpr>(el.get())) {
+                        indexValue(kv->Key.get(), -1, i);
+                    }
+                    n = std::max(n, ++i);
+                }
+            }
+            typ = base = table.Array(n, elem);
+            a->SetType(typ);
+        }
+    } else if (e->Type != nullptr) {
+        typ = base = typExpr(e->Type.get());
+    } else if (hint != 0) {
+        typ = base = hint;
+        // &T{...} may be elided to {...} in a []*T literal
+        if (table.Kind(under(hint)) == KindPointer) {
+            base = table[under(hint)].Elem();
+        }
+    } else {
+        error(e, "invalid composite literal type: missing type");
+    }
+    if (typ == 0) {
+        // the keys may be field names, which cannot be resolved without
+        // the type
+        for (auto &el : e->ElemList) {
+            Operand y;
+            auto kv = dyn_cast<ast::KeyValueExpr>(el.get());
+            rawExpr(y, kv != nullptr ? kv->Value.get() : el.get(), 0);
+        }
+        return;
+    }
+
+    auto u = under(base);
+    auto &t = table[u];
+    switch (t.Kind) {
+    case KindStruct: {
+        if (e->ElemList.empty()) {
+            break;
+        }
+        if (e->NKeys > 0) {
+            if (size_t(e->NKeys) != e->ElemList.size()) {
+                error(e, "mixture of field:value and value elements in struct literal");
+            }
+            std::vector<bool> seen(t.Names.size());
+            for (auto &el : e->ElemList) {
+                auto kv = dyn_cast<ast::KeyValueExpr>(el.get());
+                if (kv == nullptr) {
+                    Operand y;
+                    rawExpr(y, el.get(), 0);
+                    continue;
+                }
+                auto key = dyn_cast<ast::Name>(kv->Key.get());
+                size_t i = t.Names.size();
+                if (key != nullptr) {
+                    for (i = 0; i < t.Names.size(); i++) {
+                        if (FieldName(t.Names[i]) == key->Sym) {
+                            break;
+                        }
+                    }
+                }
+                if (i == t.Names.size()) {
+                    error(kv->Key.get(), fmt::format("unknown field {} in struct literal of type {}",
+                                                     ast::String(kv->Key.get()), table.String(base)));
+                    Operand y;
+                    rawExpr(y, kv->Value.get(), 0);
+                    continue;
+                }
+                kv->Key->SetType(t.Elems[i]);
+                if (seen[i]) {
+                    error(kv->Key.get(), fmt::format("duplicate field name {} in struct literal", key->Value));
+                }
+                seen[i] = true;
+                Operand y;
+                expr(y, kv->Value.get(), t.Elems[i]);
+                assignment(y, t.Elems[i], "struct literal");
+            }
+            break;
+        }
+        for (size_t i = 0; i < e->ElemList.size(); i++) {
+            Operand y;
+            if (i >= t.Elems.size()) {
+                error(e->ElemList[i].get(), fmt::format("too many values in struct literal of type {}",
+                                                        table.String(base)));
+                break;
+            }
+            expr(y, e->ElemList[i].get(), t.Elems[i]);
+            assignment(y, t.Elems[i], "struct literal");
+        }
+        if (e->ElemList.size() < t.Elems.size()) {
+            errorf(e->Rbrace, fmt::format("too few values in struct literal of type {}", table.String(base)));
+        }
+        break;
+    }
+    case KindArray:
+    case KindSlice: {
+        auto elem = t.Elem();
+        int64_t max = t.Kind == KindArray ? t.Len : -1;
+        if (e->Packed != nullptr) {
+            if (!IsInteger(elem)) {
+                error(e, fmt::format("cannot use integer constants as {} value in array or slice literal",
+                                     table.String(elem)));
+            } else if (max >= 0 && int64_t(e->Packed->Len()) > max) {
+                error(e, fmt::format("index {} out of bounds [0:{}]", max, max));
+            }
+            break;
+        }
+        std::unordered_map<int64_t, bool> seen;
+        int64_t i = 0;
+        for (auto &el : e->ElemList) {
+            auto val = el.get();
+            if (auto kv = dyn_cast<ast::KeyValueExpr>(el.get())) {
+                indexValue(kv->Key.get(), max, i);
+                val = kv->Value.get();
+            } else if (max >= 0 && i >= max) {
+                error(val, fmt::format("index {} out of bounds [0:{}]", i, max));
+            }
+            if (!seen.emplace(i, true).second) {
+                error(el.get(), fmt::format("duplicate index {} in array or slice literal", i));
+            }
+            i++;
+            Operand y;
+            expr(y, val, elem);
+            assignment(y, elem, "array or slice literal");
+        }
+        break;
+    }
+    case KindMap: {
+        for (auto &el : e->ElemList) {
+            auto kv = dyn_cast<ast::KeyValueExpr>(el.get());
+            if (kv == nullptr) {
+                error(el.get(), "missing key in map literal");
+                Operand y;
+                rawExpr(y, el.get(), 0);
+                continue;
+            }
+            Operand k, v;
+            expr(k, kv->Key.get(), t.Key());
+            assignment(k, t.Key(), "map literal");
+            expr(v, kv->Value.get(), t.Elem());
+            assignment(v, t.Elem(), "map literal");
+        }
+        break;
+    }
+    default:
+        if (u != 0) {
+            error(e, fmt::format("invalid composite literal type {}", table.String(typ)));
+        }
+        useExprs(e->ElemList);
+        return;
+    }
+    x.mode = Mode::Value;
+    x.type = typ;
+}
+
+void Context::funcLit(Operand &x, ast::FuncLit *e) {
+    auto sig = funcType(e->Type.get());
+    if (e->Body != nullptr) {
+        funcBody(e->Type.get(), nullptr, sig, 0, e->Body.get());
+    }
+    if (sig != 0) {
+        x.mode = Mode::Value;
+        x.type = sig;
+    }
+}
+
+void Context::selector(Operand &x, ast::SelectorExpr *e) {
+    // qualified identifier pkg.Name; those of packages that could not be
+    // imported, reported at the import, are left unresolved
+    if (auto n = dyn_cast<ast::Name>(e->X.get())) {
+        if (auto obj = lookup(n); obj != nullptr && obj->Kind == ObjKind::PkgName) {
+            use(n, obj);
+            if (obj->Imported == nullptr) {
+                return;
+            }
+            auto exp = obj->Imported->Lookup(e->Sel->Sym);
+            if (exp == nullptr) {
+                error(e->Sel.get(), fmt::format("undefined: {}", ast::String(e)));
+                return;
+            }
+            if (!IsExported(e->Sel->Value)) {
+                error(e->Sel.get(),
+                      fmt::format("name {} not exported by package {}", e->Sel->Value, obj->Imported->Name()));
+                return;
+            }
+            uses.emplace_back(e->Sel.get(), exp); // imported objects are shared: nothing to mark
+            object(x, e->Sel.get(), exp);
+            return;
+        }
+    }
+    exprOrType(x, e->X.get());
+    if (x.Invalid()) {
+        return;
+    }
+    auto sel = e->Sel->Value;
+    if (x.mode == Mode::TypeExpr) {
+        // method expression T.m
+        auto s = LookupFieldOrMethod(check, x.type, e->Sel->Sym);
+        if (s.kind != Selection::Method) {
+            error(e->Sel.get(), fmt::format("{}.{} undefined (type {} has no method {})", ast::String(e->X.get()), sel,
+                                            table.String(x.type), sel));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        if (s.method != nullptr && s.method->PtrRecv && table.Kind(x.type) != KindPointer && !s.indirect) {
+            error(e, fmt::format("invalid method expression {}.{} (needs pointer receiver (*{}).{})",
+                                 ast::String(e->X.get()), sel, ast::String(e->X.get()), sel));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        auto &sig = table[s.type];
+        std::vector<TypeId> params{x.type};
+        params.insert(params.end(), sig.Params().begin(), sig.Params().end());
+        x.mode = Mode::Value;
+        x.type = table.Func(params, sig.Results(), sig.Variadic);
+        return;
+    }
+    if (x.type == KindUntypedNil) {
+        error(e, fmt::format("invalid operation: {} (nil has no field or method {})", ast::String(e), sel));
+        x.mode = Mode::Invalid;
+        return;
+    }
+    auto s = LookupFieldOrMethod(check, x.type, e->Sel->Sym);
+    switch (s.kind) {
+    case Selection::None:
+        error(e->Sel.get(), fmt::format("{}.{} undefined (type {} has no field or method {})", ast::String(e->X.get()),
+                                        sel, table.String(x.type), sel));
+        x.mode = Mode::Invalid;
+        return;
+    case Selection::Ambiguous:
+        error(e->Sel.get(), fmt::format("ambiguous selector {}", ast::String(e)));
+        x.mode = Mode::Invalid;
+        return;
+    case Selection::Field:
+        // a field of an addressable struct or reached through a pointer is addressable
+        x.mode = x.mode == Mode::Variable || s.indirect ? Mode::Variable : Mode::Value;
+        x.type = s.type;
+        return;
+    case Selection::Method:
+        if (s.method != nullptr && s.method->PtrRecv && !s.indirect && x.mode != Mode::Variable) {
+            error(e, fmt::format("cannot call pointer method {} on {}", sel, table.String(x.type)));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        x.mode = Mode::Value;
+        x.type = s.type;
+        return;
+    }
+}
+
+// indexValue checks an index expression e. If e is a constant, its value is
+// stored in val and checked against max, unless max is negative.
+bool Context::indexValue(ast::ExprNode *e, int64_t max, int64_t &val) {
+    Operand x;
+    expr(x, e);
+    if (x.Invalid()) {
+        return false;
+    }
+    if (IsUntyped(x.type)) {
+        convertUntyped(x, KindInt);
+        if (x.Invalid()) {
+            return false;
+        }
+        updateType(x.expr, x.type);
+    }
+    if (!IsInteger(x.type)) {
+        error(e, fmt::format("invalid argument: index {} must be integer", describe(x)));
+        return false;
+    }
+    if (x.mode != Mode::Constant || !x.val.IsKnown()) {
+        return false;
+    }
+    if (x.val.Sign() < 0) {
+        error(e, fmt::format("invalid argument: index {} must not be negative", describe(x)));
+        return false;
+    }
+    auto v = x.val.Int64Val();
+    if (v && max >= 0 && *v >= max) {
+        error(e, fmt::format("invalid argument: index {} out of bounds [0:{}]", *v, max));
+        return false;
+    }
+    if (!v) {
+        error(e, fmt::format("invalid argument: index {} overflows int", describe(x)));
+        return false;
+    }
+    val = *v;
+    return true;
+}
+
+void Context::index(Operand &x, ast::IndexExpr *e) {
+    rawExpr(x, e->X.get(), 0);
+    if (x.generic != nullptr && !x.Invalid()) {
+        funcInst(x, e);
+        return;
+    }
+    value(x);
+    singleValue(x);
+    if (x.Invalid()) {
+        Operand y;
+        rawExpr(y, e->Index.get(), 0);
+        return;
+    }
+    int64_t v;
+    auto &t = table[under(x.type)];
+    switch (t.Kind) {
+    case KindString:
+    case KindUntypedString:
+        indexValue(e->Index.get(), -1, v);
+        x.mode = Mode::Value;
+        x.type = KindUint8;
+        return;
+    case KindArray:
+        indexValue(e->Index.get(), t.Len, v);
+        x.mode = x.mode == Mode::Variable ? Mode::Variable : Mode::Value;
+        x.type = t.Elem();
+        return;
+    case KindPointer:
+        if (auto &a = table[under(t.Elem())]; a.Kind == KindArray) {
+            indexValue(e->Index.get(), a.Len, v);
+            x.mode = Mode::Variable;
+            x.type = a.Elem();
+            return;
+        }
+        break;
+    case KindSlice:
+        indexValue(e->Index.get(), -1, v);
+        x.mode = Mode::Variable;
+        x.type = t.Elem();
+        return;
+    case KindMap: {
+        Operand k;
+        expr(k, e->Index.get(), t.Key());
+        assignment(k, t.Key(), "map index");
+        x.mode = Mode::MapIndex;
+        x.type = t.Elem();
+        return;
+    }
+    default:
+        break;
+    }
+    error(e, fmt::format("invalid operation: cannot index {}", describe(x)));
+    Operand y;
+    rawExpr(y, e->Index.get(), 0);
+    x.mode = Mode::Invalid;
+}
+
+void Context::sliceExpr(Operand &x, ast::SliceExpr *e) {
+    expr(x, e->X.get());
+    int64_t max = -1;
+    if (!x.Invalid()) {
+        auto &t = table[under(x.type)];
+        switch (t.Kind) {
+        case KindString:
+        case KindUntypedString:
+            if (e->Full) {
+                error(e, fmt::format("invalid operation: 3-index slice of string"));
+                x.mode = Mode::Invalid;
+                break;
+            }
+            x.mode = Mode::Value;
+            x.type = x.type == KindUntypedString ? KindString : x.type;
+            break;
+        case KindArray:
+            if (x.mode != Mode::Variable) {
+                error(e, fmt::format("invalid operation: {} (slice of unaddressable value)", ast::String(e)));
+                x.mode = Mode::Invalid;
+                break;
+            }
+            max = t.Len + 1;
+            x.mode = Mode::Value;
+            x.type = table.Slice(t.Elem());
+            break;
+        case KindPointer:
+            if (auto &a = table[under(t.Elem())]; a.Kind == KindArray) {
+                max = a.Len + 1;
+                x.mode = Mode::Value;
+                x.type = table.Slice(a.Elem());
+                break;
+            }
+            [[fallthrough]];
+        default:
+            if (t.Kind == KindSlice) {
+                x.mode = Mode::Value;
+                break;
+            }
+            error(e, fmt::format("cannot slice {}", describe(x)));
+            x.mode = Mode::Invalid;
+            break;
+        }
+    }
+    // constant indices must be in increasing order
+    int64_t prev = -1;
+    for (auto &i : e->Index) {
+        int64_t v;
+        if (i != nullptr && indexValue(i.get(), max, v)) {
+            if (v < prev) {
+                error(i.get(), fmt::format("invalid slice indices: {} < {}", v, prev));
+            }
+            prev = v;
+        }
+    }
+}
+
+void Context::unary(Operand &x, ast::Operation *e) {
+    auto op = e->Op;
+    if (op == Operator_Mul) {
+        // pointer indirection or pointer type
+        exprOrType(x, e->X.get());
+        if (x.Invalid()) {
+            return;
+        }
+        if (x.mode == Mode::TypeExpr) {
+            x.type = table.Pointer(x.type);
+            return;
+        }
+        if (x.type == KindUntypedNil) {
+            error(e, "invalid operation: cannot indirect nil");
+            x.mode = Mode::Invalid;
+            return;
+        }
+        auto u = under(x.type);
+        if (table.Kind(u) != KindPointer) {
+            error(e, fmt::format("invalid operation: cannot indirect {}", describe(x)));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        x.mode = Mode::Variable;
+        x.type = table[u].Elem();
+        return;
+    }
+
+    expr(x, e->X.get());
+    if (x.Invalid()) {
+        return;
+    }
+    switch (op) {
+    case Operator_And: {
+        auto inner = e->X.get();
+        while (auto p = dyn_cast<ast::ParenExpr>(inner)) {
+            inner = p->X.get();
+        }
+        if (x.mode != Mode::Variable && !isa<ast::CompositeLit>(inner)) {
+            error(e, fmt::format("invalid operation: cannot take address of {}", describe(x)));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        x.mode = Mode::Value;
+        x.type = table.Pointer(x.type);
+        return;
+    }
+    case Operator_Recv: {
+        auto u = under(x.type);
+        if (table.Kind(u) != KindChan) {
+            error(e, fmt::format("invalid operation: cannot receive from non-channel {}", describe(x)));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        if (table[u].Len == SendOnly) {
+            error(e, fmt::format("invalid operation: cannot receive from send-only channel {}", describe(x)));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        x.mode = Mode::CommaOk;
+        x.type = table[u].Elem();
+        return;
+    }
+    case Operator_Tilde:
+        error(e, "cannot use ~ outside of interface or type constraint");
+        x.mode = Mode::Invalid;
+        return;
+    default:
+        break;
+    }
+
+    bool ok;
+    switch (op) {
+    case Operator_Add:
+    case Operator_Sub:
+        ok = IsNumeric(x.type);
+        break;
+    case Operator_Xor:
+        ok = IsInteger(x.type);
+        break;
+    case Operator_Not:
+        ok = IsBoolean(x.type);
+        break;
+    default:
+        ok = false;
+        break;
+    }
+    if (!ok) {
+        error(e, fmt::format("invalid operation: operator {} not defined on {}", syntax::OperatorString(op), describe(x)));
+        x.mode = Mode::Invalid;
+        return;
+    }
+    if (x.mode != Mode::Constant) {
+        x.mode = Mode::Value;
+        return;
+    }
+    x.val = UnaryOp(op, x.val, op == Operator_Xor ? unsignedBits(x.type) : 0);
+    overflow(x, e, op, true);
+}
+
+// binary checks lhs op rhs; e is the expression, or nil for an assignment
+// operation x op= y.
+void Context::binary(Operand &x, ast::Operation *e, ast::ExprNode *lhs, ast::ExprNode *rhs, syntax::Operator op) {
+    Operand y;
+    expr(x, lhs);
+    expr(y, rhs);
+    if (x.Invalid() || y.Invalid()) {
+        x.mode = Mode::Invalid;
+        return;
+    }
+    if (isShift(op)) {
+        shift(x, y, e, op);
+        return;
+    }
+    auto text = [&] {
+        return e != nullptr ? ast::String(e)
+                            : fmt::format("{} {}= {}", ast::String(lhs), syntax::OperatorString(op), ast::String(rhs));
+    };
+    matchTypes(x, y);
+    if (x.Invalid() || y.Invalid()) {
+        x.mode = Mode::Invalid;
+        return;
+    }
+    if (isComparison(op)) {
+        comparison(x, y, op);
+        return;
+    }
+    if (x.type != y.type) {
+        error(e != nullptr ? static_cast<ast::Node *>(e) : lhs,
+              fmt::format("invalid operation: {} (mismatched types {} and {})", text(), table.String(x.type),
+                          table.String(y.type)));
+        x.mode = Mode::Invalid;
+        return;
+    }
+
+    bool ok;
+    switch (op) {
+    case Operator_AndAnd:
+    case Operator_OrOr:
+        ok = IsBoolean(x.type);
+        break;
+    case Operator_Add:
+        ok = IsNumeric(x.type) || IsString(x.type);
+        break;
+    case Operator_Sub:
+    case Operator_Mul:
+    case Operator_Div:
+        ok = IsNumeric(x.type);
+        break;
+    default: // % & | ^ &^
+        ok = IsInteger(x.type);
+        break;
+    }
+    if (!ok) {
+        error(e != nullptr ? static_cast<ast::Node *>(e) : lhs,
+              fmt::format("invalid operation: operator {} not defined on {}", syntax::OperatorString(op), describe(x)));
+        x.mode = Mode::Invalid;
+        return;
+    }
+    if ((op == Operator_Div || op == Operator_Rem) && (x.mode == Mode::Constant || IsInteger(x.type)) &&
+        y.mode == Mode::Constant && y.val.IsKnown() && y.val.Sign() == 0) {
+        error(rhs, "invalid operation: division by zero");
+        x.mode = Mode::Invalid;
+        return;
+    }
+    if (x.mode != Mode::Constant || y.mode != Mode::Constant) {
+        x.mode = Mode::Value;
+        return;
+    }
+
+    // a quotient of floating-point type is not truncated, even if both
+    // operands have integer values
+    if (op == Operator_Div && !IsInteger(x.type)) {
+        x.val = IsComplex(x.type) ? x.val.ToComplex() : x.val.ToFloat();
+    }
+    x.val = BinaryOp(x.val, op, y.val);
+    overflow(x, e != nullptr ? static_cast<ast::Node *>(e) : lhs, op, false);
+}
+
+void Context::shift(Operand &x, Operand &y, ast::Operation *e, syntax::Operator op) {
+    ast::Node *at = e != nullptr ? static_cast<ast::Node *>(e) : x.expr;
+    // the shift count must be a non-negative integer
+    if (IsUntyped(y.type)) {
+        if (!convertUntyped(y, KindUint) || y.Invalid()) {
+            if (!y.Invalid()) {
+                error(y.expr, fmt::format("invalid operation: shift count {} must be integer", describe(y)));
+            }
+            x.mode = Mode::Invalid;
+            return;
+        }
+        if (y.mode != Mode::Constant) {
+            updateType(y.expr, y.type);
+        }
+    } else if (!IsInteger(y.type)) {
+        error(y.expr, fmt::format("invalid operation: shift count {} must be integer", describe(y)));
+        x.mode = Mode::Invalid;
+        return;
+    }
+    if (y.mode == Mode::Constant && y.val.Sign() < 0) {
+        error(y.expr, fmt::format("invalid operation: negative shift count {}", describe(y)));
+        x.mode = Mode::Invalid;
+        return;
+    }
+
+    if (x.mode == Mode::Constant && IsUntyped(x.type)) {
+        if (x.type != KindUntypedInt && x.type != KindUntypedRune) {
+            // an untyped constant with an integer value may be shifted
+            auto v = x.val.ToInt();
+            if (x.val.IsKnown() && !v.IsKnown()) {
+                error(at, fmt::format("invalid operation: shifted operand {} must be integer", describe(x)));
+                x.mode = Mode::Invalid;
+                return;
+            }
+            if (y.mode == Mode::Constant) {
+                x.type = KindUntypedInt;
+                x.val = v;
+            }
+        }
+        if (y.mode != Mode::Constant && e != nullptr) {
+            // a non-constant shift of an untyped constant stays untyped:
+            // it takes the type the context gives it, which must be an
+            // integer type
+            delayed_shifts.insert(e);
+            x.mode = Mode::Value;
+            x.val = Value{};
+            return;
+        }
+    }
+    if (!IsInteger(x.type)) {
+        error(at, fmt::format("invalid operation: shifted operand {} must be integer", describe(x)));
+        x.mode = Mode::Invalid;
+        return;
+    }
+    if (x.mode != Mode::Constant || y.mode != Mode::Constant) {
+        x.mode = Mode::Value;
+        return;
+    }
+    // shiftBound allows the smallest float64 to be written as 1 >> shiftBound
+    constexpr uint64_t shiftBound = 1023 - 1 + 52;
+    auto count = y.val.ToInt().Uint64Val();
+    if (y.val.IsKnown() && (!count || *count > shiftBound)) {
+        error(y.expr, fmt::format("invalid operation: invalid shift count {}", describe(y)));
+        x.mode = Mode::Invalid;
+        return;
+    }
+    x.val = Shift(x.val, op, count.value_or(0));
+    overflow(x, at, op, false);
+}
+
+// overflow checks the constant result of an operation at. A typed constant
+// must be representable in its type and is rounded to it; an untyped integer
+// constant may not grow beyond 512 bits.
+void Context::overflow(Operand &x, ast::Node *at, syntax::Operator op, bool unary) {
+    if (!x.val.IsKnown()) {
+        return;
+    }
+    if (!IsUntyped(x.type)) {
+        Value rounded;
+        if (!representable(x.val, x.type, rounded)) {
+            error(at, fmt::format("constant {} overflows {}", x.val.String(), table.String(x.type)));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        x.val = std::move(rounded);
+        return;
+    }
+    constexpr int64_t prec = 512;
+    if (x.val.Kind() == ConstKind::Int && x.val.BitLen() > prec) {
+        error(at, fmt::format("constant {}overflow", opName(op, unary)));
+        x.val = Value{};
+    }
+}
+
+void Context::comparison(Operand &x, Operand &y, syntax::Operator op) {
+    auto e = x.expr;
+    std::string cause;
+    bool ok = true;
+    if (x.type == KindUntypedNil || y.type == KindUntypedNil) {
+        // comparison with nil
+        auto other = x.type == KindUntypedNil ? y.type : x.type;
+        ok = (op == Operator_Eql || op == Operator_Neq) && HasNil(other);
+        if (!ok && other == KindUntypedNil) {
+            cause = fmt::format("operator {} not defined on nil", syntax::OperatorString(op));
+        } else if (!ok) {
+            cause = fmt::format("mismatched types {} and {}", table.String(x.type), table.String(y.type));
+        }
+    } else if (x.type != y.type) {
+        ok = false;
+        cause = fmt::format("mismatched types {} and {}", table.String(x.type), table.String(y.type));
+    } else if (op == Operator_Eql || op == Operator_Neq) {
+        if (!Comparable(x.type)) {
+            ok = false;
+            auto k = table.Kind(under(x.type));
+            if (k == KindSlice || k == KindMap || k == KindFunc) {
+                cause = fmt::format("{} can only be compared to nil",
+                                    k == KindSlice ? "slice" : k == KindMap ? "map" : "func");
+            } else {
+                cause = fmt::format("operator {} not defined on {}", syntax::OperatorString(op), describe(x));
+            }
+        }
+    } else if (!Ordered(x.type)) {
+        ok = false;
+        cause = fmt::format("operator {} not defined on {}", syntax::OperatorString(op), describe(x));
+    }
+    if (!ok) {
+        errorf(e->pos, fmt::format("invalid operation: {} {} {} ({})", ast::String(x.expr), syntax::OperatorString(op),
+                                   ast::String(y.expr), cause));
+        x.mode = Mode::Invalid;
+        return;
+    }
+    if (x.mode == Mode::Constant && y.mode == Mode::Constant) {
+        bool known = x.val.IsKnown() && y.val.IsKnown();
+        x.val = known ? Value::MakeBool(Compare(x.val, op, y.val)) : Value{};
+    } else {
+        x.mode = Mode::Value;
+        // untyped operands that are not constants assume their default
+        // type
+        if (IsUntyped(x.type)) {
+            x.type = y.type = DefaultType(x.type);
+        }
+    }
+    // the operands keep their types; the result is an untyped boolean
+    updateType(x.expr, x.type);
+    updateType(y.expr, y.type);
+    x.type = KindUntypedBool;
+}
+
+// ----------------------------------------------------------------------------
+// Untyped operands and assignability
+
+// matchTypes converts an untyped operand to the type of the other operand
+// of a binary operation, or two untyped operands to the larger kind.
+void Context::matchTypes(Operand &x, Operand &y) {
+    bool ux = IsUntyped(x.type), uy = IsUntyped(y.type);
+    if (ux && uy) {
+        if (rank(x.type) > 0 && rank(y.type) > 0) {
+            auto t = rank(x.type) > rank(y.type) ? x.type : y.type;
+            x.type = y.type = t;
+        }
+        return;
+    }
+    if (ux && x.type != KindUntypedNil) {
+        if (convertUntyped(x, y.type) && !x.Invalid()) {
+            updateType(x.expr, x.type);
+        }
+    } else if (uy && y.type != KindUntypedNil) {
+        if (convertUntyped(y, x.type) && !y.Invalid()) {
+            updateType(y.expr, y.type);
+        }
+    }
+}
+
+// convertUntyped gives the untyped operand x the type target, if the value
+// of x can be represented in it. It returns false if it cannot; it reports
+// a constant that overflows target and invalidates x.
+bool Context::convertUntyped(Operand &x, TypeId target) {
+    if (!IsUntyped(x.type) || target == 0) {
+        return true;
+    }
+    if (IsUntyped(target)) {
+        if (rank(x.type) > 0 && rank(target) > 0) {
+            x.type = rank(x.type) > rank(target) ? x.type : target;
+            return true;
+        }
+        return x.type == target;
+    }
+    if (table.Kind(target) == KindTypeParam) {
+        // the value must suit every type of the type set; it is no longer
+        // a constant
+        auto terms = table[table.Underlying(table[target].Elem())].Terms();
+        if (terms.empty()) {
+            return false;
+        }
+        for (auto term : terms) {
+            Operand y = x;
+            if (!convertUntyped(y, table.Underlying(TermType(term)))) {
+                return false;
+            }
+            if (y.Invalid()) {
+                x.mode = Mode::Invalid;
+                return true;
+            }
+        }
+        if (x.mode == Mode::Constant) {
+            x.mode = Mode::Value;
+            x.val = Value{};
+        }
+        x.type = target;
+        return true;
+    }
+    auto u = under(target);
+    if (table.Kind(u) == KindInterface) {
+        // untyped values are boxed with their default type
+        if (x.type == KindUntypedNil) {
+            x.type = target;
+            return true;
+        }
+        if (!table[u].Names.empty()) {
+            return false; // a basic type implements no methods
+        }
+        x.type = DefaultType(x.type);
+        return true;
+    }
+    bool ok;
+    switch (x.type) {
+    case KindUntypedBool:
+        ok = IsBoolean(u);
+        break;
+    case KindUntypedInt:
+    case KindUntypedRune:
+    case KindUntypedFloat:
+    case KindUntypedComplex:
+        // whether the value fits is checked below
+        ok = IsNumeric(u);
+        break;
+    case KindUntypedString:
+        ok = IsString(u);
+        break;
+    case KindUntypedNil:
+        ok = HasNil(u);
+        break;
+    default:
+        ok = false;
+        break;
+    }
+    if (!ok) {
+        return false;
+    }
+    if (x.mode == Mode::Constant && x.val.IsKnown()) {
+        Value rounded;
+        if (!representable(x.val, u, rounded)) {
+            error(x.expr, fmt::format("cannot use {} ({} constant {}) as {} value ({})", ast::String(x.expr),
+                                      table.String(x.type), x.val.String(), table.String(target),
+                                      truncated(x.val, u) ? "truncated" : "overflows"));
+            x.mode = Mode::Invalid;
+            return true;
+        }
+        x.val = std::move(rounded);
+    }
+    x.type = target;
+    return true;
+}
+
+// assignable reports whether a value x can be assigned to a variable of
+// type t.
+bool Context::assignable(const Operand &x, TypeId t) {
+    auto v = x.type;
+    if (v == t) {
+        return true;
+    }
+    if (table.Kind(v) == KindTypeParam || table.Kind(t) == KindTypeParam) {
+        // a type parameter stands for a type of its own: its values are
+        // only assignable to interfaces it implements
+        return table.Kind(t) != KindTypeParam && table.Kind(under(t)) == KindInterface &&
+               MissingMethod(check, v, t) == 0;
+    }
+    auto vu = table.Underlying(v), tu = under(t);
+    auto named = [&](TypeId typ) { return table.Kind(typ) < KindArray || table.Kind(typ) == KindNamed; };
+    // identical underlying types and at least one is not a named type
+    if (vu == tu && (!named(v) || !named(t))) {
+        return true;
+    }
+    if (table.Kind(tu) == KindInterface) {
+        return MissingMethod(check, v, t) == 0;
+    }
+    // a bidirectional channel is assignable to a directional one
+    if (table.Kind(vu) == KindChan && table.Kind(tu) == KindChan && table[vu].Len == ChanBoth &&
+        table[vu].Elem() == table[tu].Elem() && (!named(v) || !named(t))) {
+        return true;
+    }
+    return false;
+}
+
+// assignment checks that x can be assigned to a variable of type t in the
+// given context, converting untyped values. If t is 0, untyped values get
+// their default type.
+void Context::assignment(Operand &x, TypeId t, std::string_view context) {
+    if (x.Invalid()) {
+        return;
+    }
+    if (IsUntyped(x.type)) {
+        auto target = t;
+        if (t == 0) {
+            if (x.type == KindUntypedNil) {
+                error(x.expr, fmt::format("use of untyped nil in {}", context));
+                x.mode = Mode::Invalid;
+                return;
+            }
+            target = DefaultType(x.type);
+        }
+        if (!convertUntyped(x, target)) {
+            error(x.expr, fmt::format("cannot use {} as {} value in {}", describe(x), table.String(t), context));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        if (x.Invalid()) {
+            return;
+        }
+        updateType(x.expr, x.type);
+    }
+    if (t == 0 || assignable(x, t)) {
+        return;
+    }
+    auto msg = fmt::format("cannot use {} as {} value in {}", describe(x), table.String(t), context);
+    if (IsInterface(t) && !IsInterface(x.type) && x.type != 0) {
+        if (auto m = MissingMethod(check, x.type, t)) {
+            msg += fmt::format(": {} does not implement {} (missing method {})", table.String(x.type),
+                               table.String(t), nameOf(m));
+        }
+    }
+    error(x.expr, std::move(msg));
+    x.mode = Mode::Invalid;
+}
+
+// ----------------------------------------------------------------------------
+// Calls
+
+void Context::call(Operand &x, ast::CallExpr *e) {
+    rawExpr(x, e->Fun.get(), 0);
+    switch (x.mode) {
+    case Mode::Invalid:
+        useExprs(e->ArgList);
+        return;
+    case Mode::TypeExpr: {
+        auto t = x.type;
+        if (e->ArgList.size() != 1 || e->HasDots) {
+            error(e, fmt::format("{} arguments in conversion to {}", e->ArgList.empty() ? "missing" : "too many",
+                                 table.String(t)));
+            useExprs(e->ArgList);
+            x.mode = Mode::Invalid;
+            return;
+        }
+        expr(x, e->ArgList[0].get(), t);
+        conversion(x, t);
+        return;
+    }
+    case Mode::Builtin:
+        builtin(x, e, x.builtin);
+        return;
+    default:
+        break;
+    }
+    auto u = under(x.type);
+    if (table.Kind(u) != KindFunc) {
+        error(e, fmt::format("invalid operation: cannot call non-function {}", describe(x)));
+        useExprs(e->ArgList);
+        x.mode = Mode::Invalid;
+        return;
+    }
+    // the type arguments of a generic function are inferred from the
+    // arguments, which are checked against the instantiated signature
+    auto xs = argumentValues(e, x.generic != nullptr ? 0 : u);
+    if (x.generic != nullptr) {
+        std::vector<TypeId> targs(x.targs.begin(), x.targs.end());
+        if (!infer(e, x, xs, targs)) {
+            x.mode = Mode::Invalid;
+            return;
+        }
+        instantiate(x, e->Fun.get(), std::move(targs));
+        if (x.Invalid()) {
+            return;
+        }
+        u = x.type;
+    }
+    arguments(e, u, xs);
+    auto results = table[u].Results();
+    x.tuple = {};
+    if (results.empty()) {
+        x.mode = Mode::NoValue;
+        x.type = 0;
+    } else if (results.size() == 1) {
+        x.mode = Mode::Value;
+        x.type = results[0];
+    } else {
+        x.mode = Mode::Value;
+        x.type = 0;
+        x.tuple = results;
+    }
+}
+
+// argumentValues checks the arguments of a call of a function with
+// signature sig, or of a generic function if sig is 0, and returns their
+// values: those of a single call with several results f(g()), one by one.
+std::vector<Operand> Context::argumentValues(ast::CallExpr *e, TypeId sig) {
+    auto &args = e->ArgList;
+    auto params = sig == 0 ? std::span<const TypeId>() : table[sig].Params();
+    std::vector<Operand> xs;
+    if (args.size() == 1 && !e->HasDots) {
+        // f(g()) with a multi-value g
+        Operand x;
+        multiExpr(x, args[0].get(), params.empty() ? 0 : params[0]);
+        if (x.tuple.size() > 1) {
+            for (auto r : x.tuple) {
+                Operand y = x;
+                y.tuple = {};
+                y.type = r;
+                xs.push_back(y);
+            }
+        } else {
+            xs.push_back(x);
+        }
+    } else {
+        for (size_t i = 0; i < args.size(); i++) {
+            Operand x;
+            auto hint = i < params.size() ? params[i] : 0;
+            expr(x, args[i].get(), hint);
+            xs.push_back(x);
+        }
+    }
+    return xs;
+}
+
+// arguments checks the argument values xs of a call of a function with
+// signature sig.
+void Context::arguments(ast::CallExpr *e, TypeId sig, std::vector<Operand> &xs) {
+    auto &t = table[sig];
+    auto params = t.Params();
+    auto &args = e->ArgList;
+    auto name = ast::String(e->Fun.get());
+    if (e->HasDots && !t.Variadic) {
+        error(args.back().get(), fmt::format("have (...) but function is not variadic: {}", name));
+        return;
+    }
+    size_t n = xs.size(), want = params.size();
+    bool ok = t.Variadic && !e->HasDots ? n >= want - 1 : n == want;
+    if (!ok) {
+        if (n < want) {
+            errorf(e->pos, fmt::format("not enough arguments in call to {}", name));
+        } else {
+            error(args[std::min(want, args.size() - 1)].get(), fmt::format("too many arguments in call to {}", name));
+        }
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        auto p = i < want ? params[i] : params.back();
+        if (t.Variadic && !e->HasDots && i >= want - 1) {
+            p = table[p].Elem(); // ...T
+        }
+        assignment(xs[i], p, fmt::format("argument to {}", name));
+    }
+}
+
+// convertibleTo reports whether a non-constant value of type v converts to
+// type t, beyond assignability. A conversion from or to a type parameter
+// must be valid for all the types of its type set.
+bool Context::convertibleTo(TypeId v, TypeId t) {
+    for (auto typ : {v, t}) {
+        if (table.Kind(typ) != KindTypeParam) {
+            continue;
+        }
+        auto terms = table[table.Underlying(table[typ].Elem())].Terms();
+        return !terms.empty() && std::all_of(terms.begin(), terms.end(), [&](TypeId term) {
+            return typ == v ? convertibleTo(TermType(term), t) : convertibleTo(v, TermType(term));
+        });
+    }
+    auto vu = table.Underlying(v), tu = under(t);
+    if (vu == tu) {
+        return true;
+    }
+    if (table.Kind(vu) == KindPointer && table.Kind(tu) == KindPointer &&
+        table.Underlying(table[vu].Elem()) == table.Underlying(table[tu].Elem())) {
+        return true;
+    }
+    if ((IsNumeric(vu) && IsNumeric(tu)) || (IsInteger(vu) && IsString(tu))) {
+        return true;
+    }
+    // string <-> []byte and []rune
+    if (IsString(vu) && table.Kind(tu) == KindSlice) {
+        auto elem = table.Underlying(table[tu].Elem());
+        return elem == KindUint8 || elem == KindInt32;
+    }
+    if (IsString(tu) && table.Kind(vu) == KindSlice) {
+        auto elem = table.Underlying(table[vu].Elem());
+        return elem == KindUint8 || elem == KindInt32;
+    }
+    // slice to array or array pointer
+    if (table.Kind(vu) == KindSlice) {
+        auto a = table.Kind(tu) == KindPointer ? table.Underlying(table[tu].Elem()) : tu;
+        return table.Kind(a) == KindArray && table[a].Elem() == table[vu].Elem();
+    }
+    // a value converts to an interface it implements, also inside the type
+    // set of a type parameter
+    return table.Kind(tu) == KindInterface && MissingMethod(check, v, t) == 0;
+}
+
+void Context::conversion(Operand &x, TypeId t) {
+    if (x.Invalid()) {
+        return;
+    }
+    auto tu = under(t);
+    bool constArg = x.mode == Mode::Constant;
+    bool ok;
+    if (constArg && IsConstType(t)) {
+        // a constant converts to a constant of a basic type if its value is
+        // representable in it, or from an integer to a string
+        if (IsInteger(x.type) && IsString(tu)) {
+            ok = true;
+            if (x.val.IsKnown()) {
+                std::string str;
+                auto r = x.val.ToInt().Int64Val();
+                appendRune(str, r.value_or(-1));
+                x.val = Value::MakeString(std::move(str));
+            }
+        } else {
+            ok = (IsNumeric(x.type) && IsNumeric(tu)) || (IsString(x.type) && IsString(tu)) ||
+                 (IsBoolean(x.type) && IsBoolean(tu));
+            Value rounded;
+            if (ok && x.val.IsKnown() && !representable(x.val, tu, rounded)) {
+                error(x.expr, fmt::format("cannot convert {} to type {} ({})", describe(x), table.String(t),
+                                          truncated(x.val, tu) ? "truncated" : "overflows"));
+                x.mode = Mode::Invalid;
+                return;
+            }
+            if (ok && x.val.IsKnown()) {
+                x.val = std::move(rounded);
+            }
+        }
+        if (ok) {
+            if (IsUntyped(x.type)) {
+                updateType(x.expr, t);
+            }
+            x.type = t;
+            return;
+        }
+    } else {
+        if (IsUntyped(x.type)) {
+            // an untyped value that is not a constant, such as a delayed
+            // shift, takes the type it is converted to, unless that is an
+            // interface
+            Operand y = x;
+            if (!constArg && x.type != KindUntypedNil && table.Kind(t) != KindTypeParam &&
+                table.Kind(tu) != KindInterface && convertUntyped(y, t) && !y.Invalid()) {
+                x.type = y.type;
+                updateType(x.expr, x.type);
+            } else {
+                assignment(x, x.type == KindUntypedNil ? t : 0, "conversion");
+            }
+            if (x.Invalid()) {
+                return;
+            }
+        }
+        ok = assignable(x, t) || convertibleTo(x.type, t);
+    }
+    if (!ok) {
+        error(x.expr, fmt::format("cannot convert {} to type {}", describe(x), table.String(t)));
+        x.mode = Mode::Invalid;
+        return;
+    }
+    x.mode = Mode::Value;
+    x.type = t;
+}
+
+void Context::builtin(Operand &x, ast::CallExpr *e, BuiltinId id) {
+    auto name = ast::String(e->Fun.get());
+    auto &args = e->ArgList;
+    auto nargs = [&](size_t min, size_t max) {
+        if (args.size() < min) {
+            errorf(e->pos, fmt::format("not enough arguments for {}() (expected {}, found {})", name, min,
+                                       args.size()));
+        } else if (args.size() > max) {
+            error(args[max].get(), fmt::format("too many arguments for {}() (expected {}, found {})", name, max,
+                                               args.size()));
+        } else {
+            return true;
+        }
+        useExprs(args);
+        x.mode = Mode::Invalid;
+        return false;
+    };
+    if (e->HasDots && id != BuiltinId::Append) {
+        error(e, fmt::format("invalid operation: invalid use of ... with built-in {}", name));
+        useExprs(args);
+        x.mode = Mode::Invalid;
+        return;
+    }
+    auto arg = [&](Operand &y, size_t i, TypeId hint = 0) {
+        expr(y, args[i].get(), hint);
+        return !y.Invalid();
+    };
+    auto invalidArg = [&](const Operand &y) {
+        error(y.expr, fmt::format("invalid argument: {} for built-in {}", describe(y), name));
+        x.mode = Mode::Invalid;
+    };
+    x.mode = Mode::Value;
+    x.val = Value{};
+    switch (id) {
+    case BuiltinId::Len:
+    case BuiltinId::Cap: {
+        if (!nargs(1, 1)) {
+            return;
+        }
+        Operand y;
+        if (!arg(y, 0)) {
+            x.mode = Mode::Invalid;
+            return;
+        }
+        auto t = under(y.type);
+        if (table.Kind(t) == KindPointer && table.Kind(under(table[t].Elem())) == KindArray) {
+            t = under(table[t].Elem());
+        }
+        auto k = table.Kind(t);
+        bool ok = k == KindArray || k == KindSlice || k == KindChan ||
+                  (id == BuiltinId::Len && (k == KindMap || IsString(t)));
+        if (!ok) {
+            invalidArg(y);
+            return;
+        }
+        x.type = KindInt;
+        if (k == KindArray) {
+            x.mode = Mode::Constant;
+            x.val = Value::MakeInt64(int64_t(table[t].Len));
+        } else if (y.mode == Mode::Constant) {
+            // the length of a constant string
+            x.mode = Mode::Constant;
+            x.val = y.val.IsKnown() ? Value::MakeInt64(int64_t(y.val.StringVal().size())) : Value{};
+        }
+        return;
+    }
+    case BuiltinId::Append: {
+        if (!nargs(1, std::numeric_limits<size_t>::max())) {
+            return;
+        }
+        Operand s;
+        if (!arg(s, 0)) {
+            useExprs(std::span(args).subspan(1));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        if (s.type == KindUntypedNil) {
+            error(s.expr, "first argument to append must be a typed slice; have untyped nil");
+            useExprs(std::span(args).subspan(1));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        auto u = under(s.type);
+        if (table.Kind(u) != KindSlice) {
+            error(s.expr, fmt::format("invalid argument: {} (not a slice)", describe(s)));
+            useExprs(std::span(args).subspan(1));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        auto elem = table[u].Elem();
+        if (e->HasDots) {
+            if (args.size() != 2) {
+                error(e, "can only use ... with final argument in list");
+                useExprs(std::span(args).subspan(1));
+                x.mode = Mode::Invalid;
+                return;
+            }
+            Operand y;
+            if (arg(y, 1, s.type)) {
+                // append([]byte, string...)
+                if (!(table.Underlying(elem) == KindUint8 && IsString(y.type))) {
+                    assignment(y, table.Slice(elem), fmt::format("argument to {}", name));
+                }
+            }
+        } else {
+            for (size_t i = 1; i < args.size(); i++) {
+                Operand y;
+                if (arg(y, i, elem)) {
+                    assignment(y, elem, fmt::format("argument to {}", name));
+                }
+            }
+        }
+        x.type = s.type;
+        return;
+    }
+    case BuiltinId::Make: {
+        if (args.empty()) {
+            nargs(1, 3);
+            return;
+        }
+        auto t = typExpr(args[0].get());
+        if (t == 0) {
+            useExprs(std::span(args).subspan(1));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        size_t min;
+        switch (table.Kind(under(t))) {
+        case KindSlice:
+            min = 2;
+            break;
+        case KindMap:
+        case KindChan:
+            min = 1;
+            break;
+        default:
+            error(args[0].get(), fmt::format("invalid argument: cannot make {}; type must be slice, map, or channel",
+                                             ast::String(args[0].get())));
+            useExprs(std::span(args).subspan(1));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        if (args.size() < min || args.size() > min + 1) {
+            error(e, fmt::format("invalid operation: {} expects {} or {} arguments; found {}", ast::String(e), min,
+                                 min + 1, args.size()));
+            useExprs(std::span(args).subspan(1));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        int64_t sizes[2] = {-1, -1};
+        for (size_t i = 1; i < args.size(); i++) {
+            indexValue(args[i].get(), -1, sizes[i - 1]);
+        }
+        if (sizes[0] >= 0 && sizes[1] >= 0 && sizes[0] > sizes[1]) {
+            error(args[1].get(), fmt::format("invalid argument: length and capacity swapped"));
+        }
+        x.type = t;
+        return;
+    }
+    case BuiltinId::New: {
+        if (!nargs(1, 1)) {
+            return;
+        }
+        auto t = typExpr(args[0].get());
+        if (t == 0) {
+            x.mode = Mode::Invalid;
+            return;
+        }
+        x.type = table.Pointer(t);
+        return;
+    }
+    case BuiltinId::Delete: {
+        if (!nargs(2, 2)) {
+            return;
+        }
+        Operand m, k;
+        if (!arg(m, 0)) {
+            useExprs(std::span(args).subspan(1));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        auto u = under(m.type);
+        if (table.Kind(u) != KindMap) {
+            error(m.expr, fmt::format("invalid argument: {} is not a map", describe(m)));
+            useExprs(std::span(args).subspan(1));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        if (arg(k, 1, table[u].Key())) {
+            assignment(k, table[u].Key(), fmt::format("argument to {}", name));
+        }
+        x.mode = Mode::NoValue;
+        return;
+    }
+    case BuiltinId::Copy: {
+        if (!nargs(2, 2)) {
+            return;
+        }
+        Operand dst, src;
+        bool ok = arg(dst, 0);
+        ok = arg(src, 1) && ok;
+        if (!ok) {
+            x.mode = Mode::Invalid;
+            return;
+        }
+        auto du = under(dst.type), su = under(src.type);
+        if (table.Kind(du) != KindSlice) {
+            invalidArg(dst);
+            return;
+        }
+        bool str = IsString(su) && table.Underlying(table[du].Elem()) == KindUint8;
+        if (!str && (table.Kind(su) != KindSlice || table[su].Elem() != table[du].Elem())) {
+            error(e, fmt::format("invalid argument: arguments to copy {} and {} have different element types",
+                                 describe(dst), describe(src)));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        x.type = KindInt;
+        return;
+    }
+    case BuiltinId::Close: {
+        if (!nargs(1, 1)) {
+            return;
+        }
+        Operand c;
+        if (!arg(c, 0)) {
+            x.mode = Mode::Invalid;
+            return;
+        }
+        auto u = under(c.type);
+        if (table.Kind(u) != KindChan) {
+            error(c.expr, fmt::format("invalid operation: cannot close non-channel {}", describe(c)));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        if (table[u].Len == RecvOnly) {
+            error(c.expr, fmt::format("invalid operation: cannot close receive-only channel {}", describe(c)));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        x.mode = Mode::NoValue;
+        return;
+    }
+    case BuiltinId::Clear: {
+        if (!nargs(1, 1)) {
+            return;
+        }
+        Operand c;
+        if (!arg(c, 0)) {
+            x.mode = Mode::Invalid;
+            return;
+        }
+        auto k = table.Kind(under(c.type));
+        if (k != KindMap && k != KindSlice) {
+            error(c.expr, fmt::format("invalid argument: {} must be a map or slice", describe(c)));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        x.mode = Mode::NoValue;
+        return;
+    }
+    case BuiltinId::Panic: {
+        if (!nargs(1, 1)) {
+            return;
+        }
+        Operand y;
+        if (arg(y, 0)) {
+            assignment(y, Universe().Lookup(common::Interner::Global().Intern("any"))->Type,
+                       fmt::format("argument to {}", name));
+        }
+        panics.insert(e);
+        x.mode = Mode::NoValue;
+        return;
+    }
+    case BuiltinId::Print:
+    case BuiltinId::Println: {
+        for (size_t i = 0; i < args.size(); i++) {
+            Operand y;
+            if (arg(y, i)) {
+                assignment(y, 0, fmt::format("argument to {}", name));
+            }
+        }
+        x.mode = Mode::NoValue;
+        return;
+    }
+    case BuiltinId::Recover:
+        if (!nargs(0, 0)) {
+            return;
+        }
+        x.type = Universe().Lookup(common::Interner::Global().Intern("any"))->Type;
+        return;
+    case BuiltinId::Complex: {
+        if (!nargs(2, 2)) {
+            return;
+        }
+        Operand re, im;
+        bool ok = arg(re, 0);
+        ok = arg(im, 1) && ok;
+        if (!ok) {
+            x.mode = Mode::Invalid;
+            return;
+        }
+        matchTypes(re, im);
+        if (re.Invalid() || im.Invalid()) {
+            x.mode = Mode::Invalid;
+            return;
+        }
+        if (re.type != im.type || !(IsFloat(re.type) || IsInteger(re.type))) {
+            error(e, fmt::format("invalid operation: complex({}, {}) (mismatched types {} and {})",
+                                 ast::String(re.expr), ast::String(im.expr), table.String(re.type),
+                                 table.String(im.type)));
+            x.mode = Mode::Invalid;
+            return;
+        }
+        auto u = table.Underlying(re.type);
+        x.type = IsUntyped(u) ? KindUntypedComplex : u == KindFloat32 ? KindComplex64 : KindComplex128;
+        if (re.mode == Mode::Constant && im.mode == Mode::Constant) {
+            x.mode = Mode::Constant;
+            x.val = Value::MakeComplex(re.val, im.val);
+            overflow(x, e, Operator_Add, false);
+        }
+        return;
+    }
+    case BuiltinId::Real:
+    case BuiltinId::Imag: {
+        if (!nargs(1, 1)) {
+            return;
+        }
+        Operand c;
+        if (!arg(c, 0)) {
+            x.mode = Mode::Invalid;
+            return;
+        }
+        if (!IsNumeric(c.type)) {
+            invalidArg(c);
+            return;
+        }
+        auto u = table.Underlying(c.type);
+        x.type = IsUntyped(u) ? KindUntypedFloat : u == KindComplex64 ? KindFloat32 : KindFloat64;
+        if (c.mode == Mode::Constant) {
+            x.mode = Mode::Constant;
+            auto v = c.val.ToComplex();
+            x.val = id == BuiltinId::Real ? v.Real() : v.Imag();
+        }
+        return;
+    }
+    case BuiltinId::Max:
+    case BuiltinId::Min: {
+        if (!nargs(1, std::numeric_limits<size_t>::max())) {
+            return;
+        }
+        if (!arg(x, 0)) {
+            useExprs(std::span(args).subspan(1));
+            return;
+        }
+        for (size_t i = 1; i < args.size(); i++) {
+            Operand y;
+            if (!arg(y, i)) {
+                x.mode = Mode::Invalid;
+                continue;
+            }
+            if (x.Invalid()) {
+                continue;
+            }
+            matchTypes(x, y);
+            if (x.Invalid() || y.Invalid()) {
+                x.mode = Mode::Invalid;
+                continue;
+            }
+            if (x.type != y.type) {
+                error(y.expr, fmt::format("invalid argument: mismatched types {} (previous argument) and {} (type "
+                                          "of {})",
+                                          table.String(x.type), table.String(y.type), ast::String(y.expr)));
+                x.mode = Mode::Invalid;
+                continue;
+            }
+            if (x.mode == Mode::Constant && y.mode == Mode::Constant) {
+                if (!x.val.IsKnown() || !y.val.IsKnown()) {
+                    x.val = Value{};
+                } else if (Compare(y.val, id == BuiltinId::Max ? Operator_Gtr : Operator_Lss, x.val)) {
+                    x.val = y.val;
+                }
+            } else {
+                x.mode = Mode::Value;
+            }
+        }
+        if (!x.Invalid() && !Ordered(x.type)) {
+            invalidArg(x);
+        }
+        return;
+    }
+    }
+}
+
+} // namespace types
@@ -0,0 +1,387 @@
+#include <algorithm>
+
+#include <fmt/format.h>
+
+#include "syntax/types/check.hh"
+
+namespace types {
+
+using Context = Checker::Context;
+
+namespace {
+
+std::string_view nameOf(common::SymbolId sym) { return common::Interner::Global().Name(sym); }
+
+// funcName returns the name of the function F, pkg.F or (F) denotes, or nil.
+const ast::Name *funcName(ast::ExprNode *e) {
+    while (auto p = dyn_cast_or_null<ast::ParenExpr>(e)) {
+        e = p->X.get();
+    }
+    if (auto s = dyn_cast_or_null<ast::SelectorExpr>(e)) {
+        return s->Sel.get();
+    }
+    return dyn_cast_or_null<ast::Name>(e);
+}
+
+// paramIndex returns the index of t in the type parameters tparams, or -1.
+int paramIndex(TypeId t, std::span<const TypeId> tparams) {
+    auto it = std::find(tparams.begin(), tparams.end(), t);
+    return it == tparams.end() ? -1 : int(it - tparams.begin());
+}
+
+// mentions reports whether t refers to one of the type parameters params.
+bool mentions(TypeId t, std::span<const TypeId> params) {
+    auto &table = TypeTable::Global();
+    if (paramIndex(t, params) >= 0) {
+        return true;
+    }
+    if (table.Kind(t) < KindArray || table.Kind(t) == KindNamed || table.Kind(t) == KindTypeParam) {
+        return false;
+    }
+    auto elems = table[t].Elems;
+    return std::any_of(elems.begin(), elems.end(), [&](TypeId e) { return mentions(TermType(e), params); });
+}
+
+// unifier infers type arguments by matching the types of parameters, which
+// refer to the type parameters, with the types of the arguments.
+struct unifier {
+    TypeTable &table;
+    std::span<const TypeId> tparams;
+    std::vector<TypeId> &targs;
+
+    // unify reports whether x can be made identical to y by inferring the
+    // type parameters in x. The matching is inexact: a type literal in x
+    // matches a named type y with that underlying type, and a type
+    // parameter inferred as a type literal becomes the named type.
+    bool unify(TypeId x, TypeId y) {
+        if (auto i = paramIndex(x, tparams); i >= 0) {
+            auto &t = targs[size_t(i)];
+            if (t == 0 || t == y) {
+                t = y;
+                return true;
+            }
+            if (table.Underlying(t) != table.Underlying(y) ||
+                (table.Kind(t) == KindNamed && table.Kind(y) == KindNamed)) {
+                return false;
+            }
+            if (table.Kind(y) == KindNamed) {
+                t = y;
+            }
+            return true;
+        }
+        if (x == y) {
+            return true;
+        }
+        auto &a = table[x];
+        auto &b = table[y];
+        if (a.Kind != b.Kind) {
+            return a.Kind != KindNamed && b.Kind == KindNamed && unify(x, b.Underlying);
+        }
+        if (a.Kind < KindArray || a.Kind == KindNamed || a.Kind == KindTypeParam || a.Len != b.Len ||
+            a.Variadic != b.Variadic || a.Elems.size() != b.Elems.size() ||
+            !std::equal(a.Names.begin(), a.Names.end(), b.Names.begin(), b.Names.end())) {
+            return false;
+        }
+        for (size_t i = 0; i < a.Elems.size(); i++) {
+            if ((a.Elems[i] & TildeTerm) != (b.Elems[i] & TildeTerm) ||
+                !unify(TermType(a.Elems[i]), TermType(b.Elems[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+// typeParams declares the type parameters of the generic function fn in the
+// current scope, then checks their constraints, which may refer to any of
+// them.
+void Context::typeParams(std::span<const ast::FieldPtr> list, Object *fn, DeclInfo &d) {
+    for (size_t i = 0; i < list.size(); i++) {
+        auto name = list[i]->Name.get();
+        auto obj = newObject(ObjKind::TypeName, name, table.NewTypeParam(name->Sym, int64(i)));
+        declare(obj, name);
+        d.TParams.push_back(obj);
+        fn->TParams.push_back(obj->Type);
+    }
+    ast::ExprNode *last = nullptr;
+    TypeId c = 0;
+    for (size_t i = 0; i < list.size(); i++) {
+        if (list[i]->Type.get() != last) {
+            last = list[i]->Type.get();
+            c = constraint(last);
+        }
+        table.SetConstraint(fn->TParams[i], c != 0 ? c : table.Interface({}, {}));
+    }
+}
+
+// coreType returns the underlying type shared by all the types of the type
+// set of the type parameter t, or t if there is none.
+TypeId Context::coreType(TypeId t) {
+    if (table[t].Elems.empty()) {
+        return t; // the constraint is being checked
+    }
+    TypeId core = 0;
+    for (auto term : table[table.Underlying(table[t].Elem())].Terms()) {
+        auto u = table.Underlying(TermType(term));
+        if (core != 0 && u != core) {
+            return t;
+        }
+        core = u;
+    }
+    return core != 0 ? core : t;
+}
+
+TypeId Subst(TypeId t, std::span<const TypeId> tparams, std::span<const TypeId> targs) {
+    auto &table = TypeTable::Global();
+    if (auto i = paramIndex(t, tparams); i >= 0) {
+        return targs[size_t(i)];
+    }
+    auto &typ = table[t];
+    if (typ.Kind < KindArray || typ.Kind == KindNamed || typ.Kind == KindTypeParam) {
+        return t;
+    }
+    std::vector<TypeId> elems;
+    bool changed = false;
+    for (auto e : typ.Elems) {
+        elems.push_back(Subst(TermType(e), tparams, targs) | (e & TildeTerm));
+        changed = changed || elems.back() != e;
+    }
+    if (!changed) {
+        return t;
+    }
+    std::span<const TypeId> list = elems;
+    switch (typ.Kind) {
+    case KindArray:
+        return table.Array(typ.Len, elems[0]);
+    case KindSlice:
+        return table.Slice(elems[0]);
+    case KindPointer:
+        return table.Pointer(elems[0]);
+    case KindMap:
+        return table.Map(elems[0], elems[1]);
+    case KindChan:
+        return table.Chan(uint32_t(typ.Len), elems[0]);
+    case KindFunc:
+        return table.Func(list.first(size_t(typ.Len)), list.subspan(size_t(typ.Len)), typ.Variadic);
+    case KindStruct:
+        return table.Struct(typ.Names, elems);
+    case KindInterface:
+        return table.Interface(typ.Names, list.first(typ.Names.size()), list.subspan(typ.Names.size()),
+                               typ.Variadic);
+    default:
+        return t;
+    }
+}
+
+// satisfies reports whether the type argument targ satisfies the constraint,
+// with the type parameters of the constraint substituted. If it does not,
+// cause may explain why.
+bool Context::satisfies(TypeId targ, TypeId constraint, std::string &cause) {
+    auto &c = table[table.Underlying(constraint)];
+    auto targString = table.String(targ);
+    if (c.Len > 0) {
+        auto terms = c.Terms();
+        auto in = [&](TypeId term) {
+            return std::any_of(terms.begin(), terms.end(), [&](TypeId t) { return TermSubset(term, t); });
+        };
+        bool ok;
+        if (table.Kind(targ) == KindTypeParam) {
+            // the type set of a type parameter must be included
+            auto own = table[table.Underlying(table[targ].Elem())].Terms();
+            ok = !own.empty() && std::all_of(own.begin(), own.end(), in);
+        } else {
+            ok = in(targ);
+        }
+        if (!ok) {
+            cause = fmt::format("{} missing in {}", targString, table.String(table.Interface({}, {}, terms)));
+            return false;
+        }
+    }
+    if (c.Variadic && !Comparable(targ)) {
+        static const auto comparable = Universe().LookupLocal(common::Interner::Global().Intern("comparable"));
+        if (constraint != comparable->Type) {
+            cause = fmt::format("{} is not comparable", targString);
+        }
+        return false;
+    }
+    if (auto m = MissingMethod(check, targ, constraint)) {
+        cause = fmt::format("missing method {}", nameOf(m));
+        return false;
+    }
+    return true;
+}
+
+// instantiate instantiates the generic function x with the type arguments
+// targs, which must satisfy the constraints, and records the instance.
+void Context::instantiate(Operand &x, ast::Node *at, std::vector<TypeId> targs) {
+    auto fn = x.generic;
+    std::span<const TypeId> tparams = fn->TParams;
+    for (size_t i = 0; i < tparams.size(); i++) {
+        auto c = Subst(table[tparams[i]].Elem(), tparams, targs);
+        std::string cause;
+        if (!satisfies(targs[i], c, cause)) {
+            error(at, fmt::format("{} does not satisfy {}{}", table.String(targs[i]), table.String(c),
+                                  cause.empty() ? "" : " (" + cause + ")"));
+            x.mode = Mode::Invalid;
+            return;
+        }
+    }
+    auto sig = Subst(fn->Type, tparams, targs);
+    if (auto name = funcName(x.expr)) {
+        instances.emplace_back(name, Instance{fn, std::move(targs), sig});
+    }
+    x.mode = Mode::Value;
+    x.type = sig;
+    x.generic = nullptr;
+    x.targs = {};
+    if (x.expr != nullptr) {
+        x.expr->SetType(sig);
+    }
+}
+
+// funcInst checks the instantiation F[A, B] of the generic function x with
+// explicit type arguments. With fewer type arguments than type parameters,
+// the rest are inferred from the arguments of a call.
+void Context::funcInst(Operand &x, ast::IndexExpr *e) {
+    std::vector<ast::ExprNode *> list;
+    if (auto l = dyn_cast<ast::ListExpr>(e->Index.get())) {
+        for (auto &a : l->ElemList) {
+            list.push_back(a.get());
+        }
+    } else {
+        list.push_back(e->Index.get());
+    }
+    std::vector<TypeId> targs;
+    for (auto a : list) {
+        targs.push_back(typExpr(a));
+    }
+    if (!x.targs.empty()) {
+        error(e, fmt::format("invalid operation: cannot index {}", describe(x)));
+        x.mode = Mode::Invalid;
+        return;
+    }
+    if (std::find(targs.begin(), targs.end(), 0) != targs.end()) {
+        x.mode = Mode::Invalid;
+        return;
+    }
+    auto n = x.generic->TParams.size();
+    if (targs.size() > n) {
+        error(list[n], fmt::format("got {} type arguments but {} has {} type parameters", targs.size(),
+                                   ast::String(e->X.get()), n));
+        x.mode = Mode::Invalid;
+        return;
+    }
+    if (targs.size() < n) {
+        x.targs = targ_lists.emplace_back(std::move(targs));
+        return;
+    }
+    instantiate(x, e, std::move(targs));
+}
+
+// infer infers the type arguments of a call of the generic function x that
+// are not given in targs: first from the typed arguments and the
+// constraints with a single term, such as ~[]E, then from the default
+// types of untyped constant arguments of a type parameter type, and the
+// constraints again.
+bool Context::infer(ast::CallExpr *e, const Operand &x, std::span<const Operand> args, std::vector<TypeId> &targs) {
+    std::span<const TypeId> tparams = x.generic->TParams;
+    targs.resize(tparams.size());
+    auto &sig = table[x.generic->Type];
+    auto params = sig.Params();
+    auto param = [&](size_t i) -> TypeId {
+        if (sig.Variadic && !e->HasDots && i + 1 >= params.size()) {
+            return table[params.back()].Elem();
+        }
+        return i < params.size() ? params[i] : 0;
+    };
+
+    unifier u{table, tparams, targs};
+    for (size_t i = 0; i < args.size(); i++) {
+        auto &a = args[i];
+        if (a.Invalid()) {
+            return false;
+        }
+        auto p = param(i);
+        if (p == 0 || IsUntyped(a.type)) {
+            continue;
+        }
+        if (!u.unify(p, a.type)) {
+            error(a.expr, fmt::format("type {} of {} does not match {}", table.String(a.type), ast::String(a.expr),
+                                      table.String(Subst(p, tparams, targs))));
+            return false;
+        }
+    }
+
+    // constraints with a single term give the type arguments in their core
+    // type and the other way round
+    auto core = [&] {
+        for (bool progress = true; progress;) {
+            progress = false;
+            for (size_t i = 0; i < tparams.size(); i++) {
+                auto terms = table[table.Underlying(table[tparams[i]].Elem())].Terms();
+                if (terms.size() != 1) {
+                    continue;
+                }
+                auto term = TermType(terms[0]);
+                std::vector<TypeId> unknown;
+                for (size_t j = 0; j < tparams.size(); j++) {
+                    if (targs[j] == 0) {
+                        unknown.push_back(tparams[j]);
+                    }
+                }
+                if (targs[i] == 0 && !mentions(term, unknown)) {
+                    targs[i] = Subst(term, tparams, targs);
+                    progress = true;
+                } else if (targs[i] != 0 && (terms[0] & TildeTerm) && mentions(term, unknown)) {
+                    // the type arguments in the core type follow from targs[i]
+                    if (!u.unify(term, table.Underlying(targs[i]))) {
+                        break; // reported by satisfies
+                    }
+                    progress = progress ||
+                               std::count(targs.begin(), targs.end(), 0) < std::ptrdiff_t(unknown.size());
+                }
+            }
+        }
+    };
+    core();
+
+    // untyped constants of the same type parameter take the largest kind,
+    // if they are all numeric
+    std::vector<TypeId> untyped(tparams.size());
+    auto numeric = [](TypeId t) { return t >= KindUntypedInt && t <= KindUntypedComplex; };
+    for (size_t i = 0; i < args.size(); i++) {
+        auto p = paramIndex(param(i), tparams);
+        auto t = args[i].type;
+        if (p < 0 || targs[size_t(p)] != 0 || !IsUntyped(t) || t == KindUntypedNil) {
+            continue;
+        }
+        auto &max = untyped[size_t(p)];
+        if (max != 0 && max != t && !(numeric(max) && numeric(t))) {
+            error(args[i].expr, fmt::format("default type {} of {} does not match inferred type {} for {}",
+                                            table.String(DefaultType(t)), ast::String(args[i].expr),
+                                            table.String(DefaultType(max)), table.String(tparams[size_t(p)])));
+            return false;
+        }
+        max = std::max(max, t);
+    }
+    for (size_t i = 0; i < tparams.size(); i++) {
+        if (targs[i] == 0 && untyped[i] != 0) {
+            targs[i] = DefaultType(untyped[i]);
+        }
+    }
+
+    core();
+
+    for (size_t i = 0; i < tparams.size(); i++) {
+        if (targs[i] == 0) {
+            error(e, fmt::format("in call to {}, cannot infer {}", ast::String(e->Fun.get()),
+                                 table.String(tparams[i])));
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace types
@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <unordered_set>
+
+#include "syntax/types/check.hh"
+
+namespace types {
+
+namespace {
+
+const Type &under(TypeId t) {
+    auto &table = TypeTable::Global();
+    return table[table.Underlying(t)];
+}
+
+// typeSet reports whether pred holds for t or, if t is a type parameter,
+// for all the types of its type set: it must be restricted by terms.
+template <typename P> bool typeSet(TypeId t, P pred) {
+    auto &table = TypeTable::Global();
+    if (table.Kind(t) != KindTypeParam) {
+        return pred(t);
+    }
+    if (table[t].Elems.empty()) {
+        return false; // the constraint is being checked
+    }
+    auto terms = under(table[t].Elem()).Terms();
+    return !terms.empty() && std::all_of(terms.begin(), terms.end(), [&](TypeId term) { return pred(TermType(term)); });
+}
+
+bool isOrdered(TypeId t) { return IsInteger(t) || IsFloat(t) || IsString(t); }
+
+bool hasNil(TypeId t) {
+    switch (under(t).Kind) {
+    case KindSlice:
+    case KindPointer:
+    case KindFunc:
+    case KindInterface:
+    case KindMap:
+    case KindChan:
+    case KindUnsafePointer:
+    case KindUntypedNil:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+bool IsUntyped(TypeId t) { return t >= KindUntypedBool && t <= KindUntypedNil; }
+
+bool IsBoolean(TypeId t) {
+    return typeSet(t, [](TypeId u) {
+        auto k = under(u).Kind;
+        return k == KindBool || k == KindUntypedBool;
+    });
+}
+
+bool IsInteger(TypeId t) {
+    return typeSet(t, [](TypeId u) {
+        auto k = under(u).Kind;
+        return (k >= KindInt && k <= KindUintptr) || k == KindUntypedInt || k == KindUntypedRune;
+    });
+}
+
+bool IsUnsigned(TypeId t) {
+    return typeSet(t, [](TypeId u) {
+        auto k = under(u).Kind;
+        return k >= KindUint && k <= KindUintptr;
+    });
+}
+
+bool IsFloat(TypeId t) {
+    return typeSet(t, [](TypeId u) {
+        auto k = under(u).Kind;
+        return k == KindFloat32 || k == KindFloat64 || k == KindUntypedFloat;
+    });
+}
+
+bool IsComplex(TypeId t) {
+    return typeSet(t, [](TypeId u) {
+        auto k = under(u).Kind;
+        return k == KindComplex64 || k == KindComplex128 || k == KindUntypedComplex;
+    });
+}
+
+bool IsNumeric(TypeId t) {
+    return typeSet(t, [](TypeId u) { return IsInteger(u) || IsFloat(u) || IsComplex(u); });
+}
+
+bool IsString(TypeId t) {
+    return typeSet(t, [](TypeId u) {
+        auto k = under(u).Kind;
+        return k == KindString || k == KindUntypedString;
+    });
+}
+
+bool IsInterface(TypeId t) { return under(t).Kind == KindInterface; }
+
+bool IsConstType(TypeId t) {
+    auto k = under(t).Kind;
+    return (k >= KindBool && k <= KindString) || (k >= KindUntypedBool && k <= KindUntypedString);
+}
+
+bool Comparable(TypeId t) {
+    auto &u = under(t);
+    switch (u.Kind) {
+    case KindSlice:
+    case KindMap:
+    case KindFunc:
+    case KindInvalid:
+        return false;
+    case KindArray:
+        return Comparable(u.Elem());
+    case KindStruct:
+        for (auto f : u.Elems) {
+            if (!Comparable(f)) {
+                return false;
+            }
+        }
+        return true;
+    case KindTypeParam:
+        return u.Elems.empty() || under(u.Elem()).Variadic || typeSet(t, Comparable);
+    default:
+        return true;
+    }
+}
+
+bool Ordered(TypeId t) { return typeSet(t, isOrdered); }
+
+bool HasNil(TypeId t) { return typeSet(t, hasNil); }
+
+TypeId DefaultType(TypeId t) {
+    switch (t) {
+    case KindUntypedBool:
+        return KindBool;
+    case KindUntypedInt:
+        return KindInt;
+    case KindUntypedRune:
+        return KindInt32;
+    case KindUntypedFloat:
+        return KindFloat64;
+    case KindUntypedComplex:
+        return KindComplex128;
+    case KindUntypedString:
+        return KindString;
+    default:
+        return t;
+    }
+}
+
+int64_t Sizeof(TypeId t) {
+    auto &u = under(DefaultType(t));
+    switch (u.Kind) {
+    case KindBool:
+    case KindInt8:
+    case KindUint8:
+        return 1;
+    case KindInt16:
+    case KindUint16:
+        return 2;
+    case KindInt32:
+    case KindUint32:
+    case KindFloat32:
+        return 4;
+    case KindComplex128:
+    case KindString:
+    case KindInterface:
+        return 16;
+    case KindSlice:
+        return 24;
+    case KindArray:
+        return u.Len * Sizeof(u.Elem());
+    case KindStruct: {
+        int64_t size = 0;
+        for (auto f : u.Elems) {
+            auto a = Alignof(f);
+            size = (size + a - 1) / a * a + Sizeof(f);
+        }
+        auto a = Alignof(t);
+        return (size + a - 1) / a * a;
+    }
+    case KindInvalid:
+    case KindUntypedNil:
+        return 0;
+    default: // words: integers, floats, complex64, pointers, maps, channels and functions
+        return 8;
+    }
+}
+
+int64_t Alignof(TypeId t) {
+    auto &u = under(DefaultType(t));
+    switch (u.Kind) {
+    case KindArray:
+        return Alignof(u.Elem());
+    case KindStruct: {
+        int64_t a = 1;
+        for (auto f : u.Elems) {
+            a = std::max(a, Alignof(f));
+        }
+        return a;
+    }
+    case KindComplex64:
+        return 4;
+    case KindString:
+    case KindInterface:
+    case KindSlice:
+    case KindComplex128:
+        return 8;
+    default:
+        return std::max<int64_t>(1, std::min<int64_t>(Sizeof(t), 8));
+    }
+}
+
+bool TermSubset(TypeId a, TypeId b) {
+    if (!(b & TildeTerm)) {
+        return a == b;
+    }
+    return TypeTable::Global().Underlying(TermType(a)) == TermType(b);
+}
+
+// LookupFieldOrMethod searches the embedded fields breadth-first, one depth
+// at a time, so that a shallower field or method shadows deeper ones and two
+// at the same depth are ambiguous.
+Selection LookupFieldOrMethod(const Checker &check, TypeId t, common::SymbolId name) {
+    auto &table = TypeTable::Global();
+    Selection result;
+    if (t == 0) {
+        return result;
+    }
+    bool indirect = false;
+    if (table.Kind(t) == KindPointer) {
+        t = table[t].Elem();
+        indirect = true;
+        if (IsInterface(t)) {
+            return result; // a pointer to an interface has no methods
+        }
+    }
+
+    struct Entry {
+        TypeId type;
+        std::vector<int> index;
+        bool indirect;
+    };
+    std::vector<Entry> current{{t, {}, indirect}};
+    std::unordered_set<TypeId> seen;
+    while (!current.empty()) {
+        std::vector<Entry> next;
+        int found = 0;
+        for (auto &e : current) {
+            auto typ = e.type;
+            if (table.Kind(typ) == KindNamed) {
+                if (!seen.insert(typ).second) {
+                    continue;
+                }
+                for (auto m : check.Methods(typ)) {
+                    if (m->Name == name) {
+                        if (found++ == 0) {
+                            result = {Selection::Method, m->Type, m, e.index, e.indirect};
+                        }
+                    }
+                }
+                typ = table.Underlying(typ);
+            }
+            auto &u = table[typ];
+            if (u.Kind == KindStruct) {
+                for (size_t i = 0; i < u.Names.size(); i++) {
+                    auto index = e.index;
+                    index.push_back(int(i));
+                    if (FieldName(u.Names[i]) == name) {
+                        if (found++ == 0) {
+                            result = {Selection::Field, u.Elems[i], nullptr, index, e.indirect};
+                        }
+                    }
+                    if (u.Names[i] & EmbeddedField) {
+                        auto ft = u.Elems[i];
+                        bool ind = e.indirect;
+                        if (table.Kind(ft) == KindPointer) {
+                            ft = table[ft].Elem();
+                            ind = true;
+                        }
+                        next.push_back({ft, std::move(index), ind});
+                    }
+                }
+            } else if (u.Kind == KindInterface || (u.Kind == KindTypeParam && !e.indirect && !u.Elems.empty())) {
+                // a type parameter has the methods of its constraint; a
+                // pointer to one has none
+                auto &iface = u.Kind == KindInterface ? u : table[table.Underlying(u.Elem())];
+                for (size_t i = 0; i < iface.Names.size(); i++) {
+                    if (iface.Names[i] == name) {
+                        if (found++ == 0) {
+                            result = {Selection::Method, iface.Elems[i], nullptr, e.index, e.indirect};
+                        }
+                    }
+                }
+            }
+        }
+        if (found > 1) {
+            return {Selection::Ambiguous};
+        }
+        if (found == 1) {
+            return result;
+        }
+        current = std::move(next);
+    }
+    return result;
+}
+
+common::SymbolId MissingMethod(const Checker &check, TypeId t, TypeId iface) {
+    auto &table = TypeTable::Global();
+    auto &it = table[table.Underlying(iface)];
+    auto &u = table[table.Underlying(t)];
+    for (size_t i = 0; i < it.Names.size(); i++) {
+        if (u.Kind == KindInterface) {
+            auto names = u.Names;
+            auto j = std::find(names.begin(), names.end(), it.Names[i]) - names.begin();
+            if (size_t(j) == names.size() || u.Elems[j] != it.Elems[i]) {
+                return it.Names[i];
+            }
+            continue;
+        }
+        auto sel = LookupFieldOrMethod(check, t, it.Names[i]);
+        if (sel.kind != Selection::Method || sel.type != it.Elems[i]) {
+            return it.Names[i];
+        }
+        // the method set of a value type excludes pointer receiver methods
+        if (sel.method != nullptr && sel.method->PtrRecv && table.Kind(t) != KindPointer && !sel.indirect) {
+            return it.Names[i];
+        }
+    }
+    return 0;
+}
+
+} // namespace types
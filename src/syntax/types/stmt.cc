@@ -0,0 +1,1054 @@
+#include <fmt/format.h>
+
+#include "syntax/ast/walk.hh"
+#include "syntax/types/check.hh"
+
+namespace types {
+
+using Context = Checker::Context;
+
+namespace {
+
+std::string_view nameOf(common::SymbolId sym) { return common::Interner::Global().Name(sym); }
+
+// exprList returns the expressions of a list, or the single expression e.
+std::vector<ast::ExprNodePtr> exprList(const ast::ExprNodePtr &e) {
+    if (e == nullptr) {
+        return {};
+    }
+    if (auto l = dyn_cast<ast::ListExpr>(e.get())) {
+        return l->ElemList;
+    }
+    return {e};
+}
+
+std::string plural(size_t n, std::string_view word) { return fmt::format("{} {}{}", n, word, n == 1 ? "" : "s"); }
+
+// hasBreak reports whether s contains a break statement that ends the
+// statement labeled label, or the innermost enclosing one if implicit.
+bool hasBreak(ast::StmtNode *s, common::SymbolId label, bool implicit) {
+    if (s == nullptr) {
+        return false;
+    }
+    auto list = [&](std::span<const ast::StmtNodePtr> l, bool impl) {
+        for (auto &x : l) {
+            if (hasBreak(x.get(), label, impl)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    switch (s->Kind()) {
+    case ast::NodeKind::BranchStmt: {
+        auto b = cast<ast::BranchStmt>(s);
+        if (b->Tok != Token_Break) {
+            return false;
+        }
+        return b->Label == nullptr ? implicit : b->Label->Sym == label;
+    }
+    case ast::NodeKind::BlockStmt:
+        return list(cast<ast::BlockStmt>(s)->List, implicit);
+    case ast::NodeKind::LabeledStmt:
+        return hasBreak(cast<ast::LabeledStmt>(s)->Stmt.get(), label, implicit);
+    case ast::NodeKind::IfStmt: {
+        auto i = cast<ast::IfStmt>(s);
+        return hasBreak(i->Then.get(), label, implicit) || hasBreak(i->Else.get(), label, implicit);
+    }
+    // an unlabeled break in a nested statement ends that statement
+    case ast::NodeKind::ForStmt:
+        return label != 0 && hasBreak(cast<ast::ForStmt>(s)->Body.get(), label, false);
+    case ast::NodeKind::SwitchStmt:
+        if (label != 0) {
+            for (auto &c : cast<ast::SwitchStmt>(s)->Body) {
+                if (list(c->Body, false)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    case ast::NodeKind::SelectStmt:
+        if (label != 0) {
+            for (auto &c : cast<ast::SelectStmt>(s)->Body) {
+                if (list(c->Body, false)) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+// Function bodies
+
+void Context::funcBody(ast::FuncType *type, ast::Field *recv, TypeId sig, TypeId recvType, ast::BlockStmt *body) {
+    // function literals save the state of the enclosing function
+    auto outerSig = std::exchange(this->sig, sig);
+    auto outerNamed = named_results;
+    auto outerLabels = std::exchange(labels, {});
+    auto outerTargets = std::exchange(targets, {});
+    auto outerIota = std::exchange(iota, -1);
+    auto firstVar = vars.size();
+
+    openScope();
+    declareParams(type, recv, sig, recvType);
+    collectLabels(body->List);
+    stmtList(body->List, false);
+    if (sig != 0 && !table[sig].Results().empty() && !isTerminating(body, 0)) {
+        errorf(body->Rbrace, "missing return");
+    }
+    for (auto &[sym, label] : labels) {
+        if (!label.Used) {
+            errorf(label.Pos, fmt::format("label {} defined and not used", nameOf(sym)));
+        }
+    }
+    for (size_t i = firstVar; i < vars.size(); i++) {
+        if (!vars[i]->Used) {
+            errorf(vars[i]->Pos, fmt::format("declared and not used: {}", nameOf(vars[i]->Name)));
+        }
+    }
+    vars.resize(firstVar);
+    closeScope();
+
+    this->sig = outerSig;
+    named_results = outerNamed;
+    labels = std::move(outerLabels);
+    targets = std::move(outerTargets);
+    iota = outerIota;
+}
+
+// collectLabels declares the labels of a function body, which are visible
+// in the whole body, except in function literals.
+void Context::collectLabels(std::span<const ast::StmtNodePtr> list) {
+    ast::Walker w;
+    for (auto &s : list) {
+        w.Walk(s.get(), [&](ast::Node *n) {
+            if (isa<ast::FuncLit>(n)) {
+                return ast::Visit::SkipChildren;
+            }
+            if (auto l = dyn_cast<ast::LabeledStmt>(n)) {
+                if (l->Label->Value != "_" && !labels.emplace(l->Label->Sym, Label{l->Label->pos}).second) {
+                    error(l->Label.get(), fmt::format("label {} already defined", l->Label->Value));
+                }
+            }
+            return isa<ast::ExprNode>(n) ? ast::Visit::SkipChildren : ast::Visit::Children;
+        });
+    }
+}
+
+// isTerminating reports whether s is a terminating statement; label is the
+// label of s, if any.
+bool Context::isTerminating(ast::StmtNode *s, common::SymbolId label) {
+    if (s == nullptr) {
+        return false;
+    }
+    auto lastIn = [&](std::span<const ast::StmtNodePtr> list) {
+        return !list.empty() && isTerminating(list.back().get(), 0);
+    };
+    switch (s->Kind()) {
+    case ast::NodeKind::ReturnStmt:
+        return true;
+    case ast::NodeKind::BranchStmt: {
+        auto tok = cast<ast::BranchStmt>(s)->Tok;
+        return tok == Token_Goto || tok == Token_Fallthrough;
+    }
+    case ast::NodeKind::ExprStmt: {
+        auto call = dyn_cast<ast::CallExpr>(cast<ast::ExprStmt>(s)->X.get());
+        return call != nullptr && panics.contains(call);
+    }
+    case ast::NodeKind::BlockStmt:
+        return lastIn(cast<ast::BlockStmt>(s)->List);
+    case ast::NodeKind::LabeledStmt: {
+        auto l = cast<ast::LabeledStmt>(s);
+        return isTerminating(l->Stmt.get(), l->Label->Sym);
+    }
+    case ast::NodeKind::IfStmt: {
+        auto i = cast<ast::IfStmt>(s);
+        return i->Else != nullptr && isTerminating(i->Then.get(), 0) && isTerminating(i->Else.get(), 0);
+    }
+    case ast::NodeKind::ForStmt: {
+        auto f = cast<ast::ForStmt>(s);
+        return f->Cond == nullptr && !isa_and_nonnull<ast::RangeClause>(f->Init.get()) &&
+               !hasBreak(f->Body.get(), label, true);
+    }
+    case ast::NodeKind::SwitchStmt: {
+        bool hasDefault = false;
+        for (auto &c : cast<ast::SwitchStmt>(s)->Body) {
+            hasDefault = hasDefault || c->Cases == nullptr;
+            if (!lastIn(c->Body)) {
+                return false;
+            }
+            for (auto &b : c->Body) {
+                if (hasBreak(b.get(), label, true)) {
+                    return false;
+                }
+            }
+        }
+        return hasDefault;
+    }
+    case ast::NodeKind::SelectStmt:
+        for (auto &c : cast<ast::SelectStmt>(s)->Body) {
+            if (!lastIn(c->Body)) {
+                return false;
+            }
+            for (auto &b : c->Body) {
+                if (hasBreak(b.get(), label, true)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Statements
+
+void Context::stmtList(std::span<const ast::StmtNodePtr> list, bool fallthroughOk) {
+    for (size_t i = 0; i < list.size(); i++) {
+        // fallthrough may only end a case clause
+        stmt(list[i].get(), fallthroughOk && i + 1 == list.size());
+    }
+}
+
+void Context::stmt(ast::StmtNode *s, bool fallthroughOk) {
+    auto label = std::exchange(pending_label, 0);
+    switch (s->Kind()) {
+    case ast::NodeKind::EmptyStmt:
+        return;
+    case ast::NodeKind::ExprStmt: {
+        auto e = cast<ast::ExprStmt>(s)->X.get();
+        Operand x;
+        rawExpr(x, e, 0);
+        if (x.Invalid() || x.mode == Mode::NoValue) {
+            return;
+        }
+        auto inner = e;
+        while (auto p = dyn_cast<ast::ParenExpr>(inner)) {
+            inner = p->X.get();
+        }
+        if (auto call = dyn_cast<ast::CallExpr>(inner)) {
+            // calls are statements, except for conversions and calls of
+            // built-ins without side effects
+            auto fun = call->Fun.get();
+            while (auto p = dyn_cast<ast::ParenExpr>(fun)) {
+                fun = p->X.get();
+            }
+            bool conversion = fun->typ != 0 && !isa<ast::FuncLit>(fun) && table.Kind(table.Underlying(fun->typ)) !=
+                                                                               KindFunc;
+            auto n = dyn_cast<ast::Name>(fun);
+            auto obj = n != nullptr ? lookup(n) : nullptr;
+            bool pure = obj != nullptr && obj->Kind == ObjKind::Builtin && obj->Builtin != BuiltinId::Copy &&
+                        obj->Builtin != BuiltinId::Recover;
+            if (!conversion && !pure) {
+                return;
+            }
+        } else if (auto op = dyn_cast<ast::Operation>(inner); op && op->Op == Operator_Recv && op->Y == nullptr) {
+            return;
+        }
+        if (x.mode == Mode::TypeExpr) {
+            error(e, fmt::format("{} (type) is not an expression", ast::String(e)));
+        } else {
+            error(e, fmt::format("{} is not used", describe(x)));
+        }
+        return;
+    }
+    case ast::NodeKind::SendStmt: {
+        auto send = cast<ast::SendStmt>(s);
+        Operand ch, v;
+        expr(ch, send->Chan.get());
+        expr(v, send->Value.get());
+        if (ch.Invalid() || v.Invalid()) {
+            return;
+        }
+        auto u = under(ch.type);
+        if (table.Kind(u) != KindChan) {
+            error(s, fmt::format("invalid operation: cannot send to non-channel {}", describe(ch)));
+            return;
+        }
+        if (table[u].Len == RecvOnly) {
+            error(s, fmt::format("invalid operation: cannot send to receive-only channel {}", describe(ch)));
+            return;
+        }
+        assignment(v, table[u].Elem(), "send");
+        return;
+    }
+    case ast::NodeKind::DeclStmt:
+        declStmt(cast<ast::DeclStmt>(s));
+        return;
+    case ast::NodeKind::AssignStmt:
+        assignStmt(cast<ast::AssignStmt>(s));
+        return;
+    case ast::NodeKind::BlockStmt:
+        openScope();
+        stmtList(cast<ast::BlockStmt>(s)->List, false);
+        closeScope();
+        return;
+    case ast::NodeKind::LabeledStmt: {
+        auto l = cast<ast::LabeledStmt>(s);
+        pending_label = l->Label->Sym;
+        stmt(l->Stmt.get(), fallthroughOk);
+        pending_label = 0;
+        return;
+    }
+    case ast::NodeKind::BranchStmt:
+        branchStmt(cast<ast::BranchStmt>(s), fallthroughOk);
+        return;
+    case ast::NodeKind::CallStmt: {
+        auto c = cast<ast::CallStmt>(s);
+        auto kind = c->Tok == Token_Go ? "go" : "defer";
+        Operand x;
+        rawExpr(x, c->Call.get(), 0);
+        if (x.Invalid()) {
+            return;
+        }
+        auto fun = c->Call->Fun.get();
+        if (fun->typ != 0 && table.Kind(table.Underlying(fun->typ)) != KindFunc && !isa<ast::FuncLit>(fun)) {
+            error(s, fmt::format("{} requires function call, not conversion", kind));
+        }
+        return;
+    }
+    case ast::NodeKind::ReturnStmt:
+        returnStmt(cast<ast::ReturnStmt>(s));
+        return;
+    case ast::NodeKind::IfStmt:
+        ifStmt(cast<ast::IfStmt>(s));
+        return;
+    case ast::NodeKind::ForStmt:
+        targets.push_back({label, true});
+        forStmt(cast<ast::ForStmt>(s));
+        targets.pop_back();
+        return;
+    case ast::NodeKind::SwitchStmt:
+        targets.push_back({label, false});
+        switchStmt(cast<ast::SwitchStmt>(s));
+        targets.pop_back();
+        return;
+    case ast::NodeKind::SelectStmt:
+        targets.push_back({label, false});
+        selectStmt(cast<ast::SelectStmt>(s));
+        targets.pop_back();
+        return;
+    default:
+        error(s, "invalid statement");
+        return;
+    }
+}
+
+void Context::simpleStmt(ast::SimpleStmtNode *s) {
+    if (s != nullptr) {
+        stmt(s, false);
+    }
+}
+
+void Context::branchStmt(ast::BranchStmt *s, bool fallthroughOk) {
+    auto findTarget = [&](common::SymbolId label, bool loop) {
+        for (auto it = targets.rbegin(); it != targets.rend(); ++it) {
+            if ((label == 0 || it->Label == label) && (!loop || it->Loop)) {
+                return true;
+            }
+            if (label != 0 && it->Label == label) {
+                return false; // labels a statement of the wrong kind
+            }
+        }
+        return false;
+    };
+    if (s->Label != nullptr) {
+        auto it = labels.find(s->Label->Sym);
+        if (it == labels.end()) {
+            error(s->Label.get(), fmt::format("label {} not defined", s->Label->Value));
+            return;
+        }
+        it->second.Used = true;
+    }
+    auto label = s->Label == nullptr ? 0 : s->Label->Sym;
+    switch (s->Tok) {
+    case Token_Break:
+        if (!findTarget(label, false)) {
+            if (label != 0) {
+                error(s->Label.get(), fmt::format("invalid break label {}", s->Label->Value));
+            } else {
+                error(s, "break is not in a loop, switch, or select");
+            }
+        }
+        return;
+    case Token_Continue:
+        if (!findTarget(label, true)) {
+            if (label != 0) {
+                error(s->Label.get(), fmt::format("invalid continue label {}", s->Label->Value));
+            } else {
+                error(s, "continue is not in a loop");
+            }
+        }
+        return;
+    case Token_Fallthrough:
+        if (!fallthroughOk) {
+            error(s, "fallthrough statement out of place");
+        }
+        return;
+    default: // goto
+        return;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Declarations
+
+void Context::declStmt(ast::DeclStmt *s) {
+    const ast::Group *group = nullptr;
+    ast::ConstDecl *last = nullptr;
+    int64_t iota = 0;
+    for (auto &decl : s->DeclList) {
+        if (auto c = dyn_cast<ast::ConstDecl>(decl.get()); c == nullptr || c->Group == nullptr ||
+                                                              c->Group.get() != group) {
+            group = c == nullptr ? nullptr : c->Group.get();
+            last = nullptr;
+            iota = 0;
+        }
+        switch (decl->Kind()) {
+        case ast::NodeKind::ConstDecl: {
+            auto c = cast<ast::ConstDecl>(decl.get());
+            if (c->Type != nullptr || c->Values != nullptr) {
+                last = c;
+            }
+            localConst(c, last, iota++);
+            break;
+        }
+        case ast::NodeKind::VarDecl:
+            localVar(cast<ast::VarDecl>(decl.get()));
+            break;
+        case ast::NodeKind::TypeDecl:
+            localType(cast<ast::TypeDecl>(decl.get()));
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void Context::localConst(ast::ConstDecl *d, ast::ConstDecl *last, int64_t iota) {
+    auto outer = std::exchange(this->iota, iota);
+    TypeId t = 0;
+    if (last != nullptr && last->Type != nullptr) {
+        t = typExpr(last->Type.get());
+        if (t != 0 && !IsConstType(t)) {
+            error(last->Type.get(), fmt::format("invalid constant type {}", table.String(t)));
+            t = 0;
+        }
+    }
+    auto values = last == nullptr ? std::vector<ast::ExprNodePtr>{} : exprList(last->Values);
+    std::vector<Object *> objs;
+    for (size_t i = 0; i < d->NameList.size(); i++) {
+        auto name = d->NameList[i].get();
+        auto obj = newObject(ObjKind::Const, name, 0);
+        objs.push_back(obj);
+        if (i >= values.size()) {
+            error(name, "missing init expr for const declaration");
+            continue;
+        }
+        Operand x;
+        expr(x, values[i].get());
+        if (x.Invalid()) {
+            continue;
+        }
+        if (x.mode != Mode::Constant) {
+            error(values[i].get(), fmt::format("{} is not constant", describe(x)));
+            continue;
+        }
+        if (t != 0) {
+            assignment(x, t, "constant declaration");
+            if (x.Invalid()) {
+                continue;
+            }
+        }
+        obj->Type = x.type;
+            obj->Val = x.val;
+    }
+    if (values.size() > d->NameList.size() && last == d) {
+        error(values[d->NameList.size()].get(), "extra init expr");
+    }
+    this->iota = outer;
+    // the constants are in scope after their declaration
+    for (size_t i = 0; i < objs.size(); i++) {
+        declare(objs[i], d->NameList[i].get());
+    }
+}
+
+void Context::localVar(ast::VarDecl *d) {
+    TypeId t = 0;
+    if (d->Type != nullptr) {
+        t = typExpr(d->Type.get());
+    }
+    std::vector<Object *> objs;
+    for (auto &name : d->NameList) {
+        objs.push_back(newObject(ObjKind::Var, name.get(), t));
+    }
+    if (d->Values != nullptr) {
+        initVars(objs, exprList(d->Values), d);
+    }
+    // the variables are in scope after their declaration
+    for (size_t i = 0; i < objs.size(); i++) {
+        declare(objs[i], d->NameList[i].get());
+        if (d->NameList[i]->Value != "_") {
+            vars.push_back(objs[i]);
+        }
+    }
+}
+
+void Context::localType(ast::TypeDecl *d) {
+    auto obj = newObject(ObjKind::TypeName, d->Name.get(), 0);
+    if (d->Alias) {
+        obj->Type = typExpr(d->Type.get(), true);
+        declare(obj, d->Name.get());
+        return;
+    }
+    // the type is in scope in its own declaration
+    obj->Type = table.NewNamed(obj->Name);
+    declare(obj, d->Name.get());
+    auto rhs = typExpr(d->Type.get(), true);
+    table.SetUnderlying(obj->Type, rhs);
+}
+
+// ----------------------------------------------------------------------------
+// Assignments
+
+// unpack checks the right-hand side of an assignment of n values. A single
+// call may provide all values, and a comma-ok expression two. It returns
+// false if the number of values does not match; xs then holds the values
+// found.
+bool Context::unpack(std::span<const ast::ExprNodePtr> rhs, size_t n, std::vector<Operand> &xs) {
+    xs.clear();
+    if (rhs.size() == 1 && n > 1) {
+        Operand x;
+        multiExpr(x, rhs[0].get());
+        if (x.Invalid()) {
+            xs.resize(n, x);
+            return true;
+        }
+        if (x.tuple.size() > 1) {
+            for (auto t : x.tuple) {
+                Operand y = x;
+                y.tuple = {};
+                y.type = t;
+                xs.push_back(y);
+            }
+            return xs.size() == n;
+        }
+        xs.push_back(x);
+        if (n == 2 && (x.mode == Mode::CommaOk || x.mode == Mode::MapIndex)) {
+            Operand ok;
+            ok.mode = Mode::Value;
+            ok.type = KindUntypedBool;
+            ok.expr = x.expr;
+            xs.back().mode = Mode::Value;
+            xs.push_back(ok);
+            return true;
+        }
+        return false;
+    }
+    for (auto &e : rhs) {
+        Operand x;
+        expr(x, e.get());
+        xs.push_back(x);
+    }
+    return xs.size() == n;
+}
+
+// mismatch reports an assignment of the wrong number of values.
+void Context::mismatch(std::span<const ast::ExprNodePtr> rhs, size_t n, const std::vector<Operand> &xs,
+                       ast::Node *at) {
+    if (!rhs.empty()) {
+        at = rhs[0].get();
+    }
+    if (rhs.size() == 1 && isa<ast::CallExpr>(rhs[0].get())) {
+        error(at, fmt::format("assignment mismatch: {} but {} returns {}", plural(n, "variable"),
+                              ast::String(rhs[0].get()), plural(xs.size(), "value")));
+    } else {
+        error(at, fmt::format("assignment mismatch: {} but {}", plural(n, "variable"), plural(xs.size(), "value")));
+    }
+}
+
+// initVars checks the initialization of the variables lhs with rhs. The
+// variables without a declared type get the types of their values.
+void Context::initVars(std::span<Object *const> lhs, std::span<const ast::ExprNodePtr> rhs, ast::Node *at) {
+    std::vector<Operand> xs;
+    if (!unpack(rhs, lhs.size(), xs)) {
+        mismatch(rhs, lhs.size(), xs, at);
+        // avoid follow-on errors for the variables
+        for (auto obj : lhs) {
+            obj->Used = true;
+        }
+        return;
+    }
+    for (size_t i = 0; i < lhs.size(); i++) {
+        auto &x = xs[i];
+        assignment(x, lhs[i]->Type, "variable declaration");
+        if (lhs[i]->Type == 0 && !x.Invalid()) {
+            lhs[i]->Type = x.type;
+        }
+    }
+}
+
+// assignVar checks the assignment of x to lhs.
+void Context::assignVar(ast::ExprNode *lhs, Operand &x) {
+    auto inner = lhs;
+    while (auto p = dyn_cast<ast::ParenExpr>(inner)) {
+        inner = p->X.get();
+    }
+    Operand z;
+    if (auto n = dyn_cast<ast::Name>(inner)) {
+        if (n->Value == "_") {
+            assignment(x, 0, "assignment");
+            return;
+        }
+        // assigning to a variable does not use it
+        auto obj = lookup(n);
+        if (obj != nullptr && obj->Kind == ObjKind::Var) {
+            use(n, obj, false);
+            n->SetType(obj->Type);
+            z.mode = obj->Type == 0 ? Mode::Invalid : Mode::Variable;
+            z.type = obj->Type;
+            z.expr = lhs;
+        } else {
+            expr(z, lhs);
+        }
+    } else {
+        expr(z, lhs);
+    }
+    if (z.Invalid()) {
+        return;
+    }
+    if (z.mode != Mode::Variable && z.mode != Mode::MapIndex) {
+        error(lhs, fmt::format("cannot assign to {} (neither addressable nor a map index expression)", describe(z)));
+        return;
+    }
+    assignment(x, z.type, "assignment");
+}
+
+void Context::assignVars(std::span<const ast::ExprNodePtr> lhs, std::span<const ast::ExprNodePtr> rhs,
+                         ast::Node *at) {
+    std::vector<Operand> xs;
+    if (!unpack(rhs, lhs.size(), xs)) {
+        mismatch(rhs, lhs.size(), xs, at);
+        for (auto &e : lhs) {
+            Operand x;
+            rawExpr(x, e.get(), 0);
+        }
+        return;
+    }
+    for (size_t i = 0; i < lhs.size(); i++) {
+        assignVar(lhs[i].get(), xs[i]);
+    }
+}
+
+void Context::shortVarDecl(ast::AssignStmt *s, std::span<const ast::ExprNodePtr> lhs,
+                           std::span<const ast::ExprNodePtr> rhs) {
+    // the new variables are in scope after the statement
+    std::vector<Object *> objs(lhs.size());
+    std::vector<bool> fresh(lhs.size());
+    bool hasNew = false;
+    for (size_t i = 0; i < lhs.size(); i++) {
+        auto n = dyn_cast<ast::Name>(lhs[i].get());
+        if (n == nullptr) {
+            error(lhs[i].get(), fmt::format("non-name {} on left side of :=", ast::String(lhs[i].get())));
+            continue;
+        }
+        bool repeated = false;
+        for (size_t j = 0; j < i; j++) {
+            if (auto m = dyn_cast<ast::Name>(lhs[j].get()); m && m->Sym == n->Sym && n->Value != "_") {
+                repeated = true;
+            }
+        }
+        if (repeated) {
+            error(n, fmt::format("{} repeated on left side of :=", n->Value));
+            continue;
+        }
+        if (n->Value != "_") {
+            if (auto obj = blocks[scope].LookupLocal(n->Sym); obj != nullptr && obj->Kind == ObjKind::Var) {
+                objs[i] = obj;
+                use(n, obj, false);
+                continue;
+            }
+        }
+        objs[i] = newObject(ObjKind::Var, n, 0);
+        fresh[i] = true;
+        hasNew = hasNew || n->Value != "_";
+    }
+
+    std::vector<Operand> xs;
+    if (!unpack(rhs, lhs.size(), xs)) {
+        mismatch(rhs, lhs.size(), xs, s);
+        xs.assign(lhs.size(), Operand{});
+        for (auto obj : objs) {
+            if (obj != nullptr) {
+                obj->Used = true;
+            }
+        }
+    }
+    for (size_t i = 0; i < lhs.size(); i++) {
+        if (objs[i] == nullptr) {
+            continue;
+        }
+        assignment(xs[i], fresh[i] ? 0 : objs[i]->Type, "assignment");
+        if (fresh[i] && !xs[i].Invalid()) {
+            objs[i]->Type = xs[i].type;
+        }
+    }
+    if (!hasNew) {
+        error(s, "no new variables on left side of :=");
+    }
+    for (size_t i = 0; i < lhs.size(); i++) {
+        if (fresh[i]) {
+            declare(objs[i], cast<ast::Name>(lhs[i].get()));
+            if (cast<ast::Name>(lhs[i].get())->Value != "_") {
+                vars.push_back(objs[i]);
+            }
+        }
+    }
+}
+
+void Context::assignStmt(ast::AssignStmt *s) {
+    auto lhs = exprList(s->Lhs);
+    auto rhs = exprList(s->Rhs);
+    if (s->Op == Operator_Def) {
+        shortVarDecl(s, lhs, rhs);
+        return;
+    }
+    if (s->Rhs == nullptr || s->Op != 0) {
+        // x++, x--, x op= y: the operation reads x, which uses it
+        Operand x;
+        if (s->Rhs == nullptr) {
+            expr(x, s->Lhs.get());
+            if (!x.Invalid() && !IsNumeric(x.type)) {
+                error(s, fmt::format("invalid operation: {}{} (non-numeric type {})", ast::String(s->Lhs.get()),
+                                     s->Op == Operator_Add ? "++" : "--", table.String(x.type)));
+                x.mode = Mode::Invalid;
+            }
+        } else {
+            binary(x, nullptr, s->Lhs.get(), s->Rhs.get(), s->Op);
+        }
+        if (!x.Invalid()) {
+            x.expr = s->Rhs != nullptr ? s->Rhs.get() : s->Lhs.get();
+            assignVar(s->Lhs.get(), x);
+        }
+        return;
+    }
+    assignVars(lhs, rhs, s);
+}
+
+void Context::returnStmt(ast::ReturnStmt *s) {
+    auto list = exprList(s->Results);
+    if (sig == 0) {
+        useExprs(list); // the signature is invalid, and was reported
+        return;
+    }
+    auto results = table[sig].Results();
+    if (list.empty()) {
+        if (!results.empty() && !named_results) {
+            error(s, "not enough return values");
+        }
+        return;
+    }
+    if (results.empty()) {
+        error(list[0].get(), "too many return values");
+        useExprs(list);
+        return;
+    }
+    std::vector<Operand> xs;
+    if (!unpack(list, results.size(), xs)) {
+        error(xs.size() < results.size() ? static_cast<ast::Node *>(s) : list[std::min(results.size(), list.size() - 1)].get(),
+              xs.size() < results.size() ? "not enough return values" : "too many return values");
+        return;
+    }
+    for (size_t i = 0; i < results.size(); i++) {
+        assignment(xs[i], results[i], "return statement");
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Control flow
+
+void Context::ifStmt(ast::IfStmt *s) {
+    openScope();
+    simpleStmt(s->Init.get());
+    Operand x;
+    expr(x, s->Cond.get());
+    if (!x.Invalid() && !IsBoolean(x.type)) {
+        error(s->Cond.get(), "non-boolean condition in if statement");
+    } else {
+        assignment(x, 0, "if statement");
+    }
+    stmt(s->Then.get(), false);
+    if (s->Else != nullptr) {
+        stmt(s->Else.get(), false);
+    }
+    closeScope();
+}
+
+void Context::forStmt(ast::ForStmt *s) {
+    openScope();
+    if (auto r = dyn_cast_or_null<ast::RangeClause>(s->Init.get())) {
+        rangeStmt(s, r);
+        closeScope();
+        return;
+    }
+    simpleStmt(s->Init.get());
+    if (s->Cond != nullptr) {
+        Operand x;
+        expr(x, s->Cond.get());
+        if (!x.Invalid() && !IsBoolean(x.type)) {
+            error(s->Cond.get(), "non-boolean condition in for statement");
+        } else {
+            assignment(x, 0, "for statement");
+        }
+    }
+    if (auto a = dyn_cast_or_null<ast::AssignStmt>(s->Post.get()); a && a->Op == Operator_Def) {
+        error(a, "cannot declare in post statement of for loop");
+    } else {
+        simpleStmt(s->Post.get());
+    }
+    stmt(s->Body.get(), false);
+    closeScope();
+}
+
+void Context::rangeStmt(ast::ForStmt *s, ast::RangeClause *r) {
+    Operand x;
+    expr(x, r->X.get());
+    TypeId key = 0, value = 0;
+    size_t max = 2;
+    if (!x.Invalid()) {
+        auto u = under(x.type);
+        auto &t = table[u];
+        if (IsString(u)) {
+            key = KindInt;
+            value = KindInt32;
+        } else if (t.Kind == KindArray || t.Kind == KindSlice) {
+            key = KindInt;
+            value = t.Elem();
+        } else if (t.Kind == KindPointer && table.Kind(under(t.Elem())) == KindArray) {
+            key = KindInt;
+            value = table[under(t.Elem())].Elem();
+        } else if (t.Kind == KindMap) {
+            key = t.Key();
+            value = t.Elem();
+        } else if (t.Kind == KindChan && t.Len != SendOnly) {
+            key = t.Elem();
+            max = 1;
+        } else if (IsInteger(u)) {
+            assignment(x, 0, "range clause");
+            key = x.type;
+            max = 1;
+        } else {
+            error(r->X.get(), fmt::format("cannot range over {}", describe(x)));
+            x.mode = Mode::Invalid;
+        }
+    }
+    auto lhs = exprList(r->Lhs);
+    if (lhs.size() > max) {
+        error(lhs[max].get(), fmt::format("range over {} permits only one iteration variable", describe(x)));
+        lhs.resize(max);
+    }
+    TypeId types[2] = {key, value};
+    if (r->Def) {
+        for (size_t i = 0; i < lhs.size(); i++) {
+            auto n = dyn_cast<ast::Name>(lhs[i].get());
+            if (n == nullptr) {
+                error(lhs[i].get(), fmt::format("non-name {} on left side of :=", ast::String(lhs[i].get())));
+                continue;
+            }
+            n->SetType(types[i]);
+            declareVar(n, x.Invalid() ? 0 : types[i]);
+        }
+    } else {
+        for (size_t i = 0; i < lhs.size(); i++) {
+            if (lhs[i] == nullptr) {
+                continue;
+            }
+            Operand v;
+            v.mode = x.Invalid() ? Mode::Invalid : Mode::Value;
+            v.type = types[i];
+            v.expr = r->X.get();
+            assignVar(lhs[i].get(), v);
+        }
+    }
+    stmt(s->Body.get(), false);
+}
+
+void Context::switchStmt(ast::SwitchStmt *s) {
+    openScope();
+    simpleStmt(s->Init.get());
+    if (auto g = dyn_cast_or_null<ast::TypeSwitchGuard>(s->Tag.get())) {
+        typeSwitchStmt(s, g);
+        closeScope();
+        return;
+    }
+    Operand tag;
+    if (s->Tag != nullptr) {
+        expr(tag, s->Tag.get());
+        assignment(tag, 0, "switch expression");
+        if (!tag.Invalid() && !Comparable(tag.type) && !HasNil(tag.type)) {
+            error(s->Tag.get(), fmt::format("cannot switch on {}", describe(tag)));
+            tag.mode = Mode::Invalid;
+        }
+    } else {
+        tag.mode = Mode::Constant;
+        tag.type = KindBool;
+        tag.val = Value::MakeBool(true);
+    }
+    // integer and string case values, to report duplicates
+    std::unordered_map<int64_t, ast::ExprNode *> ints;
+    std::unordered_map<std::string, ast::ExprNode *> strings;
+    ast::CaseClause *dflt = nullptr;
+    for (size_t i = 0; i < s->Body.size(); i++) {
+        auto c = s->Body[i].get();
+        if (c->Cases == nullptr) {
+            if (dflt != nullptr) {
+                error(c, "multiple defaults in switch");
+            }
+            dflt = c;
+        }
+        for (auto &e : exprList(c->Cases)) {
+            Operand x;
+            expr(x, e.get());
+            if (x.Invalid() || tag.Invalid()) {
+                continue;
+            }
+            Operand y = tag;
+            y.expr = s->Tag != nullptr ? s->Tag.get() : e.get();
+            matchTypes(x, y);
+            if (x.Invalid() || y.Invalid()) {
+                continue;
+            }
+            if (x.type != y.type && !(HasNil(y.type) && x.type == KindUntypedNil)) {
+                if (s->Tag != nullptr) {
+                    error(e.get(), fmt::format("invalid case {} in switch on {} (mismatched types {} and {})",
+                                               ast::String(e.get()), ast::String(s->Tag.get()), table.String(x.type),
+                                               table.String(y.type)));
+                } else {
+                    error(e.get(), fmt::format("invalid case {} in switch (mismatched types {} and bool)",
+                                               ast::String(e.get()), table.String(x.type)));
+                }
+                continue;
+            }
+            if (x.mode == Mode::Constant) {
+                bool dup = false;
+                if (auto v = x.val.Int64Val()) {
+                    dup = !ints.emplace(*v, e.get()).second;
+                } else if (x.val.Kind() == ConstKind::String) {
+                    dup = !strings.emplace(std::string(x.val.StringVal()), e.get()).second;
+                }
+                if (dup) {
+                    error(e.get(), fmt::format("duplicate case {} in expression switch", ast::String(e.get())));
+                }
+            }
+        }
+        openScope();
+        stmtList(c->Body, i + 1 < s->Body.size());
+        closeScope();
+    }
+    closeScope();
+}
+
+void Context::typeSwitchStmt(ast::SwitchStmt *s, ast::TypeSwitchGuard *g) {
+    Operand x;
+    expr(x, g->X.get());
+    if (!x.Invalid() && !IsInterface(x.type)) {
+        error(g->X.get(), fmt::format("{} is not an interface", describe(x)));
+        x.mode = Mode::Invalid;
+    }
+    auto nilName = common::Interner::Global().Intern("nil");
+    std::vector<Object *> clauseVars;
+    ast::CaseClause *dflt = nullptr;
+    for (auto &c : s->Body) {
+        if (c->Cases == nullptr) {
+            if (dflt != nullptr) {
+                error(c.get(), "multiple defaults in switch");
+            }
+            dflt = c.get();
+        }
+        auto cases = exprList(c->Cases);
+        TypeId single = 0;
+        for (auto &e : cases) {
+            TypeId t = 0;
+            auto n = dyn_cast<ast::Name>(e.get());
+            if (auto obj = n != nullptr && n->Sym == nilName ? lookup(n) : nullptr; obj && obj->Kind == ObjKind::Nil) {
+                use(n, obj);
+                t = KindUntypedNil;
+            } else {
+                t = typExpr(e.get());
+                if (t != 0 && !x.Invalid() && !IsInterface(t)) {
+                    if (auto m = MissingMethod(check, t, x.type)) {
+                        error(e.get(), fmt::format("impossible type switch case: {} cannot have dynamic type {} "
+                                                   "(missing method {})",
+                                                   describe(x), table.String(t), nameOf(m)));
+                    }
+                }
+            }
+            single = cases.size() == 1 ? t : 0;
+        }
+        openScope();
+        if (g->Lhs != nullptr) {
+            // the variable has the type of the case if there is one, else
+            // the type of x
+            auto t = single != 0 && single != KindUntypedNil ? single : x.type;
+            auto obj = newObject(ObjKind::Var, g->Lhs.get(), x.Invalid() ? 0 : t);
+            blocks[scope].Insert(obj);
+            clauseVars.push_back(obj);
+            implicits.emplace_back(c.get(), obj);
+        }
+        stmtList(c->Body, false);
+        closeScope();
+    }
+    if (g->Lhs != nullptr) {
+        uses.emplace_back(g->Lhs.get(), clauseVars.empty() ? nullptr : clauseVars[0]);
+        bool used = false;
+        for (auto v : clauseVars) {
+            used = used || v->Used;
+        }
+        if (!used) {
+            error(g->Lhs.get(), fmt::format("declared and not used: {}", g->Lhs->Value));
+        }
+    }
+}
+
+void Context::selectStmt(ast::SelectStmt *s) {
+    ast::CommClause *dflt = nullptr;
+    for (auto &c : s->Body) {
+        if (c->Comm == nullptr) {
+            if (dflt != nullptr) {
+                error(c.get(), "multiple defaults in select");
+            }
+            dflt = c.get();
+        } else {
+            // the communication must be a send or a receive
+            auto rhs = [](ast::ExprNode *e) {
+                while (auto p = dyn_cast_or_null<ast::ParenExpr>(e)) {
+                    e = p->X.get();
+                }
+                auto op = dyn_cast_or_null<ast::Operation>(e);
+                return op != nullptr && op->Op == Operator_Recv && op->Y == nullptr;
+            };
+            bool ok = isa<ast::SendStmt>(c->Comm.get());
+            if (auto e = dyn_cast<ast::ExprStmt>(c->Comm.get())) {
+                ok = rhs(e->X.get());
+            } else if (auto a = dyn_cast<ast::AssignStmt>(c->Comm.get())) {
+                ok = (a->Op == 0 || a->Op == Operator_Def) && rhs(a->Rhs.get());
+            }
+            if (!ok) {
+                error(c->Comm.get(), "select case must be receive, send or assign recv");
+            }
+        }
+        openScope();
+        simpleStmt(c->Comm.get());
+        stmtList(c->Body, false);
+        closeScope();
+    }
+}
+
+} // namespace types
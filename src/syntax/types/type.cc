@@ -0,0 +1,337 @@
+#include "syntax/types/type.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include <xxhash.h>
+
+namespace types {
+
+namespace {
+
+const char *basicNames[] = {
+    "invalid type", "bool", "int", "int8", "int16", "int32", "int64", "uint", "uint8", "uint16", "uint32", "uint64",
+    "uintptr", "float32", "float64", "complex64", "complex128", "string", "unsafe.Pointer", "untyped bool",
+    "untyped int", "untyped rune", "untyped float", "untyped complex", "untyped string", "untyped nil",
+};
+
+} // namespace
+
+// Pending is the key used to insert a new type, see Interner::Pending.
+// Converting it to a key copies the element and name arrays into the arena,
+// converting it to a value publishes the record.
+struct TypeTable::Pending {
+    TypeTable *table;
+    const Key &k;
+    Key stored{};
+    TypeId id = 0;
+
+    operator Key() {
+        stored = table->Store(k);
+        return stored;
+    }
+    operator TypeId() {
+        Type t;
+        t.Kind = stored.kind;
+        t.Variadic = stored.variadic;
+        t.Len = stored.len;
+        t.Elems = stored.elems;
+        t.Names = stored.names;
+        id = table->Publish(t);
+        return id;
+    }
+};
+
+size_t TypeTable::Hash::operator()(const Key &k) const {
+    auto h = XXH3_64bits_withSeed(k.elems.data(), k.elems.size_bytes(),
+                                  uint64_t(k.len) * 0x9e3779b97f4a7c15ull ^ (uint64_t(k.kind) << 1 | k.variadic));
+    return k.names.empty() ? h : XXH3_64bits_withSeed(k.names.data(), k.names.size_bytes(), h);
+}
+size_t TypeTable::Hash::operator()(const Pending &p) const { return (*this)(p.k); }
+
+bool TypeTable::Equal::operator()(const Key &a, const Key &b) const {
+    return a.kind == b.kind && a.variadic == b.variadic && a.len == b.len &&
+           std::equal(a.elems.begin(), a.elems.end(), b.elems.begin(), b.elems.end()) &&
+           std::equal(a.names.begin(), a.names.end(), b.names.begin(), b.names.end());
+}
+bool TypeTable::Equal::operator()(const Key &a, const Pending &b) const { return (*this)(a, b.k); }
+
+TypeTable::TypeTable() : _chunks(new std::atomic<Type *>[max_chunks]()) {
+    // the basic and untyped types, in kind order so that their IDs are their kinds
+    for (uint8 kind = KindInvalid; kind <= KindUntypedNil; kind++) {
+        Intern(Key{kind, false, 0, {}, {}});
+    }
+}
+
+TypeTable::~TypeTable() {
+    for (size_t i = 0; i < max_chunks; i++) {
+        delete[] _chunks[i].load(std::memory_order_relaxed);
+    }
+}
+
+TypeTable &TypeTable::Global() {
+    static TypeTable global;
+    return global;
+}
+
+TypeId TypeTable::Intern(const Key &k) {
+    TypeId id = 0;
+    if (_map.find(k, id)) {
+        return id;
+    }
+    Pending p{this, k};
+    auto inserted = _map.uprase_fn(
+        p,
+        [&](TypeId &existing) {
+            id = existing;
+            return false;
+        },
+        p);
+    return inserted ? p.id : id;
+}
+
+TypeTable::Key TypeTable::Store(const Key &k) {
+    auto n = k.elems.size() + k.names.size();
+    if (n == 0) {
+        return k;
+    }
+    uint32_t *dst;
+    {
+        tbb::spin_mutex::scoped_lock lock(_arena_mutex);
+        if (n > _avail) {
+            auto size = std::max(n, arena_block_size);
+            _blocks.emplace_back(new uint32_t[size]);
+            _cur = _blocks.back().get();
+            _avail = size;
+        }
+        dst = _cur;
+        _cur += n;
+        _avail -= n;
+    }
+    std::copy(k.elems.begin(), k.elems.end(), dst);
+    std::copy(k.names.begin(), k.names.end(), dst + k.elems.size());
+    return Key{k.kind, k.variadic, k.len, std::span<const TypeId>(dst, k.elems.size()),
+               std::span<const common::SymbolId>(dst + k.elems.size(), k.names.size())};
+}
+
+TypeId TypeTable::Publish(const Type &t) {
+    auto id = _next.fetch_add(1, std::memory_order_acq_rel);
+    if ((id >> chunk_bits) >= max_chunks) {
+        panic("too many types");
+    }
+    auto &slot = _chunks[id >> chunk_bits];
+    auto chunk = slot.load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+        auto fresh = new Type[chunk_size];
+        if (slot.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)) {
+            chunk = fresh;
+        } else {
+            delete[] fresh;
+        }
+    }
+    auto &rec = chunk[id & (chunk_size - 1)];
+    rec = t;
+    if (t.Kind != KindNamed) {
+        rec.Underlying = id;
+    }
+    return id;
+}
+
+TypeId TypeTable::Array(int64 len, TypeId elem) { return Intern(Key{KindArray, false, len, {&elem, 1}, {}}); }
+
+TypeId TypeTable::Slice(TypeId elem) { return Intern(Key{KindSlice, false, 0, {&elem, 1}, {}}); }
+
+TypeId TypeTable::Pointer(TypeId elem) { return Intern(Key{KindPointer, false, 0, {&elem, 1}, {}}); }
+
+TypeId TypeTable::Map(TypeId key, TypeId value) {
+    TypeId elems[] = {key, value};
+    return Intern(Key{KindMap, false, 0, elems, {}});
+}
+
+TypeId TypeTable::Chan(uint32_t dir, TypeId elem) { return Intern(Key{KindChan, false, dir, {&elem, 1}, {}}); }
+
+TypeId TypeTable::Func(std::span<const TypeId> params, std::span<const TypeId> results, bool variadic) {
+    // small signatures are assembled on the stack
+    TypeId buf[8];
+    std::vector<TypeId> big;
+    auto n = params.size() + results.size();
+    TypeId *elems = buf;
+    if (n > std::size(buf)) {
+        big.resize(n);
+        elems = big.data();
+    }
+    std::copy(params.begin(), params.end(), elems);
+    std::copy(results.begin(), results.end(), elems + params.size());
+    return Intern(Key{KindFunc, variadic, int64(params.size()), {elems, n}, {}});
+}
+
+TypeId TypeTable::Struct(std::span<const common::SymbolId> names, std::span<const TypeId> fields) {
+    return Intern(Key{KindStruct, false, 0, fields, names});
+}
+
+TypeId TypeTable::Interface(std::span<const common::SymbolId> names, std::span<const TypeId> methods,
+                             std::span<const TypeId> terms, bool comparable) {
+    // method sets are unordered: canonicalize by name
+    std::vector<uint32_t> order(names.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return common::Interner::Global().Name(names[a]) < common::Interner::Global().Name(names[b]);
+    });
+    std::vector<common::SymbolId> sorted_names(names.size());
+    std::vector<TypeId> elems(names.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        sorted_names[i] = names[order[i]];
+        elems[i] = methods[order[i]];
+    }
+    for (auto t : terms) {
+        if (std::find(elems.begin() + names.size(), elems.end(), t) == elems.end()) {
+            elems.push_back(t);
+        }
+    }
+    return Intern(Key{KindInterface, comparable, int64(elems.size() - names.size()), elems, sorted_names});
+}
+
+TypeId TypeTable::NewNamed(common::SymbolId name) {
+    Type t;
+    t.Kind = KindNamed;
+    t.Name = name;
+    return Publish(t);
+}
+
+void TypeTable::SetUnderlying(TypeId named, TypeId underlying) {
+    auto &rec = const_cast<Type &>(Get(named));
+    // the underlying type of a named type is never a named type
+    rec.Underlying = Underlying(underlying);
+}
+
+TypeId TypeTable::NewTypeParam(common::SymbolId name, int64 index) {
+    Type t;
+    t.Kind = KindTypeParam;
+    t.Name = name;
+    t.Len = index;
+    return Publish(t);
+}
+
+void TypeTable::SetConstraint(TypeId param, TypeId constraint) {
+    auto &rec = const_cast<Type &>(Get(param));
+    rec.Elems = Store(Key{KindTypeParam, false, 0, {&constraint, 1}, {}}).elems;
+}
+
+std::string TypeTable::String(TypeId t) const {
+    std::string s;
+    WriteTo(s, t);
+    return s;
+}
+
+void TypeTable::WriteTerms(std::string &s, std::span<const TypeId> terms) const {
+    for (size_t i = 0; i < terms.size(); i++) {
+        s += i > 0 ? " | " : "";
+        s += terms[i] & TildeTerm ? "~" : "";
+        WriteTo(s, TermType(terms[i]));
+    }
+}
+
+void TypeTable::WriteTo(std::string &s, TypeId t) const {
+    auto &typ = Get(t);
+    auto list = [&](std::span<const TypeId> l, bool variadic) {
+        for (size_t i = 0; i < l.size(); i++) {
+            if (i > 0) {
+                s += ", ";
+            }
+            if (variadic && i + 1 == l.size()) {
+                s += "...";
+                WriteTo(s, Get(l[i]).Elem());
+            } else {
+                WriteTo(s, l[i]);
+            }
+        }
+    };
+    switch (typ.Kind) {
+    case KindArray:
+        s += "[" + std::to_string(typ.Len) + "]";
+        WriteTo(s, typ.Elem());
+        break;
+    case KindSlice:
+        s += "[]";
+        WriteTo(s, typ.Elem());
+        break;
+    case KindPointer:
+        s += "*";
+        WriteTo(s, typ.Elem());
+        break;
+    case KindMap:
+        s += "map[";
+        WriteTo(s, typ.Key());
+        s += "]";
+        WriteTo(s, typ.Elem());
+        break;
+    case KindChan:
+        s += typ.Len == 2 ? "<-chan " : typ.Len == 1 ? "chan<- " : "chan ";
+        WriteTo(s, typ.Elem());
+        break;
+    case KindFunc: {
+        s += "func(";
+        list(typ.Params(), typ.Variadic);
+        s += ")";
+        auto results = typ.Results();
+        if (results.size() == 1) {
+            s += " ";
+            WriteTo(s, results[0]);
+        } else if (results.size() > 1) {
+            s += " (";
+            list(results, false);
+            s += ")";
+        }
+        break;
+    }
+    case KindInterface:
+        if (typ.Names.empty() && typ.Len > 0 && !typ.Variadic) {
+            // a constraint written as a union, e.g. ~int | string
+            WriteTerms(s, typ.Terms());
+            break;
+        }
+        [[fallthrough]];
+    case KindStruct:
+        s += typ.Kind == KindStruct ? "struct{" : "interface{";
+        for (size_t i = 0; i < typ.Names.size(); i++) {
+            if (i > 0) {
+                s += "; ";
+            }
+            if (typ.Kind == KindStruct && (typ.Names[i] & EmbeddedField)) {
+                WriteTo(s, typ.Elems[i]);
+                continue;
+            }
+            s += common::Interner::Global().Name(typ.Names[i]);
+            if (typ.Kind == KindStruct) {
+                s += " ";
+                WriteTo(s, typ.Elems[i]);
+            } else {
+                // drop the func keyword of the signature
+                s += String(typ.Elems[i]).substr(4);
+            }
+        }
+        if (typ.Kind == KindInterface) {
+            auto sep = typ.Names.empty() ? "" : "; ";
+            if (typ.Variadic) {
+                s += sep;
+                s += "comparable";
+                sep = "; ";
+            }
+            if (typ.Len > 0) {
+                s += sep;
+                WriteTerms(s, typ.Terms());
+            }
+        }
+        s += "}";
+        break;
+    case KindNamed:
+    case KindTypeParam:
+        s += common::Interner::Global().Name(typ.Name);
+        break;
+    default:
+        s += basicNames[typ.Kind];
+    }
+}
+
+} // namespace types
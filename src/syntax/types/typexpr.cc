@@ -0,0 +1,364 @@
+#include <optional>
+
+#include <fmt/format.h>
+
+#include "syntax/types/check.hh"
+
+namespace types {
+
+using Context = Checker::Context;
+
+namespace {
+
+// isConstraint reports whether t is an interface that restricts its type set
+// beyond its methods, which is only allowed as a constraint. The underlying
+// type of a named type declared later is not known yet.
+bool isConstraint(TypeId t) {
+    auto &table = TypeTable::Global();
+    auto u = table.Underlying(t);
+    return u != 0 && table.Kind(u) == KindInterface && (table[u].Len > 0 || table[u].Variadic);
+}
+
+// isTerm reports whether e is a union or a term ~T of a constraint.
+bool isTerm(ast::ExprNode *e) {
+    auto op = dyn_cast<ast::Operation>(e);
+    return op != nullptr && ((op->Op == Operator_Or && op->Y != nullptr) || (op->Op == Operator_Tilde && op->Y == nullptr));
+}
+
+// intersect returns the terms of the intersection of the type sets of the
+// union of terms a and of b.
+std::vector<TypeId> intersect(std::span<const TypeId> a, std::span<const TypeId> b) {
+    std::vector<TypeId> out;
+    for (auto x : a) {
+        for (auto y : b) {
+            if (TermSubset(x, y)) {
+                out.push_back(x);
+            } else if (TermSubset(y, x)) {
+                out.push_back(y);
+            }
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+// typExpr checks a type expression and returns its type, or 0 after
+// reporting an error. An interface with type constraints may only be used
+// as a constraint, or to declare one.
+TypeId Context::typExpr(ast::ExprNode *e, bool constraint) {
+    Operand x;
+    exprOrType(x, e);
+    switch (x.mode) {
+    case Mode::Invalid:
+        return 0;
+    case Mode::TypeExpr:
+        if (!constraint && isConstraint(x.type)) {
+            error(e, fmt::format("cannot use type {} outside a type constraint: interface contains type constraints",
+                                 ast::String(e)));
+            return 0;
+        }
+        return x.type;
+    case Mode::NoValue:
+        error(e, fmt::format("{} used as type", ast::String(e)));
+        return 0;
+    default:
+        error(e, fmt::format("{} is not a type", ast::String(e)));
+        return 0;
+    }
+}
+
+// under returns the underlying type of t. The underlying type of a named
+// type of the package that is declared later is resolved on demand. That of
+// a type parameter is its core type, if it has one.
+TypeId Context::under(TypeId t) {
+    if (t != 0 && table.Kind(t) == KindNamed && table.Underlying(t) == 0) {
+        if (auto it = check._type_names.find(t); it != check._type_names.end()) {
+            check.objDecl(*this, it->second);
+        }
+    }
+    if (t != 0 && table.Kind(t) == KindTypeParam) {
+        return coreType(t);
+    }
+    return table.Underlying(t);
+}
+
+// constraint checks the constraint of a type parameter: an interface, a
+// union of terms, or a type T that stands for interface{ T }.
+TypeId Context::constraint(ast::ExprNode *e) {
+    if (isTerm(e)) {
+        std::vector<TypeId> terms;
+        return typeTerms(e, terms) ? table.Interface({}, {}, terms) : 0;
+    }
+    auto t = typExpr(e, true);
+    if (t == 0 || table.Kind(under(t)) == KindInterface) {
+        return t;
+    }
+    if (table.Kind(t) == KindTypeParam) {
+        error(e, "cannot use a type parameter as constraint");
+        return 0;
+    }
+    return table.Interface({}, {}, {&t, 1});
+}
+
+// typeTerms appends the terms of the union e to terms. A term that is a
+// constraint without methods contributes its own terms.
+bool Context::typeTerms(ast::ExprNode *e, std::vector<TypeId> &terms) {
+    auto op = dyn_cast<ast::Operation>(e);
+    if (op != nullptr && op->Op == Operator_Or && op->Y != nullptr) {
+        bool ok = typeTerms(op->X.get(), terms);
+        return typeTerms(op->Y.get(), terms) && ok;
+    }
+    bool tilde = op != nullptr && op->Op == Operator_Tilde && op->Y == nullptr;
+    auto x = tilde ? op->X.get() : e;
+    auto t = typExpr(x, !tilde);
+    if (t == 0) {
+        return false;
+    }
+    if (table.Kind(t) == KindTypeParam) {
+        error(x, "term cannot be a type parameter");
+        return false;
+    }
+    if (tilde && under(t) != t) {
+        error(e, fmt::format("invalid use of ~ (underlying type of {} is {})", table.String(t),
+                             table.String(under(t))));
+        return false;
+    }
+    auto &u = table[under(t)];
+    if (!tilde && u.Kind == KindInterface && (u.Len > 0 || u.Variadic)) {
+        if (!u.Names.empty() || u.Variadic) {
+            error(x, fmt::format("cannot use {} in union ({} contains methods)", table.String(t), table.String(t)));
+            return false;
+        }
+        terms.insert(terms.end(), u.Terms().begin(), u.Terms().end());
+        return true;
+    }
+    terms.push_back(tilde ? t | TildeTerm : t);
+    return true;
+}
+
+TypeId Context::arrayLength(ast::ExprNode *e, TypeId elem) {
+    Operand x;
+    expr(x, e);
+    if (x.Invalid()) {
+        return 0;
+    }
+    if (x.mode != Mode::Constant) {
+        error(e, fmt::format("array length {} must be constant", describe(x)));
+        return 0;
+    }
+    // an untyped constant with an integer value is a valid length
+    auto v = x.val.ToInt();
+    if (!(IsInteger(x.type) || (IsUntyped(x.type) && v.IsKnown())) || (x.val.IsKnown() && !v.IsKnown())) {
+        error(e, fmt::format("array length {} must be integer", describe(x)));
+        return 0;
+    }
+    if (!v.IsKnown()) {
+        return 0; // reported by the constant expression
+    }
+    auto n = v.Int64Val();
+    if (!n || *n < 0) {
+        error(e, fmt::format("invalid array length {}", ast::String(e)));
+        return 0;
+    }
+    return elem == 0 ? 0 : table.Array(*n, elem);
+}
+
+// funcType returns the signature described by e. Parameters declared in a
+// list such as (a, b int) share their type expression, which is checked once.
+TypeId Context::funcType(ast::FuncType *e) {
+    std::vector<TypeId> params, results;
+    bool variadic = false, ok = true;
+    auto fields = [&](std::span<const ast::FieldPtr> list, std::vector<TypeId> &types, bool dots) {
+        ast::ExprNode *last = nullptr;
+        TypeId t = 0;
+        for (size_t i = 0; i < list.size(); i++) {
+            auto f = list[i].get();
+            if (f->Type.get() != last) {
+                last = f->Type.get();
+                if (auto d = dyn_cast<ast::DotsType>(last)) {
+                    auto elem = typExpr(d->Elem.get());
+                    if (!dots || i + 1 != list.size()) {
+                        error(d, "can only use ... with final parameter in list");
+                        ok = false;
+                    } else {
+                        variadic = true;
+                    }
+                    t = elem == 0 ? 0 : table.Slice(elem);
+                    d->SetType(t);
+                } else {
+                    t = typExpr(last);
+                }
+            }
+            ok = ok && t != 0;
+            types.push_back(t);
+        }
+    };
+    fields(e->ParamList, params, true);
+    fields(e->ResultList, results, false);
+    if (!ok) {
+        return 0;
+    }
+    auto t = table.Func(params, results, variadic);
+    e->SetType(t);
+    return t;
+}
+
+TypeId Context::structType(ast::StructType *e) {
+    std::vector<common::SymbolId> names;
+    std::vector<TypeId> fields;
+    std::unordered_map<common::SymbolId, bool> seen;
+    bool ok = true;
+    ast::ExprNode *last = nullptr;
+    TypeId t = 0;
+    for (auto &f : e->FieldList) {
+        if (f->Type.get() != last) {
+            last = f->Type.get();
+            t = typExpr(last);
+        }
+        ok = ok && t != 0;
+        common::SymbolId name;
+        ast::Node *at = f.get();
+        if (f->Name != nullptr) {
+            name = f->Name->Sym;
+            at = f->Name.get();
+        } else {
+            // the name of an embedded field T, *T or pkg.T is T
+            auto x = f->Type.get();
+            if (auto op = dyn_cast<ast::Operation>(x); op && op->Op == Operator_Mul && op->Y == nullptr) {
+                x = op->X.get();
+            }
+            if (auto s = dyn_cast<ast::SelectorExpr>(x)) {
+                x = s->Sel.get();
+            }
+            auto n = dyn_cast<ast::Name>(x);
+            if (n == nullptr) {
+                error(f->Type.get(), fmt::format("invalid embedded field type {}", ast::String(f->Type.get())));
+                ok = false;
+                continue;
+            }
+            name = n->Sym;
+            if (t != 0 && table.Kind(t) == KindPointer && table.Kind(table.Underlying(table[t].Elem())) == KindPointer) {
+                error(f->Type.get(), "embedded field type cannot be a pointer to a pointer");
+            }
+        }
+        if (common::Interner::Global().Name(name) != "_" && !seen.emplace(name, true).second) {
+            error(at, fmt::format("{} redeclared", common::Interner::Global().Name(name)));
+            ok = false;
+            continue;
+        }
+        names.push_back(f->Name != nullptr ? name : name | EmbeddedField);
+        fields.push_back(t);
+    }
+    return ok ? table.Struct(names, fields) : 0;
+}
+
+// interfaceType returns the interface type described by e, with the methods
+// of embedded interfaces included. The type set of a constraint is the
+// intersection of those of its embedded elements: unions, types and
+// constraints.
+TypeId Context::interfaceType(ast::InterfaceType *e) {
+    std::vector<common::SymbolId> names;
+    std::vector<TypeId> methods;
+    std::optional<std::vector<TypeId>> terms; // none: all types
+    bool comparable = false;
+    bool ok = true;
+    auto restrict = [&](std::span<const TypeId> t) {
+        terms = terms ? intersect(*terms, t) : std::vector<TypeId>(t.begin(), t.end());
+    };
+    auto add = [&](common::SymbolId name, TypeId sig, ast::Node *at, bool embedded) {
+        for (size_t i = 0; i < names.size(); i++) {
+            if (names[i] == name) {
+                // the same method may come from several embedded interfaces
+                if (!embedded || methods[i] != sig) {
+                    error(at, fmt::format("duplicate method {}", common::Interner::Global().Name(name)));
+                    ok = false;
+                }
+                return;
+            }
+        }
+        names.push_back(name);
+        methods.push_back(sig);
+    };
+    for (auto &f : e->MethodList) {
+        if (f->Name != nullptr) {
+            auto sig = funcType(cast<ast::FuncType>(f->Type.get()));
+            ok = ok && sig != 0;
+            add(f->Name->Sym, sig, f->Name.get(), false);
+            continue;
+        }
+        if (isTerm(f->Type.get())) {
+            std::vector<TypeId> union_;
+            ok = typeTerms(f->Type.get(), union_) && ok;
+            restrict(union_);
+            continue;
+        }
+        auto t = typExpr(f->Type.get(), true);
+        if (t == 0) {
+            ok = false;
+            continue;
+        }
+        if (table.Kind(t) == KindTypeParam) {
+            error(f->Type.get(), "cannot embed a type parameter");
+            ok = false;
+            continue;
+        }
+        auto u = under(t);
+        if (u == 0) {
+            ok = false; // a recursive embedding, reported by the declaration
+            continue;
+        }
+        if (table.Kind(u) != KindInterface) {
+            restrict({&t, 1}); // interface{ T } is a constraint on T
+            continue;
+        }
+        auto &iface = table[u];
+        for (size_t i = 0; i < iface.Names.size(); i++) {
+            add(iface.Names[i], iface.Elems[i], f->Type.get(), true);
+        }
+        if (iface.Len > 0) {
+            restrict(iface.Terms());
+        }
+        comparable = comparable || iface.Variadic;
+    }
+    if (!ok) {
+        return 0;
+    }
+    return table.Interface(names, methods, terms.value_or(std::vector<TypeId>{}), comparable);
+}
+
+// declareParams declares the receiver, parameters and results of a function
+// in the current scope.
+void Context::declareParams(ast::FuncType *e, ast::Field *recv, TypeId sig, TypeId recvType) {
+    if (recv != nullptr && recv->Name != nullptr) {
+        declare(newObject(ObjKind::Var, recv->Name.get(), recvType), recv->Name.get());
+    }
+    if (sig == 0) {
+        // declare the names anyway, to avoid follow-on errors
+        for (auto list : {&e->ParamList, &e->ResultList}) {
+            for (auto &f : *list) {
+                if (f->Name != nullptr) {
+                    declare(newObject(ObjKind::Var, f->Name.get(), 0), f->Name.get());
+                }
+            }
+        }
+        return;
+    }
+    auto &t = table[sig];
+    auto params = t.Params();
+    auto results = t.Results();
+    for (size_t i = 0; i < e->ParamList.size(); i++) {
+        if (auto &name = e->ParamList[i]->Name) {
+            declare(newObject(ObjKind::Var, name.get(), params[i]), name.get());
+        }
+    }
+    named_results = false;
+    for (size_t i = 0; i < e->ResultList.size(); i++) {
+        if (auto &name = e->ResultList[i]->Name) {
+            declare(newObject(ObjKind::Var, name.get(), results[i]), name.get());
+            named_results = true;
+        }
+    }
+}
+
+} // namespace types
@@ -0,0 +1,134 @@
+#include "syntax/types/scope.hh"
+
+#include <cassert>
+#include <deque>
+
+namespace types {
+
+Object *Scope::Insert(Object *obj) {
+    assert(!_frozen && "Insert into a frozen scope");
+    if (auto prev = LookupLocal(obj->Name)) {
+        return prev;
+    }
+    // keep the small array at most 3/4 and the table at most 1/2 full, so
+    // that a probe for a missing name ends soon
+    if (_table ? 2 * (_size + 1) > _mask + 1 : 4 * (_size + 1) > 3 * small_size) {
+        grow();
+    }
+    auto names = _table ? _table->names.get() : _names;
+    auto objs = _table ? _table->objs.get() : _objs;
+    auto mask = _table ? _mask : small_size - 1;
+    auto i = hash(obj->Name) & mask;
+    while (names[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    names[i] = obj->Name;
+    objs[i] = obj;
+    _size++;
+    return nullptr;
+}
+
+void Scope::grow() {
+    auto [names, objs, mask] = slots();
+    auto cap = _table ? 2 * (_mask + 1) : 4 * small_size;
+    auto table = std::make_unique<Table>();
+    table->names = std::make_unique<common::SymbolId[]>(cap);
+    table->objs = std::make_unique<Object *[]>(cap);
+    for (uint32_t j = 0; j <= mask; j++) {
+        if (names[j] != 0) {
+            auto i = hash(names[j]) & (cap - 1);
+            while (table->names[i] != 0) {
+                i = (i + 1) & (cap - 1);
+            }
+            table->names[i] = names[j];
+            table->objs[i] = objs[j];
+        }
+    }
+    _table = std::move(table);
+    _mask = cap - 1;
+}
+
+Object *Scope::Lookup(common::SymbolId name) const {
+    for (auto s = this; s != nullptr; s = s->_parent) {
+        if (auto obj = s->LookupLocal(name)) {
+            return obj;
+        }
+    }
+    return nullptr;
+}
+
+namespace {
+
+struct universe {
+    Scope scope;
+    std::deque<Object> objects;
+    TypeId error = 0;
+
+    Object *declare(ObjKind kind, std::string_view name, TypeId type) {
+        auto &obj = objects.emplace_back();
+        obj.Kind = kind;
+        obj.Name = common::Interner::Global().Intern(name);
+        obj.Type = type;
+        scope.Insert(&obj);
+        return &obj;
+    }
+
+    universe() {
+        auto &table = TypeTable::Global();
+        auto &interner = common::Interner::Global();
+
+        const char *basic[] = {
+            "bool",   "int",    "int8",    "int16",   "int32",   "int64",     "uint",       "uint8",  "uint16",
+            "uint32", "uint64", "uintptr", "float32", "float64", "complex64", "complex128", "string",
+        };
+        for (TypeId kind = KindBool; kind <= KindString; kind++) {
+            declare(ObjKind::TypeName, basic[kind - KindBool], kind);
+        }
+        declare(ObjKind::TypeName, "byte", KindUint8);
+        declare(ObjKind::TypeName, "rune", KindInt32);
+        declare(ObjKind::TypeName, "any", table.Interface({}, {}));
+        auto comparable = table.NewNamed(interner.Intern("comparable"));
+        table.SetUnderlying(comparable, table.Interface({}, {}, {}, true));
+        declare(ObjKind::TypeName, "comparable", comparable);
+
+        // type error interface { Error() string }
+        error = table.NewNamed(interner.Intern("error"));
+        TypeId str[] = {KindString};
+        common::SymbolId names[] = {interner.Intern("Error")};
+        TypeId methods[] = {table.Func({}, str)};
+        table.SetUnderlying(error, table.Interface(names, methods));
+        declare(ObjKind::TypeName, "error", error);
+
+        for (auto [name, val] : {std::pair{"false", false}, std::pair{"true", true}}) {
+            declare(ObjKind::Const, name, KindUntypedBool)->Val = Value::MakeBool(val);
+        }
+        declare(ObjKind::Const, "iota", KindUntypedInt);
+        declare(ObjKind::Nil, "nil", KindUntypedNil);
+
+        std::pair<const char *, BuiltinId> builtins[] = {
+            {"append", BuiltinId::Append},   {"cap", BuiltinId::Cap},         {"clear", BuiltinId::Clear},
+            {"close", BuiltinId::Close},     {"complex", BuiltinId::Complex}, {"copy", BuiltinId::Copy},
+            {"delete", BuiltinId::Delete},   {"imag", BuiltinId::Imag},       {"len", BuiltinId::Len},
+            {"make", BuiltinId::Make},       {"max", BuiltinId::Max},         {"min", BuiltinId::Min},
+            {"new", BuiltinId::New},         {"panic", BuiltinId::Panic},     {"print", BuiltinId::Print},
+            {"println", BuiltinId::Println}, {"real", BuiltinId::Real},       {"recover", BuiltinId::Recover},
+        };
+        for (auto [name, id] : builtins) {
+            declare(ObjKind::Builtin, name, 0)->Builtin = id;
+        }
+        scope.Freeze();
+    }
+};
+
+universe &theUniverse() {
+    static universe u;
+    return u;
+}
+
+} // namespace
+
+const Scope &Universe() { return theUniverse().scope; }
+
+TypeId ErrorType() { return theUniverse().error; }
+
+} // namespace types
@@ -0,0 +1,409 @@
+#include "build/build.hh"
+
+#include <gtest/gtest.h>
+#include <tbb/global_control.h>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+
+using namespace build;
+
+namespace {
+
+struct TempDir {
+    std::string path;
+    TempDir() {
+        char tmpl[] = "/tmp/build_test.XXXXXX";
+        path = mkdtemp(tmpl);
+    }
+    ~TempDir() { std::filesystem::remove_all(path); }
+
+    void write(const std::string &name, const std::string &src) {
+        auto file = std::filesystem::path(path) / name;
+        std::filesystem::create_directories(file.parent_path());
+        std::ofstream(file) << src;
+    }
+};
+
+// pkg writes a package with a function F that calls F of each import,
+// followed by body.
+void pkg(TempDir &dir, const std::string &path, std::vector<std::string> imports, const std::string &body = "") {
+    std::string src = "package " + path.substr(path.rfind('/') + 1) + "\n\n";
+    std::string calls;
+    for (auto &imp : imports) {
+        src += "import \"" + imp + "\"\n";
+        calls += "\t" + imp.substr(imp.rfind('/') + 1) + ".F()\n";
+    }
+    dir.write(path + "/a.go", src + "\nfunc F() {\n" + calls + body + "}\n");
+}
+
+std::vector<std::string> paths(const Graph &g) {
+    std::vector<std::string> out;
+    for (auto &p : g.Packages) {
+        out.push_back(p->Path);
+    }
+    return out;
+}
+
+} // namespace
+
+TEST(BuildTest, test_load) {
+    TempDir dir;
+    pkg(dir, "app", {"lib/a", "lib/b", "fmt"});
+    pkg(dir, "lib/a", {"lib/b"});
+    pkg(dir, "lib/b", {});
+    dir.write("lib/b/b_test.go", "package b\n\nimport \"app\"\n");
+    pkg(dir, "unused", {});
+
+    std::string roots[] = {"app", "missing"};
+    auto g = Load(dir.path, roots);
+    ASSERT_EQ(g.Errors.size(), 1u);
+    EXPECT_EQ(g.Errors[0], "package missing is not in " + dir.path);
+    EXPECT_EQ(paths(g), (std::vector<std::string>{"lib/b", "lib/a", "app"}));
+
+    auto &app = *g.Packages[2];
+    EXPECT_EQ(app.Imports, (std::vector<std::string>{"lib/a", "lib/b"})); // fmt is external
+    EXPECT_EQ(app.Deps.size(), 2u);
+    EXPECT_EQ(g.Packages[0]->Importers.size(), 2u);
+    EXPECT_EQ(g.Packages[0]->Files.size(), 1u);
+    // lib/b heads the critical path
+    EXPECT_EQ(g.Packages[0]->Priority, g.Packages[0]->Cost + g.Packages[1]->Cost + app.Cost);
+    EXPECT_EQ(g.Packages[1]->Priority, g.Packages[1]->Cost + app.Cost);
+}
+
+TEST(BuildTest, test_build_constraints) {
+    // the files of other platforms are left out, by their //go:build line or
+    // their name, so their declarations do not clash
+    TempDir dir;
+    dir.write("sys/sys_linux.go",
+              "//go:build linux\n\npackage sys\n\nimport \"lib\"\n\nconst Name = lib.Linux\n");
+    dir.write("sys/sys_other.go", "//go:build !linux\n\npackage sys\n\nconst Name = \"other\"\n");
+    dir.write("sys/page_amd64.go", "package sys\n\nconst Page = 4096\n");
+    dir.write("sys/page_arm64.go", "package sys\n\nconst Page = 16384\n");
+    dir.write("sys/ignore.go", "// +build ignore\n\npackage main\n");
+    pkg(dir, "lib", {}, "");
+    dir.write("lib/b.go", "package lib\n\nconst Linux = \"linux\"\n");
+    dir.write("only/a_windows.go", "package only\n");
+    dir.write("bad/a.go", "//go:build linux &&\n\npackage bad\n");
+
+    std::string roots[] = {"sys", "only", "bad"};
+    auto files = [&](const Package &pkg) {
+        std::vector<std::string> out;
+        for (auto &f : pkg.Files) {
+            out.push_back(std::filesystem::path(f).filename().string());
+        }
+        return out;
+    };
+    auto g = Load(dir.path, roots);
+    ASSERT_EQ(paths(g), (std::vector<std::string>{"bad", "lib", "only", "sys"}));
+    auto &sys = *g.Packages[3];
+    EXPECT_EQ(files(sys), (std::vector<std::string>{"page_amd64.go", "sys_linux.go"}));
+    EXPECT_EQ(sys.Imports, std::vector<std::string>{"lib"});
+    EXPECT_EQ(g.Packages[2]->Errors,
+              std::vector<std::string>{"build constraints exclude all Go files in " + dir.path + "/only"});
+    EXPECT_EQ(g.Packages[0]->Errors, std::vector<std::string>{dir.path + "/bad/a.go: parsing //go:build line: "
+                                                                          "unexpected end of expression"});
+    Build(g);
+    EXPECT_TRUE(sys.Errors.empty()) << sys.Errors[0];
+
+    Target darwin{"darwin", "arm64"};
+    g = Load(dir.path, roots, darwin);
+    ASSERT_EQ(paths(g), (std::vector<std::string>{"bad", "only", "sys"}));
+    EXPECT_EQ(files(*g.Packages[2]), (std::vector<std::string>{"page_arm64.go", "sys_other.go"}));
+    EXPECT_TRUE(g.Packages[2]->Imports.empty());
+    Build(g);
+    EXPECT_TRUE(g.Packages[2]->Errors.empty());
+}
+
+TEST(BuildTest, test_import_cycle) {
+    TempDir dir;
+    pkg(dir, "a", {"b"});
+    pkg(dir, "b", {"c"});
+    pkg(dir, "c", {"a", "d"});
+    pkg(dir, "d", {});
+    pkg(dir, "e", {"a"});
+
+    std::string roots[] = {"e"};
+    auto g = Load(dir.path, roots);
+    ASSERT_EQ(g.Errors.size(), 1u);
+    EXPECT_EQ(g.Errors[0], "import cycle not allowed: a -> b -> c -> a");
+    EXPECT_EQ(paths(g), (std::vector<std::string>{"d"}));
+    EXPECT_TRUE(g.Packages[0]->Importers.empty());
+    EXPECT_TRUE(Build(g));
+}
+
+TEST(BuildTest, test_build) {
+    TempDir dir;
+    pkg(dir, "app", {"bad", "good"});
+    pkg(dir, "bad", {}, "\tvar x int = \"s\"\n\t_ = x\n");
+    pkg(dir, "good", {"leaf"});
+    pkg(dir, "leaf", {});
+    dir.write("syntax/a.go", "package syntax\n\nfunc F( {}\n");
+    dir.write("empty/README", "");
+
+    std::string roots[] = {"app", "syntax", "empty"};
+    auto g = Load(dir.path, roots);
+    ASSERT_TRUE(g.Errors.empty());
+
+    // a package is compiled after all it imports are checked
+    std::mutex mu;
+    std::vector<std::string> compiled;
+    Options opts;
+    opts.Compile = [&](Package &p) {
+        for (auto d : p.Deps) {
+            EXPECT_NE(d->Types, nullptr);
+        }
+        std::lock_guard lock(mu);
+        compiled.push_back(p.Path);
+    };
+    EXPECT_FALSE(Build(g, opts));
+    std::sort(compiled.begin(), compiled.end());
+    EXPECT_EQ(compiled, (std::vector<std::string>{"good", "leaf"}));
+
+    std::map<std::string, Package *> byPath;
+    for (auto &p : g.Packages) {
+        byPath[p->Path] = p.get();
+    }
+    ASSERT_EQ(byPath["bad"]->Errors.size(), 1u);
+    EXPECT_EQ(byPath["bad"]->Errors[0],
+              dir.path + "/bad/a.go:5:14: cannot use \"s\" (untyped string constant) as int value in variable declaration");
+    EXPECT_TRUE(byPath["app"]->Skipped);
+    EXPECT_TRUE(byPath["app"]->Errors.empty());
+    ASSERT_FALSE(byPath["syntax"]->Errors.empty());
+    EXPECT_EQ(byPath["syntax"]->Errors[0].rfind(dir.path + "/syntax/a.go:3:", 0), 0u);
+    EXPECT_EQ(byPath["empty"]->Errors, (std::vector<std::string>{"no Go files in " + dir.path + "/empty"}));
+    EXPECT_NE(byPath["leaf"]->Types, nullptr);
+
+    // the files of the packages are released with them
+    auto pos = byPath["leaf"]->Syntax.at(0)->pos;
+    EXPECT_EQ(syntax::FileSet::Global().Resolve(pos).Filename, dir.path + "/leaf/a.go");
+    g = Graph{};
+    EXPECT_EQ(syntax::FileSet::Global().File(pos), nullptr);
+}
+
+TEST(BuildTest, test_critical_path_first) {
+    // on one thread, the head of the chain x <- y <- z goes before the
+    // bigger independent packages, which go before the cheap end of the
+    // chain
+    TempDir dir;
+    pkg(dir, "x", {});
+    pkg(dir, "y", {"x"});
+    pkg(dir, "z", {"y"});
+    std::string big(3000, ' ');
+    pkg(dir, "p", {}, big);
+    pkg(dir, "q", {}, big);
+
+    std::string roots[] = {"p", "q", "z"};
+    auto g = Load(dir.path, roots);
+    ASSERT_TRUE(g.Errors.empty());
+    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, 1);
+    std::vector<std::string> order;
+    Options opts;
+    opts.Compile = [&](Package &p) { order.push_back(p.Path); };
+    opts.ParallelBodies = false;
+    EXPECT_TRUE(Build(g, opts));
+    EXPECT_EQ(order, (std::vector<std::string>{"x", "y", "p", "q", "z"}));
+}
+
+TEST(BuildTest, test_export_data) {
+    // importers are checked against the export data written by the
+    // packages they import
+    TempDir dir, out;
+    dir.write("lib/a.go", "package lib\n\ntype T struct{ N int }\n\nfunc (t *T) Inc() { t.N++ }\n\n"
+                          "func New() *T { return &T{} }\n");
+    dir.write("app/a.go", "package app\n\nimport \"lib\"\n\nfunc F() int {\n\tt := lib.New()\n\tt.Inc()\n"
+                          "\treturn t.N\n}\n\nfunc G() string { return lib.New().N }\n");
+
+    std::string roots[] = {"app"};
+    auto g = Load(dir.path, roots);
+    Options opts;
+    opts.ExportDir = out.path;
+    EXPECT_FALSE(Build(g, opts));
+    EXPECT_TRUE(std::filesystem::exists(out.path + "/lib.x"));
+    EXPECT_FALSE(std::filesystem::exists(out.path + "/app.x"));
+    ASSERT_EQ(g.Packages[1]->Errors.size(), 1u);
+    EXPECT_EQ(g.Packages[1]->Errors[0], dir.path + "/app/a.go:11:35: cannot use lib.New().N (variable of type int) as "
+                                                   "string value in return statement");
+}
+
+TEST(BuildTest, test_inline) {
+    // the inlinable bodies of a package are exported with it
+    TempDir dir;
+    dir.write("lib/a.go", "package lib\n\ntype T struct{ n int }\n\nfunc (t *T) N() int { return t.n }\n");
+    dir.write("app/a.go", "package app\n\nimport \"lib\"\n\nfunc F(t *lib.T) int { return t.N() + 1 }\n");
+
+    std::string roots[] = {"app"};
+    for (int budget : {compile::InlineMaxBudget, 0}) {
+        auto g = Load(dir.path, roots);
+        Options opts;
+        opts.InlineBudget = budget;
+        ASSERT_TRUE(Build(g, opts));
+        auto &app = *g.Packages[1];
+        ASSERT_EQ(app.Inline != nullptr, budget > 0);
+        if (budget > 0) {
+            std::vector<std::string> got;
+            for (auto &d : app.Inline->Decisions()) {
+                got.push_back(d.Message());
+            }
+            EXPECT_EQ(got, (std::vector<std::string>{"can inline F with cost 11", "inlining call to (*lib.T).N"}));
+        }
+    }
+}
+
+TEST(BuildTest, test_generics) {
+    // a stencil needed by several packages is generated by one of them
+    TempDir dir;
+    dir.write("lib/a.go", "package lib\n\nfunc Max[T int | float64](a, b T) T {\n\tif a > b {\n\t\treturn a\n\t}\n"
+                          "\treturn b\n}\n");
+    for (auto name : {"x", "y"}) {
+        dir.write(std::string(name) + "/a.go", std::string("package ") + name +
+                                                   "\n\nimport \"lib\"\n\nvar M = lib.Max(1, 2) + int(lib.Max(1.5, 2))\n");
+    }
+
+    std::string roots[] = {"x", "y"};
+    auto g = Load(dir.path, roots);
+    ASSERT_TRUE(Build(g));
+    EXPECT_EQ(g.Instances->Size(), 2u);
+    std::map<std::string, std::set<std::string>> owners;
+    for (auto &p : g.Packages) {
+        for (auto &s : p->Stencil->Stencils()) {
+            owners[s->Name].insert(s->Owner);
+        }
+    }
+    ASSERT_EQ(owners.size(), 2u);
+    for (auto &[name, by] : owners) {
+        EXPECT_EQ(by.size(), 1u) << name;
+        EXPECT_TRUE(*by.begin() == "x" || *by.begin() == "y") << name;
+    }
+    EXPECT_TRUE(owners.count("lib.Max[go.shape.float64]"));
+}
+
+TEST(BuildTest, test_embed) {
+    // the files named by //go:embed are streamed to the data writer before
+    // Compile, in the order of Embeds
+    TempDir dir;
+    dir.write("embed/embed.go", "package embed\n\ntype FS struct{}\n");
+    dir.write("app/a.go", "package app\n\nimport \"embed\"\n\n//go:embed b.txt static\nvar assets embed.FS\n\n"
+                          "//go:embed a.txt\nvar a string\n");
+    dir.write("app/a.txt", "alpha");
+    dir.write("app/b.txt", "beta");
+    dir.write("app/static/c.css", "gamma");
+    dir.write("app/static/.d", "hidden");
+
+    std::string data;
+    Options opts;
+    opts.Data = [&](Package &pkg, std::string_view chunk) { data.append(chunk); };
+    opts.Compile = [&](Package &pkg) { pkg.Outputs.push_back(data); };
+    std::string roots[] = {"app"};
+    auto g = Load(dir.path, roots);
+    ASSERT_TRUE(Build(g, opts));
+    auto &app = *g.Packages[1];
+    std::vector<std::string> files;
+    for (auto &f : app.Embeds) {
+        files.push_back(f.Path.substr(app.Dir.size() + 1));
+        EXPECT_EQ(f.Hash.size(), 16u);
+    }
+    EXPECT_EQ(files, (std::vector<std::string>{"a.txt", "b.txt", "static/c.css"}));
+    EXPECT_EQ(app.Outputs, std::vector<std::string>{"alphabetagamma"});
+    EXPECT_TRUE(g.Packages[0]->Embeds.empty());
+
+    // the embedded files are part of the key
+    TempDir cache;
+    opts.CacheDir = cache.path;
+    auto build = [&](bool cached, const std::string &out, size_t embeds = 3) {
+        data.clear();
+        g = Load(dir.path, roots);
+        ASSERT_TRUE(Build(g, opts));
+        EXPECT_EQ(g.Packages[1]->Cached, cached);
+        EXPECT_EQ(g.Packages[1]->Outputs, std::vector<std::string>{out});
+        EXPECT_EQ(g.Packages[1]->Embeds.size(), embeds);
+    };
+    build(false, "alphabetagamma");
+    build(true, "alphabetagamma");
+    dir.write("app/static/c.css", "delta");
+    build(false, "alphabetadelta");
+    dir.write("app/static/.d", "ignored");
+    build(true, "alphabetadelta");
+    dir.write("app/static/e.css", "epsilon");
+    build(false, "alphabetadeltaepsilon", 4);
+    opts.CacheDir.clear();
+
+    // a pattern naming no file fails the package, as gc does
+    dir.write("app/a.go", "package app\n\nimport _ \"embed\"\n\n//go:embed *.png\nvar png []byte\n");
+    data.clear();
+    g = Load(dir.path, roots);
+    EXPECT_FALSE(Build(g, opts));
+    EXPECT_EQ(g.Packages[1]->Errors,
+              std::vector<std::string>{dir.path + "/app/a.go:6:5: pattern *.png: no matching files found"});
+    EXPECT_TRUE(g.Packages[1]->Outputs.empty());
+}
+
+TEST(BuildTest, test_cache) {
+    // a rebuild restores every package whose sources and imports are as
+    // they were; an edit that keeps the export data of a package keeps
+    // its importers cached
+    TempDir dir, cache;
+    auto lib = [&](const std::string &body) {
+        dir.write("lib/a.go", "package lib\n\ntype T struct{ N int }\n\nfunc New() *T {\n" + body + "}\n");
+    };
+    lib("\tt := &T{}\n\tswitch t.N {\n\tcase 1:\n\t}\n\treturn t\n");
+    dir.write("mid/a.go", "package mid\n\nimport \"lib\"\n\nfunc N() int { return lib.New().N }\n");
+    dir.write("app/a.go", "package app\n\nimport \"mid\"\n\nvar X = mid.N()\n");
+
+    std::atomic<int> compiled{0};
+    Options opts;
+    opts.CacheDir = cache.path;
+    opts.Flags = {"-O2"};
+    opts.Compile = [&](Package &pkg) {
+        compiled++;
+        pkg.Outputs = {"code of " + pkg.Path};
+    };
+    auto build = [&](std::vector<bool> cached) {
+        std::string roots[] = {"app"};
+        auto g = Load(dir.path, roots);
+        EXPECT_TRUE(Build(g, opts));
+        std::vector<bool> got;
+        for (auto &pkg : g.Packages) {
+            got.push_back(pkg->Cached);
+            EXPECT_EQ(pkg->Outputs, std::vector<std::string>{"code of " + pkg->Path});
+            EXPECT_EQ(pkg->Types == nullptr, pkg->Cached);
+        }
+        EXPECT_EQ(got, cached);
+    };
+
+    build({false, false, false});
+    EXPECT_EQ(compiled, 3);
+    build({true, true, true});
+    EXPECT_EQ(compiled, 3);
+
+    // another branch changes the body of lib.New only, which is not
+    // inlinable for its switch, so not exported
+    lib("\tt := &T{N: 1}\n\tswitch t.N {\n\tcase 1:\n\t}\n\treturn t\n");
+    build({false, true, true});
+    // back to the first branch
+    lib("\tt := &T{}\n\tswitch t.N {\n\tcase 1:\n\t}\n\treturn t\n");
+    build({true, true, true});
+    EXPECT_EQ(compiled, 4);
+
+    // the export data of lib changes, but not that of mid
+    dir.write("lib/b.go", "package lib\n\nvar V int\n");
+    build({false, false, true});
+    // so do the flags
+    opts.Flags = {"-O0"};
+    build({false, false, false});
+    EXPECT_EQ(compiled, 9);
+
+    // a failed package is not cached
+    dir.write("app/a.go", "package app\n\nimport \"mid\"\n\nvar X string = mid.N()\n");
+    for (int i = 0; i < 2; i++) {
+        std::string roots[] = {"app"};
+        auto g = Load(dir.path, roots);
+        EXPECT_FALSE(Build(g, opts));
+        EXPECT_TRUE(g.Packages[1]->Cached);
+        EXPECT_FALSE(g.Packages[2]->Cached);
+        EXPECT_EQ(g.Packages[2]->Errors.size(), 1u);
+    }
+}
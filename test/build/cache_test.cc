@@ -0,0 +1,124 @@
+#include "build/cache.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+using namespace build;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct TempDir {
+    std::string path;
+    TempDir() {
+        char tmpl[] = "/tmp/cache_test.XXXXXX";
+        path = mkdtemp(tmpl);
+    }
+    ~TempDir() { fs::remove_all(path); }
+};
+
+std::vector<std::string> files(const std::string &dir) {
+    std::vector<std::string> out;
+    for (auto &e : fs::recursive_directory_iterator(dir)) {
+        if (e.is_regular_file()) {
+            out.push_back(e.path().filename().string());
+        }
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+// age makes the files of dir written in the last minute look used the
+// given number of hours ago.
+void age(const std::string &dir, int hours) {
+    auto now = fs::file_time_type::clock::now();
+    for (auto &e : fs::recursive_directory_iterator(dir)) {
+        if (e.is_regular_file() && now - e.last_write_time() < std::chrono::minutes(1)) {
+            fs::last_write_time(e.path(), now - std::chrono::hours(hours));
+        }
+    }
+}
+
+} // namespace
+
+TEST(CacheTest, test_hasher) {
+    EXPECT_EQ(Hasher().Sum().size(), 16u);
+    EXPECT_EQ(Hasher().Add("ab").Add("c").Sum(), Hasher().Add("ab").Add("c").Sum());
+    EXPECT_NE(Hasher().Add("ab").Add("c").Sum(), Hasher().Add("a").Add("bc").Sum());
+    EXPECT_NE(Hasher().Add("").Sum(), Hasher().Sum());
+    EXPECT_EQ(Cache::ToolId(), Cache::ToolId());
+    EXPECT_NE(Cache::ToolId(), std::string(16, '\0'));
+}
+
+TEST(CacheTest, test_get_put) {
+    TempDir dir;
+    Cache cache(dir.path);
+    auto k1 = Hasher().Add("one").Sum(), k2 = Hasher().Add("two").Sum();
+    EXPECT_FALSE(cache.Get(k1));
+
+    std::string big(100000, 'x');
+    ASSERT_TRUE(cache.Put(k1, {"export", big, ""}));
+    ASSERT_TRUE(cache.Put(k2, {"export"}));
+    auto got = cache.Get(k1);
+    ASSERT_TRUE(got);
+    EXPECT_EQ(*got, (std::vector<std::string>{"export", big, ""}));
+    EXPECT_EQ(cache.Get(k2), (std::vector<std::string>{"export"}));
+    // the outputs of both actions are stored once
+    EXPECT_EQ(files(dir.path).size(), 5u);
+
+    // a fresh cache over the directory sees the entries
+    EXPECT_EQ(Cache(dir.path).Get(k1), got);
+}
+
+TEST(CacheTest, test_damaged) {
+    TempDir dir;
+    Cache cache(dir.path);
+    auto key = Hasher().Add("k").Sum();
+    ASSERT_TRUE(cache.Put(key, {"export", "object code"}));
+    std::string output;
+    for (auto &e : fs::recursive_directory_iterator(dir.path)) {
+        if (e.is_regular_file() && fs::file_size(e.path()) == 11) {
+            output = e.path();
+        }
+    }
+    // same size, other contents
+    std::ofstream(output, std::ios::binary | std::ios::trunc) << "object cod3";
+    EXPECT_FALSE(cache.Get(key));
+    EXPECT_FALSE(fs::exists(output));
+    // putting the action again repairs it
+    ASSERT_TRUE(cache.Put(key, {"export", "object code"}));
+    EXPECT_EQ(cache.Get(key), (std::vector<std::string>{"export", "object code"}));
+}
+
+TEST(CacheTest, test_trim) {
+    TempDir dir;
+    Cache cache(dir.path, 10000);
+    // four actions of 3054 bytes each, the first one the oldest
+    std::string keys[4];
+    for (int i = 0; i < 4; i++) {
+        keys[i] = Hasher().Add(uint64_t(i)).Sum();
+        ASSERT_TRUE(cache.Put(keys[i], {std::string(3000, char('a' + i))}));
+        age(dir.path, 10 - i);
+    }
+    std::ofstream(dir.path + "/stale.tmp") << "partial";
+    age(dir.path, 2);
+    // a hit marks the action used
+    ASSERT_TRUE(cache.Get(keys[0]));
+
+    // down to 9000 bytes: the second action goes, and a file of the third
+    EXPECT_LE(cache.Trim(), 9000u);
+    EXPECT_TRUE(cache.Get(keys[0]));
+    EXPECT_FALSE(cache.Get(keys[1]));
+    EXPECT_FALSE(cache.Get(keys[2]));
+    EXPECT_TRUE(cache.Get(keys[3]));
+    EXPECT_FALSE(fs::exists(dir.path + "/stale.tmp"));
+
+    // under the limit, nothing is removed
+    auto left = files(dir.path);
+    EXPECT_EQ(cache.Trim(), Cache(dir.path, 10000).Trim());
+    EXPECT_EQ(files(dir.path), left);
+}
@@ -0,0 +1,56 @@
+#include "build/constraint.hh"
+
+#include <gtest/gtest.h>
+
+using namespace build;
+
+namespace {
+
+// match returns whether the file is built for linux/amd64, or the error.
+std::string match(std::string_view name, std::string_view src, const Target &target = {}) {
+    std::string error;
+    auto ok = MatchFile(name, src, target, error);
+    return error.empty() ? (ok ? "yes" : "no") : error;
+}
+
+} // namespace
+
+TEST(ConstraintTest, test_file_names) {
+    EXPECT_EQ(match("a.go", ""), "yes");
+    EXPECT_EQ(match("a_linux.go", ""), "yes");
+    EXPECT_EQ(match("a_windows.go", ""), "no");
+    EXPECT_EQ(match("a_arm64.go", ""), "no");
+    EXPECT_EQ(match("a_linux_amd64.go", ""), "yes");
+    EXPECT_EQ(match("a_linux_arm64.go", ""), "no");
+    EXPECT_EQ(match("a_windows_test.go", ""), "no");
+    // a name that is only a suffix is not constrained
+    EXPECT_EQ(match("windows.go", ""), "yes");
+    EXPECT_EQ(match("a_unix.go", ""), "yes");
+    EXPECT_EQ(match("a_linux.go", "", Target{"android", "arm64"}), "yes");
+}
+
+TEST(ConstraintTest, test_go_build) {
+    EXPECT_EQ(match("a.go", "//go:build linux\n\npackage a\n"), "yes");
+    EXPECT_EQ(match("a.go", "// Copyright\n\n//go:build !linux\n\npackage a\n"), "no");
+    EXPECT_EQ(match("a.go", "//go:build (darwin || unix) && !386 && go1.18\npackage a\n"), "yes");
+    EXPECT_EQ(match("a.go", "//go:build go1.22 || cgo\n\npackage a\n"), "no");
+    EXPECT_EQ(match("a.go", "/* block\n*/\n//go:build windows\n\npackage a\n"), "no");
+    // only the header counts
+    EXPECT_EQ(match("a.go", "package a\n\n//go:build windows\n"), "yes");
+    // the //go:build line overrides the // +build lines
+    EXPECT_EQ(match("a.go", "//go:build linux\n// +build windows\n\npackage a\n"), "yes");
+
+    EXPECT_EQ(match("a.go", "//go:build linux &&\n\npackage a\n"),
+              "parsing //go:build line: unexpected end of expression");
+    EXPECT_EQ(match("a.go", "//go:build (linux\n\npackage a\n"), "parsing //go:build line: missing )");
+    EXPECT_EQ(match("a.go", "//go:build linux\n//go:build amd64\n\npackage a\n"), "multiple //go:build comments");
+}
+
+TEST(ConstraintTest, test_plus_build) {
+    EXPECT_EQ(match("a.go", "// +build linux darwin\n\npackage a\n"), "yes");
+    EXPECT_EQ(match("a.go", "// +build linux,386 darwin\n\npackage a\n"), "no");
+    EXPECT_EQ(match("a.go", "// +build !windows\n// +build amd64\n\npackage a\n"), "yes");
+    EXPECT_EQ(match("a.go", "// +build ignore\n\npackage main\n"), "no");
+    // not followed by a blank line, it is a doc comment
+    EXPECT_EQ(match("a.go", "// +build ignore\npackage main\n"), "yes");
+}
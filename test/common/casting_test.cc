@@ -0,0 +1,80 @@
+#include "common/casting.hh"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+// A hierarchy in the shape of ast::Node: Shape > {Circle, Polygon > {Triangle, Square}}.
+enum class Kind { Circle, Triangle, Square, FirstPolygon = Triangle, LastPolygon = Square };
+
+struct Shape {
+    const Kind kind;
+    explicit Shape(Kind k) : kind(k) {}
+    virtual ~Shape() = default;
+    static bool classof(const Shape *) { return true; }
+};
+
+struct Circle : Shape {
+    Circle() : Shape(Kind::Circle) {}
+    static bool classof(const Shape *s) { return s->kind == Kind::Circle; }
+};
+
+struct Polygon : Shape {
+    using Shape::Shape;
+    static bool classof(const Shape *s) { return s->kind >= Kind::FirstPolygon && s->kind <= Kind::LastPolygon; }
+};
+
+struct Triangle : Polygon {
+    Triangle() : Polygon(Kind::Triangle) {}
+    static bool classof(const Shape *s) { return s->kind == Kind::Triangle; }
+};
+
+struct Square : Polygon {
+    Square() : Polygon(Kind::Square) {}
+    static bool classof(const Shape *s) { return s->kind == Kind::Square; }
+};
+
+} // namespace
+
+TEST(CastingTest, test_isa) {
+    Square sq;
+    Shape *s = &sq;
+    EXPECT_TRUE(isa<Shape>(s));
+    EXPECT_TRUE(isa<Polygon>(s));
+    EXPECT_TRUE(isa<Square>(s));
+    EXPECT_FALSE(isa<Triangle>(s));
+    EXPECT_FALSE(isa<Circle>(s));
+    EXPECT_TRUE(isa<Polygon>(*s));
+
+    Shape *nil = nullptr;
+    EXPECT_FALSE(isa_and_nonnull<Shape>(nil));
+    EXPECT_TRUE(isa_and_nonnull<Square>(s));
+}
+
+TEST(CastingTest, test_cast) {
+    Triangle t;
+    Shape *s = &t;
+    const Shape *cs = &t;
+    EXPECT_EQ(cast<Triangle>(s), &t);
+    EXPECT_EQ(&cast<Polygon>(*s), &t);
+    static_assert(std::is_same_v<decltype(cast<Triangle>(cs)), const Triangle *>);
+    static_assert(std::is_same_v<decltype(dyn_cast<Triangle>(cs)), const Triangle *>);
+
+    EXPECT_EQ(dyn_cast<Polygon>(s), &t);
+    EXPECT_EQ(dyn_cast<Circle>(s), nullptr);
+    EXPECT_EQ(dyn_cast_or_null<Circle>((Shape *)nullptr), nullptr);
+}
+
+TEST(CastingTest, test_shared_ptr) {
+    std::shared_ptr<Shape> s = std::make_shared<Circle>();
+    std::shared_ptr<Circle> c = dyn_cast<Circle>(s);
+    ASSERT_NE(c, nullptr);
+    EXPECT_EQ(c.use_count(), 2);
+    EXPECT_EQ(dyn_cast<Polygon>(s), nullptr);
+    EXPECT_EQ(cast<Circle>(s), c);
+    EXPECT_TRUE(isa<Circle>(s));
+
+    std::shared_ptr<Shape> nil;
+    EXPECT_EQ(dyn_cast_or_null<Circle>(nil), nullptr);
+    EXPECT_FALSE(isa_and_nonnull<Circle>(nil));
+}
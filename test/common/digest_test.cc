@@ -0,0 +1,30 @@
+#include "common/digest.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace common;
+
+TEST(DigestTest, test_digest) {
+    // the XXH3-128 digest of no data, high half first
+    EXPECT_EQ(HexDigest(Digest("")), "99aa06d3014798d86001c324468d497f");
+    EXPECT_EQ(Digest("").size(), 16u);
+    EXPECT_NE(Digest("a"), Digest("b"));
+    EXPECT_EQ(HexDigest(std::string("\x00\x0f\xa0\xff", 4)), "000fa0ff");
+}
+
+TEST(DigestTest, test_state) {
+    std::string data(10000, 'x');
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = char(i * 31);
+    }
+    DigestState s;
+    for (size_t off = 0; off < data.size(); off += 999) {
+        s.Update(std::string_view(data).substr(off, 999));
+    }
+    EXPECT_EQ(s.Sum(), Digest(data));
+    // Sum does not end the digest
+    s.Update("more");
+    EXPECT_EQ(s.Sum(), Digest(data + "more"));
+}
@@ -0,0 +1,65 @@
+#include "common/interner.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace common;
+
+TEST(InternerTest, test_intern) {
+    Interner in;
+    EXPECT_EQ(in.Intern(""), 0u);
+    auto a = in.Intern("foo");
+    auto b = in.Intern("bar");
+    EXPECT_NE(a, b);
+    EXPECT_EQ(in.Intern(std::string("foo")), a);
+    EXPECT_EQ(in.Name(a), "foo");
+    EXPECT_EQ(in.Name(b), "bar");
+    EXPECT_EQ(in.Size(), 3u);
+
+    SymbolId id;
+    EXPECT_TRUE(in.Lookup("bar", id));
+    EXPECT_EQ(id, b);
+    EXPECT_FALSE(in.Lookup("baz", id));
+
+    // the stored copy does not alias the caller's buffer
+    std::string s = "transient";
+    auto c = in.Intern(s);
+    s.assign(s.size(), 'x');
+    EXPECT_EQ(in.Name(c), "transient");
+}
+
+TEST(InternerTest, test_concurrent_dense_ids) {
+    Interner in;
+    const int nthreads = 8;
+    const int nnames = 20000;
+    std::vector<std::vector<SymbolId>> ids(nthreads, std::vector<SymbolId>(nnames));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nthreads; t++) {
+        threads.emplace_back([&, t] {
+            // every thread interns the same names in a different order
+            for (int i = 0; i < nnames; i++) {
+                auto k = (i * 7919 + t * 104729) % nnames;
+                ids[t][k] = in.Intern("name" + std::to_string(k));
+            }
+        });
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+
+    EXPECT_EQ(in.Size(), size_t(nnames + 1));
+    std::vector<bool> seen(nnames + 1);
+    for (int k = 0; k < nnames; k++) {
+        for (int t = 1; t < nthreads; t++) {
+            ASSERT_EQ(ids[t][k], ids[0][k]);
+        }
+        auto id = ids[0][k];
+        ASSERT_LE(id, SymbolId(nnames));
+        EXPECT_FALSE(seen[id]);
+        seen[id] = true;
+        EXPECT_EQ(in.Name(id), "name" + std::to_string(k));
+    }
+}
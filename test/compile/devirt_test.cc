@@ -0,0 +1,292 @@
+#include "compile/devirt.hh"
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include <sstream>
+
+#include "syntax/ast/walk.hh"
+#include "syntax/parser.hh"
+
+using namespace compile;
+
+namespace {
+
+struct Package {
+    ast::FilePtr file;
+    types::Checker check;
+    Inliner inliner;
+    Devirtualizer devirt;
+
+    explicit Package(const std::string &src, types::Importer *importer = nullptr, const CallProfile *profile = nullptr)
+        : check(importer), inliner(check), devirt(check, "p", &inliner, profile) {
+        file = syntax::Parse(std::make_unique<std::istringstream>(src), [](uint line, uint col, std::string msg) {
+            FAIL() << line << ":" << col << ": " << msg;
+        });
+        ast::File *files[] = {file.get()};
+        for (auto &e : check.Check(files)) {
+            ADD_FAILURE() << e.Msg;
+        }
+        inliner.Analyze(files);
+        devirt.Analyze(files);
+    }
+
+    // messages returns the devirtualization decisions as "line: message".
+    std::vector<std::string> messages() const {
+        std::vector<std::string> out;
+        for (auto &d : devirt.Decisions()) {
+            out.push_back(fmt::format("{}: {}", syntax::FileSet::Global().Resolve(d.Pos).Line, d.Message()));
+        }
+        return out;
+    }
+
+    // call returns the n-th call in the function fn, in source order.
+    const ast::CallExpr *call(std::string_view fn, size_t n = 0) const {
+        for (auto &d : file->DeclList) {
+            auto f = dyn_cast<ast::FuncDecl>(d.get());
+            if (f == nullptr || f->Name->Value != fn) {
+                continue;
+            }
+            const ast::CallExpr *found = nullptr;
+            ast::Inspect(f->Body.get(), [&](ast::Node *node) {
+                if (auto c = dyn_cast<ast::CallExpr>(node); c != nullptr && found == nullptr && n-- == 0) {
+                    found = c;
+                }
+                return found == nullptr;
+            });
+            return found;
+        }
+        return nullptr;
+    }
+};
+
+using Messages = std::vector<std::string>;
+
+const char *shapes = R"(package p
+
+type Shape interface{ Area() int }
+
+type Square struct{ n int }
+
+func (s *Square) Area() int { return s.n * s.n }
+
+type Rect struct{ w, h int }
+
+func (r Rect) Area() int { return r.w * r.h }
+
+)";
+
+} // namespace
+
+TEST(DevirtTest, test_local_flow) {
+    Package p(shapes + std::string(R"(var global Shape = Rect{}
+
+func direct() int {
+	var s Shape = &Square{2}
+	return s.Area() + Shape(Rect{1, 2}).Area()
+}
+
+func same(big bool) int {
+	s := Shape(&Square{1})
+	if big {
+		s = &Square{3}
+	}
+	var t Shape
+	t = s
+	return t.Area()
+}
+
+func mixed(big bool) int {
+	var s Shape = &Square{1}
+	if big {
+		s = Rect{}
+	}
+	return s.Area()
+}
+
+func unknown(param Shape, xs []Shape) int {
+	n := param.Area() + global.Area()
+	for _, x := range xs {
+		n += x.Area()
+	}
+	var s Shape = Rect{}
+	reset(&s)
+	return n + s.Area()
+}
+
+func reset(s *Shape) { *s = nil }
+
+func spawned() {
+	var s Shape = &Square{}
+	defer s.Area()
+}
+)"));
+    EXPECT_EQ(p.messages(), (Messages{
+                                "17: devirtualizing s.Area to *Square",
+                                "17: devirtualizing Shape(Rect{1, 2}).Area to Rect",
+                                "27: devirtualizing t.Area to *Square",
+                                "52: devirtualizing s.Area to *Square",
+                            }));
+
+    // the direct calls are inlined, the receiver asserted to its dynamic
+    // type
+    auto d = p.devirt.Devirtualized(p.call("direct", 0));
+    ASSERT_NE(d, nullptr);
+    EXPECT_FALSE(d->Guarded);
+    EXPECT_EQ(types::TypeTable::Global().String(d->Type), "*Square");
+    auto inlined = p.inliner.Inlined(p.call("direct", 0));
+    ASSERT_NE(inlined, nullptr);
+    EXPECT_EQ(inlined->Callee, d->Method);
+    EXPECT_EQ(inlined->Assert, d->Type);
+    EXPECT_FALSE(inlined->DerefRecv);
+    auto rect = p.inliner.Inlined(p.call("direct", 1));
+    ASSERT_NE(rect, nullptr);
+    EXPECT_EQ(types::TypeTable::Global().String(rect->Assert), "Rect");
+
+    EXPECT_EQ(p.devirt.Devirtualized(p.call("mixed")), nullptr);
+    EXPECT_NE(p.devirt.Devirtualized(p.call("spawned", 0)), nullptr);
+    EXPECT_EQ(p.inliner.Inlined(p.call("spawned", 0)), nullptr);
+}
+
+TEST(DevirtTest, test_inlined) {
+    Package p(shapes + std::string(R"(func NewSquare(n int) Shape { return &Square{n} }
+
+func id(s Shape) Shape { return s }
+
+func area(s Shape) int { return s.Area() }
+
+func use() int {
+	s := NewSquare(2)
+	t := id(Rect{})
+	return s.Area() + t.Area() + area(&Square{1}) + area(Rect{})
+}
+)"));
+    EXPECT_EQ(p.messages(), (Messages{
+                                "22: devirtualizing s.Area to *Square",
+                                "22: devirtualizing t.Area to Rect",
+                                "22: devirtualizing s.Area to *Square",
+                                "22: devirtualizing s.Area to Rect",
+                            }));
+    // the call in the body of area is devirtualized per call site
+    auto body = p.call("area");
+    auto site = p.call("use", 4);
+    ASSERT_EQ(p.inliner.Inlined(site)->Callee->Name, common::Interner::Global().Intern("area"));
+    EXPECT_EQ(p.devirt.Devirtualized(body), nullptr);
+    auto d = p.devirt.Devirtualized(body, site);
+    ASSERT_NE(d, nullptr);
+    EXPECT_EQ(types::TypeTable::Global().String(d->Type), "*Square");
+}
+
+TEST(DevirtTest, test_inlined_statements) {
+    // a parameter the inlined body assigns does not keep the flow of its
+    // argument
+    Package p(shapes + std::string(R"(func twice(s Shape) int {
+	n := s.Area()
+	return n * 2
+}
+
+func swapped(s Shape, big bool) int {
+	if big {
+		s = Rect{}
+	}
+	return s.Area()
+}
+
+func use() int { return twice(&Square{2}) + swapped(&Square{3}, true) }
+)"));
+    EXPECT_EQ(p.messages(), Messages{"25: devirtualizing s.Area to *Square"});
+}
+
+TEST(DevirtTest, test_profile) {
+    std::string error;
+    EXPECT_FALSE(CallProfile::Parse("p.f 1 p.T.m\n", error));
+    EXPECT_EQ(error, "line 1: want \"caller offset callee count\"");
+    EXPECT_FALSE(CallProfile::Parse("# header\n\np.f x p.T.m 1\n", error));
+    EXPECT_EQ(error, "line 3: want \"caller offset callee count\"");
+
+    auto profile = CallProfile::Parse(R"(# caller offset callee count
+p.total 1 p.(*Square).Area 60
+p.total 1 p.Rect.Area 10
+p.total 1 p.(*Square).Area 30
+p.(*Group).Sum 1 p.Rect.Area 5
+p.(*Group).Sum 1 p.(*Square).Area 5
+p.Group.Sum 2 p.Rect.Area 5
+p.wrong 1 p.(*Square).Size 5
+)",
+                                      error);
+    ASSERT_TRUE(profile) << error;
+    EXPECT_EQ(profile->Size(), 4u);
+    auto callees = profile->Callees("p.total", 1);
+    ASSERT_EQ(callees.size(), 2u);
+    EXPECT_EQ(callees[0].Callee, "p.(*Square).Area");
+    EXPECT_EQ(callees[0].Count, 90u);
+
+    Package p(shapes + std::string(R"(type Group struct{ s Shape }
+
+func total(s Shape) int {
+	return s.Area()
+}
+
+func (g *Group) Sum() int {
+	return g.s.Area()
+}
+
+func wrong(s Shape) int {
+	return s.Area()
+}
+)"),
+              nullptr, &*profile);
+    EXPECT_EQ(p.messages(), (Messages{"16: PGO devirtualizing interface call s.Area to (*Square).Area"}));
+    auto d = p.devirt.Devirtualized(p.call("total"));
+    ASSERT_NE(d, nullptr);
+    EXPECT_TRUE(d->Guarded);
+    ASSERT_NE(p.inliner.Inlined(p.call("total")), nullptr);
+}
+
+TEST(DevirtTest, test_imported) {
+    types::DirImporter importer;
+    {
+        Package lib(R"(package io
+
+type Writer interface{ Write(p []byte) (int, error) }
+
+type Buffer struct{ buf []byte }
+
+func (b *Buffer) Write(p []byte) (int, error) { return len(p), nil }
+
+func (b *Buffer) Len() int { return len(b.buf) }
+
+type Discard struct{}
+
+func (Discard) Write(p []byte) (int, error) { return len(p), nil }
+
+func NewBuffer() Writer { return &Buffer{} }
+)",
+                    &importer);
+        auto bodies = lib.inliner.Exports();
+        ASSERT_TRUE(importer.Add("x/io", types::Export(lib.check, "x/io", &bodies)));
+    }
+    std::string error;
+    auto profile = CallProfile::Parse("p.copy 1 x/io.Discard.Write 80\np.copy 1 x/io.(*Buffer).Write 20\n", error);
+    ASSERT_TRUE(profile) << error;
+
+    Package p(R"(package p
+
+import "x/io"
+
+func copy(dst io.Writer, p []byte) {
+	dst.Write(p)
+}
+
+func pipeline(p []byte) {
+	w := io.NewBuffer()
+	w.Write(p)
+	copy(w, p)
+}
+)",
+              &importer, &*profile);
+    EXPECT_EQ(p.messages(), (Messages{
+                                "6: PGO devirtualizing interface call dst.Write to io.Discard.Write",
+                                "11: devirtualizing w.Write to *io.Buffer",
+                            }));
+}
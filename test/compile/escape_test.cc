@@ -0,0 +1,500 @@
+#include "compile/escape.hh"
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include <sstream>
+
+#include "syntax/parser.hh"
+#include "syntax/types/export.hh"
+
+using namespace compile;
+
+namespace {
+
+struct Package {
+    ast::FilePtr file;
+    types::Checker check;
+    EscapeAnalysis escape{check};
+    std::vector<EscapeDecision> decisions;
+
+    explicit Package(const std::string &src, bool explain = false, types::Importer *importer = nullptr)
+        : check(importer) {
+        file = syntax::Parse(std::make_unique<std::istringstream>(src), [](uint line, uint col, std::string msg) {
+            FAIL() << line << ":" << col << ": " << msg;
+        });
+        ast::File *files[] = {file.get()};
+        for (auto &e : check.Check(files)) {
+            ADD_FAILURE() << e.Msg;
+        }
+        decisions = escape.Analyze(files, explain);
+    }
+
+    // messages returns the decisions as "line: message".
+    std::vector<std::string> messages() const {
+        std::vector<std::string> out;
+        for (auto &d : decisions) {
+            out.push_back(fmt::format("{}: {}", syntax::FileSet::Global().Resolve(d.Pos).Line, d.Message()));
+        }
+        return out;
+    }
+
+    const types::Object *object(std::string_view name) const {
+        return check.PackageScope().LookupLocal(common::Interner::Global().Intern(name));
+    }
+};
+
+using Messages = std::vector<std::string>;
+
+} // namespace
+
+TEST(EscapeTest, test_locals) {
+    Package p(R"(package p
+
+type T struct{ a, b int }
+
+func local() int {
+	t := &T{1, 2}
+	x := 3
+	q := &x
+	return t.a + *q
+}
+
+func returned() *T {
+	t := T{}
+	return &t
+}
+
+func literal() *T { return &T{} }
+
+func fresh() *int { return new(int) }
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "6: &T{...} does not escape",
+                                "13: moved to heap: t",
+                                "17: &T{...} escapes to heap",
+                                "19: new(int) escapes to heap",
+                            }));
+}
+
+TEST(EscapeTest, test_slices_and_maps) {
+    Package p(R"(package p
+
+var sink []int
+
+func sum(n int) int {
+	s := []int{1, 2, 3}
+	buf := make([]byte, 64)
+	big := make([]byte, 1<<20)
+	dyn := make([]int, n)
+	m := map[string]int{"a": 1}
+	return s[0] + len(buf) + len(big) + len(dyn) + m["a"]
+}
+
+func keep() {
+	s := []int{1}
+	sink = s
+	var a [4]int
+	sink = a[:]
+}
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "6: []int{...} does not escape",
+                                "7: make([]byte, 64) does not escape",
+                                "8: make([]byte, 1 << 20) escapes to heap",
+                                "9: make([]int, n) escapes to heap",
+                                "10: map[string]int{...} does not escape",
+                                "15: []int{...} escapes to heap",
+                                "17: moved to heap: a",
+                            }));
+}
+
+TEST(EscapeTest, test_loops) {
+    Package p(R"(package p
+
+type T struct{ next *T }
+
+func list(n int) *T {
+	var head *T
+	for i := 0; i < n; i++ {
+		head = &T{head}
+	}
+	return head
+}
+
+func scratch(n int) int {
+	k := 0
+	for i := 0; i < n; i++ {
+		t := &T{}
+		if t.next == nil {
+			k++
+		}
+	}
+	return k
+}
+
+func back() {
+	var p *int
+again:
+	x := 0
+	p = &x
+	if *p == 0 {
+		goto again
+	}
+}
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "8: &T{...} escapes to heap",
+                                "16: &T{...} does not escape",
+                                "27: moved to heap: x",
+                            }));
+}
+
+TEST(EscapeTest, test_closures) {
+    Package p(R"(package p
+
+var sink func() int
+
+func called() int {
+	x := 1
+	f := func() int { return x }
+	return f()
+}
+
+func stored() {
+	y := 2
+	sink = func() int { return y }
+}
+
+func inner() {
+	var p *int
+	func() {
+		z := 3
+		p = &z
+	}()
+	_ = p
+}
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "7: func literal does not escape",
+                                // y is captured by value
+                                "13: func literal escapes to heap",
+                                "18: func literal does not escape",
+                                "19: moved to heap: z",
+                            }));
+}
+
+TEST(EscapeTest, test_captures) {
+    Package p(R"(package p
+
+var sink func() int
+
+func counter() {
+	n := 0
+	sink = func() int { n++; return n }
+}
+
+func straight(k int) {
+	m := k
+	m *= 2
+	sink = func() int { return m }
+}
+
+func after(k int) {
+	a := 0
+	sink = func() int { return a }
+	a = k
+}
+
+func loops(s []int) {
+	for _, v := range s {
+		sink = func() int { return v }
+	}
+	for i := 0; i < len(s); i++ {
+		sink = func() int { return i }
+	}
+}
+
+func addressed(k int) {
+	b := k
+	q := &b
+	sink = func() int { return *q + b }
+}
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "6: moved to heap: n",
+                                "7: func literal escapes to heap",
+                                // assigned before the closure is created
+                                "13: func literal escapes to heap",
+                                "17: moved to heap: a",
+                                "18: func literal escapes to heap",
+                                "22: leaking param content: s",
+                                "23: moved to heap: v",
+                                "24: func literal escapes to heap",
+                                "26: moved to heap: i",
+                                "27: func literal escapes to heap",
+                                "32: moved to heap: b",
+                                "34: func literal escapes to heap",
+                            }));
+}
+
+TEST(EscapeTest, test_self_assignment) {
+    Package p(R"(package p
+
+type Stack struct{ buf []*int }
+
+func (s *Stack) Pop() *int {
+	n := len(s.buf) - 1
+	x := s.buf[n]
+	s.buf = s.buf[:n]
+	return x
+}
+
+type Ring struct {
+	arr [4]*int
+	buf []*int
+}
+
+func (r *Ring) Reset() { r.buf = r.arr[:0] }
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "5: leaking param: s to result ~r0 level=2",
+                                // a slice of the array points into r itself
+                                "17: leaking param: r",
+                            }));
+}
+
+TEST(EscapeTest, test_params) {
+    Package p(R"(package p
+
+type T struct{ p *int }
+
+var sink *int
+
+func id(p *int) *int { return p }
+
+func leak(p *int) { sink = p }
+
+func content(t *T) { sink = t.p }
+
+func read(p *int) int { return *p }
+
+func (t *T) get() *int { return t.p }
+
+func count(n int) int { return n }
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "7: leaking param: p to result ~r0 level=0",
+                                "9: leaking param: p",
+                                "11: leaking param content: t",
+                                "13: p does not escape",
+                                "15: leaking param: t to result ~r0 level=1",
+                            }));
+    auto leaks = p.escape.Leaks(p.object("id"));
+    ASSERT_NE(leaks, nullptr);
+    ASSERT_EQ(leaks->size(), 1u);
+    EXPECT_EQ((*leaks)[0].Heap, -1);
+    EXPECT_EQ((*leaks)[0].Results, std::vector<int>{0});
+    EXPECT_EQ(p.escape.Leaks(p.object("sink")), nullptr);
+}
+
+TEST(EscapeTest, test_imported) {
+    types::DirImporter importer;
+    {
+        Package lib(R"(package lib
+
+type T struct{ p *int }
+
+var sink *int
+
+func Keep(p *int) { sink = p }
+
+func Get(t *T, p *int) (*int, *int) { return t.p, p }
+
+func (t *T) Set(p *int) { t.p = p }
+)");
+        auto leaks = lib.escape.Exports();
+        EXPECT_EQ(leaks.size(), 3u);
+        // for each parameter, the heap and then each result
+        EXPECT_EQ(leaks[lib.object("Get")], (std::vector<int32_t>{-1, 1, -1, -1, -1, 0}));
+        ASSERT_TRUE(importer.Add("x/lib", types::Export(lib.check, "x/lib", nullptr, &leaks)));
+    }
+
+    Package p(R"(package p
+
+import "x/lib"
+
+func use() *int {
+	a, b := 1, 2
+	lib.Keep(&a)
+	_, q := lib.Get(&lib.T{}, &b)
+	return q
+}
+
+func set() {
+	var t lib.T
+	c := 3
+	t.Set(&c)
+}
+
+func call(f func(*int)) {
+	d := 4
+	f(&d)
+}
+)",
+              false, &importer);
+    EXPECT_EQ(p.messages(), (Messages{
+                                "6: moved to heap: a",
+                                "6: moved to heap: b",
+                                // Get returns what its first parameter points to
+                                "8: &lib.T{...} does not escape",
+                                // Set stores its argument through its receiver
+                                "14: moved to heap: c",
+                                "18: f does not escape",
+                                "19: moved to heap: d",
+                            }));
+}
+
+TEST(EscapeTest, test_calls) {
+    Package p(R"(package p
+
+type T struct{ v int }
+
+var sink *T
+
+func id(t *T) *T { return t }
+func keep(t *T)  { sink = t }
+func use(t *T) int { return t.v }
+
+func caller() int {
+	a := &T{}
+	b := id(&T{})
+	keep(&T{})
+	return use(a) + b.v
+}
+
+func ret() *T { return id(&T{}) }
+
+// even and odd are analyzed together
+func even(t *T, n int) *T {
+	if n == 0 {
+		return t
+	}
+	return odd(t, n-1)
+}
+
+func odd(t *T, n int) *T { return even(t, n-1) }
+
+func rec() int { return even(&T{}, 4).v }
+
+func unknown(f func(*T)) { f(&T{}) }
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "7: leaking param: t to result ~r0 level=0",
+                                "8: leaking param: t",
+                                "9: t does not escape",
+                                "12: &T{...} does not escape",
+                                "13: &T{...} does not escape",
+                                "14: &T{...} escapes to heap",
+                                "18: &T{...} escapes to heap",
+                                // the recursive calls connect the results and parameters of both
+                                "21: leaking param: t",
+                                "28: leaking param: t",
+                                "30: &T{...} escapes to heap",
+                                "32: f does not escape",
+                                "32: &T{...} escapes to heap",
+                            }));
+}
+
+TEST(EscapeTest, test_interfaces) {
+    Package p(R"(package p
+
+type S struct{ a, b int }
+
+type I interface{ M() }
+
+func (s S) M() {}
+
+var sink any
+
+func box(n int) {
+	var x any = n
+	sink = S{1, n}
+	var y any = 7
+	_, _ = x, y
+}
+
+func dispatch(i I) { i.M() }
+
+func assert(i any) int {
+	switch v := i.(type) {
+	case *S:
+		return v.a
+	case int:
+		return v
+	}
+	return 0
+}
+
+func fail(msg string) { panic(msg) }
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "12: n does not escape",
+                                "13: S{1, n} escapes to heap",
+                                "18: leaking param: i",
+                                "20: i does not escape",
+                                "30: leaking param: msg",
+                                "30: msg escapes to heap",
+                            }));
+}
+
+TEST(EscapeTest, test_spawn) {
+    Package p(R"(package p
+
+type T struct{ v int }
+
+func work(t *T) int { return t.v }
+
+func spawn() {
+	go work(&T{})
+	defer work(&T{})
+	for i := 0; i < 3; i++ {
+		defer work(&T{})
+	}
+	ch := make(chan *T, 1)
+	ch <- &T{}
+}
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "5: t does not escape",
+                                "8: &T{...} escapes to heap",
+                                "9: &T{...} does not escape",
+                                "11: &T{...} escapes to heap",
+                                "14: &T{...} escapes to heap",
+                            }));
+}
+
+TEST(EscapeTest, test_explain) {
+    Package p(R"(package p
+
+type T struct{ v int }
+
+var sink *T
+
+func f() {
+	t := &T{}
+	u := t
+	sink = u
+}
+)",
+              true);
+    ASSERT_EQ(p.decisions.size(), 1u);
+    auto &d = p.decisions[0];
+    EXPECT_TRUE(d.Heap);
+    EXPECT_EQ(d.Explain, (std::vector<std::string>{
+                             "flow: t = &&T{...}: address-of at 8:7",
+                             "flow: u = t: assign at 9:4",
+                             "flow: {heap} = u: assign at 10:7",
+                         }));
+    EXPECT_TRUE(p.escape.OnHeap(d.Site));
+}
@@ -0,0 +1,452 @@
+#include "compile/inline.hh"
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <sstream>
+
+#include "syntax/ast/walk.hh"
+#include "syntax/parser.hh"
+
+using namespace compile;
+
+namespace {
+
+struct Package {
+    ast::FilePtr file;
+    types::Checker check;
+    Inliner inliner;
+
+    explicit Package(const std::string &src, types::Importer *importer = nullptr, int budget = InlineMaxBudget)
+        : check(importer), inliner(check, budget) {
+        file = syntax::Parse(std::make_unique<std::istringstream>(src), [](uint line, uint col, std::string msg) {
+            FAIL() << line << ":" << col << ": " << msg;
+        });
+        ast::File *files[] = {file.get()};
+        for (auto &e : check.Check(files)) {
+            ADD_FAILURE() << e.Msg;
+        }
+        inliner.Analyze(files);
+    }
+
+    // messages returns the decisions as "line: message".
+    std::vector<std::string> messages() const {
+        std::vector<std::string> out;
+        for (auto &d : inliner.Decisions()) {
+            out.push_back(fmt::format("{}: {}", syntax::FileSet::Global().Resolve(d.Pos).Line, d.Message()));
+        }
+        return out;
+    }
+
+    // call returns the n-th call in the function fn, in source order.
+    const ast::CallExpr *call(std::string_view fn, size_t n = 0) const {
+        for (auto &d : file->DeclList) {
+            auto f = dyn_cast<ast::FuncDecl>(d.get());
+            if (f == nullptr || f->Name->Value != fn) {
+                continue;
+            }
+            const ast::CallExpr *found = nullptr;
+            ast::Inspect(f->Body.get(), [&](ast::Node *node) {
+                if (auto c = dyn_cast<ast::CallExpr>(node); c != nullptr && found == nullptr && n-- == 0) {
+                    found = c;
+                }
+                return found == nullptr;
+            });
+            return found;
+        }
+        return nullptr;
+    }
+};
+
+using Messages = std::vector<std::string>;
+
+} // namespace
+
+TEST(InlineTest, test_costs) {
+    Package p(R"(package p
+
+type T struct{ x int }
+
+func (t *T) X() int { return t.x }
+
+func (t T) Double() int { return 2 * t.x }
+
+func add(a, b int) int { return a + b }
+
+func sum(t *T, n int) int { return add(t.X(), n) }
+
+func loop(n int) int {
+	k := 0
+	for i := 0; i < n; i++ {
+		k += i
+	}
+	return k
+}
+
+func fact(n int) int {
+	if n == 0 {
+		return 1
+	}
+	return n * fact(n-1)
+}
+
+func spawn() int {
+	go loop(1)
+	return 0
+}
+
+func many(a int) int { return loop(a) + loop(a+1) }
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "5: can inline (*T).X with cost 4",
+                                "7: can inline T.Double with cost 6",
+                                "9: can inline add with cost 4",
+                                // the calls to add and X are inlined into sum, at their costs
+                                "11: can inline sum with cost 16",
+                                "11: inlining call to add",
+                                "11: inlining call to (*T).X",
+                                "13: can inline loop with cost 18",
+                                "21: cannot inline fact: recursive",
+                                "28: cannot inline spawn: unhandled op GO",
+                                // the calls to loop are inlined, at its cost
+                                "33: can inline many with cost 46",
+                                "33: inlining call to loop",
+                                "33: inlining call to loop",
+                            }));
+}
+
+TEST(InlineTest, test_statement_bodies) {
+    // go build -gcflags=-m makes the same decisions; it also inlines sw,
+    // which costs what it costs in callsum
+    Package p(R"(package p
+
+type T struct{ x, y int }
+
+func (p *T) setX(v int) { p.x = v }
+
+func clamp(v, lo, hi int) int {
+	if v < lo {
+		return lo
+	} else if v > hi {
+		return hi
+	}
+	return v
+}
+
+func Use(p *T, v int) int {
+	p.setX(clamp(v, 0, 10))
+	p.y = clamp(v*2, -5, 5)
+	return p.x + p.y
+}
+
+func Named(a int) (r int) {
+	var b = a * 2
+	r = b
+	return
+}
+
+func swap(a, b int) (int, int) { return b, a }
+
+func Incr(p *int) { *p++ }
+
+func sum(s []int) int {
+	t := 0
+	for _, x := range s {
+		t += x
+	}
+	return t
+}
+
+func sw(x int) int {
+	switch x {
+	case 1:
+		return 2
+	}
+	return 3
+}
+
+func callsum(s []int) int { return sum(s) + sw(1) }
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "5: can inline (*T).setX with cost 5",
+                                "7: can inline clamp with cost 16",
+                                "16: can inline Use with cost 67",
+                                "17: inlining call to (*T).setX",
+                                "17: inlining call to clamp",
+                                "18: inlining call to clamp",
+                                "22: can inline Named with cost 10",
+                                "28: can inline swap with cost 4",
+                                "30: can inline Incr with cost 3",
+                                "32: can inline sum with cost 15",
+                                "40: cannot inline sw: unhandled op SWITCH",
+                                "48: can inline callsum with cost 31",
+                                "48: inlining call to sum",
+                            }));
+    auto set = p.inliner.Inlined(p.call("Use", 0));
+    ASSERT_NE(set, nullptr);
+    EXPECT_EQ(set->Body->Result, nullptr);
+    EXPECT_EQ(set->Body->Params.size(), 2u);
+    EXPECT_TRUE(set->Body->Results.empty());
+    EXPECT_EQ(ast::String(set->Args[1]), "clamp(v, 0, 10)");
+
+    // the statements are exported, and inlined by importers
+    auto bodies = p.inliner.Exports();
+    auto clamp = std::find_if(bodies.begin(), bodies.end(), [](auto &b) { return b.first->Decl != nullptr &&
+        cast<ast::FuncDecl>(b.first->Decl)->Name->Value == "clamp"; });
+    ASSERT_NE(clamp, bodies.end());
+    EXPECT_EQ(clamp->second, R"(package p
+
+
+func _(v int, lo int, hi int) (_ int) {
+	if v < lo {
+		return lo
+	} else if v > hi {
+		return hi
+	}
+	return v
+}
+)");
+    types::DirImporter importer;
+    ASSERT_TRUE(importer.Add("x/p", types::Export(p.check, "x/p", &bodies)));
+    Package q(R"(package q
+
+import "x/p"
+
+func f(t *p.T, n *int) (int, int) {
+	p.Incr(n)
+	return p.Named(*n), p.Use(t, 3)
+}
+)",
+              &importer);
+    EXPECT_EQ(q.messages(), (Messages{
+                                "5: cannot inline f: function too complex: cost 100 exceeds budget 80",
+                                "6: inlining call to p.Incr",
+                                "7: inlining call to p.Named",
+                                "7: inlining call to p.Use",
+                            }));
+    // the calls in the imported body of Use are planned too
+    auto use = q.inliner.Inlined(q.call("f", 2));
+    ASSERT_NE(use, nullptr);
+    auto stmt = cast<ast::ExprStmt>(use->Body->Decl->Body->List[0].get());
+    auto setX = q.inliner.Inlined(cast<ast::CallExpr>(stmt->X.get()));
+    ASSERT_NE(setX, nullptr);
+    EXPECT_NE(q.inliner.Inlined(cast<ast::CallExpr>(setX->Args[1])), nullptr);
+}
+
+TEST(InlineTest, test_plan) {
+    Package p(R"(package p
+
+type T struct{ x int }
+
+func (t *T) X() int { return t.x }
+
+func (t T) Y() int { return t.x }
+
+func twice(n int) int { return n + n }
+
+func f(t T, p *T) int {
+	defer twice(1)
+	return t.X() + p.Y() + twice(p.x) + (*T).X(p)
+}
+)");
+    auto x = p.inliner.Inlined(p.call("f", 1));
+    ASSERT_NE(x, nullptr);
+    EXPECT_EQ(x->Body, p.inliner.Body(x->Callee));
+    EXPECT_EQ(ast::String(x->Body->Result), "t.x");
+    ASSERT_EQ(x->Args.size(), 1u);
+    EXPECT_EQ(ast::String(x->Args[0]), "t");
+    EXPECT_TRUE(x->AddrRecv);
+    EXPECT_FALSE(x->DerefRecv);
+
+    auto y = p.inliner.Inlined(p.call("f", 2));
+    ASSERT_NE(y, nullptr);
+    EXPECT_TRUE(y->DerefRecv);
+
+    auto twice = p.inliner.Inlined(p.call("f", 3));
+    ASSERT_NE(twice, nullptr);
+    ASSERT_EQ(twice->Args.size(), 1u);
+    EXPECT_EQ(ast::String(twice->Args[0]), "p.x");
+    ASSERT_EQ(twice->Body->Params.size(), 1u);
+    EXPECT_NE(twice->Body->Params[0], nullptr);
+
+    // a method expression takes the receiver as its first argument
+    auto expr = p.inliner.Inlined(p.call("f", 4));
+    ASSERT_NE(expr, nullptr);
+    EXPECT_EQ(ast::String(expr->Args[0]), "p");
+
+    // the deferred call runs later
+    EXPECT_EQ(p.inliner.Inlined(p.call("f", 0)), nullptr);
+}
+
+TEST(InlineTest, test_disabled) {
+    Package p(R"(package p
+
+func one() int { return 1 }
+
+func two() int { return one() + one() }
+)",
+              nullptr, 0);
+    EXPECT_EQ(p.messages(), Messages{});
+    EXPECT_EQ(p.inliner.Inlined(p.call("two")), nullptr);
+    EXPECT_TRUE(p.inliner.Exports().empty());
+}
+
+TEST(InlineTest, test_imported) {
+    types::DirImporter importer;
+    {
+        Package strings(R"(package strings
+
+func HasPrefix(s, prefix string) bool { return len(s) >= len(prefix) && s[0:len(prefix)] == prefix }
+)",
+                        &importer);
+        ASSERT_TRUE(importer.Add("strings", types::Export(strings.check, "strings")));
+    }
+    {
+        Package lib(R"(package lib
+
+import "strings"
+
+type Req struct {
+	method string
+	path   string
+}
+
+var prefix = "/api"
+
+func (r *Req) Method() string { return r.method }
+
+func (r *Req) API() bool { return strings.HasPrefix(r.path, prefix) }
+
+func (r *Req) IsGet() bool { return r.Method() == "GET" }
+
+func New(m string) *Req { return &Req{method: m} }
+
+func Loop(n int) int {
+	for n > 0 {
+		n--
+	}
+	return n
+}
+)",
+                    &importer);
+        auto bodies = lib.inliner.Exports();
+        EXPECT_EQ(bodies.size(), 5u);
+        ASSERT_TRUE(importer.Add("x/lib", types::Export(lib.check, "x/lib", &bodies)));
+    }
+
+    Package p(R"(package p
+
+import "x/lib"
+
+func get(r *lib.Req) bool { return r.IsGet() }
+
+func handle() bool {
+	r := lib.New("GET")
+	return get(r) && r.API() && lib.Loop(3) == 0
+}
+)",
+              &importer);
+    EXPECT_EQ(p.messages(), (Messages{
+                                // IsGet costs 11: its call to Method is inlined too
+                                "5: can inline get with cost 16",
+                                "5: inlining call to (*lib.Req).IsGet",
+                                "7: cannot inline handle: function too complex: cost 122 exceeds budget 80",
+                                "8: inlining call to lib.New",
+                                "9: inlining call to get",
+                                "9: inlining call to (*lib.Req).API",
+                                "9: inlining call to lib.Loop",
+                            }));
+    // the call to Method in the body of IsGet is planned too
+    auto isGet = p.inliner.Inlined(p.call("get"));
+    ASSERT_NE(isGet, nullptr);
+    auto inner = dyn_cast<ast::Operation>(isGet->Body->Result);
+    ASSERT_NE(inner, nullptr);
+    auto method = p.inliner.Inlined(cast<ast::CallExpr>(inner->X.get()));
+    ASSERT_NE(method, nullptr);
+    EXPECT_EQ(ast::String(method->Body->Result), "r.method");
+}
+
+TEST(InlineTest, test_loops_and_variadic) {
+    Package p(R"(package p
+
+func Max(x int, ys ...int) int {
+	for _, y := range ys {
+		if y > x {
+			x = y
+		}
+	}
+	return x
+}
+
+func Index(s []int, v int) int {
+	for i := 0; i < len(s); i++ {
+		if s[i] != v {
+			continue
+		}
+		return i
+	}
+	return -1
+}
+
+func f(s []int) int {
+	return Max(1) + Max(1, 2, 3) + Max(0, s...)
+}
+)");
+    EXPECT_EQ(p.messages(), (Messages{
+                                "3: can inline Max with cost 17",
+                                "12: can inline Index with cost 25",
+                                "22: can inline f with cost 66",
+                                "23: inlining call to Max",
+                                "23: inlining call to Max",
+                                "23: inlining call to Max",
+                            }));
+
+    // the arguments of the variadic parameter are packed, unless passed
+    // with ...
+    auto none = p.inliner.Inlined(p.call("f", 0));
+    ASSERT_NE(none, nullptr);
+    ASSERT_EQ(none->Args.size(), 2u);
+    EXPECT_EQ(none->Args[1], nullptr);
+    EXPECT_TRUE(none->Packed.empty());
+    auto two = p.inliner.Inlined(p.call("f", 1));
+    ASSERT_NE(two, nullptr);
+    ASSERT_EQ(two->Packed.size(), 2u);
+    EXPECT_EQ(ast::String(two->Packed[1]), "3");
+    auto dots = p.inliner.Inlined(p.call("f", 2));
+    ASSERT_NE(dots, nullptr);
+    EXPECT_EQ(ast::String(dots->Args[1]), "s");
+    EXPECT_TRUE(dots->Packed.empty());
+
+    auto bodies = p.inliner.Exports();
+    auto index = std::find_if(bodies.begin(), bodies.end(), [](auto &b) { return b.first->Decl != nullptr &&
+        cast<ast::FuncDecl>(b.first->Decl)->Name->Value == "Index"; });
+    ASSERT_NE(index, bodies.end());
+    EXPECT_EQ(index->second, R"(package p
+
+
+func _(s []int, v int) (_ int) {
+	for i := 0; i < len(s); i++ {
+		if s[i] != v {
+			continue
+		}
+		return i
+	}
+	return -1
+}
+)");
+    types::DirImporter importer;
+    ASSERT_TRUE(importer.Add("x/p", types::Export(p.check, "x/p", &bodies)));
+    Package q(R"(package q
+
+import "x/p"
+
+func g(s []int) int { return p.Max(p.Index(s, 3), s...) }
+)",
+              &importer);
+    EXPECT_EQ(q.messages(), (Messages{
+                                "5: can inline g with cost 54",
+                                "5: inlining call to p.Max",
+                                "5: inlining call to p.Index",
+                            }));
+}
@@ -0,0 +1,263 @@
+#include "compile/stencil.hh"
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include <sstream>
+
+#include "syntax/parser.hh"
+
+using namespace compile;
+
+namespace {
+
+struct Package {
+    ast::FilePtr file;
+    types::Checker check;
+    Stenciler stenciler;
+
+    explicit Package(const std::string &src, types::Importer *importer = nullptr, const std::string &path = "p",
+                     InstanceCache *cache = nullptr)
+        : check(importer), stenciler(check, path, cache) {
+        file = syntax::Parse(std::make_unique<std::istringstream>(src), [](uint line, uint col, std::string msg) {
+            FAIL() << line << ":" << col << ": " << msg;
+        });
+        ast::File *files[] = {file.get()};
+        for (auto &e : check.Check(files)) {
+            ADD_FAILURE() << e.Msg;
+        }
+        stenciler.Analyze(files);
+    }
+
+    // messages returns the reports as "line: message".
+    std::vector<std::string> messages() const {
+        std::vector<std::string> out;
+        for (auto &r : stenciler.Reports()) {
+            out.push_back(fmt::format("{}: {}", syntax::FileSet::Global().Resolve(r.Pos).Line, r.Message()));
+        }
+        return out;
+    }
+
+    types::Object *lookup(std::string_view name) const {
+        return check.PackageScope().LookupLocal(common::Interner::Global().Intern(name));
+    }
+
+    // dict returns the dictionary named name.
+    const Dictionary *dict(std::string_view name) const {
+        for (auto &d : stenciler.Dictionaries()) {
+            if (d->Name == name) {
+                return d.get();
+            }
+        }
+        return nullptr;
+    }
+};
+
+// entries formats the entries of a dictionary or layout.
+std::vector<std::string> entries(std::span<const DictEntry> list) {
+    auto &table = types::TypeTable::Global();
+    std::vector<std::string> out;
+    for (auto &e : list) {
+        switch (e.kind) {
+        case DictEntry::TypeDesc:
+            out.push_back("type " + table.String(e.Type));
+            break;
+        case DictEntry::Method:
+            out.push_back(fmt::format("method {}.{}", table.String(e.Type), e.Name));
+            break;
+        case DictEntry::Itab:
+            out.push_back(fmt::format("itab {}, {}", table.String(e.Type), table.String(e.Iface)));
+            break;
+        case DictEntry::SubDict: {
+            std::string targs;
+            for (auto t : e.TypeArgs) {
+                targs += (targs.empty() ? "" : ",") + table.String(t);
+            }
+            out.push_back(fmt::format("dict {}[{}] {}", common::Interner::Global().Name(e.Callee->Name), targs,
+                                      e.Name));
+            break;
+        }
+        }
+    }
+    return out;
+}
+
+using Strings = std::vector<std::string>;
+
+const char *libSrc = R"(package lib
+
+type Stringer interface{ String() string }
+
+func Map[T, R any](xs []T, f func(T) R) []R {
+	out := make([]R, 0, len(xs))
+	for _, x := range xs {
+		out = append(out, f(x))
+	}
+	return out
+}
+
+func Strings[T Stringer](xs []T) []string {
+	return Map(xs, func(x T) string { return x.String() })
+}
+
+func Box[T any](x T) any { return x }
+
+func Show[T Stringer](x T) Stringer { return x }
+)";
+
+} // namespace
+
+TEST(StencilTest, test_shapes) {
+    Package p(R"(package p
+
+type MyInt int
+
+type T struct{ x int }
+
+var (
+	a int
+	b MyInt
+	c *T
+	d map[string]int
+	e chan int
+	f func()
+	g T
+	h []int
+)
+)");
+    auto shape = [&](std::string_view name) {
+        return types::TypeTable::Global().String(ShapeOf(p.lookup(name)->Type));
+    };
+    EXPECT_EQ(shape("a"), "int");
+    EXPECT_EQ(shape("b"), "int");
+    for (auto name : {"c", "d", "e", "f"}) {
+        EXPECT_EQ(shape(name), "*uint8") << name;
+    }
+    EXPECT_EQ(shape("g"), "struct{x int}");
+    EXPECT_EQ(shape("h"), "[]int");
+}
+
+TEST(StencilTest, test_plan) {
+    Package p(R"(package p
+
+type MyInt int
+
+func (m MyInt) String() string { return "" }
+
+type Stringer interface{ String() string }
+
+type Node struct{ next *Node }
+
+func Max[T int | MyInt | float64](a, b T) T {
+	if a > b {
+		return a
+	}
+	return b
+}
+
+func First[T any](xs []T) T { return xs[0] }
+
+func Names[T Stringer](xs []T) []string {
+	out := make([]string, 0, len(xs))
+	for _, x := range xs {
+		out = append(out, x.String())
+	}
+	var s Stringer = Stringer(xs[0])
+	_ = s
+	return append(out, Name(xs[0]))
+}
+
+func Name[T Stringer](x T) string { return x.String() }
+
+func use() {
+	_ = Max(1, 2)
+	_ = Max[MyInt](1, 2)
+	_ = Max(1.5, 2)
+	_ = First([]*Node{})
+	_ = First([]map[string]int{})
+	_ = First([]chan int{})
+	_ = Names([]MyInt{})
+}
+)");
+    EXPECT_EQ(p.messages(), (Strings{
+                                "33: instantiating Max[int] with new stencil p.Max[go.shape.int]",
+                                "34: instantiating Max[MyInt] with stencil p.Max[go.shape.int]",
+                                "35: instantiating Max[float64] with new stencil p.Max[go.shape.float64]",
+                                "36: instantiating First[*Node] with new stencil p.First[go.shape.*uint8]",
+                                "37: instantiating First[map[string]int] with stencil p.First[go.shape.*uint8]",
+                                "38: instantiating First[chan int] with stencil p.First[go.shape.*uint8]",
+                                "39: instantiating Names[MyInt] with new stencil p.Names[go.shape.int]",
+                            }));
+    // seven instances need four stencils, and one more for the call in
+    // the body of Names
+    ASSERT_EQ(p.stenciler.Stencils().size(), 5u);
+    EXPECT_EQ(p.stenciler.Stencils()[4]->Name, "p.Name[go.shape.int]");
+
+    auto names = p.stenciler.Generic(p.lookup("Names"));
+    ASSERT_NE(names, nullptr);
+    EXPECT_EQ(names->Name, "p.Names");
+    EXPECT_EQ(entries(names->Layout), (Strings{"type T", "method T.String", "itab T, Stringer", "dict Name[T] "}));
+    auto dict = p.dict("p.Names[p.MyInt]");
+    ASSERT_NE(dict, nullptr);
+    EXPECT_EQ(dict->Code->Name, "p.Names[go.shape.int]");
+    EXPECT_EQ(entries(dict->Entries), (Strings{"type MyInt", "method MyInt.String", "itab MyInt, Stringer",
+                                               "dict Name[MyInt] p.Name[p.MyInt]"}));
+    EXPECT_NE(p.dict("p.Name[p.MyInt]"), nullptr);
+    EXPECT_EQ(p.stenciler.Generic(p.lookup("use")), nullptr);
+}
+
+TEST(StencilTest, test_imported) {
+    // the layouts are exported, and the stencils of a build are generated
+    // once
+    types::DirImporter importer;
+    InstanceCache cache;
+    {
+        Package lib(libSrc, &importer, "x/lib", &cache);
+        auto layouts = lib.stenciler.Exports();
+        EXPECT_EQ(layouts.size(), 4u);
+        EXPECT_EQ(layouts[lib.lookup("Box")], "package lib\n\n\nfunc _[T any](T) {}\n\n//dict type 0\n");
+        ASSERT_TRUE(importer.Add("x/lib", types::Export(lib.check, "x/lib", &layouts)));
+    }
+
+    auto src = [](const std::string &name) {
+        return "package " + name + R"(
+
+import "x/lib"
+
+type Name string
+
+func (n Name) String() string { return string(n) }
+
+func F(xs []Name) []string {
+	_ = lib.Box(1)
+	_ = lib.Show[*Name](nil)
+	return lib.Strings(xs)
+}
+)";
+    };
+    Package a(src("a"), &importer, "a", &cache);
+    EXPECT_EQ(a.messages(), (Strings{
+                                "10: instantiating lib.Box[int] with new stencil x/lib.Box[go.shape.int]",
+                                "11: instantiating lib.Show[*Name] with new stencil x/lib.Show[go.shape.*uint8]",
+                                "12: instantiating lib.Strings[Name] with new stencil x/lib.Strings[go.shape.string]",
+                            }));
+    auto strings = a.dict("x/lib.Strings[a.Name]");
+    ASSERT_NE(strings, nullptr);
+    EXPECT_EQ(entries(strings->Entries),
+              (Strings{"type Name", "dict Map[Name,string] x/lib.Map[a.Name,string]", "method Name.String"}));
+    auto show = a.dict("x/lib.Show[*a.Name]");
+    ASSERT_NE(show, nullptr);
+    EXPECT_EQ(entries(show->Entries), (Strings{"type *Name", "itab *Name, Stringer"}));
+    EXPECT_EQ(cache.Size(), 4u);
+
+    // another package shares the stencils a generated
+    Package b(src("b"), &importer, "b", &cache);
+    EXPECT_EQ(b.messages(),
+              (Strings{
+                  "10: instantiating lib.Box[int] with stencil x/lib.Box[go.shape.int] of package a",
+                  "11: instantiating lib.Show[*Name] with stencil x/lib.Show[go.shape.*uint8] of package a",
+                  "12: instantiating lib.Strings[Name] with stencil x/lib.Strings[go.shape.string] of package a",
+              }));
+    EXPECT_EQ(cache.Size(), 4u);
+    EXPECT_NE(b.dict("x/lib.Strings[b.Name]"), nullptr);
+}
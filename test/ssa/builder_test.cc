@@ -0,0 +1,483 @@
+#include "ssa/build.hh"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "syntax/parser.hh"
+
+namespace {
+
+struct Package {
+    ast::FilePtr file;
+    types::Checker check;
+    compile::EscapeAnalysis escape{check};
+    compile::Devirtualizer devirt;
+
+    explicit Package(const std::string &src, const compile::CallProfile *profile = nullptr)
+        : devirt(check, "p", nullptr, profile) {
+        file = syntax::Parse(std::make_unique<std::istringstream>(src), [](uint line, uint col, std::string msg) {
+            FAIL() << line << ":" << col << ": " << msg;
+        });
+        ast::File *files[] = {file.get()};
+        for (auto &e : check.Check(files)) {
+            ADD_FAILURE() << e.Msg;
+        }
+        escape.Analyze(files);
+        devirt.Analyze(files);
+    }
+
+    ast::FuncDecl *decl(std::string_view name) const {
+        for (auto &d : file->DeclList) {
+            if (auto f = dyn_cast<ast::FuncDecl>(d.get()); f && ssa::FuncName(f) == name) {
+                return f;
+            }
+        }
+        return nullptr;
+    }
+
+    // dump returns the SSA form of the function name, or why it is not
+    // built.
+    std::string dump(std::string_view name) const {
+        ssa::Func f;
+        std::string reason;
+        if (!ssa::Build(f, check, decl(name), &reason, &escape, &devirt)) {
+            return "not lowered: " + reason;
+        }
+        if (auto err = f.Verify(); !err.empty()) {
+            ADD_FAILURE() << err << "\n" << f.String();
+        }
+        return f.String();
+    }
+};
+
+} // namespace
+
+TEST(BuilderTest, test_branches) {
+    Package p(R"(package p
+
+func abs(x int) int {
+	if x < 0 {
+		x = -x
+	}
+	return x
+}
+)");
+    EXPECT_EQ(p.dump("abs"), R"(abs func(int) int
+b0:
+  v0 = InitMem <mem>
+  v1 = Arg <int> [0] {x}
+  v2 = ConstInt <int> [0]
+  v3 = Less <bool> v1 v2
+  If v3 -> b1 b2
+b1: <- b0
+  v4 = Neg <int> v1
+  Plain -> b2
+b2: <- b0 b1
+  v5 = Phi <int> v1 v4
+  v7 = MakeResult <void> v5 v0
+  Ret v7
+)");
+}
+
+TEST(BuilderTest, test_loops) {
+    Package p(R"(package p
+
+func sum(xs []int) (s int) {
+	for _, x := range xs {
+		if x < 0 {
+			break
+		}
+		s += x
+	}
+	return
+}
+)");
+    EXPECT_EQ(p.dump("sum"), R"(sum func([]int) int
+b0:
+  v0 = InitMem <mem>
+  v1 = Arg <[]int> [0] {xs}
+  v2 = ConstInt <int> [0]
+  v3 = SliceLen <int> v1
+  v4 = ConstInt <int> [0]
+  v11 = ConstInt <int> [0]
+  v15 = ConstInt <int> [1]
+  Plain -> b1
+b1: <- b0 b3
+  v13 = Phi <int> v2 v14
+  v5 = Phi <int> v4 v16
+  v6 = Less <bool> v5 v3
+  If v6 -> b2 b4
+b2: <- b1
+  v7 = SlicePtr <*int> v1
+  v8 = PtrIndex <*int> v7 v5
+  v10 = Load <int> v8 v0
+  v12 = Less <bool> v10 v11
+  If v12 -> b5 b6
+b3: <- b6
+  v16 = Add <int> v5 v15
+  Plain -> b1
+b4: <- b1 b5
+  v19 = MakeResult <void> v13 v0
+  Ret v19
+b5: <- b2
+  Plain -> b4
+b6: <- b2
+  v14 = Add <int> v13 v10
+  Plain -> b3
+)");
+}
+
+TEST(BuilderTest, test_memory) {
+    Package p(R"(package p
+
+type T struct{ a, b int }
+
+func (t *T) Inc() { t.a++ }
+
+func g() int {
+	t := T{1, 2}
+	t.Inc()
+	return t.b
+}
+)");
+    EXPECT_EQ(p.dump("(*T).Inc"), R"((*T).Inc func()
+b0:
+  v0 = InitMem <mem>
+  v1 = Arg <*T> [0] {t}
+  v2 = NilCheck <void> v1 v0
+  v3 = OffPtr <*int> [0] v1
+  v4 = Load <int> v3 v0
+  v5 = ConstInt <int> [1]
+  v6 = Add <int> v4 v5
+  v7 = Store <mem> v3 v6 v0
+  v8 = MakeResult <void> v7
+  Ret v8
+)");
+    // t lives in memory, as Inc takes its address
+    EXPECT_EQ(p.dump("g"), R"(g func() int
+b0:
+  v0 = InitMem <mem>
+  v1 = ConstInt <int> [1]
+  v2 = ConstInt <int> [2]
+  v3 = StructMake <T> v1 v2
+  v4 = Alloc <*T> {t} v0
+  v5 = Store <mem> v4 v3 v0
+  v6 = StaticCall <mem> {Inc} v4 v5
+  v7 = OffPtr <*int> [1] v4
+  v8 = Load <int> v7 v6
+  v9 = MakeResult <void> v8 v6
+  Ret v9
+)");
+}
+
+TEST(BuilderTest, test_packed_literal) {
+    // a literal of 64 integers or more is parsed into a packed buffer,
+    // which is copied from read-only data in one move
+    std::string elems;
+    for (int i = 0; i < 100; i++) {
+        elems += std::to_string(i * 600) + ", ";
+    }
+    Package p("package p\n\nfunc f() []uint16 { return []uint16{" + elems + "} }\n");
+    EXPECT_EQ(p.dump("f"), R"(f func() []uint16
+b0:
+  v0 = InitMem <mem>
+  v1 = HeapAlloc <*[100]uint16> v0
+  v2 = StaticData <*[100]uint16> {200 bytes}
+  v3 = Move <mem> [200] v1 v2 v0
+  v4 = Convert <*uint16> v1
+  v5 = ConstInt <int> [100]
+  v6 = SliceMake <[]uint16> v4 v5 v5
+  v7 = MakeResult <void> v6 v3
+  Ret v7
+)");
+    ssa::Func f;
+    ASSERT_TRUE(ssa::Build(f, p.check, p.decl("f")));
+    auto data = f.Entry()->Values[2]->Str;
+    ASSERT_EQ(data.size(), 200u);
+    EXPECT_EQ(uint8_t(data[2]), 600 & 0xff);
+    EXPECT_EQ(uint8_t(data[3]), 600 >> 8);
+}
+
+TEST(BuilderTest, test_allocations) {
+    Package p(R"(package p
+
+type T struct{ a, b int }
+
+func sum(t *T) int { return t.a + t.b }
+
+func local() int {
+	t := T{1, 2}
+	return sum(&t) + *new(int)
+}
+
+func escaping() *T { return &T{} }
+)");
+    // neither t nor the new int outlive local
+    EXPECT_EQ(p.dump("local"), R"(local func() int
+b0:
+  v0 = InitMem <mem>
+  v1 = ConstInt <int> [1]
+  v2 = ConstInt <int> [2]
+  v3 = StructMake <T> v1 v2
+  v4 = Alloc <*T> {t} v0
+  v5 = Store <mem> v4 v3 v0
+  v6 = StaticCall <mem> {sum} v4 v5
+  v7 = SelectN <int> [0] v6
+  v8 = Alloc <*int> v6
+  v9 = NilCheck <void> v8 v6
+  v10 = Load <int> v8 v6
+  v11 = Add <int> v7 v10
+  v12 = MakeResult <void> v11 v6
+  Ret v12
+)");
+    EXPECT_EQ(p.dump("escaping"), R"(escaping func() *T
+b0:
+  v0 = InitMem <mem>
+  v1 = HeapAlloc <*T> v0
+  v2 = MakeResult <void> v1 v0
+  Ret v2
+)");
+}
+
+TEST(BuilderTest, test_devirtualized_calls) {
+    std::string error;
+    auto profile = compile::CallProfile::Parse("p.guarded 1 p.(*Square).Area 100\n", error);
+    ASSERT_TRUE(profile) << error;
+    Package p(R"(package p
+
+type Shape interface{ Area() int }
+
+type Square struct{ s int }
+
+func (q *Square) Area() int { return q.s * q.s }
+
+func direct() int {
+	var s Shape = &Square{2}
+	return s.Area()
+}
+
+func guarded(s Shape) int {
+	return s.Area()
+}
+)",
+              &*profile);
+    EXPECT_EQ(p.dump("direct"), R"(direct func() int
+b0:
+  v0 = InitMem <mem>
+  v1 = HeapAlloc <*Square> v0
+  v2 = ConstInt <int> [2]
+  v3 = OffPtr <*int> [0] v1
+  v4 = Store <mem> v3 v2 v0
+  v5 = IMake <Shape> v1
+  v6 = RuntimeCall <mem> {typeAssert} v5 v4
+  v7 = SelectN <*Square> [0] v6
+  v8 = StaticCall <mem> {Area} v7 v6
+  v9 = SelectN <int> [0] v8
+  v10 = MakeResult <void> v9 v8
+  Ret v10
+)");
+    // the profile makes the call directly only if s holds a *Square
+    EXPECT_EQ(p.dump("guarded"), R"(guarded func(Shape) int
+b0:
+  v0 = InitMem <mem>
+  v1 = Arg <Shape> [0] {s}
+  v2 = RuntimeCall <mem> {typeAssert2} v1 v0
+  v3 = SelectN <*Square> [0] v2
+  v4 = SelectN <bool> [1] v2
+  If v4 -> b1 b2
+b1: <- b0
+  v5 = StaticCall <mem> {Area} v3 v2
+  v6 = SelectN <int> [0] v5
+  Plain -> b3
+b2: <- b0
+  v7 = InterCall <mem> {Area} v1 v2
+  v8 = SelectN <int> [0] v7
+  Plain -> b3
+b3: <- b1 b2
+  v10 = Phi <mem> v5 v7
+  v9 = Phi <int> v6 v8
+  v11 = MakeResult <void> v9 v10
+  Ret v11
+)");
+}
+
+TEST(BuilderTest, test_bounds_checks) {
+    Package p(R"(package p
+
+func get(a [4]int, s []int, i int) int { return a[2] + s[i] }
+)");
+    EXPECT_EQ(p.dump("get"), R"(get func([4]int, []int, int) int
+b0:
+  v0 = InitMem <mem>
+  v1 = Arg <[4]int> [0] {a}
+  v2 = Alloc <*[4]int> {a} v0
+  v3 = Store <mem> v2 v1 v0
+  v4 = Arg <[]int> [1] {s}
+  v5 = Arg <int> [2] {i}
+  v6 = ConstInt <int> [4]
+  v7 = ConstInt <int> [2]
+  v8 = PtrIndex <*int> v2 v7
+  v9 = Load <int> v8 v3
+  v10 = SliceLen <int> v4
+  v11 = IsInBounds <bool> v5 v10
+  If v11 -> b1 b2
+b1: <- b0
+  v13 = SlicePtr <*int> v4
+  v14 = PtrIndex <*int> v13 v5
+  v15 = Load <int> v14 v3
+  v16 = Add <int> v9 v15
+  v17 = MakeResult <void> v16 v3
+  Ret v17
+b2: <- b0
+  v12 = PanicBounds <mem> v5 v10 v3
+  Exit v12
+)");
+}
+
+TEST(BuilderTest, test_short_circuit) {
+    Package p(R"(package p
+
+func f(a, b bool) bool { return a && b }
+)");
+    EXPECT_EQ(p.dump("f"), R"(f func(bool, bool) bool
+b0:
+  v0 = InitMem <mem>
+  v1 = Arg <bool> [0] {a}
+  v2 = Arg <bool> [1] {b}
+  v3 = ConstBool <bool> [true]
+  v4 = ConstBool <bool> [false]
+  If v1 -> b4 b2
+b1: <- b4
+  Plain -> b3
+b2: <- b0 b4
+  Plain -> b3
+b3: <- b1 b2
+  v5 = Phi <bool> v3 v4
+  v8 = MakeResult <void> v5 v0
+  Ret v8
+b4: <- b0
+  If v2 -> b1 b2
+)");
+}
+
+TEST(BuilderTest, test_verifies) {
+    Package p(R"(package p
+
+type P struct{ x, y int }
+
+type I interface{ M() int }
+
+func (p P) M() int { return p.x }
+
+func swap(a, b int) (int, int) {
+	a, b = b, a
+	return a, b
+}
+
+func nested(n int) int {
+	s := 0
+outer:
+	for i := 0; i < n; i++ {
+		for j := 0; j < n; j++ {
+			if j > i {
+				continue outer
+			}
+			if i*j > 100 {
+				break outer
+			}
+			s += i * j
+		}
+	}
+	return s
+}
+
+func sw(x int) (r string) {
+	switch x {
+	case 1:
+		r = "one"
+	case 2, 3:
+		fallthrough
+	default:
+		r = "many"
+	}
+	return
+}
+
+func calls(i I, p *P, m map[string]int, c chan int) int {
+	m["a"]++
+	c <- i.M() + p.M()
+	v, ok := m["b"]
+	if !ok {
+		panic("no b")
+	}
+	return v + len(m) + <-c
+}
+
+func slices(s []int, str string) []int {
+	s = append(s[1:2:3], len(str[1:]))
+	for i := range 3 {
+		s = append(s, i)
+	}
+	return s
+}
+
+func dead() int {
+	for {
+		return 1
+	}
+}
+)");
+    for (auto name : {"P.M", "swap", "nested", "sw", "calls", "slices", "dead"}) {
+        EXPECT_EQ(p.dump(name).find("not lowered"), std::string::npos) << name;
+    }
+}
+
+TEST(BuilderTest, test_unsupported) {
+    Package p(R"(package p
+
+func closure() func() int { return func() int { return 1 } }
+
+func deferred() { defer println() }
+
+func generic[T any](x T) T { return x }
+
+func loopvar() (s []*int) {
+	for i := 0; i < 3; i++ {
+		s = append(s, &i)
+	}
+	return
+}
+
+func typeswitch(x any) int {
+	switch x.(type) {
+	case int:
+		return 1
+	}
+	return 0
+}
+)");
+    EXPECT_EQ(p.dump("closure"), "not lowered: closure");
+    EXPECT_EQ(p.dump("deferred"), "not lowered: defer statement");
+    EXPECT_EQ(p.dump("generic"), "not lowered: generic function");
+    EXPECT_EQ(p.dump("loopvar"), "not lowered: address-taken loop variable");
+    EXPECT_EQ(p.dump("typeswitch"), "not lowered: type switch");
+}
+
+TEST(BuilderTest, test_func_reuse) {
+    Package p(R"(package p
+
+func a(x int) int { return x + 1 }
+
+func b(x, y int) int { return x * y }
+)");
+    ssa::Func f;
+    ASSERT_TRUE(ssa::Build(f, p.check, p.decl("a")));
+    EXPECT_EQ(f.Name(), "a");
+    ASSERT_TRUE(ssa::Build(f, p.check, p.decl("b")));
+    EXPECT_EQ(f.Name(), "b");
+    // the IDs of the previous function are not carried over
+    EXPECT_EQ(f.Entry()->Id, 0u);
+    EXPECT_EQ(f.NumValues(), 5u);
+    EXPECT_EQ(f.Verify(), "");
+}
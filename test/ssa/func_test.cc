@@ -0,0 +1,179 @@
+#include "ssa/func.hh"
+
+#include <gtest/gtest.h>
+
+using namespace ssa;
+
+namespace {
+
+constexpr TypeId Int = KindInt;
+constexpr TypeId Bool = KindBool;
+
+// diamond builds
+//
+//     func f(x int) int {
+//         y := 1
+//         if x < 0 { y = 2 }
+//         return y
+//     }
+struct Diamond {
+    Func f;
+    Block *entry, *then, *done;
+    Value *arg, *phi;
+
+    Diamond() {
+        f.Reset("f", 0);
+        entry = f.NewBlock(BlockKind::If);
+        then = f.NewBlock(BlockKind::Plain);
+        done = f.NewBlock(BlockKind::Ret);
+        auto mem = f.NewValue(entry, Op::InitMem, TypeMem);
+        arg = f.NewValue(entry, Op::Arg, Int);
+        auto one = f.ConstInt(Int, 1), two = f.ConstInt(Int, 2);
+        entry->SetControl(f.NewValue(entry, Op::Less, Bool, {arg, f.ConstInt(Int, 0)}));
+        entry->AddEdgeTo(then);
+        entry->AddEdgeTo(done);
+        then->AddEdgeTo(done);
+        phi = f.NewValue(done, Op::Phi, Int, {one, two});
+        done->SetControl(f.NewValue(done, Op::MakeResult, 0, {phi, mem}));
+    }
+};
+
+} // namespace
+
+TEST(FuncTest, test_list) {
+    common::Arena arena;
+    List<int, 2> l;
+    EXPECT_TRUE(l.empty());
+    for (int i = 0; i < 10; i++) {
+        l.push_back(arena, i);
+    }
+    ASSERT_EQ(l.size(), 10u);
+    l.insert(arena, 0, -1);
+    l.erase(5);
+    std::vector<int> got(l.begin(), l.end());
+    EXPECT_EQ(got, (std::vector<int>{-1, 0, 1, 2, 3, 5, 6, 7, 8, 9}));
+    l.truncate(2);
+    EXPECT_EQ(l.back(), 0);
+}
+
+TEST(FuncTest, test_bitset) {
+    BitSet s(130);
+    EXPECT_TRUE(s.Insert(3));
+    EXPECT_FALSE(s.Insert(3));
+    s.Add(129);
+    s.Add(64);
+    EXPECT_TRUE(s.Has(64));
+    EXPECT_FALSE(s.Has(65));
+    EXPECT_FALSE(s.Has(1000));
+    EXPECT_EQ(s.Count(), 3u);
+    s.Remove(3);
+    EXPECT_EQ(s.Count(), 2u);
+    s.Reset(10);
+    EXPECT_EQ(s.Count(), 0u);
+}
+
+TEST(FuncTest, test_dense_ids) {
+    Diamond d;
+    EXPECT_EQ(d.f.NumBlocks(), 3u);
+    std::vector<bool> seen(d.f.NumValues());
+    for (auto b : d.f.Blocks()) {
+        for (auto v : b->Values) {
+            ASSERT_LT(v->Id, d.f.NumValues());
+            EXPECT_FALSE(seen[v->Id]);
+            seen[v->Id] = true;
+        }
+    }
+    EXPECT_EQ(d.f.Verify(), "");
+    EXPECT_EQ(d.arg->Uses, 1u);
+    EXPECT_EQ(d.phi->Uses, 1u);
+}
+
+TEST(FuncTest, test_string) {
+    Diamond d;
+    EXPECT_EQ(d.f.String(), R"(f void
+b0:
+  v0 = InitMem <mem>
+  v1 = Arg <int> [0]
+  v2 = ConstInt <int> [1]
+  v3 = ConstInt <int> [2]
+  v4 = ConstInt <int> [0]
+  v5 = Less <bool> v1 v4
+  If v5 -> b1 b2
+b1: <- b0
+  Plain -> b2
+b2: <- b0 b1
+  v6 = Phi <int> v2 v3
+  v7 = MakeResult <void> v6 v0
+  Ret v7
+)");
+}
+
+TEST(FuncTest, test_remove_edge) {
+    Diamond d;
+    // the branch always goes to then
+    d.entry->RemoveEdge(1);
+    d.entry->Kind = BlockKind::Plain;
+    d.entry->SetControl(nullptr);
+    ASSERT_EQ(d.phi->Args.size(), 1u);
+    EXPECT_EQ(d.phi->Args[0]->AuxInt, 2);
+    EXPECT_EQ(d.f.Verify(), "");
+}
+
+TEST(FuncTest, test_remove_unreachable) {
+    Diamond d;
+    d.entry->RemoveEdge(0);
+    d.entry->Kind = BlockKind::Plain;
+    d.entry->SetControl(nullptr);
+    d.f.RemoveUnreachable();
+    EXPECT_EQ(d.f.Blocks().size(), 2u);
+    ASSERT_EQ(d.phi->Args.size(), 1u);
+    EXPECT_EQ(d.phi->Args[0]->AuxInt, 1);
+    EXPECT_EQ(d.f.Verify(), "");
+}
+
+TEST(FuncTest, test_copy_of) {
+    Diamond d;
+    d.phi->CopyOf(d.arg);
+    EXPECT_EQ(d.phi->Op, Op::Copy);
+    EXPECT_EQ(d.phi->Args.size(), 1u);
+    EXPECT_EQ(d.arg->Uses, 2u);
+    EXPECT_EQ(d.f.Verify(), "");
+}
+
+TEST(FuncTest, test_verify) {
+    Diamond d;
+    // a Phi must have an argument per predecessor
+    d.phi->AddArg(d.arg);
+    EXPECT_NE(d.f.Verify().find("v6"), std::string::npos) << d.f.Verify();
+
+    Diamond e;
+    e.arg->Uses++;
+    EXPECT_NE(e.f.Verify().find("uses"), std::string::npos) << e.f.Verify();
+
+    // a value of then does not dominate the result
+    Diamond g;
+    g.done->Control->SetArg(0, g.f.NewValue(g.then, Op::Neg, Int, {g.arg}));
+    EXPECT_NE(g.f.Verify().find("dominate"), std::string::npos) << g.f.Verify();
+}
+
+TEST(FuncTest, test_reset_frees_ir) {
+    Func f;
+    size_t reserved = 0;
+    for (int round = 0; round < 3; round++) {
+        f.Reset("f", 0);
+        auto b = f.NewBlock(BlockKind::Exit);
+        auto mem = f.NewValue(b, Op::InitMem, TypeMem);
+        for (int i = 0; i < 1000; i++) {
+            f.ConstInt(Int, i);
+        }
+        b->SetControl(mem);
+        EXPECT_EQ(f.NumValues(), 1001u);
+        EXPECT_EQ(f.Verify(), "");
+        if (round == 1) {
+            reserved = f.Mem().Reserved();
+        } else if (round == 2) {
+            // the arena settled at the size of the function
+            EXPECT_EQ(f.Mem().Reserved(), reserved);
+        }
+    }
+}
@@ -0,0 +1,630 @@
+#include "ssa/pass.hh"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "ssa/build.hh"
+#include "ssa/dom.hh"
+#include "ssa/loop.hh"
+#include "syntax/parser.hh"
+
+namespace {
+
+struct Package {
+    ast::FilePtr file;
+    types::Checker check;
+
+    explicit Package(const std::string &src) {
+        file = syntax::Parse(std::make_unique<std::istringstream>(src), [](uint line, uint col, std::string msg) {
+            FAIL() << line << ":" << col << ": " << msg;
+        });
+        ast::File *files[] = {file.get()};
+        for (auto &e : check.Check(files)) {
+            ADD_FAILURE() << e.Msg;
+        }
+    }
+
+    // build builds the function name into f.
+    void build(ssa::Func &f, std::string_view name) const {
+        for (auto &d : file->DeclList) {
+            if (auto decl = dyn_cast<ast::FuncDecl>(d.get()); decl && ssa::FuncName(decl) == name) {
+                std::string reason;
+                ASSERT_TRUE(ssa::Build(f, check, decl, &reason)) << reason;
+                return;
+            }
+        }
+        FAIL() << "no function " << name;
+    }
+
+    // opt returns the SSA form of the function name after the passes of
+    // pipeline.
+    std::string opt(std::string_view name, std::string_view pipeline) const {
+        ssa::Func f;
+        build(f, name);
+        ssa::PassManager pm;
+        EXPECT_EQ(pm.SetPipeline(pipeline), "");
+        pm.SetVerify(true);
+        if (auto err = pm.Run(f); !err.empty()) {
+            ADD_FAILURE() << err << "\n" << f.String();
+        }
+        return f.String();
+    }
+};
+
+} // namespace
+
+TEST(PassTest, test_dominators) {
+    Package p(R"(package p
+
+func f(n int) int {
+	s := 0
+	for i := 0; i < n; i++ {
+		if i%2 == 0 {
+			s += i
+		}
+	}
+	return s
+}
+)");
+    ssa::Func f;
+    p.build(f, "f");
+    ssa::DomTree dom(f);
+    auto entry = f.Entry();
+    EXPECT_EQ(dom.Idom(entry), nullptr);
+    ASSERT_EQ(dom.ReversePostorder().size(), f.Blocks().size());
+    EXPECT_EQ(dom.ReversePostorder()[0], entry);
+    EXPECT_EQ(dom.Preorder()[0], entry);
+    for (auto b : f.Blocks()) {
+        EXPECT_TRUE(dom.Dominates(entry, b));
+        EXPECT_TRUE(dom.Dominates(b, b));
+        if (b == entry) {
+            continue;
+        }
+        // the immediate dominator dominates each predecessor, and is
+        // dominated by every other dominator
+        auto d = dom.Idom(b);
+        ASSERT_NE(d, nullptr);
+        EXPECT_FALSE(dom.Dominates(b, d));
+        for (auto pred : b->Preds) {
+            EXPECT_TRUE(dom.Dominates(d, pred) || pred == b);
+        }
+        bool child = false;
+        for (auto c : dom.Children(d)) {
+            child |= c == b;
+        }
+        EXPECT_TRUE(child) << "b" << b->Id;
+    }
+}
+
+TEST(PassTest, test_deadcode) {
+    Package p(R"(package p
+
+var g int
+
+func f(x, y int) int {
+	a := x * y
+	b := a + 1
+	_ = b
+	g = x / y
+	return x
+}
+)");
+    // the division stays, as it may panic, and so does the store
+    EXPECT_EQ(p.opt("f", "deadcode"), R"(f func(int, int) int
+b0:
+  v0 = InitMem <mem>
+  v1 = Arg <int> [0] {x}
+  v2 = Arg <int> [1] {y}
+  v6 = Addr <*int> {g}
+  v7 = Div <int> v1 v2
+  v8 = Store <mem> v6 v7 v0
+  v9 = MakeResult <void> v1 v8
+  Ret v9
+)");
+}
+
+TEST(PassTest, test_sccp) {
+    Package p(R"(package p
+
+func f(x int) int {
+	n := 4
+	k := n * 2
+	if k > 7 {
+		return x + k
+	}
+	return x - 1
+}
+
+func loop(n int) int {
+	i := 1
+	s := 0
+	for j := 0; j < n; j++ {
+		if i != 1 {
+			i = 2
+		}
+		s += i
+	}
+	return s + i
+}
+
+func wrap() (int8, uint8, int, bool) {
+	var a int8 = 127
+	var b uint8 = 1
+	c := 1
+	s := "ab"
+	return a + 1, b - 2, c << 70, s == "a"
+}
+
+func div(x int) int {
+	y := 0
+	return x / y
+}
+)");
+    EXPECT_EQ(p.opt("f", "sccp,deadcode"), R"(f func(int) int
+b0:
+  v0 = InitMem <mem>
+  v1 = Arg <int> [0] {x}
+  v4 = ConstInt <int> [8]
+  Plain -> b1
+b1: <- b0
+  v7 = Add <int> v1 v4
+  v8 = MakeResult <void> v7 v0
+  Ret v8
+)");
+    // i is 1 on every executable edge, so the branch in the loop is gone
+    EXPECT_EQ(p.opt("loop", "sccp,deadcode"), R"(loop func(int) int
+b0:
+  v0 = InitMem <mem>
+  v1 = Arg <int> [0] {n}
+  v3 = ConstInt <int> [0]
+  v4 = ConstInt <int> [0]
+  v17 = ConstInt <int> [1]
+  Plain -> b1
+b1: <- b0 b3
+  v13 = Phi <int> v3 v15
+  v8 = ConstInt <int> [1]
+  v5 = Phi <int> v4 v18
+  v7 = Less <bool> v5 v1
+  If v7 -> b2 b4
+b2: <- b1
+  Plain -> b6
+b3: <- b6
+  v18 = Add <int> v5 v17
+  Plain -> b1
+b4: <- b1
+  v20 = Add <int> v13 v8
+  v23 = MakeResult <void> v20 v0
+  Ret v23
+b6: <- b2
+  v14 = ConstInt <int> [1]
+  v15 = Add <int> v13 v14
+  Plain -> b3
+)");
+    // constants wrap at the size of their type
+    auto wrap = p.opt("wrap", "sccp,deadcode");
+    EXPECT_NE(wrap.find("ConstInt <int8> [-128]"), std::string::npos) << wrap;
+    EXPECT_NE(wrap.find("ConstInt <uint8> [255]"), std::string::npos) << wrap;
+    EXPECT_NE(wrap.find("ConstInt <int> [0]"), std::string::npos) << wrap;
+    EXPECT_NE(wrap.find("ConstBool <bool> [false]"), std::string::npos) << wrap;
+    // a division by zero is not folded, it panics
+    auto div = p.opt("div", "sccp,deadcode");
+    EXPECT_NE(div.find("Div <int>"), std::string::npos) << div;
+}
+
+TEST(PassTest, test_cse) {
+    Package p(R"(package p
+
+type T struct {
+	a, b int
+}
+
+func f(x, y int) int {
+	return (x*y + 1) ^ (y*x + 1)
+}
+
+func g(t *T) int {
+	s := t.a + t.a
+	t.b = 0
+	return s + t.a
+}
+
+func h(c bool, x, y int) int {
+	if c {
+		return x + y
+	}
+	return x + y
+}
+)");
+    EXPECT_EQ(p.opt("f", "cse,deadcode"), R"(f func(int, int) int
+b0:
+  v0 = InitMem <mem>
+  v1 = Arg <int> [0] {x}
+  v2 = Arg <int> [1] {y}
+  v3 = Mul <int> v1 v2
+  v4 = ConstInt <int> [1]
+  v5 = Add <int> v3 v4
+  v9 = Xor <int> v5 v5
+  v10 = MakeResult <void> v9 v0
+  Ret v10
+)");
+    // t.a is loaded twice from the same memory, and once more after the
+    // store
+    auto g = p.opt("g", "cse,deadcode");
+    size_t loads = 0;
+    for (size_t i = 0; (i = g.find("= Load", i)) != std::string::npos; i++) {
+        loads++;
+    }
+    EXPECT_EQ(loads, 2u) << g;
+    // neither sum dominates the other
+    auto h = p.opt("h", "cse,deadcode");
+    EXPECT_NE(h.find("Add <int> v2 v3"), h.rfind("Add <int> v2 v3")) << h;
+}
+
+TEST(PassTest, test_copyelim) {
+    // a loop whose Phi selects x or a copy of itself
+    ssa::Func f;
+    f.Reset("f", 0);
+    auto entry = f.NewBlock(ssa::BlockKind::Plain), loop = f.NewBlock(ssa::BlockKind::If),
+         done = f.NewBlock(ssa::BlockKind::Ret);
+    auto mem = f.NewValue(entry, ssa::Op::InitMem, ssa::TypeMem);
+    auto x = f.NewValue(entry, ssa::Op::Arg, KindInt);
+    entry->AddEdgeTo(loop);
+    loop->AddEdgeTo(loop);
+    loop->AddEdgeTo(done);
+    auto phi = f.NewValue(loop, ssa::Op::Phi, KindInt, {x, x});
+    auto copy = f.NewValue(loop, ssa::Op::Copy, KindInt, {phi});
+    phi->SetArg(1, copy);
+    loop->SetControl(f.NewValue(loop, ssa::Op::Less, KindBool, {copy, x}));
+    auto result = f.NewValue(done, ssa::Op::MakeResult, 0, {copy, mem});
+    done->SetControl(result);
+    ASSERT_EQ(f.Verify(), "");
+
+    ssa::CopyElim(f);
+    EXPECT_EQ(f.Verify(), "");
+    EXPECT_EQ(result->Args[0], x);
+    EXPECT_EQ(loop->Control->Args[0], x);
+    for (auto b : f.Blocks()) {
+        for (auto v : b->Values) {
+            EXPECT_NE(v->Op, ssa::Op::Copy) << v->LongString();
+            EXPECT_NE(v->Op, ssa::Op::Phi) << v->LongString();
+        }
+    }
+}
+
+TEST(PassTest, test_pass_manager) {
+    ssa::PassManager pm;
+    EXPECT_EQ(pm.Pipeline(), ssa::PassManager::DefaultPipeline);
+    EXPECT_EQ(pm.SetPipeline("cse,nope"), "unknown pass \"nope\"");
+    EXPECT_EQ(pm.Pipeline(), ssa::PassManager::DefaultPipeline);
+    EXPECT_EQ(pm.SetPipeline("deadcode,cse,deadcode"), "");
+    EXPECT_EQ(pm.Pipeline(), "deadcode,cse,deadcode");
+    EXPECT_EQ(pm.SetPipeline(""), "");
+    EXPECT_EQ(pm.Pipeline(), "");
+    for (auto &pass : ssa::Passes()) {
+        EXPECT_EQ(pm.SetPipeline(pass.Name), "");
+    }
+
+    Package p(R"(package p
+
+func f(x int) int {
+	a := x * 2
+	b := x * 2
+	return a + b
+}
+)");
+    ssa::Func f;
+    ssa::PassManager other;
+    pm.SetPipeline("cse,deadcode");
+    other.SetPipeline("cse,deadcode");
+    for (auto m : {&pm, &other}) {
+        p.build(f, "f");
+        EXPECT_EQ(m->Run(f), "");
+    }
+    pm.Merge(other);
+    auto timings = pm.Timings();
+    ASSERT_EQ(timings.size(), 2u);
+    EXPECT_EQ(timings[0].Pass->Name, "cse");
+    EXPECT_EQ(timings[0].Runs, 2u);
+    // the second product and the copy CSE left of it, in each function
+    EXPECT_EQ(timings[1].Removed, 4);
+    auto report = pm.Report();
+    EXPECT_NE(report.find("cse"), std::string::npos) << report;
+    EXPECT_NE(report.find("total"), std::string::npos) << report;
+}
+
+TEST(PassTest, test_prove) {
+    Package p(R"(package p
+
+type T struct {
+	a, b int
+}
+
+func sum(s []byte) int {
+	n := 0
+	for i := 0; i < len(s); i++ {
+		n += int(s[i])
+	}
+	return n
+}
+
+func down(s []int) int {
+	n := 0
+	for i := len(s) - 1; i >= 0; i-- {
+		n += s[i]
+	}
+	return n
+}
+
+func pairs(b []byte) int {
+	n := 0
+	for i := 1; i+1 < len(b); i += 2 {
+		n += int(b[i-1]) + int(b[i]) + int(b[i+1])
+	}
+	return n
+}
+
+func fields(t *T) int {
+	return t.a + t.b
+}
+
+func guarded(s []int, i int) int {
+	if i >= 0 && i < len(s) {
+		return s[i] + s[i]
+	}
+	return 0
+}
+
+func past(s []int) int {
+	n := 0
+	for i := 0; i <= len(s); i++ {
+		n += s[i]
+	}
+	return n
+}
+
+func other(a, b []int, i int) int {
+	if i < len(a) {
+		return a[i] + b[i]
+	}
+	return 0
+}
+)");
+    auto count = [](const std::string &s, std::string_view op) {
+        size_t n = 0;
+        for (size_t i = 0; (i = s.find(op, i)) != std::string::npos; i++) {
+            n++;
+        }
+        return n;
+    };
+    for (auto name : {"sum", "down", "pairs", "guarded"}) {
+        auto s = p.opt(name, "cse,prove,deadcode");
+        EXPECT_EQ(count(s, "IsInBounds"), 0u) << s;
+        EXPECT_EQ(count(s, "PanicBounds"), 0u) << s;
+    }
+    // the fields of t are loaded after a single nil check
+    auto fields = p.opt("fields", "cse,prove,deadcode");
+    EXPECT_EQ(count(fields, "NilCheck"), 1u) << fields;
+    // i may be len(s) in past; in other it may be negative, and is not
+    // compared with len(b)
+    auto past = p.opt("past", "cse,prove,deadcode");
+    EXPECT_EQ(count(past, "IsInBounds"), 1u) << past;
+    auto other = p.opt("other", "cse,prove,deadcode");
+    EXPECT_EQ(count(other, "IsInBounds"), 2u) << other;
+
+    // the removed checks are reported under debug, and only then
+    ssa::Func f;
+    ssa::PassManager pm;
+    pm.SetPipeline("cse,prove,deadcode");
+    p.build(f, "guarded");
+    EXPECT_EQ(pm.Run(f), "");
+    EXPECT_TRUE(f.Reports().empty());
+    EXPECT_EQ(pm.SetDebug("nope"), "unknown pass \"nope\"");
+    EXPECT_EQ(pm.SetDebug("prove"), "");
+    p.build(f, "guarded");
+    EXPECT_EQ(pm.Run(f), "");
+    ASSERT_EQ(f.Reports().size(), 2u);
+    for (auto &r : f.Reports()) {
+        EXPECT_TRUE(r.Pos.IsKnown());
+    }
+    EXPECT_EQ(f.Reports()[0].Msg, "Proved IsInBounds");
+}
+
+TEST(PassTest, test_loops) {
+    Package p(R"(package p
+
+func f(n int) int {
+	s := 0
+	for i := 0; i < n; i++ {
+		for j := 0; j < i; j++ {
+			s += j
+		}
+	}
+	return s
+}
+)");
+    ssa::Func f;
+    p.build(f, "f");
+    ssa::DomTree dom(f);
+    ssa::LoopNest nest(f, dom);
+    ASSERT_EQ(nest.Loops().size(), 2u);
+    auto outer = nest.Loops()[0], inner = nest.Loops()[1];
+    EXPECT_EQ(outer->Depth, 1u);
+    EXPECT_EQ(outer->Outer, nullptr);
+    EXPECT_FALSE(outer->Inner);
+    EXPECT_EQ(inner->Depth, 2u);
+    EXPECT_EQ(inner->Outer, outer);
+    EXPECT_TRUE(inner->Inner);
+    EXPECT_EQ(nest.Of(f.Entry()), nullptr);
+    EXPECT_EQ(nest.Of(inner->Header), inner);
+    EXPECT_TRUE(nest.Contains(outer, inner->Header));
+    EXPECT_FALSE(nest.Contains(inner, outer->Header));
+    for (auto l : nest.Loops()) {
+        EXPECT_EQ(l->Blocks[0], l->Header);
+        ASSERT_EQ(l->Latches.size(), 1u);
+        EXPECT_TRUE(dom.Dominates(l->Header, l->Latches[0]));
+        EXPECT_EQ(l->Exits, std::vector<ssa::Block *>{l->Header});
+        auto entry = l->Entry();
+        ASSERT_NE(entry, nullptr);
+        EXPECT_FALSE(nest.Contains(l, entry));
+    }
+    // n is invariant in both loops, and i only in the inner one
+    EXPECT_TRUE(nest.Invariant(inner, f.Entry()->Values[1]));
+    EXPECT_TRUE(nest.Invariant(outer, f.Entry()->Values[1]));
+}
+
+TEST(PassTest, test_loop_opts) {
+    Package p(R"(package p
+
+type T struct {
+	a, b int
+}
+
+var g int
+
+func count(n int) int {
+	s := 0
+	for i := 0; i < n; i++ {
+		s += i
+	}
+	return s
+}
+
+func ahead(s []int) int {
+	t := 0
+	for i := 0; i+1 < len(s); i++ {
+		t += s[i+1]
+	}
+	return t
+}
+
+func field(t *T, n int) int {
+	s := 0
+	for i := 0; i < n; i++ {
+		s += t.a
+	}
+	return s
+}
+
+func div(x, y, n int) int {
+	s := 0
+	for i := 0; i < n; i++ {
+		s += x / y
+	}
+	return s
+}
+
+func stored(t *T, n int) int {
+	s := 0
+	for i := 0; i < n; i++ {
+		g = i
+		s += t.a
+	}
+	return s
+}
+
+func cond(x, y, n int) int {
+	s := 0
+	for i := 0; i < n; i++ {
+		if i > 3 {
+			s += x / y
+		}
+	}
+	return s
+}
+
+func mat(a []float64, n, m int) float64 {
+	s := 0.0
+	for i := 0; i < n; i++ {
+		for j := 0; j < m; j++ {
+			s += a[i*m+j] + a[j<<2]
+		}
+	}
+	return s
+}
+
+func last(s []int) int {
+	n := 0
+	for i := len(s) - 1; -1 < i; i-- {
+		n += s[i]
+	}
+	return n
+}
+)");
+    // inLoop counts the values of op in the loops of the function name
+    // after pipeline.
+    auto inLoop = [&](std::string_view name, std::string_view pipeline, ssa::Op op) {
+        ssa::Func f;
+        p.build(f, name);
+        ssa::PassManager pm;
+        EXPECT_EQ(pm.SetPipeline(pipeline), "");
+        pm.SetVerify(true);
+        EXPECT_EQ(pm.Run(f), "");
+        ssa::DomTree dom(f);
+        ssa::LoopNest nest(f, dom);
+        size_t n = 0;
+        for (auto b : f.Blocks()) {
+            for (auto v : b->Values) {
+                n += v->Op == op && nest.Of(b) != nullptr;
+            }
+        }
+        return n;
+    };
+
+    // a rotated loop branches once per iteration, at its latch, after a
+    // test on entry
+    {
+        ssa::Func f;
+        p.build(f, "count");
+        ssa::PassManager pm;
+        pm.SetPipeline("looprotate,deadcode");
+        pm.SetVerify(true);
+        EXPECT_EQ(pm.Run(f), "");
+        ssa::DomTree dom(f);
+        ssa::LoopNest nest(f, dom);
+        ASSERT_EQ(nest.Loops().size(), 1u);
+        auto l = nest.Loops()[0];
+        EXPECT_EQ(f.Entry()->Kind, ssa::BlockKind::If);
+        ASSERT_EQ(l->Latches.size(), 1u);
+        EXPECT_EQ(l->Latches[0]->Kind, ssa::BlockKind::If);
+        EXPECT_EQ(l->Exits, l->Latches);
+        for (auto b : l->Blocks) {
+            EXPECT_TRUE(b == l->Latches[0] || b->Kind == ssa::BlockKind::Plain) << f.String();
+        }
+    }
+
+    // the Phis of the header may use its values, as i+1 here once CSE
+    // merges the increment with the test
+    EXPECT_EQ(inLoop("ahead", ssa::PassManager::DefaultPipeline, ssa::Op::IsInBounds), 0u);
+
+    // what may panic is hoisted only from where the rotated loop always
+    // evaluates it first
+    const auto licm = "looprotate,licm,deadcode";
+    EXPECT_EQ(inLoop("field", licm, ssa::Op::NilCheck), 0u);
+    EXPECT_EQ(inLoop("field", licm, ssa::Op::Load), 0u);
+    EXPECT_EQ(inLoop("div", licm, ssa::Op::Div), 0u);
+    EXPECT_EQ(inLoop("div", "licm,deadcode", ssa::Op::Div), 1u);
+    EXPECT_EQ(inLoop("stored", licm, ssa::Op::NilCheck), 1u);
+    EXPECT_EQ(inLoop("cond", licm, ssa::Op::Div), 1u);
+
+    // the index products become induction variables of their own
+    EXPECT_EQ(inLoop("mat", "indvars,copyelim,deadcode", ssa::Op::Mul), 0u);
+    EXPECT_EQ(inLoop("mat", "indvars,copyelim,deadcode", ssa::Op::Shl), 0u);
+    // and -1 < i is tested as 0 <= i
+    {
+        ssa::Func f;
+        p.build(f, "last");
+        ssa::PassManager pm;
+        pm.SetPipeline("indvars");
+        pm.SetVerify(true);
+        EXPECT_EQ(pm.Run(f), "");
+        ssa::DomTree dom(f);
+        ssa::LoopNest nest(f, dom);
+        ASSERT_EQ(nest.Loops().size(), 1u);
+        auto c = nest.Loops()[0]->Header->Control;
+        EXPECT_EQ(c->Op, ssa::Op::Leq) << f.String();
+        EXPECT_EQ(c->Args[0]->Op, ssa::Op::ConstInt);
+        EXPECT_EQ(c->Args[0]->AuxInt, 0);
+    }
+    EXPECT_EQ(inLoop("last", "cse,indvars,prove,deadcode", ssa::Op::IsInBounds), 0u);
+}
@@ -0,0 +1,105 @@
+#include "staticdata/embed.hh"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+
+#include "common/digest.hh"
+
+using namespace staticdata;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct TempDir {
+    std::string path;
+    TempDir() {
+        char tmpl[] = "/tmp/embed_test.XXXXXX";
+        path = mkdtemp(tmpl);
+    }
+    ~TempDir() { std::filesystem::remove_all(path); }
+};
+
+std::string write(const std::string &path, size_t size) {
+    std::string data(size, '\0');
+    for (size_t i = 0; i < size; i++) {
+        data[i] = char(i * 7 + i / 4093);
+    }
+    std::ofstream(path, std::ios::binary) << data;
+    return data;
+}
+
+} // namespace
+
+TEST(EmbedTest, test_write_embed) {
+    TempDir dir;
+    auto path = dir.path + "/asset";
+    auto data = write(path, 2 * EmbedChunkSize + 12345);
+
+    std::string out;
+    int chunks = 0;
+    EmbedFile f;
+    ASSERT_TRUE(WriteEmbed(
+        path,
+        [&](std::string_view chunk) {
+            EXPECT_LE(chunk.size(), EmbedChunkSize);
+            out.append(chunk);
+            chunks++;
+        },
+        f));
+    EXPECT_EQ(chunks, 3);
+    EXPECT_TRUE(out == data);
+    EXPECT_EQ(f.Path, path);
+    EXPECT_EQ(f.Size, data.size());
+    EXPECT_EQ(f.Hash, common::Digest(data));
+
+    // hashing alone gives the same digest
+    EmbedFile g;
+    ASSERT_TRUE(WriteEmbed(path, nullptr, g));
+    EXPECT_EQ(g.Hash, f.Hash);
+}
+
+TEST(EmbedTest, test_empty_and_missing) {
+    TempDir dir;
+    auto path = dir.path + "/empty";
+    write(path, 0);
+    EmbedFile f;
+    ASSERT_TRUE(WriteEmbed(path, [](std::string_view) { FAIL() << "no chunks expected"; }, f));
+    EXPECT_EQ(f.Size, 0u);
+    EXPECT_EQ(f.Hash, common::Digest(""));
+
+    EXPECT_FALSE(WriteEmbed(dir.path + "/missing", nullptr, f));
+}
+
+TEST(EmbedTest, test_resolve_embed) {
+    TempDir dir;
+    for (auto name : {"a.txt", "b.txt", "c.go", "static/x.css", "static/.hidden", "static/_draft/y.css",
+                      "static/img/z.png", "empty/.keep"}) {
+        auto path = fs::path(dir.path) / name;
+        fs::create_directories(path.parent_path());
+        write(path.string(), 10);
+    }
+    auto resolve = [&](std::vector<std::string> patterns) {
+        std::string err;
+        auto files = ResolveEmbed(dir.path, patterns, err);
+        return err.empty() ? files : std::vector<std::string>{err};
+    };
+    using names = std::vector<std::string>;
+    EXPECT_EQ(resolve({"b.txt", "*.txt", "a.txt"}), (names{"a.txt", "b.txt"}));
+    // a directory stands for its files but those hidden
+    EXPECT_EQ(resolve({"static"}), (names{"static/img/z.png", "static/x.css"}));
+    EXPECT_EQ(resolve({"all:static"}),
+              (names{"static/.hidden", "static/_draft/y.css", "static/img/z.png", "static/x.css"}));
+    // unless matched by name
+    EXPECT_EQ(resolve({"static/.*", "s*/*/*.png"}), (names{"static/.hidden", "static/img/z.png"}));
+
+    EXPECT_EQ(resolve({"*.txt", "d.txt"}), names{"pattern d.txt: no matching files found"});
+    EXPECT_EQ(resolve({"../a.txt"}), names{"pattern ../a.txt: invalid pattern syntax"});
+    EXPECT_EQ(resolve({"/a.txt"}), names{"pattern /a.txt: invalid pattern syntax"});
+    EXPECT_EQ(resolve({"static/"}), names{"pattern static/: invalid pattern syntax"});
+    EXPECT_EQ(resolve({"empty"}), names{"pattern empty: cannot embed directory: contains no embeddable files"});
+    EXPECT_EQ(resolve({"all:empty"}), names{"empty/.keep"});
+}
@@ -0,0 +1,203 @@
+#include "syntax/cache/ast_cache.hh"
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace syntax;
+
+namespace {
+
+const char *src = R"(package p
+
+import (
+	"fmt"
+	s "strings"
+)
+
+type T struct {
+	x, y int
+	*U  `json:"u"`
+}
+
+func (t *T) M(a []int, b ...string) (n int, err error) {
+L:
+	for i, v := range a {
+		switch {
+		case v > 0:
+			continue L
+		default:
+			n += i
+		}
+	}
+	fmt.Println(s.ToUpper(b[0]), T{x: 1}, a[1:2:3], <-make(chan int))
+	return
+}
+
+func f()
+)";
+
+struct TempDir {
+    std::string path;
+    TempDir() {
+        char tmpl[] = "/tmp/ast_cache_test.XXXXXX";
+        path = mkdtemp(tmpl);
+    }
+    ~TempDir() { std::filesystem::remove_all(path); }
+};
+
+ast::FilePtr parse(const std::string &s, uint mode = 0) {
+    return Parse(std::make_unique<std::istringstream>(s), [](uint line, uint col, std::string msg) {
+        FAIL() << line << ":" << col << ": " << msg;
+    }, mode);
+}
+
+Position where(Pos p) { return FileSet::Global().Resolve(p); }
+
+std::string bytes(const flatbuffers::DetachedBuffer &buf) {
+    return std::string(reinterpret_cast<const char *>(buf.data()), buf.size());
+}
+
+} // namespace
+
+TEST(AstCacheTest, test_round_trip) {
+    TempDir dir;
+    cache::AstCache c(dir.path);
+    auto f = parse(src);
+    ASSERT_EQ(c.Load(src), nullptr);
+    ASSERT_TRUE(c.Store(src, *f));
+
+    auto cached = c.Load(src);
+    ASSERT_NE(cached, nullptr);
+    auto g = cached->Decode();
+    ASSERT_NE(g, nullptr);
+
+    // the decoded tree encodes to the very same bytes
+    auto hash = cache::AstCache::Hash(src);
+    EXPECT_EQ(bytes(cache::Encode(*g, hash, 0)), bytes(cache::Encode(*f, hash, 0)));
+
+    EXPECT_EQ(g->PkgName->Sym, f->PkgName->Sym);
+    EXPECT_EQ(where(g->Eof), where(f->Eof));
+    auto i0 = std::dynamic_pointer_cast<ast::ImportDecl>(g->DeclList[0]);
+    auto i1 = std::dynamic_pointer_cast<ast::ImportDecl>(g->DeclList[1]);
+    ASSERT_NE(i0->Group, nullptr);
+    EXPECT_EQ(i0->Group, i1->Group);
+
+    // fields declared in a list still share their type
+    auto t = std::dynamic_pointer_cast<ast::TypeDecl>(g->DeclList[2]);
+    auto st = std::dynamic_pointer_cast<ast::StructType>(t->Type);
+    ASSERT_EQ(st->FieldList.size(), 3u);
+    EXPECT_EQ(st->FieldList[0]->Type, st->FieldList[1]->Type);
+    ASSERT_EQ(st->TagList.size(), 3u);
+    EXPECT_EQ(st->TagList[0], nullptr);
+    EXPECT_EQ(st->TagList[2]->Value, "`json:\"u\"`");
+
+    auto m = std::dynamic_pointer_cast<ast::FuncDecl>(g->DeclList[3]);
+    EXPECT_EQ(ast::String(m->Type.get()), "func(a []int, b ...string) (n int, err error)");
+    EXPECT_EQ(where(m->pos), where(f->DeclList[3]->pos));
+    EXPECT_EQ(where(m->pos).Line, 13);
+    EXPECT_EQ(where(m->Body->Rbrace),
+              where(std::dynamic_pointer_cast<ast::FuncDecl>(f->DeclList[3])->Body->Rbrace));
+    EXPECT_EQ(std::dynamic_pointer_cast<ast::FuncDecl>(g->DeclList[4])->Body, nullptr);
+}
+
+TEST(AstCacheTest, test_view) {
+    TempDir dir;
+    cache::AstCache c(dir.path);
+    ASSERT_TRUE(c.Store(src, *parse(src)));
+    auto cached = c.Load(src);
+    ASSERT_NE(cached, nullptr);
+
+    auto root = cached->Root();
+    ASSERT_EQ(root.Kind(), cache::NodeKind_File);
+    EXPECT_EQ(root.Child(0).Str(), "p");
+    auto decls = root.Child(1);
+    ASSERT_EQ(decls.Kind(), cache::NodeKind_List);
+    ASSERT_EQ(decls.NumChildren(), 5u);
+    auto m = decls.Child(3);
+    ASSERT_EQ(m.Kind(), cache::NodeKind_FuncDecl);
+    EXPECT_EQ(m.Child(1).Str(), "M");
+    EXPECT_EQ(m.Offset(), int64_t(std::string_view(src).find("func (t *T)") + 5));
+    EXPECT_FALSE(decls.Child(4).Child(3)); // no body
+}
+
+TEST(AstCacheTest, test_invalidation) {
+    TempDir dir;
+    cache::AstCache c(dir.path);
+    ASSERT_TRUE(c.Store(src, *parse(src)));
+    EXPECT_EQ(c.Load(std::string(src) + "\n"), nullptr);
+    // entries are keyed by parser mode as well
+    EXPECT_EQ(c.Load(src, SkipFuncBodies), nullptr);
+
+    // a truncated entry is treated as missing
+    auto path = c.Path(cache::AstCache::Hash(src), 0);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    EXPECT_EQ(c.Load(src), nullptr);
+}
+
+TEST(AstCacheTest, test_parse_cached) {
+    TempDir dir;
+    cache::AstCache c(dir.path);
+    auto errh = [](uint line, uint col, std::string msg) { FAIL() << line << ":" << col << ": " << msg; };
+    auto f = cache::ParseCached(c, src, errh, SkipFuncBodies);
+    ASSERT_NE(f, nullptr);
+    ASSERT_NE(c.Load(src, SkipFuncBodies), nullptr);
+
+    // a warm parse yields the skipped bodies, ready to be parsed
+    auto g = cache::ParseCached(c, src, errh, SkipFuncBodies);
+    auto m = std::dynamic_pointer_cast<ast::FuncDecl>(g->DeclList[3]);
+    ASSERT_TRUE(m->Skipped());
+    ASSERT_NE(ParseFuncBody(src, m.get(), errh), nullptr);
+    EXPECT_EQ(m->Body->List.size(), 3u);
+
+    // files with errors are not cached
+    std::string bad = "package p\nvar x = \n";
+    int errors = 0;
+    cache::ParseCached(c, bad, [&](uint, uint, std::string) { errors++; });
+    EXPECT_EQ(errors, 1);
+    EXPECT_EQ(c.Load(bad), nullptr);
+}
+
+TEST(AstCacheTest, test_packed_round_trip) {
+    TempDir dir;
+    cache::AstCache c(dir.path);
+    std::string packed = "package p\n\nvar b = []uint16{";
+    for (int i = 0; i < 100; i++) {
+        packed += std::to_string(i * 655) + ", ";
+    }
+    packed += "}\n";
+    auto f = parse(packed);
+    ASSERT_TRUE(c.Store(packed, *f));
+    auto cached = c.Load(packed);
+    ASSERT_NE(cached, nullptr);
+    auto g = cached->Decode();
+    ASSERT_NE(g, nullptr);
+
+    auto hash = cache::AstCache::Hash(packed);
+    EXPECT_EQ(bytes(cache::Encode(*g, hash, 0)), bytes(cache::Encode(*f, hash, 0)));
+
+    auto v = std::dynamic_pointer_cast<ast::VarDecl>(g->DeclList[0]);
+    auto lit = std::dynamic_pointer_cast<ast::CompositeLit>(v->Values);
+    ASSERT_NE(lit->Packed, nullptr);
+    EXPECT_TRUE(lit->ElemList.empty());
+    EXPECT_EQ(lit->Packed->ElemSize, 2);
+    ASSERT_EQ(lit->Packed->Len(), 100u);
+    EXPECT_EQ(lit->Packed->At(99), 99u * 655);
+}
+
+TEST(AstCacheTest, test_embed_round_trip) {
+    TempDir dir;
+    cache::AstCache c(dir.path);
+    std::string embed = "package p\n\n//go:embed a.txt \"b c.txt\"\nvar s string\n";
+    auto f = parse(embed, directives);
+    ASSERT_TRUE(c.Store(embed, *f, directives));
+    auto cached = c.Load(embed, directives);
+    ASSERT_NE(cached, nullptr);
+    auto g = cached->Decode();
+    ASSERT_NE(g, nullptr);
+    auto v = std::dynamic_pointer_cast<ast::VarDecl>(g->DeclList[0]);
+    EXPECT_EQ(v->EmbedPatterns, (std::vector<std::string>{"a.txt", "b c.txt"}));
+}
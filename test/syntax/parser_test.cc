@@ -0,0 +1,450 @@
+#include "syntax/parser.hh"
+
+#include <fmt/format.h>
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+using namespace syntax;
+
+namespace {
+
+struct Errors {
+    std::vector<std::string> msgs;
+    err_handler handler() {
+        return [this](uint line, uint col, std::string msg) {
+            msgs.push_back(std::to_string(line) + ":" + std::to_string(col) + ": " + msg);
+        };
+    }
+};
+
+Position where(Pos p) { return FileSet::Global().Resolve(p); }
+
+ast::FilePtr parse(const std::string &src, Errors &errs, uint mode = 0) {
+    return Parse(std::make_unique<std::istringstream>(src), errs.handler(), mode);
+}
+
+// parseExpr parses x as the initializer of a package-level variable.
+ast::ExprNodePtr parseExpr(const std::string &x) {
+    Errors errs;
+    auto f = parse("package p; var _ = " + x, errs);
+    EXPECT_TRUE(errs.msgs.empty()) << errs.msgs.front();
+    auto d = std::dynamic_pointer_cast<ast::VarDecl>(f->DeclList.at(0));
+    return d->Values;
+}
+
+} // namespace
+
+TEST(ParserTest, test_file) {
+    Errors errs;
+    auto f = parse(R"(package main
+
+import (
+	"fmt"
+	str "strings"
+)
+
+const a, b = 1, "x"
+
+type T struct {
+	x, y int
+	*U
+}
+
+func (t *T) M(a int, b ...string) (int, error) {
+	return 0, nil
+}
+
+func main() {
+	fmt.Println(str.ToUpper("hi"))
+}
+)",
+                   errs);
+    ASSERT_TRUE(errs.msgs.empty()) << errs.msgs.front();
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(f->PkgName->Value, "main");
+    ASSERT_EQ(f->DeclList.size(), 6u);
+
+    auto i0 = std::dynamic_pointer_cast<ast::ImportDecl>(f->DeclList[0]);
+    auto i1 = std::dynamic_pointer_cast<ast::ImportDecl>(f->DeclList[1]);
+    ASSERT_NE(i1, nullptr);
+    EXPECT_EQ(i0->Group, i1->Group);
+    EXPECT_EQ(i1->LocalPkgName->Value, "str");
+    EXPECT_EQ(i1->LocalPkgName->Sym, common::Interner::Global().Intern("str"));
+    EXPECT_EQ(i1->Path->Value, "\"strings\"");
+
+    auto t = std::dynamic_pointer_cast<ast::TypeDecl>(f->DeclList[3]);
+    auto st = std::dynamic_pointer_cast<ast::StructType>(t->Type);
+    ASSERT_NE(st, nullptr);
+    ASSERT_EQ(st->FieldList.size(), 3u);
+    EXPECT_EQ(st->FieldList[2]->Name, nullptr);
+
+    auto m = std::dynamic_pointer_cast<ast::FuncDecl>(f->DeclList[4]);
+    ASSERT_NE(m->Recv, nullptr);
+    EXPECT_EQ(m->Name->Value, "M");
+    EXPECT_EQ(ast::String(m->Type.get()), "func(a int, b ...string) (int, error)");
+    EXPECT_EQ(m->Body->List.size(), 1u);
+    EXPECT_EQ(where(m->pos).Line, 15);
+    EXPECT_EQ(where(m->pos).Col, 6);
+    EXPECT_LT(f->DeclList[3]->pos, m->pos);
+}
+
+TEST(ParserTest, test_precedence) {
+    EXPECT_EQ(ast::String(parseExpr("a + b * c").get()), "a + b * c");
+    auto x = std::dynamic_pointer_cast<ast::Operation>(parseExpr("a + b * c - d"));
+    ASSERT_NE(x, nullptr);
+    EXPECT_EQ(x->Op, Operator_Sub);
+    auto l = std::dynamic_pointer_cast<ast::Operation>(x->X);
+    EXPECT_EQ(l->Op, Operator_Add);
+    EXPECT_EQ(ast::String(l->Y.get()), "b * c");
+
+    x = std::dynamic_pointer_cast<ast::Operation>(parseExpr("a || b && c == d"));
+    EXPECT_EQ(x->Op, Operator_OrOr);
+    EXPECT_EQ(ast::String(x->Y.get()), "b && c == d");
+
+    x = std::dynamic_pointer_cast<ast::Operation>(parseExpr("-x.y[i](z) << 2"));
+    EXPECT_EQ(x->Op, Operator_Shl);
+    EXPECT_EQ(ast::String(x->X.get()), "-x.y[i](z)");
+
+    EXPECT_EQ(ast::String(parseExpr("(a + b) * c").get()), "(a + b) * c");
+    // <-chan int(ch) receives from the conversion chan int(ch).
+    x = std::dynamic_pointer_cast<ast::Operation>(parseExpr("<-chan int(ch)"));
+    ASSERT_NE(x, nullptr);
+    EXPECT_EQ(x->Op, Operator_Recv);
+    EXPECT_NE(std::dynamic_pointer_cast<ast::CallExpr>(x->X), nullptr);
+    auto c = std::dynamic_pointer_cast<ast::ChanType>(parseExpr("<-chan <-chan int"));
+    ASSERT_NE(c, nullptr);
+    EXPECT_EQ(c->Dir, RecvOnly);
+    EXPECT_EQ(std::dynamic_pointer_cast<ast::ChanType>(c->Elem)->Dir, RecvOnly);
+}
+
+TEST(ParserTest, test_statements) {
+    Errors errs;
+    auto f = parse(R"(package p
+func f(ch chan int, m map[string][]int) {
+L:
+	for i := 0; i < 10; i++ {
+		if x, ok := m["a"]; ok && len(x) > i {
+			continue L
+		} else if i == 3 {
+			break
+		}
+	}
+	for k, v := range m {
+		_, _ = k, v
+	}
+	switch x := interface{}(ch).(type) {
+	case chan int:
+		_ = x
+	default:
+	}
+	select {
+	case v := <-ch:
+		ch <- v
+	default:
+	}
+	defer func() { recover() }()
+	go f(nil, nil)
+	s := []T{{1, 2}, {3, 4}}
+	if s == nil {
+	}
+}
+)",
+                   errs);
+    ASSERT_TRUE(errs.msgs.empty()) << errs.msgs.front();
+    auto fn = std::dynamic_pointer_cast<ast::FuncDecl>(f->DeclList.at(0));
+    auto &list = fn->Body->List;
+    ASSERT_EQ(list.size(), 8u);
+    EXPECT_NE(std::dynamic_pointer_cast<ast::LabeledStmt>(list[0]), nullptr);
+    auto r = std::dynamic_pointer_cast<ast::ForStmt>(list[1]);
+    ASSERT_NE(r, nullptr);
+    EXPECT_NE(std::dynamic_pointer_cast<ast::RangeClause>(r->Init), nullptr);
+    auto sw = std::dynamic_pointer_cast<ast::SwitchStmt>(list[2]);
+    auto g = std::dynamic_pointer_cast<ast::TypeSwitchGuard>(sw->Tag);
+    ASSERT_NE(g, nullptr);
+    EXPECT_EQ(g->Lhs->Value, "x");
+    EXPECT_EQ(sw->Body.size(), 2u);
+    EXPECT_NE(std::dynamic_pointer_cast<ast::SelectStmt>(list[3]), nullptr);
+    EXPECT_NE(std::dynamic_pointer_cast<ast::CallStmt>(list[4]), nullptr);
+    auto a = std::dynamic_pointer_cast<ast::AssignStmt>(list[6]);
+    ASSERT_NE(a, nullptr);
+    auto lit = std::dynamic_pointer_cast<ast::CompositeLit>(a->Rhs);
+    ASSERT_NE(lit, nullptr);
+    EXPECT_EQ(lit->ElemList.size(), 2u);
+}
+
+TEST(ParserTest, test_errors) {
+    Errors errs;
+    auto f = parse("package p\nfunc f() {\n\tx := \n}\nvar y int = 1 +\n", errs);
+    ASSERT_NE(f, nullptr);
+    ASSERT_FALSE(errs.msgs.empty());
+    EXPECT_EQ(errs.msgs[0], "4:1: syntax error: unexpected }, expecting expression");
+
+    errs.msgs.clear();
+    f = parse("func f() {}", errs);
+    EXPECT_EQ(f, nullptr);
+    ASSERT_EQ(errs.msgs.size(), 1u);
+    EXPECT_EQ(errs.msgs[0], "1:1: syntax error: package statement must be first");
+
+    errs.msgs.clear();
+    parse("package p; func f() { if x := 0 { } }", errs);
+    ASSERT_EQ(errs.msgs.size(), 1u);
+    EXPECT_EQ(errs.msgs[0], "1:28: syntax error: cannot use assignment (x) := (0) as value");
+}
+
+TEST(ParserTest, test_skip_func_bodies) {
+    std::string src = R"(package p
+
+func f(x int) int {
+	if x > 0 { return x }
+	return -x
+}
+
+var g = func() {}
+
+func h() { y := "}"; _ = y }
+)";
+    Errors errs;
+    auto f = Parse(std::make_unique<std::istringstream>(src), errs.handler(), SkipFuncBodies);
+    ASSERT_TRUE(errs.msgs.empty()) << errs.msgs.front();
+    ASSERT_EQ(f->DeclList.size(), 3u);
+    auto f0 = std::dynamic_pointer_cast<ast::FuncDecl>(f->DeclList[0]);
+    auto f2 = std::dynamic_pointer_cast<ast::FuncDecl>(f->DeclList[2]);
+    EXPECT_TRUE(f0->Skipped());
+    EXPECT_EQ(where(f0->BodyLbrace).Line, 3);
+    EXPECT_EQ(where(f0->BodyRbrace).Line, 6);
+    EXPECT_EQ(src[where(f2->BodyRbrace).Offset], '}');
+
+    auto body = ParseFuncBody(src, f0.get(), errs.handler());
+    ASSERT_NE(body, nullptr);
+    EXPECT_FALSE(f0->Skipped());
+    EXPECT_EQ(ParseFuncBody(src, f0.get(), errs.handler()), nullptr);
+
+    // positions match those of a full parse
+    auto full = Parse(std::make_unique<std::istringstream>(src), errs.handler());
+    auto body2 = std::dynamic_pointer_cast<ast::FuncDecl>(full->DeclList[0])->Body;
+    ASSERT_EQ(body->List.size(), body2->List.size());
+    for (size_t i = 0; i < body->List.size(); i++) {
+        EXPECT_EQ(where(body->List[i]->pos), where(body2->List[i]->pos));
+    }
+    EXPECT_EQ(where(body->Rbrace), where(body2->Rbrace));
+    EXPECT_TRUE(errs.msgs.empty());
+}
+
+TEST(ParserTest, test_imports_only) {
+    Errors errs;
+    auto f = parse(R"(package p
+
+import "a"
+import (
+	b "x/b"
+	. "c"
+)
+
+func f() { this is not parsed }
+)",
+                   errs, ImportsOnly);
+    ASSERT_TRUE(errs.msgs.empty()) << errs.msgs.front();
+    ASSERT_EQ(f->DeclList.size(), 3u);
+    auto d = std::dynamic_pointer_cast<ast::ImportDecl>(f->DeclList[1]);
+    EXPECT_EQ(d->LocalPkgName->Value, "b");
+    EXPECT_EQ(d->Path->Value, "\"x/b\"");
+}
+
+TEST(ParserTest, test_parallel_func_bodies) {
+    std::string src = "package p\n";
+    for (int i = 0; i < 64; i++) {
+        src += "func f" + std::to_string(i) + "() {\n" + (i % 16 == 0 ? "\tx := \n" : "\tx := 1; _ = x\n") + "}\n";
+    }
+    Errors errs;
+    auto f = Parse(std::make_unique<std::istringstream>(src), errs.handler(), SkipFuncBodies);
+    ASSERT_TRUE(errs.msgs.empty());
+    ParseFuncBodies(src, f.get(), errs.handler());
+    for (auto &d : f->DeclList) {
+        EXPECT_NE(std::dynamic_pointer_cast<ast::FuncDecl>(d)->Body, nullptr);
+    }
+    ASSERT_EQ(errs.msgs.size(), 4u);
+    EXPECT_EQ(errs.msgs[0], "4:1: syntax error: unexpected }, expecting expression");
+    EXPECT_EQ(errs.msgs[3], "148:1: syntax error: unexpected }, expecting expression");
+}
+
+TEST(ParserTest, test_spans) {
+    std::string src = R"(package p
+
+var x = f(a, b)[i] + -y.z
+
+func (t *T) M(n int) {
+	for i := 0; i < n; i++ {
+		m[k] = T{1, k: {2}}
+	}
+}
+)";
+    Errors errs;
+    auto f = Parse(std::make_unique<std::istringstream>(src), errs.handler());
+    ASSERT_TRUE(errs.msgs.empty()) << errs.msgs.front();
+    EXPECT_EQ(f->Text(), src);
+
+    auto v = std::dynamic_pointer_cast<ast::VarDecl>(f->DeclList.at(0));
+    EXPECT_EQ(v->Text(), "x = f(a, b)[i] + -y.z");
+    auto sum = std::dynamic_pointer_cast<ast::Operation>(v->Values);
+    EXPECT_EQ(sum->Text(), "f(a, b)[i] + -y.z");
+    EXPECT_EQ(sum->X->Text(), "f(a, b)[i]");
+    EXPECT_EQ(std::dynamic_pointer_cast<ast::IndexExpr>(sum->X)->X->Text(), "f(a, b)");
+    EXPECT_EQ(sum->Y->Text(), "-y.z");
+
+    auto m = std::dynamic_pointer_cast<ast::FuncDecl>(f->DeclList.at(1));
+    EXPECT_EQ(m->Text().substr(0, 21), "func (t *T) M(n int) ");
+    EXPECT_EQ(m->Recv->Text(), "t *T");
+    EXPECT_EQ(m->Recv->Type->Text(), "*T");
+    auto loop = std::dynamic_pointer_cast<ast::ForStmt>(m->Body->List.at(0));
+    EXPECT_EQ(loop->Init->Text(), "i := 0");
+    EXPECT_EQ(loop->Cond->Text(), "i < n");
+    EXPECT_EQ(loop->Post->Text(), "i++");
+    auto a = std::dynamic_pointer_cast<ast::AssignStmt>(loop->Body->List.at(0));
+    EXPECT_EQ(a->Text(), "m[k] = T{1, k: {2}}");
+    auto lit = std::dynamic_pointer_cast<ast::CompositeLit>(a->Rhs);
+    EXPECT_EQ(lit->ElemList.at(1)->Text(), "k: {2}");
+    EXPECT_EQ(std::dynamic_pointer_cast<ast::KeyValueExpr>(lit->ElemList[1])->Value->Text(), "{2}");
+    EXPECT_EQ(where(a->GetSpan().Start).Line, 7);
+
+    // nodes copy no text: a span is a position and a length
+    EXPECT_EQ(sizeof(Span), 8u);
+}
+
+TEST(ParserTest, test_packed_literals) {
+    // elems returns n comma-separated integer literals i*37 % 256, in hex
+    auto elems = [](int n) {
+        std::string s;
+        for (int i = 0; i < n; i++) {
+            s += fmt::format("0x{:02x}, ", i * 37 % 256);
+        }
+        return s;
+    };
+    auto lit = [](const std::string &x) { return std::dynamic_pointer_cast<ast::CompositeLit>(parseExpr(x)); };
+
+    auto x = lit("[]byte{" + elems(100) + "}");
+    ASSERT_NE(x->Packed, nullptr);
+    EXPECT_TRUE(x->ElemList.empty());
+    ASSERT_EQ(x->Packed->Len(), 100u);
+    EXPECT_EQ(x->Packed->Data.size(), 100u);
+    EXPECT_EQ(x->Packed->At(7), 7u * 37 % 256);
+    EXPECT_EQ(ast::String(x.get()).substr(0, 16), "[]byte{0, 37, 74");
+
+    x = lit("[...]uint32{1_000, 0b11, 0o17, 017, 4294967295, " + elems(100) + "}");
+    ASSERT_NE(x->Packed, nullptr);
+    EXPECT_EQ(x->Packed->ElemSize, 4);
+    EXPECT_EQ(x->Packed->At(0), 1000u);
+    EXPECT_EQ(x->Packed->At(1), 3u);
+    EXPECT_EQ(x->Packed->At(2), 15u);
+    EXPECT_EQ(x->Packed->At(3), 15u);
+    EXPECT_EQ(x->Packed->At(4), 4294967295u);
+
+    // small literals keep their nodes
+    x = lit("[]byte{1, 0x2}");
+    EXPECT_EQ(x->Packed, nullptr);
+    ASSERT_EQ(x->ElemList.size(), 2u);
+    EXPECT_EQ(std::dynamic_pointer_cast<ast::BasicLit>(x->ElemList[1])->Value, "0x2");
+
+    // values out of range, other elements and keys fall back to nodes
+    // without losing the elements consumed so far
+    for (auto tail : {"256", "y", "'a'", "-1", "1 << 8", "(1)", "99: 1"}) {
+        Errors errs;
+        auto f = parse("package p; var _ = []byte{" + elems(100) + tail + "}", errs);
+        ASSERT_TRUE(errs.msgs.empty()) << tail << ": " << errs.msgs.front();
+        auto d = std::dynamic_pointer_cast<ast::VarDecl>(f->DeclList.at(0));
+        x = std::dynamic_pointer_cast<ast::CompositeLit>(d->Values);
+        EXPECT_EQ(x->Packed, nullptr) << tail;
+        ASSERT_EQ(x->ElemList.size(), 101u) << tail;
+        auto e = std::dynamic_pointer_cast<ast::BasicLit>(x->ElemList[4]);
+        EXPECT_EQ(e->Value, "0x94") << tail;
+        EXPECT_EQ(e->Text(), "0x94") << tail;
+        EXPECT_EQ(where(e->pos).Col, 27 + 6 * 4) << tail;
+        EXPECT_EQ(x->ElemList[100]->Text(), tail) << tail;
+        EXPECT_EQ(ast::String(x->ElemList[100].get()), tail) << tail;
+    }
+}
+
+TEST(ParserTest, test_go_embed) {
+    Errors errs;
+    auto f = parse(R"(package p
+
+import "embed"
+
+//go:embed hello.txt
+var s string
+
+var (
+	//go:embed "a b.txt" `c.txt` static/*
+	fs embed.FS
+
+	n int
+)
+)",
+                   errs, directives);
+    ASSERT_NE(f, nullptr);
+    EXPECT_TRUE(errs.msgs.empty()) << errs.msgs.front();
+    auto embeds = [&](size_t i) { return std::dynamic_pointer_cast<ast::VarDecl>(f->DeclList.at(i))->EmbedPatterns; };
+    EXPECT_EQ(embeds(1), std::vector<std::string>{"hello.txt"});
+    EXPECT_EQ(embeds(2), (std::vector<std::string>{"a b.txt", "c.txt", "static/*"}));
+    EXPECT_TRUE(embeds(3).empty());
+
+    // without directives mode, //go:embed is an ordinary comment
+    f = parse("package p\n//go:embed x\nvar s string\n", errs);
+    EXPECT_TRUE(errs.msgs.empty());
+    EXPECT_TRUE(std::dynamic_pointer_cast<ast::VarDecl>(f->DeclList.at(0))->EmbedPatterns.empty());
+
+    for (auto [src, msg] : std::vector<std::pair<std::string, std::string>>{
+             {"//go:embed x\nvar a, b string", "2:1: go:embed cannot apply to multiple vars"},
+             {"//go:embed x\nvar a = \"\"", "2:1: go:embed cannot apply to var with initializer"},
+             {"func f() {\n//go:embed x\nvar s string\n}", "3:1: go:embed cannot apply to var inside func"},
+             {"//go:embed x\nconst c = 1", "2:1: misplaced compiler directive"},
+             {"//go:embed x\nvar (\n\ts string\n)", "2:1: misplaced compiler directive"},
+             {"var s string //go:embed x\n", "2:14: misplaced compiler directive"},
+             {"//go:embed\nvar s string", "2:1: usage: //go:embed pattern..."},
+             {"//go:embed \"x\nvar s string", "2:1: invalid quoted string in //go:embed \"x"},
+             {"//go:embed `x`y\nvar s string", "2:1: invalid quoted string in //go:embed `x`y"},
+         }) {
+        errs.msgs.clear();
+        parse("package p\n" + src, errs, directives);
+        ASSERT_EQ(errs.msgs.size(), 1u) << src;
+        EXPECT_EQ(errs.msgs[0], msg) << src;
+    }
+
+    std::vector<std::string> patterns;
+    EXPECT_TRUE(ParseGoEmbed(R"( a	"b\tc\"" `d\e` )", patterns));
+    EXPECT_EQ(patterns, (std::vector<std::string>{"a", "b\tc\"", "d\\e"}));
+    EXPECT_FALSE(ParseGoEmbed(R"("\q")", patterns));
+}
+
+TEST(ParserTest, test_type_params) {
+    Errors errs;
+    auto f = parse(R"(package p
+
+type Number interface {
+	~int | ~float64
+	String() string
+}
+
+func Map[S ~[]E, E, R any](s S, f func(E) R) []R { return nil }
+
+var x = Map[[]int, int, string]
+var y = a[i]
+)",
+                   errs);
+    ASSERT_TRUE(errs.msgs.empty()) << errs.msgs.front();
+    auto fn = std::dynamic_pointer_cast<ast::FuncDecl>(f->DeclList.at(1));
+    ASSERT_EQ(fn->TParamList.size(), 3u);
+    EXPECT_EQ(fn->TParamList[0]->Name->Value, "S");
+    EXPECT_EQ(ast::String(fn->TParamList[0]->Type.get()), "~[]E");
+    // grouped type parameters share their constraint
+    EXPECT_EQ(fn->TParamList[1]->Type, fn->TParamList[2]->Type);
+
+    auto value = [&](size_t i) {
+        auto idx = cast<ast::IndexExpr>(std::dynamic_pointer_cast<ast::VarDecl>(f->DeclList.at(i))->Values.get());
+        return idx->Index.get();
+    };
+    auto list = dyn_cast<ast::ListExpr>(value(2));
+    ASSERT_NE(list, nullptr);
+    EXPECT_EQ(list->ElemList.size(), 3u);
+    EXPECT_FALSE(isa<ast::ListExpr>(value(3)));
+}
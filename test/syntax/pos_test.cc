@@ -0,0 +1,96 @@
+#include "syntax/pos.hh"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "syntax/parser.hh"
+
+using namespace syntax;
+
+TEST(PosTest, test_resolve) {
+    FileSet set;
+    auto a = set.AddFile("a.go", 10);
+    auto b = set.AddFile("b.go", 5);
+    // "ab\ncd\n\nef" spread over lines 1-4
+    for (auto offset : {3, 6, 7}) {
+        a->AddLine(offset);
+    }
+    a->AddLine(6); // out of order: ignored
+    EXPECT_EQ(a->Lines().size(), 4u);
+
+    EXPECT_EQ(set.Resolve(a->At(0)), (Position{"a.go", 1, 1, 0}));
+    EXPECT_EQ(set.Resolve(a->At(4)), (Position{"a.go", 2, 2, 4}));
+    EXPECT_EQ(set.Resolve(a->At(6)), (Position{"a.go", 3, 1, 6}));
+    EXPECT_EQ(set.Resolve(a->At(10)), (Position{"a.go", 4, 4, 10})); // EOF
+    EXPECT_EQ(set.Resolve(b->At(2)), (Position{"b.go", 1, 3, 2}));
+    EXPECT_EQ(set.Resolve(Pos()), Position{});
+
+    // positions of later files compare greater
+    EXPECT_LT(a->At(10), b->At(0));
+    EXPECT_EQ(set.File(a->At(10)), a);
+    EXPECT_EQ(set.File(b->At(0)), b);
+    EXPECT_EQ(set.File(Pos(b->Base() + 6)), nullptr);
+    EXPECT_EQ(sizeof(Pos), 4u);
+}
+
+TEST(PosTest, test_release) {
+    FileSet set;
+    auto a = set.AddFile("a.go", 10);
+    auto b = set.AddFile("b.go", 5);
+    auto c = set.AddFile("c.go", 5);
+    auto pa = a->At(3), pb = b->At(0), pc = c->At(5);
+
+    set.Release(pb);
+    EXPECT_EQ(set.File(pb), nullptr);
+    EXPECT_EQ(set.Resolve(pb), Position{});
+    EXPECT_EQ(set.Resolve(pa).Filename, "a.go");
+    EXPECT_EQ(set.Resolve(pc).Filename, "c.go");
+    set.Release(pb); // released already
+
+    // the range of the last files is reused
+    set.Release(pc);
+    auto d = set.AddFile("d.go", 2);
+    EXPECT_EQ(d->Base(), a->Base() + a->Size() + 1);
+    set.Release(pa);
+    set.Release(d->At(0));
+    EXPECT_EQ(set.AddFile("e.go", 1)->Base(), 1u);
+
+    // a set out of positions adds no file
+    EXPECT_EQ(set.AddFile("big.go", int64_t(UINT32_MAX) - 3), nullptr);
+    auto f = set.AddFile("f.go", int64_t(UINT32_MAX) - 4);
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(set.AddFile("g.go", 0), nullptr);
+    set.Release(f->At(0));
+    EXPECT_NE(set.AddFile("g.go", 0), nullptr);
+}
+
+TEST(PosTest, test_parsed_positions) {
+    std::string src = "package p\n\nvar x = 1 +\n\t\"s\"\n";
+    auto f = Parse(std::make_unique<std::istringstream>(src), nullptr);
+    ASSERT_NE(f, nullptr);
+    auto file = FileSet::Global().File(f->pos);
+    ASSERT_NE(file, nullptr);
+    EXPECT_EQ(file->Size(), src.size());
+    EXPECT_EQ(file->Lines().size(), 5u);
+    auto d = std::dynamic_pointer_cast<ast::VarDecl>(f->DeclList.at(0));
+    auto op = std::dynamic_pointer_cast<ast::Operation>(d->Values);
+    EXPECT_EQ(file->Resolve(op->Y->pos), (Position{"", 4, 2, int64_t(src.find('"'))}));
+    EXPECT_EQ(file->Resolve(f->Eof).Line, 5);
+
+    // non-seekable input is buffered to learn its size
+    std::stringstream in;
+    in << src;
+    struct unseekable : std::istream {
+        explicit unseekable(std::streambuf *b) : std::istream(b) {}
+    };
+    struct nobuf : std::streambuf {
+        std::streambuf *b;
+        explicit nobuf(std::streambuf *b) : b(b) {}
+        int underflow() override { return b->sgetc(); }
+        int uflow() override { return b->sbumpc(); }
+    } buf(in.rdbuf());
+    auto g = Parse(std::make_unique<unseekable>(&buf), nullptr);
+    ASSERT_NE(g, nullptr);
+    EXPECT_EQ(FileSet::Global().File(g->pos)->Size(), src.size());
+}
@@ -0,0 +1,41 @@
+#include "syntax/scanner.hh"
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include <sstream>
+
+#include "common/interner.hh"
+
+using namespace syntax;
+
+namespace {
+
+// scan returns the names scanned from src and the errors as "line:col: msg".
+std::pair<std::vector<std::string>, std::vector<std::string>> scan(const std::string &src) {
+    std::vector<std::string> names, errs;
+    scanner s;
+    s.init(
+        std::make_unique<std::istringstream>(src),
+        [&](uint line, uint col, std::string msg) { errs.push_back(fmt::format("{}:{}: {}", line, col, msg)); }, 0);
+    for (s.next(); s._tok != Token_EOF; s.next()) {
+        if (s._tok == Token_Name) {
+            names.emplace_back(common::Interner::Global().Name(s._sym));
+        }
+    }
+    return {names, errs};
+}
+
+} // namespace
+
+TEST(ScannerTest, test_unicode_identifiers) {
+    // letters and decimal digits of any script make up identifiers
+    auto [names, errs] = scan("café π 日本語 x٣ _ü Ωmega\n");
+    EXPECT_EQ(names, (std::vector<std::string>{"café", "π", "日本語", "x٣", "_ü", "Ωmega"}));
+    EXPECT_TRUE(errs.empty());
+
+    // but not symbols, nor digits first
+    std::tie(names, errs) = scan("a€b ٣x\n");
+    EXPECT_EQ(errs, (std::vector<std::string>{"1:2: invalid character U+20AC '€' in identifier",
+                                              "1:7: identifier cannot begin with digit U+0663 '٣'"}));
+}
@@ -0,0 +1,631 @@
+#include "syntax/types/check.hh"
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include <sstream>
+
+#include "syntax/ast/walk.hh"
+#include "syntax/parser.hh"
+
+using namespace types;
+
+namespace {
+
+ast::FilePtr parse(const std::string &s) {
+    return syntax::Parse(std::make_unique<std::istringstream>(s), [](uint line, uint col, std::string msg) {
+        FAIL() << line << ":" << col << ": " << msg;
+    });
+}
+
+// check type-checks src and returns the errors as "line:col: msg".
+std::vector<std::string> check(Checker &c, const ast::FilePtr &f, bool parallel = true) {
+    ast::File *files[] = {f.get()};
+    std::vector<std::string> out;
+    for (auto &e : c.Check(files, parallel)) {
+        auto p = syntax::FileSet::Global().Resolve(e.Pos);
+        out.push_back(fmt::format("{}:{}: {}", p.Line, p.Col, e.Msg));
+    }
+    return out;
+}
+
+std::vector<std::string> check(const std::string &src) {
+    Checker c;
+    return check(c, parse(src));
+}
+
+std::string typeOf(const Checker &c, std::string_view name) {
+    auto obj = c.PackageScope().LookupLocal(common::Interner::Global().Intern(name));
+    return obj == nullptr ? "<nil>" : TypeTable::Global().String(obj->Type);
+}
+
+} // namespace
+
+TEST(CheckTest, test_declarations) {
+    auto f = parse(R"(package p
+
+const (
+	A = iota * 10
+	B
+	C int8 = 1 << 6
+)
+
+type Point struct {
+	X, Y int
+	next *Point
+}
+
+func (p *Point) Len() int { return p.X + p.Y }
+
+var (
+	origin = Point{}
+	pts    = []*Point{{1, 2, nil}, {X: 3}}
+	n      = len(pts) + B
+	m      = map[string][]Point{"a": {origin}}
+	fn     = func(x float64) float64 { return x * 2 }
+	ch     = make(chan<- int, 1)
+	arr    = [...]byte{'a', 'b', 'c'}
+	r, ok  = m["a"]
+)
+)");
+    Checker c;
+    EXPECT_EQ(check(c, f), std::vector<std::string>{});
+    EXPECT_EQ(typeOf(c, "A"), "untyped int");
+    EXPECT_EQ(typeOf(c, "B"), "untyped int");
+    EXPECT_EQ(typeOf(c, "C"), "int8");
+    EXPECT_EQ(c.PackageScope().LookupLocal(common::Interner::Global().Intern("B"))->Val.Int64Val(), 10);
+    EXPECT_EQ(typeOf(c, "origin"), "Point");
+    EXPECT_EQ(typeOf(c, "pts"), "[]*Point");
+    EXPECT_EQ(typeOf(c, "n"), "int");
+    EXPECT_EQ(typeOf(c, "m"), "map[string][]Point");
+    EXPECT_EQ(typeOf(c, "fn"), "func(float64) float64");
+    EXPECT_EQ(typeOf(c, "ch"), "chan<- int");
+    EXPECT_EQ(typeOf(c, "arr"), "[3]uint8");
+    EXPECT_EQ(typeOf(c, "r"), "[]Point");
+    EXPECT_EQ(typeOf(c, "ok"), "bool");
+
+    auto point = c.PackageScope().LookupLocal(common::Interner::Global().Intern("Point"))->Type;
+    ASSERT_EQ(c.Methods(point).size(), 1u);
+    EXPECT_TRUE(c.Methods(point)[0]->PtrRecv);
+    EXPECT_EQ(TypeTable::Global().String(c.Methods(point)[0]->Type), "func() int");
+}
+
+TEST(CheckTest, test_expression_types) {
+    auto f = parse(R"(package p
+
+func f(s []string, b byte) {
+	x := len(s) * 2
+	y := 1.5
+	z := b + 1
+	w := s[0] + "!"
+	_, _, _, _ = x, y, z, w
+}
+)");
+    Checker c;
+    EXPECT_EQ(check(c, f), std::vector<std::string>{});
+    auto body = cast<ast::FuncDecl>(f->DeclList[0].get())->Body;
+    auto rhs = [&](size_t i) { return cast<ast::AssignStmt>(body->List[i].get())->Rhs.get(); };
+    auto &table = TypeTable::Global();
+    EXPECT_EQ(table.String(rhs(0)->GetType()), "int");
+    EXPECT_EQ(table.String(cast<ast::Operation>(rhs(0))->Y->GetType()), "int");
+    EXPECT_EQ(table.String(rhs(1)->GetType()), "float64");
+    EXPECT_EQ(table.String(rhs(2)->GetType()), "uint8");
+    EXPECT_EQ(table.String(cast<ast::Operation>(rhs(2))->Y->GetType()), "uint8");
+    EXPECT_EQ(table.String(rhs(3)->GetType()), "string");
+
+    // names resolve to their objects
+    auto lhs = cast<ast::Name>(cast<ast::AssignStmt>(body->List[0].get())->Lhs.get());
+    auto x = c.ObjectOf(lhs);
+    ASSERT_NE(x, nullptr);
+    EXPECT_EQ(x->Kind, ObjKind::Var);
+    EXPECT_TRUE(x->Used);
+}
+
+TEST(CheckTest, test_errors) {
+    auto errors = check(R"(package p
+
+import "strings"
+
+type I interface{ M() }
+type T struct{}
+
+func (t *T) M() {}
+
+func f(a int) int {
+	var s string = a
+	u := 1
+	if a {
+	}
+	for {
+		break L
+	}
+}
+
+func g() (int, error) {
+	x, y := 1
+	var i I = T{}
+	var b byte = 300
+	return 1
+	undefined()
+}
+
+func h() {
+	continue
+	a, b := g()
+	a, b := g()
+	_ = b
+}
+)");
+    std::vector<std::string> want = {
+        "3:8: \"strings\" imported and not used",
+        "11:6: declared and not used: s",
+        "11:17: cannot use a (variable of type int) as string value in variable declaration",
+        "12:2: declared and not used: u",
+        "13:5: non-boolean condition in if statement",
+        "16:9: label L not defined",
+        "21:10: assignment mismatch: 2 variables but 1 value",
+        "22:6: declared and not used: i",
+        "22:13: cannot use T{} (value of type T) as I value in variable declaration: T does not implement I "
+        "(missing method M)",
+        "23:6: declared and not used: b",
+        "23:15: cannot use 300 (untyped int constant 300) as uint8 value (overflows)",
+        "24:2: not enough return values",
+        "25:2: undefined: undefined",
+        "26:1: missing return",
+        "29:2: continue is not in a loop",
+        "30:2: declared and not used: a",
+        "31:7: no new variables on left side of :=",
+    };
+    EXPECT_EQ(errors, want);
+}
+
+TEST(CheckTest, test_unused) {
+    // x op= y, x++ and x-- read x, so they use it as they do in gc and
+    // go/types; an assignment alone does not
+    auto errors = check(R"(package p
+
+func f() {
+	var n int
+	n += 1
+	m := 0
+	m++
+	k := 0
+	k = 1
+}
+)");
+    EXPECT_EQ(errors, std::vector<std::string>{"8:2: declared and not used: k"});
+}
+
+TEST(CheckTest, test_statements) {
+    // a valid package using most statements and built-ins
+    EXPECT_EQ(check(R"(package p
+
+type Shape interface {
+	Area() float64
+}
+
+type Rect struct{ W, H float64 }
+
+func (r Rect) Area() float64 { return r.W * r.H }
+
+type Named struct {
+	Rect
+	Name string
+}
+
+func kind(v any) string {
+	switch x := v.(type) {
+	case nil:
+		return "nil"
+	case int, int64:
+		return "int"
+	case Shape:
+		_ = x.Area()
+		return "shape"
+	default:
+		return "other"
+	}
+}
+
+func loops(xs []int, m map[string]int, ch chan int, done <-chan struct{}) (sum int) {
+outer:
+	for i, x := range xs {
+		switch {
+		case x < 0:
+			continue outer
+		case x == 0:
+			fallthrough
+		case x > 100:
+			break outer
+		}
+		sum += i * x
+	}
+	for k := range m {
+		delete(m, k)
+	}
+	for range 3 {
+		sum++
+	}
+	select {
+	case v, ok := <-ch:
+		if ok {
+			sum += v
+		}
+	case ch <- 1:
+	case <-done:
+		return
+	}
+	defer close(ch)
+	go func() { ch <- len(xs) }()
+	var shapes []Shape
+	shapes = append(shapes, Rect{1, 2}, Named{Rect{3, 4}, "n"})
+	n := Named{Name: "x"}
+	n.W = float64(copy(xs, xs[1:]))
+	_ = n.Area() + shapes[0].Area()
+	const big = 1 << 40
+	sum += int(big >> 38)
+	b := []byte("abc")
+	b = append(b, "def"...)
+	return sum + cap(b) + min(1, sum, 3)
+}
+
+func must(err error) {
+	if err != nil {
+		panic(err)
+	}
+}
+
+func forever() int {
+	for {
+	}
+}
+)"),
+              std::vector<std::string>{});
+}
+
+TEST(CheckTest, test_constants) {
+    auto f = parse(R"(package p
+
+const (
+	KB = 1 << (10 * (iota + 1))
+	MB
+	GB
+)
+
+const (
+	huge  = 1 << 100
+	back  = huge >> 98
+	third = 1 / 3.0
+	exact = third*3 == 1
+	f32   float32 = 0.1
+	mask  uint8 = ^uint8(0)
+	name  = "go" + "pher"
+	n     = len(name)
+	r     = string('a' + 1)
+	c     = (1 + 2i) * (1 - 2i)
+	re    = real(c)
+	i     int = 2.0
+	m     = max(3, 1.5, 2)
+)
+
+var arr [c]int
+
+func f(x int) {
+	switch x {
+	case 1, 2, 1:
+	}
+	switch "a" {
+	case "a", "b", "a":
+	}
+}
+
+const (
+	_ uint8 = 255 + 1
+	_ int = 1.5
+	_ = 1 << 600
+	_ = 1 / 0
+	_ = 1.0 / 0
+	_ = 1 << 1.5
+	_ = 1 << 2000
+	_ int8 = -128
+	_ = int8(-128) - 1
+	_ float32 = 1e39
+	_ = int(2.5)
+	_ = byte(256)
+)
+)");
+    Checker c;
+    std::vector<std::string> want = {
+        "29:13: duplicate case 1 in expression switch",
+        "32:17: duplicate case \"a\" in expression switch",
+        "37:16: cannot use 255 + 1 (untyped int constant 256) as uint8 value (overflows)",
+        "38:10: cannot use 1.5 (untyped float constant 1.5) as int value (truncated)",
+        "39:8: constant shift overflow",
+        "40:10: invalid operation: division by zero",
+        "41:12: invalid operation: division by zero",
+        "42:11: cannot use 1.5 (untyped float constant 1.5) as uint value (truncated)",
+        "43:11: invalid operation: invalid shift count 2000 (constant of type uint)",
+        "45:17: constant -129 overflows int8",
+        "46:14: cannot use 1e39 (untyped float constant 1e+39) as float32 value (overflows)",
+        "47:10: cannot convert 2.5 (untyped float constant) to type int (truncated)",
+        "48:11: cannot convert 256 (untyped int constant) to type uint8 (overflows)",
+    };
+    EXPECT_EQ(check(c, f), want);
+    auto val = [&](std::string_view name) {
+        return c.PackageScope().LookupLocal(common::Interner::Global().Intern(name))->Val;
+    };
+    EXPECT_EQ(val("GB").Int64Val(), int64_t(1) << 30);
+    EXPECT_TRUE(val("GB").IsInline());
+    EXPECT_EQ(val("huge").String(), "1267650600228229401496703205376");
+    EXPECT_EQ(val("back").Int64Val(), 4);
+    EXPECT_TRUE(val("exact").BoolVal());
+    EXPECT_EQ(val("f32").Float64Val(), double(0.1f));
+    EXPECT_EQ(val("mask").Int64Val(), 255);
+    EXPECT_EQ(val("name").StringVal(), "gopher");
+    EXPECT_EQ(val("n").Int64Val(), 6);
+    EXPECT_EQ(val("r").StringVal(), "b");
+    EXPECT_EQ(val("c").String(), "(5 + 0i)");
+    EXPECT_EQ(val("re").String(), "5");
+    EXPECT_EQ(val("i").Int64Val(), 2);
+    EXPECT_EQ(val("m").String(), "3");
+    EXPECT_EQ(typeOf(c, "arr"), "[5]int");
+    EXPECT_EQ(typeOf(c, "m"), "untyped float");
+}
+
+TEST(CheckTest, test_delayed_shifts) {
+    // a shift of an untyped constant by a variable count takes the type of
+    // its context, as go/types has it
+    auto f = parse(R"(package p
+
+var n uint = 3
+
+var x uint64 = 1 << n
+
+func bits(data uint64, start, end uint) uint {
+	return uint(data>>start) & ((1 << (end - start + 1)) - 1)
+}
+
+var (
+	i int     = 1.0 << n
+	u         = uint8(1 << n)
+	p         = 1<<n == 1<<33
+	a         [10]int
+	v         = a[1.0<<n]
+	k         = 1 << n
+	s         = []int{1 << n}
+	_ float32 = 1 << n
+	g         = 1.0 << n
+	h         = 1.0<<n != 0
+)
+)");
+    Checker c;
+    EXPECT_EQ(check(c, f), (std::vector<std::string>{
+                               "19:14: invalid operation: shifted operand 1 (type float32) must be integer",
+                               "20:14: invalid operation: shifted operand 1.0 (type float64) must be integer",
+                               "21:14: invalid operation: shifted operand 1.0 (type float64) must be integer",
+                           }));
+    EXPECT_EQ(typeOf(c, "x"), "uint64");
+    EXPECT_EQ(typeOf(c, "u"), "uint8");
+    EXPECT_EQ(typeOf(c, "p"), "bool");
+    EXPECT_EQ(typeOf(c, "k"), "int");
+
+    // the shifted constants are recorded with the type of the context
+    auto &table = TypeTable::Global();
+    auto value = [&](size_t decl) { return cast<ast::VarDecl>(f->DeclList[decl].get())->Values.get(); };
+    auto shl = cast<ast::Operation>(value(1));
+    EXPECT_EQ(table.String(shl->GetType()), "uint64");
+    EXPECT_EQ(table.String(shl->X->GetType()), "uint64");
+    auto ret = cast<ast::ReturnStmt>(cast<ast::FuncDecl>(f->DeclList[2].get())->Body->List[0].get());
+    auto mask = cast<ast::ParenExpr>(cast<ast::Operation>(ret->Results.get())->Y.get());
+    EXPECT_EQ(table.String(mask->GetType()), "uint");
+    auto sub = cast<ast::Operation>(mask->X.get());
+    EXPECT_EQ(table.String(cast<ast::ParenExpr>(sub->X.get())->X->GetType()), "uint");
+    EXPECT_EQ(table.String(sub->Y->GetType()), "uint");
+}
+
+TEST(CheckTest, test_cycles) {
+    EXPECT_EQ(check(R"(package p
+
+var a = b
+var b = c + a
+var c = 1
+)"),
+              std::vector<std::string>{"3:5: initialization cycle for a"});
+
+    EXPECT_EQ(check(R"(package p
+
+type A B
+type B A
+type S struct {
+	s S
+}
+type L struct {
+	next *L
+}
+)"),
+              (std::vector<std::string>{"3:6: invalid recursive type A", "5:6: invalid recursive type S"}));
+}
+
+TEST(CheckTest, test_init_order) {
+    auto f = parse(R"(package p
+
+var (
+	a = c + b
+	b = f()
+	c = f()
+	d = 3
+)
+
+func f() int {
+	d++
+	return d
+}
+)");
+    Checker c;
+    EXPECT_EQ(check(c, f), std::vector<std::string>{});
+    std::vector<std::string> order;
+    for (auto obj : c.InitOrder()) {
+        order.emplace_back(common::Interner::Global().Name(obj->Name));
+    }
+    EXPECT_EQ(order, (std::vector<std::string>{"d", "b", "c", "a"}));
+}
+
+TEST(CheckTest, test_parallel_deterministic) {
+    // a large package whose bodies have errors and refer to each other
+    std::string src = "package p\n\nvar total int\n\n";
+    for (int i = 0; i < 1200; i++) {
+        src += fmt::format(R"(func f{0}(n int) int {{
+	unused{0} := n
+	s := "x" + n
+	for i := 0; i < n; i++ {{
+		total += i
+	}}
+	if n > 0 {{
+		return f{1}(n - 1)
+	}}
+	return len(s)
+}}
+
+)",
+                           i, (i + 1) % 1200);
+    }
+    auto f = parse(src);
+    Checker seq;
+    auto want = check(seq, f, false);
+    EXPECT_EQ(want.size(), 2400u);
+    for (int run = 0; run < 3; run++) {
+        Checker c;
+        EXPECT_EQ(check(c, f, true), want);
+    }
+}
+
+TEST(CheckTest, test_generics) {
+    auto f = parse(R"(package p
+
+type Number interface {
+	~int | ~int64 | ~float64
+}
+
+type MyInt int
+
+func Sum[T Number](xs ...T) T {
+	var s T
+	for _, x := range xs {
+		s += x
+	}
+	return s
+}
+
+func Map[S ~[]E, E, R any](s S, f func(E) R) []R {
+	out := make([]R, 0, len(s))
+	for _, x := range s {
+		out = append(out, f(x))
+	}
+	return out
+}
+
+func Keys[K comparable, V any](m map[K]V) []K {
+	var out []K
+	for k := range m {
+		out = append(out, k)
+	}
+	return out
+}
+
+func Zero[T any]() T {
+	var z T
+	return z
+}
+
+var (
+	a = Sum(1, 2, 3)
+	b = Sum(1, 2.5)
+	c = Sum[MyInt](1, 2)
+	d = Sum(MyInt(1), 2)
+	e = Map([]int{1, 2}, func(x int) string { return "" })
+	g = Keys(map[string]bool{})
+	h = Zero[*MyInt]()
+	i = Map[[]MyInt]([]MyInt{1}, func(x MyInt) bool { return x > 0 })
+)
+)");
+    Checker c;
+    EXPECT_EQ(check(c, f), std::vector<std::string>{});
+    EXPECT_EQ(typeOf(c, "Sum"), "func(...T) T");
+    EXPECT_EQ(typeOf(c, "a"), "int");
+    EXPECT_EQ(typeOf(c, "b"), "float64");
+    EXPECT_EQ(typeOf(c, "c"), "MyInt");
+    EXPECT_EQ(typeOf(c, "d"), "MyInt");
+    EXPECT_EQ(typeOf(c, "e"), "[]string");
+    EXPECT_EQ(typeOf(c, "g"), "[]string");
+    EXPECT_EQ(typeOf(c, "h"), "*MyInt");
+    // the element type is inferred from the core type of the constraint
+    EXPECT_EQ(typeOf(c, "i"), "[]bool");
+
+    // instances are recorded by the name of the function
+    auto sum = c.PackageScope().LookupLocal(common::Interner::Global().Intern("Sum"));
+    std::vector<std::string> instances;
+    ast::Inspect(f.get(), [&](ast::Node *n) {
+        auto name = dyn_cast<ast::Name>(n);
+        if (auto inst = name == nullptr ? nullptr : c.InstanceOf(name); inst != nullptr && inst->Func == sum) {
+            instances.push_back(TypeTable::Global().String(inst->Type));
+        }
+        return true;
+    });
+    EXPECT_EQ(instances, (std::vector<std::string>{"func(...int) int", "func(...float64) float64",
+                                                   "func(...MyInt) MyInt", "func(...MyInt) MyInt"}));
+}
+
+TEST(CheckTest, test_generic_errors) {
+    auto errors = check(R"(package p
+
+type Stringer interface{ String() string }
+
+type Number interface{ ~int | float64 }
+
+type MyFloat float64
+
+func Max[T Number](a, b T) T { return a }
+
+func Join[T Stringer](xs []T) string { return "" }
+
+func Eq[T comparable](a, b T) bool { return a == b }
+
+func Less[T any](a, b T) bool { return a < b }
+
+func Pair[A, B any](a A) B {
+	var b B
+	return b
+}
+
+func init[T any]() {}
+
+var n Number
+
+func f() {
+	_ = Max(1, "a")
+	_ = Max(MyFloat(1), 2)
+	_ = Join([]int{})
+	_ = Eq([]int{}, nil)
+	_ = Pair(1)
+	_ = Pair[int, string, bool]
+	x := Max
+	_ = x
+	_ = Max[int]
+	_ = Pair[int]
+}
+)");
+    std::vector<std::string> want = {
+        "15:40: invalid operation: a < b (operator < not defined on a (variable of type T))",
+        "22:6: func init must have no type parameters",
+        "24:7: cannot use type Number outside a type constraint: interface contains type constraints",
+        "27:13: default type string of \"a\" does not match inferred type int for T",
+        "28:6: MyFloat does not satisfy Number (MyFloat missing in ~int | float64)",
+        "29:6: int does not satisfy Stringer (missing method String)",
+        "30:6: []int does not satisfy comparable",
+        "31:10: in call to Pair, cannot infer B",
+        "32:24: got 3 type arguments but Pair has 2 type parameters",
+        "33:7: cannot use generic function Max without instantiation",
+        "36:10: cannot use generic function Pair[int] without instantiation",
+    };
+    EXPECT_EQ(errors, want);
+}
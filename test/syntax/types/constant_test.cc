@@ -0,0 +1,179 @@
+#include "syntax/types/constant.hh"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace types;
+
+namespace {
+
+Value lit(std::string_view s, syntax::LitKind kind) { return Value::MakeFromLiteral(s, kind); }
+
+Value num(std::string_view s) {
+    bool isFloat = s.find_first_of(".eEpP") != std::string_view::npos && s.find_first_of("xX") == std::string_view::npos;
+    isFloat = isFloat || s.find_first_of("pP") != std::string_view::npos;
+    return lit(s, isFloat ? FloatLit : IntLit);
+}
+
+std::string str(const Value &v) { return v.String(); }
+
+std::string i128(__int128 v) {
+    if (v == 0) {
+        return "0";
+    }
+    bool neg = v < 0;
+    auto u = neg ? -(unsigned __int128)v : (unsigned __int128)v;
+    std::string s;
+    for (; u != 0; u /= 10) {
+        s.insert(s.begin(), char('0' + int(u % 10)));
+    }
+    return neg ? "-" + s : s;
+}
+
+} // namespace
+
+TEST(ConstantTest, test_literals) {
+    EXPECT_EQ(str(num("0x_1F")), "31");
+    EXPECT_EQ(str(num("0o17")), "15");
+    EXPECT_EQ(str(num("017")), "15");
+    EXPECT_EQ(str(num("0b1010")), "10");
+    EXPECT_EQ(str(num("1_000_000")), "1000000");
+    EXPECT_EQ(str(num("123456789012345678901234567890")), "123456789012345678901234567890");
+    EXPECT_EQ(str(num("0xffffffffffffffff")), "18446744073709551615");
+    EXPECT_EQ(str(num("1.5")), "1.5");
+    EXPECT_EQ(str(num("1e100")), "1e+100");
+    EXPECT_EQ(str(num("1e1000")), "1e+1000");
+    EXPECT_EQ(str(num("-1e-1000")), "unknown"); // a literal has no sign
+    EXPECT_EQ(str(num("2.5e-1000")), "2.5e-1000");
+    EXPECT_EQ(str(num("0x1p-2")), "0.25");
+    EXPECT_EQ(str(num("0x1.8p1")), "3");
+    EXPECT_EQ(str(num("1e100000")), "unknown");
+    EXPECT_EQ(str(lit("0123i", ImagLit)), "(0 + 123i)");
+    EXPECT_EQ(str(lit("0x10i", ImagLit)), "(0 + 16i)");
+    EXPECT_EQ(str(lit("1.5i", ImagLit)), "(0 + 1.5i)");
+    EXPECT_EQ(str(lit("'a'", RuneLit)), "97");
+    EXPECT_EQ(str(lit("'\\n'", RuneLit)), "10");
+    EXPECT_EQ(str(lit("'\\377'", RuneLit)), "255");
+    EXPECT_EQ(str(lit("'\\u00e9'", RuneLit)), "233");
+    EXPECT_EQ(str(lit("'é'", RuneLit)), "233");
+    EXPECT_FALSE(lit("'\\400'", RuneLit).IsKnown());
+    EXPECT_FALSE(lit("'\\ud800'", RuneLit).IsKnown());
+    EXPECT_EQ(lit("\"a\\tb\\u00e9\\xff\"", StringLit).StringVal(), "a\tb\xc3\xa9\xff");
+    EXPECT_EQ(lit("`a\\n\r\nb`", StringLit).StringVal(), "a\\n\nb");
+    EXPECT_EQ(str(lit("\"a\\\"b\"", StringLit)), "\"a\\\"b\"");
+
+    // decimal literals are exact
+    auto tenth = num("0.1");
+    EXPECT_TRUE(tenth.IsInline());
+    EXPECT_EQ(tenth.Num().String(), "1");
+    EXPECT_EQ(tenth.Denom().String(), "10");
+    EXPECT_TRUE(Compare(BinaryOp(BinaryOp(tenth, Operator_Add, num("0.2")), Operator_Sub, num("0.3")), Operator_Eql,
+                        Value::MakeInt64(0)));
+}
+
+TEST(ConstantTest, test_fast_path) {
+    // iota tables and bit masks stay inline
+    Value v = Value::MakeInt64(0);
+    for (int i = 0; i < 62; i++) {
+        auto bit = Shift(Value::MakeInt64(1), Operator_Shl, uint64_t(i));
+        EXPECT_TRUE(bit.IsInline());
+        v = BinaryOp(v, Operator_Or, bit);
+    }
+    EXPECT_TRUE(v.IsInline());
+    EXPECT_EQ(v.Int64Val(), (int64_t(1) << 62) - 1);
+    auto kb = BinaryOp(Value::MakeInt64(1), Operator_Mul, Shift(Value::MakeInt64(1), Operator_Shl, 10));
+    EXPECT_TRUE(kb.IsInline());
+    auto f = BinaryOp(num("1.5"), Operator_Mul, num("2.25"));
+    EXPECT_TRUE(f.IsInline());
+    EXPECT_EQ(str(f), "3.375");
+    EXPECT_EQ(str(BinaryOp(Value::MakeInt64(1), Operator_Div, num("3.0"))), "0.333333");
+
+    // overflow promotes
+    auto max = Value::MakeInt64(INT64_MAX);
+    auto big = BinaryOp(max, Operator_Add, Value::MakeInt64(1));
+    EXPECT_FALSE(big.IsInline());
+    EXPECT_EQ(str(big), "9223372036854775808");
+    EXPECT_FALSE(big.Int64Val().has_value());
+    EXPECT_EQ(big.Uint64Val(), uint64_t(1) << 63);
+    auto back = BinaryOp(big, Operator_Sub, Value::MakeInt64(1));
+    EXPECT_TRUE(back.IsInline());
+    EXPECT_EQ(back.Int64Val(), INT64_MAX);
+    EXPECT_EQ(Value::MakeInt64(INT64_MIN).Int64Val(), INT64_MIN);
+    EXPECT_EQ(str(UnaryOp(Operator_Sub, Value::MakeInt64(INT64_MIN), 0)), "9223372036854775808");
+}
+
+TEST(ConstantTest, test_operators) {
+    auto i = [](int64_t v) { return Value::MakeInt64(v); };
+    EXPECT_EQ(str(BinaryOp(i(-7), Operator_Div, i(2))), "-3");
+    EXPECT_EQ(str(BinaryOp(i(-7), Operator_Rem, i(2))), "-1");
+    EXPECT_EQ(str(BinaryOp(i(7), Operator_AndNot, i(5))), "2");
+    EXPECT_FALSE(BinaryOp(i(1), Operator_Div, i(0)).IsKnown());
+    EXPECT_EQ(str(BinaryOp(num("1.0"), Operator_Div, i(4))), "0.25");
+    EXPECT_EQ(str(UnaryOp(Operator_Xor, i(0), 0)), "-1");
+    EXPECT_EQ(str(UnaryOp(Operator_Xor, i(1), 8)), "254");
+    EXPECT_EQ(str(UnaryOp(Operator_Xor, i(0), 64)), "18446744073709551615");
+    EXPECT_EQ(str(UnaryOp(Operator_Not, Value::MakeBool(false), 0)), "true");
+    EXPECT_EQ(str(BinaryOp(Value::MakeBool(true), Operator_AndAnd, Value::MakeBool(false))), "false");
+    EXPECT_EQ(BinaryOp(Value::MakeString("ab"), Operator_Add, Value::MakeString("c")).StringVal(), "abc");
+    EXPECT_TRUE(Compare(Value::MakeString("ab"), Operator_Lss, Value::MakeString("b")));
+    EXPECT_TRUE(Compare(num("0.5"), Operator_Lss, i(1)));
+    EXPECT_TRUE(Compare(num("2.0"), Operator_Eql, i(2)));
+    EXPECT_EQ(str(Shift(i(-5), Operator_Shr, 1)), "-3");
+    EXPECT_EQ(str(Shift(i(-5), Operator_Shr, 100)), "-1");
+    EXPECT_EQ(str(Shift(i(1), Operator_Shl, 100)), "1267650600228229401496703205376");
+    EXPECT_EQ(str(Shift(Shift(i(-3), Operator_Shl, 100), Operator_Shr, 99)), "-6");
+
+    // complex arithmetic
+    auto c = BinaryOp(i(1), Operator_Add, lit("2i", ImagLit));
+    EXPECT_EQ(str(c), "(1 + 2i)");
+    EXPECT_EQ(str(BinaryOp(c, Operator_Mul, c)), "(-3 + 4i)");
+    EXPECT_EQ(str(BinaryOp(BinaryOp(c, Operator_Mul, c), Operator_Div, c)), "(1 + 2i)");
+    EXPECT_FALSE(c.ToFloat().IsKnown());
+    EXPECT_EQ(str(BinaryOp(c, Operator_Sub, lit("2i", ImagLit)).ToInt()), "1");
+
+    // conversions
+    EXPECT_FALSE(num("1.5").ToInt().IsKnown());
+    EXPECT_EQ(num("1e3").ToInt().Int64Val(), 1000);
+    EXPECT_EQ(num("0.1").Float64Val(), 0.1);
+    EXPECT_EQ(num("0.1").Float32Val(), 0.1f);
+    EXPECT_EQ(num("1e-320").Float64Val(), 1e-320);
+    EXPECT_EQ(num("123456789012345678901234567890.5").Float64Val(), 123456789012345678901234567890.5);
+    EXPECT_TRUE(std::isinf(num("1e400").Float64Val()));
+    EXPECT_TRUE(std::isinf(num("1e39").Float32Val()));
+    EXPECT_EQ(str(Value::MakeFloat64(0.375)), "0.375");
+}
+
+TEST(ConstantTest, test_big_arithmetic) {
+    // check the multi-word paths against 128-bit arithmetic
+    std::mt19937_64 rng(1);
+    auto random = [&] {
+        auto bits = rng() % 62 + 2;
+        auto v = __int128(rng() >> (64 - bits + 1));
+        return rng() % 2 ? -v : v;
+    };
+    for (int n = 0; n < 2000; n++) {
+        auto a = random() * random(), b = random();
+        if (b == 0) {
+            continue;
+        }
+        auto x = Value::MakeInt(BigInt::Parse(i128(a < 0 ? -a : a), 10));
+        if (a < 0) {
+            x = UnaryOp(Operator_Sub, x, 0);
+        }
+        auto y = Value::MakeInt(BigInt::Parse(i128(b < 0 ? -b : b), 10));
+        if (b < 0) {
+            y = UnaryOp(Operator_Sub, y, 0);
+        }
+        ASSERT_EQ(str(x), i128(a));
+        EXPECT_EQ(str(BinaryOp(x, Operator_Div, y)), i128(a / b)) << i128(a) << " / " << i128(b);
+        EXPECT_EQ(str(BinaryOp(x, Operator_Rem, y)), i128(a % b)) << i128(a) << " % " << i128(b);
+        EXPECT_EQ(str(BinaryOp(x, Operator_And, y)), i128(a & b));
+        EXPECT_EQ(str(BinaryOp(x, Operator_Or, y)), i128(a | b));
+        EXPECT_EQ(str(BinaryOp(x, Operator_Xor, y)), i128(a ^ b));
+        EXPECT_EQ(str(Shift(x, Operator_Shr, 7)), i128(a >> 7));
+        EXPECT_EQ(Compare(x, Operator_Lss, y), a < b);
+        auto q = BinaryOp(x.ToFloat(), Operator_Div, y);
+        EXPECT_TRUE(Compare(BinaryOp(q, Operator_Mul, y), Operator_Eql, x));
+    }
+}
@@ -0,0 +1,312 @@
+#include "syntax/types/export.hh"
+
+#include <gtest/gtest.h>
+#include <fmt/format.h>
+
+#include <filesystem>
+#include <sstream>
+
+#include "syntax/parser.hh"
+
+using namespace types;
+
+namespace {
+
+// checked is a package checked with an importer.
+struct checked {
+    ast::FilePtr file;
+    Checker check;
+    std::vector<std::string> errors; // "line:col: msg"
+
+    checked(Importer *importer, const std::string &src) : check(importer) {
+        file = syntax::Parse(std::make_unique<std::istringstream>(src), [](uint line, uint col, std::string msg) {
+            FAIL() << line << ":" << col << ": " << msg;
+        });
+        ast::File *files[] = {file.get()};
+        for (auto &e : check.Check(files)) {
+            auto p = syntax::FileSet::Global().Resolve(e.Pos);
+            errors.push_back(fmt::format("{}:{}: {}", p.Line, p.Col, e.Msg));
+        }
+    }
+};
+
+// add checks src and adds its export data to importer as path.
+void add(DirImporter &importer, const std::string &path, const std::string &src) {
+    checked c(&importer, src);
+    ASSERT_EQ(c.errors, std::vector<std::string>{});
+    ASSERT_TRUE(importer.Add(path, Export(c.check, path)));
+}
+
+common::SymbolId sym(std::string_view name) { return common::Interner::Global().Intern(name); }
+
+const char *libSrc = R"(package lib
+
+const (
+	Big   = 1 << 100
+	Neg   = -7
+	Third = 1.0 / 3
+	Z     = 2 + 0.5i
+	S     = "a\x00b"
+	T     = true
+)
+
+type Node struct {
+	Next  *Node
+	Value int
+	Shape
+}
+
+type Shape interface {
+	Area() float64
+}
+
+func (n Node) Len() int      { return 0 }
+func (n *Node) Push(v int)   { n.Value = v }
+
+var Ch = make(chan<- map[string][4]byte)
+
+func Sum(xs ...int) (int, error) { return 0, nil }
+
+func hidden() {}
+)";
+
+} // namespace
+
+TEST(ExportTest, test_round_trip) {
+    DirImporter importer;
+    checked c(&importer, libSrc);
+    ASSERT_EQ(c.errors, std::vector<std::string>{});
+    auto data = Export(c.check, "example.com/lib");
+    flatbuffers::Verifier verifier(data.data(), data.size());
+    EXPECT_TRUE(exportdata::VerifyPackageBuffer(verifier));
+    ASSERT_TRUE(importer.Add("example.com/lib", std::move(data)));
+
+    auto pkg = importer.Import("example.com/lib");
+    ASSERT_NE(pkg, nullptr);
+    EXPECT_EQ(pkg->Path(), "example.com/lib");
+    EXPECT_EQ(pkg->Name(), "lib");
+    EXPECT_EQ(pkg->Size(), 11u);
+    EXPECT_EQ(pkg->Decoded(), 0u);
+
+    auto &table = TypeTable::Global();
+    for (auto name : {"Big", "Neg", "Third", "Z", "S", "T", "Node", "Shape", "Ch", "Sum", "hidden"}) {
+        auto want = c.check.PackageScope().LookupLocal(sym(name));
+        auto got = pkg->Lookup(sym(name));
+        ASSERT_NE(got, nullptr) << name;
+        EXPECT_EQ(got->Kind, want->Kind) << name;
+        EXPECT_EQ(table.String(got->Type), table.String(want->Type)) << name;
+        if (want->Kind == ObjKind::Const) {
+            EXPECT_TRUE(Compare(got->Val, Operator_Eql, want->Val)) << name;
+            EXPECT_EQ(got->Val.String(), want->Val.String()) << name;
+        }
+    }
+    EXPECT_EQ(pkg->Lookup(sym("Missing")), nullptr);
+    EXPECT_EQ(pkg->Lookup(sym("Len")), nullptr); // methods are not package-level
+
+    // the named type is decoded once and keeps its methods
+    auto node = pkg->Lookup(sym("Node"))->Type;
+    EXPECT_NE(node, c.check.PackageScope().LookupLocal(sym("Node"))->Type);
+    EXPECT_EQ(importer.Owner(node), pkg);
+    auto under = table[table.Underlying(node)];
+    ASSERT_EQ(under.Kind, KindStruct);
+    EXPECT_EQ(under.Elems[0], table.Pointer(node));
+    EXPECT_EQ(under.Names[2], sym("Shape") | EmbeddedField);
+    auto methods = pkg->Methods(node);
+    ASSERT_EQ(methods.size(), 2u);
+    EXPECT_EQ(methods[0]->Name, sym("Len"));
+    EXPECT_FALSE(methods[0]->PtrRecv);
+    EXPECT_EQ(methods[1]->Name, sym("Push"));
+    EXPECT_TRUE(methods[1]->PtrRecv);
+    EXPECT_EQ(table.String(methods[1]->Type), "func(int)");
+    EXPECT_EQ(pkg->Methods(node).data(), methods.data());
+}
+
+TEST(ExportTest, test_lazy_decoding) {
+    // a lookup decodes the object found and the types it refers to only
+    std::string src = "package huge\n";
+    for (int i = 0; i < 2000; i++) {
+        src += fmt::format("type T{0} struct{{ f{0} [{0}]int }}\nfunc F{0}(t T{0}) *T{0} {{ return &t }}\n", i);
+    }
+    DirImporter importer;
+    add(importer, "huge", src);
+    auto pkg = importer.Import("huge");
+    ASSERT_NE(pkg, nullptr);
+    EXPECT_EQ(pkg->Size(), 4000u);
+    EXPECT_EQ(pkg->Decoded(), 0u);
+
+    auto f = pkg->Lookup(sym("F1234"));
+    ASSERT_NE(f, nullptr);
+    EXPECT_EQ(TypeTable::Global().String(f->Type), "func(T1234) *T1234");
+    // F1234, its signature, T1234, *T1234, its struct and the array
+    EXPECT_EQ(pkg->Decoded(), 6u);
+    EXPECT_EQ(pkg->Lookup(sym("T1234"))->Type, TypeTable::Global()[f->Type].Params()[0]);
+    EXPECT_EQ(pkg->Decoded(), 7u);
+    EXPECT_EQ(pkg->Lookup(sym("F1234")), f);
+    EXPECT_EQ(pkg->Decoded(), 7u);
+}
+
+TEST(ExportTest, test_qualified_identifiers) {
+    DirImporter importer;
+    add(importer, "lib", libSrc);
+    checked c(&importer, R"(package main
+
+import (
+	"lib"
+	l2 "lib"
+	"other"
+)
+
+type Square struct{ side float64 }
+
+func (s Square) Area() float64 { return s.side * s.side }
+
+func main() {
+	n := lib.Node{Value: lib.Neg}
+	n.Push(len(lib.S))
+	var s lib.Shape = Square{2}
+	n.Shape = s
+	var _ int = n.Len() + n.Next.Value
+	var _ float64 = lib.Third
+	var _ [lib.Big >> 98]int = [4]int{}
+	_, err := l2.Sum(1, 2)
+	_ = err.Error()
+	lib.Ch <- nil
+	_ = other.Anything(1)
+	_ = lib.Missing
+	lib.hidden()
+	var _ interface{ Push(int) } = n
+	var _ string = lib.Neg
+}
+
+func f(r other.Reader) int { return 1 }
+
+var _ = other.T{A: 1}
+)");
+    // other is reported once, where it is imported
+    EXPECT_EQ(c.errors, (std::vector<std::string>{
+                            "6:2: could not import other",
+                            "25:10: undefined: lib.Missing",
+                            "26:6: name hidden not exported by package lib",
+                            "27:33: cannot use n (variable of type Node) as interface{Push(int)} value in variable "
+                            "declaration: Node does not implement interface{Push(int)} (missing method Push)",
+                            "28:20: cannot use lib.Neg (untyped int constant) as string value in variable declaration",
+                        }));
+}
+
+TEST(ExportTest, test_shared_types) {
+    // a named type reached through two packages is the same type
+    char tmpl[] = "/tmp/export_test.XXXXXX";
+    std::string dir = mkdtemp(tmpl);
+    {
+        DirImporter importer(dir);
+        add(importer, "a", "package a\n\ntype T struct{ X int }\n\nfunc (T) M() int { return 1 }\n");
+        add(importer, "x/b", "package b\n\nimport \"a\"\n\nfunc New() a.T { return a.T{} }\n\nvar P *a.T\n");
+        EXPECT_TRUE(std::filesystem::exists(dir + "/x/b.x"));
+
+        checked c(&importer, R"(package main
+
+import (
+	"a"
+	"x/b"
+)
+
+var t a.T = b.New()
+var p *a.T = b.P
+var n = b.New().M() + p.X
+)");
+        EXPECT_EQ(c.errors, std::vector<std::string>{});
+        EXPECT_EQ(TypeTable::Global().String(c.check.PackageScope().LookupLocal(sym("n"))->Type), "int");
+    }
+
+    // a fresh importer maps the files written
+    DirImporter importer(dir);
+    auto b = importer.Import("x/b");
+    ASSERT_NE(b, nullptr);
+    auto t = TypeTable::Global()[b->Lookup(sym("New"))->Type].Results()[0];
+    EXPECT_EQ(t, importer.Import("a")->Lookup(sym("T"))->Type);
+    std::filesystem::remove_all(dir);
+}
+
+TEST(ExportTest, test_generics) {
+    // type parameters and constraints are exported with the generic
+    // functions, which importers instantiate
+    DirImporter importer;
+    add(importer, "lib", R"(package lib
+
+type Ordered interface {
+	~int | ~int64 | ~float64 | ~string
+}
+
+type Stringer interface{ String() string }
+
+func Max[T Ordered](a, b T) T {
+	if a > b {
+		return a
+	}
+	return b
+}
+
+func Index[S ~[]E, E comparable](s S, v E) int { return -1 }
+
+func Str[T Stringer](x T) string { return x.String() }
+)");
+    auto pkg = importer.Import("lib");
+    ASSERT_NE(pkg, nullptr);
+    auto &table = TypeTable::Global();
+    auto index = pkg->Lookup(sym("Index"));
+    ASSERT_EQ(index->TParams.size(), 2u);
+    EXPECT_EQ(table.String(index->Type), "func(S, E) int");
+    EXPECT_EQ(table.String(table[index->TParams[0]].Elem()), "~[]E");
+    EXPECT_EQ(table.String(table[index->TParams[1]].Elem()), "comparable");
+    EXPECT_EQ(table.String(table.Underlying(pkg->Lookup(sym("Ordered"))->Type)), "~int | ~int64 | ~float64 | ~string");
+
+    checked c(&importer, R"(package main
+
+import "lib"
+
+type Name string
+
+func (n Name) String() string { return string(n) }
+
+var (
+	a = lib.Max(1, 2.5)
+	b = lib.Max(Name("x"), "y")
+	i = lib.Index([]Name{}, "a")
+	s = lib.Str(Name(""))
+	_ = lib.Max(true, false)
+	_ = lib.Str(1)
+)
+)");
+    EXPECT_EQ(c.errors, (std::vector<std::string>{
+                            "14:9: bool does not satisfy Ordered (bool missing in ~int | ~int64 | ~float64 | ~string)",
+                            "15:9: int does not satisfy Stringer (missing method String)",
+                        }));
+    auto typeOf = [&](std::string_view name) {
+        return table.String(c.check.PackageScope().LookupLocal(sym(name))->Type);
+    };
+    EXPECT_EQ(typeOf("a"), "float64");
+    EXPECT_EQ(typeOf("b"), "Name");
+    EXPECT_EQ(typeOf("i"), "int");
+    EXPECT_EQ(typeOf("s"), "string");
+}
+
+TEST(ExportTest, test_malformed) {
+    DirImporter importer;
+    flatbuffers::FlatBufferBuilder fbb;
+    fbb.Finish(fbb.CreateString("not export data"));
+    EXPECT_FALSE(importer.Add("bad", fbb.Release()));
+    EXPECT_EQ(importer.Import("bad"), nullptr);
+
+    // a corrupt entry reads as a missing object
+    checked c(&importer, "package p\n\nvar A, B int\n");
+    auto data = Export(c.check, "p");
+    auto entry = reinterpret_cast<const uint8_t *>(exportdata::GetPackage(data.data())->objects()->Get(1));
+    // point the vtable of B outside the buffer
+    auto at = data.data() + (entry - data.data());
+    at[0] = at[1] = at[2] = 0x7f;
+    ASSERT_TRUE(importer.Add("p", std::move(data)));
+    auto p = importer.Import("p");
+    ASSERT_NE(p, nullptr);
+    EXPECT_NE(p->Lookup(sym("A")), nullptr);
+    EXPECT_EQ(p->Lookup(sym("B")), nullptr);
+}
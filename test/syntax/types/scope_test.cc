@@ -0,0 +1,114 @@
+#include "syntax/types/scope.hh"
+
+#include <gtest/gtest.h>
+#include <tbb/parallel_for.h>
+
+#include <deque>
+
+using namespace types;
+
+namespace {
+
+struct objects {
+    std::deque<Object> objs;
+
+    Object *make(std::string_view name) {
+        auto &obj = objs.emplace_back();
+        obj.Name = common::Interner::Global().Intern(name);
+        return &obj;
+    }
+};
+
+common::SymbolId sym(std::string_view name) { return common::Interner::Global().Intern(name); }
+
+} // namespace
+
+TEST(ScopeTest, test_insert_lookup) {
+    objects o;
+    Scope s;
+    std::vector<Object *> objs;
+    // fill the inline array, then grow the table a few times
+    for (int i = 0; i < 200; i++) {
+        auto obj = o.make("v" + std::to_string(i));
+        ASSERT_EQ(s.Insert(obj), nullptr);
+        objs.push_back(obj);
+        for (int j = 0; j <= i; j++) {
+            ASSERT_EQ(s.LookupLocal(objs[j]->Name), objs[j]) << i << " " << j;
+        }
+        EXPECT_EQ(s.LookupLocal(sym("w" + std::to_string(i))), nullptr);
+    }
+    EXPECT_EQ(s.Size(), 200u);
+    EXPECT_EQ(s.Insert(o.make("v7")), objs[7]);
+    EXPECT_EQ(s.Size(), 200u);
+
+    // a moved scope keeps its objects
+    Scope small;
+    small.Insert(objs[0]);
+    Scope moved = std::move(small);
+    EXPECT_EQ(moved.LookupLocal(objs[0]->Name), objs[0]);
+    Scope big = std::move(s);
+    EXPECT_EQ(big.LookupLocal(objs[150]->Name), objs[150]);
+}
+
+TEST(ScopeTest, test_block_scopes) {
+    objects o;
+    Scope pkg(&Universe());
+    auto x = o.make("x");
+    pkg.Insert(x);
+    pkg.Freeze();
+
+    BlockScopes blocks(&pkg);
+    auto outer = blocks.Open(NoScope);
+    auto y = o.make("y");
+    blocks[outer].Insert(y);
+    auto inner = blocks.Open(outer);
+    auto x2 = o.make("x");
+    blocks[inner].Insert(x2);
+    auto sibling = blocks.Open(outer);
+
+    EXPECT_EQ(blocks.Parent(inner), outer);
+    EXPECT_EQ(blocks.Lookup(inner, sym("x")), x2); // shadows the package x
+    EXPECT_EQ(blocks.Lookup(sibling, sym("x")), x);
+    EXPECT_EQ(blocks.Lookup(inner, sym("y")), y);
+    EXPECT_EQ(blocks.Lookup(NoScope, sym("y")), nullptr);
+    EXPECT_EQ(blocks.Lookup(inner, sym("int"))->Kind, ObjKind::TypeName);
+    EXPECT_EQ(blocks.Lookup(inner, sym("undeclared")), nullptr);
+
+    // blocks stay valid as more are opened
+    auto s = inner;
+    for (int i = 0; i < 100; i++) {
+        s = blocks.Open(s);
+        blocks[s].Insert(o.make("d" + std::to_string(i)));
+    }
+    EXPECT_EQ(blocks.Lookup(s, sym("d0"))->Name, sym("d0"));
+    EXPECT_EQ(blocks.Lookup(s, sym("x")), x2);
+}
+
+TEST(ScopeTest, test_shared_readers) {
+    objects o;
+    Scope pkg(&Universe());
+    std::vector<Object *> objs;
+    for (int i = 0; i < 1000; i++) {
+        objs.push_back(o.make("p" + std::to_string(i)));
+        pkg.Insert(objs.back());
+    }
+    pkg.Freeze();
+    EXPECT_TRUE(pkg.Frozen());
+    EXPECT_TRUE(Universe().Frozen());
+
+    // each reader has its own blocks over the shared package scope
+    std::atomic<int> wrong{0};
+    tbb::parallel_for(0, 64, [&](int t) {
+        objects local;
+        BlockScopes blocks(&pkg);
+        auto s = blocks.Open(NoScope);
+        auto shadow = local.make("p" + std::to_string(t));
+        blocks[s].Insert(shadow);
+        for (int i = 0; i < 1000; i++) {
+            if (blocks.Lookup(s, objs[i]->Name) != (i == t ? shadow : objs[i])) {
+                wrong++;
+            }
+        }
+    });
+    EXPECT_EQ(wrong, 0);
+}
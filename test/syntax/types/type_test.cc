@@ -0,0 +1,123 @@
+#include "syntax/types/type.hh"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "syntax/types/check.hh"
+
+using namespace types;
+
+namespace {
+
+common::SymbolId sym(std::string_view s) { return common::Interner::Global().Intern(s); }
+
+} // namespace
+
+TEST(TypeTest, test_basic) {
+    TypeTable t;
+    EXPECT_EQ(t.Kind(KindInt), KindInt);
+    EXPECT_EQ(t.Kind(KindUnsafePointer), KindUnsafePointer);
+    EXPECT_EQ(t.Underlying(KindString), TypeId(KindString));
+    EXPECT_EQ(t.String(KindFloat64), "float64");
+    EXPECT_EQ(t.String(KindUntypedRune), "untyped rune");
+    EXPECT_EQ(t.Size(), size_t(KindUntypedNil + 1));
+}
+
+TEST(TypeTest, test_hash_consing) {
+    TypeTable t;
+    auto s = t.Slice(KindInt);
+    EXPECT_EQ(t.Slice(KindInt), s);
+    EXPECT_NE(t.Slice(KindInt64), s);
+    EXPECT_NE(t.Array(3, KindInt), t.Array(4, KindInt));
+    EXPECT_EQ(t.Map(KindString, s), t.Map(KindString, t.Slice(KindInt)));
+    EXPECT_NE(t.Map(KindString, KindInt), t.Map(KindInt, KindString));
+    EXPECT_NE(t.Chan(1, KindInt), t.Chan(2, KindInt));
+
+    TypeId params[] = {KindInt, s};
+    TypeId results[] = {KindBool};
+    auto f = t.Func(params, results, true);
+    EXPECT_EQ(t.Func(params, results, true), f);
+    EXPECT_NE(t.Func(params, results, false), f);
+    EXPECT_NE(t.Func({params, 1}, {}, false), t.Func({}, {params, 1}, false));
+    EXPECT_EQ(t[f].Params().size(), 2u);
+    EXPECT_EQ(t[f].Results()[0], TypeId(KindBool));
+    EXPECT_EQ(t.String(f), "func(int, ...int) bool");
+
+    common::SymbolId names[] = {sym("x"), sym("y")};
+    TypeId fields[] = {KindInt, KindString};
+    auto st = t.Struct(names, fields);
+    EXPECT_EQ(t.Struct(names, fields), st);
+    common::SymbolId swapped[] = {sym("y"), sym("x")};
+    EXPECT_NE(t.Struct(swapped, fields), st);
+    EXPECT_EQ(t.String(st), "struct{x int; y string}");
+
+    // method sets are unordered
+    auto m = t.Func({}, {}, false);
+    TypeId methods[] = {m, f};
+    TypeId reversed[] = {f, m};
+    common::SymbolId mnames[] = {sym("M"), sym("F")};
+    common::SymbolId rnames[] = {sym("F"), sym("M")};
+    auto i = t.Interface(mnames, methods);
+    EXPECT_EQ(t.Interface(rnames, reversed), i);
+    EXPECT_EQ(t.String(i), "interface{F(int, ...int) bool; M()}");
+
+    auto size = t.Size();
+    EXPECT_EQ(t.Pointer(t.Map(KindString, s)), t.Pointer(t.Map(KindString, s)));
+    EXPECT_EQ(t.Size(), size + 1); // only the pointer type is new
+}
+
+TEST(TypeTest, test_named) {
+    TypeTable t;
+    auto a = t.NewNamed(sym("T"));
+    auto b = t.NewNamed(sym("T"));
+    EXPECT_NE(a, b);
+    TypeId elems[] = {a};
+    common::SymbolId names[] = {sym("next")};
+    t.SetUnderlying(a, t.Struct(names, {elems, 1}));
+    t.SetUnderlying(b, a);
+    EXPECT_EQ(t.Underlying(b), t.Underlying(a));
+    EXPECT_EQ(t.Kind(t.Underlying(b)), KindStruct);
+    EXPECT_EQ(t.String(t.Pointer(b)), "*T");
+    EXPECT_EQ(t.String(t.Underlying(a)), "struct{next T}");
+}
+
+TEST(TypeTest, test_sizeof) {
+    auto &t = TypeTable::Global();
+    EXPECT_EQ(Sizeof(KindBool), 1);
+    EXPECT_EQ(Sizeof(KindUntypedInt), 8);
+    EXPECT_EQ(Sizeof(KindString), 16);
+    EXPECT_EQ(Sizeof(t.Slice(KindInt)), 24);
+    EXPECT_EQ(Sizeof(t.Array(10, KindInt32)), 40);
+    EXPECT_EQ(Alignof(KindComplex64), 4);
+
+    // fields are padded to their alignment, and the struct to its own
+    common::SymbolId names[] = {sym("a"), sym("b"), sym("c")};
+    TypeId fields[] = {KindInt8, KindInt64, KindInt16};
+    auto st = t.Struct(names, fields);
+    EXPECT_EQ(Sizeof(st), 24);
+    EXPECT_EQ(Alignof(st), 8);
+    EXPECT_EQ(Sizeof(t.Struct({}, {})), 0);
+}
+
+TEST(TypeTest, test_concurrent) {
+    TypeTable t;
+    constexpr int nthreads = 4, ntypes = 2000;
+    std::vector<std::vector<TypeId>> ids(nthreads);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nthreads; i++) {
+        threads.emplace_back([&, i] {
+            for (int n = 0; n < ntypes; n++) {
+                ids[i].push_back(t.Slice(t.Array(n, KindInt)));
+            }
+        });
+    }
+    for (auto &th : threads) {
+        th.join();
+    }
+    for (int i = 1; i < nthreads; i++) {
+        EXPECT_EQ(ids[i], ids[0]);
+    }
+    EXPECT_EQ(t.Size(), size_t(KindUntypedNil + 1 + 2 * ntypes));
+    EXPECT_EQ(t.String(ids[0][7]), "[][7]int");
+}
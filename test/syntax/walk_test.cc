@@ -0,0 +1,117 @@
+#include "syntax/ast/walk.hh"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "syntax/parser.hh"
+
+using namespace ast;
+
+namespace {
+
+FilePtr parse(const std::string &src) {
+    return syntax::Parse(std::make_unique<std::istringstream>(src), [](uint line, uint col, std::string msg) {
+        FAIL() << line << ":" << col << ": " << msg;
+    });
+}
+
+std::string names(const std::vector<Node *> &nodes) {
+    std::string s;
+    for (auto n : nodes) {
+        if (auto x = dynamic_cast<Name *>(n)) {
+            s += std::string(x->Value) + " ";
+        }
+    }
+    return s;
+}
+
+} // namespace
+
+TEST(WalkTest, test_order) {
+    auto f = parse("package p; func f(a, b int) { g(a + b, c[d]) }");
+    std::vector<Node *> pre, post;
+    Walker w;
+    EXPECT_TRUE(w.Walk(
+        f.get(),
+        [&](Node *n) {
+            pre.push_back(n);
+            return Visit::Children;
+        },
+        [&](Node *n) {
+            post.push_back(n);
+            return true;
+        }));
+    // a and b share their type, which is visited once per field
+    EXPECT_EQ(names(pre), "p f a int b int g a b c d ");
+    EXPECT_EQ(names(post), "p f a int b int g a b c d ");
+    ASSERT_EQ(pre.size(), post.size());
+    EXPECT_EQ(pre.front(), f.get());
+    EXPECT_EQ(post.back(), f.get());
+}
+
+TEST(WalkTest, test_skip_and_stop) {
+    auto f = parse("package p; func f() { g(x + y); h(z) }");
+    std::vector<Node *> seen;
+    Walker w;
+    w.Walk(f.get(), [&](Node *n) {
+        seen.push_back(n);
+        return dynamic_cast<CallExpr *>(n) ? Visit::SkipChildren : Visit::Children;
+    });
+    EXPECT_EQ(names(seen), "p f ");
+
+    seen.clear();
+    EXPECT_FALSE(w.Walk(f.get(), [&](Node *n) {
+        seen.push_back(n);
+        auto x = dynamic_cast<Name *>(n);
+        return x && x->Value == "x" ? Visit::Stop : Visit::Children;
+    }));
+    EXPECT_EQ(names(seen), "p f g x ");
+
+    // Parent and Depth describe the position of the node being visited
+    size_t depth = 0;
+    w.Walk(f.get(), [&](Node *n) {
+        if (auto x = dynamic_cast<Name *>(n); x && x->Value == "z") {
+            EXPECT_NE(dynamic_cast<CallExpr *>(w.Parent()), nullptr);
+            depth = w.Depth();
+        }
+        return Visit::Children;
+    });
+    EXPECT_EQ(depth, 5u); // File, FuncDecl, BlockStmt, ExprStmt, CallExpr
+
+    int calls = 0;
+    Inspect(f.get(), [&](Node *n) {
+        calls += dynamic_cast<CallExpr *>(n) != nullptr;
+        return dynamic_cast<FuncType *>(n) == nullptr;
+    });
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(WalkTest, test_deep_tree) {
+    // x + x + ... + x nested a million levels deep
+    constexpr int depth = 1000000;
+    auto leaf = std::make_shared<Name>();
+    leaf->Value = "x";
+    ExprNodePtr root = leaf;
+    for (int i = 0; i < depth; i++) {
+        auto op = std::make_shared<Operation>();
+        op->X = root;
+        op->Y = leaf;
+        root = op;
+    }
+    int nodes = 0;
+    size_t max_depth = 0;
+    Walker w;
+    w.Walk(root.get(), [&](Node *) {
+        nodes++;
+        max_depth = std::max(max_depth, w.Depth());
+        return Visit::Children;
+    });
+    EXPECT_EQ(nodes, 2 * depth + 1);
+    EXPECT_EQ(max_depth, size_t(depth));
+
+    // unlink iteratively: the recursive destructors would overflow the stack
+    while (auto op = std::dynamic_pointer_cast<Operation>(root)) {
+        root = std::move(op->X);
+    }
+}